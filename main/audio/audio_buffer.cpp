@@ -2,23 +2,29 @@
 #include "../system/error_handler.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include <cstring>
 
 static const char *TAG = "audio_buffer";
 
-// Ring buffer size: 2 seconds at 96kHz stereo 24-bit
-// 96000 Hz × 2 channels × 3 bytes × 2 seconds = 1,152,000 bytes
-constexpr size_t RING_BUFFER_SIZE = 1152000;
+constexpr size_t RING_BUFFER_SIZE = AUDIO_BUFFER_RING_BYTES;
+static_assert(RING_BUFFER_SIZE % 6 == 0, "whole frames: peek() spans never split a frame at the wrap");
 
 // Ring buffer and pointers
 static uint8_t *ring_buffer = nullptr;
 static std::atomic<uint32_t> write_pos{0};
-static std::atomic<uint32_t> read_pos[ClientConnection::MAX_CLIENTS] = {0, 0, 0};
-static std::atomic<bool> client_active[ClientConnection::MAX_CLIENTS] = {false, false, false};
+static std::atomic<uint32_t> read_pos[AUDIO_BUFFER_MAX_READERS] = {};
+static std::atomic<bool> client_active[AUDIO_BUFFER_MAX_READERS] = {};
 
 // Overrun counters
 static std::atomic<uint32_t> overrun_count{0};
 
+// Capture clock (seqlock: clock_seq is odd while write() updates it). Every
+// write is whole frames from position 0, so write_pos == frames × 6 mod size.
+static std::atomic<uint32_t> clock_seq{0};
+static std::atomic<uint64_t> clock_frames{0};
+static std::atomic<int64_t>  clock_time_us{0};
+
 bool AudioBuffer::init()
 {
     ESP_LOGI(TAG, "Initializing audio ring buffer in PSRAM");
@@ -36,11 +42,13 @@ bool AudioBuffer::init()
     
     // Reset all pointers
     write_pos.store(0, std::memory_order_release);
-    for (int i = 0; i < ClientConnection::MAX_CLIENTS; i++) {
+    for (int i = 0; i < AUDIO_BUFFER_MAX_READERS; i++) {
         read_pos[i].store(0, std::memory_order_release);
         client_active[i].store(false, std::memory_order_release);
     }
     overrun_count.store(0, std::memory_order_release);
+    clock_frames.store(0, std::memory_order_relaxed);
+    clock_time_us.store(esp_timer_get_time(), std::memory_order_relaxed);
     
     ESP_LOGI(TAG, "Ring buffer initialized: %d bytes (%.2f MB) in PSRAM", 
              RING_BUFFER_SIZE, RING_BUFFER_SIZE / (1024.0 * 1024.0));
@@ -70,8 +78,8 @@ bool AudioBuffer::write(const uint8_t *data, size_t size)
     }
     
     // Check if we're about to overrun any active client
-    static uint32_t log_throttle[ClientConnection::MAX_CLIENTS] = {0};
-    for (int client_id = 0; client_id < ClientConnection::MAX_CLIENTS; client_id++) {
+    static uint32_t log_throttle[AUDIO_BUFFER_MAX_READERS] = {0};
+    for (int client_id = 0; client_id < AUDIO_BUFFER_MAX_READERS; client_id++) {
         if (client_active[client_id].load(std::memory_order_acquire)) {
             uint32_t rp = read_pos[client_id].load(std::memory_order_acquire);
             
@@ -91,6 +99,15 @@ bool AudioBuffer::write(const uint8_t *data, size_t size)
         }
     }
     
+    // Clock before the write pointer, so no reader is ever past the clock
+    uint32_t seq = clock_seq.load(std::memory_order_relaxed);
+    clock_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    clock_frames.store(clock_frames.load(std::memory_order_relaxed) + size / AudioStream::BYTES_PER_FRAME,
+                       std::memory_order_relaxed);
+    clock_time_us.store(esp_timer_get_time(), std::memory_order_relaxed);
+    clock_seq.store(seq + 2, std::memory_order_release);
+
     // Update write pointer atomically
     write_pos.store(wp, std::memory_order_release);
     
@@ -99,7 +116,7 @@ bool AudioBuffer::write(const uint8_t *data, size_t size)
 
 bool AudioBuffer::read(uint8_t client_id, uint8_t *data, size_t size, size_t *bytes_read)
 {
-    if (ring_buffer == nullptr || client_id >= ClientConnection::MAX_CLIENTS) {
+    if (ring_buffer == nullptr || client_id >= AUDIO_BUFFER_MAX_READERS) {
         *bytes_read = 0;
         return false;
     }
@@ -143,9 +160,40 @@ bool AudioBuffer::read(uint8_t client_id, uint8_t *data, size_t size, size_t *by
     return true;
 }
 
-bool AudioBuffer::register_client(uint8_t client_id)
+bool AudioBuffer::peek(uint8_t client_id, const uint8_t **data, size_t max_size, size_t *len)
 {
-    if (client_id >= ClientConnection::MAX_CLIENTS) {
+    *len = 0;
+    if (ring_buffer == nullptr || client_id >= AUDIO_BUFFER_MAX_READERS) {
+        return false;
+    }
+
+    if (!client_active[client_id].load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    uint32_t wp = write_pos.load(std::memory_order_acquire);
+    uint32_t rp = read_pos[client_id].load(std::memory_order_acquire);
+
+    // Contiguous part only: up to the write position or the end of the ring
+    uint32_t available = (wp >= rp) ? (wp - rp) : (RING_BUFFER_SIZE - rp);
+    *data = &ring_buffer[rp];
+    *len  = (max_size < available) ? max_size : available;
+    return true;
+}
+
+void AudioBuffer::consume(uint8_t client_id, size_t len)
+{
+    if (client_id >= AUDIO_BUFFER_MAX_READERS) {
+        return;
+    }
+
+    uint32_t rp = read_pos[client_id].load(std::memory_order_acquire);
+    read_pos[client_id].store((uint32_t)((rp + len) % RING_BUFFER_SIZE), std::memory_order_release);
+}
+
+bool AudioBuffer::register_client(uint8_t client_id, uint32_t behind_bytes)
+{
+    if (client_id >= AUDIO_BUFFER_MAX_READERS) {
         return false;
     }
     
@@ -155,10 +203,12 @@ bool AudioBuffer::register_client(uint8_t client_id)
     }
     
     // Set client read position BEHIND write position to allow buffering
-    // Start 1.5s behind for weak WiFi tolerance (48000 Hz * 2 ch * 3 bytes * 1.5s = 432000 bytes)
-    constexpr uint32_t START_BUFFER = 432000;
+    behind_bytes -= behind_bytes % AudioStream::BYTES_PER_FRAME;
+    if (behind_bytes >= RING_BUFFER_SIZE) {
+        behind_bytes = RING_BUFFER_SIZE - AudioStream::BYTES_PER_FRAME;
+    }
     uint32_t wp = write_pos.load(std::memory_order_acquire);
-    uint32_t rp = (wp >= START_BUFFER) ? (wp - START_BUFFER) : (RING_BUFFER_SIZE - START_BUFFER + wp);
+    uint32_t rp = (wp >= behind_bytes) ? (wp - behind_bytes) : (RING_BUFFER_SIZE - behind_bytes + wp);
     
     read_pos[client_id].store(rp, std::memory_order_release);
     client_active[client_id].store(true, std::memory_order_release);
@@ -170,7 +220,7 @@ bool AudioBuffer::register_client(uint8_t client_id)
 
 bool AudioBuffer::unregister_client(uint8_t client_id)
 {
-    if (client_id >= ClientConnection::MAX_CLIENTS) {
+    if (client_id >= AUDIO_BUFFER_MAX_READERS) {
         return false;
     }
     
@@ -193,7 +243,7 @@ uint32_t AudioBuffer::get_fill_bytes()
     uint32_t min_fill = RING_BUFFER_SIZE;
     bool any_active = false;
     
-    for (int client_id = 0; client_id < ClientConnection::MAX_CLIENTS; client_id++) {
+    for (int client_id = 0; client_id < AUDIO_BUFFER_MAX_READERS; client_id++) {
         if (client_active[client_id].load(std::memory_order_acquire)) {
             any_active = true;
             uint32_t rp = read_pos[client_id].load(std::memory_order_acquire);
@@ -217,6 +267,37 @@ uint32_t AudioBuffer::get_overrun_count()
     return overrun_count.load(std::memory_order_acquire);
 }
 
+void AudioBuffer::get_clock(uint64_t *frames, int64_t *time_us)
+{
+    uint32_t seq;
+    uint64_t f;
+    int64_t  t;
+    do {
+        seq = clock_seq.load(std::memory_order_acquire);
+        f   = clock_frames.load(std::memory_order_relaxed);
+        t   = clock_time_us.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != clock_seq.load(std::memory_order_relaxed));
+
+    if (frames != nullptr) *frames = f;
+    if (time_us != nullptr) *time_us = t;
+}
+
+uint64_t AudioBuffer::reader_frame(uint8_t client_id)
+{
+    uint64_t frames = 0;
+    get_clock(&frames, nullptr);
+    if (client_id >= AUDIO_BUFFER_MAX_READERS) {
+        return frames;
+    }
+
+    // The clock is written first, so the reader is at or behind its position
+    uint32_t wp = (uint32_t)((frames * AudioStream::BYTES_PER_FRAME) % RING_BUFFER_SIZE);
+    uint32_t rp = read_pos[client_id].load(std::memory_order_acquire);
+    uint32_t behind = (wp >= rp) ? (wp - rp) : (RING_BUFFER_SIZE - rp + wp);
+    return frames - behind / AudioStream::BYTES_PER_FRAME;
+}
+
 void AudioBuffer::deinit()
 {
     if (ring_buffer != nullptr) {
@@ -6,6 +6,21 @@
 #include <cstddef>
 #include <atomic>
 
+// Reader slots: 0 … MAX_CLIENTS-1 belong to the HTTP stream clients, the
+// next four to the shared stream encoder pipes (see network/stream_encoder.h)
+// and the last to the RTP sender (network/rtp_sender.h).
+static constexpr uint8_t AUDIO_BUFFER_ENCODER_READERS = 4;
+static constexpr uint8_t AUDIO_BUFFER_RTP_READER =
+    ClientConnection::MAX_CLIENTS + AUDIO_BUFFER_ENCODER_READERS;
+static constexpr uint8_t AUDIO_BUFFER_MAX_READERS = AUDIO_BUFFER_RTP_READER + 1;
+
+// Ring size: 2 s at 96 kHz (96000 Hz × 2 ch × 3 bytes × 2 s)
+static constexpr uint32_t AUDIO_BUFFER_RING_BYTES = 1152000;
+
+// Default start of a new reader behind the writer: 1.5 s at 48 kHz
+// (48000 Hz × 2 ch × 3 bytes × 1.5 s), for weak WiFi tolerance
+static constexpr uint32_t AUDIO_BUFFER_START_BEHIND_BYTES = 432000;
+
 class AudioBuffer {
 public:
     // Initialize ring buffer in PSRAM (1.1MB for 2s at 96kHz)
@@ -19,9 +34,19 @@ public:
     // Returns true on success, bytes_read=0 if no data available
     static bool read(uint8_t client_id, uint8_t *data, size_t size, size_t *bytes_read);
     
+    // Zero-copy read: point `data` at up to `max_size` contiguous bytes the
+    // client has not read yet (stops at the ring's end; the rest follows on
+    // the next call). The span stays valid until the writer laps the client,
+    // the same window read() copies in. Returns false if not registered.
+    static bool peek(uint8_t client_id, const uint8_t **data, size_t max_size, size_t *len);
+
+    // Advance the client past `len` bytes obtained from peek()
+    static void consume(uint8_t client_id, size_t len);
+
     // Register client for reading (allocates read pointer)
-    // Client starts reading from current write position
-    static bool register_client(uint8_t client_id);
+    // Client starts `behind_bytes` (whole frames) before the write position
+    static bool register_client(uint8_t client_id,
+                                uint32_t behind_bytes = AUDIO_BUFFER_START_BEHIND_BYTES);
     
     // Unregister client (frees read pointer)
     static bool unregister_client(uint8_t client_id);
@@ -34,6 +59,14 @@ public:
     
     // Get overrun count (writer lapped a reader)
     static uint32_t get_overrun_count();
+
+    // Capture clock: frames written since init() and the esp_timer time (µs)
+    // of the last write. A write is one DMA block, so frame `frames` is the
+    // first one after `time_us`.
+    static void get_clock(uint64_t *frames, int64_t *time_us);
+
+    // Capture frame index (same count as get_clock) of the client's next read
+    static uint64_t reader_frame(uint8_t client_id);
     
     // Deinitialize and free ring buffer
     static void deinit();
@@ -2,6 +2,8 @@
 #include "i2s_master.h"
 #include "audio_buffer.h"
 #include "eq_processor.h"
+#include "loudness_meter.h"
+#include "audio_tap.h"
 #include "../system/error_handler.h"
 #include "../system/watchdog.h"
 #include "esp_log.h"
@@ -122,6 +124,12 @@ static void audio_capture_task(void *params)
             ErrorHandler::log_error(ErrorType::SYSTEM_ERROR, 
                                     "Failed to write to ring buffer");
         }
+
+        // EBU R128 loudness of the streamed signal (fixed cost per block)
+        LoudnessMeter::process(converted_buffer, frames);
+
+        // Analysis tap (memcpy, only while an analyzer holds it)
+        AudioTap::write(converted_buffer, frames);
         
         // Lightweight clipping check: test first sample pair per chunk
         if (converted_size >= 6) {
@@ -196,6 +204,9 @@ static void audio_capture_task(void *params)
                 if (state_change_counter >= debounce_threshold) {
                     playback_status.store(candidate_state, std::memory_order_release);
                     state_change_counter = 0;
+                    if (candidate_state) {
+                        LoudnessMeter::reset();  // Integrated loudness per record side
+                    }
                     ESP_LOGI(TAG,
                              "Playback status changed: %s (RMS: %.1f, on: %.1f, off: %.1f)",
                              candidate_state ? "PLAYING" : "IDLE",
@@ -0,0 +1,88 @@
+#include "audio_tap.h"
+#include "dsp_platform.h"
+#include <atomic>
+#include <cstring>
+
+static const char *TAG = "audio_tap";
+
+static constexpr size_t FRAME_BYTES = 6;  // 24-bit packed stereo
+static_assert((AUDIO_TAP_FRAMES & (AUDIO_TAP_FRAMES - 1)) == 0, "ring size must be a power of two");
+
+static uint8_t              *s_ring = nullptr;
+static std::atomic<uint32_t> s_write_idx{0};
+static std::atomic<int>      s_consumers{0};
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool AudioTap::init() {
+    if (s_ring != nullptr) return true;
+
+    const size_t bytes = AUDIO_TAP_FRAMES * FRAME_BYTES;
+    s_ring = (uint8_t *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (s_ring == nullptr) s_ring = (uint8_t *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL);
+    if (s_ring == nullptr) {
+        ESP_LOGE(TAG, "No memory for %u byte tap ring", (unsigned)bytes);
+        return false;
+    }
+    memset(s_ring, 0, bytes);
+
+    ESP_LOGI(TAG, "Audio tap ready (%lu frames, %u bytes)",
+             (unsigned long)AUDIO_TAP_FRAMES, (unsigned)bytes);
+    return true;
+}
+
+void AudioTap::acquire() {
+    s_consumers.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void AudioTap::release() {
+    if (s_consumers.fetch_sub(1, std::memory_order_acq_rel) <= 0) {
+        s_consumers.store(0, std::memory_order_release);  // Unbalanced release
+    }
+}
+
+void AudioTap::write(const uint8_t *pcm24, size_t frames) {
+    if (s_ring == nullptr || s_consumers.load(std::memory_order_relaxed) <= 0) return;
+    if (frames > AUDIO_TAP_MAX_WRITE) frames = AUDIO_TAP_MAX_WRITE;
+
+    uint32_t w   = s_write_idx.load(std::memory_order_relaxed);
+    uint32_t pos = w & (AUDIO_TAP_FRAMES - 1);
+    size_t first = AUDIO_TAP_FRAMES - pos;
+    if (first > frames) first = frames;
+
+    memcpy(s_ring + pos * FRAME_BYTES, pcm24, first * FRAME_BYTES);
+    if (frames > first) {
+        memcpy(s_ring, pcm24 + first * FRAME_BYTES, (frames - first) * FRAME_BYTES);
+    }
+    s_write_idx.store(w + (uint32_t)frames, std::memory_order_release);
+}
+
+uint32_t AudioTap::write_index() {
+    return s_write_idx.load(std::memory_order_acquire);
+}
+
+bool AudioTap::read(uint32_t end, float *lrlr, size_t frames) {
+    if (s_ring == nullptr || lrlr == nullptr) return false;
+    if (frames + AUDIO_TAP_MAX_WRITE > AUDIO_TAP_FRAMES) return false;
+
+    const uint32_t start = end - (uint32_t)frames;
+    uint32_t w = s_write_idx.load(std::memory_order_acquire);
+    // Not yet written, or already (being) overwritten
+    if ((int32_t)(w - end) < 0) return false;
+    if (w - start + AUDIO_TAP_MAX_WRITE > AUDIO_TAP_FRAMES) return false;
+
+    for (size_t i = 0; i < frames; i++) {
+        const uint8_t *src = s_ring + ((start + i) & (AUDIO_TAP_FRAMES - 1)) * FRAME_BYTES;
+        int32_t l = (int32_t)src[0] | ((int32_t)src[1] << 8) | ((int32_t)src[2] << 16);
+        int32_t r = (int32_t)src[3] | ((int32_t)src[4] << 8) | ((int32_t)src[5] << 16);
+        if (l & 0x800000) l |= 0xFF000000;
+        if (r & 0x800000) r |= 0xFF000000;
+        lrlr[i * 2 + 0] = (float)l / 8388608.0f;
+        lrlr[i * 2 + 1] = (float)r / 8388608.0f;
+    }
+
+    // The writer may have lapped the window while we copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    w = s_write_idx.load(std::memory_order_relaxed);
+    return w - start + AUDIO_TAP_MAX_WRITE <= AUDIO_TAP_FRAMES;
+}
@@ -0,0 +1,44 @@
+#ifndef AUDIO_TAP_H
+#define AUDIO_TAP_H
+
+#include <cstdint>
+#include <cstddef>
+
+// AudioTap: lock-free copy of the streamed 24-bit signal for analysis tasks.
+//
+// The capture task (Core 0) appends each block with one memcpy into a ring of
+// AUDIO_TAP_FRAMES frames and then publishes the new write index. Readers
+// (Core 1 analysis tasks) copy any window that has not yet been overwritten
+// and re-check the index afterwards; a window the writer lapped during the
+// copy is reported as lost. Neither side ever blocks the other.
+//
+// The copy only runs while at least one consumer holds the tap, so the
+// capture path pays nothing when no analyzer is in use. Frames written before
+// a consumer's acquire() are stale: start reading at write_index() taken
+// after acquiring.
+
+static constexpr uint32_t AUDIO_TAP_FRAMES    = 8192;  // Power of two
+static constexpr uint32_t AUDIO_TAP_MAX_WRITE = 512;   // Largest block per write()
+
+class AudioTap {
+public:
+    // Allocate the ring (PSRAM preferred). Call once at startup.
+    static bool init();
+
+    // Consumer reference count; the capture task copies only while > 0.
+    static void acquire();
+    static void release();
+
+    // Append `frames` frames of 24-bit packed stereo (Core 0 only).
+    static void write(const uint8_t *pcm24, size_t frames);
+
+    // Total frames written so far (wraps at 2^32).
+    static uint32_t write_index();
+
+    // Copy the `frames` frames ending just before index `end` into `lrlr` as
+    // normalized float32 stereo. Returns false if any of them is not yet
+    // written or was overwritten before the copy finished.
+    static bool read(uint32_t end, float *lrlr, size_t frames);
+};
+
+#endif // AUDIO_TAP_H
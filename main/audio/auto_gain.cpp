@@ -0,0 +1,143 @@
+#include "auto_gain.h"
+#include "loudness_meter.h"
+#include "dsp_platform.h"
+#include <atomic>
+#include <cmath>
+
+static const char *TAG = "auto_gain";
+
+static constexpr float DB_TO_LN = 0.11512925f;     // ln(10) / 20
+
+// ─── Static DRAM_ATTR state (no heap in the audio path) ──────────────────────
+
+static DRAM_ATTR float    s_gain_db  = 0.0f;       // Integrator (Core 0)
+static DRAM_ATTR float    s_gain_lin = 1.0f;       // Applied at the end of the last block
+
+static volatile bool      s_enabled     = false;
+static volatile float     s_target_lufs = -18.0f;
+static volatile float     s_max_gain_db = 12.0f;
+static std::atomic<bool>  s_reset_pending{false};
+
+static uint32_t s_sample_rate = 48000;
+
+// Metrics (written by Core 0, read by Core 1 — 32-bit stores are atomic on Xtensa)
+static volatile bool     s_holding      = true;
+static volatile float    s_short_term   = LOUDNESS_FLOOR_LUFS;
+static volatile float    s_gain_db_out  = 0.0f;
+static volatile uint32_t s_cycles_avg   = 0;
+static volatile uint32_t s_cycles_max   = 0;
+static volatile uint32_t s_block_frames = 240;
+
+// ─── Helpers ─────────────────────────────────────────────────────────────────
+
+static inline float clamp_f(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void apply_params(float target_lufs, float max_gain_db) {
+    s_target_lufs = clamp_f(target_lufs, -40.0f, -10.0f);
+    s_max_gain_db = clamp_f(max_gain_db, 0.0f, 24.0f);
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+void AutoGain::init(uint32_t sample_rate, bool enabled, float target_lufs, float max_gain_db) {
+    s_sample_rate = sample_rate;
+    apply_params(target_lufs, max_gain_db);
+    s_gain_db    = 0.0f;
+    s_gain_lin   = 1.0f;
+    s_gain_db_out = 0.0f;
+    s_reset_pending.store(false, std::memory_order_release);
+    s_enabled    = enabled;
+    s_cycles_avg = 0;
+    s_cycles_max = 0;
+
+    ESP_LOGI(TAG, "AGC %s: target=%.1f LUFS, max gain=%.1f dB",
+             enabled ? "enabled" : "disabled", s_target_lufs, s_max_gain_db);
+}
+
+void AutoGain::configure(bool enabled, float target_lufs, float max_gain_db) {
+    apply_params(target_lufs, max_gain_db);
+    if (enabled && !s_enabled) {
+        // Core 0 restarts the integrator at 0 dB on its next block
+        s_reset_pending.store(true, std::memory_order_release);
+    }
+    s_enabled = enabled;
+
+    ESP_LOGI(TAG, "AGC %s: target=%.1f LUFS, max gain=%.1f dB",
+             enabled ? "enabled" : "disabled", s_target_lufs, s_max_gain_db);
+}
+
+void AutoGain::process(float *lrlr, size_t frames) {
+    if (frames == 0) return;
+    uint32_t t0 = esp_cpu_get_cycle_count();
+
+    if (s_reset_pending.exchange(false, std::memory_order_acq_rel)) {
+        s_gain_db = 0.0f;
+    }
+
+    float goal = 1.0f;
+    if (s_enabled) {
+        const float block_s    = (float)frames / (float)s_sample_rate;
+        const float short_term = LoudnessMeter::short_term_lufs();
+        const bool  holding    = short_term <= AGC_GATE_LUFS;
+        if (!holding) {
+            float step  = (s_target_lufs - short_term) * block_s * (1.0f / AGC_TIME_CONSTANT_S);
+            float slew  = AGC_MAX_SLEW_DB_S * block_s;
+            s_gain_db  += clamp_f(step, -slew, slew);
+        }
+        s_gain_db  = clamp_f(s_gain_db, AGC_MIN_GAIN_DB, s_max_gain_db);
+        goal       = expf(s_gain_db * DB_TO_LN);
+        s_holding    = holding;
+        s_short_term = short_term;
+    } else {
+        s_gain_db = 0.0f;
+    }
+
+    // Linear ramp from the previous block's gain: no steps at block edges
+    float g        = s_gain_lin;
+    const float dg = (goal - g) / (float)frames;
+    for (size_t i = 0; i < frames; i++) {
+        g += dg;
+        lrlr[i * 2 + 0] *= g;
+        lrlr[i * 2 + 1] *= g;
+    }
+    s_gain_lin    = goal;
+    s_gain_db_out = s_gain_db;
+    s_block_frames = (uint32_t)frames;
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+    if (cycles > s_cycles_max) s_cycles_max = cycles;
+    // Running average with 1/16 weight (integer, no float divide)
+    s_cycles_avg = s_cycles_avg == 0 ? cycles : s_cycles_avg - (s_cycles_avg >> 4) + (cycles >> 4);
+}
+
+bool AutoGain::is_active() {
+    return s_enabled || s_gain_lin != 1.0f;
+}
+
+float AutoGain::peak_gain() {
+    // Current gain plus more than one block of maximum slew (≈ 0.02 dB)
+    return s_gain_lin * 1.01f;
+}
+
+void AutoGain::get_stats(AGCStats *stats) {
+    if (stats == nullptr) return;
+
+    // One DMA block period in CPU cycles = frames / fs · f_cpu
+    float block_cycles = (float)s_block_frames / (float)s_sample_rate *
+                         (float)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e6f;
+
+    const float gain_db = s_gain_db_out;
+    stats->enabled         = s_enabled;
+    stats->holding         = s_holding;
+    stats->target_lufs     = s_target_lufs;
+    stats->max_gain_db     = s_max_gain_db;
+    stats->gain_db         = gain_db;
+    stats->short_term_lufs = s_short_term;
+    stats->target_gain_db  = s_holding ? gain_db
+                           : clamp_f(gain_db + s_target_lufs - s_short_term, AGC_MIN_GAIN_DB, s_max_gain_db);
+    stats->cycles_avg      = s_cycles_avg;
+    stats->cycles_max      = s_cycles_max;
+    stats->budget_pct      = block_cycles > 0.0f ? 100.0f * (float)s_cycles_avg / block_cycles : 0.0f;
+}
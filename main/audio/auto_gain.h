@@ -0,0 +1,71 @@
+#ifndef AUTO_GAIN_H
+#define AUTO_GAIN_H
+
+#include <cstdint>
+#include <cstddef>
+
+// AutoGain: slow input level normalization for the EQ float path.
+//
+// Runs on Core 0 inside EQProcessor::process(), after the FIR stage and
+// before the limiter (which catches the peaks of a boosted record). The level
+// comes from LoudnessMeter's short-term loudness (3 s, K-weighted) of the
+// streamed output, so the loop is closed around the applied gain:
+//
+//   per DMA block, if short_term > AGC_GATE_LUFS:
+//     step     = (target − short_term) · T_block / AGC_TIME_CONSTANT_S
+//     gain_db += clamp(step, ±AGC_MAX_SLEW_DB_S · T_block)
+//     gain_db  = clamp(gain_db, AGC_MIN_GAIN_DB, max_gain_db)
+//   out = in · g, g ramped linearly from the previous block's gain
+//
+// Below the gate (run-out, lead-in grooves, the 3 s after a meter reset) the
+// gain holds, so silence between sides is not pumped up. The integrator's
+// 10 s time constant is long against the 1.5 s delay of the short-term
+// window, so the loop settles without overshoot; a 10 dB level change is
+// 90 % corrected after about 25 s.
+//
+// Cost per block (fixed): one expf plus one add and two multiplies per frame.
+// While disabled process() is not called and the float path is not entered
+// for it; disabling ramps back to unity over one block first.
+//
+// State is static (no heap in the audio path).
+
+static constexpr float AGC_TIME_CONSTANT_S = 10.0f;
+static constexpr float AGC_MAX_SLEW_DB_S   = 3.0f;
+static constexpr float AGC_GATE_LUFS       = -50.0f;
+static constexpr float AGC_MIN_GAIN_DB     = -12.0f;
+
+struct AGCStats {
+    bool     enabled;
+    bool     holding;               // Short-term loudness below the gate
+    float    target_lufs;
+    float    max_gain_db;
+    float    gain_db;               // Applied at the end of the last block
+    float    target_gain_db;        // Gain that would meet the target now (clamped)
+    float    short_term_lufs;       // Loudness the loop sees
+    uint32_t cycles_avg;            // CPU cycles per DMA block (running average)
+    uint32_t cycles_max;
+    float    budget_pct;            // cycles_avg as % of one DMA block period
+};
+
+class AutoGain {
+public:
+    // Configure for a sample rate; the gain starts at 0 dB.
+    static void init(uint32_t sample_rate, bool enabled, float target_lufs, float max_gain_db);
+
+    // Change parameters at runtime (Core 1). Enabling starts from 0 dB.
+    static void configure(bool enabled, float target_lufs, float max_gain_db);
+
+    // Apply the gain to `frames` stereo frames in place (Core 0 only).
+    static void process(float *lrlr, size_t frames);
+
+    // True while process() must run: enabled, or still ramping back to unity
+    static bool  is_active();
+
+    // Largest linear gain the next block can apply (silence bound for the EQ
+    // fast path)
+    static float peak_gain();
+
+    static void  get_stats(AGCStats *stats);
+};
+
+#endif // AUTO_GAIN_H
@@ -0,0 +1,116 @@
+#include "dither.h"
+
+// ─── Sample sources (24-bit signed integer per interleaved sample) ───────────
+
+struct S24Source {
+    const uint8_t *p;
+    inline int32_t operator()(size_t i) const {
+        const uint8_t *s = p + i * 3;
+        // Assemble in the top bytes and shift back down to sign-extend
+        return (int32_t)(((uint32_t)s[0] << 8) | ((uint32_t)s[1] << 16) | ((uint32_t)s[2] << 24)) >> 8;
+    }
+};
+
+struct F32Source {
+    const float *p;
+    inline int32_t operator()(size_t i) const {
+        float f = p[i];
+        if (f > 0.99999988f) f = 0.99999988f;   // (2²³ − 1) / 2²³
+        if (f < -1.0f)       f = -1.0f;
+        return (int32_t)(f * 8388608.0f);       // Sub-LSB24 truncation is below any dither
+    }
+};
+
+// ─── Quantizer ───────────────────────────────────────────────────────────────
+
+static inline int32_t clip16(int32_t y) {
+    return y > 32767 ? 32767 : (y < -32768 ? -32768 : y);
+}
+
+static inline int32_t clamp_err(int32_t e) {
+    return e > 512 ? 512 : (e < -512 ? -512 : e);
+}
+
+static inline void put16(uint8_t *out, int32_t y) {
+    out[0] = (uint8_t)(y & 0xFF);
+    out[1] = (uint8_t)((y >> 8) & 0xFF);
+}
+
+// ORDER < 0: no dither. ORDER 0: TPDF. ORDER 1/2: TPDF + shaping.
+template <int ORDER, typename Source>
+static void quantize(Ditherer &d, Source src, uint8_t *out, size_t frames) {
+    uint32_t rng = d.rng;
+    int32_t l1 = d.err[0][0], l2 = d.err[0][1];
+    int32_t r1 = d.err[1][0], r2 = d.err[1][1];
+
+    for (size_t n = 0; n < frames; n++) {
+        int32_t xl = src(n * 2 + 0);
+        int32_t xr = src(n * 2 + 1);
+
+        int32_t dl = 0, dr = 0;
+        if (ORDER >= 0) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            dl = (int32_t)(rng & 0xFF) + (int32_t)((rng >> 8) & 0xFF) - 255;
+            dr = (int32_t)((rng >> 16) & 0xFF) + (int32_t)(rng >> 24) - 255;
+        }
+
+        if (ORDER == 1) {
+            xl -= l1;
+            xr -= r1;
+        } else if (ORDER == 2) {
+            xl -= 2 * l1 - l2;
+            xr -= 2 * r1 - r2;
+        }
+
+        int32_t yl = clip16((xl + dl + 128) >> 8);
+        int32_t yr = clip16((xr + dr + 128) >> 8);
+
+        if (ORDER >= 1) {
+            l2 = l1;
+            r2 = r1;
+            l1 = clamp_err(yl * 256 - xl);
+            r1 = clamp_err(yr * 256 - xr);
+        }
+
+        put16(out + n * 4 + 0, yl);
+        put16(out + n * 4 + 2, yr);
+    }
+
+    d.rng = rng;
+    d.err[0][0] = l1; d.err[0][1] = l2;
+    d.err[1][0] = r1; d.err[1][1] = r2;
+}
+
+template <typename Source>
+static void dispatch(Ditherer &d, Source src, uint8_t *out, size_t frames) {
+    switch (d.mode) {
+        case DitherMode::OFF:      quantize<-1>(d, src, out, frames); break;
+        case DitherMode::TPDF_NS1: quantize<1>(d, src, out, frames);  break;
+        case DitherMode::TPDF_NS2: quantize<2>(d, src, out, frames);  break;
+        case DitherMode::TPDF:
+        default:                   quantize<0>(d, src, out, frames);  break;
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+void Ditherer::init(DitherMode m, uint32_t seed) {
+    mode = m;
+    rng  = seed != 0 ? seed : 0x9E3779B9u;
+    reset();
+}
+
+void Ditherer::reset() {
+    err[0][0] = err[0][1] = 0;
+    err[1][0] = err[1][1] = 0;
+}
+
+void Ditherer::process_s24(const uint8_t *pcm24, uint8_t *out, size_t frames) {
+    dispatch(*this, S24Source{pcm24}, out, frames);
+}
+
+void Ditherer::process_f32(const float *lrlr, uint8_t *out, size_t frames) {
+    dispatch(*this, F32Source{lrlr}, out, frames);
+}
@@ -0,0 +1,56 @@
+#ifndef DITHER_H
+#define DITHER_H
+
+#include <cstdint>
+#include <cstddef>
+#include "../config_schema.h"
+
+// Ditherer: 24 → 16-bit requantization for the stream output.
+//
+// Working in 24-bit integer units (1 LSB16 = 256), per sample and channel:
+//
+//   v = x − Σ c_k · e[n−k]                  noise-shaping feedback
+//   d = u1 + u2 − 255                       TPDF, u1/u2 uniform on 0…255
+//   y = clip16((v + d + 128) >> 8)
+//   e = 256 · y − v                         total error (dither included)
+//
+// so the output is x + e filtered by the noise transfer function 1 − Σ c_k z⁻ᵏ:
+//
+//   TPDF      c = {}        flat, 0.5 LSB rms (−96.3 dBFS)
+//   TPDF_NS1  c = {1}       (1 − z⁻¹)   +3 dB total, +6 dB at fs/2
+//   TPDF_NS2  c = {2, −1}   (1 − z⁻¹)²  +7.8 dB total, +12 dB at fs/2
+//
+// TPDF of ±1 LSB makes the error's mean and variance independent of the
+// signal, so quiet passages get a steady hiss instead of truncation
+// distortion. Both shaped curves cross the flat floor at fs/6 and move the
+// noise above it: over 0–2 kHz at 48 kHz the floor drops 16 dB (1st order)
+// or 30 dB (2nd order).
+//
+// One xorshift32 step per frame yields the four bytes for both channels'
+// dither; L and R are uncorrelated. The unshaped loop carries no state but
+// the generator, the shaped loops carry one or two errors per channel in
+// registers. The error is clamped to ±2 LSB so a clipped sample cannot make
+// the shaping loop run away.
+//
+// One instance per stream pipe; not shared between threads.
+
+struct Ditherer {
+    DitherMode mode;
+    uint32_t   rng;             // xorshift32 state, never 0
+    int32_t    err[2][2];       // [channel][e(n−1), e(n−2)]
+
+    // Select the mode and seed the generator (non-zero seeds give different
+    // sequences, so pipes do not share a noise pattern)
+    void init(DitherMode mode, uint32_t seed);
+
+    // Clear the shaping state (after a gap in the input)
+    void reset();
+
+    // Packed 24-bit LE stereo → 16-bit LE stereo. OFF rounds to nearest.
+    void process_s24(const uint8_t *pcm24, uint8_t *out, size_t frames);
+
+    // Interleaved float stereo (±1.0 full scale) → 16-bit LE stereo
+    void process_f32(const float *lrlr, uint8_t *out, size_t frames);
+};
+
+#endif // DITHER_H
@@ -0,0 +1,28 @@
+#ifndef DSP_PLATFORM_H
+#define DSP_PLATFORM_H
+
+// DSP platform layer for the float audio path (EQProcessor, PeakLimiter,
+// EQResponse) and the stream encoders: the one place those modules pull the
+// ESP-IDF, FreeRTOS and esp-dsp headers from, so dsps_* resolve to the
+// ae32/aes3 assembly kernels.
+//
+// The modules use nothing beyond these headers, which keeps them portable:
+// the host test suite (test/host) supplies the same header names from
+// test/host/stub, with reference kernels and host threads behind them, and
+// builds the unmodified sources with a plain toolchain:
+//
+//   cmake -S test/host -B build-host && cmake --build build-host
+//   ctest --test-dir build-host --output-on-failure
+
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_dsp.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#endif  // DSP_PLATFORM_H
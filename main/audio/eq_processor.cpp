@@ -1,6 +1,10 @@
 #include "eq_processor.h"
-#include "esp_dsp.h"
-#include "esp_log.h"
+#include "phono_filters.h"
+#include "peak_limiter.h"
+#include "fir_filter.h"
+#include "auto_gain.h"
+#include "dsp_platform.h"
+#include <atomic>
 #include <cstring>
 #include <cmath>
 
@@ -10,14 +14,80 @@ static const char *TAG = "eq_processor";
 // DRAM_ATTR ensures arrays are in internal SRAM, preventing cache miss latency
 // in the Xtensa ae32 biquad multiply-accumulate loop.
 
-static DRAM_ATTR float  s_coef[EQ_MAX_BANDS][5];       // Biquad coefficients {b0,b1,b2,a1,a2}
+// Band coefficients live in two banks. Live edits (update_band) write the
+// published bank in place; whole-set swaps (load_bank, used by EQ presets) fill
+// the other bank and publish it with one atomic store. Core 0 picks the new
+// bank up at the next block boundary and crossfades old → new over that block,
+// then acknowledges it via s_bank_in_use.
+struct BandBank {
+    float        coef[EQ_MAX_BANDS][5];   // Biquad coefficients {b0,b1,b2,a1,a2}
+    EQBandConfig bands[EQ_MAX_BANDS];     // Band configs (read each DMA block)
+    uint8_t      active_bands;
+};
+
+static DRAM_ATTR BandBank s_bank[2];
+static std::atomic<uint8_t> s_bank_published{0};  // Written by Core 1
+static std::atomic<uint8_t> s_bank_in_use{0};     // Acknowledged by Core 0
+
 static DRAM_ATTR float  s_w[EQ_MAX_BANDS][4];           // Stereo delay lines {wL0,wL1,wR0,wR1}
 static DRAM_ATTR float  s_float_buf[EQ_FRAMES_PER_BLOCK * 2]; // Float32 LRLR interleaved workspace
-static DRAM_ATTR EQBandConfig s_bands[EQ_MAX_BANDS];   // Band configs (read each DMA block)
+
+// Crossfade workspace: the outgoing bank runs on a copy of the block with a
+// throwaway copy of the delay lines
+static DRAM_ATTR float  s_xfade_buf[EQ_FRAMES_PER_BLOCK * 2];
+static DRAM_ATTR float  s_xfade_w[EQ_MAX_BANDS][4];
 
 static DRAM_ATTR bool     s_enabled      = false;
-static DRAM_ATTR uint8_t  s_active_bands = 0;
 static uint32_t s_sample_rate  = 48000;
+static volatile uint32_t s_bank_swaps = 0;
+
+static constexpr uint32_t BANK_ACK_TIMEOUT_MS = 50;  // ≈ 10 DMA blocks at 48 kHz
+
+// Phono preset stage — coefficients copied from the constexpr tables in
+// phono_filters.h. Double-buffered like the band banks: set_phono() (or a
+// sample-rate change) fills the spare bank and publishes it; Core 0 clears the
+// stage delay lines when it picks the new bank up, then acknowledges it.
+struct PhonoBank {
+    float   coef[PHONO_MAX_STAGES][5];
+    uint8_t stages;
+};
+
+static DRAM_ATTR PhonoBank s_phono[2];
+static DRAM_ATTR float  s_phono_w[PHONO_MAX_STAGES][4];
+static std::atomic<uint8_t> s_phono_published{0};  // Written by Core 1
+static std::atomic<uint8_t> s_phono_in_use{0};     // Acknowledged by Core 0
+static PhonoCurve s_phono_curve  = PhonoCurve::OFF;
+static bool       s_phono_rumble = false;
+
+// Bumped on every coefficient change; lets Core 1 consumers (e.g. the
+// /eq/response cache) detect stale derived data without locking.
+static std::atomic<uint32_t> s_coef_generation{0};
+
+// ─── Silent-block fast path ──────────────────────────────────────────────────
+// A block is skipped (output = digital zero) when the worst-case cascade output
+// for its input peak is below EQ_SILENCE_THRESHOLD, all delay lines are below
+// EQ_STATE_EPSILON, and the previous block's output and the limiter's
+// lookahead delay line were already below the threshold. Every sample of such
+// a block would quantize to 0 in step 4 anyway, so the fast path never changes
+// the output. It is therefore taken only for digital silence (a muted or
+// powered-down ADC, a zeroed source): the PCM1808's idle noise floor sits far
+// above one LSB, so lead-in, run-out and an idle turntable run the full path.
+//
+// s_silence_gain is the L1 norm of the cascade impulse response, i.e. the exact
+// upper bound on |output| / |input| peak; recomputed on Core 1 on every
+// coefficient change.
+
+static DRAM_ATTR float    s_silence_gain      = 1.0f;
+static DRAM_ATTR float    s_prev_out_peak     = 1.0f;   // Previous block output peak (float scale)
+static DRAM_ATTR bool     s_in_fast_path      = false;
+
+// Statistics (written by Core 0, read by Core 1 — 32-bit stores are atomic on Xtensa)
+static volatile uint32_t  s_blocks_total      = 0;
+static volatile uint32_t  s_blocks_silent     = 0;
+static volatile uint32_t  s_denormal_flushes  = 0;
+static volatile uint32_t  s_cycles_full_avg   = 0;
+static volatile uint32_t  s_cycles_fast_avg   = 0;
+static volatile uint32_t  s_last_frames       = EQ_FRAMES_PER_BLOCK;
 
 // ─── Helpers ─────────────────────────────────────────────────────────────────
 
@@ -43,77 +113,180 @@ static void biquad_gen_peak(float *c, float freq_hz, float gain_db, float Q, flo
     c[4] = (1.0f - alpha / A) * a0_inv;  // a2
 }
 
-// Recompute biquad coefficients for one band from s_bands[b] and s_sample_rate.
-static void recompute_band_coef(uint8_t b) {
-    const EQBandConfig& band = s_bands[b];
-
+// Compute biquad coefficients for one band at the given sample rate.
+static void compute_band_coef(const EQBandConfig& band, uint32_t sample_rate, float *c) {
     if (!band.enabled) {
         // Identity filter: pass through without processing
-        s_coef[b][0] = 1.0f; s_coef[b][1] = 0.0f; s_coef[b][2] = 0.0f;
-        s_coef[b][3] = 0.0f; s_coef[b][4] = 0.0f;
+        c[0] = 1.0f; c[1] = 0.0f; c[2] = 0.0f;
+        c[3] = 0.0f; c[4] = 0.0f;
         return;
     }
 
-    float freq  = clamp_f(band.frequency_hz, 20.0f, (float)s_sample_rate * 0.5f - 1.0f);
+    float freq  = clamp_f(band.frequency_hz, 20.0f, (float)sample_rate * EQ_MAX_FREQ_RATIO);
     float gain  = clamp_f(band.gain_db,  -24.0f,  24.0f);
     float Q     = clamp_f(band.q_factor,   0.1f,  10.0f);
-    float f_norm = freq / (float)s_sample_rate;  // Normalized freq for esp-dsp generators
+    float f_norm = freq / (float)sample_rate;  // Normalized freq for esp-dsp generators
 
     switch (band.filter_type) {
         case EQFilterType::LOW_SHELF:
-            dsps_biquad_gen_lowShelf_f32(s_coef[b], f_norm, gain, Q);
+            dsps_biquad_gen_lowShelf_f32(c, f_norm, gain, Q);
             break;
         case EQFilterType::HIGH_SHELF:
-            dsps_biquad_gen_highShelf_f32(s_coef[b], f_norm, gain, Q);
+            dsps_biquad_gen_highShelf_f32(c, f_norm, gain, Q);
             break;
         case EQFilterType::LOW_PASS:
-            dsps_biquad_gen_lpf_f32(s_coef[b], f_norm, Q);
+            dsps_biquad_gen_lpf_f32(c, f_norm, Q);
             break;
         case EQFilterType::HIGH_PASS:
-            dsps_biquad_gen_hpf_f32(s_coef[b], f_norm, Q);
+            dsps_biquad_gen_hpf_f32(c, f_norm, Q);
             break;
         case EQFilterType::PEAKING:
         default:
-            biquad_gen_peak(s_coef[b], freq, gain, Q, (float)s_sample_rate);
+            biquad_gen_peak(c, freq, gain, Q, (float)sample_rate);
             break;
     }
 
-    ESP_LOGD(TAG, "Band %u: %s %.0fHz %.1fdB Q=%.2f -> coef=[%.4f %.4f %.4f %.4f %.4f]",
-             b, eq_filter_type_to_str(band.filter_type), freq, gain, Q,
-             s_coef[b][0], s_coef[b][1], s_coef[b][2], s_coef[b][3], s_coef[b][4]);
+    ESP_LOGD(TAG, "%s %.0fHz %.1fdB Q=%.2f -> coef=[%.4f %.4f %.4f %.4f %.4f]",
+             eq_filter_type_to_str(band.filter_type), freq, gain, Q,
+             c[0], c[1], c[2], c[3], c[4]);
 }
 
-static uint8_t count_active_bands() {
+static uint8_t count_active_bands(const BandBank& bank) {
     uint8_t count = 0;
     for (uint8_t b = 0; b < EQ_MAX_BANDS; b++) {
-        if (s_bands[b].enabled) count++;
+        if (bank.bands[b].enabled) count++;
     }
     return count;
 }
 
+static inline BandBank& published_bank() {
+    return s_bank[s_bank_published.load(std::memory_order_acquire)];
+}
+
+static inline const PhonoBank& published_phono() {
+    return s_phono[s_phono_published.load(std::memory_order_acquire)];
+}
+
+// Wait until Core 0 has acknowledged the published bank of a pair, so the
+// spare one is free to rewrite. When no audio is being processed the wait
+// simply times out.
+static void wait_bank_ack(const std::atomic<uint8_t>& published, const std::atomic<uint8_t>& in_use) {
+    const uint8_t idx = published.load(std::memory_order_acquire);
+    uint32_t waited_ms = 0;
+    while (in_use.load(std::memory_order_acquire) != idx && waited_ms < BANK_ACK_TIMEOUT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+        waited_ms++;
+    }
+}
+
+// Run every enabled band of `bank` over `buf` in place
+static inline void run_bank(const BandBank& bank, float *buf, size_t frames, float (*w)[4]) {
+    for (uint8_t b = 0; b < EQ_MAX_BANDS; b++) {
+        if (!bank.bands[b].enabled) continue;
+        dsps_biquad_sf32(buf, buf, (int)frames, const_cast<float *>(bank.coef[b]), w[b]);
+    }
+}
+
+static inline uint32_t cycles_ema(uint32_t avg, uint32_t sample) {
+    return avg == 0 ? sample : avg - (avg >> 4) + (sample >> 4);
+}
+
+// Flush delay-line values that have decayed below EQ_STATE_EPSILON to exact
+// zero (keeps the FPU out of denormal territory during long fades), and return
+// the largest remaining |w| across all stages.
+static float flush_and_measure_state(const BandBank& bank, uint8_t phono_stages, bool eq_active) {
+    float state_max = 0.0f;
+    uint32_t flushed = 0;
+
+    auto scan = [&](float *w) {
+        for (int k = 0; k < 4; k++) {
+            float a = fabsf(w[k]);
+            if (a < EQ_STATE_EPSILON) {
+                if (w[k] != 0.0f) { w[k] = 0.0f; flushed++; }
+            } else if (a > state_max) {
+                state_max = a;
+            }
+        }
+    };
+
+    for (uint8_t st = 0; st < phono_stages; st++) scan(s_phono_w[st]);
+    if (eq_active) {
+        for (uint8_t b = 0; b < EQ_MAX_BANDS; b++) {
+            if (bank.bands[b].enabled) scan(s_w[b]);
+        }
+    }
+    if (flushed) s_denormal_flushes = s_denormal_flushes + flushed;
+    return state_max;
+}
+
+// L1 norm of the active cascade's impulse response (float, Core 1).
+// Runs until the tail has stayed below 1e-7 for 256 samples or the cap is hit;
+// the 10 % margin covers the truncated tail.
+static void update_silence_gain() {
+    constexpr uint8_t  MAX_STAGES  = PHONO_MAX_STAGES + EQ_MAX_BANDS;
+    constexpr uint32_t MAX_SAMPLES = 16384;
+
+    float coef[MAX_STAGES][5];
+    float w[MAX_STAGES][2] = {};
+    uint8_t stages = EQProcessor::copy_active_coefs(coef, MAX_STAGES);
+
+    float l1 = 0.0f;
+    uint32_t quiet = 0;
+    for (uint32_t n = 0; n < MAX_SAMPLES && quiet < 256; n++) {
+        float x = (n == 0) ? 1.0f : 0.0f;
+        for (uint8_t st = 0; st < stages; st++) {
+            // Direct form II, same structure as dsps_biquad_f32
+            float d0 = x - coef[st][3] * w[st][0] - coef[st][4] * w[st][1];
+            x = coef[st][0] * d0 + coef[st][1] * w[st][0] + coef[st][2] * w[st][1];
+            w[st][1] = w[st][0];
+            w[st][0] = d0;
+        }
+        float a = fabsf(x);
+        l1 += a;
+        quiet = (a < 1e-7f && n > 0) ? quiet + 1 : 0;
+    }
+    s_silence_gain = stages == 0 ? 1.0f : l1 * 1.1f;
+}
+
+// Called after every coefficient change (Core 1)
+static void coefs_changed() {
+    s_coef_generation.fetch_add(1, std::memory_order_release);
+    update_silence_gain();
+}
+
 // ─── Public API ──────────────────────────────────────────────────────────────
 
 bool EQProcessor::init(const DeviceConfig& config, uint32_t sample_rate) {
     s_sample_rate = sample_rate;
     s_enabled     = config.eq_enabled;
 
-    memcpy(s_bands, config.eq_bands, sizeof(s_bands));
+    BandBank& bank = s_bank[0];
+    memcpy(bank.bands, config.eq_bands, sizeof(bank.bands));
     memset(s_w, 0, sizeof(s_w));
 
     for (uint8_t b = 0; b < EQ_MAX_BANDS; b++) {
-        recompute_band_coef(b);
+        compute_band_coef(bank.bands[b], s_sample_rate, bank.coef[b]);
     }
-    s_active_bands = count_active_bands();
+    bank.active_bands = count_active_bands(bank);
+    s_bank_published.store(0, std::memory_order_release);
+    s_bank_in_use.store(0, std::memory_order_release);
+    set_phono(config.phono_curve, config.phono_rumble_filter);
+    PeakLimiter::init(sample_rate, config.limiter_enabled,
+                      config.limiter_ceiling_db, config.limiter_release_ms);
+    AutoGain::init(sample_rate, config.agc_enabled, config.agc_target_lufs, config.agc_max_gain_db);
+    s_prev_out_peak = 1.0f;
+    s_in_fast_path  = false;
+    coefs_changed();
 
     ESP_LOGI(TAG, "EQ initialized: %u/%u bands active, sample_rate=%lu, %s",
-             s_active_bands, EQ_MAX_BANDS, (unsigned long)s_sample_rate,
+             bank.active_bands, EQ_MAX_BANDS, (unsigned long)s_sample_rate,
              s_enabled ? "ENABLED" : "bypassed");
 
     for (uint8_t b = 0; b < EQ_MAX_BANDS; b++) {
         ESP_LOGI(TAG, "  Band %u: %s %.0fHz %.1fdB Q=%.2f [%s]",
-                 b, eq_filter_type_to_str(s_bands[b].filter_type),
-                 s_bands[b].frequency_hz, s_bands[b].gain_db, s_bands[b].q_factor,
-                 s_bands[b].enabled ? "on" : "off");
+                 b, eq_filter_type_to_str(bank.bands[b].filter_type),
+                 bank.bands[b].frequency_hz, bank.bands[b].gain_db, bank.bands[b].q_factor,
+                 bank.bands[b].enabled ? "on" : "off");
     }
     return true;
 }
@@ -121,10 +294,30 @@ bool EQProcessor::init(const DeviceConfig& config, uint32_t sample_rate) {
 // process() is called from Core 0 audio_capture_task per DMA block.
 // Constitution §IV: no mutex; float writes from Core 1 are atomic on Xtensa.
 bool EQProcessor::process(const uint8_t* input_i2s, uint8_t* output_24, size_t frames) {
-    if (!s_enabled || s_active_bands == 0) {
+    const uint8_t   bank_idx     = s_bank_published.load(std::memory_order_acquire);
+    const uint8_t   prev_idx     = s_bank_in_use.load(std::memory_order_relaxed);
+    const BandBank& bank         = s_bank[bank_idx];
+    const BandBank& prev_bank    = s_bank[prev_idx];
+    const bool      eq_active    = s_enabled && bank.active_bands > 0;
+    const bool      prev_active  = s_enabled && prev_bank.active_bands > 0;
+    const bool      crossfade    = bank_idx != prev_idx && (eq_active || prev_active);
+    const uint8_t   phono_idx    = s_phono_published.load(std::memory_order_acquire);
+    const PhonoBank& phono       = s_phono[phono_idx];
+    const uint8_t   phono_stages = phono.stages;
+    const bool      fir_active   = FIRFilter::is_active();
+    const bool      agc_active   = AutoGain::is_active();
+    if (phono_idx != s_phono_in_use.load(std::memory_order_relaxed)) {
+        memset(s_phono_w, 0, sizeof(s_phono_w));  // New phono stage set starts clean
+        s_phono_in_use.store(phono_idx, std::memory_order_release);
+    }
+    if (!eq_active && !crossfade && phono_stages == 0 && !fir_active && !agc_active) {
+        s_bank_in_use.store(bank_idx, std::memory_order_release);
         return false;  // Caller uses legacy bit-packing path — zero overhead
     }
 
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    int32_t in_peak = 0;
+
     // Step 1: Convert 32-bit MSB-aligned I²S slots → float32 LRLR normalized [-1, +1]
     // I²S layout per stereo frame (8 bytes):
     //   [L_byte0=0, L_byte1=LSB, L_byte2=mid, L_byte3=MSB]
@@ -144,28 +337,110 @@ bool EQProcessor::process(const uint8_t* input_i2s, uint8_t* output_24, size_t f
 
         s_float_buf[i * 2 + 0] = (float)lv / 8388608.0f;  // L — normalize to [-1, +1]
         s_float_buf[i * 2 + 1] = (float)rv / 8388608.0f;  // R
+
+        int32_t la = lv < 0 ? -lv : lv;
+        int32_t ra = rv < 0 ? -rv : rv;
+        if (la > in_peak) in_peak = la;
+        if (ra > in_peak) in_peak = ra;
+    }
+
+    // Silent-block fast path: skip the cascade while input, state and the
+    // previous output are all below the threshold, and nothing audible waits
+    // in the limiter's lookahead. Delay lines (the limiter's included) are
+    // cleared on entry so processing resumes from a clean state on the next
+    // loud block. Not taken while the FIR stage runs: its delay line spans
+    // many blocks.
+    float in_bound = (float)in_peak / 8388608.0f * s_silence_gain;
+    if (agc_active) in_bound *= AutoGain::peak_gain();
+    const bool limiter = PeakLimiter::is_enabled();
+    if (!fir_active && in_bound < EQ_SILENCE_THRESHOLD && s_prev_out_peak < EQ_SILENCE_THRESHOLD &&
+        flush_and_measure_state(bank, phono_stages, eq_active) < EQ_STATE_EPSILON &&
+        (!limiter || s_in_fast_path || PeakLimiter::pending_peak() < EQ_SILENCE_THRESHOLD)) {
+        s_bank_in_use.store(bank_idx, std::memory_order_release);
+        if (!s_in_fast_path) {
+            memset(s_w, 0, sizeof(s_w));
+            memset(s_phono_w, 0, sizeof(s_phono_w));
+            if (limiter) PeakLimiter::flush();
+            s_in_fast_path = true;
+        }
+        memset(output_24, 0, frames * 6);
+        s_prev_out_peak = 0.0f;
+        s_blocks_silent = s_blocks_silent + 1;
+        s_blocks_total  = s_blocks_total + 1;
+        s_last_frames   = (uint32_t)frames;
+        s_cycles_fast_avg = cycles_ema(s_cycles_fast_avg, esp_cpu_get_cycle_count() - t0);
+        return true;
     }
+    s_in_fast_path = false;
 
     // Step 2: Apply biquad filter chain in-place (stereo interleaved LRLR)
     // dsps_biquad_sf32 is a macro → resolves to ae32/aes3 FPU assembly on ESP32/S3
-    for (uint8_t b = 0; b < EQ_MAX_BANDS; b++) {
-        if (!s_bands[b].enabled) continue;
-        dsps_biquad_sf32(s_float_buf, s_float_buf, (int)frames, s_coef[b], s_w[b]);
+    // Phono preset stages run first, in the same pass as the user bands.
+    for (uint8_t st = 0; st < phono_stages; st++) {
+        dsps_biquad_sf32(s_float_buf, s_float_buf, (int)frames, const_cast<float *>(phono.coef[st]),
+                         s_phono_w[st]);
+    }
+    if (crossfade) {
+        // Bank swap: run the outgoing bank on a copy of the block with a copy
+        // of the delay lines, the incoming bank on the live buffer and state,
+        // then ramp linearly from old to new across the block.
+        for (uint8_t b = 0; b < EQ_MAX_BANDS; b++) {
+            if (bank.bands[b].enabled && !(prev_active && prev_bank.bands[b].enabled)) {
+                memset(s_w[b], 0, sizeof(s_w[b]));  // Newly enabled band starts clean
+            }
+        }
+        memcpy(s_xfade_buf, s_float_buf, frames * 2 * sizeof(float));
+        memcpy(s_xfade_w, s_w, sizeof(s_w));
+        if (prev_active) run_bank(prev_bank, s_xfade_buf, frames, s_xfade_w);
+        if (eq_active)   run_bank(bank, s_float_buf, frames, s_w);
+
+        const float step = 1.0f / (float)frames;
+        for (size_t i = 0; i < frames; i++) {
+            float g = (float)(i + 1) * step;
+            s_float_buf[i * 2 + 0] = s_xfade_buf[i * 2 + 0] + g * (s_float_buf[i * 2 + 0] - s_xfade_buf[i * 2 + 0]);
+            s_float_buf[i * 2 + 1] = s_xfade_buf[i * 2 + 1] + g * (s_float_buf[i * 2 + 1] - s_xfade_buf[i * 2 + 1]);
+        }
+        s_bank_swaps = s_bank_swaps + 1;
+    } else if (eq_active) {
+        run_bank(bank, s_float_buf, frames, s_w);
     }
+    s_bank_in_use.store(bank_idx, std::memory_order_release);
 
-    // Step 3: Convert float32 LRLR → 24-bit packed little-endian stereo
+    // Step 2b: FIR correction (partitioned convolution, tail precomputed on
+    // the fir_tail task)
+    if (fir_active) {
+        FIRFilter::process(s_float_buf, frames);
+    }
+
+    // Step 2c: Automatic gain (optional), ahead of the limiter so boosted
+    // peaks are limited rather than clipped
+    if (agc_active) {
+        AutoGain::process(s_float_buf, frames);
+    }
+
+    // Step 3: Lookahead peak limiter (optional) keeps peaks under the ceiling;
+    // the clamp below then only catches float rounding.
+    if (limiter) {
+        PeakLimiter::process(s_float_buf, frames);
+    }
+
+    // Step 4: Convert float32 LRLR → 24-bit packed little-endian stereo
+    float out_peak = 0.0f;
     for (size_t i = 0; i < frames; i++) {
         size_t dst = i * 6;
 
         float lf = s_float_buf[i * 2 + 0];
         float rf = s_float_buf[i * 2 + 1];
 
-        // Hard-clip to [-1, +1] before quantization
+        // Hard-clip to [-1, +1] before quantization (only path when limiter is off)
         if (lf >  1.0f) lf =  1.0f;
         if (lf < -1.0f) lf = -1.0f;
         if (rf >  1.0f) rf =  1.0f;
         if (rf < -1.0f) rf = -1.0f;
 
+        float pa = fabsf(lf) > fabsf(rf) ? fabsf(lf) : fabsf(rf);
+        if (pa > out_peak) out_peak = pa;
+
         int32_t lo = (int32_t)(lf * 8388607.0f);
         int32_t ro = (int32_t)(rf * 8388607.0f);
 
@@ -177,19 +452,63 @@ bool EQProcessor::process(const uint8_t* input_i2s, uint8_t* output_24, size_t f
         output_24[dst + 5] = (uint8_t)((ro >> 16) & 0xFF);  // R2 MSB
     }
 
+    // Denormal protection: flush decayed delay-line state once per block
+    flush_and_measure_state(bank, phono_stages, eq_active);
+
+    s_prev_out_peak = out_peak;
+    s_blocks_total  = s_blocks_total + 1;
+    s_last_frames   = (uint32_t)frames;
+    s_cycles_full_avg = cycles_ema(s_cycles_full_avg, esp_cpu_get_cycle_count() - t0);
     return true;
 }
 
+// Fill the spare phono bank for the current curve, rumble filter and sample
+// rate, then publish it (Core 1)
+static void load_phono_bank() {
+    wait_bank_ack(s_phono_published, s_phono_in_use);
+    const uint8_t spare = s_phono_published.load(std::memory_order_acquire) ^ 1;
+    PhonoBank& bank = s_phono[spare];
+
+    const phono::CoefSet* set = phono::coef_set_for_rate(s_sample_rate);
+    bank.stages = set != nullptr ? phono::build_stages(*set, s_phono_curve, s_phono_rumble, bank.coef) : 0;
+    s_phono_published.store(spare, std::memory_order_release);
+    coefs_changed();
+
+    if (set == nullptr) {
+        if (s_phono_curve != PhonoCurve::OFF || s_phono_rumble) {
+            ESP_LOGW(TAG, "Phono stage unavailable at %lu Hz (bypassed)",
+                     (unsigned long)s_sample_rate);
+        }
+        return;
+    }
+    ESP_LOGI(TAG, "Phono stage: curve=%s rumble=%s (%u biquads @ %lu Hz)",
+             phono_curve_to_str(s_phono_curve), s_phono_rumble ? "on" : "off",
+             bank.stages, (unsigned long)s_sample_rate);
+}
+
 void EQProcessor::update_band(uint8_t band_index, const EQBandConfig& band, uint32_t sample_rate) {
     if (band_index >= EQ_MAX_BANDS) return;
 
-    s_sample_rate       = sample_rate;
-    s_bands[band_index] = band;
+    if (sample_rate != s_sample_rate) {
+        // Every stage was designed for the old rate: rebuild the whole band
+        // set through the spare bank (crossfaded), and the phono stages
+        s_sample_rate = sample_rate;
+        EQBandConfig bands[EQ_MAX_BANDS];
+        get_bands(bands);
+        bands[band_index] = band;
+        load_bank(bands, nullptr, 0);
+        load_phono_bank();
+        ESP_LOGI(TAG, "Sample rate changed to %lu Hz: all stages rebuilt", (unsigned long)sample_rate);
+        return;
+    }
 
     // Recompute coefficients — delay lines (s_w[b]) are intentionally NOT zeroed
     // to avoid audible clicks during live parameter changes.
-    recompute_band_coef(band_index);
-    s_active_bands = count_active_bands();
+    BandBank& bank = published_bank();
+    bank.bands[band_index] = band;
+    compute_band_coef(band, s_sample_rate, bank.coef[band_index]);
+    bank.active_bands = count_active_bands(bank);
+    coefs_changed();
 
     ESP_LOGI(TAG, "Band %u updated: %s %.0fHz %.1fdB Q=%.2f [%s]",
              band_index, eq_filter_type_to_str(band.filter_type),
@@ -200,25 +519,122 @@ void EQProcessor::update_band(uint8_t band_index, const EQBandConfig& band, uint
 void EQProcessor::set_enabled(bool enabled) {
     bool was_enabled = s_enabled;
     s_enabled = enabled;
+    if (enabled != was_enabled) {
+        coefs_changed();
+    }
 
     if (enabled && !was_enabled) {
         // Transitioning off→on: zero delay lines to avoid artifacts from stale state
         memset(s_w, 0, sizeof(s_w));
-        s_active_bands = count_active_bands();
-        ESP_LOGI(TAG, "EQ enabled (%u active bands)", s_active_bands);
+        ESP_LOGI(TAG, "EQ enabled (%u active bands)", published_bank().active_bands);
     } else if (!enabled && was_enabled) {
         ESP_LOGI(TAG, "EQ disabled (bypass)");
     }
 }
 
+void EQProcessor::set_phono(PhonoCurve curve, bool rumble_filter) {
+    s_phono_curve  = curve;
+    s_phono_rumble = rumble_filter;
+    load_phono_bank();
+}
+
 bool EQProcessor::is_enabled() {
     return s_enabled;
 }
 
 uint8_t EQProcessor::active_band_count() {
-    return s_active_bands;
+    return published_bank().active_bands;
 }
 
 uint32_t EQProcessor::get_sample_rate() {
     return s_sample_rate;
 }
+
+PhonoCurve EQProcessor::phono_curve() {
+    return s_phono_curve;
+}
+
+bool EQProcessor::phono_rumble_filter() {
+    return s_phono_rumble;
+}
+
+uint8_t EQProcessor::phono_stage_count() {
+    return published_phono().stages;
+}
+
+uint32_t EQProcessor::coef_generation() {
+    return s_coef_generation.load(std::memory_order_acquire);
+}
+
+uint8_t EQProcessor::copy_active_coefs(float (*out)[5], uint8_t max_stages) {
+    uint8_t n = 0;
+    const PhonoBank& phono = published_phono();
+    for (uint8_t st = 0; st < phono.stages && n < max_stages; st++) {
+        memcpy(out[n++], phono.coef[st], sizeof(phono.coef[st]));
+    }
+    const BandBank& bank = published_bank();
+    if (s_enabled && bank.active_bands > 0) {
+        for (uint8_t b = 0; b < EQ_MAX_BANDS && n < max_stages; b++) {
+            if (!bank.bands[b].enabled) continue;
+            memcpy(out[n++], bank.coef[b], sizeof(bank.coef[b]));
+        }
+    }
+    return n;
+}
+
+void EQProcessor::get_stats(EQStats *stats) {
+    if (stats == nullptr) return;
+    uint32_t total  = s_blocks_total;
+    uint32_t silent = s_blocks_silent;
+
+    stats->blocks_total       = total;
+    stats->blocks_silent      = silent;
+    stats->fast_path_pct      = total > 0 ? 100.0f * (float)silent / (float)total : 0.0f;
+    stats->fast_path_seconds  = (float)silent * (float)s_last_frames / (float)s_sample_rate;
+    stats->cycles_full_avg    = s_cycles_full_avg;
+    stats->cycles_fast_avg    = s_cycles_fast_avg;
+    stats->denormal_flushes   = s_denormal_flushes;
+    stats->silence_gain_bound = s_silence_gain;
+    stats->in_fast_path       = s_in_fast_path;
+}
+
+void EQProcessor::compute_coefs(const EQBandConfig* bands, uint32_t sample_rate, float (*out)[5]) {
+    for (uint8_t b = 0; b < EQ_MAX_BANDS; b++) {
+        compute_band_coef(bands[b], sample_rate, out[b]);
+    }
+}
+
+bool EQProcessor::load_bank(const EQBandConfig* bands, const float (*coefs)[5], uint32_t coef_sample_rate) {
+    if (bands == nullptr) return false;
+
+    // The spare bank is only free once Core 0 has acknowledged the published
+    // one (it may still be crossfading out of the spare)
+    wait_bank_ack(s_bank_published, s_bank_in_use);
+    const uint8_t spare = s_bank_published.load(std::memory_order_acquire) ^ 1;
+    BandBank& bank = s_bank[spare];
+    memcpy(bank.bands, bands, sizeof(bank.bands));
+
+    bool precomputed = coefs != nullptr && coef_sample_rate == s_sample_rate;
+    if (precomputed) {
+        memcpy(bank.coef, coefs, sizeof(bank.coef));
+    } else {
+        compute_coefs(bank.bands, s_sample_rate, bank.coef);
+    }
+    bank.active_bands = count_active_bands(bank);
+
+    s_bank_published.store(spare, std::memory_order_release);
+    coefs_changed();
+
+    ESP_LOGI(TAG, "Band bank %u loaded: %u active bands (%s coefficients)",
+             spare, bank.active_bands, precomputed ? "precomputed" : "recomputed");
+    return true;
+}
+
+void EQProcessor::get_bands(EQBandConfig* out) {
+    if (out == nullptr) return;
+    memcpy(out, published_bank().bands, sizeof(EQBandConfig) * EQ_MAX_BANDS);
+}
+
+uint32_t EQProcessor::bank_swap_count() {
+    return s_bank_swaps;
+}
@@ -17,11 +17,47 @@
 // Data flow (per DMA block):
 //   dma_buffer (uint8_t, 32-bit I²S slots) →
 //   float32 LRLR interleaved →
-//   N-stage dsps_biquad_sf32 chain →
+//   phono preset stages (0–3 fixed biquads, see phono_filters.h) →
+//   N-stage dsps_biquad_sf32 chain (user bands) →
+//   FIR correction (optional, see fir_filter.h) →
+//   automatic gain (optional, see auto_gain.h) →
+//   lookahead peak limiter (optional, see peak_limiter.h) or hard clip →
 //   24-bit packed stereo (uint8_t)
+//
+// Silent blocks (input × cascade gain bound below EQ_SILENCE_THRESHOLD, with
+// settled delay lines and an empty limiter lookahead) skip steps 2–3 and emit
+// digital zero. The threshold is one LSB of the 24-bit output, so that zero is
+// exactly what the full path would have produced: the 24-bit noise floor
+// passes untouched. Only digital silence benefits; the ADC's idle noise (lead-in,
+// run-out, a stopped platter) runs the full path. Delay-line values below
+// EQ_STATE_EPSILON are flushed to zero after every block so long decays never
+// run on denormals.
+//
+// The phono stage is independent of the EQ master switch: it keeps all 10 user
+// bands free, and costs nothing when curve = OFF and the rumble filter is off.
+// The same holds for automatic gain: it enters the float path on its own and
+// leaves it (after ramping back to unity) when disabled.
 
 static constexpr uint8_t  EQ_MAX_BANDS         = 10;
 static constexpr size_t   EQ_FRAMES_PER_BLOCK   = 240;  // DMA block = 240 stereo frames
+static constexpr float    EQ_SILENCE_THRESHOLD  = 1.0f / 8388608.0f;  // 1 LSB of the 24-bit output (≈ -138 dBFS)
+static constexpr float    EQ_STATE_EPSILON      = 1e-9f;              // Delay-line flush level (≈ -180 dB)
+// Highest band frequency as a fraction of the sample rate. Not Nyquist − 1 Hz:
+// that close to Nyquist cosf(w0) rounds to −1 and shelf/pass poles land on the
+// unit circle. 0.49·fs is still above 20 kHz at 44.1 kHz.
+static constexpr float    EQ_MAX_FREQ_RATIO     = 0.49f;
+
+struct EQStats {
+    uint32_t blocks_total;        // Blocks through the float path
+    uint32_t blocks_silent;       // Blocks served by the silent fast path
+    float    fast_path_pct;       // blocks_silent / blocks_total
+    float    fast_path_seconds;   // Audio time covered by the fast path
+    uint32_t cycles_full_avg;     // CPU cycles per full block (running average)
+    uint32_t cycles_fast_avg;     // CPU cycles per fast-path block
+    uint32_t denormal_flushes;    // Delay-line values flushed to zero
+    float    silence_gain_bound;  // Cascade L1 gain used by the silence test
+    bool     in_fast_path;
+};
 
 class EQProcessor {
 public:
@@ -35,11 +71,14 @@ public:
     //   input_i2s : uint8_t[frames * 8]  — raw I²S DMA data (32-bit slots, MSB-aligned 24-bit)
     //   output_24 : uint8_t[frames * 6]  — output 24-bit packed stereo (little-endian)
     //   frames    : stereo frame count (typically EQ_FRAMES_PER_BLOCK = 240)
-    // Returns true if EQ was applied; false if bypassed (caller uses legacy packing path).
+    // Returns true if any filtering was applied; false if both the phono stage and
+    // the EQ are bypassed (caller uses legacy packing path).
     static bool process(const uint8_t* input_i2s, uint8_t* output_24, size_t frames);
 
     // Update a single band's parameters and recompute its coefficients.
     // Delay lines are NOT reset — avoids clicks on live parameter change.
+    // A `sample_rate` different from the live one rebuilds every band (through
+    // load_bank) and the phono stages for the new rate.
     // Safe to call from Core 1 (HTTP handler).
     static void update_band(uint8_t band_index, const EQBandConfig& band, uint32_t sample_rate);
 
@@ -47,9 +86,52 @@ public:
     // On false→true: zeroes all delay lines, recomputes all active-band coefficients.
     static void set_enabled(bool enabled);
 
+    // Select the phono preset stage (de-emphasis curve + rumble filter).
+    // Loads compile-time coefficients for the current sample rate into the spare
+    // phono bank and publishes it; Core 0 zeroes the stage delay lines when it
+    // picks the bank up. Unsupported sample rates leave the stage bypassed.
+    // Safe to call from Core 1 (HTTP handler); blocks up to ~50 ms like
+    // load_bank() if the previous set has not been picked up yet.
+    static void set_phono(PhonoCurve curve, bool rumble_filter);
+
     static bool     is_enabled();
     static uint8_t  active_band_count();
     static uint32_t get_sample_rate();
+    static PhonoCurve phono_curve();
+    static bool     phono_rumble_filter();
+    static uint8_t  phono_stage_count();
+
+    // Coefficient generation counter — incremented whenever any stage's
+    // coefficients or the set of active stages changes.
+    static uint32_t coef_generation();
+
+    // Copy the coefficients of every stage process() currently runs (phono
+    // stages first, then enabled user bands) into `out`. Returns the stage count.
+    // Callers should compare coef_generation() before and after to detect a
+    // concurrent update.
+    static uint8_t  copy_active_coefs(float (*out)[5], uint8_t max_stages);
+
+    // Fast-path / denormal statistics (safe from Core 1)
+    static void     get_stats(EQStats *stats);
+
+    // Compute coefficients for a full band set at `sample_rate` without
+    // touching the live filter (used to precompute preset banks).
+    static void     compute_coefs(const EQBandConfig* bands, uint32_t sample_rate, float (*out)[5]);
+
+    // Replace all EQ_MAX_BANDS bands at once. The new set is written to the
+    // spare coefficient bank and published atomically; Core 0 crossfades from
+    // the old bank to the new one over the next DMA block, so the swap is
+    // glitch-free. `coefs` (may be nullptr) is used as-is when
+    // `coef_sample_rate` matches the live rate, otherwise coefficients are
+    // recomputed. Safe to call from Core 1; blocks up to ~50 ms if a previous
+    // swap has not been picked up by Core 0 yet.
+    static bool     load_bank(const EQBandConfig* bands, const float (*coefs)[5], uint32_t coef_sample_rate);
+
+    // Copy the live band configs (EQ_MAX_BANDS entries) into `out`.
+    static void     get_bands(EQBandConfig* out);
+
+    // Number of crossfaded bank swaps since boot (diagnostics)
+    static uint32_t bank_swap_count();
 };
 
 #endif // EQ_PROCESSOR_H
@@ -0,0 +1,190 @@
+#include "eq_response.h"
+#include "eq_processor.h"
+#include "phono_filters.h"
+#include "dsp_platform.h"
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "eq_response";
+
+static constexpr uint8_t MAX_STAGES      = PHONO_MAX_STAGES + EQ_MAX_BANDS;
+static constexpr float   GRID_MIN_HZ     = 20.0f;
+static constexpr float   GRID_MAX_HZ     = 20000.0f;
+static constexpr float   MAG_FLOOR_DB    = -120.0f;
+static constexpr int     SNAPSHOT_RETRIES = 3;
+
+// ─── Workspace (PSRAM, allocated on first request) ───────────────────────────
+// Structure-of-arrays layout: each stage is evaluated over the whole grid in
+// one branch-free pass, and the per-stage results are folded into the running
+// product/sum with the esp-dsp vector kernels (ae32/aes3 optimized).
+
+enum WorkArray {
+    W_FREQ, W_COS1, W_SIN1, W_COS2, W_SIN2,   // Grid (depends on points + rate)
+    W_MAG2, W_PHASE,                          // Cascade accumulators
+    W_STAGE_MAG2, W_STAGE_PHASE,              // Per-stage scratch
+    W_COUNT
+};
+
+static float   *s_work[W_COUNT] = {};
+static float    s_coefs[MAX_STAGES][5];
+
+// Cache keys
+static uint16_t s_grid_points   = 0;
+static uint32_t s_grid_rate     = 0;
+static uint16_t s_cached_points = 0;
+static uint32_t s_cached_rate   = 0;
+static uint32_t s_cached_gen    = 0;
+static uint8_t  s_cached_stages = 0;
+static bool     s_cache_valid   = false;
+
+static uint32_t s_cache_hits  = 0;
+static uint32_t s_evaluations = 0;
+
+static bool ensure_workspace() {
+    if (s_work[0] != nullptr) return true;
+
+    const size_t bytes = EQ_RESPONSE_MAX_POINTS * sizeof(float);
+    for (int i = 0; i < W_COUNT; i++) {
+        s_work[i] = (float *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        if (s_work[i] == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate response workspace");
+            for (int j = 0; j < i; j++) {
+                heap_caps_free(s_work[j]);
+                s_work[j] = nullptr;
+            }
+            return false;
+        }
+    }
+    ESP_LOGI(TAG, "Response workspace allocated: %u bytes in PSRAM",
+             (unsigned)(bytes * W_COUNT));
+    return true;
+}
+
+// Log-spaced grid and the e^-jω / e^-j2ω terms shared by every stage
+static void build_grid(uint16_t points, uint32_t sample_rate) {
+    float *freq = s_work[W_FREQ];
+    float f_max = (float)sample_rate * 0.5f * 0.999f;
+    if (f_max > GRID_MAX_HZ) f_max = GRID_MAX_HZ;
+    const float ratio = logf(f_max / GRID_MIN_HZ) / (float)(points - 1);
+    const float w_per_hz = 2.0f * (float)M_PI / (float)sample_rate;
+
+    for (uint16_t i = 0; i < points; i++) {
+        freq[i] = GRID_MIN_HZ * expf(ratio * (float)i);
+        float w = freq[i] * w_per_hz;
+        s_work[W_COS1][i] = cosf(w);
+        s_work[W_SIN1][i] = sinf(w);
+        s_work[W_COS2][i] = cosf(2.0f * w);
+        s_work[W_SIN2][i] = sinf(2.0f * w);
+    }
+    s_grid_points = points;
+    s_grid_rate   = sample_rate;
+}
+
+// |H|² and arg H of one biquad over the whole grid
+static void eval_stage(const float *c, uint16_t points) {
+    const float *c1 = s_work[W_COS1];
+    const float *s1 = s_work[W_SIN1];
+    const float *c2 = s_work[W_COS2];
+    const float *s2 = s_work[W_SIN2];
+    float *mag2  = s_work[W_STAGE_MAG2];
+    float *phase = s_work[W_STAGE_PHASE];
+
+    const float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+    for (uint16_t i = 0; i < points; i++) {
+        float nr = b0 + b1 * c1[i] + b2 * c2[i];
+        float ni = -(b1 * s1[i] + b2 * s2[i]);
+        float dr = 1.0f + a1 * c1[i] + a2 * c2[i];
+        float di = -(a1 * s1[i] + a2 * s2[i]);
+        mag2[i]  = (nr * nr + ni * ni) / (dr * dr + di * di + 1e-30f);
+        phase[i] = atan2f(ni, nr) - atan2f(di, dr);
+    }
+}
+
+static void evaluate(uint16_t points, uint8_t stages) {
+    float *mag2  = s_work[W_MAG2];
+    float *phase = s_work[W_PHASE];
+
+    for (uint16_t i = 0; i < points; i++) {
+        mag2[i]  = 1.0f;
+        phase[i] = 0.0f;
+    }
+
+    for (uint8_t st = 0; st < stages; st++) {
+        eval_stage(s_coefs[st], points);
+        dsps_mul_f32(mag2, s_work[W_STAGE_MAG2], mag2, points, 1, 1, 1);
+        dsps_add_f32(phase, s_work[W_STAGE_PHASE], phase, points, 1, 1, 1);
+    }
+
+    // Convert in place: |H|² → dB, radians → degrees wrapped to (-180, 180]
+    const float rad_to_deg = 180.0f / (float)M_PI;
+    for (uint16_t i = 0; i < points; i++) {
+        float db = 10.0f * log10f(mag2[i] + 1e-12f);
+        mag2[i] = db < MAG_FLOOR_DB ? MAG_FLOOR_DB : db;
+
+        float p = fmodf(phase[i], 2.0f * (float)M_PI);
+        if (p >  (float)M_PI) p -= 2.0f * (float)M_PI;
+        if (p <= -(float)M_PI) p += 2.0f * (float)M_PI;
+        phase[i] = p * rad_to_deg;
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool EQResponse::get(uint16_t points, EQResponseView *view) {
+    if (view == nullptr) return false;
+    if (points < EQ_RESPONSE_MIN_POINTS) points = EQ_RESPONSE_MIN_POINTS;
+    if (points > EQ_RESPONSE_MAX_POINTS) points = EQ_RESPONSE_MAX_POINTS;
+
+    if (!ensure_workspace()) return false;
+
+    uint32_t rate = EQProcessor::get_sample_rate();
+    uint32_t gen  = EQProcessor::coef_generation();
+
+    bool hit = s_cache_valid && s_cached_gen == gen &&
+               s_cached_points == points && s_cached_rate == rate;
+
+    if (hit) {
+        s_cache_hits++;
+    } else {
+        // Snapshot coefficients; retry if Core 1 changed them mid-copy
+        uint8_t stages = 0;
+        for (int attempt = 0; attempt < SNAPSHOT_RETRIES; attempt++) {
+            gen    = EQProcessor::coef_generation();
+            stages = EQProcessor::copy_active_coefs(s_coefs, MAX_STAGES);
+            if (EQProcessor::coef_generation() == gen) break;
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        if (s_grid_points != points || s_grid_rate != rate) {
+            build_grid(points, rate);
+        }
+        evaluate(points, stages);
+
+        s_cached_points = points;
+        s_cached_rate   = rate;
+        s_cached_gen    = gen;
+        s_cached_stages = stages;
+        s_cache_valid   = true;
+        s_evaluations++;
+
+        ESP_LOGD(TAG, "Evaluated %u stages x %u points in %lld us",
+                 stages, points, (long long)(esp_timer_get_time() - t0));
+    }
+
+    view->points       = s_cached_points;
+    view->sample_rate  = s_cached_rate;
+    view->generation   = s_cached_gen;
+    view->stages       = s_cached_stages;
+    view->freq_hz      = s_work[W_FREQ];
+    view->magnitude_db = s_work[W_MAG2];
+    view->phase_deg    = s_work[W_PHASE];
+    return true;
+}
+
+uint32_t EQResponse::get_cache_hits() {
+    return s_cache_hits;
+}
+
+uint32_t EQResponse::get_evaluations() {
+    return s_evaluations;
+}
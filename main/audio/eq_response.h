@@ -0,0 +1,44 @@
+#ifndef EQ_RESPONSE_H
+#define EQ_RESPONSE_H
+
+#include <cstdint>
+#include <cstddef>
+
+// EQResponse: combined frequency response of the live biquad cascade.
+//
+// Evaluates |H(e^jω)| (dB) and arg H(e^jω) (degrees) of every stage
+// EQProcessor currently runs — phono preset stages and enabled user bands —
+// on a log-spaced grid from 20 Hz to min(20 kHz, Nyquist).
+//
+// Results are cached and only recomputed when EQProcessor::coef_generation(),
+// the sample rate, or the requested point count changes. Called from the HTTP
+// server task only (Core 1); not used in the audio path.
+
+static constexpr uint16_t EQ_RESPONSE_MIN_POINTS     = 16;
+static constexpr uint16_t EQ_RESPONSE_MAX_POINTS     = 512;
+static constexpr uint16_t EQ_RESPONSE_DEFAULT_POINTS = 128;
+
+struct EQResponseView {
+    uint16_t     points;
+    uint32_t     sample_rate;
+    uint32_t     generation;     // EQProcessor::coef_generation() at evaluation
+    uint8_t      stages;         // Number of biquads in the evaluated cascade
+    const float *freq_hz;        // [points]
+    const float *magnitude_db;   // [points]
+    const float *phase_deg;      // [points], wrapped to (-180, 180]
+};
+
+class EQResponse {
+public:
+    // Fill `view` with the response for `points` grid points (clamped to
+    // [EQ_RESPONSE_MIN_POINTS, EQ_RESPONSE_MAX_POINTS]).
+    // Pointers stay valid until the next get() call.
+    // Returns false if the PSRAM workspace could not be allocated.
+    static bool get(uint16_t points, EQResponseView *view);
+
+    // Number of cache hits / recomputations since boot (diagnostics)
+    static uint32_t get_cache_hits();
+    static uint32_t get_evaluations();
+};
+
+#endif // EQ_RESPONSE_H
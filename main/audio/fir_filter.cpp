@@ -0,0 +1,420 @@
+#include "fir_filter.h"
+#include "dsp_platform.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "fir_filter";
+
+static constexpr size_t N    = FIR_FFT_SIZE;
+static constexpr size_t B    = FIR_PARTITION;
+static constexpr size_t BINS = FIR_FFT_SIZE / 2 + 1;   // Half spectrum, DC..Nyquist
+static constexpr size_t SPEC = BINS * 2;               // Floats per half spectrum (re, im)
+static_assert(2 * B - 1 <= N, "overlap-save needs FFT size >= 2 * partition - 1");
+static_assert((N & (N - 1)) == 0, "radix-2 FFT size");
+
+static constexpr uint32_t STOP_TIMEOUT_MS = 100;
+
+// ─── State ───────────────────────────────────────────────────────────────────
+// Spectra are heap-allocated at load time, in PSRAM: a 4096-tap IR needs
+// ~150 KB, which would eat the internal RAM that WiFi/lwIP rely on
+// (SPIRAM_MALLOC_RESERVE_INTERNAL). Internal RAM is used only on boards
+// without PSRAM. Layout per partition / FDL slot: [L half spectrum][R half spectrum].
+
+static float   *s_h        = nullptr;  // [partitions][2][SPEC] — IR spectra, scaled 1/N
+static float   *s_fdl      = nullptr;  // [partitions + 1][2][SPEC] — input spectra history
+static uint16_t s_partitions = 0;
+static uint16_t s_fdl_slots  = 0;
+static uint16_t s_taps       = 0;
+static uint8_t  s_channels   = 0;
+static uint32_t s_ir_rate    = 0;
+static uint32_t s_memory     = 0;
+static bool     s_in_psram   = false;
+
+static DRAM_ATTR float s_window[N * 2];         // Last N frames LRLR = complex re:L im:R
+static DRAM_ATTR float s_work[N * 2];           // FFT workspace
+static DRAM_ATTR float s_tail[2][2][SPEC];      // Double-buffered tail sums {A (L), B (R)}
+static DRAM_ATTR float s_tail_zero[2][SPEC];
+
+static uint32_t s_sample_rate = 48000;
+static bool     s_enabled     = false;
+static bool     s_loaded      = false;
+
+static std::atomic<bool>     s_active{false};
+static std::atomic<bool>     s_head_busy{false};
+static std::atomic<bool>     s_tail_busy{false};
+static std::atomic<uint32_t> s_seq{0};          // Next block to be produced
+static std::atomic<uint32_t> s_tail_ready{0};   // Block whose tail is in s_tail
+
+static TaskHandle_t s_tail_task = nullptr;
+
+// Metrics (written by Core 0, read by Core 1)
+static volatile uint32_t s_head_cycles_avg = 0;
+static volatile uint32_t s_head_cycles_max = 0;
+static volatile uint32_t s_tail_cycles_avg = 0;
+static volatile uint32_t s_tail_cycles_max = 0;
+static volatile uint32_t s_blocks          = 0;
+static volatile uint32_t s_misses          = 0;
+static volatile uint32_t s_dropped         = 0;
+static volatile uint32_t s_skipped         = 0;
+
+// ─── Helpers ─────────────────────────────────────────────────────────────────
+
+static inline uint32_t cycles_ema(uint32_t avg, uint32_t sample) {
+    return avg == 0 ? sample : avg - (avg >> 4) + (sample >> 4);
+}
+
+static inline float *h_spec(uint16_t p, int ch)   { return s_h + ((size_t)p * 2 + ch) * SPEC; }
+// Input spectrum of block `blk - back` (back < s_fdl_slots). Slots that were
+// never written are zero, so early blocks see silence before the first input.
+static inline float *fdl_spec(uint32_t blk, uint16_t back, int ch) {
+    uint32_t slot = (blk % s_fdl_slots + s_fdl_slots - back) % s_fdl_slots;
+    return s_fdl + ((size_t)slot * 2 + ch) * SPEC;
+}
+
+static inline void fft(float *data) {
+    dsps_fft2r_fc32(data, (int)N);
+    dsps_bit_rev_fc32(data, (int)N);
+}
+
+// Separate Z = FFT(a + jb) of two real signals into half spectra A and B:
+//   A[k] = (Z[k] + Z*[N-k]) / 2,  B[k] = (Z[k] − Z*[N-k]) / 2j
+static void split_spectrum(const float *z, float *a, float *b) {
+    for (size_t k = 0; k < BINS; k++) {
+        size_t m = (N - k) & (N - 1);
+        float zr = z[k * 2], zi = z[k * 2 + 1];
+        float wr = z[m * 2], wi = z[m * 2 + 1];
+        a[k * 2]     = 0.5f * (zr + wr);
+        a[k * 2 + 1] = 0.5f * (zi - wi);
+        b[k * 2]     = 0.5f * (zi + wi);
+        b[k * 2 + 1] = 0.5f * (wr - zr);
+    }
+}
+
+// acc += x · h over the half spectrum (complex multiply-accumulate)
+static inline void cmac(float *acc, const float *x, const float *h) {
+    for (size_t k = 0; k < BINS; k++) {
+        float xr = x[k * 2], xi = x[k * 2 + 1];
+        float hr = h[k * 2], hi = h[k * 2 + 1];
+        acc[k * 2]     += xr * hr - xi * hi;
+        acc[k * 2 + 1] += xr * hi + xi * hr;
+    }
+}
+
+// Tail sums for block `blk`: Σ_{p≥1} X_{blk-p} · H_p, per channel
+static void compute_tail(uint32_t blk) {
+    float (*out)[SPEC] = s_tail[blk & 1];
+    memset(out, 0, sizeof(s_tail[0]));
+    for (uint16_t p = 1; p < s_partitions; p++) {
+        cmac(out[0], fdl_spec(blk, p, 0), h_spec(p, 0));
+        cmac(out[1], fdl_spec(blk, p, 1), h_spec(p, 1));
+    }
+    s_tail_ready.store(blk, std::memory_order_release);
+}
+
+static void fir_tail_task(void *) {
+    ESP_LOGI(TAG, "fir_tail task started on Core %d", xPortGetCoreID());
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        s_tail_busy.store(true);
+        if (s_active.load()) {
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            compute_tail(s_seq.load(std::memory_order_acquire));
+            uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+            if (cycles > s_tail_cycles_max) s_tail_cycles_max = cycles;
+            s_tail_cycles_avg = cycles_ema(s_tail_cycles_avg, cycles);
+        }
+        s_tail_busy.store(false);
+    }
+}
+
+static void reset_state() {
+    memset(s_window, 0, sizeof(s_window));
+    memset(s_tail, 0, sizeof(s_tail));
+    if (s_fdl) memset(s_fdl, 0, (size_t)s_fdl_slots * 2 * SPEC * sizeof(float));
+    s_seq.store(0);
+    s_tail_ready.store(0);
+}
+
+static void update_active() {
+    bool active = s_enabled && s_loaded && s_ir_rate == s_sample_rate;
+    if (active && !s_active.load()) reset_state();
+    s_active.store(active);
+}
+
+// Pause the stage and wait until neither Core 0 path is inside it
+static void stop_and_wait() {
+    s_active.store(false);
+    uint32_t waited_ms = 0;
+    while ((s_head_busy.load() || s_tail_busy.load()) && waited_ms < STOP_TIMEOUT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+        waited_ms++;
+    }
+}
+
+// PSRAM first; `psram` is cleared if either buffer fell back to internal RAM
+static float *alloc_spectra(size_t bytes, bool *psram) {
+    float *p = (float *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (p == nullptr) {
+        p = (float *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL);
+        if (p != nullptr) *psram = false;
+    }
+    return p;
+}
+
+static void free_spectra() {
+    if (s_h)   heap_caps_free(s_h);
+    if (s_fdl) heap_caps_free(s_fdl);
+    s_h = nullptr;
+    s_fdl = nullptr;
+    s_partitions = 0;
+    s_fdl_slots  = 0;
+    s_memory     = 0;
+    s_in_psram   = false;
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool FIRFilter::init(uint32_t sample_rate) {
+    s_sample_rate = sample_rate;
+
+    // Shared radix-2 twiddle table, sized for the largest FFT any module uses
+    esp_err_t err = dsps_fft2r_init_fc32(nullptr, CONFIG_DSP_MAX_FFT_SIZE);
+    if (err != ESP_OK && err != ESP_ERR_DSP_REINITIALIZED) {
+        ESP_LOGE(TAG, "FFT init failed: %d", err);
+        return false;
+    }
+
+    if (s_tail_task == nullptr) {
+        BaseType_t result = xTaskCreatePinnedToCore(
+            fir_tail_task,
+            "fir_tail",
+            3072,
+            nullptr,
+            20,  // Below audio_capture (24): capture always preempts
+            &s_tail_task,
+            0    // Core 0 (DSP core)
+        );
+        if (result != pdPASS) {
+            // Fall back to computing the tail inline after each block
+            s_tail_task = nullptr;
+            ESP_LOGW(TAG, "fir_tail task not created, tail runs inline");
+        }
+    }
+
+    ESP_LOGI(TAG, "FIR stage ready: partition=%u frames, FFT=%u, max %lu taps",
+             (unsigned)B, (unsigned)N, (unsigned long)FIR_MAX_TAPS);
+    return true;
+}
+
+bool FIRFilter::load(const float *ir, uint32_t taps, uint8_t channels, uint32_t ir_sample_rate) {
+    if (ir == nullptr || taps == 0 || taps > FIR_MAX_TAPS || (channels != 1 && channels != 2)) {
+        return false;
+    }
+
+    stop_and_wait();
+    free_spectra();
+    s_loaded = false;
+
+    uint16_t partitions = (uint16_t)((taps + B - 1) / B);
+    size_t h_bytes   = (size_t)partitions * 2 * SPEC * sizeof(float);
+    size_t fdl_bytes = (size_t)(partitions + 1) * 2 * SPEC * sizeof(float);
+    bool psram = true;
+    s_h   = alloc_spectra(h_bytes, &psram);
+    s_fdl = alloc_spectra(fdl_bytes, &psram);
+    if (s_h == nullptr || s_fdl == nullptr) {
+        ESP_LOGE(TAG, "Out of memory for %u partitions (%u bytes)",
+                 partitions, (unsigned)(h_bytes + fdl_bytes));
+        free_spectra();
+        update_active();
+        return false;
+    }
+    s_partitions = partitions;
+    s_fdl_slots  = partitions + 1;  // One spare so a late tail never reads the slot being written
+    s_memory     = (uint32_t)(h_bytes + fdl_bytes);
+    s_in_psram   = psram;
+
+    // Partition spectra: L taps in re, R taps in im, zero-padded to N. The
+    // inverse FFT's 1/N is folded in here.
+    const float scale = 1.0f / (float)N;
+    int64_t t0 = esp_timer_get_time();
+    for (uint16_t p = 0; p < partitions; p++) {
+        memset(s_work, 0, sizeof(s_work));
+        for (size_t i = 0; i < B; i++) {
+            size_t t = (size_t)p * B + i;
+            if (t >= taps) break;
+            s_work[i * 2]     = ir[t * channels] * scale;
+            s_work[i * 2 + 1] = ir[t * channels + channels - 1] * scale;
+        }
+        fft(s_work);
+        split_spectrum(s_work, h_spec(p, 0), h_spec(p, 1));
+    }
+
+    s_taps     = (uint16_t)taps;
+    s_channels = channels;
+    s_ir_rate  = ir_sample_rate;
+    s_loaded   = true;
+    s_head_cycles_avg = s_head_cycles_max = 0;
+    s_tail_cycles_avg = s_tail_cycles_max = 0;
+    s_misses = 0;
+    s_dropped = 0;
+    update_active();
+
+    ESP_LOGI(TAG, "IR loaded: %lu taps x %u ch @ %lu Hz, %u partitions, %lu bytes %s (%lld us)",
+             (unsigned long)taps, channels, (unsigned long)ir_sample_rate, partitions,
+             (unsigned long)s_memory, psram ? "PSRAM" : "internal",
+             (long long)(esp_timer_get_time() - t0));
+    if (ir_sample_rate != s_sample_rate) {
+        ESP_LOGW(TAG, "IR rate %lu Hz != stream rate %lu Hz, stage stays bypassed",
+                 (unsigned long)ir_sample_rate, (unsigned long)s_sample_rate);
+    }
+    return true;
+}
+
+void FIRFilter::unload() {
+    stop_and_wait();
+    free_spectra();
+    s_loaded   = false;
+    s_taps     = 0;
+    s_channels = 0;
+    s_ir_rate  = 0;
+    ESP_LOGI(TAG, "IR unloaded");
+}
+
+void FIRFilter::set_enabled(bool enabled) {
+    s_enabled = enabled;
+    update_active();
+    ESP_LOGI(TAG, "FIR stage %s%s", enabled ? "enabled" : "disabled",
+             enabled && !s_active.load() ? " (no IR for this sample rate)" : "");
+}
+
+bool FIRFilter::is_active() {
+    return s_active.load(std::memory_order_acquire);
+}
+
+void FIRFilter::process(float *lrlr, size_t frames) {
+    s_head_busy.store(true);
+    if (!s_active.load()) {
+        s_head_busy.store(false);
+        return;
+    }
+    if (frames != B) {
+        // Partial DMA read: the partition grid cannot shift by a fraction of a block
+        s_skipped = s_skipped + 1;
+        s_head_busy.store(false);
+        return;
+    }
+
+    uint32_t t0  = esp_cpu_get_cycle_count();
+    uint32_t blk = s_seq.load(std::memory_order_relaxed);
+
+    // Slide the time window by one block and transform it
+    memmove(s_window, s_window + B * 2, (N - B) * 2 * sizeof(float));
+    memcpy(s_window + (N - B) * 2, lrlr, B * 2 * sizeof(float));
+    memcpy(s_work, s_window, sizeof(s_work));
+    fft(s_work);
+    float *xl = fdl_spec(blk, 0, 0);
+    float *xr = fdl_spec(blk, 0, 1);
+    split_spectrum(s_work, xl, xr);
+
+    // Head partition plus the tail precomputed during the previous block.
+    // A late tail is not dropped (an audible dropout of everything past the
+    // first partition): the previous block's tail is held instead. Its buffer
+    // is complete and idle only once fir_tail has finished block blk − 1;
+    // from then on fir_tail writes only the other buffer.
+    const float (*tail)[SPEC] = s_tail_zero;
+    if (s_partitions > 1) {
+        uint32_t ready = s_tail_ready.load(std::memory_order_acquire);
+        if (ready == blk) {
+            tail = s_tail[blk & 1];
+        } else if (blk != 0) {
+            s_misses = s_misses + 1;
+            if (ready == blk - 1) {
+                tail = s_tail[(blk - 1) & 1];
+            } else {
+                s_dropped = s_dropped + 1;
+            }
+        }
+    }
+    const float *hl = h_spec(0, 0);
+    const float *hr = h_spec(0, 1);
+
+    // Y = A + jB over the full spectrum, with A = Σ X_L·H_L and B = Σ X_R·H_R
+    // (A and B are spectra of real signals, so bins above N/2 are conjugates).
+    // The inverse FFT is computed as conj(FFT(conj(Y))), so s_work holds conj(Y).
+    for (size_t k = 0; k < BINS; k++) {
+        float ar = tail[0][k * 2]     + xl[k * 2] * hl[k * 2]     - xl[k * 2 + 1] * hl[k * 2 + 1];
+        float ai = tail[0][k * 2 + 1] + xl[k * 2] * hl[k * 2 + 1] + xl[k * 2 + 1] * hl[k * 2];
+        float br = tail[1][k * 2]     + xr[k * 2] * hr[k * 2]     - xr[k * 2 + 1] * hr[k * 2 + 1];
+        float bi = tail[1][k * 2 + 1] + xr[k * 2] * hr[k * 2 + 1] + xr[k * 2 + 1] * hr[k * 2];
+        s_work[k * 2]     =   ar - bi;
+        s_work[k * 2 + 1] = -(ai + br);
+        if (k != 0 && k != N / 2) {
+            size_t m = N - k;
+            s_work[m * 2]     =   ar + bi;
+            s_work[m * 2 + 1] = -(br - ai);
+        }
+    }
+    fft(s_work);
+
+    // Overlap-save: the last B samples are the valid linear convolution
+    const float *y = s_work + (N - B) * 2;
+    for (size_t i = 0; i < B; i++) {
+        lrlr[i * 2]     =  y[i * 2];
+        lrlr[i * 2 + 1] = -y[i * 2 + 1];
+    }
+
+    // Block counter wraps at an even multiple of the FDL size so slot and
+    // tail-buffer indices stay continuous
+    uint32_t next = blk + 1;
+    if (next == (uint32_t)s_fdl_slots * 65536u) next = 0;
+    s_seq.store(next, std::memory_order_release);
+    s_blocks = s_blocks + 1;
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+    if (cycles > s_head_cycles_max) s_head_cycles_max = cycles;
+    s_head_cycles_avg = cycles_ema(s_head_cycles_avg, cycles);
+    s_head_busy.store(false);
+
+    // Tail for the next block: hand off to fir_tail, or run it here
+    if (s_partitions > 1) {
+        if (s_tail_task != nullptr) {
+            xTaskNotifyGive(s_tail_task);
+        } else {
+            uint32_t t1 = esp_cpu_get_cycle_count();
+            compute_tail(next);
+            uint32_t tail_cycles = esp_cpu_get_cycle_count() - t1;
+            if (tail_cycles > s_tail_cycles_max) s_tail_cycles_max = tail_cycles;
+            s_tail_cycles_avg = cycles_ema(s_tail_cycles_avg, tail_cycles);
+        }
+    }
+}
+
+void FIRFilter::get_stats(FIRStats *stats) {
+    if (stats == nullptr) return;
+
+    // One DMA block period in CPU cycles = frames / fs · f_cpu
+    float block_cycles = (float)B / (float)s_sample_rate *
+                         (float)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e6f;
+
+    stats->loaded          = s_loaded;
+    stats->enabled         = s_enabled;
+    stats->active          = s_active.load();
+    stats->taps            = s_taps;
+    stats->channels        = s_channels;
+    stats->partitions      = s_partitions;
+    stats->ir_sample_rate  = s_ir_rate;
+    stats->in_psram        = s_in_psram;
+    stats->memory_bytes    = s_memory;
+    stats->head_cycles_avg = s_head_cycles_avg;
+    stats->head_cycles_max = s_head_cycles_max;
+    stats->tail_cycles_avg = s_tail_cycles_avg;
+    stats->tail_cycles_max = s_tail_cycles_max;
+    stats->head_budget_pct = block_cycles > 0.0f ? 100.0f * (float)s_head_cycles_avg / block_cycles : 0.0f;
+    stats->tail_budget_pct = block_cycles > 0.0f ? 100.0f * (float)s_tail_cycles_avg / block_cycles : 0.0f;
+    stats->blocks          = s_blocks;
+    stats->deadline_misses = s_misses;
+    stats->tails_dropped   = s_dropped;
+    stats->skipped_blocks  = s_skipped;
+}
@@ -0,0 +1,81 @@
+#ifndef FIR_FILTER_H
+#define FIR_FILTER_H
+
+#include "eq_processor.h"
+#include <cstdint>
+#include <cstddef>
+
+// FIRFilter: optional FIR stage (room / cartridge correction) for the EQ
+// float path, using uniformly partitioned overlap-save FFT convolution.
+//
+// The impulse response is split into P partitions of FIR_PARTITION taps — one
+// DMA block — and each partition is kept as a precomputed spectrum. Every
+// block the input window is transformed once and the output is
+//
+//   Y_n = X_n · H_0  +  Σ_{p=1..P-1} X_{n-p} · H_p
+//         └─ head ─┘    └──────── tail ────────┘
+//
+// The head needs the current block and runs inline on Core 0 inside
+// EQProcessor::process(). The tail only needs earlier blocks, so the
+// "fir_tail" task (Core 0, below the capture task's priority) computes it
+// during the previous block period. Capture never waits on it: when a tail is
+// not ready in time the previous block's tail is reused for that block (a
+// 5 ms smear of the tail rather than a dropout) and counted as a deadline miss.
+// Inline cost is therefore constant (two FFTs + one partition) regardless of
+// tap count, and the stage adds no latency beyond the IR itself.
+//
+// L and R are packed into one complex FFT (re = L, im = R) and separated in
+// the frequency domain, so a stereo IR costs the same FFTs as a mono one.
+
+static constexpr size_t   FIR_PARTITION = EQ_FRAMES_PER_BLOCK;  // Hop = DMA block
+static constexpr size_t   FIR_FFT_SIZE  = 512;                  // ≥ 2·partition − 1
+static constexpr uint32_t FIR_MAX_TAPS  = 4096;                 // Per channel
+
+struct FIRStats {
+    bool     loaded;
+    bool     enabled;              // User switch
+    bool     active;               // Loaded, enabled and sample rate matches
+    uint16_t taps;
+    uint8_t  channels;             // 1 = same IR on L/R, 2 = per-channel IR
+    uint16_t partitions;
+    uint32_t ir_sample_rate;
+    bool     in_psram;             // Spectra in PSRAM (false only without PSRAM)
+    uint32_t memory_bytes;
+    uint32_t head_cycles_avg;      // Inline (capture task) cycles per block
+    uint32_t head_cycles_max;
+    uint32_t tail_cycles_avg;      // fir_tail task cycles per block
+    uint32_t tail_cycles_max;
+    float    head_budget_pct;      // As % of one DMA block period
+    float    tail_budget_pct;
+    uint32_t blocks;
+    uint32_t deadline_misses;      // Tail not ready when its block arrived (previous tail held)
+    uint32_t tails_dropped;        // Misses with no complete previous tail to hold
+    uint32_t skipped_blocks;       // Partial DMA reads passed through
+};
+
+class FIRFilter {
+public:
+    // Initialize FFT tables and start the fir_tail task. Call once at startup.
+    static bool init(uint32_t sample_rate);
+
+    // Build the partition spectra from `ir` (float32, `channels` interleaved,
+    // `taps` frames) recorded at `ir_sample_rate`. Replaces any loaded IR; the
+    // stage is paused for the duration (Core 1, not realtime).
+    static bool load(const float *ir, uint32_t taps, uint8_t channels, uint32_t ir_sample_rate);
+
+    // Drop the loaded IR and free its spectra
+    static void unload();
+
+    // User switch; the stage runs only when an IR for the live rate is loaded
+    static void set_enabled(bool enabled);
+
+    static bool is_active();
+
+    // Convolve `frames` stereo frames in place (Core 0 only).
+    // Blocks other than FIR_PARTITION frames are passed through unchanged.
+    static void process(float *lrlr, size_t frames);
+
+    static void get_stats(FIRStats *stats);
+};
+
+#endif // FIR_FILTER_H
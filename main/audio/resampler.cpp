@@ -0,0 +1,89 @@
+#include "resampler.h"
+#include "resampler_tables.h"
+#include "dsp_platform.h"
+#include <cstring>
+
+static const char *TAG = "resampler";
+
+static size_t history_stride(const resample::RatioTable *table) {
+    return table->taps - 1 + RESAMPLER_MAX_FRAMES;
+}
+
+bool Resampler::supported(uint32_t in_rate, uint32_t out_rate) {
+    return resample::table_for(in_rate, out_rate) != nullptr;
+}
+
+bool Resampler::init(uint32_t in_rate, uint32_t out_rate) {
+    table   = resample::table_for(in_rate, out_rate);
+    history = nullptr;
+    if (table == nullptr) return false;
+
+    // Internal RAM first: every output reads K history samples per channel
+    const size_t bytes = 2 * history_stride(table) * sizeof(float);
+    history = (float *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL);
+    if (history == nullptr) history = (float *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (history == nullptr) {
+        ESP_LOGE(TAG, "No memory for %u byte resampler history", (unsigned)bytes);
+        table = nullptr;
+        return false;
+    }
+    reset();
+
+    ESP_LOGI(TAG, "%lu -> %lu Hz: L=%u M=%u, %u taps per phase",
+             (unsigned long)in_rate, (unsigned long)out_rate,
+             table->up, table->down, table->taps);
+    return true;
+}
+
+void Resampler::deinit() {
+    if (history != nullptr) heap_caps_free(history);
+    history = nullptr;
+    table   = nullptr;
+}
+
+void Resampler::reset() {
+    if (table == nullptr || history == nullptr) return;
+    memset(history, 0, 2 * history_stride(table) * sizeof(float));
+    t = (uint32_t)(table->taps - 1) * table->up;    // First output on the first new sample
+}
+
+size_t Resampler::max_output(size_t frames) const {
+    if (table == nullptr) return frames;
+    return frames * table->up / table->down + 1;
+}
+
+size_t Resampler::process(const float *in_lrlr, size_t frames, float *out_lrlr) {
+    if (table == nullptr || history == nullptr) return 0;
+    if (frames > RESAMPLER_MAX_FRAMES) frames = RESAMPLER_MAX_FRAMES;
+
+    const uint32_t K = table->taps;
+    const uint32_t L = table->up;
+    const uint32_t M = table->down;
+    const size_t stride = history_stride(table);
+    float *hist_l = history;
+    float *hist_r = history + stride;
+
+    for (size_t i = 0; i < frames; i++) {
+        hist_l[K - 1 + i] = in_lrlr[i * 2 + 0];
+        hist_r[K - 1 + i] = in_lrlr[i * 2 + 1];
+    }
+
+    // Outputs whose newest input sample i is already in history
+    size_t n = 0;
+    const uint32_t end = (uint32_t)(K - 1 + frames) * L;
+    while (t < end) {
+        uint32_t i = t / L;
+        uint32_t p = t - i * L;
+        const float *coeffs = table->coeffs + p * K;
+        dsps_dotprod_f32(coeffs, hist_l + i - (K - 1), &out_lrlr[n * 2 + 0], (int)K);
+        dsps_dotprod_f32(coeffs, hist_r + i - (K - 1), &out_lrlr[n * 2 + 1], (int)K);
+        n++;
+        t += M;
+    }
+
+    // Keep the newest K − 1 samples as history for the next block
+    t -= (uint32_t)frames * L;
+    memmove(hist_l, hist_l + frames, (K - 1) * sizeof(float));
+    memmove(hist_r, hist_r + frames, (K - 1) * sizeof(float));
+    return n;
+}
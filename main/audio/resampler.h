@@ -0,0 +1,51 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Resampler: polyphase sample-rate converter for stream output rates.
+//
+// Output n of fs_in → fs_in · L / M sits at t = n·M, counted in 1/L input
+// samples. With i = ⌊t / L⌋ and p = t mod L,
+//
+//   y[n] = Σ_k h[p + k·L] · x[i − k],   k = 0 … K−1
+//
+// so only the outputs are computed: one K-tap dot product (dsps_dotprod_f32)
+// per output sample and channel against row p of a compile-time table (see
+// resampler_tables.h). Cost is K multiply-adds per output sample and channel,
+// independent of L and M.
+//
+// Input is interleaved float stereo in blocks of at most RESAMPLER_MAX_FRAMES.
+// Each block is de-interleaved behind the last K − 1 samples of the previous
+// one, so a dot product never wraps. Group delay is about K / 2 input samples
+// (0.7 ms at 48 kHz).
+
+static constexpr size_t RESAMPLER_MAX_FRAMES = 256;
+
+namespace resample { struct RatioTable; }
+
+struct Resampler {
+    const resample::RatioTable *table;
+    float   *history;       // Planar L then R, taps − 1 + RESAMPLER_MAX_FRAMES each
+    uint32_t t;             // Next output, in 1/L input samples from history[0]
+
+    // True if in_rate → out_rate has a table (equal rates need no resampler)
+    static bool supported(uint32_t in_rate, uint32_t out_rate);
+
+    // Select the table and allocate history. False if unsupported or no memory.
+    bool init(uint32_t in_rate, uint32_t out_rate);
+    void deinit();
+
+    // Clear history and restart the phase
+    void reset();
+
+    // Most output frames `frames` input frames can produce
+    size_t max_output(size_t frames) const;
+
+    // Convert `frames` (≤ RESAMPLER_MAX_FRAMES) interleaved stereo frames into
+    // `out_lrlr` (room for max_output(frames)). Returns output frames.
+    size_t process(const float *in_lrlr, size_t frames, float *out_lrlr);
+};
+
+#endif // RESAMPLER_H
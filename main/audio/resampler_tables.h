@@ -0,0 +1,135 @@
+#ifndef RESAMPLER_TABLES_H
+#define RESAMPLER_TABLES_H
+
+#include "phono_filters.h"
+#include <cstdint>
+
+// ResamplerTables: compile-time polyphase filters for the stream resampler.
+//
+// Like the phono coefficients, every table is generated by constexpr
+// functions when the firmware is compiled and lives in flash: nothing is
+// designed at boot or when a client asks for another rate.
+//
+// Each ratio fs_out / fs_in = L / M has one Kaiser-windowed sinc prototype of
+// L·K taps, running at L·fs_in. The prototype is split into its L phases of K
+// taps; each phase is stored reversed, so an output is a plain forward dot
+// product over the K newest input samples, and normalized to unity DC gain,
+// so the phases share one gain and no image tone appears at fs_in.
+//
+// Cutoff and β were chosen so that the passband is flat within 0.1 dB to
+// 20 kHz and everything from fs_out − 20 kHz upward is rejected by ≥ 94 dB.
+// Content between 20 kHz and fs_out / 2 may alias, but only to above 20 kHz.
+//
+//   ratio            L     M     K     cutoff      β     flash
+//   48   → 44.1 kHz  147   160   64    21.75 kHz   9.5   37.6 KB
+//   96   → 48 kHz    1     2     64    23.25 kHz   9.5   0.3 KB
+//   96   → 44.1 kHz  147   320   128   21.75 kHz   9.5   75.3 KB
+
+namespace resample {
+
+using phono::PI;
+using phono::cx_sin;
+using phono::cx_cos;
+
+// The largest table has 18816 taps, so the per-tap math is kept cheap enough
+// for the compiler's constexpr operation limit: the sinc numerator follows
+// each phase by angle addition (one cx_sin / cx_cos per phase), and the
+// square root stops at convergence instead of phono::cx_sqrt's fixed 64 steps.
+
+// Square root on [0, 1]: Newton from 1 decreases monotonically to √x
+constexpr double cx_sqrt_unit(double x) {
+    if (x <= 0.0) return 0.0;
+    double r = 1.0;
+    for (int i = 0; i < 64; i++) {
+        double next = 0.5 * (r + x / r);
+        if (next >= r) break;
+        r = next;
+    }
+    return r;
+}
+
+// Zeroth-order modified Bessel function of the first kind (Kaiser window)
+constexpr double cx_bessel_i0(double x) {
+    double term = 1.0, sum = 1.0, q = x * x / 4.0;
+    for (int k = 1; k < 64 && term > sum * 1e-17; k++) {
+        term *= q / ((double)k * (double)k);
+        sum  += term;
+    }
+    return sum;
+}
+
+template <uint16_t L, uint16_t K>
+struct Polyphase {
+    float c[L * K];     // Row p = phase p, K taps, oldest sample first
+};
+
+// Kaiser-windowed sinc low-pass at `cutoff_hz`, designed at L × fs_in and
+// split into L phases of K taps.
+template <uint16_t L, uint16_t K>
+constexpr Polyphase<L, K> make_polyphase(double fs_in, double cutoff_hz, double beta) {
+    Polyphase<L, K> table{};
+    constexpr int N = L * K;
+    const double fc     = cutoff_hz / (fs_in * L);     // Cycles per upsampled sample
+    const double center = (N - 1) / 2.0;
+    const double i0_beta = cx_bessel_i0(beta);
+    const double step    = 2.0 * PI * fc * L;           // Phase advance per tap of a row
+    const double sin_step = cx_sin(step), cos_step = cx_cos(step);
+
+    for (int p = 0; p < L; p++) {
+        double row[K] = {};
+        double sum = 0.0;
+        double s = cx_sin(2.0 * PI * fc * (p - center));
+        double c = cx_cos(2.0 * PI * fc * (p - center));
+        for (int k = 0; k < K; k++) {
+            int    j = p + k * L;                       // Prototype tap
+            double x = 2.0 * PI * fc * (j - center);
+            double sinc = (j * 2 == N - 1) ? 1.0 : s / x;
+            double r = 2.0 * j / (N - 1) - 1.0;
+            double w = cx_bessel_i0(beta * cx_sqrt_unit(1.0 - r * r)) / i0_beta;
+            double s_next = s * cos_step + c * sin_step;
+            c = c * cos_step - s * sin_step;
+            s = s_next;
+            row[K - 1 - k] = sinc * w;                  // Reversed: x[i-k] pairs with c[K-1-k]
+            sum += sinc * w;
+        }
+        for (int k = 0; k < K; k++) table.c[p * K + k] = static_cast<float>(row[k] / sum);
+    }
+    return table;
+}
+
+// ─── Supported ratios ────────────────────────────────────────────────────────
+
+struct RatioTable {
+    uint32_t     in_rate;
+    uint32_t     out_rate;
+    uint16_t     up;            // L
+    uint16_t     down;          // M
+    uint16_t     taps;          // K, per phase
+    const float *coeffs;        // up × taps
+};
+
+constexpr double KAISER_BETA = 9.5;
+
+template <uint32_t IN, uint32_t OUT, uint16_t L, uint16_t M, uint16_t K, uint32_t CUTOFF_HZ>
+struct Ratio {
+    static_assert((uint64_t)IN * L == (uint64_t)OUT * M, "L / M must equal OUT / IN");
+    static_assert(CUTOFF_HZ < OUT / 2 + 2000, "cutoff too far above the output Nyquist");
+
+    static constexpr Polyphase<L, K> poly =
+        make_polyphase<L, K>(static_cast<double>(IN), static_cast<double>(CUTOFF_HZ), KAISER_BETA);
+
+    static constexpr RatioTable table = { IN, OUT, L, M, K, poly.c };
+};
+
+// Returns the table for in_rate → out_rate, or nullptr if that ratio is not
+// supported (equal rates need no table).
+inline const RatioTable* table_for(uint32_t in_rate, uint32_t out_rate) {
+    if (in_rate == 48000 && out_rate == 44100) return &Ratio<48000, 44100, 147, 160, 64, 21750>::table;
+    if (in_rate == 96000 && out_rate == 48000) return &Ratio<96000, 48000, 1, 2, 64, 23250>::table;
+    if (in_rate == 96000 && out_rate == 44100) return &Ratio<96000, 44100, 147, 320, 128, 21750>::table;
+    return nullptr;
+}
+
+}  // namespace resample
+
+#endif // RESAMPLER_TABLES_H
@@ -0,0 +1,266 @@
+#include "spectrum_analyzer.h"
+#include "audio_tap.h"
+#include "dsp_platform.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "spectrum";
+
+static constexpr size_t N = SPECTRUM_FFT_SIZE;
+
+static float *s_work   = nullptr;   // [N * 2] complex FFT workspace (internal RAM)
+static float *s_window = nullptr;   // [N] Hann window
+static float *s_power  = nullptr;   // [2][SPECTRUM_FFT_BINS] double-buffered power spectra
+static float  s_norm   = 1.0f;      // Full-scale sine → power 1.0
+
+static uint32_t s_sample_rate = 48000;
+static TaskHandle_t s_task = nullptr;
+
+static std::atomic<bool>     s_active{false};
+static std::atomic<uint8_t>  s_fps{SPECTRUM_DEFAULT_FPS};
+static std::atomic<int64_t>  s_last_touch_us{0};
+static std::atomic<uint32_t> s_seq{0};            // Frames published
+static std::atomic<uint8_t>  s_pub{0};            // Buffer holding the latest frame
+static std::atomic<int64_t>  s_pub_us{0};         // esp_timer time of the latest frame
+static bool     s_tap_held = false;
+static uint32_t s_tap_start = 0;                  // Tap index at acquire()
+
+// Metrics
+static volatile uint32_t s_lost       = 0;
+static volatile uint32_t s_cycles_avg = 0;
+static volatile uint32_t s_cycles_max = 0;
+
+// ─── Helpers ─────────────────────────────────────────────────────────────────
+
+static bool alloc_buffers() {
+    if (s_work != nullptr) return true;
+
+    s_work = (float *)heap_caps_malloc(N * 2 * sizeof(float), MALLOC_CAP_INTERNAL);
+    s_window = (float *)heap_caps_malloc(N * sizeof(float), MALLOC_CAP_SPIRAM);
+    if (s_window == nullptr) s_window = (float *)heap_caps_malloc(N * sizeof(float), MALLOC_CAP_INTERNAL);
+    s_power = (float *)heap_caps_malloc(2 * SPECTRUM_FFT_BINS * sizeof(float), MALLOC_CAP_SPIRAM);
+    if (s_power == nullptr) s_power = (float *)heap_caps_malloc(2 * SPECTRUM_FFT_BINS * sizeof(float), MALLOC_CAP_INTERNAL);
+
+    if (s_work == nullptr || s_window == nullptr || s_power == nullptr) {
+        heap_caps_free(s_work);
+        heap_caps_free(s_window);
+        heap_caps_free(s_power);
+        s_work = s_window = s_power = nullptr;
+        ESP_LOGE(TAG, "No memory for analyzer buffers");
+        return false;
+    }
+
+    float sum = 0.0f;
+    for (size_t i = 0; i < N; i++) {
+        s_window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * (float)i / (float)N);
+        sum += s_window[i];
+    }
+    // A full-scale sine peaks at |X| = sum(w) / 2
+    s_norm = 4.0f / (sum * sum);
+    return true;
+}
+
+// Start feeding the tap; the first frame needs N fresh frames
+static bool start_tap() {
+    if (s_tap_held) return true;
+    if (!alloc_buffers()) return false;
+    AudioTap::acquire();
+    s_tap_start = AudioTap::write_index();
+    s_tap_held  = true;
+    return true;
+}
+
+static void stop_tap() {
+    if (!s_tap_held) return;
+    AudioTap::release();
+    s_tap_held = false;
+}
+
+// Analyze the latest window and publish it. False if not enough audio yet.
+static bool analyze_frame() {
+    uint32_t end = AudioTap::write_index();
+    if (end - s_tap_start < N) return false;
+
+    uint32_t t0 = esp_cpu_get_cycle_count();
+
+    // LRLR float is already the interleaved complex layout: re = L, im = R
+    if (!AudioTap::read(end, s_work, N)) {
+        s_lost = s_lost + 1;
+        return false;
+    }
+    for (size_t i = 0; i < N; i++) {
+        s_work[i * 2 + 0] *= s_window[i];
+        s_work[i * 2 + 1] *= s_window[i];
+    }
+    dsps_fft2r_fc32(s_work, N);
+    dsps_bit_rev_fc32(s_work, N);
+
+    // Separate the channels: L = (Z[k] + conj Z[N-k]) / 2, R = (Z[k] - conj Z[N-k]) / 2i,
+    // then average their power
+    float *out = s_power + (size_t)(s_pub.load(std::memory_order_relaxed) ^ 1) * SPECTRUM_FFT_BINS;
+    for (size_t k = 0; k < SPECTRUM_FFT_BINS; k++) {
+        size_t nk = (N - k) & (N - 1);
+        float zr = s_work[k * 2], zi = s_work[k * 2 + 1];
+        float cr = s_work[nk * 2], ci = s_work[nk * 2 + 1];
+        float lr = 0.5f * (zr + cr), li = 0.5f * (zi - ci);
+        float rr = 0.5f * (zi + ci), ri = 0.5f * (cr - zr);
+        out[k] = 0.5f * (lr * lr + li * li + rr * rr + ri * ri) * s_norm;
+    }
+    s_pub.store(s_pub.load(std::memory_order_relaxed) ^ 1, std::memory_order_release);
+    s_pub_us.store(esp_timer_get_time(), std::memory_order_relaxed);
+    s_seq.fetch_add(1, std::memory_order_release);
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+    if (cycles > s_cycles_max) s_cycles_max = cycles;
+    s_cycles_avg = s_cycles_avg == 0 ? cycles : s_cycles_avg - (s_cycles_avg >> 4) + (cycles >> 4);
+    return true;
+}
+
+static bool idle_expired() {
+    return esp_timer_get_time() - s_last_touch_us.load(std::memory_order_relaxed) >
+           (int64_t)SPECTRUM_IDLE_TIMEOUT_MS * 1000;
+}
+
+static void spectrum_task(void *params) {
+    for (;;) {
+        if (!s_active.load(std::memory_order_acquire)) {
+            stop_tap();
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        if (idle_expired() || !start_tap()) {
+            s_active.store(false, std::memory_order_release);
+            ESP_LOGI(TAG, "Analyzer idle");
+            continue;
+        }
+        analyze_frame();
+        vTaskDelay(pdMS_TO_TICKS(1000 / s_fps.load(std::memory_order_relaxed)));
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool SpectrumAnalyzer::init(uint32_t sample_rate) {
+    s_sample_rate = sample_rate;
+
+    esp_err_t err = dsps_fft2r_init_fc32(nullptr, CONFIG_DSP_MAX_FFT_SIZE);
+    if (err != ESP_OK && err != ESP_ERR_DSP_REINITIALIZED) {
+        ESP_LOGE(TAG, "FFT init failed: %d", err);
+        return false;
+    }
+
+    if (s_task == nullptr) {
+        BaseType_t result = xTaskCreatePinnedToCore(
+            spectrum_task,
+            "spectrum",
+            3072,
+            nullptr,
+            3,  // Below HTTP (6) and streaming: analysis yields to delivery
+            &s_task,
+            1   // Core 1
+        );
+        if (result != pdPASS) {
+            // Fall back to analyzing on demand in the requesting task
+            s_task = nullptr;
+            ESP_LOGW(TAG, "spectrum task not created, analyzing on request");
+        }
+    }
+
+    ESP_LOGI(TAG, "Spectrum analyzer ready (FFT %u, %.1f Hz/bin)",
+             (unsigned)N, (float)sample_rate / (float)N);
+    return true;
+}
+
+void SpectrumAnalyzer::set_fps(uint8_t fps) {
+    if (fps < 1) fps = 1;
+    if (fps > SPECTRUM_MAX_FPS) fps = SPECTRUM_MAX_FPS;
+    s_fps.store(fps, std::memory_order_relaxed);
+}
+
+void SpectrumAnalyzer::touch() {
+    s_last_touch_us.store(esp_timer_get_time(), std::memory_order_relaxed);
+
+    if (s_task == nullptr) {
+        if (start_tap()) {
+            s_active.store(true, std::memory_order_release);
+            analyze_frame();
+        }
+        return;
+    }
+    if (!s_active.exchange(true, std::memory_order_acq_rel)) {
+        ESP_LOGI(TAG, "Analyzer started (%u fps)", s_fps.load(std::memory_order_relaxed));
+        xTaskNotifyGive(s_task);
+    }
+}
+
+bool SpectrumAnalyzer::get_bands(uint16_t bands, float f_min_hz, uint8_t *out, SpectrumFrameInfo *info) {
+    if (out == nullptr || bands == 0 || bands > SPECTRUM_MAX_BANDS || s_power == nullptr) return false;
+
+    const float nyquist = (float)s_sample_rate / 2.0f;
+    const float df      = (float)s_sample_rate / (float)N;
+    if (f_min_hz < df) f_min_hz = df;
+    if (f_min_hz > nyquist / 2.0f) f_min_hz = nyquist / 2.0f;
+    const float ratio = powf(nyquist / f_min_hz, 1.0f / (float)bands);
+
+    // Retry if the analyzer published twice while we read (it reuses our buffer)
+    for (int attempt = 0; attempt < 3; attempt++) {
+        uint32_t seq = s_seq.load(std::memory_order_acquire);
+        if (seq == 0) return false;
+        const float *p = s_power + (size_t)s_pub.load(std::memory_order_acquire) * SPECTRUM_FFT_BINS;
+
+        float lo = f_min_hz;
+        for (uint16_t b = 0; b < bands; b++) {
+            float hi = lo * ratio;
+            size_t k_lo = (size_t)ceilf(lo / df);
+            size_t k_hi = (size_t)floorf(hi / df);
+            if (k_hi >= SPECTRUM_FFT_BINS) k_hi = SPECTRUM_FFT_BINS - 1;
+
+            float peak = 0.0f;
+            if (k_lo > k_hi) {
+                // Band narrower than one FFT bin: use the bin at its centre
+                size_t k = (size_t)lroundf(sqrtf(lo * hi) / df);
+                peak = p[k < SPECTRUM_FFT_BINS ? k : SPECTRUM_FFT_BINS - 1];
+            } else {
+                for (size_t k = k_lo; k <= k_hi; k++) {
+                    if (p[k] > peak) peak = p[k];
+                }
+            }
+
+            float db = peak > 1e-14f ? 10.0f * log10f(peak) : SPECTRUM_DB_FLOOR;
+            float q  = (db - SPECTRUM_DB_FLOOR) / SPECTRUM_DB_STEP;
+            out[b] = q <= 0.0f ? 0 : (q >= 255.0f ? 255 : (uint8_t)lroundf(q));
+            lo = hi;
+        }
+
+        if (s_seq.load(std::memory_order_acquire) - seq < 2) {
+            if (info != nullptr) {
+                info->sequence    = seq;
+                info->age_ms      = (uint32_t)((esp_timer_get_time() -
+                                                s_pub_us.load(std::memory_order_relaxed)) / 1000);
+                info->sample_rate = s_sample_rate;
+                info->f_min_hz    = f_min_hz;
+                info->f_max_hz    = nyquist;
+                info->bands       = bands;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void SpectrumAnalyzer::get_stats(SpectrumStats *stats) {
+    if (stats == nullptr) return;
+
+    uint8_t fps = s_fps.load(std::memory_order_relaxed);
+    bool active = s_active.load(std::memory_order_acquire);
+    stats->active         = active;
+    stats->fps            = fps;
+    stats->frames         = s_seq.load(std::memory_order_relaxed);
+    stats->lost_frames    = s_lost;
+    stats->cycles_avg     = s_cycles_avg;
+    stats->cycles_max     = s_cycles_max;
+    stats->core1_load_pct = active ? (float)s_cycles_avg * (float)fps /
+                                     ((float)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e4f)
+                                   : 0.0f;
+}
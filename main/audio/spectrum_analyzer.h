@@ -0,0 +1,78 @@
+#ifndef SPECTRUM_ANALYZER_H
+#define SPECTRUM_ANALYZER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// SpectrumAnalyzer: live spectrum of the streamed signal for /api/spectrum.
+//
+// The "spectrum" task (Core 1, priority 3 — below HTTP and streaming) wakes
+// at the configured frame rate, copies the latest SPECTRUM_FFT_SIZE frames
+// from AudioTap, applies a Hann window and runs one esp-dsp complex FFT with
+// L in the real and R in the imaginary part; the two channel spectra are
+// separated afterwards and averaged as power. Analysis is decimated in time:
+// only one window per frame period is transformed, however many DMA blocks
+// arrive in between. Readers reduce the 1025-bin power spectrum to
+// log-spaced bands on request.
+//
+// The capture task only feeds the tap (one memcpy per block, only while the
+// analyzer is active); it never waits for the analyzer. The analyzer starts
+// on the first request and stops SPECTRUM_IDLE_TIMEOUT_MS after the last one.
+//
+// Cost: one 2048-point complex FFT plus windowing and the L/R split per
+// frame, so Core 1 load scales linearly with the frame rate:
+//   load % = cycles_per_frame × fps / (CPU MHz × 10⁴)
+// cycles_per_frame and the resulting load are reported live in /status.
+
+static constexpr size_t   SPECTRUM_FFT_SIZE       = 2048;
+static constexpr size_t   SPECTRUM_FFT_BINS       = SPECTRUM_FFT_SIZE / 2 + 1;
+static constexpr uint8_t  SPECTRUM_DEFAULT_FPS    = 10;
+static constexpr uint8_t  SPECTRUM_MAX_FPS        = 30;
+static constexpr uint16_t SPECTRUM_DEFAULT_BANDS  = 64;
+static constexpr uint16_t SPECTRUM_MAX_BANDS      = 256;
+static constexpr uint32_t SPECTRUM_IDLE_TIMEOUT_MS = 10000;
+
+// Band levels are encoded as uint8: dB = SPECTRUM_DB_FLOOR + value × SPECTRUM_DB_STEP
+static constexpr float SPECTRUM_DB_FLOOR = -127.5f;
+static constexpr float SPECTRUM_DB_STEP  = 0.5f;
+
+struct SpectrumFrameInfo {
+    uint32_t sequence;          // Frames analyzed since start (0 = none yet)
+    uint32_t age_ms;            // Time since the frame was published
+    uint32_t sample_rate;
+    float    f_min_hz;
+    float    f_max_hz;
+    uint16_t bands;
+};
+
+struct SpectrumStats {
+    bool     active;
+    uint8_t  fps;
+    uint32_t frames;
+    uint32_t lost_frames;       // Tap window overwritten before it was copied
+    uint32_t cycles_avg;        // Per analyzed frame
+    uint32_t cycles_max;
+    float    core1_load_pct;    // cycles_avg × fps as % of one core
+};
+
+class SpectrumAnalyzer {
+public:
+    // Create the (idle) analyzer task. Requires AudioTap::init().
+    static bool init(uint32_t sample_rate);
+
+    // Frame rate in frames per second (1..SPECTRUM_MAX_FPS)
+    static void set_fps(uint8_t fps);
+
+    // Mark the analyzer as in use; starts it if idle. Call on every request.
+    static void touch();
+
+    // Reduce the latest frame to `bands` log-spaced bands between f_min_hz and
+    // Nyquist (peak power per band), encoded as uint8 (see SPECTRUM_DB_*).
+    // Never waits for a new frame. Returns false if no frame has been
+    // analyzed yet.
+    static bool get_bands(uint16_t bands, float f_min_hz, uint8_t *out, SpectrumFrameInfo *info);
+
+    static void get_stats(SpectrumStats *stats);
+};
+
+#endif // SPECTRUM_ANALYZER_H
@@ -0,0 +1,507 @@
+#include "thdn_analyzer.h"
+#include "audio_tap.h"
+#include "dsp_platform.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "thdn";
+
+// Constrained notch in delta form: a = δ - 2, ρ = 1 - ε, c1 = 2ε + δ - εδ,
+// c2 = 2ε - ε². Every term is a difference of neighbouring samples or a small
+// coefficient times a sample, so nothing cancels catastrophically in float.
+// The output is scaled by (1 + ρ²) / 2 for unity gain away from the notch;
+// the state keeps the unscaled value.
+struct Notch {
+    float delta, eps, c1, c2, gain;
+    float x1, x2, y1, y2;
+
+    void tune(float d) {
+        delta = d;
+        c1 = 2.0f * eps + d - eps * d;
+        c2 = 2.0f * eps - eps * eps;
+        gain = 1.0f - 0.5f * c2;
+    }
+    void clear() { x1 = x2 = y1 = y2 = 0.0f; }
+
+    float run(float x) {
+        float num = (x - x1) - (x1 - x2) + delta * x1;
+        float y = num + (y1 - y2) + y1 - c1 * y1 + c2 * y2;
+        x2 = x1; x1 = x;
+        y2 = y1; y1 = y;
+        return gain * y;
+    }
+};
+
+enum class LockState : uint8_t { LOCKING, SETTLING, MEASURING };
+
+struct Channel {
+    LockState state;
+    uint32_t  state_frames;         // Frames spent in the current state
+
+    // Zero-crossing lock
+    float    zc_prev, zc_peak, zc_amp;
+    bool     zc_armed;
+    uint32_t zc_count, zc_first_n, zc_last_n;
+    float    zc_first_frac, zc_last_frac;
+
+    // Fundamental notch and its gradient ∂y/∂δ (same denominator)
+    Notch    notch;
+    float    g1, g2, pg;
+    float    mu;                    // 0 until the notch transient has passed
+    float    delta_comp;            // Kahan remainder: steps are below one ulp of δ
+
+    float    dc_x1, dc_y1;          // Input high-pass
+    float    lp_z1, lp_z2;          // Residual low-pass (fs ≥ 88.2 kHz only)
+    Notch    harm[THDN_MAX_HARMONIC - 1];
+    int      harmonics;             // Harmonic notches below 0.45 fs
+
+    // Window sums
+    bool     counting;              // Measuring since the window started
+    double   sxx, srr, snn;
+};
+
+static uint32_t s_sample_rate = 48000;
+static TaskHandle_t s_task = nullptr;
+static float *s_buf = nullptr;                    // [THDN_CHUNK_FRAMES * 2] LRLR
+
+static std::atomic<bool>     s_active{false};
+static std::atomic<int64_t>  s_last_touch_us{0};
+static std::atomic<uint32_t> s_window_ms{(uint32_t)(THDN_DEFAULT_WINDOW_S * 1000.0f)};
+
+// Analyzer state (owned by the analyzer task)
+static bool     s_tap_held = false;
+static uint32_t s_read_idx = 0;
+static uint32_t s_n = 0;                          // Frames processed since start
+static Channel  s_ch[2];
+static uint32_t s_cur_window_ms = 0;
+static uint32_t s_window_frames = 0;
+static uint32_t s_window_pos = 0;
+static float    s_dc_r = 0.999f;
+static float    s_lp[5];                          // b0 b1 b2 a1 a2
+static bool     s_lp_enabled = false;
+static float    s_delta_min = 0.0f, s_delta_max = 4.0f;
+
+// Published results: seqlock around s_result
+static ThdnResult s_result;
+static std::atomic<uint32_t> s_result_seq{0};
+static uint32_t s_windows = 0;
+
+// Normalized LMS step sizes for the notch frequency
+static constexpr float THDN_MU_SETTLE = 4e-3f;
+static constexpr float THDN_MU_TRACK  = 1e-3f;
+
+// Metrics
+static volatile uint32_t s_lost       = 0;
+static volatile uint32_t s_cycles_avg = 0;
+static volatile uint32_t s_cycles_max = 0;
+
+// ─── Helpers ─────────────────────────────────────────────────────────────────
+
+// δ = 2 - 2 cos ω = 4 sin²(ω/2), precise for small ω
+static float delta_for(float w) {
+    float s = sinf(0.5f * w);
+    return 4.0f * s * s;
+}
+
+static float omega_for(float delta) {
+    return 2.0f * asinf(0.5f * sqrtf(delta));
+}
+
+static void reset_channel(Channel &c) {
+    memset(&c, 0, sizeof(c));
+    c.state = LockState::LOCKING;
+}
+
+static void reset_window() {
+    s_cur_window_ms = s_window_ms.load(std::memory_order_relaxed);
+    s_window_frames = (uint32_t)((uint64_t)s_sample_rate * s_cur_window_ms / 1000);
+    s_window_pos = 0;
+    for (Channel &c : s_ch) {
+        c.counting = c.state == LockState::MEASURING;
+        c.sxx = c.srr = c.snn = 0.0;
+    }
+}
+
+static void start_analysis() {
+    if (s_buf == nullptr) {
+        s_buf = (float *)heap_caps_malloc(THDN_CHUNK_FRAMES * 2 * sizeof(float), MALLOC_CAP_INTERNAL);
+    }
+    if (s_buf == nullptr) {
+        ESP_LOGE(TAG, "No memory for analyzer buffer");
+        s_active.store(false, std::memory_order_release);
+        return;
+    }
+
+    const float fs = (float)s_sample_rate;
+    s_dc_r = 1.0f - 2.0f * (float)M_PI * 20.0f / fs;
+    s_delta_min = delta_for(2.0f * (float)M_PI * 20.0f / fs);
+    s_delta_max = delta_for(2.0f * (float)M_PI * 0.45f);
+
+    // Residual bandwidth 20 Hz – 20 kHz; below 88.2 kHz Nyquist already is the limit
+    s_lp_enabled = s_sample_rate >= 88200;
+    if (s_lp_enabled) {
+        float w0 = 2.0f * (float)M_PI * 20000.0f / fs;
+        float alpha = sinf(w0) / (2.0f * 0.7071f);
+        float a0 = 1.0f + alpha;
+        float c = cosf(w0);
+        s_lp[0] = (1.0f - c) / 2.0f / a0;
+        s_lp[1] = (1.0f - c) / a0;
+        s_lp[2] = (1.0f - c) / 2.0f / a0;
+        s_lp[3] = -2.0f * c / a0;
+        s_lp[4] = (1.0f - alpha) / a0;
+    }
+
+    for (Channel &c : s_ch) reset_channel(c);
+    s_n = 0;
+    s_windows = 0;
+    s_lost = 0;
+    s_cycles_avg = 0;
+    s_cycles_max = 0;
+    reset_window();
+
+    // Forget the previous session's results
+    s_result_seq.fetch_add(1, std::memory_order_acq_rel);
+    memset(&s_result, 0, sizeof(s_result));
+    s_result_seq.fetch_add(1, std::memory_order_release);
+
+    AudioTap::acquire();
+    s_tap_held = true;
+    s_read_idx = AudioTap::write_index();
+    ESP_LOGI(TAG, "Analyzer started (%.1f s window)", s_cur_window_ms / 1000.0f);
+}
+
+static void stop_analysis() {
+    if (!s_tap_held) return;
+    AudioTap::release();
+    s_tap_held = false;
+    ESP_LOGI(TAG, "Analyzer idle");
+}
+
+// Lock finished: tune the notch to the zero-crossing frequency
+static void lock_channel(Channel &c) {
+    if (c.zc_count >= 4 && c.zc_last_n != c.zc_first_n) {
+        float span = (float)(c.zc_last_n - c.zc_first_n) + c.zc_last_frac - c.zc_first_frac;
+        float w = 2.0f * (float)M_PI * (float)(c.zc_count - 1) / span;
+        float d = delta_for(w);
+        if (d > s_delta_min && d < s_delta_max) {
+            c.notch.eps = 0.5f * w / THDN_NOTCH_Q;    // -3 dB width ≈ ω₀ / Q
+            c.notch.tune(d);
+            c.notch.clear();
+            c.g1 = c.g2 = c.pg = 0.0f;
+            c.mu = 0.0f;
+            c.delta_comp = 0.0f;
+            c.state = LockState::SETTLING;
+            c.state_frames = 0;
+            return;
+        }
+    }
+    // No tone: try again
+    float keep_amp = c.zc_amp;
+    reset_channel(c);
+    c.zc_amp = keep_amp;
+}
+
+// Harmonic notches follow the adapted fundamental, once per chunk
+static void tune_harmonics(Channel &c) {
+    float w = omega_for(c.notch.delta);
+    c.harmonics = 0;
+    for (int k = 2; k <= THDN_MAX_HARMONIC; k++) {
+        if ((float)k * w >= 2.0f * (float)M_PI * 0.45f) break;
+        Notch &h = c.harm[k - 2];
+        h.eps = c.notch.eps;                          // Same absolute bandwidth
+        h.tune(delta_for((float)k * w));
+        c.harmonics++;
+    }
+}
+
+static void process_locking(Channel &c, const float *lrlr, size_t frames, uint32_t n0) {
+    for (size_t i = 0; i < frames; i++) {
+        float x = lrlr[i * 2];
+        float ax = fabsf(x);
+        if (ax > c.zc_peak) c.zc_peak = ax;
+        if (x < -0.25f * c.zc_amp) c.zc_armed = true;
+        if (c.zc_armed && c.zc_prev < 0.0f && x >= 0.0f) {
+            float frac = c.zc_prev / (c.zc_prev - x);
+            uint32_t n = n0 + (uint32_t)i;
+            if (c.zc_count == 0) {
+                c.zc_first_n = n;
+                c.zc_first_frac = frac;
+            }
+            c.zc_last_n = n;
+            c.zc_last_frac = frac;
+            c.zc_count++;
+            c.zc_amp = c.zc_amp == 0.0f ? c.zc_peak : c.zc_amp + 0.25f * (c.zc_peak - c.zc_amp);
+            c.zc_peak = 0.0f;
+            c.zc_armed = false;
+        }
+        c.zc_prev = x;
+    }
+}
+
+// Band-limit, notch and accumulate `frames` frames of one channel
+static void process_notch(Channel &c, const float *lrlr, size_t frames) {
+    Notch n = c.notch;
+    const float rho = 1.0f - n.eps;
+    float g1 = c.g1, g2 = c.g2, pg = c.pg;
+    float comp = c.delta_comp;
+    const float mu = c.mu;
+    float sxx = 0.0f, srr = 0.0f, snn = 0.0f;
+
+    for (size_t i = 0; i < frames; i++) {
+        // 20 Hz high-pass first: the notch passes DC, and DC in the
+        // gradient would bias the adaptation off the tone
+        float x = lrlr[i * 2] - c.dc_x1 + s_dc_r * c.dc_y1;
+        c.dc_x1 = lrlr[i * 2];
+        c.dc_y1 = x;
+
+        float xp = n.x1, yp = n.y1;
+        float y = n.run(x);
+
+        // ∂y/∂δ = z⁻¹(x - ρy) / D(z); normalized LMS step on y²
+        float g = (xp - rho * yp) + (g1 - g2) + g1 - n.c1 * g1 + n.c2 * g2;
+        g2 = g1;
+        g1 = g;
+        pg += 0.001f * (g * g - pg);
+        float step = comp - mu * y * g / (pg + 1e-30f);
+        float d = n.delta + step;
+        comp = step - (d - n.delta);
+        n.tune(d < s_delta_min ? s_delta_min : (d > s_delta_max ? s_delta_max : d));
+
+        // Residual, 20 kHz low-pass when the band extends beyond it
+        float r = y;
+        if (s_lp_enabled) {
+            float l = s_lp[0] * r + c.lp_z1;
+            c.lp_z1 = s_lp[1] * r - s_lp[3] * l + c.lp_z2;
+            c.lp_z2 = s_lp[2] * r - s_lp[4] * l;
+            r = l;
+        }
+        float noise = r;
+        for (int k = 0; k < c.harmonics; k++) noise = c.harm[k].run(noise);
+
+        sxx += x * x;
+        srr += r * r;
+        snn += noise * noise;
+    }
+
+    c.notch = n;
+    c.g1 = g1;
+    c.g2 = g2;
+    c.pg = pg;
+    c.delta_comp = comp;
+    c.sxx += sxx;
+    c.srr += srr;
+    c.snn += snn;
+}
+
+static void process_channel(Channel &c, const float *lrlr, size_t frames, uint32_t n0) {
+    const uint32_t lock_frames   = (uint32_t)(THDN_LOCK_S * (float)s_sample_rate);
+    const uint32_t settle_frames = (uint32_t)(THDN_SETTLE_S * (float)s_sample_rate);
+
+    switch (c.state) {
+        case LockState::LOCKING:
+            process_locking(c, lrlr, frames, n0);
+            c.state_frames += (uint32_t)frames;
+            if (c.state_frames >= lock_frames) lock_channel(c);
+            break;
+
+        case LockState::SETTLING: {
+            // Hold adaptation while the notch rings in (~4 time constants),
+            // then converge fast
+            const uint32_t hold_frames = (uint32_t)(4.0f / c.notch.eps);
+            tune_harmonics(c);
+            process_notch(c, lrlr, frames);
+            c.state_frames += (uint32_t)frames;
+            if (c.state_frames >= hold_frames) c.mu = THDN_MU_SETTLE;
+            if (c.state_frames >= hold_frames + settle_frames) {
+                c.state = LockState::MEASURING;
+                c.mu = THDN_MU_TRACK;
+            }
+            break;
+        }
+
+        case LockState::MEASURING:
+            tune_harmonics(c);
+            process_notch(c, lrlr, frames);
+            break;
+    }
+}
+
+static float db10(double p) {
+    return p > 1e-15 ? 10.0f * (float)log10(p) : THDN_FLOOR_DB;
+}
+
+static void finish_window() {
+    ThdnResult r;
+    memset(&r, 0, sizeof(r));
+    r.active      = true;
+    r.window_s    = s_cur_window_ms / 1000.0f;
+    r.sample_rate = s_sample_rate;
+
+    for (int ch = 0; ch < 2; ch++) {
+        Channel &c = s_ch[ch];
+        ThdnChannelResult &out = r.channel[ch];
+        if (!c.counting || s_window_pos == 0) continue;
+
+        const double n = (double)s_window_pos;
+        double px = c.sxx / n;
+        double pr = c.srr / n;
+        double pn = c.snn / n;
+        double ph = pr > pn ? pr - pn : 0.0;
+        double pf = px > pr ? px - pr : 1e-30;
+
+        out.level_dbfs = db10(px);
+        if (out.level_dbfs < THDN_MIN_LEVEL_DBFS) {
+            // Tone gone: look for it again
+            float keep_amp = c.zc_amp;
+            reset_channel(c);
+            c.zc_amp = keep_amp;
+            continue;
+        }
+        out.valid            = true;
+        out.fundamental_hz   = omega_for(c.notch.delta) * (float)s_sample_rate / (2.0f * (float)M_PI);
+        out.thdn_db          = db10(pr / px);
+        out.thdn_pct         = 100.0f * (float)sqrt(pr / px);
+        out.thd_db           = db10(ph / px);
+        out.snr_db           = db10(pf / (pn > 1e-30 ? pn : 1e-30));
+        out.noise_floor_dbfs = db10(pn);
+    }
+
+    s_windows++;
+    r.sequence = s_windows;
+    r.lost_chunks = s_lost;
+    r.cycles_per_chunk_avg = s_cycles_avg;
+    r.cycles_per_chunk_max = s_cycles_max;
+
+    s_result_seq.fetch_add(1, std::memory_order_acq_rel);
+    s_result = r;
+    s_result_seq.fetch_add(1, std::memory_order_release);
+
+    reset_window();
+}
+
+static void process_chunk(const float *lrlr, size_t frames) {
+    if (s_window_ms.load(std::memory_order_relaxed) != s_cur_window_ms) reset_window();
+
+    while (frames > 0) {
+        size_t n = s_window_frames - s_window_pos;
+        if (n > frames) n = frames;
+        for (int ch = 0; ch < 2; ch++) {
+            process_channel(s_ch[ch], lrlr + ch, n, s_n);
+        }
+        s_n += (uint32_t)n;
+        s_window_pos += (uint32_t)n;
+        lrlr += n * 2;
+        frames -= n;
+        if (s_window_pos >= s_window_frames) finish_window();
+    }
+}
+
+// Process everything the tap holds beyond s_read_idx, one bounded chunk at a time
+static void drain() {
+    for (;;) {
+        uint32_t avail = AudioTap::write_index() - s_read_idx;
+        if (avail == 0) break;
+        size_t n = avail < THDN_CHUNK_FRAMES ? avail : THDN_CHUNK_FRAMES;
+
+        if (!AudioTap::read(s_read_idx + (uint32_t)n, s_buf, n)) {
+            // Fell behind the capture task: the gap would corrupt the window
+            s_lost = s_lost + 1;
+            s_read_idx = AudioTap::write_index();
+            reset_window();
+            continue;
+        }
+        s_read_idx += (uint32_t)n;
+
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        process_chunk(s_buf, n);
+        uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+        if (cycles > s_cycles_max) s_cycles_max = cycles;
+        s_cycles_avg = s_cycles_avg == 0 ? cycles : s_cycles_avg - (s_cycles_avg >> 4) + (cycles >> 4);
+    }
+}
+
+static bool idle_expired() {
+    int64_t timeout_us = ((int64_t)THDN_IDLE_TIMEOUT_MS + s_window_ms.load(std::memory_order_relaxed)) * 1000;
+    return esp_timer_get_time() - s_last_touch_us.load(std::memory_order_relaxed) > timeout_us;
+}
+
+static void thdn_task(void *params) {
+    for (;;) {
+        if (!s_active.load(std::memory_order_acquire)) {
+            stop_analysis();
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        if (idle_expired()) {
+            s_active.store(false, std::memory_order_release);
+            continue;
+        }
+        if (!s_tap_held) start_analysis();
+        if (s_tap_held) drain();
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool ThdnAnalyzer::init(uint32_t sample_rate) {
+    s_sample_rate = sample_rate;
+
+    if (s_task == nullptr) {
+        BaseType_t result = xTaskCreatePinnedToCore(
+            thdn_task,
+            "thdn",
+            3072,
+            nullptr,
+            3,  // Same tier as the other analyzers: below HTTP and streaming
+            &s_task,
+            1   // Core 1
+        );
+        if (result != pdPASS) {
+            // Fall back to analyzing on demand in the requesting task
+            s_task = nullptr;
+            ESP_LOGW(TAG, "thdn task not created, analyzing on request");
+        }
+    }
+    return true;
+}
+
+void ThdnAnalyzer::set_window(float seconds) {
+    if (seconds < THDN_MIN_WINDOW_S) seconds = THDN_MIN_WINDOW_S;
+    if (seconds > THDN_MAX_WINDOW_S) seconds = THDN_MAX_WINDOW_S;
+    s_window_ms.store((uint32_t)(seconds * 1000.0f), std::memory_order_relaxed);
+}
+
+void ThdnAnalyzer::touch() {
+    s_last_touch_us.store(esp_timer_get_time(), std::memory_order_relaxed);
+
+    if (s_task == nullptr) {
+        if (!s_tap_held) {
+            s_active.store(true, std::memory_order_release);
+            start_analysis();
+        }
+        if (s_tap_held) drain();
+        return;
+    }
+    if (!s_active.exchange(true, std::memory_order_acq_rel)) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+void ThdnAnalyzer::get_result(ThdnResult *result) {
+    if (result == nullptr) return;
+    memset(result, 0, sizeof(*result));
+
+    // Retry if the analyzer published while we copied
+    for (int attempt = 0; attempt < 3; attempt++) {
+        uint32_t seq = s_result_seq.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+        *result = s_result;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s_result_seq.load(std::memory_order_relaxed) == seq) break;
+    }
+    result->active      = s_active.load(std::memory_order_acquire);
+    result->window_s    = s_window_ms.load(std::memory_order_relaxed) / 1000.0f;
+    result->sample_rate = s_sample_rate;
+}
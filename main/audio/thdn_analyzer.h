@@ -0,0 +1,85 @@
+#ifndef THDN_ANALYZER_H
+#define THDN_ANALYZER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// ThdnAnalyzer: THD+N, SNR and noise floor of a test tone on each channel.
+//
+// Feed a sine (e.g. 440 Hz or 1 kHz from a generator or test record) into
+// the ADC and poll /api/measure/thdn. The "thdn" task (Core 1, priority 3)
+// reads the streamed signal from AudioTap in chunks of at most
+// THDN_CHUNK_FRAMES frames and, per channel:
+//
+//   1. locks onto the fundamental: zero-crossing frequency over THDN_LOCK_S
+//   2. high-passes at 20 Hz (one pole) to remove DC and rumble
+//   3. notches the fundamental with an adaptive constrained biquad
+//        H(z) = (1 + a z⁻¹ + z⁻²) / (1 + ρa z⁻¹ + ρ² z⁻²),  a = -2 cos ω₀
+//      where a follows the tone by normalized LMS on the residual power.
+//      The filter is evaluated in delta form (a = δ - 2, ρ = 1 - ε) and
+//      updates to δ are Kahan-compensated, so float holds the notch to about
+//      -150 dB. A plain float biquad would leave the fundamental near -70 dB
+//      at low frequencies.
+//   4. residual = THD+N (low-passed at 20 kHz when fs ≥ 88.2 kHz); fixed
+//      notches at harmonics 2–5, tuned from the adapted a once per chunk,
+//      leave the noise for SNR and noise floor
+//
+// THD+N and THD are relative to the total signal; SNR is fundamental over
+// noise. Powers are integrated over a configurable window (default 2 s),
+// after THDN_SETTLE_S of notch convergence. Levels use the same dBFS
+// convention as /api/stereo: 10·log10(mean square), full scale = 1.
+//
+// The analyzer starts on the first request and stops THDN_IDLE_TIMEOUT_MS
+// after the last one. Work per sample is fixed (high-pass, notch and its
+// gradient, optional low-pass, up to four harmonic notches per channel), so
+// time per chunk is bounded and reported.
+
+static constexpr float    THDN_DEFAULT_WINDOW_S = 2.0f;
+static constexpr float    THDN_MIN_WINDOW_S     = 0.5f;
+static constexpr float    THDN_MAX_WINDOW_S     = 30.0f;
+static constexpr float    THDN_LOCK_S           = 0.2f;
+static constexpr float    THDN_SETTLE_S         = 0.5f;
+static constexpr float    THDN_NOTCH_Q          = 3.0f;    // Fundamental notch bandwidth f₀ / Q
+static constexpr int      THDN_MAX_HARMONIC     = 5;
+static constexpr float    THDN_MIN_LEVEL_DBFS   = -60.0f;  // Quieter channel = no signal
+static constexpr float    THDN_FLOOR_DB         = -150.0f; // Reported for zero power
+static constexpr uint32_t THDN_IDLE_TIMEOUT_MS  = 10000;   // Plus one window
+static constexpr uint32_t THDN_CHUNK_FRAMES     = 512;
+
+struct ThdnChannelResult {
+    bool  valid;                // Tone found and window completed
+    float fundamental_hz;
+    float level_dbfs;           // Total signal
+    float thdn_db;              // Residual / total
+    float thdn_pct;
+    float thd_db;               // Harmonics 2–5 / total
+    float snr_db;               // Fundamental / noise
+    float noise_floor_dbfs;     // Residual without harmonics
+};
+
+struct ThdnResult {
+    bool     active;
+    float    window_s;
+    uint32_t sequence;          // Windows completed since start (0 = none yet)
+    uint32_t sample_rate;
+    ThdnChannelResult channel[2];
+    uint32_t lost_chunks;
+    uint32_t cycles_per_chunk_avg;
+    uint32_t cycles_per_chunk_max;
+};
+
+class ThdnAnalyzer {
+public:
+    // Create the (idle) analyzer task. Requires AudioTap::init().
+    static bool init(uint32_t sample_rate);
+
+    // Integration window; restarts the current window if it changes
+    static void set_window(float seconds);
+
+    // Mark the analyzer as in use; starts it if idle. Call on every request.
+    static void touch();
+
+    static void get_result(ThdnResult *result);
+};
+
+#endif // THDN_ANALYZER_H
@@ -0,0 +1,410 @@
+#include "wow_flutter.h"
+#include "audio_tap.h"
+#include "dsp_platform.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "wow_flutter";
+
+// Second-order section in transposed direct form II
+struct Biquad {
+    double b0, b1, b2, a1, a2;
+    double z1, z2;
+
+    double run(double x) {
+        double y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        return y;
+    }
+};
+
+static uint32_t s_sample_rate = 48000;
+static TaskHandle_t s_task = nullptr;
+static float *s_buf = nullptr;                    // [WF_CHUNK_FRAMES * 2] LRLR
+
+// Commands from HTTP, applied by the measuring task
+static std::atomic<bool> s_start_pending{false};
+static std::atomic<bool> s_stop_pending{false};
+static std::atomic<bool> s_running{false};
+static float s_req_reference = WF_DEFAULT_REFERENCE_HZ;
+static float s_req_duration  = WF_DEFAULT_DURATION_S;
+
+// Measurement state (owned by the measuring task)
+static bool     s_tap_held = false;
+static uint32_t s_read_idx = 0;
+static float    s_reference = WF_DEFAULT_REFERENCE_HZ;
+static float    s_duration  = WF_DEFAULT_DURATION_S;
+
+static float    s_bp[5];                          // Tone bandpass b0 b1 b2 a1 a2
+static float    s_bp_z1 = 0.0f, s_bp_z2 = 0.0f;
+static float    s_prev_y   = 0.0f;
+static bool     s_armed    = false;
+static float    s_cycle_peak = 0.0f;              // |y| max within the current period
+static float    s_amplitude  = 0.0f;              // Tone amplitude, smoothed per period
+static uint32_t s_n          = 0;                 // Samples since start (wraps; differences only)
+static uint32_t s_last_tone_n = 0;                // Sample index of the last accepted period
+static bool     s_have_prev  = false;
+static uint32_t s_prev_cross_n = 0;
+static float    s_prev_cross_frac = 0.0f;
+
+static Biquad   s_wt[2];                          // Weighting filter
+static uint32_t s_lock_periods   = 0;             // Not yet fed to the weighting filter
+static uint32_t s_settle_periods = 0;             // Weighted, not yet counted
+
+// Results (written by the measuring task, read anywhere)
+static volatile WowFlutterState s_state = WowFlutterState::IDLE;
+static volatile uint32_t s_periods  = 0;
+static volatile uint32_t s_rejected = 0;
+static volatile uint32_t s_lost     = 0;
+static double            s_period_sum = 0.0;      // Σ period (samples) while measuring
+static double            s_wsq_sum    = 0.0;      // Σ weighted²
+static double            s_wpeak      = 0.0;      // max |weighted|
+static volatile float    s_peak       = 0.0f;
+static volatile float    s_measured_hz = 0.0f;
+static volatile float    s_rms        = 0.0f;
+static volatile float    s_elapsed    = 0.0f;
+static volatile float    s_level_dbfs = -120.0f;
+static volatile uint32_t s_cycles_avg = 0;
+static volatile uint32_t s_cycles_max = 0;
+
+// ─── Filter design ───────────────────────────────────────────────────────────
+
+// RBJ bandpass (0 dB peak) around the reference tone, float for the per-sample path
+static void design_bandpass(float f0, float fs) {
+    const float q = 2.0f;
+    float w0 = 2.0f * (float)M_PI * f0 / fs;
+    float alpha = sinf(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+    s_bp[0] = alpha / a0;
+    s_bp[1] = 0.0f;
+    s_bp[2] = -alpha / a0;
+    s_bp[3] = -2.0f * cosf(w0) / a0;
+    s_bp[4] = (1.0f - alpha) / a0;
+}
+
+static double biquad_gain(const Biquad &q, double f, double fs) {
+    double w = 2.0 * M_PI * f / fs;
+    double cr = cos(w), ci = -sin(w), c2r = cos(2 * w), c2i = -sin(2 * w);
+    double nr = q.b0 + q.b1 * cr + q.b2 * c2r, ni = q.b1 * ci + q.b2 * c2i;
+    double dr = 1.0 + q.a1 * cr + q.a2 * c2r, di = q.a1 * ci + q.a2 * c2i;
+    return sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+// Weighting filter at the period rate fs_d (≈ reference frequency); see header
+static void design_weighting(double fs_d) {
+    // 2nd-order high-pass, 0.59 Hz, Q 0.49 (RBJ)
+    double w0 = 2.0 * M_PI * 0.59 / fs_d;
+    double alpha = sin(w0) / (2.0 * 0.49);
+    double a0 = 1.0 + alpha;
+    double c = cos(w0);
+    s_wt[0] = {(1.0 + c) / 2.0 / a0, -(1.0 + c) / a0, (1.0 + c) / 2.0 / a0,
+               -2.0 * c / a0, (1.0 - alpha) / a0, 0.0, 0.0};
+
+    // 1st-order high-pass 0.74 Hz × 1st-order low-pass 11.8 Hz (bilinear)
+    double kh = tan(M_PI * 0.74 / fs_d);
+    double kl = tan(M_PI * 11.8 / fs_d);
+    double hb = 1.0 / (1.0 + kh), ha = (kh - 1.0) / (kh + 1.0);      // (1 - z⁻¹)·hb / (1 + ha z⁻¹)
+    double lb = kl / (1.0 + kl),  la = (kl - 1.0) / (kl + 1.0);      // (1 + z⁻¹)·lb / (1 + la z⁻¹)
+    s_wt[1] = {hb * lb, 0.0, -hb * lb, ha + la, ha * la, 0.0, 0.0};
+
+    // 0 dB at 4 Hz
+    double g = biquad_gain(s_wt[0], 4.0, fs_d) * biquad_gain(s_wt[1], 4.0, fs_d);
+    s_wt[1].b0 /= g;
+    s_wt[1].b2 /= g;
+}
+
+// ─── Measurement ─────────────────────────────────────────────────────────────
+
+static void release_tap() {
+    if (!s_tap_held) return;
+    AudioTap::release();
+    s_tap_held = false;
+}
+
+static void finish(WowFlutterState state) {
+    s_state = state;
+    release_tap();
+    s_running.store(false, std::memory_order_release);
+    ESP_LOGI(TAG, "Measurement %s: %.3f Hz, speed %+.3f %%, W&F peak %.4f %% rms %.4f %% (weighted)",
+             WowFlutterMeter::state_name(state), s_measured_hz,
+             s_measured_hz > 0.0f ? (s_measured_hz / s_reference - 1.0f) * 100.0f : 0.0f,
+             s_peak, s_rms);
+}
+
+static void begin_measurement() {
+    s_reference = s_req_reference;
+    s_duration  = s_req_duration;
+
+    if (s_buf == nullptr) {
+        s_buf = (float *)heap_caps_malloc(WF_CHUNK_FRAMES * 2 * sizeof(float), MALLOC_CAP_INTERNAL);
+        if (s_buf == nullptr) {
+            ESP_LOGE(TAG, "No memory for measurement buffer");
+            s_state = WowFlutterState::IDLE;
+            s_running.store(false, std::memory_order_release);
+            return;
+        }
+    }
+
+    design_bandpass(s_reference, (float)s_sample_rate);
+    design_weighting(s_reference);
+    s_bp_z1 = s_bp_z2 = 0.0f;
+    s_prev_y = 0.0f;
+    s_armed = false;
+    s_cycle_peak = 0.0f;
+    s_amplitude = 0.0f;
+    s_n = 0;
+    s_last_tone_n = 0;
+    s_have_prev = false;
+    s_lock_periods   = (uint32_t)(WF_LOCK_S * s_reference);
+    s_settle_periods = (uint32_t)(WF_SETTLE_S * s_reference);
+
+    s_periods = 0;
+    s_rejected = 0;
+    s_lost = 0;
+    s_period_sum = 0.0;
+    s_wsq_sum = 0.0;
+    s_wpeak = 0.0;
+    s_peak = 0.0f;
+    s_measured_hz = 0.0f;
+    s_rms = 0.0f;
+    s_elapsed = 0.0f;
+    s_level_dbfs = -120.0f;
+    s_cycles_avg = 0;
+    s_cycles_max = 0;
+
+    if (!s_tap_held) {
+        AudioTap::acquire();
+        s_tap_held = true;
+    }
+    s_read_idx = AudioTap::write_index();
+    s_state = WowFlutterState::SETTLING;
+    ESP_LOGI(TAG, "Measuring wow & flutter at %.0f Hz for %.0f s", s_reference, s_duration);
+}
+
+// One accepted tone period; dev = f / reference - 1
+static void on_period(double period, double dev) {
+    if (s_lock_periods > 0) {
+        // Bandpass and hysteresis still settling. Then start the high-pass at
+        // rest for the current speed offset, so that the offset step does not
+        // ring through the sub-Hz poles
+        if (--s_lock_periods == 0) {
+            s_wt[0].z1 = -s_wt[0].b0 * dev;
+            s_wt[0].z2 = s_wt[0].b2 * dev;
+        }
+        return;
+    }
+
+    double w = s_wt[1].run(s_wt[0].run(dev));
+    if (s_settle_periods > 0) {
+        if (--s_settle_periods == 0) s_state = WowFlutterState::MEASURING;
+        return;
+    }
+    s_periods = s_periods + 1;
+    s_period_sum += period;
+    s_wsq_sum += w * w;
+    if (fabs(w) > s_wpeak) s_wpeak = fabs(w);
+}
+
+// A positive-going zero crossing at sample s_n - 1 + frac
+static void on_crossing(float frac) {
+    if (s_have_prev) {
+        double period = (double)(s_n - s_prev_cross_n) + (double)frac - (double)s_prev_cross_frac;
+        double dev = (double)s_sample_rate / period / (double)s_reference - 1.0;
+        if (fabs(dev) * 100.0 > WF_CAPTURE_PCT) {
+            s_rejected = s_rejected + 1;
+        } else {
+            s_last_tone_n = s_n;
+            on_period(period, dev);
+        }
+    }
+    s_have_prev = true;
+    s_prev_cross_n = s_n;
+    s_prev_cross_frac = frac;
+
+    // Hysteresis at a quarter of the tone amplitude rejects noise crossings
+    s_amplitude = s_amplitude == 0.0f ? s_cycle_peak : s_amplitude + 0.05f * (s_cycle_peak - s_amplitude);
+    s_cycle_peak = 0.0f;
+    s_armed = false;
+}
+
+static void process_chunk(const float *lrlr, size_t frames) {
+    const float b0 = s_bp[0], b2 = s_bp[2], a1 = s_bp[3], a2 = s_bp[4];
+    float z1 = s_bp_z1, z2 = s_bp_z2, prev = s_prev_y;
+
+    for (size_t i = 0; i < frames; i++) {
+        float x = 0.5f * (lrlr[i * 2] + lrlr[i * 2 + 1]);
+        float y = b0 * x + z1;
+        z1 = -a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+
+        float ay = fabsf(y);
+        if (ay > s_cycle_peak) s_cycle_peak = ay;
+        if (y < -0.25f * s_amplitude) s_armed = true;
+        s_n++;
+        if (s_armed && prev < 0.0f && y >= 0.0f) {
+            on_crossing(prev / (prev - y));
+        }
+        prev = y;
+    }
+    s_bp_z1 = z1;
+    s_bp_z2 = z2;
+    s_prev_y = prev;
+}
+
+static void update_results() {
+    if (s_periods > 0) {
+        s_measured_hz = (float)((double)s_periods * (double)s_sample_rate / s_period_sum);
+        // Deviation relative to the mean speed, not to the nominal one
+        double scale = 100.0 * (double)s_reference / (double)s_measured_hz;
+        s_peak = (float)(s_wpeak * scale);
+        s_rms  = (float)(sqrt(s_wsq_sum / (double)s_periods) * scale);
+        s_elapsed = (float)(s_period_sum / (double)s_sample_rate);
+    }
+    s_level_dbfs = s_amplitude > 1e-6f ? 20.0f * log10f(s_amplitude) : -120.0f;
+
+    if (s_state == WowFlutterState::MEASURING && s_elapsed >= s_duration) {
+        finish(WowFlutterState::DONE);
+    } else if ((float)(s_n - s_last_tone_n) > WF_NO_SIGNAL_TIMEOUT_S * (float)s_sample_rate ||
+               (s_n > s_sample_rate && s_level_dbfs < WF_MIN_LEVEL_DBFS)) {
+        finish(WowFlutterState::NO_SIGNAL);
+    }
+}
+
+// Process everything the tap holds beyond s_read_idx, one bounded chunk at a time
+static void drain() {
+    if (s_stop_pending.exchange(false, std::memory_order_acq_rel)) {
+        s_state = WowFlutterState::IDLE;
+        release_tap();
+        s_running.store(false, std::memory_order_release);
+        ESP_LOGI(TAG, "Measurement stopped");
+    }
+    if (s_start_pending.exchange(false, std::memory_order_acq_rel)) {
+        begin_measurement();
+    }
+    if (!s_running.load(std::memory_order_acquire) || s_buf == nullptr) return;
+
+    for (;;) {
+        uint32_t avail = AudioTap::write_index() - s_read_idx;
+        if (avail == 0) break;
+        size_t n = avail < WF_CHUNK_FRAMES ? avail : WF_CHUNK_FRAMES;
+
+        if (!AudioTap::read(s_read_idx + (uint32_t)n, s_buf, n)) {
+            // Fell behind the capture task: skip ahead, the next period starts fresh
+            s_lost = s_lost + 1;
+            s_read_idx = AudioTap::write_index();
+            s_have_prev = false;
+            s_armed = false;
+            continue;
+        }
+        s_read_idx += (uint32_t)n;
+
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        process_chunk(s_buf, n);
+        uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+        if (cycles > s_cycles_max) s_cycles_max = cycles;
+        s_cycles_avg = s_cycles_avg == 0 ? cycles : s_cycles_avg - (s_cycles_avg >> 4) + (cycles >> 4);
+
+        update_results();
+        if (!s_running.load(std::memory_order_acquire)) break;
+    }
+}
+
+static void wow_flutter_task(void *params) {
+    for (;;) {
+        if (!s_running.load(std::memory_order_acquire) &&
+            !s_start_pending.load(std::memory_order_acquire) &&
+            !s_stop_pending.load(std::memory_order_acquire)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        drain();
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool WowFlutterMeter::init(uint32_t sample_rate) {
+    s_sample_rate = sample_rate;
+
+    if (s_task == nullptr) {
+        BaseType_t result = xTaskCreatePinnedToCore(
+            wow_flutter_task,
+            "wowflutter",
+            3072,
+            nullptr,
+            3,  // Same tier as the spectrum analyzer: below HTTP and streaming
+            &s_task,
+            1   // Core 1
+        );
+        if (result != pdPASS) {
+            // Fall back to measuring on demand in the requesting task
+            s_task = nullptr;
+            ESP_LOGW(TAG, "wowflutter task not created, measuring on request");
+        }
+    }
+    return true;
+}
+
+bool WowFlutterMeter::start(float reference_hz, float duration_s) {
+    if (reference_hz < 1000.0f || reference_hz > 10000.0f ||
+        reference_hz > (float)s_sample_rate / 4.0f) {
+        return false;
+    }
+    if (duration_s < WF_MIN_DURATION_S) duration_s = WF_MIN_DURATION_S;
+    if (duration_s > WF_MAX_DURATION_S) duration_s = WF_MAX_DURATION_S;
+
+    s_req_reference = reference_hz;
+    s_req_duration  = duration_s;
+    s_running.store(true, std::memory_order_release);
+    s_start_pending.store(true, std::memory_order_release);
+    if (s_task != nullptr) {
+        xTaskNotifyGive(s_task);
+    } else {
+        drain();
+    }
+    return true;
+}
+
+void WowFlutterMeter::stop() {
+    s_stop_pending.store(true, std::memory_order_release);
+    if (s_task != nullptr) {
+        xTaskNotifyGive(s_task);
+    } else {
+        drain();
+    }
+}
+
+void WowFlutterMeter::get_result(WowFlutterResult *result) {
+    if (result == nullptr) return;
+    if (s_task == nullptr) drain();
+
+    float measured = s_measured_hz;
+    result->state               = s_state;
+    result->reference_hz        = s_reference;
+    result->duration_s          = s_duration;
+    result->elapsed_s           = s_elapsed;
+    result->measured_hz         = measured;
+    result->speed_error_pct     = measured > 0.0f ? (measured / s_reference - 1.0f) * 100.0f : 0.0f;
+    result->weighted_peak_pct   = s_peak;
+    result->weighted_rms_pct    = s_rms;
+    result->tone_level_dbfs     = s_level_dbfs;
+    result->periods             = s_periods;
+    result->rejected_periods    = s_rejected;
+    result->lost_chunks         = s_lost;
+    result->cycles_per_chunk_avg = s_cycles_avg;
+    result->cycles_per_chunk_max = s_cycles_max;
+}
+
+const char *WowFlutterMeter::state_name(WowFlutterState state) {
+    switch (state) {
+        case WowFlutterState::IDLE:      return "idle";
+        case WowFlutterState::SETTLING:  return "settling";
+        case WowFlutterState::MEASURING: return "measuring";
+        case WowFlutterState::DONE:      return "done";
+        case WowFlutterState::NO_SIGNAL: return "no_signal";
+    }
+    return "unknown";
+}
@@ -0,0 +1,86 @@
+#ifndef WOW_FLUTTER_H
+#define WOW_FLUTTER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// WowFlutterMeter: platter speed and wow & flutter from a test-record tone.
+//
+// Play a 3150 Hz (DIN 45507 / IEC 60386) or 3000 Hz (JIS) test track and start
+// a measurement. The "wowflutter" task (Core 1, priority 3) reads the
+// streamed signal from AudioTap in chunks of at most WF_CHUNK_FRAMES frames:
+//
+//   per sample    mono (L + R) / 2 → bandpass at the reference frequency →
+//                 positive-going zero-crossing detector with hysteresis and
+//                 linear interpolation between samples
+//   per period    instantaneous frequency fs / period → relative deviation →
+//                 weighting filter → peak and RMS
+//
+// Work per chunk is bounded: one biquad and a compare per sample, plus two
+// biquads per tone period. The weighting filter runs once per period, i.e. at
+// about the reference frequency. Its poles sit within 0.1 % of the unit circle,
+// so it runs in double precision. That costs a few thousand cycles per
+// millisecond, on Core 1 and only while measuring.
+//
+// Weighting: 2nd-order high-pass (0.59 Hz, Q 0.49) × 1st-order high-pass
+// (0.74 Hz) × 1st-order low-pass (11.8 Hz), normalized to 0 dB at 4 Hz. This
+// is a least-squares fit to the IEC 60386 weighting table and lies within
+// 0.8 dB of it from 0.2 to 200 Hz.
+//
+// The weighting high-pass removes the constant speed offset. That offset is
+// reported separately, as the mean tone frequency over the measurement.
+// Deviation is expressed relative to the mean speed. Results start after
+// WF_LOCK_S + WF_SETTLE_S seconds so the filters can settle.
+// Periods more than WF_CAPTURE_PCT away from the reference frequency (for
+// example clicks or dropouts) are rejected and counted.
+
+static constexpr float    WF_DEFAULT_REFERENCE_HZ = 3150.0f;
+static constexpr float    WF_DEFAULT_DURATION_S   = 20.0f;
+static constexpr float    WF_MIN_DURATION_S       = 2.0f;
+static constexpr float    WF_MAX_DURATION_S       = 300.0f;
+static constexpr float    WF_LOCK_S               = 0.1f;     // Tone lock before weighting
+static constexpr float    WF_SETTLE_S             = 2.0f;
+static constexpr float    WF_CAPTURE_PCT          = 10.0f;
+static constexpr float    WF_MIN_LEVEL_DBFS       = -50.0f;   // Quieter tone = no signal
+static constexpr float    WF_NO_SIGNAL_TIMEOUT_S  = 3.0f;
+static constexpr uint32_t WF_CHUNK_FRAMES         = 512;
+
+enum class WowFlutterState : uint8_t {
+    IDLE,           // Never started or stopped
+    SETTLING,       // Tone found, filters settling
+    MEASURING,
+    DONE,           // Duration reached; results frozen
+    NO_SIGNAL       // No usable tone within WF_NO_SIGNAL_TIMEOUT_S
+};
+
+struct WowFlutterResult {
+    WowFlutterState state;
+    float    reference_hz;
+    float    duration_s;
+    float    elapsed_s;             // Measured time, excluding settling
+    float    measured_hz;           // Mean tone frequency
+    float    speed_error_pct;       // (measured / reference - 1) × 100
+    float    weighted_peak_pct;     // Largest |weighted deviation|
+    float    weighted_rms_pct;
+    float    tone_level_dbfs;       // After the bandpass
+    uint32_t periods;               // Tone periods measured
+    uint32_t rejected_periods;      // Outside ±WF_CAPTURE_PCT
+    uint32_t lost_chunks;           // Tap overrun (Core 1 starved)
+    uint32_t cycles_per_chunk_avg;
+    uint32_t cycles_per_chunk_max;
+};
+
+class WowFlutterMeter {
+public:
+    // Create the (idle) measurement task. Requires AudioTap::init().
+    static bool init(uint32_t sample_rate);
+
+    // Start a new measurement (restarts a running one).
+    static bool start(float reference_hz, float duration_s);
+    static void stop();
+
+    static void get_result(WowFlutterResult *result);
+    static const char *state_name(WowFlutterState state);
+};
+
+#endif // WOW_FLUTTER_H
@@ -23,6 +23,34 @@ struct EQBandConfig {
     float       q_factor;       // Bandwidth/resonance (0.1–10.0)
 } __attribute__((packed));
 
+// ─── Phono Preset Types ──────────────────────────────────────────────────────
+
+// Fixed de-emphasis curves for the phono preset stage (see audio/phono_filters.h).
+// Coefficients are generated at compile time per supported sample rate.
+enum class PhonoCurve : uint8_t {
+    OFF         = 0,  // No de-emphasis (preamp already applies RIAA)
+    RIAA        = 1,  // RIAA 1954: 3180 µs / 318 µs / 75 µs
+    RIAA_IEC    = 2,  // RIAA + IEC 60098 amendment subsonic pole (7950 µs)
+    COLUMBIA_LP = 3,  // Columbia LP (pre-1955): 1590 µs / 318 µs / 100 µs
+};
+
+// ─── Stream Output Types ─────────────────────────────────────────────────────
+
+// Requantization of the 24-bit capture to 16-bit stream output (see audio/dither.h).
+enum class DitherMode : uint8_t {
+    OFF      = 0,  // No dither (native rate truncates, resampled output rounds)
+    TPDF     = 1,  // ±1 LSB triangular dither, white
+    TPDF_NS1 = 2,  // TPDF + 1st-order noise shaping (1 − z⁻¹)
+    TPDF_NS2 = 3,  // TPDF + 2nd-order noise shaping (1 − z⁻¹)²
+};
+
+// Codec of the Snapcast server's stream (see network/snapcast_server.h)
+enum class SnapcastCodec : uint8_t {
+    PCM  = 0,  // 16-bit stereo at the capture rate
+    FLAC = 1,  // Lossless, 16-bit stereo at the capture rate
+    OPUS = 2,  // Opus packets at 48 kHz (optional opus component)
+};
+
 // ─── DeviceConfig ─────────────────────────────────────────────────────────────
 
 // DeviceConfig: Persistent device configuration stored in NVS
@@ -47,16 +75,68 @@ struct DeviceConfig {
     // EQ Configuration (feature 003)
     bool eq_enabled;              // Master EQ bypass switch
     EQBandConfig eq_bands[10];    // Up to 10 parametric EQ bands
+
+    // Phono preset stage (runs ahead of the user EQ bands)
+    PhonoCurve phono_curve;       // De-emphasis curve (OFF = flat)
+    bool phono_rumble_filter;     // Subsonic rumble high-pass (20 Hz, 12 dB/oct)
+
+    // Output limiter (EQ float path; replaces the hard clip when enabled)
+    bool limiter_enabled;         // Lookahead peak limiter on/off
+    float limiter_ceiling_db;     // Output ceiling in dBFS (-12 to 0)
+    float limiter_release_ms;     // Release time constant (10-1000 ms)
+
+    // FIR correction stage (IR itself lives in the fir_ir partition)
+    bool fir_enabled;             // Run the stored impulse response
+
+    // Automatic gain (EQ float path, driven by the loudness meter)
+    bool agc_enabled;             // Slow level normalization on/off
+    float agc_target_lufs;        // Short-term loudness target (-40 to -10 LUFS)
+    float agc_max_gain_db;        // Largest boost (0 to +24 dB)
+
+    // 16-bit stream output (shared StreamEncoder stage)
+    DitherMode stream_dither;     // 24 → 16-bit requantization
+    uint16_t mp3_bitrate_kbps;    // /stream.mp3 CBR bitrate (32-320 kbps)
+    uint16_t opus_bitrate_kbps;   // /stream.opus VBR target (16-256 kbps)
+    uint8_t opus_frame_ms;        // /stream.opus frame length (10 or 20 ms)
+
+    // RTP multicast output (network/rtp_sender.h)
+    bool rtp_enabled;             // Send to the multicast group
+    char rtp_group[16];           // IPv4 multicast group, dotted quad
+    uint16_t rtp_port;            // RTP port (even; RTCP on port + 1)
+    uint8_t rtp_bits;             // Payload: 16 (L16) or 24 (L24)
+    uint8_t rtp_ttl;              // Multicast TTL (1 = local subnet only)
+
+    // Snapcast server (network/snapcast_server.h)
+    bool snapcast_enabled;        // Listen for snapclients on port 1704
+    SnapcastCodec snapcast_codec; // Stream codec
+    uint16_t snapcast_buffer_ms;  // Client playout delay (200-5000 ms)
+
+    // HLS output (network/hls_segmenter.h)
+    bool hls_enabled;             // Segment the capture for /hls/live.m3u8
+    uint8_t hls_segment_s;        // Segment duration (1-4 s)
     
     uint32_t crc32;               // Integrity checksum (covers all fields above)
 
-    static constexpr uint8_t  SCHEMA_VERSION       = 2;  // Bumped for EQ fields
+    static constexpr uint8_t  SCHEMA_VERSION       = 12; // Bumped for HLS
     static constexpr uint32_t DEFAULT_SAMPLE_RATE  = 48000;
     static constexpr uint16_t DEFAULT_HTTP_PORT    = 8080;
     static constexpr uint8_t  DEFAULT_MAX_CLIENTS  = 3;
     static constexpr const char* DEFAULT_DEVICE_NAME = "ESP32-Audio-Stream";
     static constexpr uint16_t DEFAULT_MQTT_PORT    = 1883;
     static constexpr float    DEFAULT_AUDIO_THRESHOLD_DB = -40.0f;
+    static constexpr float    DEFAULT_LIMITER_CEILING_DB = -0.3f;
+    static constexpr float    DEFAULT_LIMITER_RELEASE_MS = 100.0f;
+    static constexpr float    DEFAULT_AGC_TARGET_LUFS    = -18.0f;
+    static constexpr float    DEFAULT_AGC_MAX_GAIN_DB    = 12.0f;
+    static constexpr uint16_t DEFAULT_MP3_BITRATE_KBPS   = 320;
+    static constexpr uint16_t DEFAULT_OPUS_BITRATE_KBPS  = 128;
+    static constexpr uint8_t  DEFAULT_OPUS_FRAME_MS      = 20;
+    static constexpr const char* DEFAULT_RTP_GROUP       = "239.69.83.67";
+    static constexpr uint16_t DEFAULT_RTP_PORT           = 5004;
+    static constexpr uint8_t  DEFAULT_RTP_BITS           = 24;
+    static constexpr uint8_t  DEFAULT_RTP_TTL            = 1;
+    static constexpr uint16_t DEFAULT_SNAPCAST_BUFFER_MS = 1000;
+    static constexpr uint8_t  DEFAULT_HLS_SEGMENT_S      = 2;
 } __attribute__((packed));
 
 // ─── AudioStream ──────────────────────────────────────────────────────────────
@@ -134,6 +214,55 @@ struct WavHeader {
     static constexpr size_t SIZE = 44;
 } __attribute__((packed));
 
+// WavExtensibleHeader: WAVE_FORMAT_EXTENSIBLE header for the 24-bit stream
+// (required for more than 16 bits per sample)
+struct WavExtensibleHeader {
+    char riff_tag[4];             // "RIFF"
+    uint32_t riff_size;           // 0xFFFFFFFF (indeterminate)
+    char wave_tag[4];             // "WAVE"
+    char fmt_tag[4];              // "fmt "
+    uint32_t fmt_size;            // 40 (extensible format chunk size)
+    uint16_t audio_format;        // 0xFFFE (WAVE_FORMAT_EXTENSIBLE)
+    uint16_t num_channels;        // 2 (stereo)
+    uint32_t sample_rate;         // 44100/48000/96000
+    uint32_t byte_rate;           // sample_rate × block_align
+    uint16_t block_align;         // 6 (2 × 3 bytes)
+    uint16_t bits_per_sample;     // 24 (container)
+    uint16_t cb_size;             // 22 (extension size)
+    uint16_t valid_bits;          // 24
+    uint32_t channel_mask;        // 0x3 (front left | front right)
+    uint8_t  sub_format[16];      // KSDATAFORMAT_SUBTYPE_PCM
+    char data_tag[4];             // "data"
+    uint32_t data_size;           // 0xFFFFFFFF (indeterminate)
+
+    static constexpr size_t SIZE = 68;
+} __attribute__((packed));
+
+// ImaAdpcmWavHeader: WAVE_FORMAT_IMA_ADPCM header for the ADPCM stream
+// (fmt extension plus the fact chunk required for compressed formats)
+struct ImaAdpcmWavHeader {
+    char riff_tag[4];             // "RIFF"
+    uint32_t riff_size;           // 0xFFFFFFFF (indeterminate)
+    char wave_tag[4];             // "WAVE"
+    char fmt_tag[4];              // "fmt "
+    uint32_t fmt_size;            // 20 (IMA ADPCM format chunk size)
+    uint16_t audio_format;        // 0x0011 (WAVE_FORMAT_IMA_ADPCM)
+    uint16_t num_channels;        // 2 (stereo)
+    uint32_t sample_rate;         // 44100/48000/96000
+    uint32_t byte_rate;           // sample_rate × block_align / samples_per_block
+    uint16_t block_align;         // Bytes per ADPCM block (all channels)
+    uint16_t bits_per_sample;     // 4
+    uint16_t cb_size;             // 2 (extension size)
+    uint16_t samples_per_block;   // Frames per ADPCM block
+    char fact_tag[4];             // "fact"
+    uint32_t fact_size;           // 4
+    uint32_t sample_length;       // 0xFFFFFFFF (indeterminate)
+    char data_tag[4];             // "data"
+    uint32_t data_size;           // 0xFFFFFFFF (indeterminate)
+
+    static constexpr size_t SIZE = 60;
+} __attribute__((packed));
+
 // NVS Key Constants
 namespace NVSKeys {
     // WiFi Configuration
@@ -180,4 +309,59 @@ inline EQFilterType eq_filter_type_from_str(const char* s) {
     return EQFilterType::PEAKING;
 }
 
+// Phono curve string helpers (used by HTTP handlers and logging)
+inline const char* phono_curve_to_str(PhonoCurve c) {
+    switch (c) {
+        case PhonoCurve::OFF:         return "OFF";
+        case PhonoCurve::RIAA:        return "RIAA";
+        case PhonoCurve::RIAA_IEC:    return "RIAA_IEC";
+        case PhonoCurve::COLUMBIA_LP: return "COLUMBIA_LP";
+        default:                      return "OFF";
+    }
+}
+
+inline PhonoCurve phono_curve_from_str(const char* s) {
+    if (s == nullptr)                    return PhonoCurve::OFF;
+    if (strcmp(s, "RIAA")        == 0)   return PhonoCurve::RIAA;
+    if (strcmp(s, "RIAA_IEC")    == 0)   return PhonoCurve::RIAA_IEC;
+    if (strcmp(s, "COLUMBIA_LP") == 0)   return PhonoCurve::COLUMBIA_LP;
+    return PhonoCurve::OFF;
+}
+
+// Dither mode string helpers
+inline const char* dither_mode_to_str(DitherMode m) {
+    switch (m) {
+        case DitherMode::OFF:      return "OFF";
+        case DitherMode::TPDF:     return "TPDF";
+        case DitherMode::TPDF_NS1: return "TPDF_NS1";
+        case DitherMode::TPDF_NS2: return "TPDF_NS2";
+        default:                   return "TPDF";
+    }
+}
+
+inline DitherMode dither_mode_from_str(const char* s) {
+    if (s == nullptr)                 return DitherMode::TPDF;
+    if (strcmp(s, "OFF")      == 0)   return DitherMode::OFF;
+    if (strcmp(s, "TPDF_NS1") == 0)   return DitherMode::TPDF_NS1;
+    if (strcmp(s, "TPDF_NS2") == 0)   return DitherMode::TPDF_NS2;
+    return DitherMode::TPDF;
+}
+
+// Snapcast codec string helpers (snapcast's own codec names)
+inline const char* snapcast_codec_to_str(SnapcastCodec c) {
+    switch (c) {
+        case SnapcastCodec::PCM:  return "pcm";
+        case SnapcastCodec::FLAC: return "flac";
+        case SnapcastCodec::OPUS: return "opus";
+        default:                  return "flac";
+    }
+}
+
+inline SnapcastCodec snapcast_codec_from_str(const char* s) {
+    if (s == nullptr)             return SnapcastCodec::FLAC;
+    if (strcmp(s, "pcm")  == 0)   return SnapcastCodec::PCM;
+    if (strcmp(s, "opus") == 0)   return SnapcastCodec::OPUS;
+    return SnapcastCodec::FLAC;
+}
+
 #endif // CONFIG_SCHEMA_H
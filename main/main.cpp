@@ -7,11 +7,23 @@
 #include "audio/audio_buffer.h"
 #include "audio/audio_capture.h"
 #include "audio/eq_processor.h"
+#include "audio/fir_filter.h"
+#include "audio/loudness_meter.h"
+#include "audio/audio_tap.h"
+#include "audio/spectrum_analyzer.h"
+#include "audio/wow_flutter.h"
+#include "audio/thdn_analyzer.h"
 #include "network/wifi_manager.h"
 #include "network/config_portal.h"
 #include "network/http_server.h"
+#include "network/stream_encoder.h"
+#include "network/rtp_sender.h"
+#include "network/snapcast_server.h"
+#include "network/hls_segmenter.h"
 #include "network/mqtt_service.h"
 #include "storage/nvs_config.h"
+#include "storage/eq_presets.h"
+#include "storage/fir_store.h"
 #include "config_schema.h"
 #include "system/rgb_led.h"
 
@@ -119,6 +131,38 @@ static bool init() {
     }
     ESP_LOGI(TAG, "Audio buffer initialized");
 
+    // Shared stream conversion (per output format, fed from the ring)
+    if (!StreamEncoder::init(sample_rate)) {
+        ESP_LOGW(TAG, "Stream encoder unavailable");
+    }
+    if (has_config) {
+        StreamEncoder::set_dither(loaded_config.stream_dither);
+        StreamEncoder::set_mp3_bitrate(loaded_config.mp3_bitrate_kbps);
+        StreamEncoder::set_opus(loaded_config.opus_bitrate_kbps, loaded_config.opus_frame_ms);
+    }
+
+    // RTP multicast output (its task idles until enabled)
+    if (!RtpSender::init(sample_rate)) {
+        ESP_LOGW(TAG, "RTP sender unavailable");
+    } else if (has_config && loaded_config.rtp_enabled) {
+        RtpSender::configure(true, loaded_config.rtp_group, loaded_config.rtp_port,
+                             loaded_config.rtp_bits, loaded_config.rtp_ttl);
+    }
+
+    // Snapcast server for synchronized multiroom playback (idle until enabled)
+    if (!SnapcastServer::init(sample_rate)) {
+        ESP_LOGW(TAG, "Snapcast server unavailable");
+    } else if (has_config && loaded_config.snapcast_enabled) {
+        SnapcastServer::configure(true, loaded_config.snapcast_codec, loaded_config.snapcast_buffer_ms);
+    }
+
+    // HLS segmenter for proxied many-listener setups (idle until enabled)
+    if (!HlsSegmenter::init(sample_rate)) {
+        ESP_LOGW(TAG, "HLS segmenter unavailable");
+    } else if (has_config && loaded_config.hls_enabled) {
+        HlsSegmenter::configure(true, loaded_config.hls_segment_s);
+    }
+
     // Step: I²S
     ESP_LOGI(TAG, "Initializing I²S at %lu Hz", sample_rate);
     RGBLed::step_i2s();
@@ -129,6 +173,16 @@ static bool init() {
     }
     ESP_LOGI(TAG, "I²S master initialized");
 
+    // Loudness meter runs inside the capture task, so set it up first
+    LoudnessMeter::init(sample_rate);
+
+    // Analysis tap and the (idle until requested) analyzers
+    if (AudioTap::init()) {
+        SpectrumAnalyzer::init(sample_rate);
+        WowFlutterMeter::init(sample_rate);
+        ThdnAnalyzer::init(sample_rate);
+    }
+
     // Step: Audio Capture
     RGBLed::step_audio_capture();
     vTaskDelay(pdMS_TO_TICKS(500));
@@ -149,6 +203,18 @@ static bool init() {
     ESP_LOGI(TAG, "EQ processor initialized (%u active bands, %s)",
              EQProcessor::active_band_count(),
              EQProcessor::is_enabled() ? "enabled" : "bypassed");
+
+    // Step: EQ presets (re-apply the last active preset over the config bands)
+    if (EQPresets::init() && EQPresets::apply_active()) {
+        ESP_LOGI(TAG, "EQ preset restored");
+    }
+
+    // Step: FIR correction stage (IR from the fir_ir partition, if stored)
+    if (FIRFilter::init(sample_rate)) {
+        if (FIRStore::init()) FIRStore::load_into_filter();
+        FIRFilter::set_enabled(loaded_config.fir_enabled);
+        ESP_LOGI(TAG, "FIR stage %s", FIRFilter::is_active() ? "active" : "inactive");
+    }
     
     // Step: MQTT Client (optional - only if enabled in config)
     if (has_config && loaded_config.mqtt_enabled) {
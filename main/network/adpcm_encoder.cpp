@@ -0,0 +1,89 @@
+#include "adpcm_encoder.h"
+
+static_assert((ADPCM_BLOCK_BYTES - 8) % 8 == 0, "block data must be whole 8-sample groups");
+
+// ─── IMA ADPCM tables ────────────────────────────────────────────────────────
+
+static const uint16_t STEP_TABLE[89] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+// Quantize one sample against the predictor; updates predictor and index
+// exactly as the decoder will.
+static inline uint8_t encode_sample(int32_t sample, int32_t &pred, int32_t &index) {
+    int32_t step  = STEP_TABLE[index];
+    int32_t delta = sample - pred;
+    uint8_t nib   = 0;
+    if (delta < 0) {
+        nib   = 8;
+        delta = -delta;
+    }
+
+    int32_t diff = step >> 3;
+    if (delta >= step) { nib |= 4; delta -= step; diff += step; }
+    step >>= 1;
+    if (delta >= step) { nib |= 2; delta -= step; diff += step; }
+    step >>= 1;
+    if (delta >= step) { nib |= 1; diff += step; }
+
+    pred += (nib & 8) ? -diff : diff;
+    if (pred > 32767) pred = 32767;
+    if (pred < -32768) pred = -32768;
+
+    index += INDEX_TABLE[nib];
+    if (index < 0) index = 0;
+    if (index > 88) index = 88;
+    return nib;
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+void AdpcmEncoder::init() {
+    index[0] = 0;
+    index[1] = 0;
+}
+
+size_t AdpcmEncoder::encode(const int16_t *lrlr, uint8_t *out) {
+    int32_t pred[2];
+    int32_t idx[2];
+
+    // Block header: the first sample is stored, not coded
+    for (int c = 0; c < 2; c++) {
+        pred[c] = lrlr[c];
+        idx[c]  = index[c];
+        out[c * 4 + 0] = (uint8_t)(pred[c] & 0xFF);
+        out[c * 4 + 1] = (uint8_t)((pred[c] >> 8) & 0xFF);
+        out[c * 4 + 2] = (uint8_t)idx[c];
+        out[c * 4 + 3] = 0;
+    }
+
+    uint8_t *dst = out + 8;
+    const int16_t *src = lrlr + 2;
+    for (uint32_t group = 0; group < (ADPCM_BLOCK_FRAMES - 1) / 8; group++) {
+        for (int c = 0; c < 2; c++) {
+            for (int k = 0; k < 8; k += 2) {
+                uint8_t lo = encode_sample(src[k * 2 + c], pred[c], idx[c]);
+                uint8_t hi = encode_sample(src[(k + 1) * 2 + c], pred[c], idx[c]);
+                *dst++ = (uint8_t)(lo | (hi << 4));
+            }
+        }
+        src += 16;
+    }
+
+    index[0] = (uint8_t)idx[0];
+    index[1] = (uint8_t)idx[1];
+    return ADPCM_BLOCK_BYTES;
+}
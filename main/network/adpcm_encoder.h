@@ -0,0 +1,39 @@
+#ifndef ADPCM_ENCODER_H
+#define ADPCM_ENCODER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// AdpcmEncoder: IMA ADPCM (WAVE_FORMAT_IMA_ADPCM, 0x0011) for the shared
+// stream encoder pipes.
+//
+// 4 bits per sample, stereo, in fixed blocks of ADPCM_BLOCK_BYTES
+// (Microsoft/IMA WAV layout):
+//
+//   per channel: int16 first sample, uint8 step index, uint8 0
+//   then ADPCM_BLOCK_FRAMES − 1 samples as groups of 8 per channel,
+//   4 bytes left, 4 bytes right, low nibble first
+//
+// Each block restarts the predictor at its first sample, so a listener can
+// join at any block boundary; the step index carries over between blocks.
+// The quantizer is the standard table-driven one (89 step sizes, shift-add
+// reconstruction), bit-exact with every decoder. 512-byte blocks are 505
+// frames (10.5 ms at 48 kHz): 3.95:1 against 16-bit PCM.
+//
+// Encoder state is two step indices; no scratch memory.
+
+static constexpr uint16_t ADPCM_BLOCK_BYTES  = 512;     // WAV block_align
+// Header sample plus two nibbles per byte of the per-channel data
+static constexpr uint32_t ADPCM_BLOCK_FRAMES = (ADPCM_BLOCK_BYTES - 4 * 2) * 8 / (4 * 2) + 1;  // 505
+
+struct AdpcmEncoder {
+    uint8_t index[2];       // Step index per channel (0–88)
+
+    void init();
+
+    // Encode ADPCM_BLOCK_FRAMES interleaved 16-bit stereo frames into one
+    // ADPCM_BLOCK_BYTES block. Returns ADPCM_BLOCK_BYTES.
+    size_t encode(const int16_t *lrlr, uint8_t *out);
+};
+
+#endif // ADPCM_ENCODER_H
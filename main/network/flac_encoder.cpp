@@ -0,0 +1,564 @@
+#include "flac_encoder.h"
+#include "../audio/dsp_platform.h"
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "flac_encoder";
+
+static constexpr uint32_t N = FLAC_BLOCK_FRAMES;
+
+// Largest Rice partition order: 2^order must divide the block
+static constexpr uint8_t max_partition_order() {
+    uint8_t order = 0;
+    while (order < 8 && (N % (2u << order)) == 0) order++;
+    return order;
+}
+static constexpr uint8_t MAX_PARTITION_ORDER = max_partition_order();
+
+// |qlp| < 2^11, |x| < 2^16 (side channel), 8 taps: Σ < 2^30 fits in int32
+static_assert(FLAC_QLP_PRECISION <= 12 && FLAC_MAX_LPC_ORDER <= 8, "LPC sum must fit in int32");
+static_assert(N <= 65536 && N > FLAC_MAX_LPC_ORDER, "block size out of range");
+
+// ─── CRC tables (compile time) ───────────────────────────────────────────────
+
+struct CrcTables {
+    uint8_t  crc8[256];     // Polynomial x^8 + x^2 + x + 1 (frame header)
+    uint16_t crc16[256];    // Polynomial x^16 + x^15 + x^2 + 1 (whole frame)
+};
+
+static constexpr CrcTables make_crc_tables() {
+    CrcTables t{};
+    for (int i = 0; i < 256; i++) {
+        uint8_t c8 = (uint8_t)i;
+        for (int b = 0; b < 8; b++) c8 = (uint8_t)((c8 & 0x80) ? (c8 << 1) ^ 0x07 : (c8 << 1));
+        t.crc8[i] = c8;
+
+        uint16_t c16 = (uint16_t)(i << 8);
+        for (int b = 0; b < 8; b++) c16 = (uint16_t)((c16 & 0x8000) ? (c16 << 1) ^ 0x8005 : (c16 << 1));
+        t.crc16[i] = c16;
+    }
+    return t;
+}
+
+static constexpr CrcTables CRC = make_crc_tables();
+
+static uint8_t crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) crc = CRC.crc8[crc ^ data[i]];
+    return crc;
+}
+
+static uint16_t crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; i++) crc = (uint16_t)((crc << 8) ^ CRC.crc16[(crc >> 8) ^ data[i]]);
+    return crc;
+}
+
+// ─── Bit writer (MSB first) ──────────────────────────────────────────────────
+
+struct BitWriter {
+    uint8_t *buf;
+    size_t   pos;           // Whole bytes written
+    uint64_t acc;
+    uint32_t nbits;         // Bits pending in acc (< 8 between calls)
+
+    inline void put(uint32_t value, uint32_t n) {      // n ≤ 32
+        if (n == 0) return;
+        acc    = (acc << n) | (value & (uint32_t)((1ull << n) - 1));
+        nbits += n;
+        while (nbits >= 8) {
+            nbits -= 8;
+            buf[pos++] = (uint8_t)(acc >> nbits);
+        }
+    }
+
+    inline void put_signed(int32_t value, uint32_t n) {
+        put((uint32_t)value, n);
+    }
+
+    inline void put_rice(uint32_t u, uint32_t k) {
+        uint32_t q = u >> k;
+        while (q >= 32) {
+            put(0, 32);
+            q -= 32;
+        }
+        if (q + 1 + k <= 32) {
+            put((1u << k) | (u & ((1u << k) - 1)), q + 1 + k);
+        } else {
+            put(1, q + 1);
+            put(u, k);
+        }
+    }
+
+    inline void align() {
+        if (nbits > 0) put(0, 8 - nbits);
+    }
+
+    inline uint64_t bits() const { return (uint64_t)pos * 8 + nbits; }
+};
+
+// ─── Analysis ────────────────────────────────────────────────────────────────
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+// Σ|2nd-order fixed residual|: cheap stereo-mode and order estimate
+static uint32_t fixed2_abs_sum(const int32_t *x) {
+    uint32_t sum = 0;
+    for (uint32_t i = 2; i < N; i++) {
+        int32_t e = x[i] - 2 * x[i - 1] + x[i - 2];
+        sum += (uint32_t)(e < 0 ? -e : e);
+    }
+    return sum;
+}
+
+// Fixed order 0–4 with the smallest Σ|residual|
+static uint8_t best_fixed_order(const int32_t *x) {
+    uint64_t sum[5] = {0, 0, 0, 0, 0};
+    int32_t e1p = x[3] - x[2];
+    int32_t e2p = e1p - (x[2] - x[1]);
+    int32_t e3p = e2p - ((x[2] - x[1]) - (x[1] - x[0]));
+    for (uint32_t i = 4; i < N; i++) {
+        int32_t e0 = x[i];
+        int32_t e1 = e0 - x[i - 1];
+        int32_t e2 = e1 - e1p;
+        int32_t e3 = e2 - e2p;
+        int32_t e4 = e3 - e3p;
+        sum[0] += (uint32_t)(e0 < 0 ? -e0 : e0);
+        sum[1] += (uint32_t)(e1 < 0 ? -e1 : e1);
+        sum[2] += (uint32_t)(e2 < 0 ? -e2 : e2);
+        sum[3] += (uint32_t)(e3 < 0 ? -e3 : e3);
+        sum[4] += (uint32_t)(e4 < 0 ? -e4 : e4);
+        e1p = e1;
+        e2p = e2;
+        e3p = e3;
+    }
+    uint8_t best = 0;
+    for (uint8_t o = 1; o <= FLAC_MAX_FIXED_ORDER; o++) {
+        if (sum[o] < sum[best]) best = o;
+    }
+    return best;
+}
+
+// Zigzag-coded fixed residual of samples order … N−1 into u
+static void fixed_residual(const int32_t *x, uint8_t order, uint32_t *u) {
+    for (uint32_t i = order; i < N; i++) {
+        int32_t p;
+        switch (order) {
+            case 0:  p = 0; break;
+            case 1:  p = x[i - 1]; break;
+            case 2:  p = 2 * x[i - 1] - x[i - 2]; break;
+            case 3:  p = 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3]; break;
+            default: p = 4 * x[i - 1] - 6 * x[i - 2] + 4 * x[i - 3] - x[i - 4]; break;
+        }
+        u[i - order] = zigzag(x[i] - p);
+    }
+}
+
+struct LpcPlan {
+    uint8_t order;          // 0 = no usable LPC
+    int8_t  shift;
+    int32_t qlp[FLAC_MAX_LPC_ORDER];
+};
+
+// Windowed autocorrelation → Levinson-Durbin → order by expected bits →
+// quantized coefficients
+static void plan_lpc(const int32_t *x, const float *win, float *wx, uint8_t bps, LpcPlan *plan) {
+    plan->order = 0;
+
+    for (uint32_t i = 0; i < N; i++) wx[i] = (float)x[i] * win[i];
+
+    float autoc[FLAC_MAX_LPC_ORDER + 1];
+    for (uint8_t lag = 0; lag <= FLAC_MAX_LPC_ORDER; lag++) {
+        float s = 0.0f;
+        for (uint32_t i = lag; i < N; i++) s += wx[i] * wx[i - lag];
+        autoc[lag] = s;
+    }
+    if (autoc[0] <= 0.0f) return;
+
+    // Levinson-Durbin; lp[o][j] predicts x[i] from x[i−1−j] at order o + 1
+    float lp[FLAC_MAX_LPC_ORDER][FLAC_MAX_LPC_ORDER];
+    float lerr[FLAC_MAX_LPC_ORDER];
+    float a[FLAC_MAX_LPC_ORDER];
+    float err = autoc[0];
+    uint8_t max_order = FLAC_MAX_LPC_ORDER;
+    for (uint8_t i = 0; i < FLAC_MAX_LPC_ORDER; i++) {
+        float r = -autoc[i + 1];
+        for (uint8_t j = 0; j < i; j++) r -= a[j] * autoc[i - j];
+        r /= err;
+
+        a[i] = r;
+        for (uint8_t j = 0; j < i / 2; j++) {
+            float t = a[j];
+            a[j]         += r * a[i - 1 - j];
+            a[i - 1 - j] += r * t;
+        }
+        if (i & 1) a[i / 2] += a[i / 2] * r;
+
+        err *= 1.0f - r * r;
+        for (uint8_t j = 0; j <= i; j++) lp[i][j] = -a[j];
+        lerr[i] = err;
+        if (err <= 0.0f) {
+            max_order = i + 1;
+            break;
+        }
+    }
+
+    // Expected residual bits (libFLAC estimate) plus coefficient cost
+    const float error_scale = 0.5f / (float)N;
+    float best_bits = 0.0f;
+    uint8_t order = 0;
+    for (uint8_t o = 1; o <= max_order; o++) {
+        float e = lerr[o - 1] * error_scale;
+        float per_sample = e > 1.0f ? 0.5f * log2f(e) : 0.0f;
+        float bits = per_sample * (float)(N - o) + (float)o * (FLAC_QLP_PRECISION + bps);
+        if (order == 0 || bits < best_bits) {
+            best_bits = bits;
+            order     = o;
+        }
+    }
+
+    // Quantize with error feedback so rounding errors do not accumulate
+    const float *c = lp[order - 1];
+    float cmax = 0.0f;
+    for (uint8_t j = 0; j < order; j++) {
+        float m = fabsf(c[j]);
+        if (m > cmax) cmax = m;
+    }
+    if (cmax <= 0.0f) return;
+
+    int exp2;
+    frexpf(cmax, &exp2);
+    int shift = (FLAC_QLP_PRECISION - 1) - exp2;
+    if (shift > 15) shift = 15;
+    if (shift < 0) return;          // Coefficients too large for the precision
+
+    const int32_t qmax = (1 << (FLAC_QLP_PRECISION - 1)) - 1;
+    const int32_t qmin = -(1 << (FLAC_QLP_PRECISION - 1));
+    const float scale = (float)(1 << shift);
+    float qerr = 0.0f;
+    for (uint8_t j = 0; j < order; j++) {
+        qerr += c[j] * scale;
+        int32_t q = (int32_t)lrintf(qerr);
+        if (q > qmax) q = qmax;
+        if (q < qmin) q = qmin;
+        qerr -= (float)q;
+        plan->qlp[j] = q;
+    }
+    plan->order = order;
+    plan->shift = (int8_t)shift;
+}
+
+// Zigzag-coded LPC residual. False if a residual is too large to Rice-code.
+static bool lpc_residual(const int32_t *x, const LpcPlan &plan, uint32_t *u) {
+    const uint8_t order = plan.order;
+    for (uint32_t i = order; i < N; i++) {
+        int32_t sum = 0;
+        for (uint8_t j = 0; j < order; j++) sum += plan.qlp[j] * x[i - 1 - j];
+        int32_t r = x[i] - (sum >> plan.shift);
+        if (r > (1 << 29) || r < -(1 << 29)) return false;
+        u[i - order] = zigzag(r);
+    }
+    return true;
+}
+
+struct RicePlan {
+    uint8_t porder;
+    uint8_t method;                                 // 0: 4-bit, 1: 5-bit parameters
+    uint8_t param[1 << MAX_PARTITION_ORDER];
+};
+
+static inline uint64_t rice_bits(uint64_t sum, uint32_t count, uint8_t k) {
+    return (uint64_t)count * (1 + k) + (sum >> k);
+}
+
+static uint8_t rice_param(uint64_t sum, uint32_t count) {
+    if (count == 0 || sum < count) return 0;
+    uint8_t k = 0;
+    uint64_t mean = sum / count;
+    while ((mean >> (k + 1)) != 0) k++;
+    // floor(log2(mean)) or one more, whichever is smaller
+    if (k < 30 && rice_bits(sum, count, k + 1) < rice_bits(sum, count, k)) k++;
+    return k > 30 ? 30 : k;
+}
+
+// Choose partition order and parameters from per-partition sums. Returns the
+// estimated residual section size in bits.
+static uint64_t plan_rice(const uint32_t *u, uint8_t pred_order, RicePlan *plan) {
+    // Finest partition order whose first partition still holds a sample
+    uint8_t top = MAX_PARTITION_ORDER;
+    while (top > 0 && (N >> top) <= pred_order) top--;
+
+    uint64_t sums[1 << MAX_PARTITION_ORDER];
+    const uint32_t psize = N >> top;
+    uint32_t idx = 0;
+    for (uint32_t p = 0; p < (1u << top); p++) {
+        uint32_t count = p == 0 ? psize - pred_order : psize;
+        uint64_t s = 0;
+        for (uint32_t i = 0; i < count; i++) s += u[idx++];
+        sums[p] = s;
+    }
+
+    uint64_t best = UINT64_MAX;
+    for (int order = top; order >= 0; order--) {
+        const uint32_t parts = 1u << order;
+        const uint32_t size  = N >> order;
+        uint64_t bits = 0;
+        uint8_t  params[1 << MAX_PARTITION_ORDER];
+        uint8_t  method = 0;
+        for (uint32_t p = 0; p < parts; p++) {
+            uint32_t count = p == 0 ? size - pred_order : size;
+            uint8_t k = rice_param(sums[p], count);
+            if (k > 14) method = 1;
+            params[p] = k;
+            bits += rice_bits(sums[p], count, k);
+        }
+        bits += (uint64_t)parts * (method ? 5 : 4);
+        if (bits < best) {
+            best          = bits;
+            plan->porder  = (uint8_t)order;
+            plan->method  = method;
+            memcpy(plan->param, params, parts);
+        }
+        // Merge pairs for the next coarser order
+        for (uint32_t p = 0; p < parts / 2; p++) sums[p] = sums[2 * p] + sums[2 * p + 1];
+    }
+    return best + 2 + 4;    // Method and partition order fields
+}
+
+static void write_residual(BitWriter &bw, const uint32_t *u, uint8_t pred_order, const RicePlan &plan) {
+    bw.put(plan.method, 2);
+    bw.put(plan.porder, 4);
+    const uint32_t parts = 1u << plan.porder;
+    const uint32_t size  = N >> plan.porder;
+    const uint32_t pbits = plan.method ? 5 : 4;
+    uint32_t idx = 0;
+    for (uint32_t p = 0; p < parts; p++) {
+        uint32_t count = p == 0 ? size - pred_order : size;
+        uint8_t  k     = plan.param[p];
+        bw.put(k, pbits);
+        for (uint32_t i = 0; i < count; i++) bw.put_rice(u[idx++], k);
+    }
+}
+
+// Analyse and write one subframe
+static void encode_subframe(BitWriter &bw, const int32_t *x, uint8_t bps,
+                            uint32_t *u, const float *win, float *wx) {
+    // CONSTANT: digital silence and DC
+    bool constant = true;
+    for (uint32_t i = 1; i < N && constant; i++) constant = x[i] == x[0];
+    if (constant) {
+        bw.put(0x00, 8);                    // Pad 0, type 000000, no wasted bits
+        bw.put_signed(x[0], bps);
+        return;
+    }
+
+    const uint64_t verbatim_bits = (uint64_t)N * bps;
+
+    // FIXED
+    RicePlan fixed_rice;
+    uint8_t  fixed_order = best_fixed_order(x);
+    fixed_residual(x, fixed_order, u);
+    uint64_t fixed_bits = (uint64_t)fixed_order * bps + plan_rice(u, fixed_order, &fixed_rice);
+
+    // LPC (overwrites u; the fixed residual is recomputed if it wins)
+    LpcPlan  lpc;
+    RicePlan lpc_rice;
+    uint64_t lpc_bits = UINT64_MAX;
+    plan_lpc(x, win, wx, bps, &lpc);
+    if (lpc.order > 0 && lpc_residual(x, lpc, u)) {
+        lpc_bits = (uint64_t)lpc.order * (bps + FLAC_QLP_PRECISION) + 4 + 5 +
+                   plan_rice(u, lpc.order, &lpc_rice);
+    }
+
+    const size_t   start_pos   = bw.pos;
+    const uint64_t start_acc   = bw.acc;
+    const uint32_t start_nbits = bw.nbits;
+    const uint64_t start_bits  = bw.bits();
+
+    if (lpc_bits < fixed_bits && lpc_bits < verbatim_bits) {
+        bw.put(0x40 | ((lpc.order - 1) << 1), 8);     // Type 1xxxxx: LPC order − 1
+        for (uint8_t i = 0; i < lpc.order; i++) bw.put_signed(x[i], bps);
+        bw.put(FLAC_QLP_PRECISION - 1, 4);
+        bw.put_signed(lpc.shift, 5);
+        for (uint8_t j = 0; j < lpc.order; j++) bw.put_signed(lpc.qlp[j], FLAC_QLP_PRECISION);
+        write_residual(bw, u, lpc.order, lpc_rice);
+    } else if (fixed_bits < verbatim_bits) {
+        fixed_residual(x, fixed_order, u);
+        bw.put(0x10 | (fixed_order << 1), 8);         // Type 001xxx: fixed order
+        for (uint8_t i = 0; i < fixed_order; i++) bw.put_signed(x[i], bps);
+        write_residual(bw, u, fixed_order, fixed_rice);
+    }
+
+    // VERBATIM when chosen, or when the estimate was too optimistic
+    if (bw.bits() == start_bits || bw.bits() - start_bits > 8 + verbatim_bits) {
+        bw.pos   = start_pos;
+        bw.acc   = start_acc;
+        bw.nbits = start_nbits;
+        bw.put(0x02, 8);                    // Type 000001
+        for (uint32_t i = 0; i < N; i++) bw.put_signed(x[i], bps);
+    }
+}
+
+// ─── Frame header fields ─────────────────────────────────────────────────────
+
+static uint8_t rate_code(uint32_t rate) {
+    switch (rate) {
+        case 22050: return 6;
+        case 24000: return 5;
+        case 32000: return 7;
+        case 44100: return 9;
+        case 48000: return 10;
+        case 88200: return 8;
+        case 96000: return 11;
+        default:    return 0;       // From STREAMINFO
+    }
+}
+
+static void put_utf8(BitWriter &bw, uint32_t v) {
+    if (v < 0x80) {
+        bw.put(v, 8);
+        return;
+    }
+    uint32_t bytes = v < 0x800 ? 2 : v < 0x10000 ? 3 : v < 0x200000 ? 4 : v < 0x4000000 ? 5 : 6;
+    uint32_t lead  = (0xFF00u >> bytes) & 0xFF;
+    bw.put(lead | (v >> (6 * (bytes - 1))), 8);
+    for (int i = (int)bytes - 2; i >= 0; i--) bw.put(0x80 | ((v >> (6 * i)) & 0x3F), 8);
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool FlacEncoder::init(uint32_t rate) {
+    sample_rate  = rate;
+    frame_number = 0;
+
+    const size_t work_bytes   = 5 * N * sizeof(int32_t);
+    const size_t window_bytes = 2 * N * sizeof(float);
+    work   = (int32_t *)heap_caps_malloc(work_bytes, MALLOC_CAP_INTERNAL);
+    if (work == nullptr) work = (int32_t *)heap_caps_malloc(work_bytes, MALLOC_CAP_SPIRAM);
+    window = (float *)heap_caps_malloc(window_bytes, MALLOC_CAP_INTERNAL);
+    if (window == nullptr) window = (float *)heap_caps_malloc(window_bytes, MALLOC_CAP_SPIRAM);
+    if (work == nullptr || window == nullptr) {
+        ESP_LOGE(TAG, "No memory for FLAC scratch (%u bytes)", (unsigned)(work_bytes + window_bytes));
+        deinit();
+        return false;
+    }
+
+    // Tukey(0.5): cosine tapers over the first and last quarter
+    const uint32_t taper = N / 4;
+    for (uint32_t i = 0; i < N; i++) {
+        float w = 1.0f;
+        if (i < taper) {
+            w = 0.5f - 0.5f * cosf((float)M_PI * (float)i / (float)taper);
+        } else if (i >= N - taper) {
+            w = 0.5f - 0.5f * cosf((float)M_PI * (float)(N - 1 - i) / (float)taper);
+        }
+        window[i] = w;
+    }
+
+    ESP_LOGI(TAG, "FLAC %lu Hz: %lu-frame blocks, LPC ≤ %u, fixed ≤ %u, Rice partitions ≤ %u",
+             (unsigned long)rate, (unsigned long)N, FLAC_MAX_LPC_ORDER, FLAC_MAX_FIXED_ORDER,
+             MAX_PARTITION_ORDER);
+    return true;
+}
+
+void FlacEncoder::deinit() {
+    if (work != nullptr) heap_caps_free(work);
+    if (window != nullptr) heap_caps_free(window);
+    work   = nullptr;
+    window = nullptr;
+}
+
+size_t FlacEncoder::stream_header(uint32_t rate, uint8_t *out, size_t size) {
+    if (out == nullptr || size < FLAC_STREAM_HEADER_BYTES) return 0;
+
+    memset(out, 0, FLAC_STREAM_HEADER_BYTES);
+    BitWriter bw = {out, 0, 0, 0};
+    bw.put(0x664C6143, 32);             // "fLaC"
+    bw.put(0x80, 8);                    // Last metadata block, type 0 (STREAMINFO)
+    bw.put(34, 24);
+    bw.put(N, 16);                      // Min block size
+    bw.put(N, 16);                      // Max block size
+    bw.put(0, 24);                      // Min frame size (unknown)
+    bw.put(0, 24);                      // Max frame size (unknown)
+    bw.put(rate, 20);
+    bw.put(2 - 1, 3);                   // Channels − 1
+    bw.put(16 - 1, 5);                  // Bits per sample − 1
+    bw.put(0, 4);                       // Total samples (36 bits): unknown
+    bw.put(0, 32);
+    // MD5 of the audio: unknown (zeros, already cleared)
+    return FLAC_STREAM_HEADER_BYTES;
+}
+
+size_t FlacEncoder::encode(const int16_t *lrlr, uint8_t *out) {
+    if (work == nullptr || out == nullptr) return 0;
+
+    int32_t  *left  = work;
+    int32_t  *right = work + N;
+    int32_t  *mid   = work + 2 * N;
+    int32_t  *side  = work + 3 * N;
+    uint32_t *u     = (uint32_t *)(work + 4 * N);
+    float    *wx    = window + N;
+
+    for (uint32_t i = 0; i < N; i++) {
+        int32_t l = lrlr[i * 2 + 0];
+        int32_t r = lrlr[i * 2 + 1];
+        left[i]  = l;
+        right[i] = r;
+        mid[i]   = (l + r) >> 1;
+        side[i]  = l - r;
+    }
+
+    // Channel assignment: 1 independent, 8 left/side, 9 side/right, 10 mid/side
+    const uint32_t el = fixed2_abs_sum(left);
+    const uint32_t er = fixed2_abs_sum(right);
+    const uint32_t em = fixed2_abs_sum(mid);
+    const uint32_t es = fixed2_abs_sum(side);
+    uint8_t assignment = 1;
+    uint64_t best = (uint64_t)el + er;
+    if ((uint64_t)el + es < best) { best = (uint64_t)el + es; assignment = 8; }
+    if ((uint64_t)es + er < best) { best = (uint64_t)es + er; assignment = 9; }
+    if ((uint64_t)em + es < best) { best = (uint64_t)em + es; assignment = 10; }
+
+    BitWriter bw = {out, 0, 0, 0};
+    bw.put(0xFFF8, 16);                         // Sync, fixed block size
+    bw.put(N <= 256 ? 6 : 7, 4);                // Block size at end of header
+    bw.put(rate_code(sample_rate), 4);
+    bw.put(assignment, 4);
+    bw.put(4, 3);                               // 16 bits per sample
+    bw.put(0, 1);
+    put_utf8(bw, frame_number);
+    if (N <= 256) {
+        bw.put(N - 1, 8);
+    } else {
+        bw.put(N - 1, 16);
+    }
+    bw.put(crc8(out, bw.pos), 8);
+
+    switch (assignment) {
+        case 8:
+            encode_subframe(bw, left, 16, u, window, wx);
+            encode_subframe(bw, side, 17, u, window, wx);
+            break;
+        case 9:
+            encode_subframe(bw, side, 17, u, window, wx);
+            encode_subframe(bw, right, 16, u, window, wx);
+            break;
+        case 10:
+            encode_subframe(bw, mid, 16, u, window, wx);
+            encode_subframe(bw, side, 17, u, window, wx);
+            break;
+        default:
+            encode_subframe(bw, left, 16, u, window, wx);
+            encode_subframe(bw, right, 16, u, window, wx);
+            break;
+    }
+
+    bw.align();
+    uint16_t crc = crc16(out, bw.pos);
+    bw.put(crc, 16);
+
+    frame_number = (frame_number + 1) & 0x7FFFFFFF;
+    return bw.pos;
+}
@@ -0,0 +1,649 @@
+#include "hls_segmenter.h"
+#include "stream_encoder.h"
+#include "flac_encoder.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+static const char *TAG = "hls";
+
+static constexpr uint32_t MAX_RATE           = 96000;
+static constexpr uint32_t MAX_SEGMENT_FRAMES = HLS_MAX_SEGMENT_S * MAX_RATE / FLAC_BLOCK_FRAMES;  // FLAC frames
+static constexpr size_t   MOOF_FIXED_BYTES   = 92;      // moof without the trun sample sizes
+static constexpr size_t   MDAT_HEADER_BYTES  = 8;
+
+static_assert(FLAC_MAX_FRAME_BYTES <= UINT16_MAX, "sample sizes are kept as uint16_t");
+static_assert(HLS_PLAYLIST_SEGMENTS + 2 <= HLS_CACHE_SEGMENTS, "a slot to fill and one to spare");
+
+struct HlsSettings {
+    bool    enabled;
+    uint8_t segment_s;
+};
+
+// One cached segment. The frames go in at `reserve`; on completion the moof
+// and mdat header are written right in front of them, from `offset`.
+struct Slot {
+    uint8_t *mem;
+    bool     ready;                 // Complete: may be listed and served
+    bool     discontinuity;         // Follows a capture gap
+    uint8_t  readers;               // Pinned by acquire()
+    uint32_t seq;
+    uint32_t dsn;                   // Discontinuity sequence number
+    uint32_t frames;                // FLAC frames (samples)
+    size_t   offset;
+    size_t   bytes;                 // moof + mdat
+};
+
+// Settings from configure(), picked up by the task
+static SemaphoreHandle_t s_mutex   = nullptr;   // Settings, slots, stats
+static TaskHandle_t      s_task    = nullptr;
+static HlsSettings       s_pending = {};
+static std::atomic<bool> s_changed{false};
+static uint32_t          s_capture_rate = 48000;
+
+// Session state (segmenter task; slot metadata under s_mutex)
+static std::atomic<bool> s_running{false};
+static HlsSettings        s_active = {};
+static uint32_t           s_session;
+static Slot               s_slots[HLS_CACHE_SEGMENTS];
+static StreamSubscription s_sub = {};
+static uint32_t           s_segment_frames;     // FLAC frames per segment
+static size_t             s_reserve;            // Largest moof + mdat header
+static size_t             s_slot_bytes;
+static int                s_fill = -1;          // Slot being filled
+static size_t             s_fill_bytes;         // Frame bytes in it
+static uint32_t           s_fill_frames;
+static uint64_t           s_fill_first;         // Capture frame of its first FLAC frame
+static bool               s_started;            // A frame has been read this session
+static uint64_t           s_base_frame;         // Capture frame at media time 0
+static uint64_t           s_next_frame;         // Expected capture frame of the next read
+static bool               s_gap;                // The next segment follows a gap
+static uint32_t           s_next_seq;
+static uint32_t           s_dsn;
+static uint32_t           s_segment_cycles;     // Accumulated for the segment being filled
+static HlsStats           s_stats = {};
+
+static uint16_t s_sizes[MAX_SEGMENT_FRAMES];
+static uint8_t  s_discard[FLAC_MAX_FRAME_BYTES];
+
+// ─── ISO BMFF boxes ──────────────────────────────────────────────────────────
+
+// Big-endian writer; writes past `cap` are dropped and clear `ok`
+struct BoxWriter {
+    uint8_t *buf;
+    size_t   cap;
+    size_t   pos;
+    bool     ok;
+
+    void u8(uint8_t v) {
+        if (pos < cap) buf[pos] = v;
+        else ok = false;
+        pos++;
+    }
+    void u16(uint16_t v) { u8((uint8_t)(v >> 8)); u8((uint8_t)v); }
+    void u32(uint32_t v) { u16((uint16_t)(v >> 16)); u16((uint16_t)v); }
+    void u64(uint64_t v) { u32((uint32_t)(v >> 32)); u32((uint32_t)v); }
+    void zeros(size_t n) { while (n--) u8(0); }
+    void bytes(const void *p, size_t n) {
+        for (size_t i = 0; i < n; i++) u8(((const uint8_t *)p)[i]);
+    }
+    size_t open(const char *type) {
+        const size_t at = pos;
+        u32(0);
+        bytes(type, 4);
+        return at;
+    }
+    size_t open_full(const char *type, uint8_t version, uint32_t flags) {
+        const size_t at = open(type);
+        u32(((uint32_t)version << 24) | flags);
+        return at;
+    }
+    void close(size_t at) {
+        if (at + 4 > cap) return;
+        const uint32_t size = (uint32_t)(pos - at);
+        buf[at]     = (uint8_t)(size >> 24);
+        buf[at + 1] = (uint8_t)(size >> 16);
+        buf[at + 2] = (uint8_t)(size >> 8);
+        buf[at + 3] = (uint8_t)size;
+    }
+    void matrix() {
+        static const uint32_t unity[9] = {0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000};
+        for (uint32_t v : unity) u32(v);
+    }
+};
+
+static size_t moof_bytes(uint32_t frames) {
+    return MOOF_FIXED_BYTES + 4 * (size_t)frames;
+}
+
+// ftyp + moov: one audio track, timescale = sample rate, a 'fLaC' sample
+// entry whose dfLa box carries the STREAMINFO block, and trex defaults
+// (one FLAC_BLOCK_FRAMES frame per sample) for the fragments
+static size_t write_init(uint8_t *out, size_t size, uint32_t rate) {
+    uint8_t streaminfo[FLAC_STREAM_HEADER_BYTES];
+    if (FlacEncoder::stream_header(rate, streaminfo, sizeof(streaminfo)) == 0) return 0;
+
+    BoxWriter w = {out, size, 0, true};
+    size_t ftyp = w.open("ftyp");
+    w.bytes("iso6", 4);
+    w.u32(0);
+    w.bytes("iso6mp41", 8);
+    w.close(ftyp);
+
+    size_t moov = w.open("moov");
+    size_t mvhd = w.open_full("mvhd", 0, 0);
+    w.u32(0);                               // Creation time
+    w.u32(0);                               // Modification time
+    w.u32(rate);                            // Timescale
+    w.u32(0);                               // Duration: fragmented
+    w.u32(0x00010000);                      // Rate 1.0
+    w.u16(0x0100);                          // Volume 1.0
+    w.zeros(10);
+    w.matrix();
+    w.zeros(24);
+    w.u32(2);                               // Next track ID
+    w.close(mvhd);
+
+    size_t trak = w.open("trak");
+    size_t tkhd = w.open_full("tkhd", 0, 0x000003);    // Enabled, in movie
+    w.u32(0);
+    w.u32(0);
+    w.u32(1);                               // Track ID
+    w.u32(0);
+    w.u32(0);                               // Duration
+    w.zeros(8);
+    w.u16(0);                               // Layer
+    w.u16(0);                               // Alternate group
+    w.u16(0x0100);                          // Volume
+    w.u16(0);
+    w.matrix();
+    w.u32(0);                               // Width, height: audio
+    w.u32(0);
+    w.close(tkhd);
+
+    size_t mdia = w.open("mdia");
+    size_t mdhd = w.open_full("mdhd", 0, 0);
+    w.u32(0);
+    w.u32(0);
+    w.u32(rate);
+    w.u32(0);
+    w.u16(0x55C4);                          // Language "und"
+    w.u16(0);
+    w.close(mdhd);
+    size_t hdlr = w.open_full("hdlr", 0, 0);
+    w.u32(0);
+    w.bytes("soun", 4);
+    w.zeros(12);
+    w.bytes("SoundHandler", 13);            // With its terminating zero
+    w.close(hdlr);
+
+    size_t minf = w.open("minf");
+    size_t smhd = w.open_full("smhd", 0, 0);
+    w.u16(0);                               // Balance
+    w.u16(0);
+    w.close(smhd);
+    size_t dinf = w.open("dinf");
+    size_t dref = w.open_full("dref", 0, 0);
+    w.u32(1);
+    w.close(w.open_full("url ", 0, 0x000001));      // Media in this file
+    w.close(dref);
+    w.close(dinf);
+
+    size_t stbl = w.open("stbl");
+    size_t stsd = w.open_full("stsd", 0, 0);
+    w.u32(1);
+    size_t flac = w.open("fLaC");
+    w.zeros(6);
+    w.u16(1);                               // Data reference index
+    w.zeros(8);
+    w.u16(2);                               // Channels
+    w.u16(16);                              // Sample size
+    w.u32(0);
+    w.u32(rate <= 0xFFFF ? rate << 16 : 0); // 16.16; 0 above 65535 Hz (STREAMINFO has it)
+    size_t dfla = w.open_full("dfLa", 0, 0);
+    w.bytes(streaminfo + 4, FLAC_STREAM_HEADER_BYTES - 4);   // Without "fLaC"; last-block flag set
+    w.close(dfla);
+    w.close(flac);
+    w.close(stsd);
+    // Empty sample tables: the samples are in the fragments
+    size_t stts = w.open_full("stts", 0, 0);
+    w.u32(0);
+    w.close(stts);
+    size_t stsc = w.open_full("stsc", 0, 0);
+    w.u32(0);
+    w.close(stsc);
+    size_t stsz = w.open_full("stsz", 0, 0);
+    w.u32(0);
+    w.u32(0);
+    w.close(stsz);
+    size_t stco = w.open_full("stco", 0, 0);
+    w.u32(0);
+    w.close(stco);
+    w.close(stbl);
+    w.close(minf);
+    w.close(mdia);
+    w.close(trak);
+
+    size_t mvex = w.open("mvex");
+    size_t trex = w.open_full("trex", 0, 0);
+    w.u32(1);                               // Track ID
+    w.u32(1);                               // Sample description index
+    w.u32(FLAC_BLOCK_FRAMES);               // Sample duration
+    w.u32(0);                               // Sample size: per sample in trun
+    w.u32(0);                               // Sample flags: every sample is a sync sample
+    w.close(trex);
+    w.close(mvex);
+    w.close(moov);
+
+    return w.ok ? w.pos : 0;
+}
+
+// moof + mdat header for `frames` samples whose sizes are in s_sizes, ending
+// exactly where the frame data begins
+static void write_moof(uint8_t *out, uint32_t seq, uint64_t decode_time, uint32_t frames, size_t data_bytes) {
+    const size_t moof_len = moof_bytes(frames);
+    BoxWriter w = {out, moof_len + MDAT_HEADER_BYTES, 0, true};
+    size_t moof = w.open("moof");
+    size_t mfhd = w.open_full("mfhd", 0, 0);
+    w.u32(seq + 1);                         // Starts at 1
+    w.close(mfhd);
+    size_t traf = w.open("traf");
+    size_t tfhd = w.open_full("tfhd", 0, 0x020008);    // default-base-is-moof, default duration
+    w.u32(1);
+    w.u32(FLAC_BLOCK_FRAMES);
+    w.close(tfhd);
+    size_t tfdt = w.open_full("tfdt", 1, 0);
+    w.u64(decode_time);
+    w.close(tfdt);
+    size_t trun = w.open_full("trun", 0, 0x000201);    // data offset, sample sizes
+    w.u32(frames);
+    w.u32((uint32_t)(moof_len + MDAT_HEADER_BYTES));   // From the moof to the first sample
+    for (uint32_t i = 0; i < frames; i++) w.u32(s_sizes[i]);
+    w.close(trun);
+    w.close(traf);
+    w.close(moof);
+    w.u32((uint32_t)(MDAT_HEADER_BYTES + data_bytes));
+    w.bytes("mdat", 4);
+}
+
+// ─── Segments ────────────────────────────────────────────────────────────────
+
+// Slot for the next segment: empty, or the oldest complete one that is
+// neither listed nor pinned. -1 if every candidate is pinned.
+static int claim_slot() {
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int pick = -1;
+    for (int i = 0; i < HLS_CACHE_SEGMENTS; i++) {
+        Slot &s = s_slots[i];
+        if (s.readers > 0) continue;
+        if (!s.ready) {
+            pick = i;
+            break;
+        }
+        if (s_next_seq - s.seq <= HLS_PLAYLIST_SEGMENTS) continue;   // Listed
+        if (pick < 0 || s.seq < s_slots[pick].seq) pick = i;
+    }
+    if (pick >= 0 && s_slots[pick].ready) {
+        s_slots[pick].ready = false;
+        s_stats.cached--;
+    }
+    xSemaphoreGive(s_mutex);
+    return pick;
+}
+
+// Package the filled slot and publish it
+static void finish_segment() {
+    Slot &s = s_slots[s_fill];
+    const uint32_t t0 = esp_cpu_get_cycle_count();
+    const size_t offset = s_reserve - moof_bytes(s_fill_frames) - MDAT_HEADER_BYTES;
+    write_moof(s.mem + offset, s_next_seq, s_fill_first - s_base_frame, s_fill_frames, s_fill_bytes);
+    s_segment_cycles += esp_cpu_get_cycle_count() - t0;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_gap) {
+        s_dsn++;
+        s_stats.discontinuities++;
+    }
+    s.discontinuity = s_gap;
+    s.dsn           = s_dsn;
+    s.seq           = s_next_seq++;
+    s.frames        = s_fill_frames;
+    s.offset        = offset;
+    s.bytes         = s_reserve - offset + s_fill_bytes;
+    s.ready         = true;
+    s_stats.sequence = s_next_seq;
+    s_stats.cached++;
+    const uint32_t bytes = (uint32_t)s.bytes;
+    s_stats.segment_bytes_avg = s_stats.segment_bytes_avg == 0
+                                    ? bytes
+                                    : s_stats.segment_bytes_avg - (s_stats.segment_bytes_avg >> 3) + (bytes >> 3);
+    if (bytes > s_stats.segment_bytes_max) s_stats.segment_bytes_max = bytes;
+    s_stats.package_cycles_avg = s_stats.package_cycles_avg == 0
+                                     ? s_segment_cycles
+                                     : s_stats.package_cycles_avg - (s_stats.package_cycles_avg >> 3) +
+                                           (s_segment_cycles >> 3);
+    xSemaphoreGive(s_mutex);
+
+    ESP_LOGD(TAG, "Segment %lu: %lu frames, %u bytes", (unsigned long)s.seq, (unsigned long)s.frames,
+             (unsigned)s.bytes);
+    s_fill           = -1;
+    s_gap            = false;
+    s_segment_cycles = 0;
+}
+
+// Move everything the pipe has into the slot being filled
+static void pump() {
+    for (;;) {
+        if (s_fill < 0) {
+            s_fill = claim_slot();
+            s_fill_bytes  = 0;
+            s_fill_frames = 0;
+        }
+
+        const uint32_t t0 = esp_cpu_get_cycle_count();
+        uint8_t *dst = s_fill >= 0 ? s_slots[s_fill].mem + s_reserve + s_fill_bytes : s_discard;
+        uint64_t frame = 0;
+        const size_t len = StreamEncoder::read_frames(&s_sub, dst, FLAC_MAX_FRAME_BYTES, &frame);
+        s_segment_cycles += esp_cpu_get_cycle_count() - t0;
+        if (len == 0) return;
+
+        if (!s_started) {
+            s_started    = true;
+            s_base_frame = frame;
+        } else if (frame != s_next_frame) {
+            // Lapped: end the segment before this frame, which then starts
+            // the next one
+            if (s_fill >= 0 && s_fill_frames > 0) {
+                finish_segment();
+                s_fill = claim_slot();
+                s_fill_bytes  = 0;
+                s_fill_frames = 0;
+                if (s_fill >= 0) memmove(s_slots[s_fill].mem + s_reserve, dst, len);
+                dst = s_fill >= 0 ? s_slots[s_fill].mem + s_reserve : s_discard;
+            }
+            s_gap = true;
+        }
+        s_next_frame = frame + FLAC_BLOCK_FRAMES;
+
+        if (s_fill < 0) {
+            // Every spare slot is being sent: this frame is lost
+            s_stats.dropped_frames++;
+            s_gap = true;
+            continue;
+        }
+        if (s_fill_frames == 0) s_fill_first = frame;
+        s_sizes[s_fill_frames++] = (uint16_t)len;
+        s_fill_bytes += len;
+        if (s_fill_frames == s_segment_frames) finish_segment();
+    }
+}
+
+// ─── Session ─────────────────────────────────────────────────────────────────
+
+static void free_slots() {
+    for (auto &s : s_slots) {
+        heap_caps_free(s.mem);
+        s = {};
+    }
+}
+
+static bool start_session(const HlsSettings &cfg) {
+    if (s_capture_rate > MAX_RATE) {
+        ESP_LOGE(TAG, "HLS not available at %lu Hz", (unsigned long)s_capture_rate);
+        return false;
+    }
+    const uint32_t frames = (cfg.segment_s * s_capture_rate + FLAC_BLOCK_FRAMES / 2) / FLAC_BLOCK_FRAMES;
+    const size_t reserve  = moof_bytes(frames) + MDAT_HEADER_BYTES;
+    const size_t bytes    = reserve + (size_t)frames * FLAC_MAX_FRAME_BYTES;
+    for (auto &s : s_slots) {
+        s = {};
+        s.mem = (uint8_t *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        if (s.mem == nullptr) {
+            ESP_LOGE(TAG, "No memory for the segment cache (%u × %u bytes)", HLS_CACHE_SEGMENTS, (unsigned)bytes);
+            free_slots();
+            return false;
+        }
+    }
+    const StreamFormat flac = {StreamCodec::FLAC, s_capture_rate, 2};
+    if (!StreamEncoder::subscribe(flac, &s_sub)) {
+        ESP_LOGE(TAG, "No FLAC encoder pipe for HLS");
+        free_slots();
+        return false;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_active         = cfg;
+    s_session        = esp_random();
+    s_segment_frames = frames;
+    s_reserve        = reserve;
+    s_slot_bytes     = bytes;
+    s_fill           = -1;
+    s_started        = false;
+    s_gap            = false;
+    s_next_seq       = 0;
+    s_dsn            = 0;
+    s_segment_cycles = 0;
+    s_stats          = {};
+    s_running.store(true, std::memory_order_release);
+    xSemaphoreGive(s_mutex);
+
+    ESP_LOGI(TAG, "HLS session %08lx: %u s FLAC segments (%lu frames), cache %u × %u KB",
+             (unsigned long)s_session, cfg.segment_s, (unsigned long)frames, HLS_CACHE_SEGMENTS,
+             (unsigned)(bytes / 1024));
+    return true;
+}
+
+static void stop_session() {
+    // No new pins once stopped; wait for the sends in progress
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_running.store(false, std::memory_order_release);
+    xSemaphoreGive(s_mutex);
+    for (;;) {
+        bool pinned = false;
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        for (const auto &s : s_slots) pinned |= s.readers > 0;
+        xSemaphoreGive(s_mutex);
+        if (!pinned) break;
+        vTaskDelay(pdMS_TO_TICKS(HLS_POLL_MS));
+    }
+
+    StreamEncoder::unsubscribe(&s_sub);
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    free_slots();
+    xSemaphoreGive(s_mutex);
+    ESP_LOGI(TAG, "HLS stopped (%lu segments)", (unsigned long)s_next_seq);
+}
+
+static void hls_task(void *params) {
+    for (;;) {
+        if (s_changed.exchange(false, std::memory_order_acq_rel)) {
+            xSemaphoreTake(s_mutex, portMAX_DELAY);
+            HlsSettings cfg = s_pending;
+            xSemaphoreGive(s_mutex);
+            if (s_running.load(std::memory_order_acquire)) stop_session();
+            if (cfg.enabled && !start_session(cfg)) {
+                ESP_LOGE(TAG, "HLS not started");
+            }
+        }
+        if (!s_running.load(std::memory_order_acquire)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        pump();
+        vTaskDelay(pdMS_TO_TICKS(HLS_POLL_MS));
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool HlsSegmenter::init(uint32_t capture_rate) {
+    s_capture_rate = capture_rate;
+
+    if (s_mutex == nullptr) s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == nullptr) {
+        ESP_LOGE(TAG, "Failed to create HLS mutex");
+        return false;
+    }
+
+    if (s_task == nullptr) {
+        BaseType_t result = xTaskCreatePinnedToCore(
+            hls_task,
+            "hls_seg",
+            4096,
+            nullptr,
+            4,  // Below the encoder it reads (5), above the analyzers (3)
+            &s_task,
+            1   // Core 1
+        );
+        if (result != pdPASS) {
+            s_task = nullptr;
+            ESP_LOGE(TAG, "Failed to create hls_seg task");
+            return false;
+        }
+    }
+    return true;
+}
+
+void HlsSegmenter::configure(bool enabled, uint8_t segment_s) {
+    if (s_mutex == nullptr || s_task == nullptr) return;
+    if (segment_s < HLS_MIN_SEGMENT_S) segment_s = HLS_MIN_SEGMENT_S;
+    if (segment_s > HLS_MAX_SEGMENT_S) segment_s = HLS_MAX_SEGMENT_S;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_pending.enabled   = enabled;
+    s_pending.segment_s = segment_s;
+    xSemaphoreGive(s_mutex);
+
+    s_changed.store(true, std::memory_order_release);
+    xTaskNotifyGive(s_task);
+}
+
+bool HlsSegmenter::is_running() {
+    return s_running.load(std::memory_order_acquire);
+}
+
+size_t HlsSegmenter::build_playlist(char *buf, size_t size) {
+    if (buf == nullptr || s_mutex == nullptr) return 0;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_stats.playlist_requests++;
+    // The newest complete segments, oldest first
+    const Slot *list[HLS_PLAYLIST_SEGMENTS];
+    int count = 0;
+    if (s_running.load(std::memory_order_acquire)) {
+        for (uint32_t back = HLS_PLAYLIST_SEGMENTS; back > 0; back--) {
+            if (s_next_seq < back) continue;
+            const uint32_t seq = s_next_seq - back;
+            for (const auto &s : s_slots) {
+                if (s.ready && s.seq == seq) list[count++] = &s;
+            }
+        }
+    }
+    if (count == 0) {
+        xSemaphoreGive(s_mutex);
+        return 0;
+    }
+
+    // RFC 8216: version 6 for EXT-X-MAP in a playlist with media segments
+    int n = snprintf(buf, size,
+                     "#EXTM3U\n"
+                     "#EXT-X-VERSION:6\n"
+                     "#EXT-X-TARGETDURATION:%u\n"
+                     "#EXT-X-MEDIA-SEQUENCE:%lu\n"
+                     "#EXT-X-DISCONTINUITY-SEQUENCE:%lu\n"
+                     "#EXT-X-INDEPENDENT-SEGMENTS\n"
+                     "#EXT-X-MAP:URI=\"%08lx-init.mp4\"\n",
+                     s_active.segment_s, (unsigned long)list[0]->seq, (unsigned long)list[0]->dsn,
+                     (unsigned long)s_session);
+    bool complete = n > 0 && (size_t)n < size;
+    size_t len = complete ? (size_t)n : 0;
+    for (int i = 0; complete && i < count; i++) {
+        const Slot &s = *list[i];
+        const double seconds = (double)s.frames * FLAC_BLOCK_FRAMES / (double)s_capture_rate;
+        n = snprintf(buf + len, size - len, "%s#EXTINF:%.3f,\n%08lx-%lu.m4s\n",
+                     i > 0 && s.discontinuity ? "#EXT-X-DISCONTINUITY\n" : "", seconds,
+                     (unsigned long)s_session, (unsigned long)s.seq);
+        complete = n > 0 && (size_t)n < size - len;
+        if (complete) len += (size_t)n;
+    }
+    xSemaphoreGive(s_mutex);
+    return complete ? len : 0;
+}
+
+size_t HlsSegmenter::build_init(uint32_t session, uint8_t *out, size_t size) {
+    if (out == nullptr || !s_running.load(std::memory_order_acquire) || session != s_session) return 0;
+    return write_init(out, size, s_capture_rate);
+}
+
+int HlsSegmenter::acquire(uint32_t session, uint32_t seq, const uint8_t **data, size_t *len) {
+    if (data == nullptr || len == nullptr || s_mutex == nullptr) return -1;
+
+    int handle = -1;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_stats.segment_requests++;
+    if (s_running.load(std::memory_order_acquire) && session == s_session) {
+        for (int i = 0; i < HLS_CACHE_SEGMENTS; i++) {
+            Slot &s = s_slots[i];
+            if (!s.ready || s.seq != seq) continue;
+            s.readers++;
+            *data  = s.mem + s.offset;
+            *len   = s.bytes;
+            handle = i;
+            break;
+        }
+    }
+    if (handle < 0) s_stats.misses++;
+    xSemaphoreGive(s_mutex);
+    return handle;
+}
+
+void HlsSegmenter::release(int handle, size_t bytes_sent) {
+    if (handle < 0 || handle >= HLS_CACHE_SEGMENTS || s_mutex == nullptr) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_slots[handle].readers > 0) s_slots[handle].readers--;
+    s_stats.bytes_served += bytes_sent;
+    xSemaphoreGive(s_mutex);
+}
+
+uint32_t HlsSegmenter::playlist_max_age_s() {
+    const uint32_t half = s_active.segment_s / 2;
+    return half > 0 ? half : 1;
+}
+
+void HlsSegmenter::get_stats(HlsStats *stats) {
+    if (stats == nullptr) return;
+    memset(stats, 0, sizeof(*stats));
+    if (s_mutex == nullptr) return;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    *stats             = s_stats;
+    stats->running     = s_running.load(std::memory_order_acquire);
+    stats->session     = s_session;
+    stats->segment_s   = s_active.segment_s;
+    stats->cache_bytes = stats->running ? (uint32_t)(s_slot_bytes * HLS_CACHE_SEGMENTS) : 0;
+    const uint32_t frames = s_segment_frames;
+    xSemaphoreGive(s_mutex);
+    if (!stats->running) return;
+
+    // The FLAC pipe's share (shared with any /stream.flac listeners)
+    StreamEncoderStats enc;
+    StreamEncoder::get_stats(&enc);
+    const float seconds = (float)frames * FLAC_BLOCK_FRAMES / (float)s_capture_rate;
+    for (const auto &p : enc.pipe) {
+        if (!p.active || p.format.codec != StreamCodec::FLAC || p.format.sample_rate != s_capture_rate) continue;
+        stats->encode_cycles_avg = (uint32_t)((float)p.cycles_per_channel_second * 2.0f * seconds);
+        break;
+    }
+    const float core_hz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e6f;
+    stats->core1_load_pct =
+        ((float)stats->package_cycles_avg + (float)stats->encode_cycles_avg) / (seconds * core_hz) * 100.0f;
+}
@@ -0,0 +1,109 @@
+#ifndef HLS_SEGMENTER_H
+#define HLS_SEGMENTER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// HlsSegmenter: HTTP Live Streaming output (RFC 8216) of the capture as
+// FLAC in fragmented MP4 (ISO/IEC 14496-12 with the FLAC-in-ISOBMFF mapping).
+//
+// Every /stream listener holds a TCP connection and one of the HTTP client
+// slots for as long as it plays. An HLS player instead fetches a playlist
+// and then short segment files with plain GETs. Each segment is encoded and
+// packaged once into a PSRAM cache and served from there as a static,
+// cacheable response, so a caching reverse proxy in front of the device can
+// serve any number of players while the device sees one request per segment.
+//
+//   /hls/live.m3u8              live playlist, the newest HLS_PLAYLIST_SEGMENTS
+//   /hls/<session>-init.mp4     init segment: moov with a 'fLaC' sample entry
+//   /hls/<session>-<seq>.m4s    media segment: moof + mdat, one FLAC frame
+//                               per sample, tfdt on the capture timeline
+//
+// <session> is random per start, so the init and segment URLs never change
+// content and are sent as immutable; the playlist may be cached for half a
+// segment.
+//
+// Frames come from a shared FLAC encoder pipe (network/stream_encoder.h) at
+// the capture rate: the FLAC listeners and HLS cost one encoder. A segment is
+// `segment_s` of whole FLAC_BLOCK_FRAMES frames, so its EXTINF is exact. A
+// gap in the capture frames (the pipe was lapped, or frames were dropped for
+// want of a free slot) ends the segment early and the next one is marked
+// EXT-X-DISCONTINUITY.
+//
+// The cache is HLS_CACHE_SEGMENTS fixed slots sized for a segment of
+// verbatim FLAC frames, so every segment is full length whatever the
+// material: 6 × 200 KB per second of segment at 48 kHz (2.4 MB at 2 s,
+// twice that at 96 kHz), allocated while HLS runs. The newest
+// HLS_PLAYLIST_SEGMENTS complete segments are listed, one slot is being
+// filled, and the rest keep segments that just left the playlist fetchable
+// for players that loaded it a moment earlier. A slot being sent is pinned
+// and never refilled; the handler runs on the HTTP server task, so at most
+// one slot is pinned at a time.
+//
+// The "hls_seg" task (Core 1, priority 4: below stream_enc, which feeds its
+// FLAC pipe on the same core, above the analyzers) drains the pipe every
+// HLS_POLL_MS straight into the slot being filled and writes the moof in
+// front of the frames when the segment is complete. It blocks while HLS is
+// off.
+//
+//   ffplay http://<ip>:8080/hls/live.m3u8
+
+static constexpr uint8_t  HLS_CACHE_SEGMENTS     = 6;
+static constexpr uint8_t  HLS_PLAYLIST_SEGMENTS  = 3;       // RFC 8216 §6.2.2: ≥ 3 target durations
+static constexpr uint8_t  HLS_MIN_SEGMENT_S      = 1;
+static constexpr uint8_t  HLS_MAX_SEGMENT_S      = 4;       // 4.8 MB of cache at 48 kHz
+static constexpr uint32_t HLS_POLL_MS            = 20;
+static constexpr size_t   HLS_INIT_MAX_BYTES     = 768;
+
+struct HlsStats {
+    bool     running;
+    uint32_t session;
+    uint8_t  segment_s;
+    uint32_t sequence;              // Segments completed this session
+    uint8_t  cached;                // Complete segments in the cache
+    uint32_t cache_bytes;           // PSRAM held by the slots
+    uint32_t segment_bytes_avg;     // moof + mdat
+    uint32_t segment_bytes_max;
+    uint32_t discontinuities;       // Segments after a gap (pipe lap, dropped frames)
+    uint32_t dropped_frames;        // No free slot: every spare slot pinned
+    uint32_t package_cycles_avg;    // Per segment: pipe → slot copies and the moof
+    uint32_t encode_cycles_avg;     // Per segment: the FLAC pipe's encode cost
+    float    core1_load_pct;        // Both of the above, of one core
+    uint32_t playlist_requests;
+    uint32_t segment_requests;
+    uint32_t misses;                // Segments no longer (or not yet) cached
+    uint64_t bytes_served;
+};
+
+class HlsSegmenter {
+public:
+    // Create the (idle) segmenter task. Requires StreamEncoder::init().
+    static bool init(uint32_t capture_rate);
+
+    // Start, restart or stop segmenting. `segment_s` is clamped to
+    // HLS_MIN_SEGMENT_S–HLS_MAX_SEGMENT_S. A restart starts a new session
+    // (new URLs) with an empty cache.
+    static void configure(bool enabled, uint8_t segment_s);
+
+    static bool is_running();
+
+    // Live playlist. Returns its length, 0 if HLS is off, no segment is
+    // complete yet or `size` is too small.
+    static size_t build_playlist(char *buf, size_t size);
+
+    // Init segment of session `session` (at most HLS_INIT_MAX_BYTES). Returns
+    // its length, 0 if that session is not the running one.
+    static size_t build_init(uint32_t session, uint8_t *out, size_t size);
+
+    // Pin segment `seq` of session `session` and point `data` at it. Returns
+    // a handle for release(), or -1 if the segment is not in the cache.
+    static int  acquire(uint32_t session, uint32_t seq, const uint8_t **data, size_t *len);
+    static void release(int handle, size_t bytes_sent);
+
+    // Cache-Control max-age for the playlist: half a segment, at least 1 s
+    static uint32_t playlist_max_age_s();
+
+    static void get_stats(HlsStats *stats);
+};
+
+#endif // HLS_SEGMENTER_H
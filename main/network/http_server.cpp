@@ -1,22 +1,43 @@
 #include "http_server.h"
 #include "stream_handler.h"
+#include "stream_encoder.h"
+#include "flac_encoder.h"
+#include "adpcm_encoder.h"
+#include "mp3_encoder.h"
+#include "ogg_opus_encoder.h"
+#include "rtp_sender.h"
+#include "snapcast_server.h"
+#include "hls_segmenter.h"
 #include "mqtt_service.h"
 #include "../config_schema.h"
 #include "../storage/nvs_config.h"
+#include "../storage/eq_presets.h"
+#include "../storage/fir_store.h"
 #include "../audio/audio_buffer.h"
 #include "../audio/audio_capture.h"
+#include "../audio/dither.h"
 #include "../audio/i2s_master.h"
 #include "../audio/eq_processor.h"
+#include "../audio/eq_response.h"
+#include "../audio/peak_limiter.h"
+#include "../audio/auto_gain.h"
+#include "../audio/fir_filter.h"
+#include "../audio/loudness_meter.h"
+#include "../audio/spectrum_analyzer.h"
+#include "../audio/wow_flutter.h"
+#include "../audio/thdn_analyzer.h"
 #include "../system/error_handler.h"
 #include "../system/task_manager.h"
 #include "../network/wifi_manager.h"
 #include "esp_log.h"
 #include "esp_http_server.h"
+#include "esp_heap_caps.h"
 #include "esp_system.h"
 #include "esp_timer.h"
 #include "mqtt_client.h"
 #include "cJSON.h"
 #include "freertos/event_groups.h"
+#include <atomic>
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
@@ -45,8 +66,218 @@ static void add_cors_headers(httpd_req_t *req)
 struct StreamTaskContext {
     httpd_req_t *req;
     int client_id;
+    StreamFormat format;          // Negotiated output format
+    bool passthrough;             // 24-bit stereo straight from the capture ring
+    bool fallback_watch;          // ?codec=auto PCM stream: end it if the link keeps backing up
+    StreamSubscription sub;       // Position in the shared encoder pipe (16-bit); laps also for passthrough
 };
 
+// 24-bit chunk: one DMA block of packed frames (240 × 6 bytes)
+static constexpr size_t STREAM24_CHUNK_BYTES = 1440;
+
+// Passthrough sends each chunk in place from the capture ring, so a chunk is
+// only intact while the writer stays short of a full ring past it. Beyond
+// 95 % of the ring (where AudioBuffer starts warning) the stream resyncs and
+// counts a lap, as a lapped encoder pipe subscriber does.
+static constexpr uint64_t STREAM24_LAP_FRAMES = AUDIO_BUFFER_RING_BYTES / AudioStream::BYTES_PER_FRAME * 95 / 100;
+
+// ADPCM fallback for ?codec=auto: a PCM stream that stays more than
+// ADPCM_FALLBACK_LAG_MS behind its pipe (or is lapped) for
+// ADPCM_FALLBACK_BACKED_S consecutive seconds is ended, and the peer gets
+// ADPCM on its next ?codec=auto request for ADPCM_FALLBACK_HOLD_S. A WAV
+// stream cannot change format after its header, so the switch happens on the
+// player's reconnect.
+static constexpr int      ADPCM_FALLBACK_PEERS    = 4;
+static constexpr uint32_t ADPCM_FALLBACK_LAG_MS   = 2000;   // Joins start 1500 ms behind
+static constexpr uint32_t ADPCM_FALLBACK_BACKED_S = 5;
+static constexpr uint32_t ADPCM_FALLBACK_HOLD_S   = 600;
+
+struct FallbackPeer {
+    uint32_t ip;                  // IPv4, network order; 0 = free
+    uint32_t until_s;             // Uptime seconds
+};
+static FallbackPeer s_fallback_peers[ADPCM_FALLBACK_PEERS];
+static portMUX_TYPE s_fallback_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Peer IPv4 address of a socket (IPv4-mapped for IPv6 sockets), 0 if unknown
+static uint32_t peer_ipv4(int fd)
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    if (getpeername(fd, (struct sockaddr *)&addr, &addr_len) != 0)
+    {
+        return 0;
+    }
+    uint32_t ip = 0;
+    if (addr.ss_family == AF_INET)
+    {
+        ip = ((struct sockaddr_in *)&addr)->sin_addr.s_addr;
+    }
+    else if (addr.ss_family == AF_INET6)
+    {
+        memcpy(&ip, &((struct sockaddr_in6 *)&addr)->sin6_addr.s6_addr[12], sizeof(ip));
+    }
+    return ip;
+}
+
+static bool fallback_active(uint32_t ip)
+{
+    uint32_t now = esp_timer_get_time() / 1000000;
+    bool found = false;
+    portENTER_CRITICAL(&s_fallback_lock);
+    for (int i = 0; i < ADPCM_FALLBACK_PEERS; i++)
+    {
+        if (ip != 0 && s_fallback_peers[i].ip == ip && (int32_t)(s_fallback_peers[i].until_s - now) > 0)
+        {
+            found = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_fallback_lock);
+    return found;
+}
+
+static void fallback_remember(uint32_t ip)
+{
+    if (ip == 0)
+    {
+        return;
+    }
+    uint32_t now = esp_timer_get_time() / 1000000;
+    portENTER_CRITICAL(&s_fallback_lock);
+    // Same peer, else the slot expiring first (free slots hold 0)
+    int slot = 0;
+    for (int i = 0; i < ADPCM_FALLBACK_PEERS; i++)
+    {
+        if (s_fallback_peers[i].ip == ip)
+        {
+            slot = i;
+            break;
+        }
+        if ((int32_t)(s_fallback_peers[i].until_s - s_fallback_peers[slot].until_s) < 0)
+        {
+            slot = i;
+        }
+    }
+    s_fallback_peers[slot].ip = ip;
+    s_fallback_peers[slot].until_s = now + ADPCM_FALLBACK_HOLD_S;
+    portEXIT_CRITICAL(&s_fallback_lock);
+}
+
+// ─── Stream format negotiation ───────────────────────────────────────────────
+
+// ?format= / ?codec= names. False if unknown.
+static bool stream_format_from_name(const char *name, StreamCodec *codec)
+{
+    static const struct { const char *name; StreamCodec codec; } NAMES[] = {
+        {"s16", StreamCodec::PCM_S16},   {"pcm", StreamCodec::PCM_S16},
+        {"wav", StreamCodec::PCM_S16},   {"s24", StreamCodec::PCM_S24},
+        {"f32", StreamCodec::PCM_F32},   {"flac", StreamCodec::FLAC},
+        {"adpcm", StreamCodec::IMA_ADPCM}, {"mp3", StreamCodec::MP3},
+        {"opus", StreamCodec::OPUS},
+    };
+    for (const auto &n : NAMES)
+    {
+        if (strcmp(name, n.name) == 0)
+        {
+            *codec = n.codec;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Media types plain /stream answers with, in server preference order: on
+// equal q the earlier entry wins, so browsers listing several types at
+// q=1 keep getting PCM WAV. MP3 and Opus only count when built in.
+static const struct { const char *type; StreamCodec codec; } ACCEPT_TYPES[] = {
+    {"audio/wav", StreamCodec::PCM_S16},  {"audio/x-wav", StreamCodec::PCM_S16},
+    {"audio/wave", StreamCodec::PCM_S16}, {"audio/vnd.wave", StreamCodec::PCM_S16},
+    {"audio/*", StreamCodec::PCM_S16},    {"*/*", StreamCodec::PCM_S16},
+    {"audio/flac", StreamCodec::FLAC},    {"audio/x-flac", StreamCodec::FLAC},
+    {"audio/ogg", StreamCodec::OPUS},     {"audio/opus", StreamCodec::OPUS},
+    {"application/ogg", StreamCodec::OPUS},
+    {"audio/mpeg", StreamCodec::MP3},     {"audio/mp3", StreamCodec::MP3},
+};
+
+// Pick the codec for an Accept header value (RFC 9110 §12.5.1: highest q,
+// q=0 excludes). False if nothing listed can be served.
+static bool codec_from_accept(const char *accept, StreamCodec *codec)
+{
+    const size_t NONE = sizeof(ACCEPT_TYPES) / sizeof(ACCEPT_TYPES[0]);
+    size_t best = NONE;
+    float best_q = 0.0f;
+
+    const char *p = accept;
+    while (*p != '\0')
+    {
+        // One entry: type/subtype [; params]
+        while (*p == ' ' || *p == ',') p++;
+        const char *type = p;
+        while (*p != '\0' && *p != ',' && *p != ';' && *p != ' ') p++;
+        size_t type_len = (size_t)(p - type);
+        float q = 1.0f;
+        while (*p != '\0' && *p != ',')
+        {
+            if (*p == ';')
+            {
+                p++;
+                while (*p == ' ') p++;
+                if ((p[0] == 'q' || p[0] == 'Q') && p[1] == '=') q = strtof(p + 2, nullptr);
+            }
+            else
+            {
+                p++;
+            }
+        }
+        if (type_len == 0 || q <= 0.0f) continue;
+
+        for (size_t i = 0; i < NONE; i++)
+        {
+            const StreamCodec c = ACCEPT_TYPES[i].codec;
+            if (strlen(ACCEPT_TYPES[i].type) != type_len ||
+                strncasecmp(ACCEPT_TYPES[i].type, type, type_len) != 0)
+                continue;
+            if ((c == StreamCodec::MP3 && !Mp3Encoder::available()) ||
+                (c == StreamCodec::OPUS && !OggOpusEncoder::available()))
+                break;
+            if (q > best_q || (q == best_q && i < best))
+            {
+                best = i;
+                best_q = q;
+            }
+            break;
+        }
+    }
+    if (best == NONE) return false;
+    *codec = ACCEPT_TYPES[best].codec;
+    return true;
+}
+
+static const char *stream_content_type(StreamCodec codec)
+{
+    switch (codec)
+    {
+        case StreamCodec::FLAC: return "audio/flac";
+        case StreamCodec::MP3:  return "audio/mpeg";
+        case StreamCodec::OPUS: return "audio/ogg";
+        default:                return "audio/wav";
+    }
+}
+
+// Drop a stream's audio source: its AudioBuffer reader (24-bit passthrough)
+// or its encoder pipe subscription
+static void release_stream_source(int client_id, bool passthrough, StreamSubscription *sub)
+{
+    if (passthrough)
+    {
+        AudioBuffer::unregister_client((uint8_t)client_id);
+    }
+    else
+    {
+        StreamEncoder::unsubscribe(sub);
+    }
+}
+
 // Initialize client slots
 static void init_client_slots()
 {
@@ -100,24 +331,41 @@ static bool get_checkbox_value(const char *body, const char *key)
     return httpd_query_key_value(body, key, tmp, sizeof(tmp)) == ESP_OK;
 }
 
+// Socket timeouts (recv_wait_timeout, 5 s each) tolerated in a row while
+// reading a request body, so a stalled client cannot hold the single httpd
+// task for more than ~15 s
+static constexpr int RECV_MAX_TIMEOUTS = 3;
+
+// Read exactly `len` body bytes into `buffer`
+static esp_err_t recv_body(httpd_req_t *req, char *buffer, size_t len)
+{
+    size_t offset = 0;
+    int timeouts = 0;
+    while (offset < len) {
+        int ret = httpd_req_recv(req, buffer + offset, len - offset);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts <= RECV_MAX_TIMEOUTS) {
+            continue;
+        }
+        if (ret <= 0) {
+            return ESP_FAIL;
+        }
+        timeouts = 0;
+        offset += ret;
+    }
+    return ESP_OK;
+}
+
 static esp_err_t read_form_body(httpd_req_t *req, char *buffer, size_t buffer_len)
 {
     if (req->content_len <= 0 || req->content_len >= static_cast<int>(buffer_len)) {
         return ESP_ERR_INVALID_SIZE;
     }
 
-    int remaining = req->content_len;
-    int offset = 0;
-    while (remaining > 0) {
-        int ret = httpd_req_recv(req, buffer + offset, remaining);
-        if (ret <= 0) {
-            return ESP_FAIL;
-        }
-        remaining -= ret;
-        offset += ret;
+    if (recv_body(req, buffer, req->content_len) != ESP_OK) {
+        return ESP_FAIL;
     }
 
-    buffer[offset] = '\0';
+    buffer[req->content_len] = '\0';
     return ESP_OK;
 }
 
@@ -305,7 +553,7 @@ static esp_err_t mqtt_settings_get_handler(httpd_req_t *req)
         "const threshold=document.getElementById('threshold');const thresholdValue=document.getElementById('thresholdValue');"
         "let audioLevelRequestInFlight=false;"
         "threshold.addEventListener('input',()=>{thresholdValue.textContent=threshold.value+' dB';});"
-        "async function refreshAudioLevel(){if(audioLevelRequestInFlight)return;audioLevelRequestInFlight=true;try{const response=await fetch('/api/audio-level',{cache:'no-store'});const data=await response.json();document.getElementById('audioLevel').textContent=data.rms_db.toFixed(1)+' dB | threshold '+data.threshold_db.toFixed(1)+' dB | '+(data.playing?'playing':'idle');}catch(e){document.getElementById('audioLevel').textContent='Unavailable';}finally{audioLevelRequestInFlight=false;}}"
+        "async function refreshAudioLevel(){if(audioLevelRequestInFlight)return;audioLevelRequestInFlight=true;try{const response=await fetch('/api/audio-level',{cache:'no-store'});const data=await response.json();document.getElementById('audioLevel').textContent=data.rms_db.toFixed(1)+' dB | threshold '+data.threshold_db.toFixed(1)+' dB | '+(data.playing?'playing':'idle')+(data.loudness?' | '+data.loudness.short_term_lufs.toFixed(1)+' LUFS (S), '+data.loudness.integrated_lufs.toFixed(1)+' LUFS (I)':'');}catch(e){document.getElementById('audioLevel').textContent='Unavailable';}finally{audioLevelRequestInFlight=false;}}"
         "async function testConnection(){const form=new FormData(document.getElementById('mqttForm'));const body=new URLSearchParams(form).toString();const response=await fetch('/mqtt-settings/test',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body});const data=await response.json();document.getElementById('result').textContent=data.message;document.getElementById('result').style.background=(data.status==='success')?'#dcfce7':'#fee2e2';}"
         "async function resetConfig(){if(!confirm('Erase all configuration and reboot to setup mode?'))return;const response=await fetch('/mqtt-settings/reset',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'confirm=yes'});document.open();document.write(await response.text());document.close();}"
         "refreshAudioLevel();setInterval(refreshAudioLevel,5000);"
@@ -479,12 +727,59 @@ static esp_err_t audio_level_handler(httpd_req_t *req)
     httpd_resp_set_type(req, "application/json");
     add_cors_headers(req);
 
-    char response[160];
+    LoudnessStats loud;
+    LoudnessMeter::get_stats(&loud);
+
+    char response[640];
     int len = snprintf(response, sizeof(response),
-        "{\"rms_db\":%.2f,\"threshold_db\":%.2f,\"playing\":%s}",
+        "{\"rms_db\":%.2f,\"threshold_db\":%.2f,\"playing\":%s,"
+        "\"loudness\":{\"momentary_lufs\":%.1f,\"short_term_lufs\":%.1f,"
+        "\"integrated_lufs\":%.1f,\"loudness_range_lu\":%.1f,"
+        "\"max_momentary_lufs\":%.1f,\"max_short_term_lufs\":%.1f,"
+        "\"measured_seconds\":%.1f,\"gated_blocks\":%lu,"
+        "\"cycles_per_block_avg\":%lu,\"cycles_per_block_max\":%lu,\"block_budget_pct\":%.2f}}",
         AudioCapture::get_current_rms_db(),
         AudioCapture::get_threshold_db(),
-        AudioCapture::is_playing() ? "true" : "false");
+        AudioCapture::is_playing() ? "true" : "false",
+        loud.momentary_lufs, loud.short_term_lufs, loud.integrated_lufs,
+        loud.loudness_range_lu, loud.max_momentary_lufs, loud.max_short_term_lufs,
+        loud.measured_seconds, (unsigned long)loud.gated_blocks,
+        (unsigned long)loud.cycles_avg, (unsigned long)loud.cycles_max, loud.budget_pct);
+    return httpd_resp_send(req, response, len);
+}
+
+// POST /api/audio-level — restart the integrated loudness / LRA measurement
+// (also restarted automatically whenever playback starts)
+static esp_err_t audio_level_reset_handler(httpd_req_t *req)
+{
+    LoudnessMeter::reset();
+    httpd_resp_set_type(req, "application/json");
+    add_cors_headers(req);
+    return httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Loudness measurement reset\"}");
+}
+
+// GET /api/stereo — correlation, balance and mid/side ratio of the streamed
+// signal, integrated over STEREO_WINDOW_MS by the loudness meter's pass
+static esp_err_t stereo_handler(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "application/json");
+    add_cors_headers(req);
+
+    StereoStats st;
+    LoudnessMeter::get_stereo_stats(&st);
+    LoudnessStats loud;
+    LoudnessMeter::get_stats(&loud);
+
+    char response[384];
+    int len = snprintf(response, sizeof(response),
+        "{\"playing\":%s,\"silent\":%s,\"correlation\":%.3f,\"balance_db\":%.2f,"
+        "\"mid_side_ratio_db\":%.2f,\"left_rms_dbfs\":%.2f,\"right_rms_dbfs\":%.2f,"
+        "\"window_ms\":%.0f,\"cycles_per_block_avg\":%lu,\"block_budget_pct\":%.2f}",
+        AudioCapture::is_playing() ? "true" : "false",
+        st.silent ? "true" : "false",
+        st.correlation, st.balance_db, st.mid_side_ratio_db,
+        st.left_rms_dbfs, st.right_rms_dbfs, st.window_ms,
+        (unsigned long)loud.cycles_avg, loud.budget_pct);
     return httpd_resp_send(req, response, len);
 }
 
@@ -495,31 +790,47 @@ static void stream_task(void *arg)
     httpd_req_t *req = ctx->req;
     int client_id = ctx->client_id;
     
-    ESP_LOGI(TAG, "Stream task started for client %d", client_id);
-
-    // Chunk aligned to DMA production unit (240 frames × 6 bytes = 5ms at 48kHz)
-    uint8_t audio_chunk_24bit[1440];  // 24-bit input from ring buffer
-    uint8_t audio_chunk_16bit[960];   // 16-bit output for HTTP stream (1440 * 2/3)
-    size_t bytes_read;
+    ESP_LOGI(TAG, "Stream task started for client %d (%s, %u Hz, %u ch%s)", client_id,
+             stream_codec_to_str(ctx->format.codec), ctx->format.sample_rate, ctx->format.channels,
+             ctx->passthrough ? ", passthrough" : "");
+
+    // Chunk aligned to DMA production unit (240 frames × 4 bytes = 5ms at 48kHz)
+    uint8_t audio_chunk[960];         // Encoder pipe output; whole frames of every PCM format
+    const uint8_t *chunk;
+    size_t chunk_bytes;
     uint32_t last_log_time = esp_timer_get_time() / 1000000;
     uint32_t period_bytes = 0;
     uint32_t empty_waits = 0;
-
-    // Pacing: match send rate to audio production rate (16-bit output)
-    uint32_t byte_rate = current_sample_rate * 4; // sample_rate × 2ch × 2bytes (16-bit)
+    uint32_t last_check_time = last_log_time;
+    uint32_t last_laps = 0;
+    uint32_t backed_seconds = 0;
+    uint64_t pass_frame = ctx->passthrough ? AudioBuffer::reader_frame((uint8_t)client_id) : 0;
+
+    // Pacing: match send rate to audio production rate
+    // (compressed codecs: measured against 16-bit stereo)
+    uint32_t frame_bytes = ctx->passthrough                          ? 6
+                           : stream_codec_is_pcm(ctx->format.codec) ? StreamEncoder::frame_bytes(ctx->format)
+                                                                     : 4;
+    uint32_t byte_rate = ctx->format.sample_rate * frame_bytes;
 
     while (clients[client_id].is_active)
     {
         TickType_t iter_start = xTaskGetTickCount();
 
-        // Read from ring buffer (24-bit data)
-        if (!AudioBuffer::read(client_id, audio_chunk_24bit, sizeof(audio_chunk_24bit), &bytes_read))
+        if (ctx->passthrough)
         {
-            ESP_LOGE(TAG, "Ring buffer read error for client %d", client_id);
-            break;
+            // Native 24-bit: send straight out of the capture ring, no
+            // per-sample work and no intermediate copy
+            AudioBuffer::peek((uint8_t)client_id, &chunk, STREAM24_CHUNK_BYTES, &chunk_bytes);
+        }
+        else
+        {
+            // Read converted audio from the shared encoder pipe
+            chunk = audio_chunk;
+            chunk_bytes = StreamEncoder::read(&ctx->sub, audio_chunk, sizeof(audio_chunk));
         }
 
-        if (bytes_read == 0)
+        if (chunk_bytes == 0)
         {
             // No data - wait for capture to produce more (do NOT send silence)
             empty_waits++;
@@ -533,23 +844,35 @@ static void stream_task(void *arg)
 
         empty_waits = 0;
 
-        // Downsample 24-bit to 16-bit
-        size_t bytes_16bit = StreamHandler::downsample_24to16(audio_chunk_24bit, audio_chunk_16bit, bytes_read);
-        if (bytes_16bit == 0)
+        // Send audio chunk
+        if (httpd_resp_send_chunk(req, (const char *)chunk, chunk_bytes) != ESP_OK)
         {
-            ESP_LOGE(TAG, "Downsampling failed for client %d", client_id);
+            ESP_LOGI(TAG, "Client %d disconnected", client_id);
             break;
         }
-
-        // Send 16-bit audio chunk
-        if (httpd_resp_send_chunk(req, (const char *)audio_chunk_16bit, bytes_16bit) != ESP_OK)
+        if (ctx->passthrough)
         {
-            ESP_LOGI(TAG, "Client %d disconnected", client_id);
-            break;
+            // A send that blocked long enough for capture to come round to
+            // the chunk sent partly newer audio: resync instead of reading on
+            uint64_t captured = 0;
+            AudioBuffer::get_clock(&captured, nullptr);
+            if (captured - pass_frame > STREAM24_LAP_FRAMES)
+            {
+                AudioBuffer::unregister_client((uint8_t)client_id);
+                AudioBuffer::register_client((uint8_t)client_id);
+                pass_frame = AudioBuffer::reader_frame((uint8_t)client_id);
+                ctx->sub.laps++;
+                ESP_LOGW(TAG, "Client %d lapped by capture, resynced", client_id);
+            }
+            else
+            {
+                AudioBuffer::consume((uint8_t)client_id, chunk_bytes);
+                pass_frame += chunk_bytes / AudioStream::BYTES_PER_FRAME;
+            }
         }
 
-        clients[client_id].bytes_sent += bytes_16bit;
-        period_bytes += bytes_16bit;
+        clients[client_id].bytes_sent += chunk_bytes;
+        period_bytes += chunk_bytes;
 
         // Log throughput every 10 seconds
         uint32_t now = esp_timer_get_time() / 1000000;
@@ -557,13 +880,31 @@ static void stream_task(void *arg)
         if (elapsed >= 10)
         {
             uint32_t kbps = (period_bytes * 8) / (elapsed * 1000);
-            uint32_t target_kbps = (current_sample_rate * 4 * 8) / 1000;  // 16-bit stereo bitrate
+            uint32_t target_kbps = (byte_rate * 8) / 1000;  // PCM bitrate
             ESP_LOGI(TAG, "Client %d: %u kbps (target: %u), total %llu bytes",
                      client_id, kbps, target_kbps, clients[client_id].bytes_sent);
             period_bytes = 0;
             last_log_time = now;
         }
 
+        // ?codec=auto: end a PCM stream the link cannot keep up with; the
+        // player's reconnect gets ADPCM
+        if (ctx->fallback_watch && now != last_check_time)
+        {
+            uint64_t lag_ms = (uint64_t)StreamEncoder::pending(&ctx->sub) * 1000 / byte_rate;
+            bool backed = lag_ms > ADPCM_FALLBACK_LAG_MS || ctx->sub.laps != last_laps;
+            backed_seconds = backed ? backed_seconds + 1 : 0;
+            last_laps = ctx->sub.laps;
+            last_check_time = now;
+            if (backed_seconds >= ADPCM_FALLBACK_BACKED_S)
+            {
+                ESP_LOGW(TAG, "Client %d: link backed up for %u s (%u ms behind), falling back to ADPCM",
+                         client_id, backed_seconds, (unsigned)lag_ms);
+                fallback_remember(clients[client_id].ip_address);
+                break;
+            }
+        }
+
         // Check if audio capture is still running
         if (!AudioCapture::is_running())
         {
@@ -575,7 +916,7 @@ static void stream_task(void *arg)
         // // Calculate how long this chunk represents in real-time, then wait
         // // the remaining duration after subtracting time already spent on
         // // the read+send. This prevents burst-drain-starve buffer oscillation.
-        // TickType_t target_ticks = pdMS_TO_TICKS((bytes_read * 1000) / byte_rate);
+        // TickType_t target_ticks = pdMS_TO_TICKS((chunk_bytes * 1000) / byte_rate);
         // if (target_ticks < 1) target_ticks = 1;
         // TickType_t elapsed_ticks = xTaskGetTickCount() - iter_start;
         // if (elapsed_ticks < target_ticks)
@@ -585,10 +926,10 @@ static void stream_task(void *arg)
     }
 
     // Clean up client connection
-    ESP_LOGI(TAG, "Client %d disconnecting (sent %llu bytes)",
-             client_id, clients[client_id].bytes_sent);
+    ESP_LOGI(TAG, "Client %d disconnecting (sent %llu bytes, %u laps)",
+             client_id, clients[client_id].bytes_sent, ctx->sub.laps);
 
-    AudioBuffer::unregister_client(client_id);
+    release_stream_source(client_id, ctx->passthrough, &ctx->sub);
     clients[client_id].is_active = false;
     clients[client_id].socket_fd = -1;
 
@@ -607,6 +948,158 @@ static esp_err_t stream_handler(httpd_req_t *req)
 {
     ESP_LOGI(TAG, "New stream request from client");
 
+    // Negotiate the stream format. Sample format / codec, strongest first:
+    // ?format=s16|s24|f32|flac|adpcm|mp3|opus (or the older ?codec= and
+    // ?bits=24), the URI (/stream24.wav, /stream.flac, .mp3, .opus), then for
+    // plain /stream and /stream.wav the Accept header. ?codec=auto is PCM, or
+    // ADPCM for a peer whose PCM stream kept backing up. Rate: ?rate=, else
+    // the capture rate (Opus: 48 kHz, its native rate). ?channels=1 gives a
+    // mono (L+R)/2 PCM stream.
+    uint32_t rate = current_sample_rate;
+    bool rate_given = false;
+    uint8_t channels = 2;
+    bool bits24 = false;
+    StreamCodec codec = StreamCodec::PCM_S16;
+    bool codec_given = true;
+    if (strncmp(req->uri, "/stream24.wav", 13) == 0)
+        codec = StreamCodec::PCM_S24;
+    else if (strncmp(req->uri, "/stream.flac", 12) == 0)
+        codec = StreamCodec::FLAC;
+    else if (strncmp(req->uri, "/stream.mp3", 11) == 0)
+        codec = StreamCodec::MP3;
+    else if (strncmp(req->uri, "/stream.opus", 12) == 0)
+        codec = StreamCodec::OPUS;
+    else
+        codec_given = false;
+    bool codec_auto = false;
+    bool format_given = false;
+    uint32_t peer_ip = peer_ipv4(httpd_req_to_sockfd(req));
+    char query[96] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK)
+    {
+        char value[16];
+        if (httpd_query_key_value(query, "rate", value, sizeof(value)) == ESP_OK)
+        {
+            rate = (uint32_t)strtoul(value, nullptr, 10);
+            rate_given = true;
+        }
+        if (httpd_query_key_value(query, "channels", value, sizeof(value)) == ESP_OK)
+        {
+            unsigned long n = strtoul(value, nullptr, 10);
+            if (n != 1 && n != 2)
+            {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "channels must be 1 or 2");
+                return ESP_FAIL;
+            }
+            channels = (uint8_t)n;
+        }
+        if (httpd_query_key_value(query, "bits", value, sizeof(value)) == ESP_OK &&
+            strtoul(value, nullptr, 10) == 24)
+        {
+            bits24 = true;  // Applied below, once the URI and ?codec= / ?format= are known
+        }
+        if (httpd_query_key_value(query, "codec", value, sizeof(value)) == ESP_OK)
+        {
+            if (strcmp(value, "auto") == 0)
+                codec_auto = true;
+            else if (!stream_format_from_name(value, &codec))
+            {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "codec must be pcm, flac, adpcm, mp3, opus or auto");
+                return ESP_FAIL;
+            }
+            codec_given = true;
+        }
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK)
+        {
+            if (!stream_format_from_name(value, &codec))
+            {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "format must be s16, s24, f32, flac, adpcm, mp3 or opus");
+                return ESP_FAIL;
+            }
+            codec_given = true;
+            format_given = true;
+            codec_auto = false;
+        }
+    }
+    if (bits24 && !stream_codec_is_pcm(codec))
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Compressed streams are 16-bit");
+        return ESP_FAIL;
+    }
+    if (bits24 && !format_given)
+    {
+        // ?bits=24 widens 16-bit PCM only; an explicit ?format= wins
+        if (codec == StreamCodec::PCM_S16) codec = StreamCodec::PCM_S24;
+        codec_given = true;
+    }
+    if (codec_auto)
+    {
+        codec = fallback_active(peer_ip) ? StreamCodec::IMA_ADPCM : StreamCodec::PCM_S16;
+    }
+    else if (!codec_given)
+    {
+        // A long Accept value is truncated; the types that fit still count
+        httpd_resp_set_hdr(req, "Vary", "Accept");
+        char accept[160] = {0};
+        if (httpd_req_get_hdr_value_len(req, "Accept") > 0)
+        {
+            httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept));
+            if (!codec_from_accept(accept, &codec))
+            {
+                char msg[96];
+                snprintf(msg, sizeof(msg), "Available: audio/wav, audio/flac%s%s",
+                         OggOpusEncoder::available() ? ", audio/ogg" : "",
+                         Mp3Encoder::available() ? ", audio/mpeg" : "");
+                httpd_resp_set_status(req, "406 Not Acceptable");
+                httpd_resp_sendstr(req, msg);
+                return ESP_OK;
+            }
+        }
+    }
+
+    if (codec == StreamCodec::OPUS && !rate_given)
+    {
+        rate = 48000;
+    }
+
+    if (codec == StreamCodec::OPUS && !OggOpusEncoder::available())
+    {
+        httpd_resp_send_err(req, HTTPD_501_METHOD_NOT_IMPLEMENTED, "Opus encoder not built in");
+        return ESP_FAIL;
+    }
+    if (codec == StreamCodec::OPUS && !OggOpusEncoder::supports_rate(rate))
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Opus streams run at 8000, 12000, 16000, 24000 or 48000 Hz");
+        return ESP_FAIL;
+    }
+    if (codec == StreamCodec::MP3 && !Mp3Encoder::available())
+    {
+        httpd_resp_send_err(req, HTTPD_501_METHOD_NOT_IMPLEMENTED, "MP3 encoder not built in");
+        return ESP_FAIL;
+    }
+    if (codec == StreamCodec::MP3 && !Mp3Encoder::supports_rate(rate))
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "MP3 streams run at 32000, 44100 or 48000 Hz");
+        return ESP_FAIL;
+    }
+    if (channels == 1 && !stream_codec_is_pcm(codec))
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Mono is available for s16, s24 and f32");
+        return ESP_FAIL;
+    }
+
+    // Stereo 24-bit at the capture rate is the ring data itself: no encoder
+    StreamFormat format = {codec, rate, channels};
+    const bool passthrough = codec == StreamCodec::PCM_S24 && channels == 2 && rate == current_sample_rate;
+    if (!passthrough && !StreamEncoder::supports(format))
+    {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "Unsupported rate %u Hz (capture runs at %u Hz)",
+                 rate, current_sample_rate);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, msg);
+        return ESP_FAIL;
+    }
+
     // Check for available slot
     int client_id = find_free_slot();
     if (client_id < 0)
@@ -618,10 +1111,22 @@ static esp_err_t stream_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
-    // Register client with audio buffer
-    if (!AudioBuffer::register_client(client_id))
+    // 24-bit passthrough: own reader on the capture ring (starts 1.5 s
+    // behind, like the encoder pipes). Otherwise join (or start) the shared
+    // encoder pipe for this format.
+    StreamSubscription sub = {-1, 0, 0};
+    if (passthrough)
     {
-        ESP_LOGE(TAG, "Failed to register client %d with audio buffer", client_id);
+        if (!AudioBuffer::register_client((uint8_t)client_id))
+        {
+            ESP_LOGE(TAG, "Failed to register client %d on the audio buffer", client_id);
+            httpd_resp_send_500(req);
+            return ESP_FAIL;
+        }
+    }
+    else if (!StreamEncoder::subscribe(format, &sub))
+    {
+        ESP_LOGE(TAG, "Failed to subscribe client %d to the %u Hz encoder pipe", client_id, rate);
         httpd_resp_send_500(req);
         return ESP_FAIL;
     }
@@ -632,35 +1137,82 @@ static esp_err_t stream_handler(httpd_req_t *req)
     clients[client_id].bytes_sent = 0;
     clients[client_id].underrun_count = 0;
     clients[client_id].connected_at = esp_timer_get_time();
+    clients[client_id].ip_address = peer_ip;
 
-    ESP_LOGI(TAG, "Client %d connected (socket fd: %d)", client_id, clients[client_id].socket_fd);
+    ESP_LOGI(TAG, "Client %d connected (socket fd: %d, %s %u Hz %s%s%s)", client_id, clients[client_id].socket_fd,
+             stream_codec_to_str(codec), rate, channels == 1 ? "mono" : "stereo",
+             passthrough ? ", passthrough" : "",
+             codec_auto && codec == StreamCodec::IMA_ADPCM ? ", ADPCM fallback" : "");
 
     // Set TCP_NODELAY on streaming socket for lower latency
     int fd = httpd_req_to_sockfd(req);
     int nodelay = 1;
     setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
 
-    // Build and send WAV header
+    // Build and send WAV header (extensible for 24-bit and float, IMA ADPCM),
+    // FLAC stream header or the pipe's Ogg Opus header pages; MP3 frames need
+    // none
     WavHeader wav_header;
-    StreamHandler::build_wav_header(&wav_header, current_sample_rate);
+    WavExtensibleHeader wav_header_ext;
+    ImaAdpcmWavHeader wav_header_adpcm;
+    uint8_t flac_header[FLAC_STREAM_HEADER_BYTES];
+    uint8_t ogg_header[OGG_OPUS_HEADER_BYTES];
+    const char *header_data = nullptr;
+    size_t header_size = 0;
+    if (codec == StreamCodec::MP3)
+    {
+        // Headerless: the first frame follows the HTTP headers
+    }
+    else if (codec == StreamCodec::OPUS)
+    {
+        header_size = StreamEncoder::stream_header(&sub, ogg_header, sizeof(ogg_header));
+        header_data = (const char *)ogg_header;
+    }
+    else if (codec == StreamCodec::FLAC)
+    {
+        header_size = FlacEncoder::stream_header(rate, flac_header, sizeof(flac_header));
+        header_data = (const char *)flac_header;
+    }
+    else if (codec == StreamCodec::IMA_ADPCM)
+    {
+        StreamHandler::build_wav_header_adpcm(&wav_header_adpcm, rate);
+        header_data = (const char *)&wav_header_adpcm;
+        header_size = sizeof(wav_header_adpcm);
+    }
+    else if (codec == StreamCodec::PCM_S24 || codec == StreamCodec::PCM_F32)
+    {
+        if (codec == StreamCodec::PCM_S24)
+            StreamHandler::build_wav_header_24(&wav_header_ext, rate, channels);
+        else
+            StreamHandler::build_wav_header_f32(&wav_header_ext, rate, channels);
+        header_data = (const char *)&wav_header_ext;
+        header_size = sizeof(wav_header_ext);
+    }
+    else
+    {
+        StreamHandler::build_wav_header(&wav_header, rate, channels);
+        header_data = (const char *)&wav_header;
+        header_size = sizeof(wav_header);
+    }
 
-    httpd_resp_set_type(req, "audio/wav");
+    httpd_resp_set_type(req, stream_content_type(codec));
     httpd_resp_set_hdr(req, "Content-Disposition", "inline");
     httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
     httpd_resp_set_hdr(req, "Connection", "close");
     httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
 
-    if (httpd_resp_send_chunk(req, (const char *)&wav_header, sizeof(WavHeader)) != ESP_OK)
+    // (A zero-length chunk would end the response)
+    if (header_size > 0 && httpd_resp_send_chunk(req, header_data, header_size) != ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to send WAV header to client %d", client_id);
-        AudioBuffer::unregister_client(client_id);
+        ESP_LOGE(TAG, "Failed to send stream header to client %d", client_id);
+        release_stream_source(client_id, passthrough, &sub);
         clients[client_id].is_active = false;
         clients[client_id].socket_fd = -1;
         httpd_resp_send_500(req);
         return ESP_FAIL;
     }
 
-    clients[client_id].bytes_sent += sizeof(WavHeader);
+    clients[client_id].bytes_sent += header_size;
 
     // Create async request copy for background streaming
     httpd_req_t *async_req = nullptr;
@@ -668,7 +1220,7 @@ static esp_err_t stream_handler(httpd_req_t *req)
     if (err != ESP_OK)
     {
         ESP_LOGE(TAG, "Failed to create async handler for client %d: %d", client_id, err);
-        AudioBuffer::unregister_client(client_id);
+        release_stream_source(client_id, passthrough, &sub);
         clients[client_id].is_active = false;
         clients[client_id].socket_fd = -1;
         httpd_resp_send_500(req);
@@ -681,7 +1233,7 @@ static esp_err_t stream_handler(httpd_req_t *req)
     {
         ESP_LOGE(TAG, "Failed to allocate context for client %d", client_id);
         httpd_req_async_handler_complete(async_req);
-        AudioBuffer::unregister_client(client_id);
+        release_stream_source(client_id, passthrough, &sub);
         clients[client_id].is_active = false;
         clients[client_id].socket_fd = -1;
         httpd_resp_send_500(req);
@@ -690,6 +1242,10 @@ static esp_err_t stream_handler(httpd_req_t *req)
 
     ctx->req = async_req;
     ctx->client_id = client_id;
+    ctx->format = format;
+    ctx->passthrough = passthrough;
+    ctx->fallback_watch = codec_auto && codec == StreamCodec::PCM_S16;
+    ctx->sub = sub;
 
     // Spawn streaming task on Core 1 (network core)
     char task_name[16];
@@ -709,7 +1265,7 @@ static esp_err_t stream_handler(httpd_req_t *req)
         ESP_LOGE(TAG, "Failed to create streaming task for client %d", client_id);
         httpd_req_async_handler_complete(async_req);
         free(ctx);
-        AudioBuffer::unregister_client(client_id);
+        release_stream_source(client_id, passthrough, &sub);
         clients[client_id].is_active = false;
         clients[client_id].socket_fd = -1;
         httpd_resp_send_500(req);
@@ -721,63 +1277,820 @@ static esp_err_t stream_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-// --- Status page handler ---
-
-static void format_uptime(uint32_t seconds, char *buf, size_t len)
+// GET /stream.sdp — session description of the RTP multicast output
+static esp_err_t stream_sdp_handler(httpd_req_t *req)
 {
-    uint32_t d = seconds / 86400;
-    uint32_t h = (seconds % 86400) / 3600;
-    uint32_t m = (seconds % 3600) / 60;
-    uint32_t s = seconds % 60;
-    if (d > 0)
-        snprintf(buf, len, "%ud %uh %um", d, h, m);
-    else if (h > 0)
-        snprintf(buf, len, "%uh %um %us", h, m, s);
-    else
-        snprintf(buf, len, "%um %us", m, s);
-}
+    char ip[16] = "0.0.0.0";
+    WiFiManager::get_ip_address(ip, sizeof(ip));
+    DeviceConfig config;
+    load_config_or_defaults(&config);
 
-static esp_err_t send_status_json(httpd_req_t *req, const char *ip, uint32_t sr,
-    float buf_fill, uint64_t frames, uint32_t underruns, uint32_t overruns,
-    bool clipping, bool streaming, uint32_t cpu0, uint32_t cpu1,
-    uint32_t heap_free, uint32_t heap_min, int8_t rssi, bool wifi,
-    uint8_t num_clients, uint32_t uptime, bool mqtt_enabled, bool mqtt_connected,
-    const char *mqtt_broker, const char *mqtt_state)
-{
-    httpd_resp_set_type(req, "application/json");
     add_cors_headers(req);
+    char sdp[512];
+    size_t len = RtpSender::build_sdp(sdp, sizeof(sdp), ip, config.device_name);
+    if (len == 0) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "RTP output is off");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "application/sdp");
+    httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=\"turntable.sdp\"");
+    return httpd_resp_send(req, sdp, len);
+}
 
-    char stream_url[96];
-    build_stream_url(ip, stream_url, sizeof(stream_url));
+// ─── HLS ─────────────────────────────────────────────────────────────────────
 
-    char json[900];
-    int len = snprintf(json, sizeof(json),
-        "{\"audio\":{\"sample_rate\":%u,\"bit_depth\":24,\"channels\":2,"
-        "\"buffer_fill_pct\":%.1f,\"total_frames\":%llu,"
-        "\"underrun_count\":%u,\"overrun_count\":%u,"
-        "\"clipping\":%s,\"streaming\":%s},"
-        "\"system\":{\"uptime_seconds\":%u,"
-        "\"cpu_core0_pct\":%u,\"cpu_core1_pct\":%u,"
-        "\"heap_free_bytes\":%u,\"heap_min_free_bytes\":%u},"
-        "\"mqtt\":{\"enabled\":%s,\"connected\":%s,\"broker\":\"%s\",\"last_state\":\"%s\"},"
-        "\"eq\":{\"enabled\":%s,\"active_bands\":%u},"
-        "\"network\":{\"wifi_connected\":%s,\"rssi_dbm\":%d,"
-        "\"ip_address\":\"%s\",\"active_clients\":%u,"
-        "\"stream_url\":\"%s\"}}",
-        sr, buf_fill, frames, underruns, overruns,
-        clipping ? "true" : "false", streaming ? "true" : "false",
-        uptime, cpu0, cpu1, heap_free, heap_min,
-        mqtt_enabled ? "true" : "false", mqtt_connected ? "true" : "false", mqtt_broker, mqtt_state,
-        EQProcessor::is_enabled() ? "true" : "false", (unsigned)EQProcessor::active_band_count(),
-        wifi ? "true" : "false", rssi, ip, num_clients, stream_url);
+// Segment URLs never change content (the session is part of the name), so a
+// caching proxy may keep them for as long as it likes
+static constexpr const char *HLS_IMMUTABLE = "public, max-age=3600, immutable";
 
-    httpd_resp_send(req, json, len);
+// A media segment goes out in pieces of this size (a 2 s segment is ~80 KB)
+static constexpr size_t HLS_SEND_CHUNK_BYTES = 8192;
+
+// 404 for a segment that left the cache (or a stale session): not cacheable,
+// and the connection stays open for the proxy's next request
+static esp_err_t hls_not_found(httpd_req_t *req, const char *msg)
+{
+    httpd_resp_set_status(req, "404 Not Found");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_sendstr(req, msg);
     return ESP_OK;
 }
 
-static esp_err_t send_status_html(httpd_req_t *req, const char *ip, uint32_t sr,
-    float buf_fill, uint64_t frames, uint32_t underruns, uint32_t overruns,
-    bool clipping, bool streaming, uint32_t cpu0, uint32_t cpu1,
+// GET /hls/live.m3u8, /hls/<session>-init.mp4, /hls/<session>-<seq>.m4s —
+// HLS from HlsSegmenter's cache (network/hls_segmenter.h). Answered on the
+// server task like /status: no stream client slot is taken. A segment is
+// sent straight from PSRAM in HLS_SEND_CHUNK_BYTES chunks, so no single
+// send waits on more than 8 KB of socket buffer and a client that stops
+// reading is dropped after send_wait_timeout on one chunk. The limit: the
+// server task does nothing else until the whole segment is out, so each
+// segment fetch delays /status and the other handlers by its transfer time
+// (80 KB is about 20 ms at 30 Mbit/s). Put a caching proxy in front
+// for more than a few players.
+static esp_err_t hls_handler(httpd_req_t *req)
+{
+    add_cors_headers(req);
+    const char *name = req->uri + strlen("/hls/");
+    char file[32];
+    size_t name_len = strcspn(name, "?");
+    if (name_len >= sizeof(file)) return hls_not_found(req, "No such HLS file");
+    memcpy(file, name, name_len);
+    file[name_len] = '\0';
+
+    if (strcmp(file, "live.m3u8") == 0) {
+        if (!HlsSegmenter::is_running()) return hls_not_found(req, "HLS output is off");
+        char playlist[768];
+        size_t len = HlsSegmenter::build_playlist(playlist, sizeof(playlist));
+        if (len == 0) {
+            // Enabled, first segment not complete yet
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            httpd_resp_set_hdr(req, "Retry-After", "1");
+            httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+            httpd_resp_sendstr(req, "HLS is starting");
+            return ESP_OK;
+        }
+        char cache_control[24];
+        snprintf(cache_control, sizeof(cache_control), "max-age=%lu",
+                 (unsigned long)HlsSegmenter::playlist_max_age_s());
+        httpd_resp_set_type(req, "application/vnd.apple.mpegurl");
+        httpd_resp_set_hdr(req, "Cache-Control", cache_control);
+        return httpd_resp_send(req, playlist, len);
+    }
+
+    // <session>-init.mp4 or <session>-<seq>.m4s, session in 8 hex digits
+    char *end = nullptr;
+    const uint32_t session = (uint32_t)strtoul(file, &end, 16);
+    if (end != file + 8 || *end != '-') return hls_not_found(req, "No such HLS file");
+    const char *rest = end + 1;
+
+    if (strcmp(rest, "init.mp4") == 0) {
+        uint8_t init[HLS_INIT_MAX_BYTES];
+        size_t len = HlsSegmenter::build_init(session, init, sizeof(init));
+        if (len == 0) return hls_not_found(req, "HLS session ended");
+        httpd_resp_set_type(req, "audio/mp4");
+        httpd_resp_set_hdr(req, "Cache-Control", HLS_IMMUTABLE);
+        return httpd_resp_send(req, (const char *)init, len);
+    }
+
+    const uint32_t seq = (uint32_t)strtoul(rest, &end, 10);
+    if (end == rest || strcmp(end, ".m4s") != 0) return hls_not_found(req, "No such HLS file");
+    const uint8_t *data = nullptr;
+    size_t len = 0;
+    int handle = HlsSegmenter::acquire(session, seq, &data, &len);
+    if (handle < 0) return hls_not_found(req, "Segment not in the cache");
+
+    // Pinned until sent: the segmenter fills other slots meanwhile
+    httpd_resp_set_type(req, "audio/mp4");
+    httpd_resp_set_hdr(req, "Cache-Control", HLS_IMMUTABLE);
+    esp_err_t err = ESP_OK;
+    size_t sent = 0;
+    while (err == ESP_OK && sent < len) {
+        const size_t n = len - sent < HLS_SEND_CHUNK_BYTES ? len - sent : HLS_SEND_CHUNK_BYTES;
+        err = httpd_resp_send_chunk(req, (const char *)data + sent, n);
+        if (err == ESP_OK) sent += n;
+    }
+    if (err == ESP_OK) err = httpd_resp_send_chunk(req, nullptr, 0);
+    HlsSegmenter::release(handle, sent);
+    return err;
+}
+
+// ─── WebSocket PCM stream ────────────────────────────────────────────────────
+
+// GET /ws/audio?latency_ms=N&format=s16|s24 — the capture as binary WebSocket
+// messages, for the /player page's AudioWorklet. Browsers buffer an endless
+// WAV response for seconds before playing it; here the player schedules the
+// samples itself. The stream takes a client slot like /stream, but its reader
+// starts `latency_ms` behind the live position instead of 1.5 s, so the
+// player's jitter buffer is full with the first burst.
+//
+// The first message is text: {"rate":48000,"channels":2,"bits":16,...}. Each
+// binary message is one read of the capture ring (one DMA block when keeping
+// up, up to WS_AUDIO_MAX_FRAMES when catching up), little-endian:
+//   0   u32  sequence number, +1 per message
+//   4   u32  capture frame index of the first frame (low 32 bits)
+//   8   i64  esp_timer µs at which that frame reached the capture ring
+//   16  PCM  stereo at the capture rate: s16 (dithered like the 16-bit
+//            streams) or packed s24
+// A frame index jump means the sender fell WS_AUDIO_RESYNC_MS behind and
+// skipped to the live position.
+//
+// The player sends {"ping":t,"buffer_ms":b,"underruns":u} every few seconds
+// (which also keeps the socket off the LRU purge list) and gets back
+// {"pong":t,"rx_us":…,"tx_us":…} to place the capture clock on its own.
+// Only the sender task writes to the socket: the pong goes out between audio
+// messages.
+static constexpr uint32_t WS_AUDIO_HEADER_BYTES      = 16;
+static constexpr uint32_t WS_AUDIO_MAX_FRAMES        = 960;    // Four DMA blocks
+static constexpr uint32_t WS_AUDIO_DEFAULT_LATENCY_MS = 80;
+static constexpr uint32_t WS_AUDIO_MAX_LATENCY_MS    = 1000;
+static constexpr uint32_t WS_AUDIO_RESYNC_MS         = 500;
+static constexpr uint16_t WS_CLOSE_TRY_AGAIN_LATER   = 1013;   // RFC 6455 §7.4 (IANA registry)
+
+// One /ws/audio connection, by client slot. `token` identifies the httpd
+// session and is cleared when httpd closes it, so a reused socket number is
+// never written to.
+struct WsAudioSession {
+    std::atomic<uint32_t> token;
+    std::atomic<bool>     pong_pending;
+    char                  ping[24];        // Player's timestamp, echoed as is
+    int64_t               ping_rx_us;
+    uint32_t              buffer_ms;       // Player's last report
+    uint32_t              underruns;
+};
+static WsAudioSession s_ws_sessions[ClientConnection::MAX_CLIENTS];
+static uint32_t s_ws_next_token = 0;
+
+struct WsAudioTaskContext {
+    int client_id;
+    int fd;
+    uint32_t token;
+    bool bits24;
+    Ditherer dither;
+    uint8_t in24[WS_AUDIO_MAX_FRAMES * AudioStream::BYTES_PER_FRAME];
+    uint8_t msg[WS_AUDIO_HEADER_BYTES + WS_AUDIO_MAX_FRAMES * AudioStream::BYTES_PER_FRAME];
+};
+
+static inline void ws_put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// httpd free_ctx of a /ws/audio session: slot in the low byte, token above
+static void ws_audio_session_closed(void *ctx)
+{
+    uintptr_t value = (uintptr_t)ctx;
+    uint32_t slot = (uint32_t)(value & 0xFF);
+    uint32_t token = (uint32_t)(value >> 8);
+    if (slot < ClientConnection::MAX_CLIENTS)
+    {
+        s_ws_sessions[slot].token.compare_exchange_strong(token, 0);
+    }
+}
+
+// Every write re-checks the session token first: httpd may have closed the
+// session (and handed its fd to a new connection) while the sender was
+// reading and dithering since the check at the top of its loop
+static bool ws_send(const WsAudioTaskContext *ctx, httpd_ws_frame_t *frame)
+{
+    if (s_ws_sessions[ctx->client_id].token.load(std::memory_order_acquire) != ctx->token)
+    {
+        return false;
+    }
+    return httpd_ws_send_frame_async(server, ctx->fd, frame) == ESP_OK;
+}
+
+static bool ws_send_text(const WsAudioTaskContext *ctx, const char *text)
+{
+    httpd_ws_frame_t frame = {};
+    frame.final = true;
+    frame.type = HTTPD_WS_TYPE_TEXT;
+    frame.payload = (uint8_t *)text;
+    frame.len = strlen(text);
+    return ws_send(ctx, &frame);
+}
+
+static void ws_audio_task(void *arg)
+{
+    WsAudioTaskContext *ctx = (WsAudioTaskContext *)arg;
+    const int client_id = ctx->client_id;
+    WsAudioSession &session = s_ws_sessions[client_id];
+    const uint32_t sample_bytes = ctx->bits24 ? 3 : 2;
+    uint32_t seq = 0;
+    uint32_t resyncs = 0;
+
+    ESP_LOGI(TAG, "WebSocket audio task started for client %d (%s)", client_id, ctx->bits24 ? "s24" : "s16");
+
+    while (clients[client_id].is_active && session.token.load(std::memory_order_acquire) == ctx->token)
+    {
+        if (session.pong_pending.load(std::memory_order_acquire))
+        {
+            char pong[96];
+            snprintf(pong, sizeof(pong), "{\"pong\":%s,\"rx_us\":%lld,\"tx_us\":%lld}", session.ping,
+                     (long long)session.ping_rx_us, (long long)esp_timer_get_time());
+            session.pong_pending.store(false, std::memory_order_release);
+            if (!ws_send_text(ctx, pong))
+            {
+                break;
+            }
+        }
+
+        // A sender the link held back this far skips to the live position
+        uint64_t captured = 0;
+        AudioBuffer::get_clock(&captured, nullptr);
+        uint64_t frame = AudioBuffer::reader_frame((uint8_t)client_id);
+        if (captured > frame && captured - frame > (uint64_t)current_sample_rate * WS_AUDIO_RESYNC_MS / 1000)
+        {
+            AudioBuffer::unregister_client((uint8_t)client_id);
+            AudioBuffer::register_client((uint8_t)client_id, 0);
+            frame = AudioBuffer::reader_frame((uint8_t)client_id);
+            ctx->dither.reset();
+            resyncs++;
+            ESP_LOGW(TAG, "WebSocket client %d %llu frames behind capture, resynced", client_id,
+                     (unsigned long long)(captured - frame));
+        }
+
+        size_t got = 0;
+        uint8_t *pcm = ctx->msg + WS_AUDIO_HEADER_BYTES;
+        AudioBuffer::read((uint8_t)client_id, ctx->bits24 ? pcm : ctx->in24, sizeof(ctx->in24), &got);
+        const size_t frames = got / AudioStream::BYTES_PER_FRAME;
+        if (frames == 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(2));
+            continue;
+        }
+        if (!ctx->bits24)
+        {
+            DitherMode mode = StreamEncoder::dither();
+            if (mode != ctx->dither.mode)
+            {
+                ctx->dither.mode = mode;
+                ctx->dither.reset();
+            }
+            ctx->dither.process_s24(ctx->in24, pcm, frames);
+        }
+
+        // Capture time of the first frame, from the capture clock
+        int64_t written_us = 0;
+        AudioBuffer::get_clock(&captured, &written_us);
+        const int64_t capture_us = written_us - (int64_t)((captured - frame) * 1000000 / current_sample_rate);
+        ws_put_le32(ctx->msg, seq++);
+        ws_put_le32(ctx->msg + 4, (uint32_t)frame);
+        ws_put_le32(ctx->msg + 8, (uint32_t)capture_us);
+        ws_put_le32(ctx->msg + 12, (uint32_t)((uint64_t)capture_us >> 32));
+
+        httpd_ws_frame_t ws_frame = {};
+        ws_frame.final = true;
+        ws_frame.type = HTTPD_WS_TYPE_BINARY;
+        ws_frame.payload = ctx->msg;
+        ws_frame.len = WS_AUDIO_HEADER_BYTES + frames * 2 * sample_bytes;
+        if (!ws_send(ctx, &ws_frame))
+        {
+            ESP_LOGI(TAG, "WebSocket client %d disconnected", client_id);
+            break;
+        }
+        clients[client_id].bytes_sent += ws_frame.len;
+
+        if (!AudioCapture::is_running())
+        {
+            ESP_LOGW(TAG, "Audio capture stopped, ending WebSocket stream");
+            break;
+        }
+    }
+
+    ESP_LOGI(TAG, "WebSocket client %d closing (%lu messages, %llu bytes, %lu resyncs; player %lu ms buffered, %lu underruns)",
+             client_id, (unsigned long)seq, clients[client_id].bytes_sent, (unsigned long)resyncs,
+             (unsigned long)session.buffer_ms, (unsigned long)session.underruns);
+
+    // Still our session (the sender ended it): have httpd close the socket
+    uint32_t token = ctx->token;
+    if (session.token.compare_exchange_strong(token, 0))
+    {
+        httpd_sess_trigger_close(server, ctx->fd);
+    }
+    AudioBuffer::unregister_client((uint8_t)client_id);
+    clients[client_id].is_active = false;
+    clients[client_id].socket_fd = -1;
+
+    free(ctx);
+    vTaskDelete(NULL);
+}
+
+// Refuse a WebSocket after the handshake: close frame with a status code
+static esp_err_t ws_refuse(httpd_req_t *req, uint16_t code, const char *reason)
+{
+    uint8_t payload[64];
+    size_t len = strlen(reason);
+    if (len > sizeof(payload) - 2) len = sizeof(payload) - 2;
+    payload[0] = (uint8_t)(code >> 8);
+    payload[1] = (uint8_t)code;
+    memcpy(payload + 2, reason, len);
+    httpd_ws_frame_t frame = {};
+    frame.final = true;
+    frame.type = HTTPD_WS_TYPE_CLOSE;
+    frame.payload = payload;
+    frame.len = len + 2;
+    httpd_ws_send_frame(req, &frame);
+    return ESP_OK;
+}
+
+// Handshake (GET): take a client slot, start the reader and the sender task
+static esp_err_t ws_audio_open(httpd_req_t *req)
+{
+    uint32_t latency_ms = WS_AUDIO_DEFAULT_LATENCY_MS;
+    bool bits24 = false;
+    char query[64] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK)
+    {
+        char value[16];
+        if (httpd_query_key_value(query, "latency_ms", value, sizeof(value)) == ESP_OK)
+        {
+            latency_ms = (uint32_t)strtoul(value, nullptr, 10);
+            if (latency_ms > WS_AUDIO_MAX_LATENCY_MS) latency_ms = WS_AUDIO_MAX_LATENCY_MS;
+        }
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK)
+        {
+            if (strcmp(value, "s24") == 0)
+                bits24 = true;
+            else if (strcmp(value, "s16") != 0)
+                return ws_refuse(req, 1008, "format must be s16 or s24");
+        }
+    }
+
+    int client_id = find_free_slot();
+    if (client_id < 0)
+    {
+        ESP_LOGW(TAG, "Max clients reached, refusing WebSocket");
+        return ws_refuse(req, WS_CLOSE_TRY_AGAIN_LATER, "Maximum clients reached");
+    }
+
+    WsAudioTaskContext *ctx = (WsAudioTaskContext *)malloc(sizeof(WsAudioTaskContext));
+    const uint32_t behind_bytes = current_sample_rate * latency_ms / 1000 * AudioStream::BYTES_PER_FRAME;
+    if (ctx == nullptr || !AudioBuffer::register_client((uint8_t)client_id, behind_bytes))
+    {
+        ESP_LOGE(TAG, "Failed to set up WebSocket client %d", client_id);
+        free(ctx);
+        return ws_refuse(req, 1011, "Server error");
+    }
+
+    // Session token: httpd hands it to ws_audio_session_closed() on close
+    WsAudioSession &session = s_ws_sessions[client_id];
+    if (++s_ws_next_token > 0xFFFFFF) s_ws_next_token = 1;
+    session.token.store(s_ws_next_token, std::memory_order_release);
+    session.pong_pending.store(false, std::memory_order_relaxed);
+    session.buffer_ms = 0;
+    session.underruns = 0;
+    req->sess_ctx = (void *)(uintptr_t)((s_ws_next_token << 8) | (uint32_t)client_id);
+    req->free_ctx = ws_audio_session_closed;
+
+    const int fd = httpd_req_to_sockfd(req);
+    clients[client_id].is_active = true;
+    clients[client_id].socket_fd = fd;
+    clients[client_id].bytes_sent = 0;
+    clients[client_id].underrun_count = 0;
+    clients[client_id].connected_at = esp_timer_get_time();
+    clients[client_id].ip_address = peer_ipv4(fd);
+
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    ctx->client_id = client_id;
+    ctx->fd = fd;
+    ctx->token = s_ws_next_token;
+    ctx->bits24 = bits24;
+    ctx->dither.init(StreamEncoder::dither(), 0xBB67AE85u + (uint32_t)client_id);
+
+    char hello[160];
+    snprintf(hello, sizeof(hello),
+             "{\"rate\":%lu,\"channels\":2,\"bits\":%u,\"header_bytes\":%lu,\"latency_ms\":%lu,\"server_us\":%lld}",
+             (unsigned long)current_sample_rate, bits24 ? 24 : 16, (unsigned long)WS_AUDIO_HEADER_BYTES,
+             (unsigned long)latency_ms, (long long)esp_timer_get_time());
+    httpd_ws_frame_t frame = {};
+    frame.final = true;
+    frame.type = HTTPD_WS_TYPE_TEXT;
+    frame.payload = (uint8_t *)hello;
+    frame.len = strlen(hello);
+
+    char task_name[16];
+    snprintf(task_name, sizeof(task_name), "ws_audio_%d", client_id);
+    if (httpd_ws_send_frame(req, &frame) != ESP_OK ||
+        xTaskCreatePinnedToCore(ws_audio_task, task_name, 4096, ctx,
+                                6,      // Same as the HTTP stream tasks
+                                nullptr, 1) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to start WebSocket client %d", client_id);
+        session.token.store(0, std::memory_order_release);
+        AudioBuffer::unregister_client((uint8_t)client_id);
+        clients[client_id].is_active = false;
+        clients[client_id].socket_fd = -1;
+        free(ctx);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "WebSocket client %d connected (fd %d, %s, %lu ms behind live)", client_id, fd,
+             bits24 ? "s24" : "s16", (unsigned long)latency_ms);
+    return ESP_OK;
+}
+
+static esp_err_t ws_audio_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET)
+    {
+        return ws_audio_open(req);
+    }
+
+    // Player → device: the ping / report text message
+    const int64_t rx_us = esp_timer_get_time();
+    httpd_ws_frame_t frame = {};
+    if (httpd_ws_recv_frame(req, &frame, 0) != ESP_OK || frame.len > 128)
+    {
+        return ESP_FAIL;
+    }
+    char text[129];
+    frame.payload = (uint8_t *)text;
+    if (frame.len > 0 && httpd_ws_recv_frame(req, &frame, frame.len) != ESP_OK)
+    {
+        return ESP_FAIL;
+    }
+    text[frame.len] = '\0';
+
+    uintptr_t value = (uintptr_t)req->sess_ctx;
+    uint32_t slot = (uint32_t)(value & 0xFF);
+    if (frame.type != HTTPD_WS_TYPE_TEXT || req->sess_ctx == nullptr || slot >= ClientConnection::MAX_CLIENTS ||
+        s_ws_sessions[slot].token.load(std::memory_order_acquire) != (uint32_t)(value >> 8))
+    {
+        return ESP_OK;
+    }
+
+    WsAudioSession &session = s_ws_sessions[slot];
+    cJSON *root = cJSON_Parse(text);
+    if (root == nullptr)
+    {
+        return ESP_OK;
+    }
+    cJSON *buffer_ms = cJSON_GetObjectItem(root, "buffer_ms");
+    cJSON *underruns = cJSON_GetObjectItem(root, "underruns");
+    if (cJSON_IsNumber(buffer_ms)) session.buffer_ms = (uint32_t)buffer_ms->valuedouble;
+    if (cJSON_IsNumber(underruns)) session.underruns = (uint32_t)underruns->valuedouble;
+    cJSON *ping = cJSON_GetObjectItem(root, "ping");
+    if (cJSON_IsNumber(ping) && !session.pong_pending.load(std::memory_order_acquire))
+    {
+        snprintf(session.ping, sizeof(session.ping), "%.3f", ping->valuedouble);
+        session.ping_rx_us = rx_us;
+        session.pong_pending.store(true, std::memory_order_release);
+    }
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+// GET /player — low-latency browser player for /ws/audio. The AudioWorklet
+// keeps a ring of decoded samples and starts once it holds the target
+// latency. Its read position advances at 1 ± 0.2 % of real time to hold the
+// smoothed (~0.3 s) buffer level at the target, with linear interpolation,
+// which absorbs clock drift between the ADC and the sound card. An empty ring
+// re-buffers; an excess of more than max(40 ms, target / 2) is dropped at
+// once (latency lowered). In adaptive mode the target rises to the arrival
+// jitter measured over the last 10 s plus 10 ms.
+static esp_err_t player_page_handler(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "text/html; charset=utf-8");
+
+    httpd_resp_sendstr_chunk(req,
+        "<!DOCTYPE html><html><head>"
+        "<meta charset='UTF-8'><meta name='viewport' content='width=device-width,initial-scale=1'>"
+        "<title>Player</title>"
+        "<style>"
+        "*{box-sizing:border-box;margin:0;padding:0}"
+        "body{font-family:system-ui,sans-serif;max-width:760px;margin:0 auto;padding:12px;background:#1a1a2e;color:#e0e0e0}"
+        "h1{font-size:18px;margin-bottom:12px;color:#fff}"
+        ".c{background:#16213e;border-radius:8px;padding:12px;margin-bottom:10px}"
+        ".c h2{font-size:14px;color:#0f969c;margin-bottom:10px;border-bottom:1px solid #1a1a3e;padding-bottom:4px}"
+        "table{width:100%;border-collapse:collapse;font-size:13px}"
+        "td{padding:4px 6px;vertical-align:middle}"
+        "td.v{color:#0f969c;font-weight:bold;text-align:right}"
+        "select{background:#0d1b2a;color:#e0e0e0;border:1px solid #0f969c;border-radius:4px;padding:4px 6px;width:100%;font-size:12px}"
+        "input[type=range]{width:100%;accent-color:#0f969c}"
+        "input[type=checkbox]{width:16px;height:16px;accent-color:#0f969c;cursor:pointer}"
+        ".btn{display:inline-block;padding:8px 16px;border-radius:6px;border:none;background:#0f969c;color:#fff;cursor:pointer;font-size:14px;margin-right:8px}"
+        ".btn.alt{background:#4b5563}"
+        ".nav{display:flex;gap:8px;margin-bottom:12px}"
+        "a.btn{text-decoration:none}"
+        "</style></head><body>"
+        "<h1>&#127911; Low-Latency Player</h1>"
+        "<div class='nav'>"
+        "<a class='btn alt' href='/status'>&#8592; Status</a>"
+        "<a class='btn alt' href='/eq-settings'>EQ Settings</a>"
+        "</div>"
+        "<div class='c'><h2>Playback</h2><table>"
+        "<tr><td style='width:40%'><button class='btn' id='go' onclick='toggle()'>Play</button></td>"
+        "<td><select id='fmt'><option value='s16'>16-bit (1.5 Mbit/s)</option>"
+        "<option value='s24'>24-bit (2.3 Mbit/s)</option></select></td></tr>"
+        "<tr><td>Latency <span id='latv'></span></td>"
+        "<td><input type='range' id='lat' min='20' max='500' step='10' value='80' oninput='setTarget()'></td></tr>"
+        "<tr><td><label style='cursor:pointer'><input type='checkbox' id='ad' checked onchange='setTarget()'>"
+        " Adaptive</label></td><td style='font-size:12px;color:#888'>Raise the latency to the measured network jitter</td></tr>"
+        "</table></div>"
+        "<div class='c'><h2>Stream</h2><table>"
+        "<tr><td>State</td><td class='v' id='state'>Stopped</td></tr>"
+        "<tr><td>Start-up (click to sound)</td><td class='v' id='startup'>-</td></tr>"
+        "<tr><td>Buffered / target</td><td class='v' id='buf'>-</td></tr>"
+        "<tr><td>Network jitter (10 s)</td><td class='v' id='jit'>-</td></tr>"
+        "<tr><td>Capture to speaker</td><td class='v' id='e2e'>-</td></tr>"
+        "<tr><td>Underruns</td><td class='v' id='un'>0</td></tr>"
+        "<tr><td>Messages</td><td class='v' id='msgs'>0</td></tr>"
+        "</table></div>");
+
+    char rate[48];
+    snprintf(rate, sizeof(rate), "<script>const RATE=%lu;", (unsigned long)current_sample_rate);
+    httpd_resp_sendstr_chunk(req, rate);
+
+    // AudioWorklet processor, loaded from a Blob URL
+    httpd_resp_sendstr_chunk(req,
+        "const WL=`class P extends AudioWorkletProcessor{"
+        "constructor(){super();this.n=sampleRate*2|0;this.L=new Float32Array(this.n);this.R=new Float32Array(this.n);"
+        "this.w=0;this.r=0;this.lf=0;this.on=false;this.tg=0.08*sampleRate;this.un=0;this.cap=[];this.t=0;"
+        "this.port.onmessage=e=>{const d=e.data;"
+        "if(d.target){this.tg=d.target*sampleRate/1000;return;}"
+        "if(d.reset){this.r=this.w;this.on=false;this.cap=[];return;}"
+        "this.push(d);};}"
+        "push(d){const v=new DataView(d.buf),b=d.bits/8,n=(d.buf.byteLength-16)/(2*b)|0;"
+        "for(let i=0;i<n;i++){const k=(this.w+i)%this.n,o=16+i*2*b;"
+        "if(b==2){this.L[k]=v.getInt16(o,true)/32768;this.R[k]=v.getInt16(o+2,true)/32768;}"
+        "else{this.L[k]=(v.getUint8(o)|v.getUint8(o+1)<<8|v.getInt8(o+2)<<16)/8388608;"
+        "this.R[k]=(v.getUint8(o+3)|v.getUint8(o+4)<<8|v.getInt8(o+5)<<16)/8388608;}}"
+        "this.cap.push([this.w,d.cap]);if(this.cap.length>1024)this.cap.shift();"
+        "this.w+=n;if(this.w-this.r>this.n-n)this.r=this.w-this.tg;}"
+        "process(i,o){const L=o[0][0],R=o[0][1]||L,m=L.length;let lv=this.w-this.r;"
+        "if(!this.on&&lv>=this.tg){this.on=true;this.lf=lv;this.port.postMessage({started:1});}"
+        "if(this.on){"
+        "if(lv>this.tg+Math.max(0.04*sampleRate,this.tg/2)){this.r=this.w-this.tg;this.lf=lv=this.tg;}"
+        "this.lf+=(lv-this.lf)*0.01;"
+        "const q=1+Math.max(-0.002,Math.min(0.002,(this.lf-this.tg)/sampleRate*0.2));"
+        "for(let j=0;j<m;j++){const a=Math.floor(this.r);"
+        "if(a+1>=this.w){this.on=false;this.un++;L.fill(0,j);R.fill(0,j);break;}"
+        "const f=this.r-a,x=a%this.n,y=(a+1)%this.n;"
+        "L[j]=this.L[x]+(this.L[y]-this.L[x])*f;R[j]=this.R[x]+(this.R[y]-this.R[x])*f;this.r+=q;}}"
+        "else{L.fill(0);R.fill(0);}"
+        "if(currentTime-this.t>=0.25){this.t=currentTime;"
+        "while(this.cap.length>1&&this.cap[1][0]<=this.r)this.cap.shift();const c=this.cap[0];"
+        "this.port.postMessage({lv:(this.w-this.r)/sampleRate*1000,un:this.un,on:this.on,ct:currentTime,"
+        "cap:c&&c[0]<=this.r?c[1]+(this.r-c[0])/sampleRate*1e6:null});}"
+        "return true;}}"
+        "registerProcessor('ws-pcm',P);`;");
+
+    httpd_resp_sendstr_chunk(req,
+        "let ac=null,nd=null,ws=null,pt=null,tClick=0,ofs=null,rtt=1e12,nf=null,f0=0,t0=0,arr=[],jit=0,msgs=0,bits=16;"
+        "const $=i=>document.getElementById(i);"
+        "function target(){const m=+$('lat').value;return $('ad').checked?Math.max(m,Math.ceil(jit+10)):m;}"
+        "function setTarget(){$('latv').textContent=$('lat').value+' ms';if(nd)nd.port.postMessage({target:target()});}"
+        "function ping(){if(ws&&ws.readyState===1)ws.send(JSON.stringify({ping:performance.now()*1000,"
+        "buffer_ms:Math.round(+($('buf').dataset.lv||0)),underruns:+$('un').textContent}));}"
+        "function show(d){$('buf').dataset.lv=d.lv;"
+        "$('buf').textContent=d.lv.toFixed(0)+' / '+target()+' ms';$('un').textContent=d.un;$('msgs').textContent=msgs;"
+        "$('jit').textContent=jit.toFixed(1)+' ms';$('state').textContent=d.on?'Playing':'Buffering';"
+        "if(ofs!==null&&d.cap!==null){let p;"
+        "if(ac.getOutputTimestamp){const ts=ac.getOutputTimestamp();p=ts.performanceTime+(d.ct-ts.contextTime)*1000;}"
+        "else p=performance.now()+((ac.outputLatency||0)+ac.baseLatency)*1000;"
+        "$('e2e').textContent='\\u2248 '+((p*1000+ofs-d.cap)/1000).toFixed(0)+' ms';}"
+        "setTarget();}"
+        "function stop(msg){if(ws){ws.onclose=null;ws.close();ws=null;}clearInterval(pt);"
+        "if(nd){nd.disconnect();nd=null;}$('go').textContent='Play';$('state').textContent=msg||'Stopped';}"
+        "async function toggle(){if(ws){stop();return;}"
+        "tClick=performance.now();$('startup').textContent='-';"
+        "if(!ac){ac=new AudioContext({sampleRate:RATE,latencyHint:'interactive'});"
+        "await ac.audioWorklet.addModule(URL.createObjectURL(new Blob([WL],{type:'application/javascript'})));}"
+        "await ac.resume();"
+        "nd=new AudioWorkletNode(ac,'ws-pcm',{outputChannelCount:[2]});nd.connect(ac.destination);"
+        "nd.port.onmessage=e=>{if(e.data.started){if($('startup').textContent==='-')"
+        "$('startup').textContent=(performance.now()-tClick).toFixed(0)+' ms';}else show(e.data);};"
+        "nf=null;arr=[];jit=0;msgs=0;ofs=null;rtt=1e12;setTarget();"
+        "const fmt=$('fmt').value;bits=fmt==='s24'?24:16;"
+        "ws=new WebSocket(`ws://${location.host}/ws/audio?latency_ms=${target()}&format=${fmt}`);"
+        "ws.binaryType='arraybuffer';$('go').textContent='Stop';$('state').textContent='Connecting';"
+        "ws.onopen=()=>{pt=setInterval(ping,2000);[0,250,500,750,1000].forEach(t=>setTimeout(ping,t));};"
+        "ws.onclose=e=>stop('Closed'+(e.reason?': '+e.reason:''));"
+        "ws.onmessage=e=>{"
+        "if(typeof e.data==='string'){const m=JSON.parse(e.data);"
+        // Clock offset from the lowest-delay ping of recent ones
+        "if(m.pong!==undefined){const t4=performance.now()*1000,r=(t4-m.pong)-(m.tx_us-m.rx_us);"
+        "rtt=Math.min(rtt+1000,1e12);if(r<=rtt){rtt=r;ofs=((m.rx_us-m.pong)+(m.tx_us-t4))/2;}}"
+        "return;}"
+        "const v=new DataView(e.data),fr=v.getUint32(4,true),n=(e.data.byteLength-16)/(bits/4),now=performance.now();"
+        // A frame jump: the device resynced to live, so start over
+        "if(nf!==null&&fr!==nf){nd.port.postMessage({reset:1});arr=[];}"
+        "if(nf===null||fr!==nf){f0=fr;t0=now;}"
+        "nf=(fr+n)>>>0;msgs++;"
+        "const late=now-t0-((fr-f0)>>>0)/RATE*1000;arr.push([now,late]);while(arr[0][0]<now-10000)arr.shift();"
+        "let lo=1e9,hi=-1e9;for(const a of arr){lo=Math.min(lo,a[1]);hi=Math.max(hi,a[1]);}jit=hi-lo;"
+        "nd.port.postMessage({buf:e.data,bits:bits,cap:Number(v.getBigInt64(8,true))},[e.data]);};}"
+        "$('fmt').onchange=()=>{if(ws){stop();toggle();}};"
+        "setTarget();"
+        "</script></body></html>");
+
+    httpd_resp_sendstr_chunk(req, nullptr);
+    return ESP_OK;
+}
+
+// --- Status page handler ---
+
+static void format_uptime(uint32_t seconds, char *buf, size_t len)
+{
+    uint32_t d = seconds / 86400;
+    uint32_t h = (seconds % 86400) / 3600;
+    uint32_t m = (seconds % 3600) / 60;
+    uint32_t s = seconds % 60;
+    if (d > 0)
+        snprintf(buf, len, "%ud %uh %um", d, h, m);
+    else if (h > 0)
+        snprintf(buf, len, "%uh %um %us", h, m, s);
+    else
+        snprintf(buf, len, "%um %us", m, s);
+}
+
+static esp_err_t send_status_json(httpd_req_t *req, const char *ip, uint32_t sr,
+    float buf_fill, uint64_t frames, uint32_t underruns, uint32_t overruns,
+    bool clipping, bool streaming, uint32_t cpu0, uint32_t cpu1,
+    uint32_t heap_free, uint32_t heap_min, int8_t rssi, bool wifi,
+    uint8_t num_clients, uint32_t uptime, bool mqtt_enabled, bool mqtt_connected,
+    const char *mqtt_broker, const char *mqtt_state)
+{
+    httpd_resp_set_type(req, "application/json");
+    add_cors_headers(req);
+
+    char stream_url[96];
+    build_stream_url(ip, stream_url, sizeof(stream_url));
+
+    EQStats eq_stats;
+    EQProcessor::get_stats(&eq_stats);
+
+    char json[5632];
+    int len = snprintf(json, sizeof(json),
+        "{\"audio\":{\"sample_rate\":%u,\"bit_depth\":24,\"channels\":2,"
+        "\"buffer_fill_pct\":%.1f,\"total_frames\":%llu,"
+        "\"underrun_count\":%u,\"overrun_count\":%u,"
+        "\"clipping\":%s,\"streaming\":%s},"
+        "\"system\":{\"uptime_seconds\":%u,"
+        "\"cpu_core0_pct\":%u,\"cpu_core1_pct\":%u,"
+        "\"heap_free_bytes\":%u,\"heap_min_free_bytes\":%u},"
+        "\"mqtt\":{\"enabled\":%s,\"connected\":%s,\"broker\":\"%s\",\"last_state\":\"%s\"},"
+        "\"eq\":{\"enabled\":%s,\"active_bands\":%u,"
+        "\"fast_path_active\":%s,\"fast_path_pct\":%.1f,\"fast_path_seconds\":%.1f,"
+        "\"cycles_per_block_full\":%lu,\"cycles_per_block_fast\":%lu,\"denormal_flushes\":%lu},"
+        "\"network\":{\"wifi_connected\":%s,\"rssi_dbm\":%d,"
+        "\"ip_address\":\"%s\",\"active_clients\":%u,"
+        "\"stream_url\":\"%s\"}",
+        sr, buf_fill, frames, underruns, overruns,
+        clipping ? "true" : "false", streaming ? "true" : "false",
+        uptime, cpu0, cpu1, heap_free, heap_min,
+        mqtt_enabled ? "true" : "false", mqtt_connected ? "true" : "false", mqtt_broker, mqtt_state,
+        EQProcessor::is_enabled() ? "true" : "false", (unsigned)EQProcessor::active_band_count(),
+        eq_stats.in_fast_path ? "true" : "false", eq_stats.fast_path_pct, eq_stats.fast_path_seconds,
+        (unsigned long)eq_stats.cycles_full_avg, (unsigned long)eq_stats.cycles_fast_avg,
+        (unsigned long)eq_stats.denormal_flushes,
+        wifi ? "true" : "false", rssi, ip, num_clients, stream_url);
+
+    LimiterStats lim;
+    PeakLimiter::get_stats(&lim);
+    len += snprintf(json + len, sizeof(json) - len,
+        ",\"limiter\":{\"enabled\":%s,\"ceiling_db\":%.1f,\"release_ms\":%.0f,"
+        "\"lookahead_frames\":%u,\"gain_reduction_db\":%.2f,\"max_gain_reduction_db\":%.2f,"
+        "\"limited_blocks\":%lu,\"total_blocks\":%lu,"
+        "\"cycles_per_block_avg\":%lu,\"cycles_per_block_max\":%lu,\"block_budget_pct\":%.2f}",
+        lim.enabled ? "true" : "false", lim.ceiling_db, lim.release_ms,
+        lim.lookahead_frames, lim.gain_reduction_db, lim.max_gain_reduction_db,
+        (unsigned long)lim.limited_blocks, (unsigned long)lim.total_blocks,
+        (unsigned long)lim.cycles_avg, (unsigned long)lim.cycles_max, lim.budget_pct);
+
+    AGCStats agc;
+    AutoGain::get_stats(&agc);
+    len += snprintf(json + len, sizeof(json) - len,
+        ",\"agc\":{\"enabled\":%s,\"holding\":%s,\"target_lufs\":%.1f,\"short_term_lufs\":%.1f,"
+        "\"gain_db\":%.2f,\"target_gain_db\":%.2f,\"max_gain_db\":%.1f,"
+        "\"cycles_per_block_avg\":%lu,\"cycles_per_block_max\":%lu,\"block_budget_pct\":%.2f}",
+        agc.enabled ? "true" : "false", agc.holding ? "true" : "false", agc.target_lufs,
+        agc.short_term_lufs, agc.gain_db, agc.target_gain_db, agc.max_gain_db,
+        (unsigned long)agc.cycles_avg, (unsigned long)agc.cycles_max, agc.budget_pct);
+
+    FIRStats fir;
+    FIRFilter::get_stats(&fir);
+    len += snprintf(json + len, sizeof(json) - len,
+        ",\"fir\":{\"active\":%s,\"taps\":%u,\"partitions\":%u,"
+        "\"head_budget_pct\":%.2f,\"tail_budget_pct\":%.2f,\"deadline_misses\":%lu}",
+        fir.active ? "true" : "false", fir.taps, fir.partitions,
+        fir.head_budget_pct, fir.tail_budget_pct, (unsigned long)fir.deadline_misses);
+
+    SpectrumStats spec;
+    SpectrumAnalyzer::get_stats(&spec);
+    len += snprintf(json + len, sizeof(json) - len,
+        ",\"spectrum\":{\"active\":%s,\"fps\":%u,\"frames\":%lu,\"lost_frames\":%lu,"
+        "\"cycles_per_frame_avg\":%lu,\"cycles_per_frame_max\":%lu,\"core1_load_pct\":%.2f}",
+        spec.active ? "true" : "false", spec.fps, (unsigned long)spec.frames,
+        (unsigned long)spec.lost_frames, (unsigned long)spec.cycles_avg,
+        (unsigned long)spec.cycles_max, spec.core1_load_pct);
+
+    StreamEncoderStats enc;
+    StreamEncoder::get_stats(&enc);
+    len += snprintf(json + len, sizeof(json) - len,
+        ",\"encoder\":{\"capture_rate\":%lu,\"dither\":\"%s\",\"active_pipes\":%u,\"pipes\":[",
+        (unsigned long)enc.capture_rate, dither_mode_to_str(enc.dither), enc.active_pipes);
+    bool first_pipe = true;
+    for (int i = 0; i < STREAM_ENCODER_MAX_PIPES; i++) {
+        const StreamPipeStats &ps = enc.pipe[i];
+        if (!ps.active) continue;
+        len += snprintf(json + len, sizeof(json) - len,
+            "%s{\"codec\":\"%s\",\"sample_rate\":%lu,\"channels\":%u,\"resampling\":%s,\"subscribers\":%u,"
+            "\"blocks\":%lu,\"compression\":%.2f,\"laps\":%lu,"
+            "\"cycles_per_block_avg\":%lu,\"cycles_per_block_max\":%lu,"
+            "\"cycles_per_channel_second\":%lu,\"core\":%u,\"core_load_pct\":%.2f,"
+            "\"bitrate_kbps\":%u,\"latency_ms\":%.1f,\"complexity\":%u,\"budget_overruns\":%lu}",
+            first_pipe ? "" : ",", stream_codec_to_str(ps.format.codec),
+            (unsigned long)ps.format.sample_rate, ps.format.channels, ps.resampling ? "true" : "false", ps.subscribers,
+            (unsigned long)ps.blocks, ps.compression, (unsigned long)ps.laps,
+            (unsigned long)ps.cycles_per_block_avg, (unsigned long)ps.cycles_per_block_max,
+            (unsigned long)ps.cycles_per_channel_second, ps.core, ps.core_load_pct,
+            ps.bitrate_kbps, ps.latency_ms, ps.complexity, (unsigned long)ps.budget_overruns);
+        first_pipe = false;
+    }
+    len += snprintf(json + len, sizeof(json) - len, "]}");
+
+    RtpStats rtp;
+    RtpSender::get_stats(&rtp);
+    len += snprintf(json + len, sizeof(json) - len,
+        ",\"rtp\":{\"running\":%s,\"group\":\"%s\",\"port\":%u,\"payload\":\"L%u\",\"ttl\":%u,"
+        "\"packet_frames\":%lu,\"packets\":%lu,\"octets\":%lu,\"send_errors\":%lu,\"resyncs\":%lu,"
+        "\"latency_ms_avg\":%.2f,\"latency_ms_max\":%.2f}",
+        rtp.running ? "true" : "false", rtp.group, rtp.port, rtp.bits, rtp.ttl,
+        (unsigned long)rtp.packet_frames, (unsigned long)rtp.packets, (unsigned long)rtp.octets,
+        (unsigned long)rtp.send_errors, (unsigned long)rtp.resyncs,
+        rtp.latency_ms_avg, rtp.latency_ms_max);
+
+    SnapcastStats snap;
+    SnapcastServer::get_stats(&snap);
+    len += snprintf(json + len, sizeof(json) - len,
+        ",\"snapcast\":{\"running\":%s,\"port\":%u,\"codec\":\"%s\",\"buffer_ms\":%u,"
+        "\"chunks\":%lu,\"stale_chunks\":%lu,\"dropped_clients\":%lu,"
+        "\"chunk_age_ms_avg\":%.2f,\"chunk_age_ms_max\":%.2f,\"clock_jitter_us\":%.1f,\"clients\":[",
+        snap.running ? "true" : "false", SNAPCAST_PORT, snapcast_codec_to_str(snap.codec), snap.buffer_ms,
+        (unsigned long)snap.chunks, (unsigned long)snap.stale_chunks, (unsigned long)snap.dropped_clients,
+        snap.chunk_age_ms_avg, snap.chunk_age_ms_max, snap.clock_jitter_us);
+    bool first_client = true;
+    for (int i = 0; i < SNAPCAST_MAX_CLIENTS; i++) {
+        const SnapcastClientStats &sc = snap.client[i];
+        if (!sc.connected) continue;
+        len += snprintf(json + len, sizeof(json) - len,
+            "%s{\"name\":\"%s\",\"ip\":\"%s\",\"streaming\":%s,\"chunks\":%lu,\"skipped\":%lu,"
+            "\"time_syncs\":%lu,\"outbox_max\":%lu}",
+            first_client ? "" : ",", sc.name, sc.ip, sc.streaming ? "true" : "false",
+            (unsigned long)sc.chunks, (unsigned long)sc.skipped, (unsigned long)sc.time_syncs,
+            (unsigned long)sc.outbox_max);
+        first_client = false;
+    }
+    len += snprintf(json + len, sizeof(json) - len, "]}");
+
+    HlsStats hls;
+    HlsSegmenter::get_stats(&hls);
+    len += snprintf(json + len, sizeof(json) - len,
+        ",\"hls\":{\"running\":%s,\"session\":\"%08lx\",\"segment_s\":%u,\"sequence\":%lu,\"cached\":%u,"
+        "\"cache_bytes\":%lu,\"segment_bytes_avg\":%lu,\"segment_bytes_max\":%lu,"
+        "\"discontinuities\":%lu,\"dropped_frames\":%lu,"
+        "\"package_cycles_avg\":%lu,\"encode_cycles_avg\":%lu,\"core1_load_pct\":%.2f,"
+        "\"playlist_requests\":%lu,\"segment_requests\":%lu,\"misses\":%lu,\"bytes_served\":%llu}}",
+        hls.running ? "true" : "false", (unsigned long)hls.session, hls.segment_s,
+        (unsigned long)hls.sequence, hls.cached, (unsigned long)hls.cache_bytes,
+        (unsigned long)hls.segment_bytes_avg, (unsigned long)hls.segment_bytes_max,
+        (unsigned long)hls.discontinuities, (unsigned long)hls.dropped_frames,
+        (unsigned long)hls.package_cycles_avg, (unsigned long)hls.encode_cycles_avg, hls.core1_load_pct,
+        (unsigned long)hls.playlist_requests, (unsigned long)hls.segment_requests, (unsigned long)hls.misses,
+        (unsigned long long)hls.bytes_served);
+
+    httpd_resp_send(req, json, len);
+    return ESP_OK;
+}
+
+static esp_err_t send_status_html(httpd_req_t *req, const char *ip, uint32_t sr,
+    float buf_fill, uint64_t frames, uint32_t underruns, uint32_t overruns,
+    bool clipping, bool streaming, uint32_t cpu0, uint32_t cpu1,
     uint32_t heap_free, uint32_t heap_min, int8_t rssi, bool wifi,
     uint8_t num_clients, uint32_t uptime, bool mqtt_enabled, bool mqtt_connected,
     const char *mqtt_broker, const char *mqtt_state)
@@ -807,9 +2120,9 @@ static esp_err_t send_status_html(httpd_req_t *req, const char *ip, uint32_t sr,
         ".url{background:#0d1b2a;padding:8px;border-radius:4px;font-family:monospace;font-size:12px;word-break:break-all;margin-top:4px}"
         ".ft{text-align:center;font-size:11px;color:#555;margin-top:8px}.nav{display:flex;gap:8px;margin-bottom:12px}.btn{display:inline-block;padding:8px 10px;border-radius:6px;background:#0f969c;color:#fff;text-decoration:none;font-size:12px}"
         "</style></head><body>"
-        "<h1>&#127925; ESP32 Audio Streamer</h1><div class='nav'><a class='btn' href='/mqtt-settings'>MQTT Settings</a><a class='btn' href='/eq-settings'>EQ Settings</a><a class='btn' href='/stream'>Open Stream</a></div>");
+        "<h1>&#127925; ESP32 Audio Streamer</h1><div class='nav'><a class='btn' href='/mqtt-settings'>MQTT Settings</a><a class='btn' href='/eq-settings'>EQ Settings</a><a class='btn' href='/stream'>Open Stream</a><a class='btn' href='/player'>Player</a></div>");
 
-    char buf[384];
+    char buf[512];
 
     // Audio section
     const char *buf_class = (buf_fill > 50) ? "ok" : (buf_fill > 10) ? "warn" : "err";
@@ -855,6 +2168,53 @@ static esp_err_t send_status_html(httpd_req_t *req, const char *ip, uint32_t sr,
         mqtt_broker, mqtt_state);
     httpd_resp_sendstr_chunk(req, buf);
 
+    // EQ section
+    EQStats eq_stats;
+    EQProcessor::get_stats(&eq_stats);
+    snprintf(buf, sizeof(buf),
+        "<div class='c'><h2>EQ</h2>"
+        "<div class='r'><span class='l'>Enabled</span><span class='v'>%s (%u bands)</span></div>"
+        "<div class='r'><span class='l'>Silent Fast Path</span><span class='v'>%s, %.1f%% of blocks</span></div>"
+        "<div class='r'><span class='l'>Cost per Block</span><span class='v'>%lu / %lu cycles (full / fast)</span></div>"
+        "</div>",
+        EQProcessor::is_enabled() ? "Yes" : "No", (unsigned)EQProcessor::active_band_count(),
+        eq_stats.in_fast_path ? "Active" : "Idle", eq_stats.fast_path_pct,
+        (unsigned long)eq_stats.cycles_full_avg, (unsigned long)eq_stats.cycles_fast_avg);
+    httpd_resp_sendstr_chunk(req, buf);
+
+    // Limiter section
+    LimiterStats lim;
+    PeakLimiter::get_stats(&lim);
+    snprintf(buf, sizeof(buf),
+        "<div class='c'><h2>Limiter</h2>"
+        "<div class='r'><span class='l'>Enabled</span><span class='v %s'>%s</span></div>"
+        "<div class='r'><span class='l'>Gain Reduction</span><span class='v %s'>%.1f dB (max %.1f dB)</span></div>"
+        "<div class='r'><span class='l'>Limited Blocks</span><span class='v'>%lu / %lu</span></div>"
+        "<div class='r'><span class='l'>Cost per Block</span><span class='v %s'>%lu cycles (%.1f%%)</span></div>"
+        "</div>",
+        lim.enabled ? "ok" : "warn", lim.enabled ? "Yes" : "No (hard clip)",
+        lim.gain_reduction_db > 6.0f ? "warn" : "ok", lim.gain_reduction_db, lim.max_gain_reduction_db,
+        (unsigned long)lim.limited_blocks, (unsigned long)lim.total_blocks,
+        lim.budget_pct < 10.0f ? "ok" : "warn", (unsigned long)lim.cycles_avg, lim.budget_pct);
+    httpd_resp_sendstr_chunk(req, buf);
+
+    // Auto gain section
+    AGCStats agc;
+    AutoGain::get_stats(&agc);
+    snprintf(buf, sizeof(buf),
+        "<div class='c'><h2>Auto Gain</h2>"
+        "<div class='r'><span class='l'>Enabled</span><span class='v'>%s</span></div>"
+        "<div class='r'><span class='l'>Gain</span><span class='v %s'>%+.1f dB (target %+.1f dB%s)</span></div>"
+        "<div class='r'><span class='l'>Loudness</span><span class='v'>%.1f LUFS (target %.1f)</span></div>"
+        "<div class='r'><span class='l'>Cost per Block</span><span class='v %s'>%lu cycles (%.1f%%)</span></div>"
+        "</div>",
+        agc.enabled ? "Yes" : "No",
+        agc.gain_db >= agc.max_gain_db - 0.05f ? "warn" : "ok", agc.gain_db, agc.target_gain_db,
+        agc.holding ? ", holding" : "",
+        agc.short_term_lufs, agc.target_lufs,
+        agc.budget_pct < 5.0f ? "ok" : "warn", (unsigned long)agc.cycles_avg, agc.budget_pct);
+    httpd_resp_sendstr_chunk(req, buf);
+
     // System section
     char uptime_str[32];
     format_uptime(uptime, uptime_str, sizeof(uptime_str));
@@ -931,13 +2291,22 @@ static int build_eq_json(char *buf, size_t buf_len) {
     DeviceConfig config;
     load_config_or_defaults(&config);
 
+    // Bands come from the live EQ: an applied preset is not written back to
+    // the config blob
+    EQBandConfig bands[EQ_MAX_BANDS];
+    EQProcessor::get_bands(bands);
+    char preset[EQ_PRESET_NAME_LEN];
+    EQPresets::get_active(preset, sizeof(preset));
+    HlsStats hls;
+    HlsSegmenter::get_stats(&hls);
+
     int pos = snprintf(buf, buf_len,
-        "{\"eq_enabled\":%s,\"sample_rate\":%lu,\"bands\":[",
+        "{\"eq_enabled\":%s,\"sample_rate\":%lu,\"preset\":\"%s\",\"bands\":[",
         config.eq_enabled ? "true" : "false",
-        (unsigned long)current_sample_rate);
+        (unsigned long)current_sample_rate, preset);
 
     for (int b = 0; b < 10 && pos < (int)buf_len - 2; b++) {
-        const EQBandConfig& band = config.eq_bands[b];
+        const EQBandConfig& band = bands[b];
         pos += snprintf(buf + pos, buf_len - pos,
             "%s{\"index\":%d,\"enabled\":%s,\"filter_type\":\"%s\","
             "\"frequency_hz\":%.1f,\"gain_db\":%.2f,\"q_factor\":%.3f}",
@@ -951,7 +2320,36 @@ static int build_eq_json(char *buf, size_t buf_len) {
     }
 
     if (pos < (int)buf_len - 2) {
-        pos += snprintf(buf + pos, buf_len - pos, "]}");
+        pos += snprintf(buf + pos, buf_len - pos,
+            "],\"phono\":{\"curve\":\"%s\",\"rumble_filter\":%s,\"stages\":%u},"
+            "\"limiter\":{\"enabled\":%s,\"ceiling_db\":%.1f,\"release_ms\":%.0f,"
+            "\"lookahead_ms\":%.1f},"
+            "\"agc\":{\"enabled\":%s,\"target_lufs\":%.1f,\"max_gain_db\":%.1f},"
+            "\"dither\":{\"mode\":\"%s\"},"
+            "\"mp3\":{\"available\":%s,\"bitrate_kbps\":%u},"
+            "\"opus\":{\"available\":%s,\"bitrate_kbps\":%u,\"frame_ms\":%u},"
+            "\"rtp\":{\"enabled\":%s,\"running\":%s,\"group\":\"%s\",\"port\":%u,\"bits\":%u,\"ttl\":%u},"
+            "\"snapcast\":{\"enabled\":%s,\"running\":%s,\"codec\":\"%s\",\"buffer_ms\":%u,"
+            "\"port\":%u,\"opus\":%s},"
+            "\"hls\":{\"enabled\":%s,\"running\":%s,\"segment_s\":%u,\"cache_bytes\":%lu}}",
+            phono_curve_to_str(config.phono_curve),
+            config.phono_rumble_filter ? "true" : "false",
+            EQProcessor::phono_stage_count(),
+            config.limiter_enabled ? "true" : "false",
+            config.limiter_ceiling_db, config.limiter_release_ms,
+            LIMITER_LOOKAHEAD_MS,
+            config.agc_enabled ? "true" : "false", config.agc_target_lufs, config.agc_max_gain_db,
+            dither_mode_to_str(config.stream_dither),
+            Mp3Encoder::available() ? "true" : "false", StreamEncoder::mp3_bitrate(),
+            OggOpusEncoder::available() ? "true" : "false", StreamEncoder::opus_bitrate(),
+            StreamEncoder::opus_frame_ms(),
+            config.rtp_enabled ? "true" : "false", RtpSender::is_running() ? "true" : "false",
+            config.rtp_group, config.rtp_port, config.rtp_bits, config.rtp_ttl,
+            config.snapcast_enabled ? "true" : "false", SnapcastServer::is_running() ? "true" : "false",
+            snapcast_codec_to_str(config.snapcast_codec), config.snapcast_buffer_ms, SNAPCAST_PORT,
+            SnapcastServer::supports(SnapcastCodec::OPUS) ? "true" : "false",
+            config.hls_enabled ? "true" : "false", HlsSegmenter::is_running() ? "true" : "false",
+            config.hls_segment_s, (unsigned long)hls.cache_bytes);
     }
     return pos;
 }
@@ -961,7 +2359,7 @@ static esp_err_t eq_get_handler(httpd_req_t *req) {
     httpd_resp_set_type(req, "application/json");
     add_cors_headers(req);
 
-    char json[1200];
+    char json[2560];
     int len = build_eq_json(json, sizeof(json));
     return httpd_resp_send(req, json, len);
 }
@@ -979,13 +2377,12 @@ static esp_err_t eq_post_handler(httpd_req_t *req) {
         return ESP_FAIL;
     }
 
-    int received = httpd_req_recv(req, body, req->content_len);
-    if (received <= 0) {
+    if (recv_body(req, body, req->content_len) != ESP_OK) {
         free(body);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Failed to read body");
         return ESP_FAIL;
     }
-    body[received] = '\0';
+    body[req->content_len] = '\0';
 
     cJSON *root = cJSON_Parse(body);
     free(body);
@@ -1005,9 +2402,15 @@ static esp_err_t eq_post_handler(httpd_req_t *req) {
         EQProcessor::set_enabled(new_enabled);
     }
 
-    // Apply band updates if present
+    // Apply band updates if present. Edits start from the live bands (which
+    // may come from a preset); any actual change detaches the active preset.
     cJSON *bands = cJSON_GetObjectItem(root, "bands");
+    bool preset_cleared = false;
     if (cJSON_IsArray(bands)) {
+        EQBandConfig live[EQ_MAX_BANDS];
+        EQProcessor::get_bands(live);
+        memcpy(config.eq_bands, live, sizeof(live));
+
         cJSON *band_obj = nullptr;
         cJSON_ArrayForEach(band_obj, bands) {
             cJSON *idx_j = cJSON_GetObjectItem(band_obj, "index");
@@ -1027,75 +2430,797 @@ static esp_err_t eq_post_handler(httpd_req_t *req) {
             cJSON *j_type = cJSON_GetObjectItem(band_obj, "filter_type");
             if (cJSON_IsString(j_type)) band.filter_type = eq_filter_type_from_str(j_type->valuestring);
 
-            cJSON *j_freq = cJSON_GetObjectItem(band_obj, "frequency_hz");
-            if (cJSON_IsNumber(j_freq)) {
-                float f = (float)j_freq->valuedouble;
-                band.frequency_hz = f < 20.0f ? 20.0f : (f > 20000.0f ? 20000.0f : f);
-            }
+            cJSON *j_freq = cJSON_GetObjectItem(band_obj, "frequency_hz");
+            if (cJSON_IsNumber(j_freq)) {
+                float f = (float)j_freq->valuedouble;
+                band.frequency_hz = f < 20.0f ? 20.0f : (f > 20000.0f ? 20000.0f : f);
+            }
+
+            cJSON *j_gain = cJSON_GetObjectItem(band_obj, "gain_db");
+            if (cJSON_IsNumber(j_gain)) {
+                float g = (float)j_gain->valuedouble;
+                band.gain_db = g < -24.0f ? -24.0f : (g > 24.0f ? 24.0f : g);
+            }
+
+            cJSON *j_q = cJSON_GetObjectItem(band_obj, "q_factor");
+            if (cJSON_IsNumber(j_q)) {
+                float q = (float)j_q->valuedouble;
+                band.q_factor = q < 0.1f ? 0.1f : (q > 10.0f ? 10.0f : q);
+            }
+
+            EQProcessor::update_band((uint8_t)idx, band, current_sample_rate);
+        }
+
+        char active[EQ_PRESET_NAME_LEN];
+        if (memcmp(live, config.eq_bands, sizeof(live)) != 0 &&
+            EQPresets::get_active(active, sizeof(active))) {
+            EQPresets::clear_active();
+            preset_cleared = true;
+        }
+    }
+
+    // Apply phono preset if present: {"phono":{"curve":"RIAA","rumble_filter":true}}
+    cJSON *phono = cJSON_GetObjectItem(root, "phono");
+    if (cJSON_IsObject(phono)) {
+        cJSON *j_curve = cJSON_GetObjectItem(phono, "curve");
+        if (cJSON_IsString(j_curve)) config.phono_curve = phono_curve_from_str(j_curve->valuestring);
+
+        cJSON *j_rumble = cJSON_GetObjectItem(phono, "rumble_filter");
+        if (cJSON_IsBool(j_rumble)) config.phono_rumble_filter = cJSON_IsTrue(j_rumble);
+
+        EQProcessor::set_phono(config.phono_curve, config.phono_rumble_filter);
+    }
+
+    // Apply limiter settings if present: {"limiter":{"enabled":true,"ceiling_db":-0.3,"release_ms":100}}
+    cJSON *limiter = cJSON_GetObjectItem(root, "limiter");
+    if (cJSON_IsObject(limiter)) {
+        cJSON *j_en = cJSON_GetObjectItem(limiter, "enabled");
+        if (cJSON_IsBool(j_en)) config.limiter_enabled = cJSON_IsTrue(j_en);
+
+        cJSON *j_ceil = cJSON_GetObjectItem(limiter, "ceiling_db");
+        if (cJSON_IsNumber(j_ceil)) {
+            float c = (float)j_ceil->valuedouble;
+            config.limiter_ceiling_db = c < -12.0f ? -12.0f : (c > 0.0f ? 0.0f : c);
+        }
+
+        cJSON *j_rel = cJSON_GetObjectItem(limiter, "release_ms");
+        if (cJSON_IsNumber(j_rel)) {
+            float r = (float)j_rel->valuedouble;
+            config.limiter_release_ms = r < 10.0f ? 10.0f : (r > 1000.0f ? 1000.0f : r);
+        }
+
+        PeakLimiter::configure(config.limiter_enabled, config.limiter_ceiling_db,
+                               config.limiter_release_ms);
+    }
+
+    // Apply AGC settings if present: {"agc":{"enabled":true,"target_lufs":-18,"max_gain_db":12}}
+    cJSON *agc = cJSON_GetObjectItem(root, "agc");
+    if (cJSON_IsObject(agc)) {
+        cJSON *j_en = cJSON_GetObjectItem(agc, "enabled");
+        if (cJSON_IsBool(j_en)) config.agc_enabled = cJSON_IsTrue(j_en);
+
+        cJSON *j_target = cJSON_GetObjectItem(agc, "target_lufs");
+        if (cJSON_IsNumber(j_target)) {
+            float t = (float)j_target->valuedouble;
+            config.agc_target_lufs = t < -40.0f ? -40.0f : (t > -10.0f ? -10.0f : t);
+        }
+
+        cJSON *j_max = cJSON_GetObjectItem(agc, "max_gain_db");
+        if (cJSON_IsNumber(j_max)) {
+            float m = (float)j_max->valuedouble;
+            config.agc_max_gain_db = m < 0.0f ? 0.0f : (m > 24.0f ? 24.0f : m);
+        }
+
+        AutoGain::configure(config.agc_enabled, config.agc_target_lufs, config.agc_max_gain_db);
+    }
+
+    // Apply stream dither if present: {"dither":{"mode":"TPDF_NS2"}}
+    cJSON *dither = cJSON_GetObjectItem(root, "dither");
+    if (cJSON_IsObject(dither)) {
+        cJSON *j_mode = cJSON_GetObjectItem(dither, "mode");
+        if (cJSON_IsString(j_mode)) {
+            config.stream_dither = dither_mode_from_str(j_mode->valuestring);
+            StreamEncoder::set_dither(config.stream_dither);
+        }
+    }
+
+    // Apply MP3 bitrate if present: {"mp3":{"bitrate_kbps":192}}; streams
+    // already running keep their bitrate
+    cJSON *mp3 = cJSON_GetObjectItem(root, "mp3");
+    if (cJSON_IsObject(mp3)) {
+        cJSON *j_kbps = cJSON_GetObjectItem(mp3, "bitrate_kbps");
+        if (cJSON_IsNumber(j_kbps)) {
+            double k = j_kbps->valuedouble;
+            k = k < MP3_MIN_BITRATE_KBPS ? MP3_MIN_BITRATE_KBPS : (k > MP3_MAX_BITRATE_KBPS ? MP3_MAX_BITRATE_KBPS : k);
+            config.mp3_bitrate_kbps = Mp3Encoder::nearest_bitrate((uint32_t)k);
+            StreamEncoder::set_mp3_bitrate(config.mp3_bitrate_kbps);
+        }
+    }
+
+    // Apply Opus settings if present: {"opus":{"bitrate_kbps":96,"frame_ms":10}};
+    // like MP3, for streams opened afterwards
+    cJSON *opus = cJSON_GetObjectItem(root, "opus");
+    if (cJSON_IsObject(opus)) {
+        cJSON *j_kbps = cJSON_GetObjectItem(opus, "bitrate_kbps");
+        if (cJSON_IsNumber(j_kbps)) {
+            double k = j_kbps->valuedouble;
+            config.opus_bitrate_kbps = OggOpusEncoder::clamp_bitrate(k < 0 ? 0 : (uint32_t)k);
+        }
+        cJSON *j_ms = cJSON_GetObjectItem(opus, "frame_ms");
+        if (cJSON_IsNumber(j_ms)) {
+            config.opus_frame_ms = j_ms->valueint == 10 ? 10 : 20;
+        }
+        StreamEncoder::set_opus(config.opus_bitrate_kbps, config.opus_frame_ms);
+    }
+
+    // Apply RTP multicast settings if present:
+    // {"rtp":{"enabled":true,"group":"239.69.83.67","port":5004,"bits":24,"ttl":1}};
+    // the sender restarts with them
+    cJSON *rtp = cJSON_GetObjectItem(root, "rtp");
+    if (cJSON_IsObject(rtp)) {
+        char group[sizeof(config.rtp_group)];
+        memcpy(group, config.rtp_group, sizeof(group));
+        int port = config.rtp_port;
+
+        cJSON *j_group = cJSON_GetObjectItem(rtp, "group");
+        if (cJSON_IsString(j_group)) {
+            memset(group, 0, sizeof(group));
+            strncpy(group, j_group->valuestring, sizeof(group) - 1);
+        }
+        cJSON *j_port = cJSON_GetObjectItem(rtp, "port");
+        if (cJSON_IsNumber(j_port)) port = j_port->valueint;
+        if (!RtpSender::is_valid_group(group) || port <= 0 || port >= 65535 || port % 2 != 0) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                "RTP group must be an IPv4 multicast address and the port even");
+            return ESP_FAIL;
+        }
+        memcpy(config.rtp_group, group, sizeof(config.rtp_group));
+        config.rtp_port = (uint16_t)port;
+
+        cJSON *j_enabled = cJSON_GetObjectItem(rtp, "enabled");
+        if (cJSON_IsBool(j_enabled)) config.rtp_enabled = cJSON_IsTrue(j_enabled);
+        cJSON *j_bits = cJSON_GetObjectItem(rtp, "bits");
+        if (cJSON_IsNumber(j_bits)) config.rtp_bits = j_bits->valueint == 16 ? 16 : 24;
+        cJSON *j_ttl = cJSON_GetObjectItem(rtp, "ttl");
+        if (cJSON_IsNumber(j_ttl)) {
+            int t = j_ttl->valueint;
+            config.rtp_ttl = (uint8_t)(t < 1 ? 1 : (t > 255 ? 255 : t));
+        }
+        RtpSender::configure(config.rtp_enabled, config.rtp_group, config.rtp_port,
+                             config.rtp_bits, config.rtp_ttl);
+    }
+
+    // Apply Snapcast server settings if present:
+    // {"snapcast":{"enabled":true,"codec":"flac","buffer_ms":1000}};
+    // the server restarts with them and the snapclients reconnect
+    cJSON *snap = cJSON_GetObjectItem(root, "snapcast");
+    if (cJSON_IsObject(snap)) {
+        SnapcastCodec codec = config.snapcast_codec;
+        cJSON *j_codec = cJSON_GetObjectItem(snap, "codec");
+        if (cJSON_IsString(j_codec)) codec = snapcast_codec_from_str(j_codec->valuestring);
+        if (!SnapcastServer::supports(codec)) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Snapcast codec not available in this build");
+            return ESP_FAIL;
+        }
+        config.snapcast_codec = codec;
+
+        cJSON *j_enabled = cJSON_GetObjectItem(snap, "enabled");
+        if (cJSON_IsBool(j_enabled)) config.snapcast_enabled = cJSON_IsTrue(j_enabled);
+        cJSON *j_buffer = cJSON_GetObjectItem(snap, "buffer_ms");
+        if (cJSON_IsNumber(j_buffer)) {
+            int b = j_buffer->valueint;
+            config.snapcast_buffer_ms = (uint16_t)(b < SNAPCAST_MIN_BUFFER_MS ? SNAPCAST_MIN_BUFFER_MS
+                                                   : (b > SNAPCAST_MAX_BUFFER_MS ? SNAPCAST_MAX_BUFFER_MS : b));
+        }
+        SnapcastServer::configure(config.snapcast_enabled, config.snapcast_codec, config.snapcast_buffer_ms);
+    }
+
+    // Apply HLS settings if present: {"hls":{"enabled":true,"segment_s":2}};
+    // a change starts a new session (new segment URLs, empty cache)
+    cJSON *hls = cJSON_GetObjectItem(root, "hls");
+    if (cJSON_IsObject(hls)) {
+        cJSON *j_enabled = cJSON_GetObjectItem(hls, "enabled");
+        if (cJSON_IsBool(j_enabled)) config.hls_enabled = cJSON_IsTrue(j_enabled);
+        cJSON *j_segment = cJSON_GetObjectItem(hls, "segment_s");
+        if (cJSON_IsNumber(j_segment)) {
+            int seg = j_segment->valueint;
+            config.hls_segment_s = (uint8_t)(seg < HLS_MIN_SEGMENT_S ? HLS_MIN_SEGMENT_S
+                                             : (seg > HLS_MAX_SEGMENT_S ? HLS_MAX_SEGMENT_S : seg));
+        }
+        HlsStats running;
+        HlsSegmenter::get_stats(&running);
+        if (config.hls_enabled != running.running || config.hls_segment_s != running.segment_s) {
+            HlsSegmenter::configure(config.hls_enabled, config.hls_segment_s);
+        }
+    }
+    cJSON_Delete(root);
+
+    if (!NVSConfig::save(&config)) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save config");
+        return ESP_FAIL;
+    }
+    if (preset_cleared) MQTTClient::publish_eq_presets();
+
+    httpd_resp_set_type(req, "application/json");
+    add_cors_headers(req);
+    char json[2560];
+    int len = build_eq_json(json, sizeof(json));
+    return httpd_resp_send(req, json, len);
+}
+
+// POST /eq/reset — reset all EQ bands to flat factory defaults
+static esp_err_t eq_reset_handler(httpd_req_t *req) {
+    // Load current config to preserve WiFi/MQTT settings, then reset only EQ fields
+    DeviceConfig config;
+    load_config_or_defaults(&config);
+
+    config.eq_enabled = false;
+    const struct { EQFilterType type; float freq; float q; } defaults[10] = {
+        { EQFilterType::LOW_SHELF,  32.0f,    0.707f },
+        { EQFilterType::PEAKING,    64.0f,    1.4f   },
+        { EQFilterType::PEAKING,   125.0f,    1.4f   },
+        { EQFilterType::PEAKING,   250.0f,    1.4f   },
+        { EQFilterType::PEAKING,   500.0f,    1.4f   },
+        { EQFilterType::PEAKING,  1000.0f,    1.4f   },
+        { EQFilterType::PEAKING,  2000.0f,    1.4f   },
+        { EQFilterType::PEAKING,  4000.0f,    1.4f   },
+        { EQFilterType::PEAKING,  8000.0f,    1.4f   },
+        { EQFilterType::HIGH_SHELF, 16000.0f, 0.707f },
+    };
+    for (int i = 0; i < 10; i++) {
+        config.eq_bands[i] = { false, defaults[i].type, defaults[i].freq, 0.0f, defaults[i].q };
+    }
+
+    EQProcessor::init(config, current_sample_rate);
+    EQPresets::clear_active();
+
+    if (!NVSConfig::save(&config)) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save config");
+        return ESP_FAIL;
+    }
+    MQTTClient::publish_eq_presets();
+
+    httpd_resp_set_type(req, "application/json");
+    add_cors_headers(req);
+    char json[2560];
+    int len = build_eq_json(json, sizeof(json));
+    return httpd_resp_send(req, json, len);
+}
+
+// ─── EQ Presets ──────────────────────────────────────────────────────────────
+
+static int build_presets_json(char *buf, size_t buf_len) {
+    EQPresetInfo presets[EQ_PRESET_MAX_COUNT];
+    uint8_t count = EQPresets::list(presets, EQ_PRESET_MAX_COUNT);
+    char active[EQ_PRESET_NAME_LEN];
+    bool has_active = EQPresets::get_active(active, sizeof(active));
+
+    int pos = snprintf(buf, buf_len, "{\"active\":");
+    pos += has_active ? snprintf(buf + pos, buf_len - pos, "\"%s\"", active)
+                      : snprintf(buf + pos, buf_len - pos, "null");
+    pos += snprintf(buf + pos, buf_len - pos, ",\"max\":%u,\"presets\":[", EQ_PRESET_MAX_COUNT);
+    for (uint8_t i = 0; i < count && pos < (int)buf_len - 2; i++) {
+        pos += snprintf(buf + pos, buf_len - pos, "%s{\"slot\":%u,\"name\":\"%s\"}",
+                        i == 0 ? "" : ",", presets[i].slot, presets[i].name);
+    }
+    if (pos < (int)buf_len - 2) {
+        pos += snprintf(buf + pos, buf_len - pos, "]}");
+    }
+    return pos;
+}
+
+// GET /eq/presets — list stored presets and the active one
+static esp_err_t eq_presets_get_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    add_cors_headers(req);
+
+    char json[512];
+    int len = build_presets_json(json, sizeof(json));
+    return httpd_resp_send(req, json, len);
+}
+
+// POST /eq/presets — {"action":"apply"|"save"|"delete","name":"..."}
+//   apply  : swap the preset's coefficient bank in (crossfaded, no NVS write
+//            beyond the active-slot byte)
+//   save   : store the live bands under `name` and make it active
+//   delete : remove the preset
+static esp_err_t eq_presets_post_handler(httpd_req_t *req) {
+    char body[160];
+    if (req->content_len <= 0 || req->content_len >= (int)sizeof(body)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid body size");
+        return ESP_FAIL;
+    }
+    if (recv_body(req, body, req->content_len) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Failed to read body");
+        return ESP_FAIL;
+    }
+    body[req->content_len] = '\0';
+
+    cJSON *root = cJSON_Parse(body);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    cJSON *j_action = cJSON_GetObjectItem(root, "action");
+    cJSON *j_name   = cJSON_GetObjectItem(root, "name");
+    if (!cJSON_IsString(j_action) || !cJSON_IsString(j_name)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "action and name required");
+        return ESP_FAIL;
+    }
+
+    const char *action = j_action->valuestring;
+    const char *name   = j_name->valuestring;
+    bool ok;
+    const char *error;
+    if (strcmp(action, "apply") == 0) {
+        ok = EQPresets::apply(name);
+        error = "Preset not found";
+    } else if (strcmp(action, "save") == 0) {
+        ok = EQPresets::save(name);
+        error = "Invalid name or no free preset slot";
+    } else if (strcmp(action, "delete") == 0) {
+        ok = EQPresets::remove(name);
+        error = "Preset not found";
+    } else {
+        ok = false;
+        error = "Unknown action";
+    }
+    cJSON_Delete(root);
+
+    if (!ok) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, error);
+        return ESP_FAIL;
+    }
+    MQTTClient::publish_eq_presets();
+
+    httpd_resp_set_type(req, "application/json");
+    add_cors_headers(req);
+    char json[512];
+    int len = build_presets_json(json, sizeof(json));
+    return httpd_resp_send(req, json, len);
+}
+
+// ─── FIR Correction ──────────────────────────────────────────────────────────
+
+static int build_fir_json(char *buf, size_t buf_len) {
+    FIRStats st;
+    FIRFilter::get_stats(&st);
+    FIRStoreInfo stored;
+    FIRStore::get_info(&stored);
+
+    return snprintf(buf, buf_len,
+        "{\"enabled\":%s,\"active\":%s,\"loaded\":%s,\"stored\":%s,"
+        "\"taps\":%u,\"channels\":%u,\"ir_sample_rate\":%lu,\"sample_rate\":%lu,"
+        "\"max_taps\":%lu,\"partitions\":%u,\"partition_frames\":%u,\"fft_size\":%u,"
+        "\"latency_frames\":0,\"memory_bytes\":%lu,\"in_psram\":%s,"
+        "\"head_cycles_avg\":%lu,\"head_cycles_max\":%lu,"
+        "\"tail_cycles_avg\":%lu,\"tail_cycles_max\":%lu,"
+        "\"head_budget_pct\":%.2f,\"tail_budget_pct\":%.2f,"
+        "\"blocks\":%lu,\"deadline_misses\":%lu,\"tails_dropped\":%lu,\"skipped_blocks\":%lu}",
+        st.enabled ? "true" : "false", st.active ? "true" : "false",
+        st.loaded ? "true" : "false", stored.valid ? "true" : "false",
+        st.taps, st.channels, (unsigned long)st.ir_sample_rate,
+        (unsigned long)current_sample_rate, (unsigned long)FIR_MAX_TAPS,
+        st.partitions, (unsigned)FIR_PARTITION, (unsigned)FIR_FFT_SIZE,
+        (unsigned long)st.memory_bytes, st.in_psram ? "true" : "false",
+        (unsigned long)st.head_cycles_avg, (unsigned long)st.head_cycles_max,
+        (unsigned long)st.tail_cycles_avg, (unsigned long)st.tail_cycles_max,
+        st.head_budget_pct, st.tail_budget_pct,
+        (unsigned long)st.blocks, (unsigned long)st.deadline_misses,
+        (unsigned long)st.tails_dropped, (unsigned long)st.skipped_blocks);
+}
+
+static esp_err_t send_fir_json(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    add_cors_headers(req);
+    char json[768];
+    int len = build_fir_json(json, sizeof(json));
+    return httpd_resp_send(req, json, len);
+}
+
+// GET /eq/fir — IR info and per-block cost of the FIR stage
+static esp_err_t eq_fir_get_handler(httpd_req_t *req) {
+    return send_fir_json(req);
+}
+
+// POST /eq/fir?taps=N&channels=1|2&rate=Hz[&enabled=0|1]
+//   Body: raw little-endian float32 taps, channel-interleaved
+//   (taps × channels × 4 bytes). Received in full and validated, then written
+//   to the fir_ir partition and loaded into the filter.
+// POST /eq/fir?enabled=0|1 (empty body) — switch the stage on/off
+static esp_err_t eq_fir_post_handler(httpd_req_t *req) {
+    char query[96] = {0};
+    char value[16];
+    httpd_req_get_url_query_str(req, query, sizeof(query));
+
+    int enabled = -1;
+    if (httpd_query_key_value(query, "enabled", value, sizeof(value)) == ESP_OK) {
+        enabled = (strcmp(value, "1") == 0 || strcmp(value, "true") == 0) ? 1 : 0;
+    }
+
+    if (req->content_len > 0) {
+        uint32_t taps = 0, channels = 0, rate = 0;
+        if (httpd_query_key_value(query, "taps", value, sizeof(value)) == ESP_OK)
+            taps = strtoul(value, nullptr, 10);
+        if (httpd_query_key_value(query, "channels", value, sizeof(value)) == ESP_OK)
+            channels = strtoul(value, nullptr, 10);
+        if (httpd_query_key_value(query, "rate", value, sizeof(value)) == ESP_OK)
+            rate = strtoul(value, nullptr, 10);
+
+        if (taps == 0 || taps > FIR_MAX_TAPS || (channels != 1 && channels != 2) || rate == 0) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "taps (1-4096), channels (1|2) and rate required");
+            return ESP_FAIL;
+        }
+        if ((uint32_t)req->content_len != taps * channels * sizeof(float)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body must be taps x channels float32");
+            return ESP_FAIL;
+        }
+
+        // Receive the whole IR (≤ 32 KB) before touching flash: a failed or
+        // aborted upload must leave the stored IR and the running filter alone
+        float *ir = (float *)heap_caps_malloc(req->content_len, MALLOC_CAP_SPIRAM);
+        if (ir == nullptr) ir = (float *)heap_caps_malloc(req->content_len, MALLOC_CAP_INTERNAL);
+        if (ir == nullptr) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+            return ESP_FAIL;
+        }
+        if (recv_body(req, (char *)ir, req->content_len) != ESP_OK) {
+            heap_caps_free(ir);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "IR upload failed");
+            return ESP_FAIL;
+        }
+        bool ok = FIRStore::save(ir, taps, (uint8_t)channels, rate) &&
+                  FIRFilter::load(ir, taps, (uint8_t)channels, rate);
+        heap_caps_free(ir);
+        if (!ok) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "IR rejected (see log)");
+            return ESP_FAIL;
+        }
+    } else if (enabled < 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "IR body or enabled=0|1 required");
+        return ESP_FAIL;
+    }
+
+    if (enabled >= 0) {
+        DeviceConfig config;
+        load_config_or_defaults(&config);
+        config.fir_enabled = enabled == 1;
+        FIRFilter::set_enabled(config.fir_enabled);
+        if (!NVSConfig::save(&config)) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save config");
+            return ESP_FAIL;
+        }
+    }
+    return send_fir_json(req);
+}
+
+// DELETE /eq/fir — erase the stored IR and drop it from the filter
+static esp_err_t eq_fir_delete_handler(httpd_req_t *req) {
+    FIRFilter::unload();
+    FIRStore::erase();
+    return send_fir_json(req);
+}
+
+// ─── EQ Response ─────────────────────────────────────────────────────────────
+
+// Binary /eq/response layout (little-endian):
+//   EQResponseHeader, then float32 freq_hz[points], magnitude_db[points],
+//   and phase_deg[points] if EQ_RESPONSE_FLAG_PHASE is set.
+static constexpr uint32_t EQ_RESPONSE_MAGIC      = 0x31525145;  // "EQR1"
+static constexpr uint8_t  EQ_RESPONSE_FLAG_PHASE = 0x01;
+
+struct __attribute__((packed)) EQResponseHeader {
+    uint32_t magic;
+    uint16_t points;
+    uint8_t  flags;
+    uint8_t  stages;
+    uint32_t sample_rate;
+    uint32_t generation;
+};
+
+// Send `count` floats as a comma-separated JSON array body, in chunks
+static esp_err_t send_json_float_array(httpd_req_t *req, const float *values, uint16_t count,
+                                       const char *fmt) {
+    char chunk[512];
+    int pos = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        pos += snprintf(chunk + pos, sizeof(chunk) - pos, i == 0 ? "" : ",");
+        pos += snprintf(chunk + pos, sizeof(chunk) - pos, fmt, values[i]);
+        if (pos > (int)sizeof(chunk) - 32) {
+            if (httpd_resp_send_chunk(req, chunk, pos) != ESP_OK) return ESP_FAIL;
+            pos = 0;
+        }
+    }
+    if (pos > 0) return httpd_resp_send_chunk(req, chunk, pos);
+    return ESP_OK;
+}
+
+// GET /eq/response?points=N[&phase=1][&format=json|bin]
+// Magnitude (and optionally phase) of the live biquad cascade on a log grid.
+// Binary is selected by format=bin or "Accept: application/octet-stream".
+static esp_err_t eq_response_handler(httpd_req_t *req) {
+    uint16_t points = EQ_RESPONSE_DEFAULT_POINTS;
+    bool with_phase = false;
+    bool binary = false;
+
+    char query[96] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16];
+        if (httpd_query_key_value(query, "points", value, sizeof(value)) == ESP_OK) {
+            long n = strtol(value, nullptr, 10);
+            if (n < EQ_RESPONSE_MIN_POINTS || n > EQ_RESPONSE_MAX_POINTS) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "points out of range [16,512]");
+                return ESP_FAIL;
+            }
+            points = (uint16_t)n;
+        }
+        if (httpd_query_key_value(query, "phase", value, sizeof(value)) == ESP_OK) {
+            with_phase = strcmp(value, "1") == 0 || strcmp(value, "true") == 0;
+        }
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+            binary = strcmp(value, "bin") == 0;
+        }
+    }
+
+    char accept[64] = {0};
+    httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept));
+    if (strstr(accept, "application/octet-stream") != nullptr) {
+        binary = true;
+    }
+
+    // The ETag names the coefficient generation and the representation, so a
+    // poll with a current If-None-Match is answered without evaluating
+    char etag[40];
+    snprintf(etag, sizeof(etag), "\"%lu-%u%s%s\"", (unsigned long)EQProcessor::coef_generation(),
+             points, with_phase ? "p" : "", binary ? "b" : "j");
+    char if_none_match[40] = {0};
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+        strcmp(if_none_match, etag) == 0) {
+        add_cors_headers(req);
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_set_hdr(req, "ETag", etag);
+        httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+        return httpd_resp_send(req, nullptr, 0);
+    }
+
+    EQResponseView view;
+    if (!EQResponse::get(points, &view)) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    add_cors_headers(req);
+    snprintf(etag, sizeof(etag), "\"%lu-%u%s%s\"", (unsigned long)view.generation,
+             view.points, with_phase ? "p" : "", binary ? "b" : "j");
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "Vary", "Accept");
+
+    if (binary) {
+        EQResponseHeader hdr = {
+            EQ_RESPONSE_MAGIC, view.points,
+            (uint8_t)(with_phase ? EQ_RESPONSE_FLAG_PHASE : 0), view.stages,
+            view.sample_rate, view.generation};
+        const size_t array_bytes = view.points * sizeof(float);
+
+        httpd_resp_set_type(req, "application/octet-stream");
+        if (httpd_resp_send_chunk(req, (const char *)&hdr, sizeof(hdr)) != ESP_OK ||
+            httpd_resp_send_chunk(req, (const char *)view.freq_hz, array_bytes) != ESP_OK ||
+            httpd_resp_send_chunk(req, (const char *)view.magnitude_db, array_bytes) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (with_phase &&
+            httpd_resp_send_chunk(req, (const char *)view.phase_deg, array_bytes) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        return httpd_resp_send_chunk(req, nullptr, 0);
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    char head[160];
+    int len = snprintf(head, sizeof(head),
+        "{\"sample_rate\":%lu,\"points\":%u,\"stages\":%u,\"generation\":%lu,\"freq_hz\":[",
+        (unsigned long)view.sample_rate, view.points, view.stages,
+        (unsigned long)view.generation);
+    if (httpd_resp_send_chunk(req, head, len) != ESP_OK ||
+        send_json_float_array(req, view.freq_hz, view.points, "%.1f") != ESP_OK ||
+        httpd_resp_sendstr_chunk(req, "],\"magnitude_db\":[") != ESP_OK ||
+        send_json_float_array(req, view.magnitude_db, view.points, "%.2f") != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (with_phase) {
+        if (httpd_resp_sendstr_chunk(req, "],\"phase_deg\":[") != ESP_OK ||
+            send_json_float_array(req, view.phase_deg, view.points, "%.1f") != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    if (httpd_resp_sendstr_chunk(req, "]}") != ESP_OK) return ESP_FAIL;
+    return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+// ─── Spectrum ────────────────────────────────────────────────────────────────
+
+// Binary /api/spectrum layout (little-endian):
+//   SpectrumHeader, then uint8 level[bands]; dB = db_floor + level × db_step.
+//   Band b spans f_min · (f_max / f_min)^(b / bands) … ^((b + 1) / bands).
+static constexpr uint32_t SPECTRUM_MAGIC = 0x32435053;  // "SPC2"
+
+struct __attribute__((packed)) SpectrumHeader {
+    uint32_t magic;
+    uint16_t bands;
+    uint16_t fft_size;
+    uint32_t sample_rate;
+    uint32_t sequence;
+    float    f_min_hz;
+    float    f_max_hz;
+    float    db_floor;
+    float    db_step;
+    uint32_t age_ms;            // Time since the analyzer published this frame
+};
 
-            cJSON *j_gain = cJSON_GetObjectItem(band_obj, "gain_db");
-            if (cJSON_IsNumber(j_gain)) {
-                float g = (float)j_gain->valuedouble;
-                band.gain_db = g < -24.0f ? -24.0f : (g > 24.0f ? 24.0f : g);
+// GET /api/spectrum?bands=N&fmin=Hz&fps=N
+// Latest analyzer frame as log-spaced band levels. The first request starts
+// the analyzer; `fps` sets its frame rate for all clients. Answers at once
+// from the latest published frame (this runs on the httpd task): 503 with
+// Retry-After until the first frame after a cold start (~43 ms at 48 kHz).
+static esp_err_t spectrum_handler(httpd_req_t *req) {
+    uint16_t bands = SPECTRUM_DEFAULT_BANDS;
+    float f_min = 20.0f;
+
+    char query[64] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16];
+        if (httpd_query_key_value(query, "bands", value, sizeof(value)) == ESP_OK) {
+            long n = strtol(value, nullptr, 10);
+            if (n < 8 || n > SPECTRUM_MAX_BANDS) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "bands out of range [8,256]");
+                return ESP_FAIL;
             }
+            bands = (uint16_t)n;
+        }
+        if (httpd_query_key_value(query, "fmin", value, sizeof(value)) == ESP_OK) {
+            f_min = strtof(value, nullptr);
+        }
+        if (httpd_query_key_value(query, "fps", value, sizeof(value)) == ESP_OK) {
+            long fps = strtol(value, nullptr, 10);
+            SpectrumAnalyzer::set_fps((uint8_t)(fps < 1 ? 1 : (fps > SPECTRUM_MAX_FPS ? SPECTRUM_MAX_FPS : fps)));
+        }
+    }
 
-            cJSON *j_q = cJSON_GetObjectItem(band_obj, "q_factor");
-            if (cJSON_IsNumber(j_q)) {
-                float q = (float)j_q->valuedouble;
-                band.q_factor = q < 0.1f ? 0.1f : (q > 10.0f ? 10.0f : q);
-            }
+    SpectrumAnalyzer::touch();
 
-            EQProcessor::update_band((uint8_t)idx, band, current_sample_rate);
-        }
+    uint8_t levels[SPECTRUM_MAX_BANDS];
+    SpectrumFrameInfo info;
+    add_cors_headers(req);
+    if (!SpectrumAnalyzer::get_bands(bands, f_min, levels, &info)) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        return httpd_resp_send(req, nullptr, 0);
     }
-    cJSON_Delete(root);
 
-    if (!NVSConfig::save(&config)) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save config");
+    SpectrumHeader hdr = {
+        SPECTRUM_MAGIC, info.bands, (uint16_t)SPECTRUM_FFT_SIZE, info.sample_rate,
+        info.sequence, info.f_min_hz, info.f_max_hz, SPECTRUM_DB_FLOOR, SPECTRUM_DB_STEP,
+        info.age_ms};
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    if (httpd_resp_send_chunk(req, (const char *)&hdr, sizeof(hdr)) != ESP_OK ||
+        httpd_resp_send_chunk(req, (const char *)levels, info.bands) != ESP_OK) {
         return ESP_FAIL;
     }
+    return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+// ─── Measurements ────────────────────────────────────────────────────────────
+
+static esp_err_t send_wow_flutter_json(httpd_req_t *req) {
+    WowFlutterResult r;
+    WowFlutterMeter::get_result(&r);
+
+    char json[640];
+    int len = snprintf(json, sizeof(json),
+        "{\"state\":\"%s\",\"reference_hz\":%.1f,\"duration_s\":%.0f,\"elapsed_s\":%.1f,"
+        "\"measured_hz\":%.3f,\"speed_error_pct\":%.3f,"
+        "\"weighted_peak_pct\":%.4f,\"weighted_rms_pct\":%.4f,\"weighting\":\"DIN 45507 / IEC 60386\","
+        "\"tone_level_dbfs\":%.1f,\"periods\":%lu,\"rejected_periods\":%lu,\"lost_chunks\":%lu,"
+        "\"cycles_per_chunk_avg\":%lu,\"cycles_per_chunk_max\":%lu}",
+        WowFlutterMeter::state_name(r.state), r.reference_hz, r.duration_s, r.elapsed_s,
+        r.measured_hz, r.speed_error_pct, r.weighted_peak_pct, r.weighted_rms_pct,
+        r.tone_level_dbfs, (unsigned long)r.periods, (unsigned long)r.rejected_periods,
+        (unsigned long)r.lost_chunks,
+        (unsigned long)r.cycles_per_chunk_avg, (unsigned long)r.cycles_per_chunk_max);
 
     httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
     add_cors_headers(req);
-    char json[1200];
-    int len = build_eq_json(json, sizeof(json));
     return httpd_resp_send(req, json, len);
 }
 
-// POST /eq/reset — reset all EQ bands to flat factory defaults
-static esp_err_t eq_reset_handler(httpd_req_t *req) {
-    // Load current config to preserve WiFi/MQTT settings, then reset only EQ fields
-    DeviceConfig config;
-    load_config_or_defaults(&config);
+// GET /api/measure/wow-flutter — state and results of the current (or last)
+// measurement; values update live while measuring
+static esp_err_t wow_flutter_get_handler(httpd_req_t *req) {
+    return send_wow_flutter_json(req);
+}
 
-    config.eq_enabled = false;
-    const struct { EQFilterType type; float freq; float q; } defaults[10] = {
-        { EQFilterType::LOW_SHELF,  32.0f,    0.707f },
-        { EQFilterType::PEAKING,    64.0f,    1.4f   },
-        { EQFilterType::PEAKING,   125.0f,    1.4f   },
-        { EQFilterType::PEAKING,   250.0f,    1.4f   },
-        { EQFilterType::PEAKING,   500.0f,    1.4f   },
-        { EQFilterType::PEAKING,  1000.0f,    1.4f   },
-        { EQFilterType::PEAKING,  2000.0f,    1.4f   },
-        { EQFilterType::PEAKING,  4000.0f,    1.4f   },
-        { EQFilterType::PEAKING,  8000.0f,    1.4f   },
-        { EQFilterType::HIGH_SHELF, 16000.0f, 0.707f },
-    };
-    for (int i = 0; i < 10; i++) {
-        config.eq_bands[i] = { false, defaults[i].type, defaults[i].freq, 0.0f, defaults[i].q };
+// POST /api/measure/wow-flutter?ref=3150&seconds=20 — start a measurement
+// POST /api/measure/wow-flutter?stop=1             — abort it
+static esp_err_t wow_flutter_post_handler(httpd_req_t *req) {
+    float ref = WF_DEFAULT_REFERENCE_HZ;
+    float seconds = WF_DEFAULT_DURATION_S;
+
+    char query[64] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16];
+        if (httpd_query_key_value(query, "stop", value, sizeof(value)) == ESP_OK) {
+            WowFlutterMeter::stop();
+            return send_wow_flutter_json(req);
+        }
+        if (httpd_query_key_value(query, "ref", value, sizeof(value)) == ESP_OK) {
+            ref = strtof(value, nullptr);
+        }
+        if (httpd_query_key_value(query, "seconds", value, sizeof(value)) == ESP_OK) {
+            seconds = strtof(value, nullptr);
+        }
     }
 
-    EQProcessor::init(config, current_sample_rate);
-
-    if (!NVSConfig::save(&config)) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save config");
+    if (!WowFlutterMeter::start(ref, seconds)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "ref out of range [1000,10000] Hz");
         return ESP_FAIL;
     }
+    return send_wow_flutter_json(req);
+}
+
+// GET /api/measure/thdn?window=2
+// THD+N, THD, SNR and noise floor per channel over the last completed window.
+// The first request starts the analyzer; `window` (0.5–30 s) applies to all
+// clients. "ready" stays false until one full window has been measured.
+static esp_err_t thdn_handler(httpd_req_t *req) {
+    char query[32] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16];
+        if (httpd_query_key_value(query, "window", value, sizeof(value)) == ESP_OK) {
+            float window = strtof(value, nullptr);
+            if (window < THDN_MIN_WINDOW_S || window > THDN_MAX_WINDOW_S) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "window out of range [0.5,30] s");
+                return ESP_FAIL;
+            }
+            ThdnAnalyzer::set_window(window);
+        }
+    }
+
+    ThdnAnalyzer::touch();
+    ThdnResult r;
+    ThdnAnalyzer::get_result(&r);
+
+    char json[1024];
+    int len = snprintf(json, sizeof(json),
+        "{\"active\":%s,\"ready\":%s,\"window_s\":%.1f,\"sequence\":%lu,\"sample_rate\":%lu,"
+        "\"channels\":[",
+        r.active ? "true" : "false", r.sequence > 0 ? "true" : "false",
+        r.window_s, (unsigned long)r.sequence, (unsigned long)r.sample_rate);
+    for (int ch = 0; ch < 2; ch++) {
+        const ThdnChannelResult &c = r.channel[ch];
+        len += snprintf(json + len, sizeof(json) - len,
+            "%s{\"channel\":\"%s\",\"valid\":%s,\"fundamental_hz\":%.2f,\"level_dbfs\":%.2f,"
+            "\"thdn_db\":%.2f,\"thdn_pct\":%.5f,\"thd_db\":%.2f,\"snr_db\":%.2f,"
+            "\"noise_floor_dbfs\":%.2f}",
+            ch == 0 ? "" : ",", ch == 0 ? "left" : "right", c.valid ? "true" : "false",
+            c.fundamental_hz, c.level_dbfs, c.thdn_db, c.thdn_pct, c.thd_db, c.snr_db,
+            c.noise_floor_dbfs);
+    }
+    len += snprintf(json + len, sizeof(json) - len,
+        "],\"lost_chunks\":%lu,\"cycles_per_chunk_avg\":%lu,\"cycles_per_chunk_max\":%lu}",
+        (unsigned long)r.lost_chunks,
+        (unsigned long)r.cycles_per_chunk_avg, (unsigned long)r.cycles_per_chunk_max);
 
     httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
     add_cors_headers(req);
-    char json[1200];
-    int len = build_eq_json(json, sizeof(json));
     return httpd_resp_send(req, json, len);
 }
 
@@ -1141,6 +3266,137 @@ static esp_err_t eq_settings_page_handler(httpd_req_t *req) {
         "Enable EQ</label>"
         "</div>"
         "<div class='c'>"
+        "<h2>Presets</h2>"
+        "<table><tr>"
+        "<td style='width:40%'><select id='preset'></select></td>"
+        "<td><button class='btn' onclick='presetAction(\"apply\")'>Load</button>"
+        "<button class='btn danger' onclick='presetAction(\"delete\")'>Delete</button></td>"
+        "</tr><tr>"
+        "<td><input type='text' id='preset_name' maxlength='23' placeholder='Preset name'"
+        " style='background:#0d1b2a;color:#e0e0e0;border:1px solid #0f969c;border-radius:4px;padding:4px 6px;width:100%;font-size:12px'></td>"
+        "<td><button class='btn alt' onclick='presetAction(\"save\")'>Save current</button></td>"
+        "</tr></table></div>"
+        "<div class='c'>"
+        "<h2>Frequency Response</h2>"
+        "<canvas id='resp' width='720' height='200' style='width:100%;background:#0d1b2a;border-radius:4px'></canvas>"
+        "</div>"
+        "<div class='c'>"
+        "<h2>Live Spectrum</h2>"
+        "<canvas id='spec' width='720' height='160' style='width:100%;background:#0d1b2a;border-radius:4px'></canvas>"
+        "</div>"
+        "<div class='c'>"
+        "<h2>Phono Preset</h2>"
+        "<table><tr>"
+        "<td style='width:50%'><select id='phono_curve'>"
+        "<option value='OFF'>Off (line level)</option>"
+        "<option value='RIAA'>RIAA</option>"
+        "<option value='RIAA_IEC'>RIAA + IEC subsonic</option>"
+        "<option value='COLUMBIA_LP'>Columbia LP</option>"
+        "</select></td>"
+        "<td><label style='font-size:13px;cursor:pointer'>"
+        "<input type='checkbox' id='phono_rumble' style='margin-right:8px;vertical-align:middle'>"
+        "Rumble filter (20 Hz)</label></td>"
+        "</tr></table></div>"
+        "<div class='c'>"
+        "<h2>Output Limiter</h2>"
+        "<table><tr>"
+        "<td><label style='font-size:13px;cursor:pointer'>"
+        "<input type='checkbox' id='lim_en' style='margin-right:8px;vertical-align:middle'>"
+        "Lookahead limiter</label></td>"
+        "<td>Ceiling (dBFS)<input type='number' id='lim_ceil' min='-12' max='0' step='0.1'></td>"
+        "<td>Release (ms)<input type='number' id='lim_rel' min='10' max='1000' step='10'></td>"
+        "</tr></table></div>"
+        "<div class='c'>"
+        "<h2>Auto Gain</h2>"
+        "<table><tr>"
+        "<td><label style='font-size:13px;cursor:pointer'>"
+        "<input type='checkbox' id='agc_en' style='margin-right:8px;vertical-align:middle'>"
+        "Normalize level</label></td>"
+        "<td>Target (LUFS)<input type='number' id='agc_target' min='-40' max='-10' step='1'></td>"
+        "<td>Max gain (dB)<input type='number' id='agc_max' min='0' max='24' step='1'></td>"
+        "</tr></table></div>"
+        "<div class='c'>"
+        "<h2>Stream Dither (16-bit)</h2>"
+        "<table><tr>"
+        "<td style='width:50%'><select id='dither_mode'>"
+        "<option value='OFF'>Off (truncate)</option>"
+        "<option value='TPDF'>TPDF</option>"
+        "<option value='TPDF_NS1'>TPDF + 1st-order shaping</option>"
+        "<option value='TPDF_NS2'>TPDF + 2nd-order shaping</option>"
+        "</select></td>"
+        "</tr></table></div>"
+        "<div class='c'>"
+        "<h2>MP3 Stream</h2>"
+        "<table><tr>"
+        "<td style='width:50%'><select id='mp3_kbps'>"
+        "<option value='128'>128 kbps</option>"
+        "<option value='192'>192 kbps</option>"
+        "<option value='256'>256 kbps</option>"
+        "<option value='320'>320 kbps</option>"
+        "</select></td>"
+        "<td id='mp3_note' style='font-size:13px'></td>"
+        "</tr></table></div>"
+        "<div class='c'>"
+        "<h2>Opus Stream</h2>"
+        "<table><tr>"
+        "<td>Bitrate (kbps)<input type='number' id='opus_kbps' min='16' max='256' step='8'></td>"
+        "<td><select id='opus_ms'>"
+        "<option value='10'>10 ms frames</option>"
+        "<option value='20'>20 ms frames</option>"
+        "</select></td>"
+        "<td id='opus_note' style='font-size:13px'></td>"
+        "</tr></table></div>"
+        "<div class='c'>"
+        "<h2>RTP Multicast</h2>"
+        "<table><tr>"
+        "<td><label style='font-size:13px;cursor:pointer'>"
+        "<input type='checkbox' id='rtp_en' style='margin-right:8px;vertical-align:middle'>"
+        "Send</label></td>"
+        "<td>Group<input type='text' id='rtp_group' maxlength='15'"
+        " style='background:#0d1b2a;color:#e0e0e0;border:1px solid #0f969c;border-radius:4px;padding:4px 6px;width:100%;font-size:12px'></td>"
+        "<td>Port<input type='number' id='rtp_port' min='1024' max='65534' step='2'></td>"
+        "<td><select id='rtp_bits'>"
+        "<option value='24'>L24</option>"
+        "<option value='16'>L16</option>"
+        "</select></td>"
+        "<td>TTL<input type='number' id='rtp_ttl' min='1' max='255' step='1'></td>"
+        "</tr></table>"
+        "<div id='rtp_note' style='font-size:12px;color:#888;margin-top:6px'></div></div>"
+        "<div class='c'>"
+        "<h2>Snapcast Server</h2>"
+        "<table><tr>"
+        "<td><label style='font-size:13px;cursor:pointer'>"
+        "<input type='checkbox' id='snap_en' style='margin-right:8px;vertical-align:middle'>"
+        "Serve</label></td>"
+        "<td><select id='snap_codec'>"
+        "<option value='flac'>FLAC</option>"
+        "<option value='pcm'>PCM</option>"
+        "<option value='opus' id='snap_opus'>Opus</option>"
+        "</select></td>"
+        "<td>Buffer (ms)<input type='number' id='snap_buf' min='200' max='5000' step='100'></td>"
+        "</tr></table>"
+        "<div id='snap_note' style='font-size:12px;color:#888;margin-top:6px'></div></div>"
+        "<div class='c'>"
+        "<h2>HLS Output</h2>"
+        "<table><tr>"
+        "<td><label style='font-size:13px;cursor:pointer'>"
+        "<input type='checkbox' id='hls_en' style='margin-right:8px;vertical-align:middle'>"
+        "Segment</label></td>"
+        "<td>Segment (s)<input type='number' id='hls_seg' min='1' max='4' step='1'></td>"
+        "</tr></table>"
+        "<div id='hls_note' style='font-size:12px;color:#888;margin-top:6px'></div></div>"
+        "<div class='c'>"
+        "<h2>FIR Correction</h2>"
+        "<table><tr>"
+        "<td><label style='font-size:13px;cursor:pointer'>"
+        "<input type='checkbox' id='fir_en' onchange='firEnable(this.checked)' style='margin-right:8px;vertical-align:middle'>"
+        "Enable</label></td>"
+        "<td><input type='file' id='fir_file' accept='.wav' style='font-size:12px'></td>"
+        "<td><button class='btn' onclick='firUpload()'>Upload IR</button>"
+        "<button class='btn danger' onclick='firDelete()'>Delete</button></td>"
+        "</tr></table>"
+        "<div id='fir_info' style='font-size:12px;color:#888;margin-top:6px'></div></div>"
+        "<div class='c'>"
         "<h2>EQ Bands</h2>"
         "<table>"
         "<thead><tr>"
@@ -1183,11 +3439,51 @@ static esp_err_t eq_settings_page_handler(httpd_req_t *req) {
         "function loadEQ(){"
         "fetch('/eq').then(r=>r.json()).then(data=>{"
         "document.getElementById('eq_enabled').checked=data.eq_enabled;"
+        "if(data.phono){document.getElementById('phono_curve').value=data.phono.curve;"
+        "document.getElementById('phono_rumble').checked=data.phono.rumble_filter;}"
+        "if(data.limiter){document.getElementById('lim_en').checked=data.limiter.enabled;"
+        "document.getElementById('lim_ceil').value=data.limiter.ceiling_db;"
+        "document.getElementById('lim_rel').value=data.limiter.release_ms;}"
+        "if(data.agc){document.getElementById('agc_en').checked=data.agc.enabled;"
+        "document.getElementById('agc_target').value=data.agc.target_lufs;"
+        "document.getElementById('agc_max').value=data.agc.max_gain_db;}"
+        "if(data.dither)document.getElementById('dither_mode').value=data.dither.mode;"
+        "if(data.mp3){document.getElementById('mp3_kbps').value=data.mp3.bitrate_kbps;"
+        "document.getElementById('mp3_note').textContent=data.mp3.available?'New /stream.mp3 listeners':'Not built in';}"
+        "if(data.opus){document.getElementById('opus_kbps').value=data.opus.bitrate_kbps;"
+        "document.getElementById('opus_ms').value=data.opus.frame_ms;"
+        "document.getElementById('opus_note').textContent=data.opus.available?'New /stream.opus listeners':'Not built in';}"
+        "if(data.rtp){document.getElementById('rtp_en').checked=data.rtp.enabled;"
+        "document.getElementById('rtp_group').value=data.rtp.group;"
+        "document.getElementById('rtp_port').value=data.rtp.port;"
+        "document.getElementById('rtp_bits').value=data.rtp.bits;"
+        "document.getElementById('rtp_ttl').value=data.rtp.ttl;"
+        "document.getElementById('rtp_note').innerHTML=data.rtp.running?'Sending, session description at <a href=\"/stream.sdp\">/stream.sdp</a>':'Off';}"
+        "if(data.snapcast){document.getElementById('snap_en').checked=data.snapcast.enabled;"
+        "document.getElementById('snap_codec').value=data.snapcast.codec;"
+        "document.getElementById('snap_buf').value=data.snapcast.buffer_ms;"
+        "document.getElementById('snap_opus').disabled=!data.snapcast.opus;"
+        "document.getElementById('snap_note').textContent=data.snapcast.running?'Listening on port '+data.snapcast.port+': snapclient --host '+location.hostname:'Off';}"
+        "if(data.hls){document.getElementById('hls_en').checked=data.hls.enabled;"
+        "document.getElementById('hls_seg').value=data.hls.segment_s;"
+        "document.getElementById('hls_note').innerHTML=data.hls.running?'FLAC in fMP4 at <a href=\"/hls/live.m3u8\">/hls/live.m3u8</a>, '+Math.round(data.hls.cache_bytes/1024)+' KB segment cache':'Off';}"
         "currentBands=data.bands;"
         "const tbody=document.getElementById('bands');"
         "tbody.innerHTML='';"
         "data.bands.forEach(b=>tbody.appendChild(buildRow(b)));"
+        "drawResponse();"
         "}).catch(()=>toast('Failed to load EQ config',false));}"
+        "function drawResponse(){"
+        "fetch('/eq/response?points=256').then(r=>r.json()).then(d=>{"
+        "const c=document.getElementById('resp'),g=c.getContext('2d'),W=c.width,H=c.height;"
+        "const lx=f=>Math.log(f/20)/Math.log(d.freq_hz[d.points-1]/20)*W;"
+        "const ly=db=>H/2-db*(H/2)/24;"
+        "g.clearRect(0,0,W,H);g.strokeStyle='#1a1a3e';g.fillStyle='#888';g.font='10px sans-serif';"
+        "[100,1000,10000].forEach(f=>{const x=lx(f);g.beginPath();g.moveTo(x,0);g.lineTo(x,H);g.stroke();g.fillText(f>=1000?f/1000+'k':f,x+2,H-4);});"
+        "[-12,0,12].forEach(db=>{const y=ly(db);g.beginPath();g.moveTo(0,y);g.lineTo(W,y);g.stroke();g.fillText(db+' dB',2,y-2);});"
+        "g.strokeStyle='#0f969c';g.lineWidth=2;g.beginPath();"
+        "d.magnitude_db.forEach((m,i)=>{const x=lx(d.freq_hz[i]),y=ly(Math.max(-24,Math.min(24,m)));i?g.lineTo(x,y):g.moveTo(x,y);});"
+        "g.stroke();g.lineWidth=1;}).catch(()=>{});}"
         "function applyEQ(){"
         "const bands=currentBands.map(b=>({index:b.index,"
         "enabled:document.getElementById('en'+b.index).checked,"
@@ -1195,16 +3491,105 @@ static esp_err_t eq_settings_page_handler(httpd_req_t *req) {
         "frequency_hz:parseFloat(document.getElementById('freq'+b.index).value)||b.frequency_hz,"
         "gain_db:parseFloat(document.getElementById('gain'+b.index).value)||0,"
         "q_factor:parseFloat(document.getElementById('q'+b.index).value)||b.q_factor}));"
-        "const payload=JSON.stringify({eq_enabled:document.getElementById('eq_enabled').checked,bands});"
+        "const phono={curve:document.getElementById('phono_curve').value,"
+        "rumble_filter:document.getElementById('phono_rumble').checked};"
+        "const limiter={enabled:document.getElementById('lim_en').checked,"
+        "ceiling_db:parseFloat(document.getElementById('lim_ceil').value)||0,"
+        "release_ms:parseFloat(document.getElementById('lim_rel').value)||100};"
+        "const agc={enabled:document.getElementById('agc_en').checked,"
+        "target_lufs:parseFloat(document.getElementById('agc_target').value)||-18,"
+        "max_gain_db:parseFloat(document.getElementById('agc_max').value)||0};"
+        "const dither={mode:document.getElementById('dither_mode').value};"
+        "const mp3={bitrate_kbps:parseInt(document.getElementById('mp3_kbps').value)};"
+        "const opus={bitrate_kbps:parseInt(document.getElementById('opus_kbps').value),"
+        "frame_ms:parseInt(document.getElementById('opus_ms').value)};"
+        "const rtp={enabled:document.getElementById('rtp_en').checked,"
+        "group:document.getElementById('rtp_group').value.trim(),"
+        "port:parseInt(document.getElementById('rtp_port').value)||5004,"
+        "bits:parseInt(document.getElementById('rtp_bits').value),"
+        "ttl:parseInt(document.getElementById('rtp_ttl').value)||1};"
+        "const snapcast={enabled:document.getElementById('snap_en').checked,"
+        "codec:document.getElementById('snap_codec').value,"
+        "buffer_ms:parseInt(document.getElementById('snap_buf').value)||1000};"
+        "const hls={enabled:document.getElementById('hls_en').checked,"
+        "segment_s:parseInt(document.getElementById('hls_seg').value)||2};"
+        "const payload=JSON.stringify({eq_enabled:document.getElementById('eq_enabled').checked,bands,phono,limiter,agc,dither,mp3,opus,rtp,snapcast,hls});"
         "fetch('/eq',{method:'POST',headers:{'Content-Type':'application/json'},body:payload})"
-        ".then(r=>r.json()).then(()=>toast('EQ settings applied',true))"
+        ".then(r=>r.json()).then(()=>{toast('EQ settings applied',true);drawResponse();})"
         ".catch(()=>toast('Failed to apply EQ',false));}"
         "function resetEQ(){"
         "if(!confirm('Reset all EQ bands to flat (0 dB)?'))return;"
         "fetch('/eq/reset',{method:'POST',headers:{'Content-Type':'application/json'},body:'{}'})"
         ".then(r=>r.json()).then(()=>{toast('EQ reset to flat',true);loadEQ();})"
         ".catch(()=>toast('Reset failed',false));}"
-        "loadEQ();"
+        "function loadPresets(){"
+        "fetch('/eq/presets').then(r=>r.json()).then(d=>{"
+        "const s=document.getElementById('preset');"
+        "s.innerHTML=d.presets.length?'':'<option value=\"\">(none saved)</option>';"
+        "d.presets.forEach(p=>{const o=document.createElement('option');o.value=o.textContent=p.name;"
+        "if(p.name===d.active)o.selected=true;s.appendChild(o);});"
+        "}).catch(()=>{});}"
+        "function presetAction(action){"
+        "const name=action==='save'?document.getElementById('preset_name').value.trim():document.getElementById('preset').value;"
+        "if(!name)return;"
+        "if(action==='delete'&&!confirm('Delete preset '+name+'?'))return;"
+        "fetch('/eq/presets',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({action,name})})"
+        ".then(r=>{if(!r.ok)throw 0;return r.json();})"
+        ".then(()=>{toast('Preset '+name+(action==='apply'?' loaded':action==='save'?' saved':' deleted'),true);loadPresets();loadEQ();})"
+        ".catch(()=>toast('Preset '+action+' failed',false));}"
+        "function showFir(d){"
+        "document.getElementById('fir_en').checked=d.enabled;"
+        "document.getElementById('fir_info').textContent=d.loaded?"
+        "`${d.taps} taps x ${d.channels} ch @ ${d.ir_sample_rate} Hz, ${d.partitions} partitions`+"
+        "(d.active?` | inline ${d.head_budget_pct.toFixed(1)}% + tail ${d.tail_budget_pct.toFixed(1)}% of block, ${d.deadline_misses} misses`"
+        ":d.ir_sample_rate!==d.sample_rate?` | inactive: stream runs at ${d.sample_rate} Hz`:' | inactive')"
+        ":'No impulse response loaded';}"
+        "function loadFir(){fetch('/eq/fir').then(r=>r.json()).then(showFir).catch(()=>{});}"
+        "function firEnable(on){"
+        "fetch('/eq/fir?enabled='+(on?1:0),{method:'POST'}).then(r=>{if(!r.ok)throw 0;return r.json();})"
+        ".then(showFir).catch(()=>toast('FIR switch failed',false));}"
+        "function firDelete(){"
+        "if(!confirm('Delete the stored impulse response?'))return;"
+        "fetch('/eq/fir',{method:'DELETE'}).then(r=>r.json()).then(showFir).catch(()=>{});}"
+        // Minimal WAV reader: PCM 16/24/32-bit or float32, mono or stereo
+        "function parseWav(buf){"
+        "const v=new DataView(buf);"
+        "if(v.getUint32(0,false)!==0x52494646||v.getUint32(8,false)!==0x57415645)throw 'Not a WAV file';"
+        "let p=12,fmt=null;"
+        "while(p+8<=buf.byteLength){"
+        "const id=v.getUint32(p,false),sz=v.getUint32(p+4,true);p+=8;"
+        "if(id===0x666d7420){let tag=v.getUint16(p,true);if(tag===0xFFFE)tag=v.getUint16(p+24,true);"
+        "fmt={tag,ch:v.getUint16(p+2,true),rate:v.getUint32(p+4,true),bits:v.getUint16(p+14,true)};}"
+        "else if(id===0x64617461&&fmt){"
+        "if(fmt.ch<1||fmt.ch>2)throw 'IR must be mono or stereo';"
+        "const bps=fmt.bits/8,n=Math.floor(Math.min(sz,buf.byteLength-p)/bps),out=new Float32Array(n);"
+        "for(let i=0;i<n;i++){const o=p+i*bps;"
+        "if(fmt.tag===3&&fmt.bits===32)out[i]=v.getFloat32(o,true);"
+        "else if(fmt.tag===1&&fmt.bits===16)out[i]=v.getInt16(o,true)/32768;"
+        "else if(fmt.tag===1&&fmt.bits===24)out[i]=((v.getInt8(o+2)<<16)|(v.getUint8(o+1)<<8)|v.getUint8(o))/8388608;"
+        "else if(fmt.tag===1&&fmt.bits===32)out[i]=v.getInt32(o,true)/2147483648;"
+        "else throw 'Unsupported WAV sample format';}"
+        "return {ch:fmt.ch,rate:fmt.rate,taps:n/fmt.ch,data:out};}"
+        "p+=sz+(sz&1);}"
+        "throw 'No audio data in WAV';}"
+        "function firUpload(){"
+        "const f=document.getElementById('fir_file').files[0];if(!f)return;"
+        "f.arrayBuffer().then(b=>{const w=parseWav(b);"
+        "if(w.taps>4096)throw 'IR longer than 4096 taps';"
+        "return fetch(`/eq/fir?taps=${w.taps}&channels=${w.ch}&rate=${w.rate}`,"
+        "{method:'POST',headers:{'Content-Type':'application/octet-stream'},body:w.data.buffer});})"
+        ".then(r=>{if(!r.ok)return r.text().then(t=>{throw t;});return r.json();})"
+        ".then(d=>{showFir(d);toast('Impulse response loaded',true);})"
+        ".catch(e=>toast('FIR upload failed: '+e,false));}"
+        "function drawSpectrum(){"
+        "fetch('/api/spectrum?bands=96&fps=10').then(r=>{if(!r.ok)throw 0;return r.arrayBuffer();}).then(b=>{"
+        "const v=new DataView(b),n=v.getUint16(4,true),fl=v.getFloat32(24,true),st=v.getFloat32(28,true),lv=new Uint8Array(b,36,n);"
+        "const c=document.getElementById('spec'),g=c.getContext('2d'),W=c.width,H=c.height,bw=W/n;"
+        "g.clearRect(0,0,W,H);g.fillStyle='#0f969c';"
+        "lv.forEach((q,i)=>{const db=fl+q*st,h=Math.max(0,(db+100)/100)*H;g.fillRect(i*bw,H-h,bw-1,h);});"
+        "}).catch(()=>{}).finally(()=>{if(!document.hidden)setTimeout(drawSpectrum,100);});}"
+        "document.addEventListener('visibilitychange',()=>{if(!document.hidden)drawSpectrum();});"
+        "loadEQ();loadPresets();loadFir();drawSpectrum();"
         "</script></body></html>");
 
     httpd_resp_sendstr_chunk(req, nullptr);
@@ -1228,8 +3613,9 @@ bool HTTPServer::init(uint16_t port, uint32_t sample_rate) {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.server_port = port;
     config.max_open_sockets = 4; // 3 streaming + 1 for status/config
-    config.max_uri_handlers = 20;
+    config.max_uri_handlers = 35;
     config.lru_purge_enable = true;
+    config.uri_match_fn = httpd_uri_match_wildcard;  // /hls/*; other URIs match exactly as before
     config.stack_size = 16384;  // Increased for larger audio chunks
     config.send_wait_timeout = 5;  // Allow time for WiFi congestion
     config.recv_wait_timeout = 5;
@@ -1269,6 +3655,113 @@ bool HTTPServer::init(uint16_t port, uint32_t sample_rate) {
         return false;
     }
 
+    httpd_uri_t stream24_wav_uri = {
+        .uri = "/stream24.wav",
+        .method = HTTP_GET,
+        .handler = stream_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &stream24_wav_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /stream24.wav URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t stream_flac_uri = {
+        .uri = "/stream.flac",
+        .method = HTTP_GET,
+        .handler = stream_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &stream_flac_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /stream.flac URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t stream_mp3_uri = {
+        .uri = "/stream.mp3",
+        .method = HTTP_GET,
+        .handler = stream_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &stream_mp3_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /stream.mp3 URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t stream_opus_uri = {
+        .uri = "/stream.opus",
+        .method = HTTP_GET,
+        .handler = stream_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &stream_opus_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /stream.opus URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t stream_sdp_uri = {
+        .uri = "/stream.sdp",
+        .method = HTTP_GET,
+        .handler = stream_sdp_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &stream_sdp_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /stream.sdp URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    // Register WebSocket PCM stream and its player page
+    httpd_uri_t ws_audio_uri = {
+        .uri = "/ws/audio",
+        .method = HTTP_GET,
+        .handler = ws_audio_handler,
+        .user_ctx = nullptr,
+        .is_websocket = true};
+    if (httpd_register_uri_handler(server, &ws_audio_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /ws/audio URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t player_uri = {
+        .uri = "/player",
+        .method = HTTP_GET,
+        .handler = player_page_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &player_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /player URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    // Register HLS playlist and segments
+    httpd_uri_t hls_uri = {
+        .uri = "/hls/*",
+        .method = HTTP_GET,
+        .handler = hls_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &hls_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /hls/* URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
     // Register status URI handler
     httpd_uri_t status_uri = {
         .uri = "/status",
@@ -1348,6 +3841,32 @@ bool HTTPServer::init(uint16_t port, uint32_t sample_rate) {
         return false;
     }
 
+    httpd_uri_t audio_level_reset_uri = {
+        .uri = "/api/audio-level",
+        .method = HTTP_POST,
+        .handler = audio_level_reset_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &audio_level_reset_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register POST /api/audio-level URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t stereo_uri = {
+        .uri = "/api/stereo",
+        .method = HTTP_GET,
+        .handler = stereo_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &stereo_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /api/stereo URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
     // EQ endpoints
     httpd_uri_t eq_settings_uri = {
         .uri = "/eq-settings",
@@ -1401,6 +3920,136 @@ bool HTTPServer::init(uint16_t port, uint32_t sample_rate) {
         return false;
     }
 
+    httpd_uri_t eq_response_uri = {
+        .uri = "/eq/response",
+        .method = HTTP_GET,
+        .handler = eq_response_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &eq_response_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /eq/response URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t eq_presets_get_uri = {
+        .uri = "/eq/presets",
+        .method = HTTP_GET,
+        .handler = eq_presets_get_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &eq_presets_get_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register GET /eq/presets URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t eq_presets_post_uri = {
+        .uri = "/eq/presets",
+        .method = HTTP_POST,
+        .handler = eq_presets_post_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &eq_presets_post_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register POST /eq/presets URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t eq_fir_get_uri = {
+        .uri = "/eq/fir",
+        .method = HTTP_GET,
+        .handler = eq_fir_get_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &eq_fir_get_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register GET /eq/fir URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t eq_fir_post_uri = {
+        .uri = "/eq/fir",
+        .method = HTTP_POST,
+        .handler = eq_fir_post_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &eq_fir_post_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register POST /eq/fir URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t eq_fir_delete_uri = {
+        .uri = "/eq/fir",
+        .method = HTTP_DELETE,
+        .handler = eq_fir_delete_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &eq_fir_delete_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register DELETE /eq/fir URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t spectrum_uri = {
+        .uri = "/api/spectrum",
+        .method = HTTP_GET,
+        .handler = spectrum_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &spectrum_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /api/spectrum URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t wow_flutter_get_uri = {
+        .uri = "/api/measure/wow-flutter",
+        .method = HTTP_GET,
+        .handler = wow_flutter_get_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &wow_flutter_get_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /api/measure/wow-flutter URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t wow_flutter_post_uri = {
+        .uri = "/api/measure/wow-flutter",
+        .method = HTTP_POST,
+        .handler = wow_flutter_post_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &wow_flutter_post_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register POST /api/measure/wow-flutter URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
+    httpd_uri_t thdn_uri = {
+        .uri = "/api/measure/thdn",
+        .method = HTTP_GET,
+        .handler = thdn_handler,
+        .user_ctx = nullptr};
+    if (httpd_register_uri_handler(server, &thdn_uri) != ESP_OK)
+    {
+        ErrorHandler::log_error(ErrorType::HTTP_ERROR, "Failed to register /api/measure/thdn URI");
+        httpd_stop(server);
+        server = nullptr;
+        return false;
+    }
+
     ESP_LOGI(TAG, "HTTP server started successfully");
     ESP_LOGI(TAG, "Stream endpoint: http://[ip]:%d/stream", port);
 
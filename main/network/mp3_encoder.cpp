@@ -0,0 +1,103 @@
+#include "mp3_encoder.h"
+#include "esp_log.h"
+
+#if __has_include("layer3.h")
+#include "layer3.h"
+#define MP3_HAVE_SHINE 1
+#else
+#define MP3_HAVE_SHINE 0
+#endif
+
+static const char *TAG = "mp3_encoder";
+
+// ─── Bitrates and rates ──────────────────────────────────────────────────────
+
+// MPEG-1 Layer III bitrates (kbps), bitrate index 1–14
+static const uint16_t BITRATES_KBPS[] = {
+    32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320
+};
+
+bool Mp3Encoder::available() {
+    return MP3_HAVE_SHINE != 0;
+}
+
+bool Mp3Encoder::supports_rate(uint32_t sample_rate) {
+    return sample_rate == 32000 || sample_rate == 44100 || sample_rate == 48000;
+}
+
+uint16_t Mp3Encoder::nearest_bitrate(uint32_t kbps) {
+    uint16_t best = BITRATES_KBPS[0];
+    for (uint16_t rate : BITRATES_KBPS) {
+        uint32_t d_best = kbps > best ? kbps - best : best - kbps;
+        uint32_t d      = kbps > rate ? kbps - rate : rate - kbps;
+        if (d < d_best) best = rate;
+    }
+    return best;
+}
+
+// ─── Encoder ─────────────────────────────────────────────────────────────────
+
+#if MP3_HAVE_SHINE
+
+bool Mp3Encoder::init(uint32_t sample_rate, uint16_t kbps) {
+    shine        = nullptr;
+    bitrate_kbps = nearest_bitrate(kbps);
+    if (!supports_rate(sample_rate) || shine_check_config((int)sample_rate, bitrate_kbps) < 0) {
+        ESP_LOGE(TAG, "MP3 %lu Hz / %u kbps not supported", (unsigned long)sample_rate, bitrate_kbps);
+        return false;
+    }
+
+    shine_config_t config;
+    shine_set_config_mpeg_defaults(&config.mpeg);
+    config.wave.channels   = PCM_STEREO;
+    config.wave.samplerate = (int)sample_rate;
+    config.mpeg.mode       = STEREO;
+    config.mpeg.bitr       = bitrate_kbps;
+
+    shine_t s = shine_initialise(&config);
+    if (s == nullptr) {
+        ESP_LOGE(TAG, "No memory for the MP3 encoder");
+        return false;
+    }
+    if (shine_samples_per_pass(s) != (int)MP3_FRAME_FRAMES) {
+        ESP_LOGE(TAG, "Unexpected MP3 frame size %d", shine_samples_per_pass(s));
+        shine_close(s);
+        return false;
+    }
+    shine = s;
+
+    ESP_LOGI(TAG, "MP3 %lu Hz, %u kbps CBR stereo", (unsigned long)sample_rate, bitrate_kbps);
+    return true;
+}
+
+void Mp3Encoder::deinit() {
+    if (shine != nullptr) shine_close((shine_t)shine);
+    shine = nullptr;
+}
+
+size_t Mp3Encoder::encode(const int16_t *lrlr, const uint8_t **out) {
+    if (shine == nullptr || out == nullptr) return 0;
+    int written = 0;
+    // shine takes a non-const buffer but only reads it
+    *out = shine_encode_buffer_interleaved((shine_t)shine, const_cast<int16_t *>(lrlr), &written);
+    return written > 0 ? (size_t)written : 0;
+}
+
+#else  // Built without the shine component
+
+bool Mp3Encoder::init(uint32_t sample_rate, uint16_t kbps) {
+    shine        = nullptr;
+    bitrate_kbps = nearest_bitrate(kbps);
+    ESP_LOGW(TAG, "MP3 encoder not built in (no shine component)");
+    return false;
+}
+
+void Mp3Encoder::deinit() {
+    shine = nullptr;
+}
+
+size_t Mp3Encoder::encode(const int16_t *lrlr, const uint8_t **out) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef MP3_ENCODER_H
+#define MP3_ENCODER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Mp3Encoder: MPEG-1 Layer III CBR for the shared stream encoder pipes.
+//
+// A thin wrapper around shine, the fixed-point Layer III encoder (no float,
+// no psychoacoustic model; bits are spent by a fixed quantization loop),
+// built when a `shine` component is present in components/ — see
+// main/CMakeLists.txt. Without it available() is false and /stream.mp3
+// answers 501.
+//
+// One pass encodes MP3_FRAME_FRAMES stereo frames (one MPEG-1 frame) and
+// returns that frame's bytes; frames are self-synchronizing, so the stream
+// has no header and a listener joins at any frame start. Only the MPEG-1
+// rates (32, 44.1, 48 kHz) are offered; 96 kHz captures use ?rate=48000.
+//
+// State (~50 KB) is allocated by shine at init().
+
+static constexpr uint32_t MP3_FRAME_FRAMES         = 1152;
+static constexpr uint16_t MP3_MIN_BITRATE_KBPS     = 32;
+static constexpr uint16_t MP3_MAX_BITRATE_KBPS     = 320;
+// 144 · bitrate / rate plus the padding byte, at 320 kbps and 32 kHz
+static constexpr size_t   MP3_MAX_FRAME_BYTES      = 144 * 320000 / 32000 + 1;
+
+struct Mp3Encoder {
+    void    *shine;         // shine_t
+    uint16_t bitrate_kbps;
+
+    // True if the firmware was built with the shine component
+    static bool available();
+
+    // True for the MPEG-1 sample rates
+    static bool supports_rate(uint32_t sample_rate);
+
+    // Nearest MPEG-1 Layer III bitrate (32–320 kbps)
+    static uint16_t nearest_bitrate(uint32_t kbps);
+
+    // Open a stereo CBR encoder. False if unavailable, the rate is not an
+    // MPEG-1 rate or shine is out of memory.
+    bool init(uint32_t sample_rate, uint16_t bitrate_kbps);
+    void deinit();
+
+    // Encode MP3_FRAME_FRAMES interleaved 16-bit stereo frames. `out` points
+    // into the encoder's own buffer until the next call. Returns bytes.
+    size_t encode(const int16_t *lrlr, const uint8_t **out);
+};
+
+#endif // MP3_ENCODER_H
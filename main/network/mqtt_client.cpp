@@ -1,7 +1,9 @@
 #include "mqtt_service.h"
 #include "../config_schema.h"
 #include "../storage/nvs_config.h"
+#include "../storage/eq_presets.h"
 #include "../audio/audio_capture.h"
+#include "../audio/loudness_meter.h"
 #include "esp_log.h"
 #include "esp_mac.h"
 #include "esp_event.h"
@@ -44,6 +46,24 @@ static char discovery_topic[256];
 static char state_topic[128];
 static char attributes_topic[128];
 static char availability_topic[128];
+static char preset_discovery_topic[256];
+static char preset_state_topic[128];
+static char preset_command_topic[128];
+static char loudness_topic[128];
+
+// Loudness sensors: one retained discovery config per value in the JSON state
+struct LoudnessSensor {
+    const char *key;       // JSON key in the loudness state payload / unique_id suffix
+    const char *name;
+    const char *unit;
+};
+static const LoudnessSensor LOUDNESS_SENSORS[] = {
+    { "momentary_lufs",    "Loudness Momentary",  "LUFS" },
+    { "short_term_lufs",   "Loudness Short-term", "LUFS" },
+    { "integrated_lufs",   "Loudness Integrated", "LUFS" },
+    { "loudness_range_lu", "Loudness Range",      "LU"   },
+};
+constexpr uint32_t LOUDNESS_PUBLISH_INTERVAL_MS = 1000;
 
 static void mqtt_reconnect_task_entry(void* params);
 
@@ -113,6 +133,14 @@ bool MQTTClient::init()
              "turntable/%s/attributes", device_id);
     snprintf(availability_topic, sizeof(availability_topic),
              "turntable/%s/availability", device_id);
+    snprintf(preset_discovery_topic, sizeof(preset_discovery_topic),
+             "homeassistant/select/%s/eq_preset/config", device_id);
+    snprintf(preset_state_topic, sizeof(preset_state_topic),
+             "turntable/%s/eq/preset", device_id);
+    snprintf(preset_command_topic, sizeof(preset_command_topic),
+             "turntable/%s/eq/preset/set", device_id);
+    snprintf(loudness_topic, sizeof(loudness_topic),
+             "turntable/%s/loudness", device_id);
 
     snprintf(broker_uri, sizeof(broker_uri), "%s://%s:%u",
              config.mqtt_use_tls ? "mqtts" : "mqtt",
@@ -276,6 +304,35 @@ bool MQTTClient::publish_discovery()
     }
     
     ESP_LOGI(TAG, "Discovery config published (msg_id: %d)", msg_id);
+
+    // Loudness sensors share one JSON state topic
+    for (const LoudnessSensor &sensor : LOUDNESS_SENSORS) {
+        char topic[160];
+        snprintf(topic, sizeof(topic), "homeassistant/sensor/%s/%s/config", device_id, sensor.key);
+        snprintf(payload, sizeof(payload),
+            "{"
+            "\"name\":\"%s\","
+            "\"unique_id\":\"%s_%s\","
+            "\"icon\":\"mdi:waveform\","
+            "\"unit_of_measurement\":\"%s\","
+            "\"state_class\":\"measurement\","
+            "\"state_topic\":\"%s\","
+            "\"value_template\":\"{{ value_json.%s }}\","
+            "\"availability_topic\":\"%s\","
+            "\"device\":{\"identifiers\":[\"%s\"]}"
+            "}",
+            sensor.name,
+            device_id, sensor.key,
+            sensor.unit,
+            loudness_topic,
+            sensor.key,
+            availability_topic,
+            device_id
+        );
+        if (esp_mqtt_client_publish(mqtt_client, topic, payload, 0, 1, 1) < 0) {
+            ESP_LOGW(TAG, "Failed to publish %s discovery", sensor.key);
+        }
+    }
     return true;
 }
 
@@ -321,6 +378,88 @@ bool MQTTClient::publish_attributes(const char* stream_url)
     return true;
 }
 
+bool MQTTClient::publish_eq_presets()
+{
+    if (mqtt_client == nullptr || !connected.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    EQPresetInfo presets[EQ_PRESET_MAX_COUNT];
+    uint8_t count = EQPresets::list(presets, EQ_PRESET_MAX_COUNT);
+
+    // A select entity needs at least one option; with no presets stored the
+    // retained discovery config is cleared so Home Assistant removes it.
+    if (count == 0) {
+        esp_mqtt_client_publish(mqtt_client, preset_discovery_topic, "", 0, 1, 1);
+    } else {
+        char options[EQ_PRESET_MAX_COUNT * (EQ_PRESET_NAME_LEN + 3)];
+        int pos = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            pos += snprintf(options + pos, sizeof(options) - pos, "%s\"%s\"",
+                            i == 0 ? "" : ",", presets[i].name);
+        }
+
+        char payload[896];
+        snprintf(payload, sizeof(payload),
+            "{"
+            "\"name\":\"EQ Preset\","
+            "\"unique_id\":\"%s_eq_preset\","
+            "\"icon\":\"mdi:tune-vertical\","
+            "\"state_topic\":\"%s\","
+            "\"command_topic\":\"%s\","
+            "\"options\":[%s],"
+            "\"availability_topic\":\"%s\","
+            "\"device\":{\"identifiers\":[\"%s\"]}"
+            "}",
+            device_id,
+            preset_state_topic,
+            preset_command_topic,
+            options,
+            availability_topic,
+            device_id
+        );
+        if (esp_mqtt_client_publish(mqtt_client, preset_discovery_topic, payload, 0, 1, 1) < 0) {
+            ESP_LOGW(TAG, "Failed to publish EQ preset discovery");
+            return false;
+        }
+    }
+
+    char active[EQ_PRESET_NAME_LEN];
+    EQPresets::get_active(active, sizeof(active));
+    int msg_id = esp_mqtt_client_publish(mqtt_client, preset_state_topic, active, 0, 1, 1);
+    if (msg_id < 0) {
+        ESP_LOGW(TAG, "Failed to publish EQ preset state");
+        return false;
+    }
+
+    ESP_LOGI(TAG, "EQ presets published (%u stored, active: '%s')", count, active);
+    return true;
+}
+
+bool MQTTClient::publish_loudness()
+{
+    if (mqtt_client == nullptr || !connected.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    LoudnessStats loud;
+    LoudnessMeter::get_stats(&loud);
+
+    char payload[192];
+    snprintf(payload, sizeof(payload),
+        "{\"momentary_lufs\":%.1f,\"short_term_lufs\":%.1f,"
+        "\"integrated_lufs\":%.1f,\"loudness_range_lu\":%.1f}",
+        loud.momentary_lufs, loud.short_term_lufs,
+        loud.integrated_lufs, loud.loudness_range_lu);
+
+    // QoS 0, not retained: a stale loudness reading is worse than none
+    if (esp_mqtt_client_publish(mqtt_client, loudness_topic, payload, 0, 0, 0) < 0) {
+        ESP_LOGW(TAG, "Failed to publish loudness");
+        return false;
+    }
+    return true;
+}
+
 bool MQTTClient::reconnect()
 {
     if (mqtt_client != nullptr) {
@@ -365,6 +504,7 @@ void MQTTClient::monitor_task(void* params)
     
     monitor_running.store(true, std::memory_order_release);
     bool last_state = false;
+    uint32_t loudness_elapsed_ms = 0;
     
     while (monitor_running.load(std::memory_order_acquire)) {
         // Check if connected
@@ -385,6 +525,15 @@ void MQTTClient::monitor_task(void* params)
             if (publish_state(current_state)) {
                 last_state = current_state;
             }
+            // Final reading of a side when it stops
+            if (!current_state) publish_loudness();
+        }
+
+        // Loudness once a second while a record plays
+        loudness_elapsed_ms += 500;
+        if (current_state && loudness_elapsed_ms >= LOUDNESS_PUBLISH_INTERVAL_MS) {
+            publish_loudness();
+            loudness_elapsed_ms = 0;
         }
         
         // Poll every 500ms
@@ -436,6 +585,10 @@ void MQTTClient::event_handler(void* handler_args, esp_event_base_t base, int32_
             char stream_url[128];
             get_stream_url(stream_url, sizeof(stream_url));
             publish_attributes(stream_url);
+
+            // EQ preset select: entity config, current value, and command topic
+            publish_eq_presets();
+            esp_mqtt_client_subscribe(mqtt_client, preset_command_topic, 1);
             
             // Start monitor task if not already running
             if (monitor_task_handle == nullptr) {
@@ -497,12 +650,47 @@ void MQTTClient::event_handler(void* handler_args, esp_event_base_t base, int32_
         case MQTT_EVENT_PUBLISHED:
             ESP_LOGD(TAG, "Message published (msg_id: %d)", event->msg_id);
             break;
+
+        case MQTT_EVENT_DATA:
+            handle_data(event);
+            break;
             
         default:
             break;
     }
 }
 
+void MQTTClient::handle_data(esp_mqtt_event_handle_t event)
+{
+    // Only single-fragment messages on the preset command topic are expected
+    if (event == nullptr || event->current_data_offset != 0 ||
+        event->data_len != event->total_data_len) {
+        return;
+    }
+
+    size_t topic_len = strlen(preset_command_topic);
+    if ((size_t)event->topic_len != topic_len ||
+        strncmp(event->topic, preset_command_topic, topic_len) != 0) {
+        return;
+    }
+
+    char name[EQ_PRESET_NAME_LEN];
+    if (event->data_len <= 0 || (size_t)event->data_len >= sizeof(name)) {
+        ESP_LOGW(TAG, "EQ preset command ignored (length %d)", event->data_len);
+        return;
+    }
+    memcpy(name, event->data, event->data_len);
+    name[event->data_len] = '\0';
+
+    if (EQPresets::apply(name)) {
+        ESP_LOGI(TAG, "EQ preset '%s' applied via MQTT", name);
+    } else {
+        ESP_LOGW(TAG, "EQ preset '%s' not found", name);
+    }
+    // Echo the (possibly unchanged) active preset so the select stays in sync
+    publish_eq_presets();
+}
+
 void MQTTClient::ip_event_handler(void* handler_args, esp_event_base_t base, int32_t event_id, void* event_data)
 {
     if (base != IP_EVENT || event_id != IP_EVENT_STA_GOT_IP) {
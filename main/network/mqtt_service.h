@@ -1,33 +1,40 @@
-#ifndef MQTT_SERVICE_H
-#define MQTT_SERVICE_H
-
-#include <cstddef>
-#include <cstdint>
-
-#include "esp_event.h"
-#include <mqtt_client.h>
-
-class MQTTClient {
-public:
-    static bool init();
-    static bool start();
-    static bool stop();
-    static bool publish_discovery();
-    static bool publish_state(bool is_playing);
-    static bool publish_attributes(const char* stream_url);
-    static bool reconnect();
-    static bool is_enabled();
-    static bool is_connected();
-    static const char* get_broker();
-    static const char* get_last_state();
-    static const char* get_last_error();
-
-private:
-    static void monitor_task(void* params);
-    static void event_handler(void* handler_args, esp_event_base_t base, int32_t event_id, void* event_data);
-    static void ip_event_handler(void* handler_args, esp_event_base_t base, int32_t event_id, void* event_data);
-    static void generate_device_id(char* buffer, size_t len);
-    static void get_stream_url(char* buffer, size_t len);
-};
-
+#ifndef MQTT_SERVICE_H
+#define MQTT_SERVICE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_event.h"
+#include <mqtt_client.h>
+
+class MQTTClient {
+public:
+    static bool init();
+    static bool start();
+    static bool stop();
+    static bool publish_discovery();
+    static bool publish_state(bool is_playing);
+    static bool publish_attributes(const char* stream_url);
+    // Publish the EQ preset select entity (discovery + retained state).
+    // Call after presets are saved, deleted or applied.
+    static bool publish_eq_presets();
+    // Publish momentary / short-term / integrated loudness and LRA (JSON,
+    // one topic feeding the four Home Assistant loudness sensors).
+    static bool publish_loudness();
+    static bool reconnect();
+    static bool is_enabled();
+    static bool is_connected();
+    static const char* get_broker();
+    static const char* get_last_state();
+    static const char* get_last_error();
+
+private:
+    static void monitor_task(void* params);
+    static void event_handler(void* handler_args, esp_event_base_t base, int32_t event_id, void* event_data);
+    static void ip_event_handler(void* handler_args, esp_event_base_t base, int32_t event_id, void* event_data);
+    static void generate_device_id(char* buffer, size_t len);
+    static void get_stream_url(char* buffer, size_t len);
+    static void handle_data(esp_mqtt_event_handle_t event);
+};
+
 #endif // MQTT_SERVICE_H
\ No newline at end of file
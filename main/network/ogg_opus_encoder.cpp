@@ -0,0 +1,221 @@
+#include "ogg_opus_encoder.h"
+#include "../audio/dsp_platform.h"
+#include <cstring>
+
+#if __has_include(<opus.h>)
+#include <opus.h>
+#define OPUS_HAVE_LIB 1
+#elif __has_include(<opus/opus.h>)
+#include <opus/opus.h>
+#define OPUS_HAVE_LIB 1
+#else
+#define OPUS_HAVE_LIB 0
+#endif
+
+static const char *TAG = "opus_encoder";
+
+// libopus keeps its working arrays on the stack (VAR_ARRAYS); CELT stereo
+// encoding peaks well under this
+static constexpr uint32_t OPUS_TASK_STACK_BYTES = 24576;
+
+// ─── Ogg pages ───────────────────────────────────────────────────────────────
+
+// CRC-32, polynomial 0x04C11DB7, MSB first, no reflection or final XOR
+struct OggCrcTable {
+    uint32_t t[256];
+};
+
+static constexpr OggCrcTable make_crc_table() {
+    OggCrcTable table = {};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i << 24;
+        for (int b = 0; b < 8; b++) c = (c & 0x80000000u) ? (c << 1) ^ 0x04C11DB7u : c << 1;
+        table.t[i] = c;
+    }
+    return table;
+}
+
+static constexpr OggCrcTable OGG_CRC = make_crc_table();
+
+static inline void put_le(uint8_t *p, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// One page holding one packet. `packet` may already sit inside `out` past
+// the header (it is moved into place). Returns the page size.
+// (Unused when built without the opus component.)
+[[maybe_unused]] static size_t write_page(uint8_t *out, uint8_t type, uint64_t granule, uint32_t serial,
+                                          uint32_t seq, const uint8_t *packet, size_t len) {
+    const size_t segments = len / 255 + 1;
+    memmove(out + 27 + segments, packet, len);
+
+    memcpy(out, "OggS", 4);
+    out[4] = 0;                             // Version
+    out[5] = type;                          // 0x02 = first page of the stream
+    put_le(out + 6, granule, 8);
+    put_le(out + 14, serial, 4);
+    put_le(out + 18, seq, 4);
+    put_le(out + 22, 0, 4);                 // CRC, filled in below
+    out[26] = (uint8_t)segments;
+    for (size_t i = 0; i + 1 < segments; i++) out[27 + i] = 255;
+    out[27 + segments - 1] = (uint8_t)(len % 255);
+
+    const size_t page = 27 + segments + len;
+    uint32_t crc = 0;
+    for (size_t i = 0; i < page; i++) crc = (crc << 8) ^ OGG_CRC.t[(crc >> 24) ^ out[i]];
+    put_le(out + 22, crc, 4);
+    return page;
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool OggOpusEncoder::available() {
+    return OPUS_HAVE_LIB != 0;
+}
+
+bool OggOpusEncoder::supports_rate(uint32_t rate) {
+    return rate == 8000 || rate == 12000 || rate == 16000 || rate == 24000 || rate == 48000;
+}
+
+uint16_t OggOpusEncoder::clamp_bitrate(uint32_t kbps) {
+    if (kbps < OPUS_MIN_BITRATE_KBPS) return OPUS_MIN_BITRATE_KBPS;
+    if (kbps > OPUS_MAX_BITRATE_KBPS) return OPUS_MAX_BITRATE_KBPS;
+    return (uint16_t)kbps;
+}
+
+uint32_t OggOpusEncoder::task_stack_bytes() {
+    return OPUS_HAVE_LIB ? OPUS_TASK_STACK_BYTES : 0;
+}
+
+#if OPUS_HAVE_LIB
+
+bool OggOpusEncoder::init(uint32_t rate, uint8_t ms, uint16_t kbps, uint32_t stream_serial) {
+    opus         = nullptr;
+    sample_rate  = rate;
+    frame_ms     = (ms == 10) ? 10 : 20;
+    frame_frames = rate * frame_ms / 1000;
+    bitrate_kbps = clamp_bitrate(kbps);
+    complexity   = OPUS_START_COMPLEXITY;
+    overruns     = 0;
+    calm_frames  = 0;
+    serial       = stream_serial;
+    page_seq     = 0;
+    granule      = 0;
+    header_len   = 0;
+    budget_cycles = (uint32_t)((uint64_t)frame_ms * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000 *
+                               OPUS_CYCLE_BUDGET_PCT / 100);
+    if (!supports_rate(rate)) {
+        ESP_LOGE(TAG, "Opus does not run at %lu Hz", (unsigned long)rate);
+        return false;
+    }
+
+    // Internal RAM first: the encoder state is touched on every frame
+    const size_t bytes = (size_t)opus_encoder_get_size(2);
+    OpusEncoder *enc = (OpusEncoder *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL);
+    if (enc == nullptr) enc = (OpusEncoder *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (enc == nullptr) {
+        ESP_LOGE(TAG, "No memory for the Opus encoder (%u bytes)", (unsigned)bytes);
+        return false;
+    }
+    if (opus_encoder_init(enc, (opus_int32)rate, 2, OPUS_APPLICATION_RESTRICTED_LOWDELAY) != OPUS_OK) {
+        ESP_LOGE(TAG, "opus_encoder_init failed");
+        heap_caps_free(enc);
+        return false;
+    }
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE((opus_int32)bitrate_kbps * 1000));
+    opus_encoder_ctl(enc, OPUS_SET_VBR(1));
+    opus_encoder_ctl(enc, OPUS_SET_SIGNAL(OPUS_SIGNAL_MUSIC));
+    opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(complexity));
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(enc, OPUS_GET_LOOKAHEAD(&lookahead));
+    opus = enc;
+
+    // OpusHead (RFC 7845 §5.1): version 1, stereo, pre-skip at 48 kHz,
+    // input rate, no gain, mapping family 0
+    uint8_t head[19];
+    memcpy(head, "OpusHead", 8);
+    head[8]  = 1;
+    head[9]  = 2;
+    put_le(head + 10, (uint64_t)lookahead * 48000 / rate, 2);
+    put_le(head + 12, rate, 4);
+    put_le(head + 16, 0, 2);
+    head[18] = 0;
+    size_t pos = write_page(header, 0x02, 0, serial, page_seq++, head, sizeof(head));
+
+    // OpusTags (§5.2): vendor string, no comments
+    uint8_t tags[96];
+    const char *vendor = opus_get_version_string();
+    size_t vendor_len  = strlen(vendor);
+    if (vendor_len > sizeof(tags) - 16) vendor_len = sizeof(tags) - 16;
+    memcpy(tags, "OpusTags", 8);
+    put_le(tags + 8, vendor_len, 4);
+    memcpy(tags + 12, vendor, vendor_len);
+    put_le(tags + 12 + vendor_len, 0, 4);
+    pos += write_page(header + pos, 0x00, 0, serial, page_seq++, tags, 16 + vendor_len);
+    header_len = (uint16_t)pos;
+
+    ESP_LOGI(TAG, "Opus %lu Hz, %u ms frames, %u kbps, complexity %u", (unsigned long)rate,
+             frame_ms, bitrate_kbps, complexity);
+    return true;
+}
+
+void OggOpusEncoder::deinit() {
+    if (opus != nullptr) heap_caps_free(opus);
+    opus = nullptr;
+}
+
+size_t OggOpusEncoder::encode(const int16_t *lrlr, uint8_t *out) {
+    if (opus == nullptr) return 0;
+    OpusEncoder *enc = (OpusEncoder *)opus;
+
+    // Encode past the largest page header, then write the header in front
+    uint8_t *packet = out + 27 + OPUS_MAX_PACKET_BYTES / 255 + 1;
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    opus_int32 len = opus_encode(enc, lrlr, (int)frame_frames, packet, (opus_int32)OPUS_MAX_PACKET_BYTES);
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+    if (len < 0) {
+        ESP_LOGW(TAG, "opus_encode failed (%ld)", (long)len);
+        return 0;
+    }
+
+    // Hold the cycle budget: step down at once, step back up slowly
+    if (cycles > budget_cycles) {
+        overruns++;
+        calm_frames = 0;
+        if (complexity > 0) {
+            complexity--;
+            opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(complexity));
+        }
+    } else if (cycles < budget_cycles / 2 && complexity < OPUS_START_COMPLEXITY) {
+        if (++calm_frames >= OPUS_RECOVER_MS / frame_ms) {
+            complexity++;
+            calm_frames = 0;
+            opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(complexity));
+        }
+    } else {
+        calm_frames = 0;
+    }
+
+    granule += (uint64_t)frame_frames * 48000 / sample_rate;
+    return write_page(out, 0x00, granule, serial, page_seq++, packet, (size_t)len);
+}
+
+#else  // Built without the opus component
+
+bool OggOpusEncoder::init(uint32_t rate, uint8_t ms, uint16_t kbps, uint32_t stream_serial) {
+    opus         = nullptr;
+    header_len   = 0;
+    bitrate_kbps = clamp_bitrate(kbps);
+    ESP_LOGW(TAG, "Opus encoder not built in (no opus component)");
+    return false;
+}
+
+void OggOpusEncoder::deinit() {
+    opus = nullptr;
+}
+
+size_t OggOpusEncoder::encode(const int16_t *lrlr, uint8_t *out) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef OGG_OPUS_ENCODER_H
+#define OGG_OPUS_ENCODER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// OggOpusEncoder: low-latency Opus in Ogg for the shared stream encoder pipes.
+//
+// libopus (built when an `opus` component is present in components/ — see
+// main/CMakeLists.txt) in OPUS_APPLICATION_RESTRICTED_LOWDELAY mode: CELT
+// only, 2.5 ms algorithmic delay, 10 or 20 ms frames at a configurable VBR
+// bitrate. Without the component available() is false and /stream.opus
+// answers 501.
+//
+// Framing (RFC 7845): the OpusHead and OpusTags pages are built at init and
+// sent by the HTTP handler; every packet then gets its own page, so nothing
+// waits for a page to fill (28 bytes per page: 11 kbps at 20 ms, 22 kbps at
+// 10 ms). A listener joins at any page start with a gap in page sequence and
+// granule position, as from an Icecast relay; Opus decoders resync within a
+// frame.
+//
+// Cycle budget: each frame may take OPUS_CYCLE_BUDGET_PCT of its own duration
+// on the encoder core. A frame over budget lowers the complexity by one
+// (counted as an overrun); after OPUS_RECOVER_MS of frames under half the
+// budget it is raised again, up to OPUS_START_COMPLEXITY.
+//
+// Encoder state (~30 KB stereo) is allocated in internal RAM first.
+
+static constexpr uint16_t OPUS_MIN_BITRATE_KBPS   = 16;
+static constexpr uint16_t OPUS_MAX_BITRATE_KBPS   = 256;
+static constexpr uint8_t  OPUS_START_COMPLEXITY   = 5;
+static constexpr uint32_t OPUS_CYCLE_BUDGET_PCT   = 30;
+static constexpr uint32_t OPUS_RECOVER_MS         = 10000;
+static constexpr size_t   OPUS_MAX_PACKET_BYTES   = 1275;    // One frame, RFC 6716
+// Page header, lacing for one packet, the packet
+static constexpr size_t   OGG_OPUS_MAX_PAGE_BYTES = 27 + OPUS_MAX_PACKET_BYTES / 255 + 1 + OPUS_MAX_PACKET_BYTES;
+static constexpr size_t   OGG_OPUS_HEADER_BYTES   = 192;     // OpusHead + OpusTags pages, at most
+
+struct OggOpusEncoder {
+    void    *opus;              // libopus OpusEncoder
+    uint32_t sample_rate;
+    uint32_t frame_frames;      // Input frames per packet
+    uint8_t  frame_ms;
+    uint16_t bitrate_kbps;
+    uint8_t  complexity;        // Current (0–OPUS_START_COMPLEXITY)
+    uint32_t budget_cycles;     // Per frame
+    uint32_t overruns;          // Frames over budget
+    uint32_t calm_frames;       // Consecutive frames under half the budget
+    uint32_t serial;            // Ogg logical stream
+    uint32_t page_seq;
+    uint64_t granule;           // 48 kHz samples through the last page
+    uint8_t  header[OGG_OPUS_HEADER_BYTES];
+    uint16_t header_len;
+
+    // True if the firmware was built with the opus component
+    static bool available();
+
+    // True for the Opus API rates (8, 12, 16, 24, 48 kHz)
+    static bool supports_rate(uint32_t sample_rate);
+
+    // Bitrate clamped to OPUS_MIN_BITRATE_KBPS–OPUS_MAX_BITRATE_KBPS
+    static uint16_t clamp_bitrate(uint32_t kbps);
+
+    // Stack the encoder task needs on top of its own for opus_encode()
+    // (0 without the component)
+    static uint32_t task_stack_bytes();
+
+    // Open a stereo encoder and build the header pages. `frame_ms` is 10 or
+    // 20 (anything else is 20). False if unavailable, the rate is not an Opus
+    // rate or memory is short.
+    bool init(uint32_t sample_rate, uint8_t frame_ms, uint16_t bitrate_kbps, uint32_t serial);
+    void deinit();
+
+    // Encode frame_frames interleaved 16-bit stereo frames into one Ogg page
+    // (room for OGG_OPUS_MAX_PAGE_BYTES). Returns the page size, 0 on error.
+    size_t encode(const int16_t *lrlr, uint8_t *out);
+};
+
+#endif // OGG_OPUS_ENCODER_H
@@ -0,0 +1,441 @@
+#include "rtp_sender.h"
+#include "stream_encoder.h"
+#include "wifi_manager.h"
+#include "../audio/audio_buffer.h"
+#include "../audio/dither.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static const char *TAG = "rtp_sender";
+
+static_assert(RTP_BLOCK_FRAMES * AudioStream::BYTES_PER_FRAME <= RTP_MAX_PAYLOAD,
+              "one DMA block fits an L24 packet");
+
+static constexpr uint32_t MAX_PACKET_FRAMES = RTP_MAX_PAYLOAD / 4;  // L16 stereo
+static constexpr uint32_t NTP_UNIX_OFFSET_S = 2208988800u;        // 1900 → 1970
+static constexpr int      DSCP_AF41_TOS     = 34 << 2;            // AES67 media class
+
+struct RtpSettings {
+    bool     enabled;
+    char     group[16];
+    uint16_t port;
+    uint8_t  bits;
+    uint8_t  ttl;
+};
+
+// Settings from configure(), picked up by the task
+static SemaphoreHandle_t s_mutex   = nullptr;   // Settings, session description, stats
+static TaskHandle_t      s_task    = nullptr;
+static RtpSettings       s_pending = {};
+static std::atomic<bool> s_changed{false};
+static uint32_t          s_capture_rate = 48000;
+static uint32_t          s_session_id   = 0;    // SDP origin, per boot
+
+// Session state (sender task)
+static std::atomic<bool> s_running{false};
+static RtpSettings s_active = {};
+static uint32_t    s_session_version = 0;
+static int         s_sock = -1;
+static sockaddr_in s_rtp_addr;
+static sockaddr_in s_rtcp_addr;
+static uint32_t    s_ssrc;
+static uint16_t    s_seq;
+static uint32_t    s_ts_base;                   // RTP timestamp of capture frame 0
+static bool        s_marker;                    // First packet after a start or resync
+static uint32_t    s_packet_frames;
+static uint64_t    s_next_frame;                // Capture frame of the next packet's first frame
+static size_t      s_fill;                      // Bytes collected in s_in24
+static int64_t     s_next_rtcp_us;
+static Ditherer    s_dither;
+static char        s_cname[32];
+static RtpStats    s_stats = {};
+static uint32_t    s_latency_avg_us;
+static uint32_t    s_latency_max_us;
+
+static uint8_t s_in24[MAX_PACKET_FRAMES * AudioStream::BYTES_PER_FRAME];
+static uint8_t s_packet[RTP_HEADER_BYTES + RTP_MAX_PAYLOAD];
+
+static inline void put_be16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static inline void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// Whole DMA blocks per datagram
+static uint32_t packet_frames(uint8_t bits) {
+    const uint32_t block_bytes = RTP_BLOCK_FRAMES * 2 * (bits / 8);
+    return (uint32_t)(RTP_MAX_PAYLOAD / block_bytes) * RTP_BLOCK_FRAMES;
+}
+
+// ─── RTCP ────────────────────────────────────────────────────────────────────
+
+// Sender report + SDES CNAME (+ BYE when leaving)
+static void send_rtcp(bool bye) {
+    uint8_t pkt[28 + 8 + sizeof(s_cname) + 4 + 8];
+
+    // The report's timestamps are the capture clock's: the frame that
+    // follows the last block written, and when that block reached the ring
+    uint64_t frames     = 0;
+    int64_t  written_us = 0;
+    AudioBuffer::get_clock(&frames, &written_us);
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    const int64_t wall_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - (esp_timer_get_time() - written_us);
+    const uint32_t ntp_s  = (uint32_t)(wall_us / 1000000) + NTP_UNIX_OFFSET_S;
+    const uint32_t ntp_f  = (uint32_t)(((uint64_t)(wall_us % 1000000) << 32) / 1000000);
+
+    pkt[0] = 0x80;                          // V=2, no reception reports
+    pkt[1] = 200;                           // SR
+    put_be16(pkt + 2, 6);
+    put_be32(pkt + 4, s_ssrc);
+    put_be32(pkt + 8, ntp_s);
+    put_be32(pkt + 12, ntp_f);
+    put_be32(pkt + 16, s_ts_base + (uint32_t)frames);
+    put_be32(pkt + 20, s_stats.packets);
+    put_be32(pkt + 24, s_stats.octets);
+    size_t len = 28;
+
+    // SDES: one chunk, CNAME then END, padded to a 32-bit boundary
+    const size_t cname = strlen(s_cname);
+    const size_t chunk = (4 + 2 + cname + 1 + 3) & ~(size_t)3;
+    memset(pkt + len, 0, 4 + chunk);
+    pkt[len]     = 0x81;                    // V=2, one chunk
+    pkt[len + 1] = 202;                     // SDES
+    put_be16(pkt + len + 2, (uint16_t)(chunk / 4));
+    put_be32(pkt + len + 4, s_ssrc);
+    pkt[len + 8] = 1;                       // CNAME
+    pkt[len + 9] = (uint8_t)cname;
+    memcpy(pkt + len + 10, s_cname, cname);
+    len += 4 + chunk;
+
+    if (bye) {
+        pkt[len]     = 0x81;                // V=2, one source
+        pkt[len + 1] = 203;                 // BYE
+        put_be16(pkt + len + 2, 1);
+        put_be32(pkt + len + 4, s_ssrc);
+        len += 8;
+    }
+
+    if (sendto(s_sock, pkt, len, 0, (const sockaddr *)&s_rtcp_addr, sizeof(s_rtcp_addr)) < 0) {
+        ESP_LOGD(TAG, "RTCP sendto failed (errno %d)", errno);
+    }
+
+    // RFC 3550 §6.3.1: randomized over 0.5–1.5 × the interval
+    const uint32_t interval_us = RTCP_INTERVAL_MS * 1000;
+    s_next_rtcp_us = esp_timer_get_time() + interval_us / 2 + esp_random() % interval_us;
+}
+
+// ─── Session ─────────────────────────────────────────────────────────────────
+
+static bool start_session(const RtpSettings &cfg) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(cfg.port);
+    if (inet_pton(AF_INET, cfg.group, &addr.sin_addr) != 1) return false;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create RTP socket (errno %d)", errno);
+        return false;
+    }
+    uint8_t ttl = cfg.ttl;
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    int tos = DSCP_AF41_TOS;
+    setsockopt(sock, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+
+    // Live position: multicast receivers bring their own jitter buffer
+    if (!AudioBuffer::register_client(AUDIO_BUFFER_RTP_READER, 0)) {
+        close(sock);
+        return false;
+    }
+
+    char ip[16] = "0.0.0.0";
+    WiFiManager::get_ip_address(ip, sizeof(ip));
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_sock        = sock;
+    s_rtp_addr    = addr;
+    s_rtcp_addr   = addr;
+    s_rtcp_addr.sin_port = htons((uint16_t)(cfg.port + 1));
+    s_ssrc        = esp_random();
+    s_seq         = (uint16_t)esp_random();
+    s_ts_base     = esp_random();
+    s_marker      = true;
+    s_packet_frames = packet_frames(cfg.bits);
+    s_fill        = 0;
+    s_next_frame  = AudioBuffer::reader_frame(AUDIO_BUFFER_RTP_READER);
+    s_next_rtcp_us = 0;                     // First report with the first packet
+    s_dither.init(StreamEncoder::dither(), 0x6A09E667u);
+    snprintf(s_cname, sizeof(s_cname), "turntable@%s", ip);
+    s_stats           = {};
+    s_latency_avg_us  = 0;
+    s_latency_max_us  = 0;
+    s_active          = cfg;
+    s_session_version++;
+    s_running.store(true, std::memory_order_release);
+    xSemaphoreGive(s_mutex);
+
+    ESP_LOGI(TAG, "RTP L%u/%lu/2 to %s:%u (TTL %u), %lu frames per packet", cfg.bits,
+             (unsigned long)s_capture_rate, cfg.group, cfg.port, cfg.ttl, (unsigned long)s_packet_frames);
+    return true;
+}
+
+static void stop_session() {
+    send_rtcp(true);
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_running.store(false, std::memory_order_release);
+    AudioBuffer::unregister_client(AUDIO_BUFFER_RTP_READER);
+    close(s_sock);
+    s_sock = -1;
+    xSemaphoreGive(s_mutex);
+
+    ESP_LOGI(TAG, "RTP stopped (%lu packets, %lu send errors)", (unsigned long)s_stats.packets,
+             (unsigned long)s_stats.send_errors);
+}
+
+// Payload from s_in24, in network byte order. Returns its size.
+static size_t build_payload(uint8_t *out) {
+    const size_t samples = s_packet_frames * 2;
+    if (s_active.bits == 16) {
+        DitherMode mode = StreamEncoder::dither();
+        if (mode != s_dither.mode) {
+            s_dither.mode = mode;
+            s_dither.reset();
+        }
+        s_dither.process_s24(s_in24, out, s_packet_frames);
+        for (size_t i = 0; i < samples; i++) {
+            uint8_t lo     = out[i * 2];
+            out[i * 2]     = out[i * 2 + 1];
+            out[i * 2 + 1] = lo;
+        }
+        return samples * 2;
+    }
+
+    for (size_t i = 0; i < samples; i++) {
+        out[i * 3]     = s_in24[i * 3 + 2];
+        out[i * 3 + 1] = s_in24[i * 3 + 1];
+        out[i * 3 + 2] = s_in24[i * 3];
+    }
+    return samples * 3;
+}
+
+static void send_packet() {
+    uint8_t *p = s_packet;
+    p[0] = 0x80;                            // V=2, no padding, extension or CSRCs
+    p[1] = (uint8_t)((s_marker ? 0x80 : 0x00) | RTP_PAYLOAD_TYPE);
+    put_be16(p + 2, s_seq);
+    put_be32(p + 4, s_ts_base + (uint32_t)s_next_frame);
+    put_be32(p + 8, s_ssrc);
+    const size_t payload = build_payload(p + RTP_HEADER_BYTES);
+
+    // A failed send is a lost packet to the receivers: the sequence moves on
+    const int sent = sendto(s_sock, s_packet, RTP_HEADER_BYTES + payload, 0,
+                            (const sockaddr *)&s_rtp_addr, sizeof(s_rtp_addr));
+    const int64_t now = esp_timer_get_time();
+    s_seq++;
+    s_next_frame += s_packet_frames;
+    if (sent < 0) {
+        if (s_stats.send_errors++ % 1000 == 0) {
+            ESP_LOGW(TAG, "RTP sendto failed (errno %d, %lu so far)", errno,
+                     (unsigned long)s_stats.send_errors);
+        }
+        return;
+    }
+    s_marker = false;
+    s_stats.packets++;
+    s_stats.octets += (uint32_t)payload;
+
+    // Capture → send latency of the packet's last frame
+    uint64_t frames     = 0;
+    int64_t  written_us = 0;
+    AudioBuffer::get_clock(&frames, &written_us);
+    const int64_t arrived_us = written_us - (int64_t)((frames - s_next_frame) * 1000000 / s_capture_rate);
+    const uint32_t latency   = now > arrived_us ? (uint32_t)(now - arrived_us) : 0;
+    s_latency_avg_us = s_latency_avg_us == 0 ? latency
+                                             : s_latency_avg_us - (s_latency_avg_us >> 4) + (latency >> 4);
+    if (latency > s_latency_max_us) s_latency_max_us = latency;
+}
+
+// Collect capture frames and send each full packet. False if nothing was
+// waiting.
+static bool pump() {
+    uint64_t captured = 0;
+    AudioBuffer::get_clock(&captured, nullptr);
+    const uint64_t position = s_next_frame + s_fill / AudioStream::BYTES_PER_FRAME;
+    if (captured > position && captured - position > (uint64_t)s_capture_rate * RTP_RESYNC_MS / 1000) {
+        AudioBuffer::unregister_client(AUDIO_BUFFER_RTP_READER);
+        AudioBuffer::register_client(AUDIO_BUFFER_RTP_READER, 0);
+        s_next_frame = AudioBuffer::reader_frame(AUDIO_BUFFER_RTP_READER);
+        s_fill       = 0;
+        s_marker     = true;
+        s_stats.resyncs++;
+        ESP_LOGW(TAG, "RTP sender %llu frames behind capture, resynced",
+                 (unsigned long long)(captured - position));
+    }
+
+    const size_t packet_bytes = s_packet_frames * AudioStream::BYTES_PER_FRAME;
+    size_t got = 0;
+    if (!AudioBuffer::read(AUDIO_BUFFER_RTP_READER, s_in24 + s_fill, packet_bytes - s_fill, &got) || got == 0) {
+        return false;
+    }
+    s_fill += got;
+    if (s_fill == packet_bytes) {
+        s_fill = 0;
+        send_packet();
+    }
+    return true;
+}
+
+static void rtp_task(void *params) {
+    for (;;) {
+        if (s_changed.exchange(false, std::memory_order_acq_rel)) {
+            xSemaphoreTake(s_mutex, portMAX_DELAY);
+            RtpSettings cfg = s_pending;
+            xSemaphoreGive(s_mutex);
+            if (s_running.load(std::memory_order_acquire)) stop_session();
+            if (cfg.enabled && !start_session(cfg)) {
+                ESP_LOGE(TAG, "RTP sender not started");
+            }
+        }
+        if (!s_running.load(std::memory_order_acquire)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        const bool busy = pump();
+        if (s_stats.packets > 0 && esp_timer_get_time() >= s_next_rtcp_us) send_rtcp(false);
+        if (!busy) vTaskDelay(pdMS_TO_TICKS(1));
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool RtpSender::init(uint32_t capture_rate) {
+    s_capture_rate = capture_rate;
+    s_session_id   = esp_random();
+
+    if (s_mutex == nullptr) s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == nullptr) {
+        ESP_LOGE(TAG, "Failed to create RTP mutex");
+        return false;
+    }
+
+    if (s_task == nullptr) {
+        BaseType_t result = xTaskCreatePinnedToCore(
+            rtp_task,
+            "rtp_tx",
+            4096,
+            nullptr,
+            7,  // Above HTTP / stream senders (6), below WiFi (8)
+            &s_task,
+            1   // Core 1
+        );
+        if (result != pdPASS) {
+            s_task = nullptr;
+            ESP_LOGE(TAG, "Failed to create rtp_tx task");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RtpSender::is_valid_group(const char *group) {
+    in_addr addr;
+    if (group == nullptr || inet_pton(AF_INET, group, &addr) != 1) return false;
+    return (ntohl(addr.s_addr) >> 28) == 0xE;
+}
+
+bool RtpSender::configure(bool enabled, const char *group, uint16_t port, uint8_t bits, uint8_t ttl) {
+    const bool valid = is_valid_group(group) && port > 0 && port % 2 == 0;
+    if (enabled && !valid) {
+        ESP_LOGW(TAG, "Invalid RTP destination %s:%u (multicast group, even port)",
+                 group != nullptr ? group : "", port);
+    }
+    if (s_mutex == nullptr || s_task == nullptr) return !enabled;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_pending.enabled = enabled && valid;
+    memset(s_pending.group, 0, sizeof(s_pending.group));
+    if (group != nullptr) strncpy(s_pending.group, group, sizeof(s_pending.group) - 1);
+    s_pending.port = port;
+    s_pending.bits = bits == 16 ? 16 : 24;
+    s_pending.ttl  = ttl == 0 ? 1 : ttl;
+    xSemaphoreGive(s_mutex);
+
+    s_changed.store(true, std::memory_order_release);
+    xTaskNotifyGive(s_task);
+    return valid || !enabled;
+}
+
+bool RtpSender::is_running() {
+    return s_running.load(std::memory_order_acquire);
+}
+
+size_t RtpSender::build_sdp(char *buf, size_t len, const char *source_ip, const char *session_name) {
+    if (buf == nullptr || s_mutex == nullptr) return 0;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    const bool        running = s_running.load(std::memory_order_acquire);
+    const RtpSettings cfg     = s_active;
+    const uint32_t    frames  = s_packet_frames;
+    const uint32_t    version = s_session_version;
+    xSemaphoreGive(s_mutex);
+    if (!running) return 0;
+
+    const uint32_t ptime_us = (uint32_t)((uint64_t)frames * 1000000 / s_capture_rate);
+    int n = snprintf(buf, len,
+        "v=0\r\n"
+        "o=- %lu %lu IN IP4 %s\r\n"
+        "s=%s\r\n"
+        "c=IN IP4 %s/%u\r\n"
+        "t=0 0\r\n"
+        "m=audio %u RTP/AVP %u\r\n"
+        "a=rtpmap:%u L%u/%lu/2\r\n"
+        "a=ptime:%lu.%03lu\r\n"
+        "a=recvonly\r\n",
+        (unsigned long)s_session_id, (unsigned long)version, source_ip, session_name,
+        cfg.group, cfg.ttl,
+        cfg.port, RTP_PAYLOAD_TYPE,
+        RTP_PAYLOAD_TYPE, cfg.bits, (unsigned long)s_capture_rate,
+        (unsigned long)(ptime_us / 1000), (unsigned long)(ptime_us % 1000));
+    return (n > 0 && (size_t)n < len) ? (size_t)n : 0;
+}
+
+void RtpSender::get_stats(RtpStats *stats) {
+    if (stats == nullptr) return;
+    memset(stats, 0, sizeof(*stats));
+    if (s_mutex == nullptr) return;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    *stats               = s_stats;
+    stats->running       = s_running.load(std::memory_order_acquire);
+    memcpy(stats->group, s_active.group, sizeof(stats->group));
+    stats->port          = s_active.port;
+    stats->bits          = s_active.bits;
+    stats->ttl           = s_active.ttl;
+    stats->packet_frames = s_packet_frames;
+    xSemaphoreGive(s_mutex);
+
+    stats->latency_ms_avg = (float)s_latency_avg_us / 1000.0f;
+    stats->latency_ms_max = (float)s_latency_max_us / 1000.0f;
+}
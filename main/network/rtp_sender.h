@@ -0,0 +1,85 @@
+#ifndef RTP_SENDER_H
+#define RTP_SENDER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// RtpSender: RTP/UDP multicast output of the capture (RFC 3550, L16/L24 from
+// RFC 3551 / RFC 3190).
+//
+// An HTTP stream is one TCP connection per listener, and max_open_sockets
+// caps the listeners. A multicast group costs one transmission however many
+// receivers join it. The sender has its own AudioBuffer reader, which starts
+// at the live position (not 1.5 s back), and sends stereo at the capture
+// rate:
+//   L24  the capture bytes reordered to network byte order
+//   L16  dithered like the 16-bit HTTP streams (StreamEncoder::set_dither())
+//
+// Packets carry whole DMA blocks of RTP_BLOCK_FRAMES, as many as fit in one
+// RTP_MTU_BYTES datagram (IPv4, no options). At stereo L16 and L24 that is
+// one block, 5 ms at 48 kHz. The RTP timestamp is a random base plus the
+// capture frame index, so the RTP clock is the ADC sample clock and a gap in
+// capture shows up as a timestamp jump.
+//
+// RTCP (port + 1) gets a sender report with CNAME every RTCP_INTERVAL_MS,
+// and a BYE when the sender stops. The report pairs an RTP timestamp with
+// the wall-clock time (NTP format) at which that frame reached the capture
+// ring, taken from AudioBuffer's capture clock rather than from the send
+// time. The wall clock is only shared between devices once SNTP has set it.
+//
+// The session's SDP (RFC 4566) is built by build_sdp() for /stream.sdp, e.g.
+//   curl -o turntable.sdp http://<ip>:8080/stream.sdp
+//   ffplay -protocol_whitelist file,udp,rtp turntable.sdp
+//
+// The "rtp_tx" task (Core 1, priority 7: above HTTP and the stream senders,
+// so packets leave on the capture cadence; below WiFi) polls the ring every
+// millisecond and blocks while RTP is off. If it ever falls RTP_RESYNC_MS
+// behind capture, it jumps to the live position and sets the marker bit.
+
+static constexpr uint32_t RTP_BLOCK_FRAMES  = 240;     // One DMA block
+static constexpr size_t   RTP_MTU_BYTES     = 1500;
+static constexpr size_t   RTP_HEADER_BYTES  = 12;
+static constexpr size_t   RTP_MAX_PAYLOAD   = RTP_MTU_BYTES - 20 - 8 - RTP_HEADER_BYTES;  // IPv4, UDP
+static constexpr uint8_t  RTP_PAYLOAD_TYPE  = 96;      // Dynamic
+static constexpr uint32_t RTCP_INTERVAL_MS  = 5000;    // RFC 3550 minimum
+static constexpr uint32_t RTP_RESYNC_MS     = 500;
+
+struct RtpStats {
+    bool     running;
+    char     group[16];
+    uint16_t port;
+    uint8_t  bits;
+    uint8_t  ttl;
+    uint32_t packet_frames;     // Frames per packet
+    uint32_t packets;
+    uint32_t octets;            // Payload bytes (the RTCP sender octet count)
+    uint32_t send_errors;       // sendto() failures (packet dropped)
+    uint32_t resyncs;           // Jumps back to the live position
+    float    latency_ms_avg;    // Capture ring → sendto(), last frame of a packet
+    float    latency_ms_max;
+};
+
+class RtpSender {
+public:
+    // Create the (idle) sender task. Requires AudioBuffer::init().
+    static bool init(uint32_t capture_rate);
+
+    // Start, restart or stop the sender with these settings. `bits` is 16 or
+    // 24 (anything else is 24). False, and stopped, if enabled with a group
+    // that is not an IPv4 multicast address or an odd port.
+    static bool configure(bool enabled, const char *group, uint16_t port, uint8_t bits, uint8_t ttl);
+
+    // True for a dotted-quad address in 224.0.0.0/4
+    static bool is_valid_group(const char *group);
+
+    static bool is_running();
+
+    // SDP for the running session, sent from `source_ip` and named
+    // `session_name`. Returns its length, 0 if the sender is stopped or the
+    // buffer is too small.
+    static size_t build_sdp(char *buf, size_t len, const char *source_ip, const char *session_name);
+
+    static void get_stats(RtpStats *stats);
+};
+
+#endif // RTP_SENDER_H
@@ -0,0 +1,698 @@
+#include "snapcast_server.h"
+#include "stream_encoder.h"
+#include "stream_handler.h"
+#include "flac_encoder.h"
+#include "ogg_opus_encoder.h"
+#include "../audio/audio_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static const char *TAG = "snapcast";
+
+static_assert((SNAPCAST_OUTBOX_BYTES & (SNAPCAST_OUTBOX_BYTES - 1)) == 0, "outbox is a power of two");
+
+// Message types (snapcast common/message/message.hpp)
+static constexpr uint16_t MSG_CODEC_HEADER    = 1;
+static constexpr uint16_t MSG_WIRE_CHUNK      = 2;
+static constexpr uint16_t MSG_SERVER_SETTINGS = 3;
+static constexpr uint16_t MSG_TIME            = 4;
+static constexpr uint16_t MSG_HELLO           = 5;
+
+// Base message: type, id, refersTo (u16), sent, received (s32 sec, s32 usec),
+// payload size (u32), all little-endian
+static constexpr size_t   BASE_BYTES      = 26;
+static constexpr size_t   RX_BYTES        = BASE_BYTES + 1024;   // Hello JSON is ~300 bytes
+static constexpr size_t   HEADER_MAX      = 64;                  // WAV 44, FLAC 42, Opus 12
+static constexpr uint32_t OPUS_ID         = 0x4F505553;          // snapcast's Opus header marker
+static constexpr uint32_t MAX_PCM_RATE    = 96000;
+static constexpr size_t   CHUNK_BYTES_MAX = MAX_PCM_RATE * SNAPCAST_CHUNK_MS / 1000 * 4;
+static constexpr int64_t  CLOCK_RESET_US  = 10000;               // A capture restart, not jitter
+
+static_assert(CHUNK_BYTES_MAX >= FLAC_MAX_FRAME_BYTES && CHUNK_BYTES_MAX >= OGG_OPUS_MAX_PAGE_BYTES,
+              "chunk buffer holds one encoded frame");
+
+struct SnapSettings {
+    bool          enabled;
+    SnapcastCodec codec;
+    uint16_t      buffer_ms;
+};
+
+struct Client {
+    int      sock;                  // -1 = free slot
+    bool     streaming;             // Hello answered: gets chunks
+    uint8_t *rx;                    // RX_BYTES, then the outbox (PSRAM)
+    size_t   rx_len;
+    uint8_t *out;                   // SNAPCAST_OUTBOX_BYTES ring
+    uint32_t out_head;              // Bytes sent (absolute)
+    uint32_t out_tail;              // Bytes queued (absolute)
+    uint32_t head_left;             // Bytes of the message at out_head not yet sent
+    uint8_t  ctrl[BASE_BYTES + 8];  // Time reply being sent
+    uint8_t  ctrl_len;
+    uint8_t  ctrl_off;
+    bool     time_pending;
+    uint16_t time_refers;
+    int64_t  time_latency_us;       // Server receive time − client send time
+    int64_t  progress_us;           // Last send, or last time the queue was empty
+    SnapcastClientStats stats;
+};
+
+// Settings from configure(), picked up by the task
+static SemaphoreHandle_t s_mutex   = nullptr;   // Settings, stats
+static TaskHandle_t      s_task    = nullptr;
+static SnapSettings      s_pending = {};
+static std::atomic<bool> s_changed{false};
+static uint32_t          s_capture_rate = 48000;
+
+// Session state (server task)
+static std::atomic<bool> s_running{false};
+static SnapSettings       s_active = {};
+static int                s_listen = -1;
+static Client             s_clients[SNAPCAST_MAX_CLIENTS];
+static StreamSubscription s_sub = {};
+static bool               s_subscribed = false;
+static uint8_t            s_header[HEADER_MAX];
+static size_t             s_header_len;
+static size_t             s_chunk_bytes;        // PCM chunk
+static size_t             s_fill;               // PCM bytes collected in s_chunk
+static uint64_t           s_chunk_frame;        // Capture frame of s_chunk[0]
+static bool               s_clock_valid;
+static int64_t            s_clock_offset_q;     // Capture clock − nominal, µs << SNAPCAST_CLOCK_SHIFT
+static SnapcastStats      s_stats = {};
+static uint32_t           s_age_avg_us;
+static uint32_t           s_age_max_us;
+static uint32_t           s_jitter_avg_us;
+
+static uint8_t s_chunk[CHUNK_BYTES_MAX];
+
+static inline void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// snapcast tv: seconds and non-negative microseconds
+static void put_tv(uint8_t *p, int64_t us) {
+    int64_t sec = us / 1000000;
+    int64_t usec = us % 1000000;
+    if (usec < 0) {
+        sec--;
+        usec += 1000000;
+    }
+    put_le32(p, (uint32_t)(int32_t)sec);
+    put_le32(p + 4, (uint32_t)(int32_t)usec);
+}
+
+static int64_t get_tv(const uint8_t *p) {
+    return (int64_t)(int32_t)get_le32(p) * 1000000 + (int32_t)get_le32(p + 4);
+}
+
+static void put_base(uint8_t *p, uint16_t type, uint16_t refers, int64_t sent_us, uint32_t size) {
+    put_le16(p, type);
+    put_le16(p + 2, 0);                     // id: replies match on refersTo
+    put_le16(p + 4, refers);
+    put_tv(p + 6, sent_us);
+    put_tv(p + 14, 0);                      // received: set by the client
+    put_le32(p + 22, size);
+}
+
+static StreamFormat pipe_format(SnapcastCodec codec) {
+    switch (codec) {
+        case SnapcastCodec::PCM:  return {StreamCodec::PCM_S16, s_capture_rate, 2};
+        case SnapcastCodec::OPUS: return {StreamCodec::OPUS, 48000, 2};
+        default:                  return {StreamCodec::FLAC, s_capture_rate, 2};
+    }
+}
+
+// ─── Clients ─────────────────────────────────────────────────────────────────
+
+static uint32_t queued(const Client &c) {
+    return c.out_tail - c.out_head;
+}
+
+// Queue one message: base header, `prefix` and `payload`. False (nothing
+// queued) if it does not fit.
+static bool queue(Client &c, uint16_t type, uint16_t refers, const uint8_t *prefix, size_t prefix_len,
+                  const uint8_t *payload, size_t payload_len) {
+    const size_t len = BASE_BYTES + prefix_len + payload_len;
+    if (len > SNAPCAST_OUTBOX_BYTES - queued(c)) return false;
+
+    uint8_t base[BASE_BYTES];
+    put_base(base, type, refers, esp_timer_get_time(), (uint32_t)(prefix_len + payload_len));
+    const uint8_t *parts[3] = {base, prefix, payload};
+    const size_t   sizes[3] = {BASE_BYTES, prefix_len, payload_len};
+    for (int i = 0; i < 3; i++) {
+        uint32_t pos   = c.out_tail & (SNAPCAST_OUTBOX_BYTES - 1);
+        size_t   first = SNAPCAST_OUTBOX_BYTES - pos;
+        if (first > sizes[i]) first = sizes[i];
+        if (sizes[i] == 0) continue;
+        memcpy(c.out + pos, parts[i], first);
+        if (sizes[i] > first) memcpy(c.out, parts[i] + first, sizes[i] - first);
+        c.out_tail += (uint32_t)sizes[i];
+    }
+    if (queued(c) > c.stats.outbox_max) c.stats.outbox_max = queued(c);
+    return true;
+}
+
+static void close_client(Client &c, const char *reason) {
+    ESP_LOGI(TAG, "Client %s (%s) %s after %lu chunks", c.stats.name, c.stats.ip, reason,
+             (unsigned long)c.stats.chunks);
+    close(c.sock);
+    c.sock      = -1;
+    c.streaming = false;
+    heap_caps_free(c.rx);
+    c.rx  = nullptr;
+    c.out = nullptr;
+    c.stats.connected = false;
+}
+
+static void accept_client() {
+    sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    int sock = accept(s_listen, (sockaddr *)&addr, &addr_len);
+    if (sock < 0) return;
+
+    Client *c = nullptr;
+    for (auto &slot : s_clients) {
+        if (slot.sock < 0) { c = &slot; break; }
+    }
+    uint8_t *mem = c != nullptr ? (uint8_t *)heap_caps_malloc(RX_BYTES + SNAPCAST_OUTBOX_BYTES, MALLOC_CAP_SPIRAM)
+                                : nullptr;
+    if (mem == nullptr) {
+        ESP_LOGW(TAG, "Client refused: %s", c == nullptr ? "all slots in use" : "no memory");
+        close(sock);
+        return;
+    }
+
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));     // Time replies go out at once
+    setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+
+    *c = {};
+    c->sock        = sock;
+    c->rx          = mem;
+    c->out         = mem + RX_BYTES;
+    c->progress_us = esp_timer_get_time();
+    c->stats.connected = true;
+    inet_ntop(AF_INET, &addr.sin_addr, c->stats.ip, sizeof(c->stats.ip));
+    strncpy(c->stats.name, c->stats.ip, sizeof(c->stats.name) - 1);
+    ESP_LOGI(TAG, "Client connected from %s", c->stats.ip);
+}
+
+// Value of a string member of the Hello JSON (no escapes; host names have none)
+static void json_string(const char *json, const char *key, char *out, size_t size) {
+    char pattern[24];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char *p = strstr(json, pattern);
+    if (p == nullptr) return;
+    p += strlen(pattern);
+    while (*p == ' ' || *p == ':') p++;
+    if (*p++ != '"') return;
+    size_t n = 0;
+    while (p[n] != '\0' && p[n] != '"' && n + 1 < size) n++;
+    if (n == 0) return;
+    memcpy(out, p, n);
+    out[n] = '\0';
+}
+
+// Hello: settings, then the codec header; chunks follow
+static bool answer_hello(Client &c, uint16_t id, const uint8_t *payload, size_t size) {
+    if (size > 4) {
+        char json[RX_BYTES];
+        size_t n = get_le32(payload);
+        if (n > size - 4) n = size - 4;
+        memcpy(json, payload + 4, n);
+        json[n] = '\0';
+        json_string(json, "HostName", c.stats.name, sizeof(c.stats.name));
+        // Goes into /status JSON and HTML as is: host name characters only
+        for (char *p = c.stats.name; *p != '\0'; p++) {
+            if (!isalnum((unsigned char)*p) && *p != '-' && *p != '.' && *p != '_') *p = '_';
+        }
+    }
+
+    if (!s_subscribed) {
+        if (!StreamEncoder::subscribe(pipe_format(s_active.codec), &s_sub)) {
+            ESP_LOGE(TAG, "No %s encoder pipe for the snapclients", snapcast_codec_to_str(s_active.codec));
+            return false;
+        }
+        s_subscribed  = true;
+        s_fill        = 0;
+        s_clock_valid = false;
+    }
+
+    char settings[96];
+    int len = snprintf(settings, sizeof(settings),
+                       "{\"bufferMs\":%u,\"latency\":0,\"muted\":false,\"volume\":100}", s_active.buffer_ms);
+    uint8_t prefix[4];
+    put_le32(prefix, (uint32_t)len);
+    queue(c, MSG_SERVER_SETTINGS, id, prefix, 4, (const uint8_t *)settings, (size_t)len);
+
+    // Codec name, then the codec's own header
+    const char *codec = snapcast_codec_to_str(s_active.codec);
+    uint8_t codec_prefix[4 + 8 + 4];
+    const size_t name_len = strlen(codec);
+    put_le32(codec_prefix, (uint32_t)name_len);
+    memcpy(codec_prefix + 4, codec, name_len);
+    put_le32(codec_prefix + 4 + name_len, (uint32_t)s_header_len);
+    queue(c, MSG_CODEC_HEADER, 0, codec_prefix, 8 + name_len, s_header, s_header_len);
+
+    c.streaming = true;
+    ESP_LOGI(TAG, "Client %s (%s) streaming %s, %u ms buffer", c.stats.name, c.stats.ip, codec,
+             s_active.buffer_ms);
+    return true;
+}
+
+static bool handle_message(Client &c, const uint8_t *msg, int64_t received_us) {
+    const uint16_t type = (uint16_t)(msg[0] | (msg[1] << 8));
+    const uint16_t id   = (uint16_t)(msg[2] | (msg[3] << 8));
+    const uint32_t size = get_le32(msg + 22);
+
+    switch (type) {
+        case MSG_TIME:
+            // Answered at the next message boundary; a newer request replaces
+            // an unanswered one
+            c.time_pending    = true;
+            c.time_refers     = id;
+            c.time_latency_us = received_us - get_tv(msg + 6);
+            return true;
+        case MSG_HELLO:
+            return c.streaming || answer_hello(c, id, msg + BASE_BYTES, size);
+        default:
+            return true;        // ClientInfo (volume) and others: not applicable
+    }
+}
+
+// Read and handle whatever the client sent. False if it closed or misbehaved.
+static bool receive(Client &c) {
+    int n = recv(c.sock, c.rx + c.rx_len, RX_BYTES - c.rx_len, 0);
+    const int64_t now = esp_timer_get_time();
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+    c.rx_len += (size_t)n;
+
+    while (c.rx_len >= BASE_BYTES) {
+        const size_t len = BASE_BYTES + get_le32(c.rx + 22);
+        if (len > RX_BYTES) return false;
+        if (c.rx_len < len) break;
+        if (!handle_message(c, c.rx, now)) return false;
+        c.rx_len -= len;
+        memmove(c.rx, c.rx + len, c.rx_len);
+    }
+    return true;
+}
+
+// Send as much as the socket takes. Time replies go between messages, with
+// the send time taken as they go out. False on a socket error.
+static bool flush(Client &c) {
+    const int64_t now = esp_timer_get_time();
+    for (;;) {
+        const uint8_t *data;
+        size_t len;
+        if (c.ctrl_off < c.ctrl_len) {
+            data = c.ctrl + c.ctrl_off;
+            len  = c.ctrl_len - c.ctrl_off;
+        } else if (c.head_left == 0 && c.time_pending) {
+            put_base(c.ctrl, MSG_TIME, c.time_refers, esp_timer_get_time(), 8);
+            put_tv(c.ctrl + BASE_BYTES, c.time_latency_us);
+            c.ctrl_len     = BASE_BYTES + 8;
+            c.ctrl_off     = 0;
+            c.time_pending = false;
+            c.stats.time_syncs++;
+            continue;
+        } else if (queued(c) > 0) {
+            const uint32_t pos = c.out_head & (SNAPCAST_OUTBOX_BYTES - 1);
+            if (c.head_left == 0) {
+                uint8_t size[4];
+                for (int i = 0; i < 4; i++) size[i] = c.out[(pos + 22 + i) & (SNAPCAST_OUTBOX_BYTES - 1)];
+                c.head_left = BASE_BYTES + get_le32(size);
+            }
+            data = c.out + pos;
+            len  = SNAPCAST_OUTBOX_BYTES - pos;
+            if (len > c.head_left) len = c.head_left;
+        } else {
+            c.progress_us = now;
+            return true;
+        }
+
+        int sent = send(c.sock, data, len, MSG_DONTWAIT);
+        if (sent < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        c.progress_us = now;
+        if (c.ctrl_off < c.ctrl_len) {
+            c.ctrl_off += (uint8_t)sent;
+        } else {
+            c.out_head  += (uint32_t)sent;
+            c.head_left -= (uint32_t)sent;
+        }
+        if ((size_t)sent < len) return true;
+    }
+}
+
+// ─── Chunks ──────────────────────────────────────────────────────────────────
+
+// Server time of a capture frame: the nominal rate plus a smoothed offset,
+// so per-block jitter of the capture clock does not reach the clients
+static int64_t chunk_time(uint64_t frame) {
+    uint64_t frames     = 0;
+    int64_t  written_us = 0;
+    AudioBuffer::get_clock(&frames, &written_us);
+    const int64_t measured = written_us - ((int64_t)frames - (int64_t)frame) * 1000000 / s_capture_rate;
+    const int64_t nominal  = (int64_t)(frame * 1000000 / s_capture_rate);
+    const int64_t offset   = measured - nominal;
+
+    int64_t residual = offset - (s_clock_offset_q >> SNAPCAST_CLOCK_SHIFT);
+    if (!s_clock_valid || residual > CLOCK_RESET_US || residual < -CLOCK_RESET_US) {
+        s_clock_offset_q = offset * (1 << SNAPCAST_CLOCK_SHIFT);
+        s_clock_valid    = true;
+        residual         = 0;
+    } else {
+        s_clock_offset_q += residual;
+    }
+    const uint32_t jitter = (uint32_t)(residual < 0 ? -residual : residual);
+    s_jitter_avg_us = s_jitter_avg_us - (s_jitter_avg_us >> 4) + (jitter >> 4);
+    return nominal + (s_clock_offset_q >> SNAPCAST_CLOCK_SHIFT);
+}
+
+// Next chunk from the pipe: PCM collected to SNAPCAST_CHUNK_MS, FLAC frames
+// as they are, Opus packets out of their Ogg pages. Returns the payload size.
+static size_t next_chunk(const uint8_t **payload, uint64_t *frame) {
+    if (s_active.codec == SnapcastCodec::PCM) {
+        for (;;) {
+            uint64_t first = 0;
+            size_t n = StreamEncoder::read_frames(&s_sub, s_chunk + s_fill, s_chunk_bytes - s_fill, &first);
+            if (n == 0) return 0;
+            if (s_fill > 0 && first != s_chunk_frame + s_fill / 4) {
+                // The pipe resynced mid-chunk: start over from this read
+                memmove(s_chunk, s_chunk + s_fill, n);
+                s_fill = 0;
+            }
+            if (s_fill == 0) s_chunk_frame = first;
+            s_fill += n;
+            if (s_fill == s_chunk_bytes) break;
+        }
+        s_fill   = 0;
+        *payload = s_chunk;
+        *frame   = s_chunk_frame;
+        return s_chunk_bytes;
+    }
+
+    size_t len = StreamEncoder::read_frames(&s_sub, s_chunk, sizeof(s_chunk), frame);
+    *payload = s_chunk;
+    if (len > 0 && s_active.codec == SnapcastCodec::OPUS) {
+        // One packet per page: skip the page header and its lacing values
+        const size_t header = len > 27 ? 27 + (size_t)s_chunk[26] : len;
+        if (header >= len) return 0;
+        *payload = s_chunk + header;
+        len -= header;
+    }
+    return len;
+}
+
+static void pump_chunks() {
+    const uint8_t *payload = nullptr;
+    uint64_t frame = 0;
+    size_t len;
+    while ((len = next_chunk(&payload, &frame)) > 0) {
+        s_stats.chunks++;
+        const int64_t ts  = chunk_time(frame);
+        const int64_t age = esp_timer_get_time() - ts;
+        if (age > (int64_t)s_active.buffer_ms * 1000 / 2) {
+            s_stats.stale_chunks++;
+            continue;
+        }
+        const uint32_t age_us = age > 0 ? (uint32_t)age : 0;
+        s_age_avg_us = s_age_avg_us == 0 ? age_us : s_age_avg_us - (s_age_avg_us >> 4) + (age_us >> 4);
+        if (age_us > s_age_max_us) s_age_max_us = age_us;
+
+        uint8_t prefix[12];
+        put_tv(prefix, ts);
+        put_le32(prefix + 8, (uint32_t)len);
+        for (auto &c : s_clients) {
+            if (c.sock < 0 || !c.streaming) continue;
+            if (queue(c, MSG_WIRE_CHUNK, 0, prefix, sizeof(prefix), payload, len)) {
+                c.stats.chunks++;
+            } else {
+                c.stats.skipped++;
+            }
+        }
+    }
+}
+
+// ─── Session ─────────────────────────────────────────────────────────────────
+
+static bool build_codec_header(SnapcastCodec codec) {
+    switch (codec) {
+        case SnapcastCodec::PCM: {
+            WavHeader wav;
+            StreamHandler::build_wav_header(&wav, s_capture_rate, 2);
+            memcpy(s_header, &wav, WavHeader::SIZE);
+            s_header_len = WavHeader::SIZE;
+            return true;
+        }
+        case SnapcastCodec::OPUS:
+            put_le32(s_header, OPUS_ID);
+            put_le32(s_header + 4, 48000);
+            put_le16(s_header + 8, 16);
+            put_le16(s_header + 10, 2);
+            s_header_len = 12;
+            return true;
+        default:
+            s_header_len = FlacEncoder::stream_header(s_capture_rate, s_header, sizeof(s_header));
+            return s_header_len > 0;
+    }
+}
+
+static bool start_session(const SnapSettings &cfg) {
+    if (!SnapcastServer::supports(cfg.codec) || s_capture_rate > MAX_PCM_RATE) {
+        ESP_LOGE(TAG, "%s not available at %lu Hz", snapcast_codec_to_str(cfg.codec),
+                 (unsigned long)s_capture_rate);
+        return false;
+    }
+    if (!build_codec_header(cfg.codec)) return false;
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create listen socket (errno %d)", errno);
+        return false;
+    }
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(SNAPCAST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (const sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 2) < 0) {
+        ESP_LOGE(TAG, "Cannot listen on port %u (errno %d)", SNAPCAST_PORT, errno);
+        close(sock);
+        return false;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_listen      = sock;
+    s_active      = cfg;
+    s_subscribed  = false;
+    s_chunk_bytes = s_capture_rate * SNAPCAST_CHUNK_MS / 1000 * 4;
+    s_fill        = 0;
+    s_clock_valid = false;
+    s_stats       = {};
+    s_age_avg_us  = 0;
+    s_age_max_us  = 0;
+    s_jitter_avg_us = 0;
+    for (auto &c : s_clients) {
+        c      = {};
+        c.sock = -1;
+    }
+    s_running.store(true, std::memory_order_release);
+    xSemaphoreGive(s_mutex);
+
+    ESP_LOGI(TAG, "Snapcast server on port %u: %s, %u ms buffer", SNAPCAST_PORT,
+             snapcast_codec_to_str(cfg.codec), cfg.buffer_ms);
+    return true;
+}
+
+static void stop_session() {
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_running.store(false, std::memory_order_release);
+    for (auto &c : s_clients) {
+        if (c.sock >= 0) close_client(c, "disconnected (server stopped)");
+    }
+    if (s_subscribed) StreamEncoder::unsubscribe(&s_sub);
+    s_subscribed = false;
+    close(s_listen);
+    s_listen = -1;
+    xSemaphoreGive(s_mutex);
+
+    ESP_LOGI(TAG, "Snapcast server stopped (%lu chunks)", (unsigned long)s_stats.chunks);
+}
+
+// One select() round: accept, read requests, queue new chunks, send
+static void serve() {
+    fd_set readable;
+    fd_set writable;
+    FD_ZERO(&readable);
+    FD_ZERO(&writable);
+    FD_SET(s_listen, &readable);
+    int max_fd = s_listen;
+    for (auto &c : s_clients) {
+        if (c.sock < 0) continue;
+        FD_SET(c.sock, &readable);
+        if (queued(c) > 0 || c.time_pending || c.ctrl_off < c.ctrl_len) FD_SET(c.sock, &writable);
+        if (c.sock > max_fd) max_fd = c.sock;
+    }
+    timeval timeout = {0, (int)(SNAPCAST_POLL_MS * 1000)};
+    if (select(max_fd + 1, &readable, &writable, nullptr, &timeout) < 0) {
+        vTaskDelay(pdMS_TO_TICKS(SNAPCAST_POLL_MS));
+        return;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (FD_ISSET(s_listen, &readable)) accept_client();
+    for (auto &c : s_clients) {
+        if (c.sock >= 0 && FD_ISSET(c.sock, &readable) && !receive(c)) close_client(c, "disconnected");
+    }
+
+    if (s_subscribed) pump_chunks();
+
+    const int64_t now = esp_timer_get_time();
+    bool streaming = false;
+    for (auto &c : s_clients) {
+        if (c.sock < 0) continue;
+        if (!flush(c)) {
+            close_client(c, "disconnected (send failed)");
+            continue;
+        }
+        if (now - c.progress_us > (int64_t)SNAPCAST_STALL_MS * 1000) {
+            s_stats.dropped_clients++;
+            close_client(c, "dropped (not reading)");
+            continue;
+        }
+        streaming |= c.streaming;
+    }
+    if (s_subscribed && !streaming) {
+        StreamEncoder::unsubscribe(&s_sub);
+        s_subscribed = false;
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+static void snapcast_task(void *params) {
+    for (;;) {
+        if (s_changed.exchange(false, std::memory_order_acq_rel)) {
+            xSemaphoreTake(s_mutex, portMAX_DELAY);
+            SnapSettings cfg = s_pending;
+            xSemaphoreGive(s_mutex);
+            if (s_running.load(std::memory_order_acquire)) stop_session();
+            if (cfg.enabled && !start_session(cfg)) {
+                ESP_LOGE(TAG, "Snapcast server not started");
+            }
+        }
+        if (!s_running.load(std::memory_order_acquire)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        serve();
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool SnapcastServer::init(uint32_t capture_rate) {
+    s_capture_rate = capture_rate;
+    for (auto &c : s_clients) c.sock = -1;
+
+    if (s_mutex == nullptr) s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == nullptr) {
+        ESP_LOGE(TAG, "Failed to create Snapcast mutex");
+        return false;
+    }
+
+    if (s_task == nullptr) {
+        BaseType_t result = xTaskCreatePinnedToCore(
+            snapcast_task,
+            "snap_srv",
+            4096,
+            nullptr,
+            6,  // Same as HTTP / stream senders
+            &s_task,
+            1   // Core 1
+        );
+        if (result != pdPASS) {
+            s_task = nullptr;
+            ESP_LOGE(TAG, "Failed to create snap_srv task");
+            return false;
+        }
+    }
+    return true;
+}
+
+void SnapcastServer::configure(bool enabled, SnapcastCodec codec, uint16_t buffer_ms) {
+    if (s_mutex == nullptr || s_task == nullptr) return;
+    if (buffer_ms < SNAPCAST_MIN_BUFFER_MS) buffer_ms = SNAPCAST_MIN_BUFFER_MS;
+    if (buffer_ms > SNAPCAST_MAX_BUFFER_MS) buffer_ms = SNAPCAST_MAX_BUFFER_MS;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_pending.enabled   = enabled;
+    s_pending.codec     = codec;
+    s_pending.buffer_ms = buffer_ms;
+    xSemaphoreGive(s_mutex);
+
+    s_changed.store(true, std::memory_order_release);
+    xTaskNotifyGive(s_task);
+}
+
+bool SnapcastServer::supports(SnapcastCodec codec) {
+    return StreamEncoder::supports(pipe_format(codec));
+}
+
+bool SnapcastServer::is_running() {
+    return s_running.load(std::memory_order_acquire);
+}
+
+void SnapcastServer::get_stats(SnapcastStats *stats) {
+    if (stats == nullptr) return;
+    memset(stats, 0, sizeof(*stats));
+    if (s_mutex == nullptr) return;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    *stats           = s_stats;
+    stats->running   = s_running.load(std::memory_order_acquire);
+    stats->codec     = s_active.codec;
+    stats->buffer_ms = s_active.buffer_ms;
+    for (int i = 0; i < SNAPCAST_MAX_CLIENTS; i++) {
+        if (s_clients[i].sock < 0) continue;
+        stats->client[i]           = s_clients[i].stats;
+        stats->client[i].streaming = s_clients[i].streaming;
+        stats->clients++;
+    }
+    xSemaphoreGive(s_mutex);
+
+    stats->chunk_age_ms_avg = (float)s_age_avg_us / 1000.0f;
+    stats->chunk_age_ms_max = (float)s_age_max_us / 1000.0f;
+    stats->clock_jitter_us  = (float)s_jitter_avg_us;
+}
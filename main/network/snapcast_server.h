@@ -0,0 +1,103 @@
+#ifndef SNAPCAST_SERVER_H
+#define SNAPCAST_SERVER_H
+
+#include "../config_schema.h"
+#include <cstdint>
+#include <cstddef>
+
+// SnapcastServer: the stream side of the Snapcast server protocol (binary
+// protocol version 2, TCP port 1704), so stock snapclients play the capture
+// in sync with each other.
+//
+// HTTP listeners each buffer as their player sees fit and drift apart by
+// hundreds of milliseconds. A snapclient instead plays every sample at the
+// server time stamped on it plus the server's buffer (bufferMs). It learns
+// the server clock from Time messages: the server echoes the client's send
+// time with the receive time, and the client keeps the median offset.
+//
+//   Hello         client → server: JSON identity. Answered with
+//                 ServerSettings (bufferMs, volume) and the CodecHeader
+//   Time          client → server, echoed back with the measured latency
+//   WireChunk     server → client: timestamp and codec payload
+//
+// The server clock is esp_timer. A chunk's timestamp is the time its first
+// frame reached the capture ring: the capture frame comes from
+// StreamEncoder::read_frames(), its time from AudioBuffer's capture clock.
+// The clock's per-block jitter is smoothed with an EWMA of its offset from
+// the nominal sample rate (SNAPCAST_CLOCK_SHIFT), which still follows drift
+// between the ADC and esp_timer.
+//
+// Chunks come from a shared encoder pipe (network/stream_encoder.h), so a
+// snapclient and an HTTP listener of the same format cost one encoder. One
+// subscription feeds every client; the pipe opens with the first client and
+// closes with the last. Codecs, as snapclient names them:
+//   pcm   16-bit stereo at the capture rate, SNAPCAST_CHUNK_MS chunks
+//   flac  one FLAC frame per chunk (20 ms at 48 kHz)
+//   opus  one Opus packet per chunk at 48 kHz (the Ogg page header stripped)
+// Chunks already older than half the buffer when read (a new pipe starts
+// 1.5 s back) are skipped, since the clients would drop them anyway.
+//
+// The "snap_srv" task (Core 1, priority 6, like the HTTP stream senders)
+// sleeps in select() over the listener and client sockets for at most
+// SNAPCAST_POLL_MS, so Time requests are stamped as they arrive. Sockets are
+// non-blocking: each client has an SNAPCAST_OUTBOX_BYTES PSRAM queue, Time
+// replies go out at the next message boundary with a fresh send time, a chunk
+// that does not fit is skipped for that client, and a client whose queue has
+// not drained for SNAPCAST_STALL_MS is disconnected.
+//
+//   snapclient --host <ip>
+
+static constexpr uint16_t SNAPCAST_PORT           = 1704;
+static constexpr uint8_t  SNAPCAST_MAX_CLIENTS    = 4;
+static constexpr uint32_t SNAPCAST_CHUNK_MS       = 20;      // PCM chunks
+static constexpr uint32_t SNAPCAST_POLL_MS        = 5;
+static constexpr size_t   SNAPCAST_OUTBOX_BYTES   = 32768;   // Per client, power of two
+static constexpr uint32_t SNAPCAST_STALL_MS       = 5000;
+static constexpr uint8_t  SNAPCAST_CLOCK_SHIFT    = 6;       // EWMA over 64 chunks
+static constexpr uint16_t SNAPCAST_MIN_BUFFER_MS  = 200;
+static constexpr uint16_t SNAPCAST_MAX_BUFFER_MS  = 5000;
+
+struct SnapcastClientStats {
+    bool     connected;
+    bool     streaming;             // Hello answered
+    char     name[32];              // HostName from Hello, else the address
+    char     ip[16];
+    uint32_t chunks;
+    uint32_t skipped;               // Chunks that did not fit the outbox
+    uint32_t time_syncs;            // Time requests answered
+    uint32_t outbox_max;            // Bytes queued, peak
+};
+
+struct SnapcastStats {
+    bool          running;
+    SnapcastCodec codec;
+    uint16_t      buffer_ms;
+    uint8_t       clients;
+    uint32_t      chunks;           // Chunks read from the pipe
+    uint32_t      stale_chunks;     // Skipped as too old to play
+    uint32_t      dropped_clients;  // Disconnected after SNAPCAST_STALL_MS
+    float         chunk_age_ms_avg; // Capture → queued, first frame of a chunk
+    float         chunk_age_ms_max;
+    float         clock_jitter_us;  // Capture clock around the smoothed one, average
+    SnapcastClientStats client[SNAPCAST_MAX_CLIENTS];
+};
+
+class SnapcastServer {
+public:
+    // Create the (idle) server task. Requires StreamEncoder::init().
+    static bool init(uint32_t capture_rate);
+
+    // Start, restart or stop the server. `buffer_ms` is clamped to
+    // SNAPCAST_MIN_BUFFER_MS–SNAPCAST_MAX_BUFFER_MS. Restarting disconnects the
+    // clients; snapclient reconnects by itself.
+    static void configure(bool enabled, SnapcastCodec codec, uint16_t buffer_ms);
+
+    // True if `codec` can be served at the capture rate
+    static bool supports(SnapcastCodec codec);
+
+    static bool is_running();
+
+    static void get_stats(SnapcastStats *stats);
+};
+
+#endif // SNAPCAST_SERVER_H
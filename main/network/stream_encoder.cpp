@@ -0,0 +1,854 @@
+#include "stream_encoder.h"
+#include "stream_handler.h"
+#include "../audio/audio_buffer.h"
+#include "../audio/resampler.h"
+#include "../audio/dither.h"
+#include "flac_encoder.h"
+#include "adpcm_encoder.h"
+#include "mp3_encoder.h"
+#include "ogg_opus_encoder.h"
+#include "../audio/dsp_platform.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "stream_encoder";
+
+static_assert(STREAM_ENCODER_MAX_PIPES <= AUDIO_BUFFER_ENCODER_READERS, "one AudioBuffer reader per pipe");
+static_assert(STREAM_ENCODER_CHUNK_FRAMES <= RESAMPLER_MAX_FRAMES, "chunk larger than a resampler block");
+
+static constexpr size_t IN_FRAME_BYTES = 6;        // 24-bit packed stereo
+static constexpr size_t MAX_OUT_FRAMES = STREAM_ENCODER_CHUNK_FRAMES + 1;  // All ratios ≤ 1
+// Frame starts kept per FLAC/MP3/Opus pipe: more than a prebuffer's worth of
+// frames
+static constexpr uint32_t SYNC_POINTS = 256;
+
+struct Pipe {
+    bool          used;
+    StreamFormat  format;
+    uint8_t       reader;               // AudioBuffer reader slot
+    uint8_t       subscribers;
+    bool          resampling;
+    Resampler     resampler;
+    Ditherer      dither;
+
+    // Block codecs (FLAC, ADPCM, MP3, Opus): buffers in PSRAM, allocated with
+    // the ring
+    FlacEncoder   flac;
+    AdpcmEncoder  adpcm;
+    Mp3Encoder    mp3;
+    OggOpusEncoder opus;
+    uint32_t      block_frames;         // Frames per encoded block, 0 = PCM
+    uint32_t      block_fill;           // Frames collected in block_pcm
+    int16_t      *block_pcm;            // block_frames interleaved frames
+    uint8_t      *block_out;            // One encoded block (MP3: the encoder's own)
+    uint32_t     *sync;                 // Frame start write_idx (FLAC, MP3, Opus), SYNC_POINTS
+    uint64_t     *sync_frame;           // Output frame at each frame start
+    uint32_t      prebuffer_frames;     // Frames in STREAM_ENCODER_PREBUFFER_MS
+    std::atomic<uint32_t> sync_count;   // Frames written (sync[] head)
+    uint32_t      encode_cycles_avg;    // Per encoded block
+    uint64_t      pcm_bytes;            // As 16-bit stereo, for the compression ratio
+    uint64_t      out_bytes;
+
+    uint8_t      *ring;
+    uint32_t      ring_mask;            // Ring bytes − 1 (power of two)
+    uint32_t      frame_bytes;
+    uint32_t      prebuffer_bytes;
+    uint32_t      max_write;            // Largest single append
+    std::atomic<uint32_t> write_idx;
+    bool          wrapped;              // write_idx has passed 2^32
+
+    // Capture timeline. ring_frames is the output frame at write_idx; both
+    // change under ring_seq (seqlock, odd while ring_append() runs).
+    uint64_t      capture_base;         // Capture frame of the first input frame
+    std::atomic<uint32_t> ring_seq;
+    std::atomic<uint64_t> ring_frames;
+
+    uint32_t      blocks;
+    std::atomic<uint32_t> laps;
+    uint32_t      cycles_avg;
+    uint32_t      cycles_max;
+    uint32_t      frames_avg;
+};
+
+static Pipe              s_pipes[STREAM_ENCODER_MAX_PIPES];
+static std::atomic<int>  s_active_pipes{0};
+static uint32_t          s_capture_rate = 48000;
+static std::atomic<uint8_t> s_dither{(uint8_t)DitherMode::TPDF};
+static std::atomic<uint16_t> s_mp3_kbps{DeviceConfig::DEFAULT_MP3_BITRATE_KBPS};
+static std::atomic<uint16_t> s_opus_kbps{DeviceConfig::DEFAULT_OPUS_BITRATE_KBPS};
+static std::atomic<uint8_t>  s_opus_frame_ms{DeviceConfig::DEFAULT_OPUS_FRAME_MS};
+// Conversion buffers, one set per worker
+struct Scratch {
+    uint8_t in24[STREAM_ENCODER_CHUNK_FRAMES * IN_FRAME_BYTES];
+    float   in_f[STREAM_ENCODER_CHUNK_FRAMES * 2];
+    float   out_f[MAX_OUT_FRAMES * 2];
+    alignas(4) uint8_t out[MAX_OUT_FRAMES * 8];     // Up to float stereo
+};
+
+// A task and the pipes it converts: "stream_enc" takes every codec but Opus,
+// "opus_enc" only Opus. Each pass holds the worker's mutex; the pipe list
+// changes under both.
+struct Worker {
+    SemaphoreHandle_t mutex;
+    TaskHandle_t      task;
+    std::atomic<int>  pipes;            // Open pipes it converts; it blocks at 0
+    Scratch           scratch;
+};
+
+static Worker s_stream_worker;
+static Worker s_opus_worker;
+
+static Worker &worker_for(StreamCodec codec) {
+    return codec == StreamCodec::OPUS ? s_opus_worker : s_stream_worker;
+}
+
+static void lock_pipe_list() {
+    xSemaphoreTake(s_stream_worker.mutex, portMAX_DELAY);
+    xSemaphoreTake(s_opus_worker.mutex, portMAX_DELAY);
+}
+
+static void unlock_pipe_list() {
+    xSemaphoreGive(s_opus_worker.mutex);
+    xSemaphoreGive(s_stream_worker.mutex);
+}
+
+// ─── Sample conversion ───────────────────────────────────────────────────────
+
+static void unpack_24(const uint8_t *pcm24, float *lrlr, size_t frames) {
+    for (size_t i = 0; i < frames * 2; i++) {
+        const uint8_t *src = pcm24 + i * 3;
+        int32_t v = (int32_t)src[0] | ((int32_t)src[1] << 8) | ((int32_t)src[2] << 16);
+        if (v & 0x800000) v |= 0xFF000000;
+        lrlr[i] = (float)v / 8388608.0f;
+    }
+}
+
+// Float stereo frames (resampled or not) to the pipe's sample format in
+// `dst`, downmixed to (L+R)/2 for mono pipes. Returns output bytes.
+static size_t emit_float(Pipe &p, float *lrlr, size_t frames, uint8_t *dst) {
+    const bool mono = p.format.channels == 1;
+    if (mono) {
+        for (size_t i = 0; i < frames; i++) {
+            float m = 0.5f * (lrlr[i * 2] + lrlr[i * 2 + 1]);
+            lrlr[i * 2]     = m;
+            lrlr[i * 2 + 1] = m;
+        }
+    }
+    const size_t step = mono ? 2 : 1;       // Input samples per output sample
+    const size_t n    = frames * p.format.channels;
+
+    switch (p.format.codec) {
+        case StreamCodec::PCM_F32: {
+            float *out = (float *)dst;
+            for (size_t i = 0; i < n; i++) out[i] = lrlr[i * step];
+            return n * 4;
+        }
+        case StreamCodec::PCM_S24: {
+            uint8_t *out = dst;
+            for (size_t i = 0; i < n; i++) {
+                float v = lrlr[i * step] * 8388608.0f;
+                int32_t s = v >= 8388607.0f ? 8388607 : (v <= -8388608.0f ? -8388608 : (int32_t)lrintf(v));
+                *out++ = (uint8_t)s;
+                *out++ = (uint8_t)(s >> 8);
+                *out++ = (uint8_t)(s >> 16);
+            }
+            return n * 3;
+        }
+        default: {
+            // 16-bit (and the compressed codecs' input): dithered per channel,
+            // then the left channel kept for mono
+            p.dither.process_f32(lrlr, dst, frames);
+            if (mono) {
+                int16_t *out = (int16_t *)dst;
+                for (size_t i = 0; i < frames; i++) out[i] = out[i * 2];
+            }
+            return n * 2;
+        }
+    }
+}
+
+// ─── Pipes ───────────────────────────────────────────────────────────────────
+
+static int find_pipe(const StreamFormat &format) {
+    for (int i = 0; i < STREAM_ENCODER_MAX_PIPES; i++) {
+        const Pipe &p = s_pipes[i];
+        if (p.used && p.format.codec == format.codec && p.format.sample_rate == format.sample_rate &&
+            p.format.channels == format.channels) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Largest encoded block, or 0 for PCM
+static size_t max_block_bytes(StreamCodec codec) {
+    switch (codec) {
+        case StreamCodec::FLAC:      return FLAC_MAX_FRAME_BYTES;
+        case StreamCodec::IMA_ADPCM: return ADPCM_BLOCK_BYTES;
+        case StreamCodec::MP3:       return MP3_MAX_FRAME_BYTES;
+        case StreamCodec::OPUS:      return OGG_OPUS_MAX_PAGE_BYTES;
+        default:                     return 0;
+    }
+}
+
+static void free_block_codec(Pipe &p) {
+    if (p.format.codec == StreamCodec::FLAC) p.flac.deinit();
+    if (p.format.codec == StreamCodec::MP3) p.mp3.deinit();
+    if (p.format.codec == StreamCodec::OPUS) p.opus.deinit();
+    if (p.block_pcm != nullptr) heap_caps_free(p.block_pcm);
+    p.block_pcm    = nullptr;
+    p.block_out    = nullptr;
+    p.sync         = nullptr;
+    p.sync_frame   = nullptr;
+    p.block_frames = 0;
+}
+
+// Encoder, block buffer, output buffer and (FLAC, MP3, Opus) sync points
+static bool alloc_block_codec(Pipe &p) {
+    const StreamCodec codec = p.format.codec;
+    const bool sync = codec != StreamCodec::IMA_ADPCM;
+    const uint8_t opus_ms = s_opus_frame_ms.load(std::memory_order_relaxed);
+    switch (codec) {
+        case StreamCodec::FLAC:      p.block_frames = FLAC_BLOCK_FRAMES; break;
+        case StreamCodec::IMA_ADPCM: p.block_frames = ADPCM_BLOCK_FRAMES; break;
+        case StreamCodec::MP3:       p.block_frames = MP3_FRAME_FRAMES; break;
+        default:                     p.block_frames = p.format.sample_rate * opus_ms / 1000; break;
+    }
+    p.block_fill        = 0;
+    p.encode_cycles_avg = 0;
+
+    const size_t pcm_bytes  = (p.block_frames * 2 * sizeof(int16_t) + 7) & ~(size_t)7;
+    const size_t out_bytes  = codec == StreamCodec::MP3 ? 0 : (max_block_bytes(codec) + 7) & ~(size_t)7;
+    const size_t sync_bytes = sync ? SYNC_POINTS * (sizeof(uint64_t) + sizeof(uint32_t)) : 0;
+    uint8_t *mem = (uint8_t *)heap_caps_malloc(pcm_bytes + out_bytes + sync_bytes, MALLOC_CAP_SPIRAM);
+    if (mem == nullptr) {
+        ESP_LOGE(TAG, "No memory for %s block buffers", stream_codec_to_str(p.format.codec));
+        p.block_frames = 0;
+        return false;
+    }
+    p.block_pcm = (int16_t *)mem;
+    p.block_out = out_bytes > 0 ? mem + pcm_bytes : nullptr;
+    p.sync_frame = sync ? (uint64_t *)(mem + pcm_bytes + out_bytes) : nullptr;
+    p.sync       = sync ? (uint32_t *)(mem + pcm_bytes + out_bytes + SYNC_POINTS * sizeof(uint64_t)) : nullptr;
+
+    if (codec == StreamCodec::IMA_ADPCM) {
+        p.adpcm.init();
+        return true;
+    }
+
+    bool ok;
+    if (codec == StreamCodec::FLAC) {
+        p.flac = {};
+        ok = p.flac.init(p.format.sample_rate);
+    } else if (codec == StreamCodec::MP3) {
+        p.mp3 = {};
+        ok = p.mp3.init(p.format.sample_rate, s_mp3_kbps.load(std::memory_order_relaxed));
+    } else {
+        // A fresh Ogg serial per pipe, so players see a new stream
+        p.opus = {};
+        ok = p.opus.init(p.format.sample_rate, opus_ms, s_opus_kbps.load(std::memory_order_relaxed),
+                         (uint32_t)esp_timer_get_time() * 2654435761u);
+    }
+    if (!ok) {
+        free_block_codec(p);
+        return false;
+    }
+    p.sync_count.store(0, std::memory_order_relaxed);
+    // Ceiling, so a joining listener never starts short of the prebuffer
+    p.prebuffer_frames = (p.format.sample_rate * STREAM_ENCODER_PREBUFFER_MS / 1000 +
+                          p.block_frames - 1) / p.block_frames;
+    return true;
+}
+
+static void close_pipe(int idx) {
+    Pipe &p = s_pipes[idx];
+    AudioBuffer::unregister_client(p.reader);
+    if (p.resampling) p.resampler.deinit();
+    if (p.block_frames > 0) free_block_codec(p);
+    if (p.ring != nullptr) heap_caps_free(p.ring);
+    p.ring = nullptr;
+    p.used = false;
+    s_active_pipes.fetch_sub(1, std::memory_order_acq_rel);
+    worker_for(p.format.codec).pipes.fetch_sub(1, std::memory_order_acq_rel);
+    ESP_LOGI(TAG, "Pipe %d closed (%s %lu Hz, %lu blocks)", idx, stream_codec_to_str(p.format.codec),
+             (unsigned long)p.format.sample_rate, (unsigned long)p.blocks);
+}
+
+static int open_pipe(const StreamFormat &format) {
+    int idx = -1;
+    for (int i = 0; i < STREAM_ENCODER_MAX_PIPES; i++) {
+        if (!s_pipes[i].used) { idx = i; break; }
+    }
+    if (idx < 0) {
+        ESP_LOGW(TAG, "All %u encoder pipes in use", (unsigned)STREAM_ENCODER_MAX_PIPES);
+        return -1;
+    }
+
+    Pipe &p = s_pipes[idx];
+    p.format      = format;
+    p.frame_bytes = StreamEncoder::frame_bytes(format);
+    p.resampling  = format.sample_rate != s_capture_rate;
+    if (p.resampling && !p.resampler.init(s_capture_rate, format.sample_rate)) return -1;
+
+    // Ring sized from the output byte rate; FLAC rings as for 16-bit PCM,
+    // since a frame is never much larger, MP3 and Opus for the highest bitrate
+    const bool     block      = max_block_bytes(format.codec) > 0;
+    uint32_t       byte_rate  = format.sample_rate * p.frame_bytes;
+    switch (format.codec) {
+        case StreamCodec::FLAC:
+            byte_rate = format.sample_rate * 4;
+            break;
+        case StreamCodec::IMA_ADPCM:
+            byte_rate = (uint32_t)((uint64_t)format.sample_rate * ADPCM_BLOCK_BYTES / ADPCM_BLOCK_FRAMES) + 1;
+            break;
+        case StreamCodec::MP3:
+            byte_rate = MP3_MAX_BITRATE_KBPS * 1000 / 8;
+            break;
+        case StreamCodec::OPUS:
+            // VBR peaks and one page header per packet
+            byte_rate = OPUS_MAX_BITRATE_KBPS * 1000 / 8 * 2;
+            break;
+        default:
+            break;
+    }
+    uint32_t ring_bytes = 1;
+    while (ring_bytes < byte_rate / 1000 * STREAM_ENCODER_RING_MS) ring_bytes <<= 1;
+    p.ring = (uint8_t *)heap_caps_malloc(ring_bytes, MALLOC_CAP_SPIRAM);
+    if (p.ring == nullptr) {
+        ESP_LOGE(TAG, "No memory for %lu byte encoder ring", (unsigned long)ring_bytes);
+        if (p.resampling) p.resampler.deinit();
+        return -1;
+    }
+    p.block_frames = 0;
+    p.block_pcm    = nullptr;
+    p.sync         = nullptr;
+    p.sync_frame   = nullptr;
+    if (block && !alloc_block_codec(p)) {
+        heap_caps_free(p.ring);
+        p.ring = nullptr;
+        if (p.resampling) p.resampler.deinit();
+        return -1;
+    }
+
+    p.reader = (uint8_t)(ClientConnection::MAX_CLIENTS + idx);
+    if (!AudioBuffer::register_client(p.reader)) {
+        if (block) free_block_codec(p);
+        heap_caps_free(p.ring);
+        p.ring = nullptr;
+        if (p.resampling) p.resampler.deinit();
+        return -1;
+    }
+
+    p.capture_base = AudioBuffer::reader_frame(p.reader);
+    p.ring_seq.store(0, std::memory_order_relaxed);
+    p.ring_frames.store(0, std::memory_order_relaxed);
+
+    size_t max_frames = p.resampling ? p.resampler.max_output(STREAM_ENCODER_CHUNK_FRAMES)
+                                     : STREAM_ENCODER_CHUNK_FRAMES;
+    p.ring_mask       = ring_bytes - 1;
+    p.prebuffer_bytes = format.sample_rate * STREAM_ENCODER_PREBUFFER_MS / 1000 * p.frame_bytes;
+    p.max_write       = (uint32_t)max_frames * p.frame_bytes;
+    if (format.codec == StreamCodec::IMA_ADPCM) {
+        // Whole blocks, rounded up
+        p.prebuffer_bytes = (format.sample_rate * STREAM_ENCODER_PREBUFFER_MS / 1000 +
+                             ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES * ADPCM_BLOCK_BYTES;
+    }
+    if (block) p.max_write = (uint32_t)max_block_bytes(format.codec);
+    p.pcm_bytes       = 0;
+    p.out_bytes       = 0;
+    p.write_idx.store(0, std::memory_order_release);
+    p.wrapped     = false;
+    p.subscribers = 0;
+    p.blocks      = 0;
+    p.laps.store(0, std::memory_order_relaxed);
+    p.cycles_avg  = 0;
+    p.cycles_max  = 0;
+    p.frames_avg  = 0;
+    p.dither.init((DitherMode)s_dither.load(std::memory_order_relaxed), 0x9E3779B9u * (uint32_t)(idx + 1));
+    p.used        = true;
+    s_active_pipes.fetch_add(1, std::memory_order_acq_rel);
+    worker_for(format.codec).pipes.fetch_add(1, std::memory_order_acq_rel);
+
+    ESP_LOGI(TAG, "Pipe %d opened: %s %lu Hz %s%s, %lu byte ring", idx, stream_codec_to_str(format.codec),
+             (unsigned long)format.sample_rate, format.channels == 1 ? "mono" : "stereo",
+             p.resampling ? " (resampled)" : "",
+             (unsigned long)ring_bytes);
+    return idx;
+}
+
+// Append `len` bytes holding `frames` output frames
+static void ring_append(Pipe &p, const uint8_t *data, size_t len, uint32_t frames) {
+    uint32_t w     = p.write_idx.load(std::memory_order_relaxed);
+    uint32_t pos   = w & p.ring_mask;
+    size_t   first = p.ring_mask + 1 - pos;
+    if (first > len) first = len;
+
+    memcpy(p.ring + pos, data, first);
+    if (len > first) memcpy(p.ring, data + first, len - first);
+    if (w + (uint32_t)len < w) p.wrapped = true;
+
+    uint32_t seq = p.ring_seq.load(std::memory_order_relaxed);
+    p.ring_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    p.ring_frames.store(p.ring_frames.load(std::memory_order_relaxed) + frames, std::memory_order_relaxed);
+    p.write_idx.store(w + (uint32_t)len, std::memory_order_release);
+    p.ring_seq.store(seq + 2, std::memory_order_release);
+    p.out_bytes += len;
+}
+
+// Output frames per read unit: one sample frame, or one ADPCM block
+static uint32_t unit_frames(const Pipe &p) {
+    return p.format.codec == StreamCodec::IMA_ADPCM ? ADPCM_BLOCK_FRAMES : 1;
+}
+
+// Output frame at ring index `idx` of a PCM or ADPCM pipe
+static uint64_t frame_at(const Pipe &p, uint32_t idx) {
+    uint32_t seq;
+    uint32_t w;
+    uint64_t frames;
+    do {
+        seq    = p.ring_seq.load(std::memory_order_acquire);
+        w      = p.write_idx.load(std::memory_order_relaxed);
+        frames = p.ring_frames.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != p.ring_seq.load(std::memory_order_relaxed));
+    return frames - (uint64_t)((w - idx) / p.frame_bytes) * unit_frames(p);
+}
+
+// Capture frame of an output frame
+static uint64_t capture_frame_of(const Pipe &p, uint64_t frame) {
+    if (!p.resampling) return p.capture_base + frame;
+    return p.capture_base + frame * s_capture_rate / p.format.sample_rate;
+}
+
+// Where a subscriber starts (join, or resync after being lapped): about
+// STREAM_ENCODER_PREBUFFER_MS behind `w`, at a frame boundary
+static uint32_t start_point(const Pipe &p, uint32_t w) {
+    if (p.sync == nullptr) {
+        uint32_t back = p.prebuffer_bytes;
+        if (!p.wrapped && w < back) back = w;
+        return w - back;
+    }
+
+    // FLAC, MP3, Opus: the first recorded frame start within the prebuffer that
+    // the writer cannot overwrite before the subscriber reads it
+    const uint32_t frames = p.sync_count.load(std::memory_order_acquire);
+    const uint32_t limit  = p.ring_mask + 1 - p.max_write;
+    uint32_t first = frames > p.prebuffer_frames ? frames - p.prebuffer_frames : 0;
+    for (; first < frames; first++) {
+        uint32_t start = p.sync[first % SYNC_POINTS];
+        if (w - start <= limit) return start;
+    }
+    return w;   // No frame yet: the next one starts at w
+}
+
+// Collect 16-bit frames into codec blocks; append each finished block
+static void block_append(Pipe &p, const int16_t *lrlr, size_t frames) {
+    while (frames > 0) {
+        size_t n = p.block_frames - p.block_fill;
+        if (n > frames) n = frames;
+        memcpy(p.block_pcm + p.block_fill * 2, lrlr, n * 4);
+        p.block_fill += (uint32_t)n;
+        lrlr         += n * 2;
+        frames       -= n;
+        if (p.block_fill < p.block_frames) break;
+        p.block_fill = 0;
+
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        const uint8_t *out = p.block_out;
+        size_t len;
+        switch (p.format.codec) {
+            case StreamCodec::FLAC:      len = p.flac.encode(p.block_pcm, p.block_out); break;
+            case StreamCodec::IMA_ADPCM: len = p.adpcm.encode(p.block_pcm, p.block_out); break;
+            case StreamCodec::OPUS:      len = p.opus.encode(p.block_pcm, p.block_out); break;
+            default:                     len = p.mp3.encode(p.block_pcm, &out); break;
+        }
+        uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+        p.encode_cycles_avg = p.encode_cycles_avg == 0
+                                  ? cycles
+                                  : p.encode_cycles_avg - (p.encode_cycles_avg >> 3) + (cycles >> 3);
+        if (len == 0) {
+            // Dropped block: the ones after it keep their place in time
+            p.ring_frames.store(p.ring_frames.load(std::memory_order_relaxed) + p.block_frames,
+                                std::memory_order_relaxed);
+            continue;
+        }
+
+        if (p.sync != nullptr) {
+            uint32_t count = p.sync_count.load(std::memory_order_relaxed);
+            p.sync[count % SYNC_POINTS]       = p.write_idx.load(std::memory_order_relaxed);
+            p.sync_frame[count % SYNC_POINTS] = p.ring_frames.load(std::memory_order_relaxed);
+            p.sync_count.store(count + 1, std::memory_order_release);
+        }
+        ring_append(p, out, len, p.block_frames);
+    }
+}
+
+// Convert the next capture block for one pipe. False if none was waiting.
+static bool convert_block(Pipe &p, Scratch &s) {
+    size_t got = 0;
+    if (!AudioBuffer::read(p.reader, s.in24, sizeof(s.in24), &got) || got == 0) return false;
+    size_t frames = got / IN_FRAME_BYTES;
+
+    DitherMode mode = (DitherMode)s_dither.load(std::memory_order_relaxed);
+    if (mode != p.dither.mode) {
+        p.dither.mode = mode;
+        p.dither.reset();
+    }
+
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    size_t out_bytes;
+    if (p.resampling || p.format.channels == 1 || p.format.codec == StreamCodec::PCM_S24 ||
+        p.format.codec == StreamCodec::PCM_F32) {
+        unpack_24(s.in24, s.in_f, frames);
+        if (p.resampling) {
+            size_t n = p.resampler.process(s.in_f, frames, s.out_f);
+            out_bytes = emit_float(p, s.out_f, n, s.out);
+        } else {
+            out_bytes = emit_float(p, s.in_f, frames, s.out);
+        }
+    } else if (mode == DitherMode::OFF) {
+        out_bytes = StreamHandler::downsample_24to16(s.in24, s.out, got);
+    } else {
+        p.dither.process_s24(s.in24, s.out, frames);
+        out_bytes = frames * 4;
+    }
+    const size_t out_frames = stream_codec_is_pcm(p.format.codec) ? out_bytes / p.frame_bytes : out_bytes / 4;
+    p.pcm_bytes += out_frames * 4;
+    if (p.block_frames > 0) {
+        block_append(p, (const int16_t *)s.out, out_bytes / 4);
+    } else {
+        ring_append(p, s.out, out_bytes, (uint32_t)out_frames);
+    }
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+
+    if (cycles > p.cycles_max) p.cycles_max = cycles;
+    p.cycles_avg = p.cycles_avg == 0 ? cycles : p.cycles_avg - (p.cycles_avg >> 4) + (cycles >> 4);
+    p.frames_avg = p.frames_avg == 0 ? (uint32_t)frames
+                                     : p.frames_avg - (p.frames_avg >> 4) + ((uint32_t)frames >> 4);
+    p.blocks++;
+    return true;
+}
+
+// One block per pipe of this worker. True if any pipe had work.
+static bool pump(Worker &w) {
+    bool busy = false;
+    xSemaphoreTake(w.mutex, portMAX_DELAY);
+    for (int i = 0; i < STREAM_ENCODER_MAX_PIPES; i++) {
+        Pipe &p = s_pipes[i];
+        if (p.used && &worker_for(p.format.codec) == &w && convert_block(p, w.scratch)) busy = true;
+    }
+    xSemaphoreGive(w.mutex);
+    return busy;
+}
+
+// A worker without a task converts on read, in the reading task
+static void pump_on_read(const Pipe &p) {
+    Worker &w = worker_for(p.format.codec);
+    if (w.task == nullptr) {
+        while (pump(w)) {}
+    }
+}
+
+static void encoder_task(void *params) {
+    Worker &w = *(Worker *)params;
+    for (;;) {
+        if (w.pipes.load(std::memory_order_acquire) == 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        if (!pump(w)) vTaskDelay(pdMS_TO_TICKS(2));
+    }
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool StreamEncoder::init(uint32_t capture_rate) {
+    s_capture_rate = capture_rate;
+
+    if (s_stream_worker.mutex == nullptr) s_stream_worker.mutex = xSemaphoreCreateMutex();
+    if (s_opus_worker.mutex == nullptr) s_opus_worker.mutex = xSemaphoreCreateMutex();
+    if (s_stream_worker.mutex == nullptr || s_opus_worker.mutex == nullptr) {
+        ESP_LOGE(TAG, "Failed to create encoder mutex");
+        return false;
+    }
+
+    // Either task missing: its pipes fall back to converting in the stream
+    // tasks when they read
+    if (s_stream_worker.task == nullptr &&
+        xTaskCreatePinnedToCore(encoder_task, "stream_enc", 3072, &s_stream_worker,
+                                5,  // Below HTTP / stream senders (6), above the analyzers (3)
+                                &s_stream_worker.task,
+                                1   // Core 1
+                                ) != pdPASS) {
+        s_stream_worker.task = nullptr;
+        ESP_LOGW(TAG, "stream_enc task not created, converting on read");
+    }
+
+    // Opus is the one encoder with a real-time cycle budget: it gets the DSP
+    // core to itself, below audio_capture (24) and fir_tail (20), so capture
+    // always preempts it and it never competes with the HTTP senders
+    if (OggOpusEncoder::available() && s_opus_worker.task == nullptr &&
+        xTaskCreatePinnedToCore(encoder_task, "opus_enc", 3072 + OggOpusEncoder::task_stack_bytes(),
+                                &s_opus_worker, 5, &s_opus_worker.task,
+                                0   // Core 0 (DSP core)
+                                ) != pdPASS) {
+        s_opus_worker.task = nullptr;
+        ESP_LOGW(TAG, "opus_enc task not created, encoding on read");
+    }
+    return true;
+}
+
+bool StreamEncoder::supports(const StreamFormat &format) {
+    if (!stream_codec_is_pcm(format.codec) && format.codec != StreamCodec::FLAC &&
+        format.codec != StreamCodec::IMA_ADPCM && format.codec != StreamCodec::MP3 &&
+        format.codec != StreamCodec::OPUS) {
+        return false;
+    }
+    if (format.channels != 2 && !(format.channels == 1 && stream_codec_is_pcm(format.codec))) {
+        return false;
+    }
+    if (format.codec == StreamCodec::OPUS &&
+        (!OggOpusEncoder::available() || !OggOpusEncoder::supports_rate(format.sample_rate))) {
+        return false;
+    }
+    if (format.codec == StreamCodec::MP3 &&
+        (!Mp3Encoder::available() || !Mp3Encoder::supports_rate(format.sample_rate))) {
+        return false;
+    }
+    return format.sample_rate == s_capture_rate ||
+           Resampler::supported(s_capture_rate, format.sample_rate);
+}
+
+void StreamEncoder::set_dither(DitherMode mode) {
+    s_dither.store((uint8_t)mode, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "Stream dither: %s", dither_mode_to_str(mode));
+}
+
+DitherMode StreamEncoder::dither() {
+    return (DitherMode)s_dither.load(std::memory_order_relaxed);
+}
+
+void StreamEncoder::set_mp3_bitrate(uint16_t kbps) {
+    kbps = Mp3Encoder::nearest_bitrate(kbps);
+    s_mp3_kbps.store(kbps, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "MP3 bitrate: %u kbps", kbps);
+}
+
+uint16_t StreamEncoder::mp3_bitrate() {
+    return s_mp3_kbps.load(std::memory_order_relaxed);
+}
+
+void StreamEncoder::set_opus(uint16_t kbps, uint8_t frame_ms) {
+    kbps     = OggOpusEncoder::clamp_bitrate(kbps);
+    frame_ms = frame_ms == 10 ? 10 : 20;
+    s_opus_kbps.store(kbps, std::memory_order_relaxed);
+    s_opus_frame_ms.store(frame_ms, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "Opus: %u kbps, %u ms frames", kbps, frame_ms);
+}
+
+uint16_t StreamEncoder::opus_bitrate() {
+    return s_opus_kbps.load(std::memory_order_relaxed);
+}
+
+uint8_t StreamEncoder::opus_frame_ms() {
+    return s_opus_frame_ms.load(std::memory_order_relaxed);
+}
+
+uint32_t StreamEncoder::frame_bytes(const StreamFormat &format) {
+    switch (format.codec) {
+        case StreamCodec::PCM_S16:   return 2u * format.channels;
+        case StreamCodec::PCM_S24:   return 3u * format.channels;
+        case StreamCodec::PCM_F32:   return 4u * format.channels;
+        case StreamCodec::FLAC:      return 1;
+        case StreamCodec::IMA_ADPCM: return ADPCM_BLOCK_BYTES;     // Whole blocks only
+        case StreamCodec::MP3:       return 1;
+        case StreamCodec::OPUS:      return 1;
+        default:                     return 4;
+    }
+}
+
+bool StreamEncoder::subscribe(const StreamFormat &format, StreamSubscription *sub) {
+    if (sub == nullptr) return false;
+    sub->pipe     = -1;
+    sub->read_idx = 0;
+    sub->laps     = 0;
+    sub->frame    = 0;
+    if (s_stream_worker.mutex == nullptr || !supports(format)) return false;
+
+    lock_pipe_list();
+    int idx = find_pipe(format);
+    if (idx < 0) idx = open_pipe(format);
+    if (idx >= 0) {
+        Pipe &p = s_pipes[idx];
+        sub->pipe     = (int8_t)idx;
+        sub->read_idx = start_point(p, p.write_idx.load(std::memory_order_acquire));
+        if (p.sync == nullptr) sub->frame = frame_at(p, sub->read_idx);
+        p.subscribers++;
+    }
+    unlock_pipe_list();
+
+    TaskHandle_t task = worker_for(format.codec).task;
+    if (idx >= 0 && task != nullptr) xTaskNotifyGive(task);
+    return idx >= 0;
+}
+
+void StreamEncoder::unsubscribe(StreamSubscription *sub) {
+    if (sub == nullptr || sub->pipe < 0 || s_stream_worker.mutex == nullptr) return;
+
+    lock_pipe_list();
+    Pipe &p = s_pipes[sub->pipe];
+    if (p.used && p.subscribers > 0 && --p.subscribers == 0) close_pipe(sub->pipe);
+    unlock_pipe_list();
+    sub->pipe = -1;
+}
+
+size_t StreamEncoder::read(StreamSubscription *sub, uint8_t *data, size_t size) {
+    if (sub == nullptr || data == nullptr || sub->pipe < 0) return 0;
+    Pipe &p = s_pipes[sub->pipe];
+    pump_on_read(p);
+
+    const uint32_t ring_bytes = p.ring_mask + 1;
+    const uint32_t limit      = ring_bytes - p.max_write;   // Farthest safe distance behind
+
+    uint32_t w = p.write_idx.load(std::memory_order_acquire);
+    if (w - sub->read_idx > limit) {
+        sub->read_idx = start_point(p, w);
+        if (p.sync == nullptr) sub->frame = frame_at(p, sub->read_idx);
+        sub->laps++;
+        p.laps.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t n = size - size % p.frame_bytes;
+    if (n > w - sub->read_idx) n = w - sub->read_idx;
+    if (n == 0) return 0;
+
+    uint32_t pos   = sub->read_idx & p.ring_mask;
+    size_t   first = ring_bytes - pos;
+    if (first > n) first = n;
+    memcpy(data, p.ring + pos, first);
+    if (n > first) memcpy(data + first, p.ring, n - first);
+
+    // Lapped during the copy: drop it and resync on the next read
+    w = p.write_idx.load(std::memory_order_acquire);
+    if (w - sub->read_idx > limit) return 0;
+
+    sub->read_idx += (uint32_t)n;
+    if (p.sync == nullptr) sub->frame += (uint64_t)(n / p.frame_bytes) * unit_frames(p);
+    return n;
+}
+
+size_t StreamEncoder::read_frames(StreamSubscription *sub, uint8_t *data, size_t size, uint64_t *capture_frame) {
+    if (sub == nullptr || data == nullptr || sub->pipe < 0) return 0;
+    Pipe &p = s_pipes[sub->pipe];
+
+    if (p.sync == nullptr) {
+        size_t n = read(sub, data, size);
+        if (n > 0 && capture_frame != nullptr) {
+            *capture_frame = capture_frame_of(p, sub->frame - (uint64_t)(n / p.frame_bytes) * unit_frames(p));
+        }
+        return n;
+    }
+
+    pump_on_read(p);
+    const uint32_t ring_bytes = p.ring_mask + 1;
+    const uint32_t limit      = ring_bytes - p.max_write;
+
+    // The frame starting at read_idx: normally the newest or close to it
+    uint32_t w     = p.write_idx.load(std::memory_order_acquire);
+    uint32_t count = p.sync_count.load(std::memory_order_acquire);
+    uint32_t n     = count;
+    if (w - sub->read_idx <= limit) {
+        const uint32_t oldest = count > SYNC_POINTS ? count - SYNC_POINTS : 0;
+        for (uint32_t i = count; i > oldest; i--) {
+            if (p.sync[(i - 1) % SYNC_POINTS] == sub->read_idx) { n = i - 1; break; }
+        }
+    }
+    if (n == count) {
+        // Lapped, or too far behind for the frame starts: resync
+        if (w == sub->read_idx) return 0;
+        sub->read_idx = start_point(p, w);
+        sub->laps++;
+        p.laps.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    const uint32_t end = n + 1 < count ? p.sync[(n + 1) % SYNC_POINTS] : w;
+    const uint32_t len = end - sub->read_idx;
+    if (len == 0) return 0;
+    if (len > size) {
+        sub->read_idx = end;    // Cannot be returned whole: skip it
+        return 0;
+    }
+    const uint64_t frame = p.sync_frame[n % SYNC_POINTS];
+
+    uint32_t pos   = sub->read_idx & p.ring_mask;
+    size_t   first = ring_bytes - pos;
+    if (first > len) first = len;
+    memcpy(data, p.ring + pos, first);
+    if (len > first) memcpy(data + first, p.ring, len - first);
+
+    // Lapped during the copy, or the frame start recycled: resync next time
+    w     = p.write_idx.load(std::memory_order_acquire);
+    count = p.sync_count.load(std::memory_order_acquire);
+    if (w - sub->read_idx > limit || count - n >= SYNC_POINTS) return 0;
+
+    sub->read_idx = end;
+    if (capture_frame != nullptr) *capture_frame = capture_frame_of(p, frame);
+    return len;
+}
+
+size_t StreamEncoder::stream_header(const StreamSubscription *sub, uint8_t *out, size_t size) {
+    if (sub == nullptr || out == nullptr || sub->pipe < 0) return 0;
+    const Pipe &p = s_pipes[sub->pipe];
+    if (p.format.codec != StreamCodec::OPUS || p.opus.header_len > size) return 0;
+    memcpy(out, p.opus.header, p.opus.header_len);
+    return p.opus.header_len;
+}
+
+uint32_t StreamEncoder::pending(const StreamSubscription *sub) {
+    if (sub == nullptr || sub->pipe < 0) return 0;
+    const Pipe &p = s_pipes[sub->pipe];
+    return p.write_idx.load(std::memory_order_acquire) - sub->read_idx;
+}
+
+void StreamEncoder::get_stats(StreamEncoderStats *stats) {
+    if (stats == nullptr) return;
+    memset(stats, 0, sizeof(*stats));
+    stats->capture_rate = s_capture_rate;
+    stats->dither       = dither();
+    stats->active_pipes = (uint8_t)s_active_pipes.load(std::memory_order_acquire);
+
+    const float core_hz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e6f;
+    for (int i = 0; i < STREAM_ENCODER_MAX_PIPES; i++) {
+        const Pipe &p = s_pipes[i];
+        StreamPipeStats &out = stats->pipe[i];
+        if (!p.used) continue;
+        out.active               = true;
+        out.format               = p.format;
+        out.resampling           = p.resampling;
+        out.subscribers          = p.subscribers;
+        out.blocks               = p.blocks;
+        out.compression          = p.out_bytes > 0 ? (float)p.pcm_bytes / (float)p.out_bytes : 1.0f;
+        out.laps                 = p.laps.load(std::memory_order_relaxed);
+        out.core                 = p.format.codec == StreamCodec::OPUS ? 0 : 1;
+        out.cycles_per_block_avg = p.cycles_avg;
+        out.cycles_per_block_max = p.cycles_max;
+        if (p.frames_avg > 0) {
+            float per_second = (float)p.cycles_avg * (float)s_capture_rate / (float)p.frames_avg;
+            out.cycles_per_channel_second = (uint32_t)(per_second / 2.0f);
+            out.core_load_pct             = per_second / core_hz * 100.0f;
+        }
+        if (p.format.codec == StreamCodec::MP3) out.bitrate_kbps = p.mp3.bitrate_kbps;
+        if (p.format.codec == StreamCodec::OPUS) {
+            out.bitrate_kbps    = p.opus.bitrate_kbps;
+            out.complexity      = p.opus.complexity;
+            out.budget_overruns = p.opus.overruns;
+        }
+        // Encoder-side latency: a block fills before it is encoded
+        const float block_ms = (float)p.block_frames * 1000.0f / (float)p.format.sample_rate;
+        const uint32_t work  = p.block_frames > 0 ? p.encode_cycles_avg : p.cycles_avg;
+        out.latency_ms       = block_ms + (float)work / core_hz * 1000.0f;
+    }
+}
@@ -0,0 +1,198 @@
+#ifndef STREAM_ENCODER_H
+#define STREAM_ENCODER_H
+
+#include <cstdint>
+#include <cstddef>
+#include "../config_schema.h"
+
+// StreamEncoder: shared conversion stage between the capture ring and the
+// HTTP stream clients.
+//
+// Clients asking for the same output format share one pipe. A pipe has its
+// own reader slot on AudioBuffer, converts each block once (resample, 24 →
+// 16-bit) and appends the result to a fan-out ring in PSRAM. Stream tasks
+// only copy bytes out of that ring, so conversion cost grows with the number
+// of distinct formats, not with the number of listeners.
+//
+// The "stream_enc" task (Core 1, priority 5: below HTTP and the stream
+// senders, above the analyzers) converts one block of at most
+// STREAM_ENCODER_CHUNK_FRAMES per pipe per pass until every pipe has caught
+// up, then sleeps 2 ms. Opus pipes are converted the same way by their own
+// "opus_enc" task (Core 0, the DSP core, priority 5: below audio_capture and
+// fir_tail), so only Opus competes with the DSP chain. With no pipes both
+// block and cost nothing. A pipe is created by its first subscriber and freed
+// by its last unsubscribe.
+//
+// Start-up matches the direct AudioBuffer clients: a new pipe's reader
+// starts 1.5 s behind capture, and a subscriber joining a running pipe starts
+// STREAM_ENCODER_PREBUFFER_MS behind its write position. Subscribers copy
+// from the ring lock-free, like AudioTap readers; a subscriber the writer has
+// lapped skips ahead to the prebuffer point and the lap is counted.
+//
+// Output rates other than the capture rate go through Resampler (polyphase,
+// compile-time tables); rates without a table are rejected.
+//
+// PCM pipes come as 16-bit, 24-bit or 32-bit float, stereo or mono (L+R)/2.
+// 24-bit, float and mono pipes take the float path (unpack, resample,
+// downmix, requantize); only the 16-bit result is dithered. Compressed codecs
+// are stereo. (Stereo 24-bit at the capture rate needs no pipe: the HTTP
+// handler streams it straight from AudioBuffer.)
+//
+// The 16-bit requantization is dithered once per pipe (see audio/dither.h),
+// with the mode from set_dither() shared by all pipes. DitherMode::OFF keeps
+// the plain truncation of StreamHandler::downsample_24to16() at the capture
+// rate.
+//
+// FLAC pipes collect the 16-bit output into FLAC_BLOCK_FRAMES blocks and
+// encode each once (network/flac_encoder.h), so the ring holds variable-size
+// frames. The pipe records where each frame starts; joins and lap resyncs go
+// to the frame start nearest STREAM_ENCODER_PREBUFFER_MS back, and the HTTP
+// handler sends the FLAC stream header before the first frame.
+//
+// IMA ADPCM pipes (network/adpcm_encoder.h) collect blocks the same way. The
+// blocks are fixed-size, so every multiple of ADPCM_BLOCK_BYTES in the ring is
+// a join point and reads return whole blocks.
+//
+// MP3 pipes (network/mp3_encoder.h, optional shine component) encode
+// MP3_FRAME_FRAMES blocks at the CBR bitrate from set_mp3_bitrate() and
+// reuse the FLAC frame-start bookkeeping; the bitrate is fixed when a pipe
+// opens. Block codecs report encoder latency: block fill plus encode time.
+//
+// Opus pipes (network/ogg_opus_encoder.h, optional libopus component) carry
+// one Ogg page per packet and use the same frame starts. Their header pages
+// carry a per-pipe stream serial, so the HTTP handler fetches them with
+// stream_header(). The encoder holds a cycle budget by lowering complexity;
+// its stack needs are added to the opus_enc task's.
+//
+// Pipes keep their output on the capture timeline: each knows the capture
+// frame (AudioBuffer::get_clock() count) of its first input frame, PCM and
+// ADPCM pipes count the output frames in the ring, and FLAC, MP3 and Opus
+// pipes record the output frame of every frame start. read_frames() uses that
+// to report which capture frame a read starts at (Snapcast wire chunks).
+
+static constexpr uint8_t  STREAM_ENCODER_MAX_PIPES      = 4;     // = AUDIO_BUFFER_ENCODER_READERS
+static constexpr uint32_t STREAM_ENCODER_CHUNK_FRAMES   = 240;   // One DMA block
+static constexpr uint32_t STREAM_ENCODER_RING_MS        = 2500;  // Rounded up to a power of two
+static constexpr uint32_t STREAM_ENCODER_PREBUFFER_MS   = 1500;
+
+enum class StreamCodec : uint8_t {
+    PCM_S16,                // 16-bit little-endian (WAV)
+    PCM_S24,                // 24-bit packed little-endian (WAV extensible)
+    PCM_F32,                // 32-bit IEEE float (WAV extensible)
+    FLAC,                   // Native FLAC frames, 16-bit stereo
+    IMA_ADPCM,              // IMA ADPCM WAV blocks, 4-bit stereo
+    MP3,                    // MPEG-1 Layer III CBR frames, stereo
+    OPUS,                   // Ogg Opus pages, stereo, low-delay mode
+};
+
+inline const char *stream_codec_to_str(StreamCodec codec) {
+    switch (codec) {
+        case StreamCodec::PCM_S16:   return "s16";
+        case StreamCodec::PCM_S24:   return "s24";
+        case StreamCodec::PCM_F32:   return "f32";
+        case StreamCodec::FLAC:      return "flac";
+        case StreamCodec::IMA_ADPCM: return "adpcm";
+        case StreamCodec::MP3:       return "mp3";
+        case StreamCodec::OPUS:      return "opus";
+        default:                     return "?";
+    }
+}
+
+// True for the uncompressed codecs (the only ones with a mono variant)
+inline bool stream_codec_is_pcm(StreamCodec codec) {
+    return codec == StreamCodec::PCM_S16 || codec == StreamCodec::PCM_S24 ||
+           codec == StreamCodec::PCM_F32;
+}
+
+struct StreamFormat {
+    StreamCodec codec;
+    uint32_t    sample_rate;
+    uint8_t     channels;   // 2, or 1 for PCM codecs
+};
+
+// One client's position in a pipe
+struct StreamSubscription {
+    int8_t   pipe;          // -1 = not subscribed
+    uint32_t read_idx;      // Absolute byte index into the pipe's ring
+    uint32_t laps;          // Times this subscriber fell a ring behind
+    uint64_t frame;         // Output frame at read_idx (PCM, ADPCM)
+};
+
+struct StreamPipeStats {
+    bool         active;
+    StreamFormat format;
+    bool         resampling;
+    uint8_t      subscribers;
+    uint32_t     blocks;                    // Blocks converted
+    float        compression;               // 16-bit stereo PCM bytes / output bytes
+    uint16_t     bitrate_kbps;              // MP3, Opus
+    uint8_t      complexity;                // Opus: current encoder complexity
+    uint32_t     budget_overruns;           // Opus: frames over the cycle budget
+    float        latency_ms;                // Block fill plus average encode time
+    uint32_t     laps;                      // Subscriber resyncs, all subscribers
+    uint32_t     cycles_per_block_avg;
+    uint32_t     cycles_per_block_max;
+    uint32_t     cycles_per_channel_second; // Input-rate normalized
+    uint8_t      core;                      // 0: opus_enc, 1: stream_enc
+    float        core_load_pct;             // Of that core at the configured clock
+};
+
+struct StreamEncoderStats {
+    uint32_t        capture_rate;
+    DitherMode      dither;
+    uint8_t         active_pipes;
+    StreamPipeStats pipe[STREAM_ENCODER_MAX_PIPES];
+};
+
+class StreamEncoder {
+public:
+    // Create the (idle) encoder tasks. Requires AudioBuffer::init().
+    static bool init(uint32_t capture_rate);
+
+    // True if `format` can be produced from the capture rate
+    static bool supports(const StreamFormat &format);
+
+    // Join (or create) the pipe for `format`. False if unsupported, all pipes
+    // are in use or memory is short.
+    static bool subscribe(const StreamFormat &format, StreamSubscription *sub);
+    static void unsubscribe(StreamSubscription *sub);
+
+    // Copy up to `size` bytes of the pipe's output (whole frames). Returns
+    // bytes copied; 0 = nothing new yet.
+    static size_t read(StreamSubscription *sub, uint8_t *data, size_t size);
+
+    // Like read(), and also reports the capture frame of the first output
+    // frame copied (resampled pipes: scaled by the rate ratio, filter delay
+    // not included). FLAC, MP3 and Opus pipes return exactly one encoded frame
+    // per call, so `size` must hold the codec's largest frame.
+    static size_t read_frames(StreamSubscription *sub, uint8_t *data, size_t size, uint64_t *capture_frame);
+
+    // Bytes written to the pipe that this subscriber has not read yet
+    static uint32_t pending(const StreamSubscription *sub);
+
+    // 24 → 16-bit requantization for all pipes; takes effect on the next block
+    static void       set_dither(DitherMode mode);
+    static DitherMode dither();
+
+    // CBR bitrate for MP3 pipes opened from now on (snapped to 32–320 kbps)
+    static void     set_mp3_bitrate(uint16_t kbps);
+    static uint16_t mp3_bitrate();
+
+    // Bitrate (clamped to 16–256 kbps) and frame length (10 or 20 ms) for
+    // Opus pipes opened from now on
+    static void     set_opus(uint16_t kbps, uint8_t frame_ms);
+    static uint16_t opus_bitrate();
+    static uint8_t  opus_frame_ms();
+
+    // Stream header owned by the subscriber's pipe (Ogg Opus header pages).
+    // Returns bytes written; 0 for codecs whose header the caller builds.
+    static size_t stream_header(const StreamSubscription *sub, uint8_t *out, size_t size);
+
+    // Output bytes per frame for `format`: the read granularity (sample bytes
+    // × channels for PCM, 1 for FLAC, MP3 and Opus, one block for ADPCM)
+    static uint32_t frame_bytes(const StreamFormat &format);
+
+    static void get_stats(StreamEncoderStats *stats);
+};
+
+#endif // STREAM_ENCODER_H
@@ -1,11 +1,12 @@
 #include "stream_handler.h"
+#include "adpcm_encoder.h"
 #include "../system/error_handler.h"
 #include "esp_log.h"
 #include <cstring>
 
 static const char *TAG = "stream_handler";
 
-void StreamHandler::build_wav_header(WavHeader* header, uint32_t sample_rate)
+void StreamHandler::build_wav_header(WavHeader* header, uint32_t sample_rate, uint8_t channels)
 {
     if (header == nullptr) {
         return;
@@ -20,19 +21,127 @@ void StreamHandler::build_wav_header(WavHeader* header, uint32_t sample_rate)
     memcpy(header->fmt_tag, "fmt ", 4);
     header->fmt_size = 16;  // PCM format chunk size
     header->audio_format = 1;  // PCM (uncompressed)
-    header->num_channels = 2;  // Stereo
+    header->num_channels = channels;  // Stereo, or mono (L+R)/2
     header->sample_rate = sample_rate;
-    header->byte_rate = sample_rate * 2 * 2;  // sample_rate × channels × bytes_per_sample (16-bit = 2 bytes)
-    header->block_align = 4;  // channels × bytes_per_sample (2 × 2)
+    header->byte_rate = sample_rate * channels * 2;  // sample_rate × channels × bytes_per_sample (16-bit = 2 bytes)
+    header->block_align = channels * 2;  // channels × bytes_per_sample
     header->bits_per_sample = 16;
     
     // data chunk
     memcpy(header->data_tag, "data", 4);
     header->data_size = 0xFFFFFFFF;  // Indeterminate (streaming)
     
-    ESP_LOGI(TAG, "WAV header built: %d Hz, 16-bit stereo, byte_rate=%d",
-             sample_rate, header->byte_rate);
+    ESP_LOGI(TAG, "WAV header built: %d Hz, 16-bit %s, byte_rate=%d",
+             sample_rate, channels == 1 ? "mono" : "stereo", header->byte_rate);
 }
+
+// WAVE_FORMAT_EXTENSIBLE fmt and data chunks for `bits`-bit samples of
+// `sub_format` (PCM or IEEE float)
+static void build_extensible(WavExtensibleHeader* header, uint32_t sample_rate, uint8_t channels,
+                             uint16_t bits, const uint8_t sub_format[16])
+{
+    static_assert(sizeof(WavExtensibleHeader) == WavExtensibleHeader::SIZE, "packed WAV header");
+
+    // RIFF chunk
+    memcpy(header->riff_tag, "RIFF", 4);
+    header->riff_size = 0xFFFFFFFF;  // Indeterminate (streaming)
+    memcpy(header->wave_tag, "WAVE", 4);
+
+    // fmt chunk (WAVEFORMATEXTENSIBLE)
+    memcpy(header->fmt_tag, "fmt ", 4);
+    header->fmt_size = 40;
+    header->audio_format = 0xFFFE;  // WAVE_FORMAT_EXTENSIBLE
+    header->num_channels = channels;
+    header->sample_rate = sample_rate;
+    header->block_align = channels * (bits / 8);  // channels × bytes_per_sample
+    header->byte_rate = sample_rate * header->block_align;
+    header->bits_per_sample = bits;
+    header->cb_size = 22;
+    header->valid_bits = bits;
+    // SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT, or SPEAKER_FRONT_CENTER
+    header->channel_mask = channels == 1 ? 0x4 : 0x3;
+    memcpy(header->sub_format, sub_format, 16);
+
+    // data chunk
+    memcpy(header->data_tag, "data", 4);
+    header->data_size = 0xFFFFFFFF;  // Indeterminate (streaming)
+}
+
+void StreamHandler::build_wav_header_24(WavExtensibleHeader* header, uint32_t sample_rate, uint8_t channels)
+{
+    // KSDATAFORMAT_SUBTYPE_PCM: 00000001-0000-0010-8000-00aa00389b71
+    static const uint8_t PCM_GUID[16] = {
+        0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+        0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+    };
+
+    if (header == nullptr) {
+        return;
+    }
+
+    // Stereo is the ring's packed frame (6 bytes)
+    build_extensible(header, sample_rate, channels, 24, PCM_GUID);
+
+    ESP_LOGI(TAG, "WAV header built: %d Hz, 24-bit %s (extensible), byte_rate=%d",
+             sample_rate, channels == 1 ? "mono" : "stereo", header->byte_rate);
+}
+
+void StreamHandler::build_wav_header_f32(WavExtensibleHeader* header, uint32_t sample_rate, uint8_t channels)
+{
+    // KSDATAFORMAT_SUBTYPE_IEEE_FLOAT: 00000003-0000-0010-8000-00aa00389b71
+    static const uint8_t FLOAT_GUID[16] = {
+        0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+        0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+    };
+
+    if (header == nullptr) {
+        return;
+    }
+
+    build_extensible(header, sample_rate, channels, 32, FLOAT_GUID);
+
+    ESP_LOGI(TAG, "WAV header built: %d Hz, 32-bit float %s (extensible), byte_rate=%d",
+             sample_rate, channels == 1 ? "mono" : "stereo", header->byte_rate);
+}
+
+void StreamHandler::build_wav_header_adpcm(ImaAdpcmWavHeader* header, uint32_t sample_rate)
+{
+    static_assert(sizeof(ImaAdpcmWavHeader) == ImaAdpcmWavHeader::SIZE, "packed WAV header");
+
+    if (header == nullptr) {
+        return;
+    }
+
+    // RIFF chunk
+    memcpy(header->riff_tag, "RIFF", 4);
+    header->riff_size = 0xFFFFFFFF;  // Indeterminate (streaming)
+    memcpy(header->wave_tag, "WAVE", 4);
+
+    // fmt chunk (IMA ADPCM)
+    memcpy(header->fmt_tag, "fmt ", 4);
+    header->fmt_size = 20;
+    header->audio_format = 0x0011;  // WAVE_FORMAT_IMA_ADPCM
+    header->num_channels = 2;  // Stereo
+    header->sample_rate = sample_rate;
+    header->byte_rate = (uint32_t)((uint64_t)sample_rate * ADPCM_BLOCK_BYTES / ADPCM_BLOCK_FRAMES);
+    header->block_align = ADPCM_BLOCK_BYTES;
+    header->bits_per_sample = 4;
+    header->cb_size = 2;
+    header->samples_per_block = ADPCM_BLOCK_FRAMES;
+
+    // fact chunk
+    memcpy(header->fact_tag, "fact", 4);
+    header->fact_size = 4;
+    header->sample_length = 0xFFFFFFFF;  // Indeterminate (streaming)
+
+    // data chunk
+    memcpy(header->data_tag, "data", 4);
+    header->data_size = 0xFFFFFFFF;  // Indeterminate (streaming)
+
+    ESP_LOGI(TAG, "WAV header built: %d Hz, IMA ADPCM stereo, %u-byte blocks, byte_rate=%d",
+             sample_rate, (unsigned)ADPCM_BLOCK_BYTES, header->byte_rate);
+}
+
 size_t StreamHandler::downsample_24to16(const uint8_t* input_24bit, uint8_t* output_16bit, size_t input_bytes)
 {
     // Input: 24-bit PCM stereo (6 bytes per frame: 3 bytes L, 3 bytes R)
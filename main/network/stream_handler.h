@@ -5,8 +5,17 @@
 
 class StreamHandler {
 public:
-    // Build WAV header for HTTP streaming
-    static void build_wav_header(WavHeader* header, uint32_t sample_rate);
+    // Build WAV header for HTTP streaming (16-bit PCM)
+    static void build_wav_header(WavHeader* header, uint32_t sample_rate, uint8_t channels = 2);
+
+    // Build WAVE_FORMAT_EXTENSIBLE header for the 24-bit streams
+    static void build_wav_header_24(WavExtensibleHeader* header, uint32_t sample_rate, uint8_t channels = 2);
+
+    // Build WAVE_FORMAT_EXTENSIBLE header for the 32-bit float stream
+    static void build_wav_header_f32(WavExtensibleHeader* header, uint32_t sample_rate, uint8_t channels = 2);
+
+    // Build WAVE_FORMAT_IMA_ADPCM header for the ADPCM stream
+    static void build_wav_header_adpcm(ImaAdpcmWavHeader* header, uint32_t sample_rate);
     
     // Downsample 24-bit PCM to 16-bit PCM (truncation method)
     // Returns number of bytes written to output_16bit
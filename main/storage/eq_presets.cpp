@@ -0,0 +1,301 @@
+#include "eq_presets.h"
+#include "../audio/eq_processor.h"
+#include "../system/error_handler.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+#include <cstdio>
+#include <cstring>
+
+static const char *TAG = "eq_presets";
+
+// NVS namespace and keys
+constexpr const char *NVS_NAMESPACE  = "eq_presets";
+constexpr const char *NVS_KEY_ACTIVE = "active";    // u8 slot, NO_ACTIVE = none
+constexpr uint8_t     NO_ACTIVE      = 0xFF;
+constexpr uint8_t     RECORD_VERSION = 1;
+
+// One preset per key "p0".."p7". The coefficient bank is computed once at save
+// time so applying a preset is a single blob read plus a memcpy. Not packed:
+// the float bank must stay word-aligned (records are memset before filling, so
+// padding bytes are deterministic for the CRC).
+struct EQPresetRecord {
+    uint8_t      version;
+    char         name[EQ_PRESET_NAME_LEN];
+    EQBandConfig bands[EQ_MAX_BANDS];
+    uint32_t     coef_rate;                  // Sample rate the bank was computed at
+    float        coefs[EQ_MAX_BANDS][5];
+    uint32_t     crc32;                      // CRC32 of all preceding bytes
+};
+
+static SemaphoreHandle_t s_mutex = nullptr;
+static char    s_names[EQ_PRESET_MAX_COUNT][EQ_PRESET_NAME_LEN];  // "" = free slot
+static uint8_t s_active = NO_ACTIVE;
+
+// ─── Helpers ─────────────────────────────────────────────────────────────────
+
+static void slot_key(uint8_t slot, char *key, size_t len) {
+    snprintf(key, len, "p%u", slot);
+}
+
+static uint32_t record_crc(const EQPresetRecord &rec) {
+    return esp_rom_crc32_le(0, (const uint8_t *)&rec, sizeof(rec) - sizeof(uint32_t));
+}
+
+static int find_slot(const char *name) {
+    for (uint8_t i = 0; i < EQ_PRESET_MAX_COUNT; i++) {
+        if (s_names[i][0] != '\0' && strcmp(s_names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static bool read_record(nvs_handle_t h, uint8_t slot, EQPresetRecord *rec) {
+    char key[4];
+    slot_key(slot, key, sizeof(key));
+    size_t size = sizeof(*rec);
+    if (nvs_get_blob(h, key, rec, &size) != ESP_OK || size != sizeof(*rec)) return false;
+    if (rec->version != RECORD_VERSION || rec->crc32 != record_crc(*rec)) {
+        ESP_LOGW(TAG, "Preset slot %u invalid (version %u / CRC mismatch), ignoring",
+                 slot, rec->version);
+        return false;
+    }
+    rec->name[EQ_PRESET_NAME_LEN - 1] = '\0';
+    return true;
+}
+
+// Only touch flash when the stored value actually changes
+static bool write_active(nvs_handle_t h, uint8_t slot) {
+    uint8_t stored = NO_ACTIVE;
+    if (nvs_get_u8(h, NVS_KEY_ACTIVE, &stored) == ESP_OK && stored == slot) return true;
+    if (nvs_set_u8(h, NVS_KEY_ACTIVE, slot) != ESP_OK) return false;
+    return nvs_commit(h) == ESP_OK;
+}
+
+static bool valid_name(const char *name) {
+    if (name == nullptr) return false;
+    size_t len = strlen(name);
+    if (len == 0 || len >= EQ_PRESET_NAME_LEN) return false;
+    for (size_t i = 0; i < len; i++) {
+        // Names end up in JSON and MQTT payloads unescaped
+        if ((unsigned char)name[i] < 0x20 || name[i] == '"' || name[i] == '\\') return false;
+    }
+    return true;
+}
+
+// Load `slot` into the EQ. Caller holds s_mutex.
+static bool apply_slot(nvs_handle_t h, uint8_t slot) {
+    static EQPresetRecord rec;  // Kept off the HTTP/MQTT task stacks
+    if (!read_record(h, slot, &rec)) return false;
+    if (!EQProcessor::load_bank(rec.bands, rec.coefs, rec.coef_rate)) return false;
+    s_active = slot;
+    ESP_LOGI(TAG, "Preset '%s' applied (slot %u)", rec.name, slot);
+    return true;
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool EQPresets::init() {
+    if (s_mutex == nullptr) {
+        s_mutex = xSemaphoreCreateMutex();
+        if (s_mutex == nullptr) return false;
+    }
+
+    memset(s_names, 0, sizeof(s_names));
+    s_active = NO_ACTIVE;
+
+    nvs_handle_t h;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) {
+        ESP_LOGI(TAG, "No presets stored");
+        return true;
+    }
+
+    static EQPresetRecord rec;
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < EQ_PRESET_MAX_COUNT; i++) {
+        if (read_record(h, i, &rec)) {
+            memcpy(s_names[i], rec.name, EQ_PRESET_NAME_LEN);
+            count++;
+        }
+    }
+    uint8_t active = NO_ACTIVE;
+    if (nvs_get_u8(h, NVS_KEY_ACTIVE, &active) == ESP_OK &&
+        active < EQ_PRESET_MAX_COUNT && s_names[active][0] != '\0') {
+        s_active = active;
+    }
+    nvs_close(h);
+
+    ESP_LOGI(TAG, "%u preset(s) stored, active: %s", count,
+             s_active != NO_ACTIVE ? s_names[s_active] : "none");
+    return true;
+}
+
+bool EQPresets::apply_active() {
+    if (s_mutex == nullptr || s_active == NO_ACTIVE) return false;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool ok = false;
+    nvs_handle_t h;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) == ESP_OK) {
+        ok = apply_slot(h, s_active);
+        nvs_close(h);
+    }
+    if (!ok) s_active = NO_ACTIVE;
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
+
+uint8_t EQPresets::list(EQPresetInfo *out, uint8_t max) {
+    if (out == nullptr || s_mutex == nullptr) return 0;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < EQ_PRESET_MAX_COUNT && n < max; i++) {
+        if (s_names[i][0] == '\0') continue;
+        out[n].slot = i;
+        memcpy(out[n].name, s_names[i], EQ_PRESET_NAME_LEN);
+        n++;
+    }
+    xSemaphoreGive(s_mutex);
+    return n;
+}
+
+bool EQPresets::save(const char *name) {
+    if (!valid_name(name) || s_mutex == nullptr) return false;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int slot = find_slot(name);
+    for (uint8_t i = 0; slot < 0 && i < EQ_PRESET_MAX_COUNT; i++) {
+        if (s_names[i][0] == '\0') slot = i;
+    }
+    if (slot < 0) {
+        xSemaphoreGive(s_mutex);
+        ESP_LOGW(TAG, "All %u preset slots in use", EQ_PRESET_MAX_COUNT);
+        return false;
+    }
+
+    static EQPresetRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.version = RECORD_VERSION;
+    strncpy(rec.name, name, EQ_PRESET_NAME_LEN - 1);
+    EQProcessor::get_bands(rec.bands);
+    rec.coef_rate = EQProcessor::get_sample_rate();
+    EQProcessor::compute_coefs(rec.bands, rec.coef_rate, rec.coefs);
+    rec.crc32 = record_crc(rec);
+
+    bool ok = false;
+    nvs_handle_t h;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) == ESP_OK) {
+        char key[4];
+        slot_key((uint8_t)slot, key, sizeof(key));
+        ok = nvs_set_blob(h, key, &rec, sizeof(rec)) == ESP_OK &&
+             nvs_commit(h) == ESP_OK &&
+             write_active(h, (uint8_t)slot);
+        nvs_close(h);
+    }
+
+    if (ok) {
+        memcpy(s_names[slot], rec.name, EQ_PRESET_NAME_LEN);
+        s_active = (uint8_t)slot;
+        ESP_LOGI(TAG, "Preset '%s' saved to slot %d (%lu Hz bank)",
+                 rec.name, slot, (unsigned long)rec.coef_rate);
+    } else {
+        ErrorHandler::log_error(ErrorType::NVS_ERROR, "Failed to save EQ preset");
+    }
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
+
+bool EQPresets::remove(const char *name) {
+    if (name == nullptr || s_mutex == nullptr) return false;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int slot = find_slot(name);
+    if (slot < 0) {
+        xSemaphoreGive(s_mutex);
+        return false;
+    }
+
+    bool ok = false;
+    nvs_handle_t h;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) == ESP_OK) {
+        char key[4];
+        slot_key((uint8_t)slot, key, sizeof(key));
+        ok = nvs_erase_key(h, key) == ESP_OK && nvs_commit(h) == ESP_OK;
+        if (ok && s_active == slot) ok = write_active(h, NO_ACTIVE);
+        nvs_close(h);
+    }
+
+    if (ok) {
+        ESP_LOGI(TAG, "Preset '%s' deleted (slot %d)", s_names[slot], slot);
+        s_names[slot][0] = '\0';
+        if (s_active == slot) s_active = NO_ACTIVE;
+    }
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
+
+bool EQPresets::apply(const char *name) {
+    if (name == nullptr || s_mutex == nullptr) return false;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int slot = find_slot(name);
+    bool ok = false;
+    nvs_handle_t h;
+    if (slot >= 0 && nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) == ESP_OK) {
+        ok = apply_slot(h, (uint8_t)slot);
+        if (ok) write_active(h, (uint8_t)slot);
+        nvs_close(h);
+    }
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
+
+bool EQPresets::get_active(char *buf, size_t len) {
+    if (buf == nullptr || len == 0) return false;
+    buf[0] = '\0';
+    if (s_mutex == nullptr) return false;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool active = s_active != NO_ACTIVE;
+    if (active) {
+        strncpy(buf, s_names[s_active], len - 1);
+        buf[len - 1] = '\0';
+    }
+    xSemaphoreGive(s_mutex);
+    return active;
+}
+
+void EQPresets::clear_active() {
+    if (s_mutex == nullptr) return;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_active != NO_ACTIVE) {
+        s_active = NO_ACTIVE;
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) == ESP_OK) {
+            write_active(h, NO_ACTIVE);
+            nvs_close(h);
+        }
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+bool EQPresets::erase() {
+    if (s_mutex != nullptr) xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    esp_err_t err = ESP_OK;
+    nvs_handle_t h;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) == ESP_OK) {
+        err = nvs_erase_all(h);
+        if (err == ESP_OK) err = nvs_commit(h);
+        nvs_close(h);
+    }
+    memset(s_names, 0, sizeof(s_names));
+    s_active = NO_ACTIVE;
+
+    if (s_mutex != nullptr) xSemaphoreGive(s_mutex);
+    ESP_LOGI(TAG, "All presets erased");
+    return err == ESP_OK;
+}
@@ -0,0 +1,60 @@
+#ifndef EQ_PRESETS_H
+#define EQ_PRESETS_H
+
+#include "config_schema.h"
+#include <cstddef>
+#include <cstdint>
+
+// EQPresets: named EQ band sets stored in their own NVS namespace.
+//
+// Each preset holds the 10 EQBandConfig bands plus a coefficient bank
+// precomputed at the sample rate it was saved at. Presets are read from NVS
+// only when applied; applying one hands the bank to EQProcessor::load_bank(),
+// which swaps it in with a one-block crossfade. Switching presets never
+// rewrites the DeviceConfig blob — only the one-byte active slot changes.
+//
+// Called from Core 1 tasks (HTTP server, MQTT event task); internally
+// serialized by a mutex.
+
+static constexpr uint8_t EQ_PRESET_MAX_COUNT = 8;
+static constexpr size_t  EQ_PRESET_NAME_LEN  = 24;   // Including NUL
+
+struct EQPresetInfo {
+    uint8_t slot;
+    char    name[EQ_PRESET_NAME_LEN];
+};
+
+class EQPresets {
+public:
+    // Open the namespace and cache preset names. Call after NVS init.
+    static bool init();
+
+    // Re-apply the preset that was active at the last shutdown (if any).
+    // Call after EQProcessor::init().
+    static bool apply_active();
+
+    // List stored presets in slot order. Returns the number written to `out`.
+    static uint8_t list(EQPresetInfo *out, uint8_t max);
+
+    // Store the live EQ bands under `name` (overwrites a preset of the same
+    // name) and mark it active. Fails if all slots are in use.
+    static bool save(const char *name);
+
+    // Delete the preset called `name`.
+    static bool remove(const char *name);
+
+    // Load the preset called `name` into the EQ and mark it active.
+    static bool apply(const char *name);
+
+    // Copy the active preset name into `buf` ("" if none). Returns false if
+    // no preset is active.
+    static bool get_active(char *buf, size_t len);
+
+    // Forget the active preset (called when bands are edited by hand).
+    static void clear_active();
+
+    // Erase all presets (factory reset).
+    static bool erase();
+};
+
+#endif // EQ_PRESETS_H
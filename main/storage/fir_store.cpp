@@ -0,0 +1,178 @@
+#include "fir_store.h"
+#include "../audio/fir_filter.h"
+#include "../system/error_handler.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "fir_store";
+
+constexpr const char *PARTITION_LABEL = "fir_ir";
+constexpr uint32_t    HEADER_MAGIC    = 0x31524946;  // "FIR1"
+constexpr uint8_t     HEADER_VERSION  = 1;
+
+struct FIRStoreHeader {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  channels;
+    uint16_t reserved;
+    uint32_t taps;
+    uint32_t sample_rate;
+    uint32_t data_crc32;        // CRC32 of the tap data
+    uint32_t crc32;             // CRC32 of all preceding header bytes
+};
+
+static const esp_partition_t *s_part = nullptr;
+static SemaphoreHandle_t s_mutex = nullptr;
+static FIRStoreHeader s_header = {};
+static bool s_valid = false;
+
+// ─── Helpers ─────────────────────────────────────────────────────────────────
+
+static uint32_t header_crc(const FIRStoreHeader &h) {
+    return esp_rom_crc32_le(0, (const uint8_t *)&h, sizeof(h) - sizeof(uint32_t));
+}
+
+static uint32_t data_bytes(uint32_t taps, uint8_t channels) {
+    return taps * channels * sizeof(float);
+}
+
+static bool read_header(FIRStoreHeader *h) {
+    if (esp_partition_read(s_part, 0, h, sizeof(*h)) != ESP_OK) return false;
+    return h->magic == HEADER_MAGIC && h->version == HEADER_VERSION &&
+           h->crc32 == header_crc(*h) &&
+           (h->channels == 1 || h->channels == 2) &&
+           h->taps > 0 && h->taps <= FIR_MAX_TAPS &&
+           FIR_STORE_DATA_OFFSET + data_bytes(h->taps, h->channels) <= s_part->size;
+}
+
+// ─── Public API ──────────────────────────────────────────────────────────────
+
+bool FIRStore::init() {
+    if (s_mutex == nullptr) {
+        s_mutex = xSemaphoreCreateMutex();
+        if (s_mutex == nullptr) return false;
+    }
+
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                      ESP_PARTITION_SUBTYPE_DATA_UNDEFINED, PARTITION_LABEL);
+    if (s_part == nullptr) {
+        ESP_LOGW(TAG, "No '%s' partition, FIR uploads disabled", PARTITION_LABEL);
+        return false;
+    }
+
+    s_valid = read_header(&s_header);
+    if (s_valid) {
+        ESP_LOGI(TAG, "Stored IR: %lu taps x %u ch @ %lu Hz",
+                 (unsigned long)s_header.taps, s_header.channels,
+                 (unsigned long)s_header.sample_rate);
+    } else {
+        ESP_LOGI(TAG, "No IR stored");
+    }
+    return true;
+}
+
+bool FIRStore::load_into_filter() {
+    if (s_part == nullptr) return false;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (!s_valid) {
+        xSemaphoreGive(s_mutex);
+        return false;
+    }
+
+    uint32_t bytes = data_bytes(s_header.taps, s_header.channels);
+    float *ir = (float *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (ir == nullptr) ir = (float *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL);
+    if (ir == nullptr) {
+        xSemaphoreGive(s_mutex);
+        ESP_LOGE(TAG, "No memory for %lu byte IR", (unsigned long)bytes);
+        return false;
+    }
+
+    bool ok = esp_partition_read(s_part, FIR_STORE_DATA_OFFSET, ir, bytes) == ESP_OK;
+    if (ok && esp_rom_crc32_le(0, (const uint8_t *)ir, bytes) != s_header.data_crc32) {
+        ESP_LOGW(TAG, "Stored IR CRC mismatch, ignoring");
+        ok = false;
+    }
+    if (ok) {
+        ok = FIRFilter::load(ir, s_header.taps, s_header.channels, s_header.sample_rate);
+    }
+    heap_caps_free(ir);
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
+
+bool FIRStore::save(const float *ir, uint32_t taps, uint8_t channels, uint32_t sample_rate) {
+    if (s_part == nullptr || ir == nullptr) return false;
+    if (taps == 0 || taps > FIR_MAX_TAPS || (channels != 1 && channels != 2)) return false;
+
+    uint32_t bytes = data_bytes(taps, channels);
+    if (FIR_STORE_DATA_OFFSET + bytes > s_part->size) return false;
+    for (uint32_t i = 0; i < taps * channels; i++) {
+        if (!std::isfinite(ir[i])) {
+            ESP_LOGW(TAG, "IR rejected: tap %lu is not finite", (unsigned long)(i / channels));
+            return false;
+        }
+    }
+
+    FIRStoreHeader h = {};
+    h.magic       = HEADER_MAGIC;
+    h.version     = HEADER_VERSION;
+    h.channels    = channels;
+    h.taps        = taps;
+    h.sample_rate = sample_rate;
+    h.data_crc32  = esp_rom_crc32_le(0, (const uint8_t *)ir, bytes);
+    h.crc32       = header_crc(h);
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    // Erase header and data in one go; rounded up to whole sectors
+    uint32_t erase_len = (FIR_STORE_DATA_OFFSET + bytes + s_part->erase_size - 1) &
+                         ~(s_part->erase_size - 1);
+    bool ok = esp_partition_erase_range(s_part, 0, erase_len) == ESP_OK;
+    s_valid = false;
+    ok = ok && esp_partition_write(s_part, FIR_STORE_DATA_OFFSET, ir, bytes) == ESP_OK;
+    ok = ok && esp_partition_write(s_part, 0, &h, sizeof(h)) == ESP_OK;
+    if (ok) {
+        s_header = h;
+        s_valid = true;
+        ESP_LOGI(TAG, "IR stored: %lu taps x %u ch @ %lu Hz",
+                 (unsigned long)taps, channels, (unsigned long)sample_rate);
+    } else {
+        ErrorHandler::log_error(ErrorType::NVS_ERROR, "Failed to write FIR partition");
+    }
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
+
+bool FIRStore::erase() {
+    if (s_part == nullptr) return false;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    // Invalidating the header sector is enough; stale taps are never read
+    bool ok = esp_partition_erase_range(s_part, 0, s_part->erase_size) == ESP_OK;
+    if (ok) s_valid = false;
+    xSemaphoreGive(s_mutex);
+    ESP_LOGI(TAG, "Stored IR erased");
+    return ok;
+}
+
+void FIRStore::get_info(FIRStoreInfo *info) {
+    if (info == nullptr) return;
+    memset(info, 0, sizeof(*info));
+    if (s_mutex == nullptr) return;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    info->valid = s_valid;
+    if (s_valid) {
+        info->taps        = s_header.taps;
+        info->channels    = s_header.channels;
+        info->sample_rate = s_header.sample_rate;
+    }
+    xSemaphoreGive(s_mutex);
+}
@@ -0,0 +1,51 @@
+#ifndef FIR_STORE_H
+#define FIR_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// FIRStore: impulse response storage for FIRFilter in the "fir_ir" flash
+// partition (a 4096-tap stereo IR is 32 KB — too large for an NVS blob).
+//
+// Layout: a header sector at offset 0, interleaved float32 taps from
+// FIR_STORE_DATA_OFFSET. save() takes a complete IR that the caller has
+// already received in RAM and validates it before anything is erased, so a
+// failed or aborted upload leaves the stored IR untouched. The header is
+// written last: losing power mid-write leaves no valid IR behind rather than
+// a corrupt one.
+//
+// Flash erase/write briefly stalls code execution from flash on both cores.
+// Capture runs from IRAM/DRAM buffers and the I2S DMA ring absorbs the gap,
+// but uploads are an admin operation and should not happen mid-stream.
+//
+// Called from Core 1 (HTTP server, startup); internally serialized by a mutex.
+
+static constexpr uint32_t FIR_STORE_DATA_OFFSET = 0x1000;
+
+struct FIRStoreInfo {
+    bool     valid;
+    uint32_t taps;
+    uint8_t  channels;
+    uint32_t sample_rate;
+};
+
+class FIRStore {
+public:
+    // Locate the partition. Returns false if the partition table has none.
+    static bool init();
+
+    // Load the stored IR (if any) into FIRFilter. Returns false if there is
+    // no valid IR or the filter rejected it.
+    static bool load_into_filter();
+
+    // Replace the stored IR with `taps` frames × `channels` float32 samples.
+    // Rejects (and keeps the stored IR) on bad dimensions or non-finite taps.
+    static bool save(const float *ir, uint32_t taps, uint8_t channels, uint32_t sample_rate);
+
+    // Erase the stored IR.
+    static bool erase();
+
+    static void get_info(FIRStoreInfo *info);
+};
+
+#endif // FIR_STORE_H
@@ -1,4 +1,6 @@
 #include "nvs_config.h"
+#include "eq_presets.h"
+#include "fir_store.h"
 #include "../system/error_handler.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
@@ -181,6 +183,49 @@ bool NVSConfig::load_factory_defaults(DeviceConfig *config)
     // Band 9: High shelf @ 16 kHz, Q=0.707
     config->eq_bands[9] = { false, EQFilterType::HIGH_SHELF, 16000.0f, 0.0f, 0.707f };
 
+    // Phono preset stage off (line-level input assumed)
+    config->phono_curve = PhonoCurve::OFF;
+    config->phono_rumble_filter = false;
+
+    // Limiter on: boosted EQ bands are limited instead of hard-clipped
+    config->limiter_enabled = true;
+    config->limiter_ceiling_db = DeviceConfig::DEFAULT_LIMITER_CEILING_DB;
+    config->limiter_release_ms = DeviceConfig::DEFAULT_LIMITER_RELEASE_MS;
+
+    // FIR off until an impulse response is uploaded
+    config->fir_enabled = false;
+
+    // AGC off: levels pass through unchanged until the user opts in
+    config->agc_enabled = false;
+    config->agc_target_lufs = DeviceConfig::DEFAULT_AGC_TARGET_LUFS;
+    config->agc_max_gain_db = DeviceConfig::DEFAULT_AGC_MAX_GAIN_DB;
+
+    // Plain TPDF dither on the 16-bit streams (flat noise floor, no shaping)
+    config->stream_dither = DitherMode::TPDF;
+
+    // Highest MP3 bitrate: still ~1/5 of 16-bit PCM at 48 kHz
+    config->mp3_bitrate_kbps = DeviceConfig::DEFAULT_MP3_BITRATE_KBPS;
+
+    // Opus: near-transparent stereo at 20 ms frames (10 ms halves the delay)
+    config->opus_bitrate_kbps = DeviceConfig::DEFAULT_OPUS_BITRATE_KBPS;
+    config->opus_frame_ms = DeviceConfig::DEFAULT_OPUS_FRAME_MS;
+
+    // RTP off: multicast floods every port of switches without IGMP snooping
+    config->rtp_enabled = false;
+    strncpy(config->rtp_group, DeviceConfig::DEFAULT_RTP_GROUP, sizeof(config->rtp_group));
+    config->rtp_port = DeviceConfig::DEFAULT_RTP_PORT;
+    config->rtp_bits = DeviceConfig::DEFAULT_RTP_BITS;
+    config->rtp_ttl = DeviceConfig::DEFAULT_RTP_TTL;
+
+    // Snapcast off; FLAC when enabled: lossless at about half the PCM rate
+    config->snapcast_enabled = false;
+    config->snapcast_codec = SnapcastCodec::FLAC;
+    config->snapcast_buffer_ms = DeviceConfig::DEFAULT_SNAPCAST_BUFFER_MS;
+
+    // HLS off: its segment cache takes several MB of PSRAM
+    config->hls_enabled = false;
+    config->hls_segment_s = DeviceConfig::DEFAULT_HLS_SEGMENT_S;
+
     config->crc32 = 0;
     
     ESP_LOGI(TAG, "Factory defaults loaded");
@@ -221,6 +266,12 @@ bool NVSConfig::erase_all()
         return false;
     }
     
+    // EQ presets live in their own namespace
+    EQPresets::erase();
+
+    // ...and the FIR impulse response in its own partition
+    FIRStore::erase();
+    
     // Also erase WiFi config from default namespace
     nvs_handle_t nvs_handle;
     esp_err_t err = nvs_open("nvs.net80211", NVS_READWRITE, &nvs_handle);
@@ -0,0 +1,74 @@
+// Ditherer cost per mode, in the stream pipes' 256-frame blocks.
+//
+// Prints, per mode (OFF is plain rounding, the truncation baseline) and input
+// path (packed 24-bit from the capture ring, float from the resampler), ns
+// per stereo frame and the share of real time at 48 kHz. Each figure is the
+// median of REPEATS runs over SECONDS of noise. Fails if a regression budget
+// is exceeded:
+//   every mode     < 0.2 % of real time
+//   NS2            < 4 × the cost of OFF on the same path
+// The budgets are loose on purpose (about ten times the current figure on a
+// desktop core): they catch structural regressions (a per-sample call into
+// the generator, shaping state spilled to memory), not drift.
+
+#include "host_test.h"
+#include "audio/dither.h"
+#include "audio/dsp_platform.h"
+#include <algorithm>
+
+static constexpr uint32_t RATE    = 48000;
+static constexpr size_t   BLOCK   = 256;
+static constexpr size_t   SECONDS = 4;
+static constexpr int      REPEATS = 5;
+
+static constexpr DitherMode MODES[] = {DitherMode::OFF, DitherMode::TPDF, DitherMode::TPDF_NS1,
+                                       DitherMode::TPDF_NS2};
+
+template <typename Fn>
+static double ns_per_frame(Fn fn) {
+    static constexpr size_t FRAMES = RATE * SECONDS;
+    std::vector<double> runs;
+    for (int r = 0; r < REPEATS; r++) {
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        for (size_t f = 0; f + BLOCK <= FRAMES; f += BLOCK) fn(f % (RATE / 4));
+        runs.push_back((uint32_t)(esp_cpu_get_cycle_count() - t0) / (double)FRAMES);
+    }
+    std::sort(runs.begin(), runs.end());
+    return runs[REPEATS / 2];
+}
+
+int main() {
+    // A quarter second of −20 dBFS noise, cycled
+    std::vector<float> f32(RATE / 4 * 2 + BLOCK * 2);
+    std::vector<uint8_t> s24(f32.size() * 3), out(BLOCK * 4);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < f32.size(); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        int32_t v = ht_to24(0.1 * ((double)(seed >> 8) / 8388608.0 - 1.0));
+        f32[i] = v / 8388608.0f;
+        ht_put24(&s24[i * 3], v);
+    }
+
+    const double frame_ns = 1e9 / RATE;
+    double off[2] = {};
+    printf("%-10s %12s %8s %12s %8s\n", "mode", "s24 ns/fr", "% RT", "f32 ns/fr", "% RT");
+    for (DitherMode mode : MODES) {
+        Ditherer d;
+        d.init(mode, 1);
+        double ns[2];
+        ns[0] = ns_per_frame([&](size_t f) { d.process_s24(&s24[f * 6], out.data(), BLOCK); });
+        ns[1] = ns_per_frame([&](size_t f) { d.process_f32(&f32[f * 2], out.data(), BLOCK); });
+        printf("%-10s %12.2f %7.3f%% %12.2f %7.3f%%\n", dither_mode_to_str(mode), ns[0], 100.0 * ns[0] / frame_ns,
+               ns[1], 100.0 * ns[1] / frame_ns);
+        for (int p = 0; p < 2; p++) {
+            const char *path = p == 0 ? "s24" : "f32";
+            HT_CHECK(ns[p] < 0.002 * frame_ns, "%s %s: %.3f %% of real time", dither_mode_to_str(mode), path,
+                     100.0 * ns[p] / frame_ns);
+            if (mode == DitherMode::OFF) off[p] = ns[p];
+            if (mode == DitherMode::TPDF_NS2) {
+                HT_CHECK(ns[p] < 4.0 * off[p], "NS2 %s: %.1fx the cost of rounding", path, ns[p] / off[p]);
+            }
+        }
+    }
+    return ht_result();
+}
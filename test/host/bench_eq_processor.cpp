@@ -0,0 +1,117 @@
+// EQProcessor cost per DMA block (240 frames, 48 kHz) by active band count.
+//
+// Prints ns per block for the bypass, 1–10 PEAKING bands, the full chain
+// (10 bands + RIAA/rumble + limiter), the silent fast path and a decay into
+// silence. Fails if a regression budget is exceeded:
+//   full chain      < 20 % of the 5 ms block period
+//   fast path       < half the cost of one band
+//   decay blocks    < 3× the steady-state cost (denormals reaching the FPU)
+// The budgets are loose on purpose: they catch structural regressions (a lost
+// fast path, denormal stalls, an accidental O(n²)) on any host, not drift.
+
+#include "host_test.h"
+#include "audio/eq_processor.h"
+#include "audio/dsp_platform.h"
+#include <algorithm>
+#include <vector>
+
+static constexpr size_t   BLOCK   = EQ_FRAMES_PER_BLOCK;
+static constexpr uint32_t RATE    = 48000;
+static constexpr int      BLOCKS  = 2000;
+static constexpr int      REPEATS = 5;
+static constexpr double   BLOCK_NS = 1e9 * BLOCK / RATE;
+
+static uint8_t s_noise[BLOCKS][BLOCK * 8];
+static uint8_t s_zero[BLOCK * 8];
+static uint8_t s_out[BLOCK * 6];
+
+static void make_noise() {
+    uint32_t seed = 12345;
+    for (int b = 0; b < BLOCKS; b++) {
+        for (size_t i = 0; i < BLOCK * 2; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            // ~ -20 dBFS white noise
+            ht_put_i2s(s_noise[b] + i * 4, (int32_t)(seed >> 8) / 10 - 0x80000 / 10 * 16);
+        }
+    }
+}
+
+static DeviceConfig config(uint8_t bands, bool phono, bool limiter) {
+    DeviceConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.eq_enabled = true;
+    for (uint8_t b = 0; b < bands; b++) {
+        cfg.eq_bands[b] = {true, EQFilterType::PEAKING, 31.25f * (float)(1 << b), b % 2 ? -3.0f : 3.0f, 1.4f};
+    }
+    cfg.phono_curve = phono ? PhonoCurve::RIAA : PhonoCurve::OFF;
+    cfg.phono_rumble_filter = phono;
+    cfg.limiter_enabled = limiter;
+    cfg.limiter_ceiling_db = -1.0f;
+    cfg.limiter_release_ms = 100.0f;
+    return cfg;
+}
+
+// Median over REPEATS of the mean ns per block
+static double time_blocks(const DeviceConfig &cfg, bool silent) {
+    std::vector<double> runs;
+    for (int r = 0; r < REPEATS; r++) {
+        EQProcessor::init(cfg, RATE);
+        // Warm up; silence needs a few blocks to settle into the fast path
+        for (int b = 0; b < 50; b++) EQProcessor::process(silent ? s_zero : s_noise[b], s_out, BLOCK);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        for (int b = 0; b < BLOCKS; b++) EQProcessor::process(silent ? s_zero : s_noise[b], s_out, BLOCK);
+        runs.push_back((double)(uint32_t)(esp_cpu_get_cycle_count() - t0) / BLOCKS);
+    }
+    std::sort(runs.begin(), runs.end());
+    return runs[REPEATS / 2];
+}
+
+// Mean ns per block over the 4 s after loud input stops (fast path excluded
+// by measuring only blocks that ran the cascade)
+static double time_decay(const DeviceConfig &cfg) {
+    std::vector<double> runs;
+    for (int r = 0; r < REPEATS; r++) {
+        EQProcessor::init(cfg, RATE);
+        for (int b = 0; b < 400; b++) EQProcessor::process(s_noise[b], s_out, BLOCK);
+        EQStats before, after;
+        EQProcessor::get_stats(&before);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        for (int b = 0; b < 800; b++) EQProcessor::process(s_zero, s_out, BLOCK);
+        double ns = (double)(uint32_t)(esp_cpu_get_cycle_count() - t0);
+        EQProcessor::get_stats(&after);
+        uint32_t full = (after.blocks_total - before.blocks_total) - (after.blocks_silent - before.blocks_silent);
+        runs.push_back(ns / (full > 0 ? full : 1));
+    }
+    std::sort(runs.begin(), runs.end());
+    return runs[REPEATS / 2];
+}
+
+int main() {
+    make_noise();
+
+    printf("%-28s %10s %10s %9s\n", "chain", "ns/block", "ns/band", "% of RT");
+    double bypass = time_blocks(config(0, false, false), false);
+    printf("%-28s %10.0f %10s %8.3f%%\n", "bypass", bypass, "-", 100.0 * bypass / BLOCK_NS);
+
+    double one_band = 0.0, ten_bands = 0.0;
+    for (uint8_t bands = 1; bands <= EQ_MAX_BANDS; bands++) {
+        double ns = time_blocks(config(bands, false, false), false);
+        if (bands == 1) one_band = ns;
+        if (bands == EQ_MAX_BANDS) ten_bands = ns;
+        char name[32];
+        snprintf(name, sizeof(name), "%u band%s", bands, bands == 1 ? "" : "s");
+        printf("%-28s %10.0f %10.0f %8.3f%%\n", name, ns, ns / bands, 100.0 * ns / BLOCK_NS);
+    }
+
+    double full = time_blocks(config(EQ_MAX_BANDS, true, true), false);
+    printf("%-28s %10.0f %10s %8.3f%%\n", "10 bands + RIAA + limiter", full, "-", 100.0 * full / BLOCK_NS);
+    double fast = time_blocks(config(EQ_MAX_BANDS, true, true), true);
+    printf("%-28s %10.0f %10s %8.3f%%\n", "silent fast path", fast, "-", 100.0 * fast / BLOCK_NS);
+    double decay = time_decay(config(EQ_MAX_BANDS, true, false));
+    printf("%-28s %10.0f %10s %8.3f%%\n", "decay to silence", decay, "-", 100.0 * decay / BLOCK_NS);
+
+    HT_CHECK(full < 0.2 * BLOCK_NS, "full chain %.0f ns per block, budget %.0f ns", full, 0.2 * BLOCK_NS);
+    HT_CHECK(fast < 0.5 * one_band, "fast path %.0f ns, one band costs %.0f ns", fast, one_band);
+    HT_CHECK(decay < 3.0 * ten_bands, "decay %.0f ns per block vs %.0f ns steady state", decay, ten_bands);
+    return ht_result();
+}
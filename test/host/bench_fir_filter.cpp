@@ -0,0 +1,111 @@
+// FIRFilter cost per DMA block (240 frames, 48 kHz) and latency by tap count.
+//
+// Prints, per stereo IR length, the partition count, the inline head cost
+// (two FFTs + one partition, on the capture task), the tail cost (the
+// fir_tail task's share; inline here), both as a share of the 5 ms block
+// period, the spectra memory, and the latency measured with a delta IR. Each
+// figure is the median of REPEATS runs. Fails if a regression budget is
+// exceeded:
+//   head           < 4 % of the block at every length (it must not grow
+//                  with taps)
+//   head + tail    < 5 % of the block at FIR_MAX_TAPS
+//   latency        0 frames beyond the IR's own delay
+// The budgets are loose on purpose (about ten times the current figure on a
+// desktop core, whose reference FFT is far slower than esp-dsp's): they
+// catch structural regressions, not drift.
+
+#include "host_test.h"
+#include "audio/fir_filter.h"
+#include "audio/dsp_platform.h"
+#include <algorithm>
+#include <vector>
+
+static constexpr size_t   B        = FIR_PARTITION;
+static constexpr uint32_t RATE     = 48000;
+static constexpr int      BLOCKS   = 400;
+static constexpr int      REPEATS  = 5;
+static constexpr double   BLOCK_NS = 1e9 * B / RATE;
+
+struct FirRun {
+    double head_ns;
+    double tail_ns;
+    uint32_t memory;
+    int32_t  latency;
+};
+
+static std::vector<float> noise(size_t n, uint32_t seed, float amp) {
+    std::vector<float> x(n);
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        x[i] = amp * ((float)(seed >> 8) / 8388608.0f - 1.0f);
+    }
+    return x;
+}
+
+// Frames between an input impulse and the output peak, less the IR delay
+static int32_t latency(uint32_t taps) {
+    std::vector<float> ir(taps * 2, 0.0f);
+    ir[(taps - 1) * 2] = ir[(taps - 1) * 2 + 1] = 1.0f;
+    FIRFilter::load(ir.data(), taps, 2, RATE);
+    const size_t blocks = taps / B + 3;
+    std::vector<float> x(blocks * B * 2, 0.0f);
+    x[0] = x[1] = 0.5f;
+    size_t peak = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        FIRFilter::process(x.data() + b * B * 2, B);
+    }
+    for (size_t n = 0; n < blocks * B; n++) {
+        if (fabsf(x[n * 2]) > fabsf(x[peak * 2])) peak = n;
+    }
+    return (int32_t)peak - (int32_t)(taps - 1);
+}
+
+static FirRun bench(uint32_t taps) {
+    std::vector<float> ir = noise(taps * 2, taps, 0.05f);
+    std::vector<float> block = noise(B * 2, 1, 0.3f);
+    std::vector<double> heads, tails;
+    FirRun run = {};
+    for (int r = 0; r < REPEATS; r++) {
+        FIRFilter::load(ir.data(), taps, 2, RATE);
+        double total = 0.0;
+        for (int b = 0; b < BLOCKS; b++) {
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            FIRFilter::process(block.data(), B);
+            total += (uint32_t)(esp_cpu_get_cycle_count() - t0);
+        }
+        // With no fir_tail task the tail runs inline at the end of process();
+        // the head's own average comes from the stats
+        FIRStats st;
+        FIRFilter::get_stats(&st);
+        heads.push_back(st.head_cycles_avg);
+        tails.push_back(total / BLOCKS - st.head_cycles_avg);
+        run.memory = st.memory_bytes;
+    }
+    std::sort(heads.begin(), heads.end());
+    std::sort(tails.begin(), tails.end());
+    run.head_ns = heads[REPEATS / 2];
+    run.tail_ns = std::max(0.0, tails[REPEATS / 2]);
+    run.latency = latency(taps);
+    return run;
+}
+
+int main() {
+    FIRFilter::init(RATE);
+    FIRFilter::set_enabled(true);
+
+    printf("%6s %5s %10s %8s %10s %8s %9s %8s\n", "taps", "parts", "head ns", "% block", "tail ns",
+           "% block", "memory", "latency");
+    for (uint32_t taps : {(uint32_t)B, 1024u, 2048u, FIR_MAX_TAPS}) {
+        FirRun r = bench(taps);
+        printf("%6u %5u %10.0f %7.2f%% %10.0f %7.2f%% %9u %8d\n", taps, (unsigned)((taps + B - 1) / B), r.head_ns,
+               100.0 * r.head_ns / BLOCK_NS, r.tail_ns, 100.0 * r.tail_ns / BLOCK_NS, r.memory, r.latency);
+        HT_CHECK(r.head_ns < 0.04 * BLOCK_NS, "%u taps: head at %.1f %% of the block", taps,
+                 100.0 * r.head_ns / BLOCK_NS);
+        HT_CHECK(r.latency == 0, "%u taps: %d frames of added latency", taps, r.latency);
+        if (taps == FIR_MAX_TAPS) {
+            double pct = 100.0 * (r.head_ns + r.tail_ns) / BLOCK_NS;
+            HT_CHECK(pct < 5.0, "%u taps: head + tail at %.1f %% of the block", taps, pct);
+        }
+    }
+    return ht_result();
+}
@@ -0,0 +1,107 @@
+// HLS cost per segment, with the real stream_enc and hls_seg tasks fed a
+// sample-tone capture at SPEED × real time.
+//
+// Prints, per segment length, the FLAC frames per segment, the memory one
+// segment holds (its PSRAM cache slot, and the moof + mdat actually
+// written), and the CPU time per segment: packaging (pipe → slot copies and
+// the moof), the FLAC pipe's encoding, and both as a share of one core. Each
+// figure is the segmenter's running average once SEGMENTS segments are
+// complete. Fails if a regression budget is exceeded:
+//   slot           ≤ 205 KB per second of segment at 48 kHz (verbatim FLAC
+//                  frames, the sizing hls_segmenter.h documents)
+//   packaging      < 0.03 % of a core
+//   packaging + encoding < 1.5 % of a core
+// The CPU budgets are loose on purpose (about ten times the current figure
+// on a desktop core): they catch structural regressions (a copy per byte
+// through a bounce buffer, a moof rebuilt per frame), not drift.
+//
+// Usage: bench_hls_segmenter <capture.wav>
+
+#include "host_test.h"
+#include "network/hls_segmenter.h"
+#include "network/stream_encoder.h"
+#include "network/flac_encoder.h"
+#include "audio/audio_buffer.h"
+#include "audio/dsp_platform.h"
+#include <atomic>
+
+static constexpr uint32_t RATE         = 48000;
+static constexpr uint32_t BLOCK_FRAMES = 240;
+static constexpr uint32_t SPEED        = 8;
+static constexpr uint32_t SEGMENTS     = 8;
+
+static std::vector<uint8_t> s_capture;          // Packed 24-bit stereo, cycled
+static std::atomic<bool>    s_capturing{false};
+
+// One block per 5 ms / SPEED on an absolute schedule
+static void capture_thread() {
+    const int64_t period_us = (int64_t)BLOCK_FRAMES * 1000000 / RATE / SPEED;
+    const size_t block_bytes = BLOCK_FRAMES * 6;
+    size_t pos = 0;
+    int64_t next = esp_timer_get_time();
+    while (s_capturing) {
+        next += period_us;
+        int64_t wait = next - esp_timer_get_time();
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::microseconds(wait));
+        AudioBuffer::write(&s_capture[pos], block_bytes);
+        pos = pos + 2 * block_bytes <= s_capture.size() ? pos + block_bytes : 0;
+    }
+}
+
+static bool wait_running(bool running) {
+    for (int i = 0; i < 1000 && HlsSegmenter::is_running() != running; i++) vTaskDelay(pdMS_TO_TICKS(1));
+    return HlsSegmenter::is_running() == running;
+}
+
+int main(int argc, char **argv) {
+    HtWav wav;
+    if (argc < 2 || !ht_load_wav(argv[1], &wav) || wav.channels != 2 || wav.sample_rate != RATE) {
+        fprintf(stderr, "usage: %s <capture.wav> (48 kHz stereo)\n", argv[0]);
+        return 1;
+    }
+    s_capture.resize(wav.samples.size() * 3);
+    for (size_t i = 0; i < wav.samples.size(); i++) ht_put24(&s_capture[i * 3], ht_to24(wav.samples[i]));
+
+    dsp_host_enable_tasks();
+    HT_CHECK(AudioBuffer::init(), "AudioBuffer::init failed");
+    HT_CHECK(StreamEncoder::init(RATE), "StreamEncoder::init failed");
+    HT_CHECK(HlsSegmenter::init(RATE), "HlsSegmenter::init failed");
+    s_capturing = true;
+    std::thread capture(capture_thread);
+
+    printf("%9s %7s %9s %10s %10s %12s %11s %8s\n", "segment", "frames", "slot KB", "avg KB", "max KB",
+           "package us", "encode us", "% core");
+    for (uint8_t segment_s : {HLS_MIN_SEGMENT_S, (uint8_t)2, HLS_MAX_SEGMENT_S}) {
+        HlsSegmenter::configure(true, segment_s);
+        HT_CHECK(wait_running(true), "%u s: HLS did not start", segment_s);
+
+        HlsStats stats = {};
+        for (int i = 0; i < 1000 && stats.sequence < SEGMENTS; i++) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+            HlsSegmenter::get_stats(&stats);
+        }
+        HT_CHECK(stats.sequence >= SEGMENTS, "%u s: %u segments in 20 s", segment_s, stats.sequence);
+        HT_CHECK(stats.discontinuities == 0 && stats.dropped_frames == 0,
+                 "%u s: %u discontinuities, %u dropped frames at %u x real time", segment_s,
+                 stats.discontinuities, stats.dropped_frames, SPEED);
+
+        const uint32_t frames = (segment_s * RATE + FLAC_BLOCK_FRAMES / 2) / FLAC_BLOCK_FRAMES;
+        const double slot_kb = stats.cache_bytes / 1024.0 / HLS_CACHE_SEGMENTS;
+        const double package_pct = 100.0 * stats.package_cycles_avg / (segment_s * 1e9);
+        printf("%7u s %7u %9.1f %10.1f %10.1f %12.1f %11.1f %7.3f%%\n", segment_s, frames, slot_kb,
+               stats.segment_bytes_avg / 1024.0, stats.segment_bytes_max / 1024.0,
+               stats.package_cycles_avg / 1000.0, stats.encode_cycles_avg / 1000.0, stats.core1_load_pct);
+
+        HT_CHECK(slot_kb <= 205.0 * segment_s, "%u s: %.1f KB per cache slot", segment_s, slot_kb);
+        HT_CHECK(package_pct < 0.03, "%u s: packaging %.3f %% of a core", segment_s, package_pct);
+        HT_CHECK(stats.core1_load_pct < 1.5f, "%u s: packaging and encoding %.3f %% of a core", segment_s,
+                 stats.core1_load_pct);
+
+        HlsSegmenter::configure(false, segment_s);
+        HT_CHECK(wait_running(false), "%u s: HLS did not stop", segment_s);
+    }
+
+    s_capturing = false;
+    capture.join();
+    return ht_result();
+}
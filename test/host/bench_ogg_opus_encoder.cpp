@@ -0,0 +1,94 @@
+// OggOpusEncoder encode time per frame on the sample-tone captures.
+//
+// Prints, per input and frame size (128 kbps, starting complexity), ns per
+// frame, the mean and worst frame as a share of the frame's own duration,
+// and the complexity and overrun count the cycle budget ended with. The
+// mean is the median of REPEATS passes over the whole file. On the host the
+// budget counts nanoseconds at 1 GHz (see stub/dsp_host.h), so it holds
+// OPUS_CYCLE_BUDGET_PCT of wall time. Fails if:
+//   mean   ≥ 10 % of the frame (about ten times a desktop core; the device
+//          budget is OPUS_CYCLE_BUDGET_PCT)
+//   any frame ran over budget, i.e. complexity was lowered
+//
+// Skipped (HT_SKIP) when the host build found no libopus: the encoder is
+// then the firmware's stub and available() is false.
+//
+// Usage: bench_ogg_opus_encoder <capture.wav> [<capture.wav> ...]
+
+#include "host_test.h"
+#include "network/ogg_opus_encoder.h"
+#include "audio/dsp_platform.h"
+#include <algorithm>
+
+static constexpr int      REPEATS      = 5;
+static constexpr uint16_t BITRATE_KBPS = 128;
+
+struct OpusRun {
+    double   ns_per_frame;
+    double   realtime_pct;
+    double   worst_pct;
+    uint8_t  complexity;
+    uint32_t overruns;
+};
+
+static OpusRun bench_opus(const std::vector<int16_t> &pcm, uint32_t rate, uint8_t frame_ms) {
+    static uint8_t page[OGG_OPUS_MAX_PAGE_BYTES];
+    std::vector<double> runs;
+    OpusRun run = {};
+    for (int r = 0; r < REPEATS; r++) {
+        OggOpusEncoder enc;
+        if (!enc.init(rate, frame_ms, BITRATE_KBPS, 1)) {
+            HT_CHECK(false, "init(%u Hz, %u ms) failed", rate, frame_ms);
+            return run;
+        }
+        const size_t frames = pcm.size() / 2 / enc.frame_frames;
+        uint32_t worst = 0, total = 0;
+        for (size_t f = 0; f < frames; f++) {
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            size_t len = enc.encode(pcm.data() + f * enc.frame_frames * 2, page);
+            uint32_t ns = esp_cpu_get_cycle_count() - t0;
+            HT_CHECK(len > 27, "frame %zu: encode() returned %zu bytes", f, len);
+            total += ns;
+            worst = ns > worst ? ns : worst;
+        }
+        runs.push_back((double)total / frames);
+        // Every pass starts from a fresh encoder; keep the slowest outcome
+        run.worst_pct  = std::max(run.worst_pct, 100.0 * worst / (frame_ms * 1e6));
+        run.overruns   = std::max(run.overruns, enc.overruns);
+        run.complexity = r == 0 ? enc.complexity : std::min(run.complexity, enc.complexity);
+        enc.deinit();
+    }
+    std::sort(runs.begin(), runs.end());
+    run.ns_per_frame = runs[REPEATS / 2];
+    run.realtime_pct = 100.0 * run.ns_per_frame / (frame_ms * 1e6);
+    return run;
+}
+
+int main(int argc, char **argv) {
+    if (!OggOpusEncoder::available()) {
+        printf("built without libopus: skipped\n");
+        return HT_SKIP;
+    }
+
+    printf("%-28s %5s %12s %9s %9s %10s %8s\n", "input", "frame", "ns/frame", "% of RT", "worst", "complexity",
+           "overruns");
+    for (int i = 1; i < argc; i++) {
+        HtWav wav;
+        HT_CHECK(ht_load_wav(argv[i], &wav) && wav.channels == 2, "cannot load %s", argv[i]);
+        if (wav.samples.empty()) continue;
+        const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+        std::vector<int16_t> pcm = ht_to_pcm16(wav);
+
+        for (uint8_t frame_ms : {10, 20}) {
+            OpusRun opus = bench_opus(pcm, wav.sample_rate, frame_ms);
+            printf("%-28s %3u ms %12.0f %8.3f%% %8.3f%% %10u %8u\n", name, frame_ms, opus.ns_per_frame,
+                   opus.realtime_pct, opus.worst_pct, opus.complexity, opus.overruns);
+            HT_CHECK(opus.realtime_pct < 10.0, "%s, %u ms: Opus at %.2f %% of real time", name, frame_ms,
+                     opus.realtime_pct);
+            HT_CHECK(opus.overruns == 0 && opus.complexity == OPUS_START_COMPLEXITY,
+                     "%s, %u ms: %u frames over budget, complexity down to %u", name, frame_ms, opus.overruns,
+                     opus.complexity);
+        }
+    }
+    return ht_result();
+}
@@ -0,0 +1,71 @@
+// Resampler cost per ratio, in the stream pipes' 256-frame blocks.
+//
+// Prints, per supported ratio, the taps per phase, ns per output sample and
+// the CPU time one channel-second of audio costs, also as a share of one
+// core. Each figure is the median of REPEATS runs over SECONDS of stereo
+// noise. Fails if a regression budget is exceeded:
+//   every ratio    < 1 % of a core per channel
+// The budget is loose on purpose (about ten times the current figure on a
+// desktop core): it catches structural regressions (a per-sample division,
+// a lost history window, a dot product over all L·K taps), not drift.
+
+#include "host_test.h"
+#include "audio/resampler.h"
+#include "audio/resampler_tables.h"
+#include "audio/dsp_platform.h"
+#include <algorithm>
+
+static constexpr int    REPEATS = 5;
+static constexpr size_t SECONDS = 2;
+
+struct RatioRun {
+    double ns_per_output;
+    double ns_per_channel_second;
+};
+
+static RatioRun bench(uint32_t in_rate, uint32_t out_rate) {
+    const size_t frames = in_rate * SECONDS;
+    std::vector<float> in(frames * 2);
+    uint32_t seed = 1;
+    for (float &s : in) {
+        seed = seed * 1664525u + 1013904223u;
+        s = 0.3f * ((float)(seed >> 8) / 8388608.0f - 1.0f);
+    }
+
+    Resampler rs;
+    rs.init(in_rate, out_rate);
+    std::vector<float> out(rs.max_output(RESAMPLER_MAX_FRAMES) * 2);
+    std::vector<double> runs;
+    size_t outputs = 0;
+    for (int r = 0; r < REPEATS; r++) {
+        rs.reset();
+        outputs = 0;
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        for (size_t pos = 0; pos < frames; pos += RESAMPLER_MAX_FRAMES) {
+            outputs += rs.process(in.data() + pos * 2, std::min(RESAMPLER_MAX_FRAMES, frames - pos), out.data());
+        }
+        runs.push_back((uint32_t)(esp_cpu_get_cycle_count() - t0));
+    }
+    rs.deinit();
+    std::sort(runs.begin(), runs.end());
+
+    RatioRun run;
+    run.ns_per_output = runs[REPEATS / 2] / (outputs * 2.0);
+    run.ns_per_channel_second = runs[REPEATS / 2] / (2.0 * SECONDS);
+    return run;
+}
+
+int main() {
+    static constexpr uint32_t RATIOS[][2] = {{48000, 44100}, {96000, 48000}, {96000, 44100}};
+
+    printf("%15s %5s %12s %16s %8s\n", "ratio", "taps", "ns/sample", "ns/channel-s", "% core");
+    for (const auto &r : RATIOS) {
+        const resample::RatioTable *t = resample::table_for(r[0], r[1]);
+        RatioRun run = bench(r[0], r[1]);
+        double pct = 100.0 * run.ns_per_channel_second / 1e9;
+        printf("%6u -> %5u %5u %12.2f %16.0f %7.3f%%\n", r[0], r[1], t->taps, run.ns_per_output,
+               run.ns_per_channel_second, pct);
+        HT_CHECK(pct < 1.0, "%u -> %u: %.2f %% of a core per channel", r[0], r[1], pct);
+    }
+    return ht_result();
+}
@@ -0,0 +1,85 @@
+// Stream codec cost per block and compression on the sample-tone captures.
+//
+// Prints, per codec and input, ns per encoded block, the share of the
+// block's real-time period, and the encoded size relative to 16-bit PCM.
+// Each figure is the median of REPEATS passes over the whole file. Fails if
+// a regression budget is exceeded:
+//   FLAC   < 1 % of real time, and ≤ 30 % of PCM on the captures
+//   ADPCM  < 0.5 % of real time
+// The time budgets are loose on purpose (about ten times the current figure
+// on a desktop core): they catch structural regressions (an O(n²) search,
+// a lost early-out, a compression collapse) on any host, not drift.
+//
+// Usage: bench_stream_codecs <capture.wav> [<capture.wav> ...]
+
+#include "host_test.h"
+#include "network/adpcm_encoder.h"
+#include "network/flac_encoder.h"
+#include "audio/dsp_platform.h"
+#include <algorithm>
+
+static constexpr int REPEATS = 5;
+
+struct CodecRun {
+    double ns_per_block;
+    double realtime_pct;
+    double size_pct;
+};
+
+static CodecRun bench_flac(const std::vector<int16_t> &pcm, uint32_t rate) {
+    static uint8_t frame[FLAC_MAX_FRAME_BYTES];
+    const size_t blocks = pcm.size() / 2 / FLAC_BLOCK_FRAMES;
+    std::vector<double> runs;
+    size_t bytes = 0;
+    for (int r = 0; r < REPEATS; r++) {
+        FlacEncoder enc;
+        enc.init(rate);
+        bytes = 0;
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        for (size_t b = 0; b < blocks; b++) bytes += enc.encode(pcm.data() + b * FLAC_BLOCK_FRAMES * 2, frame);
+        runs.push_back((double)(uint32_t)(esp_cpu_get_cycle_count() - t0) / blocks);
+        enc.deinit();
+    }
+    std::sort(runs.begin(), runs.end());
+    double ns = runs[REPEATS / 2];
+    return {ns, 100.0 * ns / (1e9 * FLAC_BLOCK_FRAMES / rate), 100.0 * bytes / (blocks * FLAC_BLOCK_FRAMES * 4.0)};
+}
+
+static CodecRun bench_adpcm(const std::vector<int16_t> &pcm, uint32_t rate) {
+    static uint8_t block[ADPCM_BLOCK_BYTES];
+    const size_t blocks = pcm.size() / 2 / ADPCM_BLOCK_FRAMES;
+    std::vector<double> runs;
+    for (int r = 0; r < REPEATS; r++) {
+        AdpcmEncoder enc;
+        enc.init();
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        for (size_t b = 0; b < blocks; b++) enc.encode(pcm.data() + b * ADPCM_BLOCK_FRAMES * 2, block);
+        runs.push_back((double)(uint32_t)(esp_cpu_get_cycle_count() - t0) / blocks);
+    }
+    std::sort(runs.begin(), runs.end());
+    double ns = runs[REPEATS / 2];
+    return {ns, 100.0 * ns / (1e9 * ADPCM_BLOCK_FRAMES / rate), 100.0 * ADPCM_BLOCK_BYTES / (ADPCM_BLOCK_FRAMES * 4.0)};
+}
+
+int main(int argc, char **argv) {
+    printf("%-8s %-28s %12s %9s %9s\n", "codec", "input", "ns/block", "% of RT", "% of PCM");
+    for (int i = 1; i < argc; i++) {
+        HtWav wav;
+        HT_CHECK(ht_load_wav(argv[i], &wav) && wav.channels == 2, "cannot load %s", argv[i]);
+        if (wav.samples.empty()) continue;
+        const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+        std::vector<int16_t> pcm = ht_to_pcm16(wav);
+
+        CodecRun flac = bench_flac(pcm, wav.sample_rate);
+        printf("%-8s %-28s %12.0f %8.3f%% %8.1f%%\n", "flac", name, flac.ns_per_block, flac.realtime_pct,
+               flac.size_pct);
+        HT_CHECK(flac.realtime_pct < 1.0, "%s: FLAC at %.2f %% of real time", name, flac.realtime_pct);
+        HT_CHECK(flac.size_pct <= 30.0, "%s: FLAC at %.1f %% of PCM", name, flac.size_pct);
+
+        CodecRun adpcm = bench_adpcm(pcm, wav.sample_rate);
+        printf("%-8s %-28s %12.0f %8.3f%% %8.1f%%\n", "adpcm", name, adpcm.ns_per_block, adpcm.realtime_pct,
+               adpcm.size_pct);
+        HT_CHECK(adpcm.realtime_pct < 0.5, "%s: ADPCM at %.3f %% of real time", name, adpcm.realtime_pct);
+    }
+    return ht_result();
+}
@@ -0,0 +1,191 @@
+#ifndef HOST_FLAC_H
+#define HOST_FLAC_H
+
+// Minimal FLAC frame decoder for the host tests: what a FlacEncoder frame may
+// contain for 16-bit stereo (all four channel assignments, CONSTANT /
+// VERBATIM / FIXED / LPC subframes, partitioned Rice with 4- and 5-bit
+// parameters and escapes). ht_flac_decode_frame() checks the sync code,
+// header fields, frame number, CRC-8 and CRC-16 with HT_CHECK.
+
+#include "host_test.h"
+#include "network/flac_encoder.h"
+
+struct HtBitReader {
+    const uint8_t *d;
+    size_t size;
+    size_t bit;
+    bool   overrun;
+
+    uint32_t u(int n) {
+        uint32_t v = 0;
+        for (int i = 0; i < n; i++) {
+            if ((bit >> 3) >= size) {
+                overrun = true;
+                return 0;
+            }
+            v = (v << 1) | ((d[bit >> 3] >> (7 - (bit & 7))) & 1);
+            bit++;
+        }
+        return v;
+    }
+    int32_t s(int n) {
+        uint32_t v = u(n);
+        return (n > 0 && (v >> (n - 1))) ? (int32_t)(v - (1ull << n)) : (int32_t)v;
+    }
+    uint32_t unary() {
+        uint32_t q = 0;
+        while (!overrun && u(1) == 0) q++;
+        return q;
+    }
+    void align() { bit = (bit + 7) & ~(size_t)7; }
+};
+
+inline uint8_t ht_crc8(const uint8_t *d, size_t n) {
+    uint8_t c = 0;
+    for (size_t i = 0; i < n; i++) {
+        c ^= d[i];
+        for (int b = 0; b < 8; b++) c = (uint8_t)((c & 0x80) ? (c << 1) ^ 0x07 : (c << 1));
+    }
+    return c;
+}
+
+inline uint16_t ht_crc16(const uint8_t *d, size_t n) {
+    uint16_t c = 0;
+    for (size_t i = 0; i < n; i++) {
+        c ^= (uint16_t)(d[i] << 8);
+        for (int b = 0; b < 8; b++) c = (uint16_t)((c & 0x8000) ? (c << 1) ^ 0x8005 : (c << 1));
+    }
+    return c;
+}
+
+struct HtFlacStats {
+    uint32_t constant, verbatim, fixed, lpc, escapes;
+    uint32_t assignment[16];
+};
+
+inline bool ht_flac_residual(HtBitReader &br, int32_t *out, uint32_t order, HtFlacStats *st) {
+    uint32_t method = br.u(2);
+    if (method > 1) return false;
+    int pbits = method == 0 ? 4 : 5;
+    uint32_t porder = br.u(4);
+    uint32_t pos = order;
+    for (uint32_t p = 0; p < (1u << porder); p++) {
+        uint32_t count = (FLAC_BLOCK_FRAMES >> porder) - (p == 0 ? order : 0);
+        uint32_t k = br.u(pbits);
+        if (k == (1u << pbits) - 1) {
+            // Escape: verbatim residuals of `bits` bits
+            uint32_t bits = br.u(5);
+            for (uint32_t i = 0; i < count; i++) out[pos++] = br.s((int)bits);
+            st->escapes++;
+            continue;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t v = (br.unary() << k) | br.u((int)k);
+            out[pos++] = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+        }
+    }
+    return !br.overrun && pos == FLAC_BLOCK_FRAMES;
+}
+
+inline bool ht_flac_subframe(HtBitReader &br, int32_t *x, int bps, HtFlacStats *st) {
+    if (br.u(1) != 0) return false;
+    uint32_t type = br.u(6);
+    if (br.u(1) != 0) return false;     // Wasted bits: never written
+
+    if (type == 0) {
+        int32_t v = br.s(bps);
+        for (uint32_t i = 0; i < FLAC_BLOCK_FRAMES; i++) x[i] = v;
+        st->constant++;
+    } else if (type == 1) {
+        for (uint32_t i = 0; i < FLAC_BLOCK_FRAMES; i++) x[i] = br.s(bps);
+        st->verbatim++;
+    } else if (type >= 8 && type <= 12) {
+        static const int coef[5][4] = {{0}, {1}, {2, -1}, {3, -3, 1}, {4, -6, 4, -1}};
+        uint32_t order = type - 8;
+        for (uint32_t i = 0; i < order; i++) x[i] = br.s(bps);
+        if (!ht_flac_residual(br, x, order, st)) return false;
+        for (uint32_t i = order; i < FLAC_BLOCK_FRAMES; i++) {
+            int64_t pred = 0;
+            for (uint32_t j = 0; j < order; j++) pred += (int64_t)coef[order][j] * x[i - 1 - j];
+            x[i] += (int32_t)pred;
+        }
+        st->fixed++;
+    } else if (type >= 32) {
+        uint32_t order = type - 31;
+        for (uint32_t i = 0; i < order; i++) x[i] = br.s(bps);
+        int precision = (int)br.u(4) + 1;
+        int shift = br.s(5);
+        if (precision > 15 || shift < 0) return false;
+        int32_t q[32];
+        for (uint32_t j = 0; j < order; j++) q[j] = br.s(precision);
+        if (!ht_flac_residual(br, x, order, st)) return false;
+        for (uint32_t i = order; i < FLAC_BLOCK_FRAMES; i++) {
+            int64_t pred = 0;
+            for (uint32_t j = 0; j < order; j++) pred += (int64_t)q[j] * x[i - 1 - j];
+            x[i] += (int32_t)(pred >> shift);
+        }
+        st->lpc++;
+    } else {
+        return false;
+    }
+    return !br.overrun;
+}
+
+// Decode one frame at `d` into lrlr (FLAC_BLOCK_FRAMES frames). Returns the frame length in
+// bytes, 0 on any error.
+inline size_t ht_flac_decode_frame(const uint8_t *d, size_t size, uint32_t rate, uint32_t frame_number,
+                           int16_t *lrlr, HtFlacStats *st) {
+    HtBitReader br = {d, size, 0, false};
+    if (br.u(16) != 0xFFF8) return 0;
+    uint32_t bs_code = br.u(4), rate_code = br.u(4), assignment = br.u(4), ss_code = br.u(3);
+    br.u(1);
+
+    // UTF-8 coded frame number
+    uint32_t b = br.u(8), bytes = 0, mask = 0x80;
+    while (b & mask) { bytes++; mask >>= 1; }
+    uint32_t number = b & (mask - 1);
+    for (uint32_t i = 1; i < bytes; i++) number = (number << 6) | (br.u(8) & 0x3F);
+
+    uint32_t n = bs_code == 6 ? br.u(8) + 1 : bs_code == 7 ? br.u(16) + 1 : 0;
+    uint32_t header_bytes = (uint32_t)(br.bit / 8);
+    uint8_t header_crc = (uint8_t)br.u(8);
+
+    static const uint32_t rates[16] = {0, 88200, 176400, 192000, 8000, 16000, 22050, 24000,
+                                       32000, 44100, 48000, 96000, 0, 0, 0, 0};
+    uint32_t header_rate = rate_code == 0 ? rate : rates[rate_code];
+    HT_CHECK(n == FLAC_BLOCK_FRAMES && ss_code == 4 && header_rate == rate && number == frame_number,
+             "frame %u: block %u, size code %u, rate %u (code %u), number %u", frame_number, n, ss_code,
+             header_rate, rate_code, number);
+    HT_CHECK(ht_crc8(d, header_bytes) == header_crc, "frame %u: header CRC-8 mismatch", frame_number);
+    if (n != FLAC_BLOCK_FRAMES || (assignment > 1 && assignment < 8) || assignment > 10) return 0;
+    st->assignment[assignment]++;
+
+    static int32_t a[FLAC_BLOCK_FRAMES], c[FLAC_BLOCK_FRAMES];
+    int bps_a = assignment == 9 ? 17 : 16, bps_c = (assignment == 8 || assignment == 10) ? 17 : 16;
+    if (!ht_flac_subframe(br, a, bps_a, st) || !ht_flac_subframe(br, c, bps_c, st)) return 0;
+    br.align();
+    size_t end = br.bit / 8;
+    uint16_t frame_crc = (uint16_t)br.u(16);
+    if (br.overrun) return 0;
+    HT_CHECK(ht_crc16(d, end) == frame_crc, "frame %u: CRC-16 mismatch", frame_number);
+
+    for (uint32_t i = 0; i < FLAC_BLOCK_FRAMES; i++) {
+        int32_t l, r;
+        switch (assignment) {
+            case 8:  l = a[i]; r = a[i] - c[i]; break;
+            case 9:  r = c[i]; l = a[i] + c[i]; break;
+            case 10: {
+                int32_t m = (a[i] * 2) | (c[i] & 1);
+                l = (m + c[i]) >> 1;
+                r = (m - c[i]) >> 1;
+                break;
+            }
+            default: l = a[i]; r = c[i]; break;
+        }
+        lrlr[i * 2 + 0] = (int16_t)l;
+        lrlr[i * 2 + 1] = (int16_t)r;
+    }
+    return end + 2;
+}
+
+#endif // HOST_FLAC_H
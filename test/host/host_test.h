@@ -0,0 +1,203 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Minimal helpers shared by the host tests (test/host): checks, sample
+// packing in the capture formats, WAV loading and tone fitting.
+//
+// A test is a plain executable. HT_CHECK records a failure and keeps going,
+// so one run reports every broken case; main() returns ht_result(), and a
+// test that cannot run here (missing library, no multicast on this host)
+// returns HT_SKIP, which CMake maps to a skipped test.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static constexpr int HT_SKIP = 77;
+
+inline int &ht_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define HT_CHECK(cond, ...)                                                    \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            ht_failures()++;                                                   \
+            fprintf(stderr, "FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);    \
+            fprintf(stderr, __VA_ARGS__);                                      \
+            fputc('\n', stderr);                                               \
+        }                                                                      \
+    } while (0)
+
+inline int ht_result() {
+    if (ht_failures() == 0) {
+        printf("PASS\n");
+        return 0;
+    }
+    printf("%d check(s) failed\n", ht_failures());
+    return 1;
+}
+
+inline double ht_db(double ratio) { return 20.0 * log10(ratio); }
+
+// ─── Sample formats ──────────────────────────────────────────────────────────
+
+// 24-bit value → one 32-bit MSB-aligned I²S slot (what EQProcessor reads)
+inline void ht_put_i2s(uint8_t *slot, int32_t v) {
+    slot[0] = 0;
+    slot[1] = (uint8_t)(v & 0xFF);
+    slot[2] = (uint8_t)((v >> 8) & 0xFF);
+    slot[3] = (uint8_t)((v >> 16) & 0xFF);
+}
+
+// 24-bit little-endian packed (the capture ring format)
+inline void ht_put24(uint8_t *p, int32_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    p[2] = (uint8_t)((v >> 16) & 0xFF);
+}
+
+inline int32_t ht_get24(const uint8_t *p) {
+    int32_t v = (int32_t)p[0] | ((int32_t)p[1] << 8) | ((int32_t)p[2] << 16);
+    return (v & 0x800000) ? v - 0x1000000 : v;
+}
+
+// [-1, 1) → 24-bit, rounded and saturated
+inline int32_t ht_to24(double x) {
+    long v = lrint(x * 8388608.0);
+    return (int32_t)(v > 8388607 ? 8388607 : (v < -8388608 ? -8388608 : v));
+}
+
+// ─── WAV ─────────────────────────────────────────────────────────────────────
+
+struct HtWav {
+    uint32_t sample_rate = 0;
+    uint16_t channels = 0;
+    std::vector<double> samples;    // Interleaved, [-1, 1)
+};
+
+// 16- or 24-bit PCM; skips chunks other than fmt and data
+inline bool ht_load_wav(const char *path, HtWav *wav) {
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr) return false;
+    std::vector<uint8_t> d;
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) d.insert(d.end(), buf, buf + n);
+    fclose(f);
+    if (d.size() < 12 || memcmp(d.data(), "RIFF", 4) != 0 || memcmp(d.data() + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    uint16_t bits = 0;
+    for (size_t p = 12; p + 8 <= d.size();) {
+        uint32_t size;
+        memcpy(&size, &d[p + 4], 4);
+        if (memcmp(&d[p], "fmt ", 4) == 0 && size >= 16) {
+            memcpy(&wav->channels, &d[p + 10], 2);
+            memcpy(&wav->sample_rate, &d[p + 12], 4);
+            memcpy(&bits, &d[p + 22], 2);
+        } else if (memcmp(&d[p], "data", 4) == 0) {
+            if (bits != 16 && bits != 24) return false;
+            size_t bytes = size < d.size() - p - 8 ? size : d.size() - p - 8;
+            const uint8_t *s = &d[p + 8];
+            for (size_t i = 0; i + bits / 8 <= bytes; i += bits / 8) {
+                if (bits == 16) {
+                    wav->samples.push_back((int16_t)(s[i] | (s[i + 1] << 8)) / 32768.0);
+                } else {
+                    wav->samples.push_back(ht_get24(s + i) / 8388608.0);
+                }
+            }
+            return wav->channels > 0;
+        }
+        p += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+// Samples → 16-bit, rounded and saturated (the codecs' input)
+inline std::vector<int16_t> ht_to_pcm16(const HtWav &wav) {
+    std::vector<int16_t> pcm(wav.samples.size());
+    for (size_t i = 0; i < pcm.size(); i++) {
+        long v = lrint(wav.samples[i] * 32768.0);
+        pcm[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+    return pcm;
+}
+
+// ─── Tone fitting ────────────────────────────────────────────────────────────
+
+// Least-squares fit of a·sin + b·cos + c at `freq_hz` to x[0], x[stride], ...
+// (n samples). Returns the amplitude √(a² + b²).
+inline double ht_tone_amplitude(const double *x, size_t n, size_t stride, double freq_hz, double fs) {
+    double s[3][3] = {}, r[3] = {};
+    for (size_t i = 0; i < n; i++) {
+        double w = 2.0 * M_PI * freq_hz * (double)i / fs;
+        double v[3] = {sin(w), cos(w), 1.0};
+        for (int j = 0; j < 3; j++) {
+            r[j] += v[j] * x[i * stride];
+            for (int k = 0; k < 3; k++) s[j][k] += v[j] * v[k];
+        }
+    }
+    // Gaussian elimination with partial pivoting on the 3×3 normal equations
+    double m[3][4];
+    for (int j = 0; j < 3; j++) {
+        for (int k = 0; k < 3; k++) m[j][k] = s[j][k];
+        m[j][3] = r[j];
+    }
+    for (int c = 0; c < 3; c++) {
+        int p = c;
+        for (int j = c + 1; j < 3; j++) {
+            if (fabs(m[j][c]) > fabs(m[p][c])) p = j;
+        }
+        for (int k = 0; k < 4; k++) {
+            double t = m[c][k];
+            m[c][k] = m[p][k];
+            m[p][k] = t;
+        }
+        for (int j = 0; j < 3; j++) {
+            if (j == c) continue;
+            double q = m[j][c] / m[c][c];
+            for (int k = 0; k < 4; k++) m[j][k] -= q * m[c][k];
+        }
+    }
+    double a = m[0][3] / m[0][0], b = m[1][3] / m[1][1];
+    return sqrt(a * a + b * b);
+}
+
+// Frequency of the dominant tone near `hint_hz` (±2 Hz), to 1 mHz
+inline double ht_find_tone(const double *x, size_t n, size_t stride, double hint_hz, double fs) {
+    double lo = hint_hz - 2.0, hi = hint_hz + 2.0;
+    double best = hint_hz, best_amp = 0.0;
+    for (double f = lo; f <= hi; f += 0.05) {
+        double a = ht_tone_amplitude(x, n, stride, f, fs);
+        if (a > best_amp) { best_amp = a; best = f; }
+    }
+    lo = best - 0.05;
+    hi = best + 0.05;
+    for (int it = 0; it < 40; it++) {
+        double m1 = lo + (hi - lo) * 0.382, m2 = lo + (hi - lo) * 0.618;
+        if (ht_tone_amplitude(x, n, stride, m1, fs) > ht_tone_amplitude(x, n, stride, m2, fs)) {
+            hi = m2;
+        } else {
+            lo = m1;
+        }
+    }
+    return (lo + hi) / 2.0;
+}
+
+// THD (dB) of the tone at `f0` from harmonics 2..`harmonics` below Nyquist
+inline double ht_thd_db(const double *x, size_t n, size_t stride, double f0, double fs, int harmonics = 10) {
+    double fund = ht_tone_amplitude(x, n, stride, f0, fs);
+    double sum = 0.0;
+    for (int h = 2; h <= harmonics && h * f0 < fs / 2.0; h++) {
+        double a = ht_tone_amplitude(x, n, stride, h * f0, fs);
+        sum += a * a;
+    }
+    return 10.0 * log10(sum / (fund * fund));
+}
+
+#endif // HOST_TEST_H
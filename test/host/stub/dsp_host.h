@@ -0,0 +1,314 @@
+#ifndef DSP_HOST_H
+#define DSP_HOST_H
+
+// Host (Linux) stand-ins for the ESP-IDF, FreeRTOS and esp-dsp entry points
+// the firmware's portable modules use. Every header in this directory maps
+// onto this file, so main/audio/dsp_platform.h and the modules that include
+// esp_log.h or freertos/task.h directly (AudioBuffer, RtpSender,
+// SnapcastServer, ...) compile unchanged with a plain host toolchain.
+//
+// Task creation fails by default, so modules with a helper task take their
+// inline fallback path and tests stay deterministic. A test that needs a real
+// task (a network sender) calls dsp_host_enable_tasks() first; tasks then run
+// as detached threads with working task notifications.
+//
+// The reference kernels follow the esp-dsp ANSI implementations exactly
+// (direct form II, coefficients {b0, b1, b2, a1, a2}, Audio EQ Cookbook
+// generators with normalized frequency f = Hz / Fs), so filter output matches
+// the device to float rounding. esp_cpu_get_cycle_count() counts nanoseconds
+// and CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ is 1000, so every "cycles" metric reads
+// as ns.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#ifndef DRAM_ATTR
+#define DRAM_ATTR
+#endif
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#ifndef CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 1000
+#endif
+
+typedef int esp_err_t;
+#ifndef ESP_OK
+#define ESP_OK 0
+#endif
+
+// ─── Logging ─────────────────────────────────────────────────────────────────
+
+#define DSP_HOST_LOG(level, tag, fmt, ...) fprintf(stderr, level " (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGE(tag, fmt, ...) DSP_HOST_LOG("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) DSP_HOST_LOG("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) DSP_HOST_LOG("I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do { if (0) DSP_HOST_LOG("D", tag, fmt, ##__VA_ARGS__); } while (0)
+
+// ─── Timing ──────────────────────────────────────────────────────────────────
+
+inline uint32_t esp_cpu_get_cycle_count() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+inline int64_t esp_timer_get_time() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint32_t esp_random() {
+    static std::mutex m;
+    static std::mt19937 gen{std::random_device{}()};
+    std::lock_guard<std::mutex> lock(m);
+    return gen();
+}
+
+// ─── FreeRTOS ────────────────────────────────────────────────────────────────
+
+typedef void *TaskHandle_t;
+typedef int   BaseType_t;
+typedef void (*TaskFunction_t)(void *);
+#define pdTRUE        1
+#define pdPASS        1
+#define pdFAIL        0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((uint32_t)(ms))
+
+inline void vTaskDelay(uint32_t ticks) {
+    // Host ticks are milliseconds
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+// A host task: a detached thread and its notification count
+struct DspHostTask {
+    std::mutex              m;
+    std::condition_variable cv;
+    uint32_t                notes = 0;
+};
+
+inline std::atomic<bool> &dsp_host_tasks() {
+    static std::atomic<bool> enabled{false};
+    return enabled;
+}
+inline DspHostTask *&dsp_host_current_task() {
+    thread_local DspHostTask *task = nullptr;
+    return task;
+}
+
+// Let xTaskCreatePinnedToCore() start real threads from now on
+inline void dsp_host_enable_tasks() { dsp_host_tasks().store(true); }
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *, uint32_t, void *arg,
+                                          unsigned, TaskHandle_t *handle, BaseType_t) {
+    if (!dsp_host_tasks().load()) {
+        if (handle) *handle = nullptr;
+        return pdFAIL;
+    }
+    DspHostTask *task = new DspHostTask;  // Lives as long as the process, like the task
+    if (handle) *handle = task;
+    std::thread([fn, arg, task] {
+        dsp_host_current_task() = task;
+        fn(arg);
+    }).detach();
+    return pdPASS;
+}
+inline void xTaskNotifyGive(TaskHandle_t handle) {
+    if (handle == nullptr) return;
+    DspHostTask *task = static_cast<DspHostTask *>(handle);
+    std::lock_guard<std::mutex> lock(task->m);
+    task->notes++;
+    task->cv.notify_one();
+}
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, uint32_t ticks) {
+    DspHostTask *task = dsp_host_current_task();
+    if (task == nullptr) return 0;
+    std::unique_lock<std::mutex> lock(task->m);
+    auto notified = [task] { return task->notes > 0; };
+    if (ticks == portMAX_DELAY) {
+        task->cv.wait(lock, notified);
+    } else if (!task->cv.wait_for(lock, std::chrono::milliseconds(ticks), notified)) {
+        return 0;
+    }
+    uint32_t notes = task->notes;
+    task->notes = clear ? 0 : notes - 1;
+    return notes;
+}
+inline int      xPortGetCoreID() { return 0; }
+
+typedef void *SemaphoreHandle_t;
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::mutex; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t m, uint32_t) {
+    static_cast<std::mutex *>(m)->lock();
+    return pdTRUE;
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t m) {
+    static_cast<std::mutex *>(m)->unlock();
+    return pdTRUE;
+}
+
+// ─── Heap ────────────────────────────────────────────────────────────────────
+
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+inline void *heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+inline void  heap_caps_free(void *ptr) { free(ptr); }
+
+// ─── esp-dsp reference kernels ───────────────────────────────────────────────
+
+// Stereo interleaved biquad, w = {wL0, wL1, wR0, wR1}
+inline esp_err_t dsps_biquad_sf32(const float *input, float *output, int len, float *coef, float *w) {
+    for (int i = 0; i < len; i++) {
+        float d0 = input[i * 2 + 0] - coef[3] * w[0] - coef[4] * w[1];
+        output[i * 2 + 0] = coef[0] * d0 + coef[1] * w[0] + coef[2] * w[1];
+        w[1] = w[0];
+        w[0] = d0;
+
+        float d1 = input[i * 2 + 1] - coef[3] * w[2] - coef[4] * w[3];
+        output[i * 2 + 1] = coef[0] * d1 + coef[1] * w[2] + coef[2] * w[3];
+        w[3] = w[2];
+        w[2] = d1;
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t dsps_mul_f32(const float *input1, const float *input2, float *output, int len,
+                              int step1, int step2, int step_out) {
+    for (int i = 0; i < len; i++) {
+        output[i * step_out] = input1[i * step1] * input2[i * step2];
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t dsps_dotprod_f32(const float *src1, const float *src2, float *dest, int len) {
+    float acc = 0.0f;
+    for (int i = 0; i < len; i++) {
+        acc += src1[i] * src2[i];
+    }
+    *dest = acc;
+    return ESP_OK;
+}
+
+inline esp_err_t dsps_add_f32(const float *input1, const float *input2, float *output, int len,
+                              int step1, int step2, int step_out) {
+    for (int i = 0; i < len; i++) {
+        output[i * step_out] = input1[i * step1] + input2[i * step2];
+    }
+    return ESP_OK;
+}
+
+#ifndef CONFIG_DSP_MAX_FFT_SIZE
+#define CONFIG_DSP_MAX_FFT_SIZE 4096
+#endif
+#define ESP_ERR_DSP_REINITIALIZED 0x70004
+
+inline esp_err_t dsps_fft2r_init_fc32(float *, int) { return ESP_OK; }
+
+// Complex radix-2 FFT in place (interleaved re/im), natural-order input,
+// bit-reversed output — same contract as the esp-dsp kernel
+inline esp_err_t dsps_fft2r_fc32(float *data, int N) {
+    for (int half = N / 2; half >= 1; half /= 2) {
+        for (int start = 0; start < N; start += 2 * half) {
+            for (int j = 0; j < half; j++) {
+                float ang = -2.0f * (float)M_PI * (float)(j * (N / (2 * half))) / (float)N;
+                float wr = cosf(ang), wi = sinf(ang);
+                float *a = data + (start + j) * 2;
+                float *b = data + (start + j + half) * 2;
+                float tr = a[0] - b[0], ti = a[1] - b[1];
+                a[0] += b[0];
+                a[1] += b[1];
+                b[0] = tr * wr - ti * wi;
+                b[1] = tr * wi + ti * wr;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t dsps_bit_rev_fc32(float *data, int N) {
+    for (int i = 1, j = 0; i < N; i++) {
+        int bit = N >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            float tr = data[i * 2], ti = data[i * 2 + 1];
+            data[i * 2]     = data[j * 2];
+            data[i * 2 + 1] = data[j * 2 + 1];
+            data[j * 2]     = tr;
+            data[j * 2 + 1] = ti;
+        }
+    }
+    return ESP_OK;
+}
+
+inline void dsp_host_normalize(float *coeffs, float b0, float b1, float b2,
+                               float a0, float a1, float a2) {
+    coeffs[0] = b0 / a0;
+    coeffs[1] = b1 / a0;
+    coeffs[2] = b2 / a0;
+    coeffs[3] = a1 / a0;
+    coeffs[4] = a2 / a0;
+}
+
+inline esp_err_t dsps_biquad_gen_lpf_f32(float *coeffs, float f, float qFactor) {
+    if (qFactor <= 0.0001f) qFactor = 0.0001f;
+    float w0 = 2.0f * (float)M_PI * f;
+    float c = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * qFactor);
+    dsp_host_normalize(coeffs, (1.0f - c) / 2.0f, 1.0f - c, (1.0f - c) / 2.0f,
+                       1.0f + alpha, -2.0f * c, 1.0f - alpha);
+    return ESP_OK;
+}
+
+inline esp_err_t dsps_biquad_gen_hpf_f32(float *coeffs, float f, float qFactor) {
+    if (qFactor <= 0.0001f) qFactor = 0.0001f;
+    float w0 = 2.0f * (float)M_PI * f;
+    float c = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * qFactor);
+    dsp_host_normalize(coeffs, (1.0f + c) / 2.0f, -(1.0f + c), (1.0f + c) / 2.0f,
+                       1.0f + alpha, -2.0f * c, 1.0f - alpha);
+    return ESP_OK;
+}
+
+inline esp_err_t dsps_biquad_gen_lowShelf_f32(float *coeffs, float f, float gain, float qFactor) {
+    float A = sqrtf(powf(10.0f, gain / 20.0f));
+    float w0 = 2.0f * (float)M_PI * f;
+    float c = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * qFactor);
+    float sa = 2.0f * sqrtf(A) * alpha;
+    dsp_host_normalize(coeffs,
+                       A * ((A + 1.0f) - (A - 1.0f) * c + sa),
+                       2.0f * A * ((A - 1.0f) - (A + 1.0f) * c),
+                       A * ((A + 1.0f) - (A - 1.0f) * c - sa),
+                       (A + 1.0f) + (A - 1.0f) * c + sa,
+                       -2.0f * ((A - 1.0f) + (A + 1.0f) * c),
+                       (A + 1.0f) + (A - 1.0f) * c - sa);
+    return ESP_OK;
+}
+
+inline esp_err_t dsps_biquad_gen_highShelf_f32(float *coeffs, float f, float gain, float qFactor) {
+    float A = sqrtf(powf(10.0f, gain / 20.0f));
+    float w0 = 2.0f * (float)M_PI * f;
+    float c = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * qFactor);
+    float sa = 2.0f * sqrtf(A) * alpha;
+    dsp_host_normalize(coeffs,
+                       A * ((A + 1.0f) + (A - 1.0f) * c + sa),
+                       -2.0f * A * ((A - 1.0f) + (A + 1.0f) * c),
+                       A * ((A + 1.0f) + (A - 1.0f) * c - sa),
+                       (A + 1.0f) - (A - 1.0f) * c + sa,
+                       2.0f * ((A - 1.0f) - (A + 1.0f) * c),
+                       (A + 1.0f) - (A - 1.0f) * c - sa);
+    return ESP_OK;
+}
+
+#endif // DSP_HOST_H
@@ -0,0 +1,3 @@
+#pragma once
+// Host build: ESP-IDF header mapped onto the host stand-ins
+#include "../dsp_host.h"
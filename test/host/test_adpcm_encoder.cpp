@@ -0,0 +1,177 @@
+// AdpcmEncoder block layout and reconstruction error.
+//
+//   layout       header (first sample LE, step index, reserved 0) per
+//                channel, then groups of 8 samples: 4 bytes left, 4 bytes
+//                right, low nibble first. A hand-computed step input pins
+//                the first nibbles and the step index carried to the next
+//                block.
+//   error        a standard IMA decoder (shift-add reconstruction, as in the
+//                Microsoft/IMA reference) rebuilds the signal: a -6 dBFS
+//                1 kHz sine and both sample-tone captures must keep their
+//                SNR above the limits below, block headers must restart the
+//                predictor exactly.
+//
+// Usage: test_adpcm_encoder <capture.wav> [<capture.wav> ...]
+
+#include "host_test.h"
+#include "network/adpcm_encoder.h"
+
+static constexpr uint32_t FRAMES = ADPCM_BLOCK_FRAMES;
+// Measured 37.3 dB (the first block spends a few samples ramping the step
+// size up from index 0) and 38.9 / 46.6 dB on the captures
+static constexpr double   SINE_MIN_SNR_DB    = 36.0;
+static constexpr double   CAPTURE_MIN_SNR_DB = 37.0;
+
+// ─── Decoder ─────────────────────────────────────────────────────────────────
+
+static const int16_t STEPS[89] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static int16_t decode_nibble(uint8_t nib, int32_t &pred, int32_t &index) {
+    static const int8_t adjust[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+    int32_t step = STEPS[index];
+    int32_t diff = step >> 3;
+    if (nib & 4) diff += step;
+    if (nib & 2) diff += step >> 1;
+    if (nib & 1) diff += step >> 2;
+    pred += (nib & 8) ? -diff : diff;
+    pred = pred > 32767 ? 32767 : (pred < -32768 ? -32768 : pred);
+    index += adjust[nib & 7];
+    index = index < 0 ? 0 : (index > 88 ? 88 : index);
+    return (int16_t)pred;
+}
+
+// One block → FRAMES interleaved stereo frames; returns the header step
+// indices through `index`
+static void decode_block(const uint8_t *in, int16_t *lrlr, uint8_t index[2]) {
+    int32_t pred[2], idx[2];
+    for (int c = 0; c < 2; c++) {
+        pred[c] = (int16_t)(in[c * 4] | (in[c * 4 + 1] << 8));
+        idx[c] = in[c * 4 + 2];
+        index[c] = in[c * 4 + 2];
+        lrlr[c] = (int16_t)pred[c];
+    }
+    const uint8_t *src = in + 8;
+    for (uint32_t group = 0; group < (FRAMES - 1) / 8; group++) {
+        for (int c = 0; c < 2; c++) {
+            for (int k = 0; k < 8; k += 2) {
+                uint8_t b = *src++;
+                lrlr[(1 + group * 8 + k) * 2 + c]     = decode_nibble(b & 0x0F, pred[c], idx[c]);
+                lrlr[(1 + group * 8 + k + 1) * 2 + c] = decode_nibble(b >> 4, pred[c], idx[c]);
+            }
+        }
+    }
+}
+
+// ─── Layout ──────────────────────────────────────────────────────────────────
+
+static void test_layout() {
+    HT_CHECK(FRAMES == 505 && ADPCM_BLOCK_BYTES == 512, "block is %u frames in %u bytes", FRAMES,
+             ADPCM_BLOCK_BYTES);
+
+    // L: 0, a step to 1000, then ±20000 over the last 16 frames (the step
+    // index ends high); R: constant -1234
+    static int16_t pcm[FRAMES * 2];
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        pcm[i * 2 + 0] = i == 0 ? 0 : (i < FRAMES - 16 ? 1000 : (i % 2 ? 20000 : -20000));
+        pcm[i * 2 + 1] = -1234;
+    }
+    AdpcmEncoder enc;
+    enc.init();
+    uint8_t block[ADPCM_BLOCK_BYTES];
+    HT_CHECK(enc.encode(pcm, block) == ADPCM_BLOCK_BYTES, "encode() size");
+
+    // Headers: first sample little-endian, step index 0 after init(), reserved 0
+    HT_CHECK(block[0] == 0x00 && block[1] == 0x00 && block[2] == 0 && block[3] == 0,
+             "left header %02X %02X %02X %02X", block[0], block[1], block[2], block[3]);
+    HT_CHECK(block[4] == 0x2E && block[5] == 0xFB && block[6] == 0 && block[7] == 0,
+             "right header %02X %02X %02X %02X", block[4], block[5], block[6], block[7]);
+
+    // First left group: step 7 → nibble 7 (diff 11, index 8); step 16 →
+    // nibble 7 (diff 30, index 16), packed low nibble first
+    HT_CHECK(block[8] == 0x77, "first left byte %02X, want 77", block[8]);
+    // Right is constant: every delta is 0, every nibble 0, index stays 0
+    bool right_zero = true;
+    for (uint32_t g = 0; g < (FRAMES - 1) / 8; g++) {
+        for (int k = 0; k < 4; k++) right_zero &= block[8 + g * 8 + 4 + k] == 0;
+    }
+    HT_CHECK(right_zero, "constant right channel coded non-zero nibbles");
+
+    int16_t out[FRAMES * 2];
+    uint8_t index[2];
+    decode_block(block, out, index);
+    HT_CHECK(out[2] == 11 && out[4] == 41, "step response starts %d, %d; want 11, 41", out[2], out[4]);
+    HT_CHECK(abs(out[(FRAMES - 17) * 2] - 1000) < 8, "step settles at %d, want 1000", out[(FRAMES - 17) * 2]);
+
+    // The step index carries into the next block's header; the first sample
+    // restarts the predictor
+    HT_CHECK(enc.index[0] > 40 && enc.index[1] == 0, "indices after the block %u/%u", enc.index[0], enc.index[1]);
+    uint8_t carried = enc.index[0];
+    enc.encode(pcm, block);
+    HT_CHECK(block[2] == carried && block[6] == 0, "second block header indices %u/%u, want %u/0", block[2],
+             block[6], carried);
+}
+
+// ─── Reconstruction error ────────────────────────────────────────────────────
+
+// Encode, decode, return the SNR (dB) of the reconstruction; checks that
+// every block header holds its first input frame exactly
+static double snr_db(const char *name, const std::vector<int16_t> &pcm) {
+    AdpcmEncoder enc;
+    enc.init();
+    const size_t blocks = pcm.size() / 2 / FRAMES;
+    uint8_t block[ADPCM_BLOCK_BYTES];
+    int16_t out[FRAMES * 2];
+    uint8_t index[2];
+    double sig = 0.0, err = 0.0;
+    int32_t worst = 0;
+    size_t header_errors = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        const int16_t *in = pcm.data() + b * FRAMES * 2;
+        enc.encode(in, block);
+        decode_block(block, out, index);
+        header_errors += out[0] != in[0] || out[1] != in[1];
+        for (uint32_t i = 0; i < FRAMES * 2; i++) {
+            double e = (double)out[i] - in[i];
+            sig += (double)in[i] * in[i];
+            err += e * e;
+            if (abs(out[i] - in[i]) > worst) worst = abs(out[i] - in[i]);
+        }
+    }
+    HT_CHECK(header_errors == 0, "%s: %zu block headers do not restart at the input", name, header_errors);
+    double snr = 10.0 * log10(sig / (err > 0.0 ? err : 1e-30));
+    printf("%-28s %5zu blocks, SNR %5.1f dB, worst sample error %d\n", name, blocks, snr, worst);
+    return snr;
+}
+
+int main(int argc, char **argv) {
+    test_layout();
+
+    std::vector<int16_t> pcm(FRAMES * 100 * 2);
+    for (size_t i = 0; i < pcm.size() / 2; i++) {
+        double w = 2.0 * M_PI * 1000.0 * (double)i / 48000.0;
+        pcm[i * 2 + 0] = (int16_t)lrint(16384.0 * sin(w));
+        pcm[i * 2 + 1] = (int16_t)lrint(16384.0 * cos(w));
+    }
+    double sine = snr_db("1 kHz sine, -6 dBFS", pcm);
+    HT_CHECK(sine > SINE_MIN_SNR_DB, "1 kHz sine SNR %.1f dB, want > %.0f dB", sine, SINE_MIN_SNR_DB);
+
+    for (int i = 1; i < argc; i++) {
+        HtWav wav;
+        HT_CHECK(ht_load_wav(argv[i], &wav) && wav.channels == 2, "cannot load %s", argv[i]);
+        if (wav.samples.empty()) continue;
+        const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+        double snr = snr_db(name, ht_to_pcm16(wav));
+        HT_CHECK(snr > CAPTURE_MIN_SNR_DB, "%s SNR %.1f dB, want > %.0f dB", name, snr, CAPTURE_MIN_SNR_DB);
+    }
+    return ht_result();
+}
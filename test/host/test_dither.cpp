@@ -0,0 +1,181 @@
+// Ditherer against the error statistics promised in dither.h.
+//
+// The error is e = 256·y − x in LSB24 units, reported in 16-bit LSBs.
+//
+//   mean          for constant inputs at every sub-LSB offset, every
+//                 dithered mode has zero mean error (|mean| < 0.01 LSB):
+//                 requantization adds no DC and no level-dependent bias
+//   modulation    TPDF error rms is 0.5 LSB at every offset (spread
+//                 < 0.2 dB), where plain rounding swings from 0 to 0.5
+//   spectrum      on a −60 dBFS tone, the error's power and neighbour
+//                 correlations match the noise transfer function:
+//                   TPDF  0.25 LSB², white, flat band to band
+//                   NS1   ×2 (+3 dB), ρ1 = −1/2, 0–2 kHz ≥ 15 dB below flat
+//                   NS2   ×6 (+7.8 dB), ρ1 = −2/3, ρ2 = 1/6, 0–2 kHz ≥ 28 dB down
+//                 and L and R errors are uncorrelated
+//   paths         process_f32 gives the same bytes as process_s24
+//   overload      NS2 at full scale clips cleanly and settles on silence
+
+#include "host_test.h"
+#include "audio/dither.h"
+#include <algorithm>
+#include <vector>
+
+static constexpr uint32_t RATE   = 48000;
+static constexpr size_t   FRAMES = 96000;
+static constexpr size_t   BLOCK  = 256;
+
+static const DitherMode DITHERED[] = {DitherMode::TPDF, DitherMode::TPDF_NS1, DitherMode::TPDF_NS2};
+
+// Requantize `x` (24-bit, interleaved stereo) and return the error per
+// sample in 16-bit LSBs
+static std::vector<double> error(DitherMode mode, const std::vector<int32_t> &x) {
+    Ditherer d;
+    d.init(mode, 12345);
+    std::vector<uint8_t> in(x.size() * 3), out(x.size() * 2);
+    for (size_t i = 0; i < x.size(); i++) ht_put24(&in[i * 3], x[i]);
+    for (size_t f = 0; f < x.size() / 2; f += BLOCK) {
+        size_t n = std::min(BLOCK, x.size() / 2 - f);
+        d.process_s24(&in[f * 6], &out[f * 4], n);
+    }
+    std::vector<double> e(x.size());
+    for (size_t i = 0; i < x.size(); i++) {
+        int16_t y = (int16_t)(out[i * 2] | (out[i * 2 + 1] << 8));
+        e[i] = (256.0 * y - x[i]) / 256.0;
+    }
+    return e;
+}
+
+static double mean(const std::vector<double> &e, int ch) {
+    double s = 0.0;
+    for (size_t i = ch; i < e.size(); i += 2) s += e[i];
+    return s / (e.size() / 2);
+}
+
+// Normalised correlation of channel a at n with channel b at n − lag
+static double corr(const std::vector<double> &e, int a, int b, size_t lag) {
+    double ma = mean(e, a), mb = mean(e, b), s = 0.0, va = 0.0, vb = 0.0;
+    for (size_t n = lag; n < e.size() / 2; n++) {
+        double u = e[n * 2 + a] - ma, v = e[(n - lag) * 2 + b] - mb;
+        s += u * v;
+        va += u * u;
+        vb += v * v;
+    }
+    return s / sqrt(va * vb);
+}
+
+static double variance(const std::vector<double> &e, int ch) {
+    double m = mean(e, ch), s = 0.0;
+    for (size_t i = ch; i < e.size(); i += 2) s += (e[i] - m) * (e[i] - m);
+    return s / (e.size() / 2);
+}
+
+// Mean error power per DFT bin over [lo, hi) Hz (1 Hz bins, every 10th),
+// channel L, first RATE frames
+static double band_power(const std::vector<double> &e, double lo, double hi) {
+    double sum = 0.0;
+    int bins = 0;
+    for (double f = lo; f < hi; f += 10.0) {
+        double re = 0.0, im = 0.0;
+        for (size_t n = 0; n < RATE; n++) {
+            double w = 2.0 * M_PI * f * (double)n / RATE;
+            re += e[n * 2] * cos(w);
+            im -= e[n * 2] * sin(w);
+        }
+        sum += (re * re + im * im) / RATE;
+        bins++;
+    }
+    return sum / bins;
+}
+
+static void test_mean_and_modulation() {
+    double rms_lo = 1e9, rms_hi = 0.0, worst_mean = 0.0, round_hi = 0.0;
+    for (int32_t offset = 0; offset < 256; offset += 8) {
+        std::vector<int32_t> x(FRAMES / 4 * 2, 1000 * 256 + offset);
+        for (DitherMode mode : DITHERED) {
+            std::vector<double> e = error(mode, x);
+            for (int ch = 0; ch < 2; ch++) worst_mean = std::max(worst_mean, fabs(mean(e, ch)));
+            if (mode == DitherMode::TPDF) {
+                double rms = sqrt(variance(e, 0) + mean(e, 0) * mean(e, 0));
+                rms_lo = std::min(rms_lo, rms);
+                rms_hi = std::max(rms_hi, rms);
+            }
+        }
+        round_hi = std::max(round_hi, fabs(error(DitherMode::OFF, x)[0]));
+    }
+    printf("mean error: worst %.4f LSB; TPDF rms %.3f-%.3f LSB over offsets (rounding 0-%.2f)\n", worst_mean,
+           rms_lo, rms_hi, round_hi);
+    HT_CHECK(worst_mean < 0.01, "dithered error has a mean of %.4f LSB", worst_mean);
+    HT_CHECK(ht_db(rms_hi / rms_lo) < 0.2, "TPDF error rms varies %.3f-%.3f LSB with the input level", rms_lo,
+             rms_hi);
+    HT_CHECK(fabs(rms_lo - 0.5) < 0.02 && fabs(rms_hi - 0.5) < 0.02, "TPDF error rms %.3f-%.3f, want 0.5 LSB",
+             rms_lo, rms_hi);
+}
+
+static void test_spectrum() {
+    std::vector<int32_t> x(FRAMES * 2);
+    for (size_t n = 0; n < FRAMES; n++) {
+        x[n * 2 + 0] = ht_to24(0.001 * sin(2.0 * M_PI * 1000.0 * n / RATE));
+        x[n * 2 + 1] = ht_to24(0.001 * sin(2.0 * M_PI * 1300.0 * n / RATE));
+    }
+    struct Expect { DitherMode mode; double gain; double rho1; double rho2; double low_db; };
+    const Expect expect[] = {
+        {DitherMode::TPDF,     1.0, 0.0,        0.0,       0.0},
+        {DitherMode::TPDF_NS1, 2.0, -0.5,       0.0,       -15.0},
+        {DitherMode::TPDF_NS2, 6.0, -2.0 / 3.0, 1.0 / 6.0, -28.0},
+    };
+    for (const Expect &ex : expect) {
+        std::vector<double> e = error(ex.mode, x);
+        double var = variance(e, 0), rho1 = corr(e, 0, 0, 1), rho2 = corr(e, 0, 0, 2), lr = corr(e, 0, 1, 0);
+        double flat = 0.25;     // Per-bin power of the unshaped error
+        double low = ht_db(sqrt(band_power(e, 10.0, 2000.0) / flat));
+        double high = ht_db(sqrt(band_power(e, 16000.0, 20000.0) / flat));
+        printf("%-8s power %.3f LSB2 (x%.2f)  rho1 %+.3f  rho2 %+.3f  L/R %+.3f  0-2 kHz %+.1f dB  "
+               "16-20 kHz %+.1f dB\n", dither_mode_to_str(ex.mode), var, var / 0.25, rho1, rho2, lr, low, high);
+        HT_CHECK(fabs(var / 0.25 / ex.gain - 1.0) < 0.05, "%s: error power x%.2f, want x%.0f",
+                 dither_mode_to_str(ex.mode), var / 0.25, ex.gain);
+        HT_CHECK(fabs(rho1 - ex.rho1) < 0.02 && fabs(rho2 - ex.rho2) < 0.02, "%s: rho1 %.3f rho2 %.3f",
+                 dither_mode_to_str(ex.mode), rho1, rho2);
+        HT_CHECK(fabs(lr) < 0.02, "%s: L/R errors correlated (%.3f)", dither_mode_to_str(ex.mode), lr);
+        if (ex.mode == DitherMode::TPDF) {
+            HT_CHECK(fabs(low) < 1.0 && fabs(high) < 1.0, "TPDF spectrum not flat: %+.1f / %+.1f dB", low, high);
+        } else {
+            HT_CHECK(low <= ex.low_db, "%s: 0-2 kHz only %.1f dB below flat", dither_mode_to_str(ex.mode), low);
+        }
+    }
+}
+
+static void test_paths() {
+    std::vector<float> f(BLOCK * 2);
+    std::vector<uint8_t> s24(BLOCK * 6), a(BLOCK * 4), b(BLOCK * 4);
+    for (size_t i = 0; i < f.size(); i++) {
+        int32_t v = ht_to24(0.7 * sin(0.01 * i + (i & 1)));
+        f[i] = v / 8388608.0f;
+        ht_put24(&s24[i * 3], v);
+    }
+    for (DitherMode mode : {DitherMode::OFF, DitherMode::TPDF, DitherMode::TPDF_NS1, DitherMode::TPDF_NS2}) {
+        Ditherer da, db;
+        da.init(mode, 7);
+        db.init(mode, 7);
+        da.process_s24(s24.data(), a.data(), BLOCK);
+        db.process_f32(f.data(), b.data(), BLOCK);
+        HT_CHECK(a == b, "%s: process_f32 differs from process_s24", dither_mode_to_str(mode));
+    }
+}
+
+static void test_overload() {
+    std::vector<int32_t> x(BLOCK * 8 * 2, 8388607);
+    std::fill(x.begin() + x.size() / 2, x.end(), 0);
+    std::vector<double> e = error(DitherMode::TPDF_NS2, x);
+    double tail = 0.0;
+    for (size_t i = x.size() - BLOCK * 2; i < x.size(); i++) tail = std::max(tail, fabs(e[i]));
+    HT_CHECK(tail <= 4.0, "NS2 still %.1f LSB off a block after leaving full scale", tail);
+}
+
+int main() {
+    test_mean_and_modulation();
+    test_spectrum();
+    test_paths();
+    test_overload();
+    return ht_result();
+}
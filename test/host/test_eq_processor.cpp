@@ -0,0 +1,523 @@
+// EQProcessor / EQResponse against a double-precision reference.
+//
+//   magnitude   every EQFilterType: float coefficients vs the Audio EQ
+//               Cookbook in double precision, steady-state sine gain through
+//               process() vs |H| of those coefficients; EQResponse curve
+//   stability   every type over the full parameter range at 44.1/48/96 kHz:
+//               poles inside the unit circle, impulse response decays
+//   thd         sample-tone/capture-440hz-sine.wav through a 4-band EQ: THD
+//               matches the double reference, float path rounding noise
+//               stays at its measured level
+//   pack/clip   24-bit round trip, hard clip without wrap-around, bypass
+//   silence     fast path only for digital silence (24-bit noise survives);
+//               a transient waiting in the limiter lookahead is emitted once,
+//               neither dropped on fast-path entry nor replayed after it
+//   phono       the phono stages process() runs are the compile-time set for
+//               the live rate, and a rate change seen by update_band()
+//               rebuilds them along with the bands
+//
+// Usage: test_eq_processor <capture-440hz-sine.wav>
+
+#include "host_test.h"
+#include "audio/eq_processor.h"
+#include "audio/eq_response.h"
+#include "audio/phono_filters.h"
+#include "audio/peak_limiter.h"
+#include <complex>
+#include <vector>
+
+static constexpr size_t BLOCK = EQ_FRAMES_PER_BLOCK;
+
+// ─── Reference ───────────────────────────────────────────────────────────────
+
+struct RefBiquad {
+    double b0, b1, b2, a1, a2;   // Normalized (a0 = 1)
+};
+
+// Audio EQ Cookbook in double precision, with EQProcessor's parameter clamps
+static RefBiquad reference(const EQBandConfig &band, double fs) {
+    double f = band.frequency_hz < 20.0f ? 20.0 : band.frequency_hz;
+    if (f > fs * EQ_MAX_FREQ_RATIO) f = fs * EQ_MAX_FREQ_RATIO;
+    double gain = band.gain_db < -24.0f ? -24.0 : (band.gain_db > 24.0f ? 24.0 : band.gain_db);
+    double q = band.q_factor < 0.1f ? 0.1 : (band.q_factor > 10.0f ? 10.0 : band.q_factor);
+    double A = pow(10.0, gain / 40.0);
+    double w0 = 2.0 * M_PI * f / fs, c = cos(w0), alpha = sin(w0) / (2.0 * q);
+    double b0, b1, b2, a0, a1, a2;
+    switch (band.filter_type) {
+        case EQFilterType::LOW_SHELF: {
+            double sa = 2.0 * sqrt(A) * alpha;
+            b0 = A * ((A + 1) - (A - 1) * c + sa);
+            b1 = 2 * A * ((A - 1) - (A + 1) * c);
+            b2 = A * ((A + 1) - (A - 1) * c - sa);
+            a0 = (A + 1) + (A - 1) * c + sa;
+            a1 = -2 * ((A - 1) + (A + 1) * c);
+            a2 = (A + 1) + (A - 1) * c - sa;
+            break;
+        }
+        case EQFilterType::HIGH_SHELF: {
+            double sa = 2.0 * sqrt(A) * alpha;
+            b0 = A * ((A + 1) + (A - 1) * c + sa);
+            b1 = -2 * A * ((A - 1) + (A + 1) * c);
+            b2 = A * ((A + 1) + (A - 1) * c - sa);
+            a0 = (A + 1) - (A - 1) * c + sa;
+            a1 = 2 * ((A - 1) - (A + 1) * c);
+            a2 = (A + 1) - (A - 1) * c - sa;
+            break;
+        }
+        case EQFilterType::LOW_PASS:
+            b0 = (1 - c) / 2; b1 = 1 - c; b2 = (1 - c) / 2;
+            a0 = 1 + alpha; a1 = -2 * c; a2 = 1 - alpha;
+            break;
+        case EQFilterType::HIGH_PASS:
+            b0 = (1 + c) / 2; b1 = -(1 + c); b2 = (1 + c) / 2;
+            a0 = 1 + alpha; a1 = -2 * c; a2 = 1 - alpha;
+            break;
+        case EQFilterType::PEAKING:
+        default:
+            b0 = 1 + alpha * A; b1 = -2 * c; b2 = 1 - alpha * A;
+            a0 = 1 + alpha / A; a1 = -2 * c; a2 = 1 - alpha / A;
+            break;
+    }
+    return {b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+}
+
+static double ref_gain_db(const std::vector<RefBiquad> &cascade, double f, double fs) {
+    std::complex<double> z1 = std::polar(1.0, -2.0 * M_PI * f / fs), z2 = z1 * z1, h = 1.0;
+    for (const RefBiquad &q : cascade) {
+        h *= (q.b0 + q.b1 * z1 + q.b2 * z2) / (1.0 + q.a1 * z1 + q.a2 * z2);
+    }
+    return 20.0 * log10(std::abs(h));
+}
+
+// ─── Driving EQProcessor ─────────────────────────────────────────────────────
+
+static DeviceConfig eq_config(const EQBandConfig *bands, uint8_t count) {
+    DeviceConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.eq_enabled = true;
+    for (uint8_t b = 0; b < count; b++) cfg.eq_bands[b] = bands[b];
+    cfg.phono_curve = PhonoCurve::OFF;
+    return cfg;
+}
+
+// The float coefficients process() is running, widened to double
+static std::vector<RefBiquad> active_cascade() {
+    float coef[EQ_MAX_BANDS][5];
+    uint8_t stages = EQProcessor::copy_active_coefs(coef, EQ_MAX_BANDS);
+    std::vector<RefBiquad> cascade;
+    for (uint8_t s = 0; s < stages; s++) {
+        cascade.push_back({coef[s][0], coef[s][1], coef[s][2], coef[s][3], coef[s][4]});
+    }
+    return cascade;
+}
+
+// Run interleaved stereo `in` ([-1, 1)) through process(); `out` gets the
+// 24-bit output as doubles. Returns false if process() bypassed any block.
+static bool run_eq(const std::vector<double> &in, std::vector<double> *out) {
+    size_t frames = in.size() / 2;
+    out->assign(frames * 2, 0.0);
+    uint8_t i2s[BLOCK * 8], packed[BLOCK * 6];
+    bool filtered = true;
+    for (size_t pos = 0; pos < frames; pos += BLOCK) {
+        size_t n = frames - pos < BLOCK ? frames - pos : BLOCK;
+        for (size_t i = 0; i < n; i++) {
+            ht_put_i2s(i2s + i * 8 + 0, ht_to24(in[(pos + i) * 2 + 0]));
+            ht_put_i2s(i2s + i * 8 + 4, ht_to24(in[(pos + i) * 2 + 1]));
+        }
+        filtered &= EQProcessor::process(i2s, packed, n);
+        for (size_t i = 0; i < n; i++) {
+            (*out)[(pos + i) * 2 + 0] = ht_get24(packed + i * 6 + 0) / 8388608.0;
+            (*out)[(pos + i) * 2 + 1] = ht_get24(packed + i * 6 + 3) / 8388608.0;
+        }
+    }
+    return filtered;
+}
+
+static std::vector<double> sine(double freq, double amp, double fs, size_t frames) {
+    std::vector<double> x(frames * 2);
+    for (size_t i = 0; i < frames; i++) {
+        x[i * 2] = x[i * 2 + 1] = amp * sin(2.0 * M_PI * freq * (double)i / fs);
+    }
+    return x;
+}
+
+// ─── Magnitude ───────────────────────────────────────────────────────────────
+
+static void test_magnitude() {
+    static const EQFilterType types[] = {EQFilterType::PEAKING, EQFilterType::LOW_SHELF,
+                                         EQFilterType::HIGH_SHELF, EQFilterType::LOW_PASS,
+                                         EQFilterType::HIGH_PASS};
+    static const EQBandConfig shapes[] = {
+        {true, EQFilterType::PEAKING, 100.0f,   12.0f, 0.707f},
+        {true, EQFilterType::PEAKING, 1000.0f,  -9.0f, 2.0f},
+        {true, EQFilterType::PEAKING, 8000.0f,   6.0f, 4.0f},
+    };
+    static const double probes[] = {31.5, 63, 125, 250, 500, 1000, 2000, 4000, 8000, 12500, 16000, 20000};
+    static const double rates[] = {44100, 48000, 96000};
+
+    double worst = 0.0, worst_coef = 0.0;
+    for (double fs : rates) {
+        for (EQFilterType type : types) {
+            for (EQBandConfig band : shapes) {
+                band.filter_type = type;
+                DeviceConfig cfg = eq_config(&band, 1);
+                std::vector<RefBiquad> ref = {reference(band, fs)};
+                EQProcessor::init(cfg, (uint32_t)fs);
+                std::vector<RefBiquad> used = active_cascade();
+
+                for (double f : probes) {
+                    if (f >= fs / 2.0 * 0.95) continue;
+                    double want = ref_gain_db(ref, f, fs);
+                    // Below -60 dB the 24-bit floor of a -26 dBFS probe dominates
+                    if (want < -60.0) continue;
+
+                    // Coefficients: float generators vs the double cookbook. Low
+                    // corners at 96 kHz are the most sensitive (≈0.05 dB).
+                    double coef_err = fabs(ref_gain_db(used, f, fs) - want);
+                    if (coef_err > worst_coef) worst_coef = coef_err;
+                    HT_CHECK(coef_err < 0.1, "%s %.0f Hz %+.0f dB Q%.2f @ %.0f Hz, fs %.0f: coefficients give %.4f dB, want %.4f dB",
+                             eq_filter_type_to_str(type), band.frequency_hz, band.gain_db, band.q_factor,
+                             f, fs, ref_gain_db(used, f, fs), want);
+
+                    // Arithmetic: process() against its own coefficients. 0.5 s
+                    // to settle, then fit over the next 0.25 s.
+                    EQProcessor::init(cfg, (uint32_t)fs);
+                    const double amp = 0.05;
+                    size_t settle = (size_t)(fs / 2), fit = (size_t)(fs / 4);
+                    std::vector<double> out;
+                    run_eq(sine(f, amp, fs, settle + fit), &out);
+                    double got = ht_db(ht_tone_amplitude(out.data() + settle * 2, fit, 2, f, fs) / amp);
+                    double err = fabs(got - ref_gain_db(used, f, fs));
+                    if (err > worst) worst = err;
+                    HT_CHECK(err < 0.02, "%s %.0f Hz %+.0f dB Q%.2f @ %.0f Hz, fs %.0f: %.4f dB, coefficients give %.4f dB",
+                             eq_filter_type_to_str(type), band.frequency_hz, band.gain_db, band.q_factor,
+                             f, fs, got, ref_gain_db(used, f, fs));
+                }
+            }
+        }
+    }
+    printf("magnitude: coefficients within %.4f dB of the reference, process() within %.4f dB of its coefficients\n",
+           worst_coef, worst);
+
+    // EQResponse evaluates the running cascade in float for the UI curve;
+    // 1 + a1·cos w + a2·cos 2w cancels below the low corners, so allow 0.1 dB
+    EQBandConfig bands[3] = {
+        {true, EQFilterType::LOW_SHELF,  120.0f,  6.0f, 0.707f},
+        {true, EQFilterType::PEAKING,   2500.0f, -4.0f, 1.4f},
+        {true, EQFilterType::HIGH_PASS,   30.0f,  0.0f, 0.707f},
+    };
+    DeviceConfig cfg = eq_config(bands, 3);
+    EQProcessor::init(cfg, 48000);
+    std::vector<RefBiquad> used = active_cascade();
+    EQResponseView view;
+    HT_CHECK(EQResponse::get(128, &view), "EQResponse::get failed");
+    HT_CHECK(view.stages == 3, "EQResponse evaluated %u stages, want 3", view.stages);
+    double worst_response = 0.0, worst_at = 0.0;
+    for (uint16_t i = 0; i < view.points; i++) {
+        double err = fabs(view.magnitude_db[i] - ref_gain_db(used, view.freq_hz[i], 48000));
+        if (err > worst_response) { worst_response = err; worst_at = view.freq_hz[i]; }
+    }
+    HT_CHECK(worst_response < 0.1, "EQResponse off the coefficients by %.4f dB at %.1f Hz", worst_response, worst_at);
+    printf("response: worst error %.4f dB over %u points\n", worst_response, view.points);
+}
+
+// ─── Stability ───────────────────────────────────────────────────────────────
+
+static void test_stability() {
+    static const float freqs[] = {20, 40, 200, 1000, 5000, 15000, 20000, 48000};
+    static const float gains[] = {-24, -6, 0, 6, 24};
+    static const float qs[]    = {0.1f, 0.707f, 3.0f, 10.0f};
+    static const uint32_t rates[] = {44100, 48000, 96000};
+
+    uint32_t checked = 0;
+    double worst_radius = 0.0;
+    for (uint32_t fs : rates) {
+        for (uint8_t t = 0; t <= (uint8_t)EQFilterType::HIGH_PASS; t++) {
+            for (float f : freqs) {
+                for (float g : gains) {
+                    for (float q : qs) {
+                        EQBandConfig bands[EQ_MAX_BANDS] = {};
+                        bands[0] = {true, (EQFilterType)t, f, g, q};
+                        float c[EQ_MAX_BANDS][5];
+                        EQProcessor::compute_coefs(bands, fs, c);
+                        // Poles of 1 + a1 z⁻¹ + a2 z⁻²: stable iff |a2| < 1 and |a1| < 1 + a2
+                        double a1 = c[0][3], a2 = c[0][4];
+                        double disc = a1 * a1 - 4.0 * a2;
+                        double radius = disc < 0.0 ? sqrt(a2) : (fabs(a1) + sqrt(disc)) / 2.0;
+                        if (radius > worst_radius) worst_radius = radius;
+                        HT_CHECK(fabs(a2) < 1.0 && fabs(a1) < 1.0 + a2,
+                                 "%s %.0f Hz %+.0f dB Q%.2f fs %u: a1 %.9f a2 %.9f",
+                                 eq_filter_type_to_str((EQFilterType)t), f, g, q, fs, a1, a2);
+                        checked++;
+                    }
+                }
+            }
+        }
+    }
+
+    // Worst cases in the float path: the narrowest, deepest low-frequency
+    // filters at 96 kHz. The impulse response must decay to digital zero.
+    static const EQBandConfig extremes[] = {
+        {true, EQFilterType::PEAKING,    20.0f,  24.0f, 10.0f},
+        {true, EQFilterType::LOW_SHELF,  20.0f,  24.0f, 10.0f},
+        {true, EQFilterType::HIGH_SHELF, 20.0f, -24.0f, 10.0f},
+        {true, EQFilterType::LOW_PASS,   20.0f,   0.0f, 10.0f},
+        {true, EQFilterType::HIGH_PASS,  20.0f,   0.0f, 10.0f},
+    };
+    for (const EQBandConfig &band : extremes) {
+        DeviceConfig cfg = eq_config(&band, 1);
+        EQProcessor::init(cfg, 96000);
+        std::vector<double> x(96000 * 3 * 2, 0.0), out;
+        x[0] = x[1] = 0.001;  // −60 dBFS click: full-scale ringing at +24 dB Q10 would clip
+        run_eq(x, &out);
+        double tail = 0.0;
+        for (size_t i = out.size() - 96000 / 2; i < out.size(); i++) tail = fmax(tail, fabs(out[i]));
+        HT_CHECK(tail == 0.0, "%s 20 Hz Q10 @ 96 kHz still rings at %.3g after 2.5 s",
+                 eq_filter_type_to_str(band.filter_type), tail);
+    }
+    printf("stability: %u coefficient sets, largest pole radius %.6f\n", checked, worst_radius);
+}
+
+// ─── THD on the reference capture ────────────────────────────────────────────
+
+static void test_thd(const char *wav_path) {
+    HtWav wav;
+    HT_CHECK(ht_load_wav(wav_path, &wav) && wav.channels == 2, "cannot load %s", wav_path);
+    if (wav.samples.empty()) return;
+    const double fs = wav.sample_rate;
+
+    EQBandConfig bands[4] = {
+        {true, EQFilterType::HIGH_PASS,    30.0f,  0.0f, 0.707f},
+        {true, EQFilterType::LOW_SHELF,   100.0f,  6.0f, 0.707f},
+        {true, EQFilterType::PEAKING,     880.0f, -3.0f, 1.4f},
+        {true, EQFilterType::HIGH_SHELF, 8000.0f,  4.0f, 0.707f},
+    };
+    DeviceConfig cfg = eq_config(bands, 4);
+    EQProcessor::init(cfg, (uint32_t)fs);
+    std::vector<double> out;
+    run_eq(wav.samples, &out);
+
+    // Same float coefficients, double arithmetic: isolates the float path's
+    // own rounding from the coefficient quantization. Direct form II keeps
+    // states of x/|A(z)|, which the 30 Hz high-pass inflates on the record's
+    // rumble; their rounding lands ≈ -63 dB below the tone. The bound catches
+    // a regression (a worse structure, lost state precision), not that floor.
+    float coef[EQ_MAX_BANDS][5];
+    uint8_t stages = EQProcessor::copy_active_coefs(coef, EQ_MAX_BANDS);
+    std::vector<double> same = wav.samples;
+    double w[EQ_MAX_BANDS][2][2] = {};
+    for (size_t i = 0; i < same.size(); i++) {
+        double x = ht_to24(same[i]) / 8388608.0;
+        for (uint8_t s = 0; s < stages; s++) {
+            double *d = w[s][i & 1];
+            double d0 = x - coef[s][3] * d[0] - coef[s][4] * d[1];
+            x = coef[s][0] * d0 + coef[s][1] * d[0] + coef[s][2] * d[1];
+            d[1] = d[0];
+            d[0] = d0;
+        }
+        same[i] = x;
+    }
+
+    // Skip the first 0.5 s (filter settling), fit over the rest
+    size_t skip = (size_t)(fs / 2), n = out.size() / 2 - skip;
+    for (int ch = 0; ch < 2; ch++) {
+        const double *in_ch = wav.samples.data() + skip * 2 + ch;
+        const double *out_ch = out.data() + skip * 2 + ch;
+        double f0 = ht_find_tone(in_ch, n, 2, 440.0, fs);
+        double thd_in = ht_thd_db(in_ch, n, 2, f0, fs);
+        double thd_out = ht_thd_db(out_ch, n, 2, f0, fs);
+        double thd_same = ht_thd_db(same.data() + skip * 2 + ch, n, 2, f0, fs);
+
+        // Expected THD: each input harmonic scaled by the reference response
+        std::vector<RefBiquad> ref;
+        for (const EQBandConfig &b : bands) ref.push_back(reference(b, fs));
+        double g0 = pow(10.0, ref_gain_db(ref, f0, fs) / 20.0);
+        double fund = ht_tone_amplitude(in_ch, n, 2, f0, fs) * g0, harm = 0.0;
+        for (int h = 2; h <= 10 && h * f0 < fs / 2.0; h++) {
+            double a = ht_tone_amplitude(in_ch, n, 2, h * f0, fs) * pow(10.0, ref_gain_db(ref, h * f0, fs) / 20.0);
+            harm += a * a;
+        }
+        double thd_ref = 10.0 * log10(harm / (fund * fund));
+
+        double err = 0.0, sig = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            double e = out_ch[i * 2] - same[(skip + i) * 2 + ch];
+            err += e * e;
+            sig += out_ch[i * 2] * out_ch[i * 2];
+        }
+        double noise_db = 10.0 * log10(err / sig);
+
+        printf("thd ch%d: f0 %.3f Hz, in %.2f dB, out %.2f dB, reference %.2f dB, float path noise %.1f dB\n",
+               ch, f0, thd_in, thd_out, thd_ref, noise_db);
+        HT_CHECK(fabs(thd_out - thd_ref) < 0.1, "ch%d THD %.2f dB, reference %.2f dB", ch, thd_out, thd_ref);
+        HT_CHECK(fabs(thd_out - thd_same) < 0.05, "ch%d THD %.2f dB, double arithmetic %.2f dB", ch, thd_out, thd_same);
+        HT_CHECK(noise_db < -60.0, "ch%d float path noise %.1f dB re signal", ch, noise_db);
+    }
+}
+
+// ─── Pack, clip, bypass ──────────────────────────────────────────────────────
+
+static void test_pack_and_clip() {
+    uint8_t i2s[BLOCK * 8], packed[BLOCK * 6];
+
+    // Bypass: nothing enabled, process() leaves the block to the caller
+    DeviceConfig off;
+    memset(&off, 0, sizeof(off));
+    EQProcessor::init(off, 48000);
+    memset(i2s, 0, sizeof(i2s));
+    HT_CHECK(!EQProcessor::process(i2s, packed, BLOCK), "bypassed chain reported filtering");
+
+    // Unity band: unpack → float → pack, extremes included. The band still
+    // runs in float; a wide 12 kHz one keeps its states near the input level,
+    // so rounding stays within 2 LSB.
+    EQBandConfig unity = {true, EQFilterType::PEAKING, 12000.0f, 0.0f, 0.1f};
+    DeviceConfig cfg = eq_config(&unity, 1);
+    EQProcessor::init(cfg, 48000);
+    static const int32_t edges[] = {8388607, -8388608, 1, -1, 0, 4660, -4660, 0x7FFF00, -0x7FFF00};
+    int32_t worst = 0;
+    for (int rep = 0; rep < 4; rep++) {
+        int32_t in[BLOCK][2];
+        for (size_t i = 0; i < BLOCK; i++) {
+            in[i][0] = (rep == 0 && i < 9) ? edges[i] : (int32_t)((i * 2654435761u + rep) & 0xFFFFFF) - 0x800000;
+            in[i][1] = -in[i][0] < 8388608 ? -in[i][0] : 8388607;
+            ht_put_i2s(i2s + i * 8, in[i][0]);
+            ht_put_i2s(i2s + i * 8 + 4, in[i][1]);
+        }
+        HT_CHECK(EQProcessor::process(i2s, packed, BLOCK), "unity band bypassed");
+        for (size_t i = 0; i < BLOCK; i++) {
+            for (int ch = 0; ch < 2; ch++) {
+                int32_t d = ht_get24(packed + i * 6 + ch * 3) - in[i][ch];
+                if (abs(d) > worst) worst = abs(d);
+            }
+        }
+    }
+    HT_CHECK(worst <= 2, "24-bit round trip off by %d LSB", worst);
+
+    // Clip: +12 dB on a full-scale sine saturates at ±(2^23 − 1), never wraps
+    EQBandConfig boost = {true, EQFilterType::PEAKING, 1000.0f, 12.0f, 1.0f};
+    cfg = eq_config(&boost, 1);
+    EQProcessor::init(cfg, 48000);
+    std::vector<double> out;
+    run_eq(sine(1000.0, 0.999, 48000, 4800), &out);
+    int clipped = 0, wrapped = 0;
+    for (size_t i = 480; i < out.size() / 2; i++) {
+        double ideal = sin(2.0 * M_PI * 1000.0 * (double)i / 48000.0);
+        int32_t v = ht_to24(out[i * 2]);
+        if (v == 8388607 || v == -8388607) clipped++;
+        if (fabs(ideal) > 0.5 && (v > 0) != (ideal > 0)) wrapped++;
+    }
+    HT_CHECK(clipped > 0, "+12 dB on a full-scale sine never clipped");
+    HT_CHECK(wrapped == 0, "%d samples wrapped around instead of clipping", wrapped);
+    printf("pack: round trip within %d LSB; clip: %d samples saturated, none wrapped\n", worst, clipped);
+}
+
+// ─── Silent fast path ────────────────────────────────────────────────────────
+
+static void test_silence() {
+    EQBandConfig band = {true, EQFilterType::PEAKING, 1000.0f, 6.0f, 1.4f};
+    DeviceConfig cfg = eq_config(&band, 1);
+    EQProcessor::init(cfg, 48000);
+    EQStats before;
+    EQProcessor::get_stats(&before);
+
+    // 0.5 s of digital silence, then 1 s of ±3 LSB noise, then silence again
+    const size_t frames = 48000 * 5 / 2;
+    std::vector<double> x(frames * 2, 0.0), out;
+    uint32_t seed = 1;
+    for (size_t i = 24000; i < 72000; i++) {
+        for (int ch = 0; ch < 2; ch++) {
+            seed = seed * 1103515245u + 12345u;
+            x[i * 2 + ch] = (double)((int32_t)((seed >> 16) % 7) - 3) / 8388608.0;
+        }
+    }
+    run_eq(x, &out);
+
+    size_t nonzero = 0;
+    for (size_t i = 24000 * 2; i < 72000 * 2; i++) nonzero += out[i] != 0.0;
+    EQStats after;
+    EQProcessor::get_stats(&after);
+    uint32_t silent = after.blocks_silent - before.blocks_silent;
+    uint32_t total = after.blocks_total - before.blocks_total;
+    printf("silence: %zu of %u noise samples kept, %u/%u blocks on the fast path\n",
+           nonzero, 48000 * 2, silent, total);
+    HT_CHECK(nonzero > 48000, "low-level noise was zeroed (%zu samples kept)", nonzero);
+    HT_CHECK(silent >= 250, "digital silence took the fast path for only %u blocks", silent);
+    HT_CHECK(after.in_fast_path, "trailing silence did not settle into the fast path");
+
+    // Limiter (with AGC, so no biquad state holds the fast path off): 40
+    // frames at the very end of a block are still in the lookahead when the
+    // next, silent block arrives. They must come out there, once.
+    DeviceConfig lim;
+    memset(&lim, 0, sizeof(lim));
+    lim.limiter_enabled = true;
+    lim.limiter_ceiling_db = -0.3f;
+    lim.limiter_release_ms = 100.0f;
+    lim.agc_enabled = true;
+    lim.agc_target_lufs = -23.0f;
+    EQProcessor::init(lim, 48000);
+    std::vector<double> y(BLOCK * 40 * 2, 0.0);
+    for (size_t i = BLOCK * 11 - 40; i < BLOCK * 11; i++) y[i * 2] = y[i * 2 + 1] = 0.25;
+    for (size_t i = BLOCK * 30; i < BLOCK * 40; i++) y[i * 2] = y[i * 2 + 1] = 0.25 * sin(0.05 * (double)i);
+    run_eq(y, &out);
+    size_t transient = 0, replayed = 0;
+    for (size_t i = 0; i < BLOCK * 30; i++) transient += out[i * 2] != 0.0;
+    for (size_t i = BLOCK * 30; i < BLOCK * 30 + PeakLimiter::lookahead_frames() - 1; i++) replayed += out[i * 2] != 0.0;
+    EQProcessor::get_stats(&after);
+    printf("silence: limiter lookahead emitted %zu of 40 transient frames, %zu replayed\n", transient, replayed);
+    HT_CHECK(transient == 40, "%zu of 40 transient frames left the limiter", transient);
+    HT_CHECK(replayed == 0, "%zu stale frames replayed after the fast path", replayed);
+}
+
+// ─── Phono stages ────────────────────────────────────────────────────────────
+
+// The active cascade starts with exactly the phono tables for `rate`
+static bool phono_matches(uint32_t rate, PhonoCurve curve, bool rumble) {
+    float want[PHONO_MAX_STAGES][5], got[PHONO_MAX_STAGES + EQ_MAX_BANDS][5];
+    uint8_t n = phono::build_stages(*phono::coef_set_for_rate(rate), curve, rumble, want);
+    uint8_t stages = EQProcessor::copy_active_coefs(got, PHONO_MAX_STAGES + EQ_MAX_BANDS);
+    return EQProcessor::phono_stage_count() == n && stages >= n && memcmp(got, want, sizeof(want[0]) * n) == 0;
+}
+
+static void test_phono() {
+    EQBandConfig band = {true, EQFilterType::PEAKING, 1000.0f, 3.0f, 1.0f};
+    DeviceConfig cfg = eq_config(&band, 1);
+    cfg.phono_curve = PhonoCurve::RIAA_IEC;
+    cfg.phono_rumble_filter = true;
+    EQProcessor::init(cfg, 48000);
+    HT_CHECK(phono_matches(48000, PhonoCurve::RIAA_IEC, true), "48 kHz phono stages differ from the tables");
+
+    // Core 0 picks the new set up at the next block; the one after runs it
+    std::vector<double> out;
+    HT_CHECK(run_eq(sine(1000.0, 0.1, 48000, BLOCK * 4), &out), "phono stage bypassed");
+    EQProcessor::set_phono(PhonoCurve::RIAA, false);
+    HT_CHECK(phono_matches(48000, PhonoCurve::RIAA, false), "set_phono() did not publish the new stages");
+    run_eq(sine(1000.0, 0.1, 48000, BLOCK * 4), &out);
+
+    // Rate change: phono stages and the band come back for 44.1 kHz
+    EQProcessor::update_band(0, band, 44100);
+    run_eq(sine(1000.0, 0.1, 44100, BLOCK * 4), &out);
+    HT_CHECK(EQProcessor::get_sample_rate() == 44100, "sample rate %u after update_band(44100)",
+             EQProcessor::get_sample_rate());
+    HT_CHECK(phono_matches(44100, PhonoCurve::RIAA, false), "phono stages not rebuilt for 44.1 kHz");
+    float coef[PHONO_MAX_STAGES + EQ_MAX_BANDS][5], want[EQ_MAX_BANDS][5];
+    EQBandConfig bands[EQ_MAX_BANDS];
+    EQProcessor::get_bands(bands);
+    EQProcessor::compute_coefs(bands, 44100, want);
+    uint8_t stages = EQProcessor::copy_active_coefs(coef, PHONO_MAX_STAGES + EQ_MAX_BANDS);
+    HT_CHECK(stages == 2 && memcmp(coef[1], want[0], sizeof(want[0])) == 0, "band not rebuilt for 44.1 kHz");
+    printf("phono: stages follow set_phono() and the 48 → 44.1 kHz change\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <capture-440hz-sine.wav>\n", argv[0]);
+        return 2;
+    }
+    test_magnitude();
+    test_stability();
+    test_thd(argv[1]);
+    test_pack_and_clip();
+    test_silence();
+    test_phono();
+    return ht_result();
+}
@@ -0,0 +1,122 @@
+// FlacEncoder round trip: encode known blocks, decode them with the minimal
+// FLAC decoder in host_flac.h, require bit-exact samples. The subframe and
+// channel-assignment counts show every decoder path was exercised.
+//
+// Inputs: both sample-tone captures, plus synthetic blocks that force each
+// subframe type, channel assignment and the 17-bit side channel (silence,
+// full-scale noise, opposite full-scale extremes, correlated channels, a
+// sine at 44.1/96 kHz and at a rate without a header code).
+//
+// Usage: test_flac_encoder <capture.wav> [<capture.wav> ...]
+
+#include "host_flac.h"
+#include <random>
+
+static constexpr uint32_t N = FLAC_BLOCK_FRAMES;
+
+// ─── Round trip ──────────────────────────────────────────────────────────────
+
+// Encode whole blocks of `pcm` (interleaved 16-bit stereo) and decode them;
+// returns the encoded size in bytes
+static size_t round_trip(const char *name, const std::vector<int16_t> &pcm, uint32_t rate, HtFlacStats *st) {
+    FlacEncoder enc;
+    HT_CHECK(enc.init(rate), "%s: init(%u) failed", name, rate);
+    static uint8_t frame[FLAC_MAX_FRAME_BYTES];
+    static int16_t decoded[N * 2];
+
+    size_t bytes = 0, blocks = pcm.size() / 2 / N, mismatched = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        const int16_t *in = pcm.data() + b * N * 2;
+        size_t size = enc.encode(in, frame);
+        HT_CHECK(size > 0 && size <= FLAC_MAX_FRAME_BYTES, "%s block %zu: %zu bytes", name, b, size);
+        size_t used = ht_flac_decode_frame(frame, size, rate, (uint32_t)b, decoded, st);
+        HT_CHECK(used == size, "%s block %zu: decoded %zu of %zu bytes", name, b, used, size);
+        if (used == 0 || memcmp(decoded, in, sizeof(decoded)) != 0) mismatched++;
+        bytes += size;
+    }
+    enc.deinit();
+
+    HT_CHECK(mismatched == 0, "%s: %zu of %zu blocks not bit-exact", name, mismatched, blocks);
+    printf("%-28s %6zu blocks, %5.1f %% of PCM, %s\n", name, blocks,
+           100.0 * (double)bytes / (double)(blocks * N * 4), mismatched ? "MISMATCH" : "bit-exact");
+    return bytes;
+}
+
+static void test_stream_header() {
+    uint8_t h[FLAC_STREAM_HEADER_BYTES];
+    HT_CHECK(FlacEncoder::stream_header(48000, h, sizeof(h) - 1) == 0, "header written into a short buffer");
+    HT_CHECK(FlacEncoder::stream_header(48000, h, sizeof(h)) == FLAC_STREAM_HEADER_BYTES, "header size");
+    HtBitReader br = {h, sizeof(h), 0, false};
+    HT_CHECK(br.u(32) == 0x664C6143, "missing fLaC marker");
+    HT_CHECK(br.u(8) == 0x80 && br.u(24) == 34, "STREAMINFO block header");
+    uint32_t min_block = br.u(16), max_block = br.u(16);
+    br.u(48);
+    uint32_t rate = br.u(20), channels = br.u(3) + 1, bps = br.u(5) + 1;
+    HT_CHECK(min_block == N && max_block == N && rate == 48000 && channels == 2 && bps == 16,
+             "STREAMINFO: block %u/%u, %u Hz, %u ch, %u bit", min_block, max_block, rate, channels, bps);
+}
+
+int main(int argc, char **argv) {
+    test_stream_header();
+
+    HtFlacStats st = {};
+    for (int i = 1; i < argc; i++) {
+        HtWav wav;
+        HT_CHECK(ht_load_wav(argv[i], &wav) && wav.channels == 2, "cannot load %s", argv[i]);
+        if (wav.samples.empty()) continue;
+        const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+        round_trip(name, ht_to_pcm16(wav), wav.sample_rate, &st);
+    }
+
+    const size_t frames = N * 8;
+    std::vector<int16_t> pcm(frames * 2, 0);
+    round_trip("silence", pcm, 48000, &st);
+
+    std::mt19937 gen(3);
+    for (int16_t &s : pcm) s = (int16_t)(gen() >> 16);
+    round_trip("full-scale noise", pcm, 48000, &st);
+
+    for (size_t i = 0; i < frames; i++) {
+        pcm[i * 2 + 0] = (i / 3) % 2 ? 32767 : -32768;
+        pcm[i * 2 + 1] = (i / 3) % 2 ? -32768 : 32767;
+    }
+    round_trip("opposite extremes", pcm, 48000, &st);
+
+    // Correlated channels. R = L + small noise favours left/side. L, R = x ± y
+    // with independent noise x, y (σy = σx / 2) favours mid/side: x + 2y
+    // beats both 2·|x ± y| and |x ± y| + 2y.
+    std::normal_distribution<double> small(0.0, 30.0), wide(0.0, 3000.0);
+    for (size_t i = 0; i < frames; i++) {
+        double x = 15000.0 * sin(2.0 * M_PI * 440.0 * (double)i / 48000.0);
+        pcm[i * 2 + 0] = (int16_t)lrint(x);
+        pcm[i * 2 + 1] = (int16_t)lrint(x + small(gen));
+    }
+    round_trip("left/side stereo", pcm, 48000, &st);
+    for (size_t i = 0; i < frames; i++) {
+        double x = wide(gen), y = wide(gen) / 2.0;
+        pcm[i * 2 + 0] = (int16_t)lrint(x + y);
+        pcm[i * 2 + 1] = (int16_t)lrint(x - y);
+    }
+    round_trip("mid/side stereo", pcm, 48000, &st);
+
+    for (uint32_t rate : {44100u, 96000u, 37800u}) {
+        for (size_t i = 0; i < frames; i++) {
+            double w = 2.0 * M_PI * 1000.0 * (double)i / rate;
+            pcm[i * 2 + 0] = (int16_t)lrint(20000.0 * sin(w));
+            pcm[i * 2 + 1] = (int16_t)lrint(12000.0 * sin(w + 0.5));
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "1 kHz sine @ %u Hz", rate);
+        round_trip(name, pcm, rate, &st);
+    }
+
+    printf("subframes: %u constant, %u verbatim, %u fixed, %u lpc; %u Rice escapes\n", st.constant,
+           st.verbatim, st.fixed, st.lpc, st.escapes);
+    printf("stereo: %u independent, %u left/side, %u side/right, %u mid/side\n", st.assignment[1],
+           st.assignment[8], st.assignment[9], st.assignment[10]);
+    HT_CHECK(st.constant > 0 && st.verbatim > 0 && st.fixed > 0 && st.lpc > 0,
+             "not every subframe type was exercised");
+    HT_CHECK(st.assignment[1] > 0 && st.assignment[8] > 0 && st.assignment[9] > 0 && st.assignment[10] > 0,
+             "not every channel assignment was exercised");
+    return ht_result();
+}
@@ -0,0 +1,399 @@
+// HlsSegmenter round trip: playlist, init segment and media segments parsed
+// back and their FLAC frames decoded (host_flac.h).
+//
+// The capture is the counter of test_snapcast_server: frame f is written as
+// L = f & 0xFFFF, R = f >> 16 above a constant byte that the undithered
+// 24 → 16-bit conversion drops, so every decoded frame names its capture
+// frame. 2 s are written at once, then a real-time capture thread runs with
+// the real stream_enc and hls_seg tasks until SEGMENTS 1 s segments are
+// complete.
+//
+//   playlist   version 6, target duration, the newest HLS_PLAYLIST_SEGMENTS
+//              segments from EXT-X-MEDIA-SEQUENCE on, EXTINF of exactly
+//              SEGMENT_FRAMES FLAC frames, the session's EXT-X-MAP and segment URLs
+//   init       ftyp + moov with consistent box sizes; mvhd and mdhd at the
+//              capture rate; a 'fLaC' sample entry (2 ch, 16 bit) whose dfLa
+//              holds the last-block STREAMINFO; trex default duration of one
+//              FLAC frame. Only the running session's init is served.
+//   segments   every cached one: mfhd = seq + 1, tfhd default-base-is-moof,
+//              tfdt consecutive on the capture timeline, trun data offset
+//              = moof + mdat header and sample sizes that add up to the
+//              mdat. Each sample decodes (CRC-8, CRC-16, frame number =
+//              tfdt / FLAC_BLOCK_FRAMES) to the capture frames tfdt names.
+//   cache      a segment that left the playlist is still served; one not
+//              complete yet, or of another session, misses; stats count the
+//              requests, misses and bytes, no gap and no dropped frame
+//   stop       no playlist, init or segment once HLS is off
+
+#include "host_flac.h"
+#include "network/hls_segmenter.h"
+#include "network/stream_encoder.h"
+#include "audio/audio_buffer.h"
+#include "audio/dsp_platform.h"
+#include <atomic>
+#include <string>
+
+static constexpr uint32_t RATE           = 48000;
+static constexpr uint32_t BLOCK_FRAMES   = 240;
+static constexpr uint8_t  SEGMENT_S      = 1;
+static constexpr uint32_t SEGMENT_FRAMES = SEGMENT_S * RATE / FLAC_BLOCK_FRAMES;   // FLAC frames
+static constexpr uint32_t SEGMENTS       = HLS_PLAYLIST_SEGMENTS + 2;
+
+// ─── Capture ─────────────────────────────────────────────────────────────────
+
+static std::atomic<uint64_t> s_written{0};
+static std::atomic<bool>     s_capturing{false};
+
+static void write_block() {
+    uint8_t block[BLOCK_FRAMES * 6];
+    const uint64_t first = s_written.load();
+    for (uint32_t i = 0; i < BLOCK_FRAMES; i++) {
+        const uint32_t f = (uint32_t)(first + i);
+        ht_put24(block + i * 6 + 0, (int32_t)(int16_t)(f & 0xFFFF) * 256 + 0x5A);
+        ht_put24(block + i * 6 + 3, (int32_t)(int16_t)(f >> 16) * 256 + 0x5A);
+    }
+    AudioBuffer::write(block, sizeof(block));
+    s_written = first + BLOCK_FRAMES;
+}
+
+// One block per 5 ms on an absolute schedule, like the I²S DMA
+static void capture_thread() {
+    const int64_t period_us = (int64_t)BLOCK_FRAMES * 1000000 / RATE;
+    int64_t next = esp_timer_get_time();
+    while (s_capturing) {
+        next += period_us;
+        int64_t wait = next - esp_timer_get_time();
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::microseconds(wait));
+        write_block();
+    }
+}
+
+// ─── ISO BMFF ────────────────────────────────────────────────────────────────
+
+static uint32_t be32(const uint8_t *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+static uint64_t be64(const uint8_t *p) { return (uint64_t)be32(p) << 32 | be32(p + 4); }
+
+struct Box {
+    const uint8_t *body;        // After the size and type
+    size_t size;                // Of the body
+};
+
+// Child `type` among the boxes that exactly fill [d, d + len). False if it
+// is missing or a size runs past the end.
+static bool child(const uint8_t *d, size_t len, const char *type, Box *out) {
+    bool found = false;
+    for (size_t pos = 0; pos < len;) {
+        if (len - pos < 8) return false;
+        const uint32_t size = be32(d + pos);
+        if (size < 8 || size > len - pos) return false;
+        if (!found && memcmp(d + pos + 4, type, 4) == 0) {
+            *out  = {d + pos + 8, size - 8};
+            found = true;
+        }
+        pos += size;
+    }
+    return found;
+}
+
+// Container boxes whose bodies are only boxes, every size in the tree must
+// add up exactly
+static bool well_formed(const uint8_t *d, size_t len) {
+    static const char *containers[] = {"moov", "trak", "mdia", "minf", "dinf", "stbl", "mvex", "moof", "traf"};
+    for (size_t pos = 0; pos < len;) {
+        if (len - pos < 8) return false;
+        const uint32_t size = be32(d + pos);
+        if (size < 8 || size > len - pos) return false;
+        for (const char *c : containers) {
+            if (memcmp(d + pos + 4, c, 4) == 0 && !well_formed(d + pos + 8, size - 8)) return false;
+        }
+        pos += size;
+    }
+    return true;
+}
+
+// Follow a '/'-separated path of container boxes
+static bool path(const uint8_t *d, size_t len, const char *p, Box *out) {
+    Box box = {d, len};
+    for (; *p != '\0'; p += p[4] == '/' ? 5 : 4) {
+        if (!child(box.body, box.size, std::string(p, 4).c_str(), &box)) return false;
+    }
+    *out = box;
+    return true;
+}
+
+// ─── Playlist ────────────────────────────────────────────────────────────────
+
+static std::vector<std::string> lines(const char *text) {
+    std::vector<std::string> out;
+    for (const char *p = text; *p != '\0';) {
+        const char *nl = strchr(p, '\n');
+        if (nl == nullptr) nl = p + strlen(p);
+        out.emplace_back(p, nl);
+        p = *nl == '\n' ? nl + 1 : nl;
+    }
+    return out;
+}
+
+static void test_playlist(uint32_t session, uint32_t sequence) {
+    char buf[1024];
+    const size_t len = HlsSegmenter::build_playlist(buf, sizeof(buf));
+    HT_CHECK(len > 0 && len == strlen(buf), "playlist: %zu bytes", len);
+    HT_CHECK(HlsSegmenter::build_playlist(buf, 64) == 0, "playlist fits 64 bytes");
+    HlsSegmenter::build_playlist(buf, sizeof(buf));
+
+    char want[128];
+    const uint32_t first = sequence - HLS_PLAYLIST_SEGMENTS;
+    std::vector<std::string> expect = {"#EXTM3U", "#EXT-X-VERSION:6"};
+    snprintf(want, sizeof(want), "#EXT-X-TARGETDURATION:%u", SEGMENT_S);
+    expect.push_back(want);
+    snprintf(want, sizeof(want), "#EXT-X-MEDIA-SEQUENCE:%u", first);
+    expect.push_back(want);
+    expect.push_back("#EXT-X-DISCONTINUITY-SEQUENCE:0");
+    expect.push_back("#EXT-X-INDEPENDENT-SEGMENTS");
+    snprintf(want, sizeof(want), "#EXT-X-MAP:URI=\"%08x-init.mp4\"", session);
+    expect.push_back(want);
+    for (uint32_t seq = first; seq < sequence; seq++) {
+        expect.push_back("#EXTINF:1.000,");
+        snprintf(want, sizeof(want), "%08x-%u.m4s", session, seq);
+        expect.push_back(want);
+    }
+
+    std::vector<std::string> got = lines(buf);
+    HT_CHECK(got.size() == expect.size(), "playlist: %zu lines, want %zu", got.size(), expect.size());
+    for (size_t i = 0; i < got.size() && i < expect.size(); i++) {
+        HT_CHECK(got[i] == expect[i], "playlist line %zu: \"%s\", want \"%s\"", i + 1, got[i].c_str(),
+                 expect[i].c_str());
+    }
+    printf("playlist: %zu bytes, segments %u-%u\n", len, first, sequence - 1);
+}
+
+// ─── Init segment ────────────────────────────────────────────────────────────
+
+static void test_init(uint32_t session) {
+    uint8_t buf[HLS_INIT_MAX_BYTES];
+    HT_CHECK(HlsSegmenter::build_init(session + 1, buf, sizeof(buf)) == 0, "init served for another session");
+    HT_CHECK(HlsSegmenter::build_init(session, buf, 64) == 0, "init fits 64 bytes");
+    const size_t len = HlsSegmenter::build_init(session, buf, sizeof(buf));
+    HT_CHECK(len > 0 && well_formed(buf, len), "init: %zu bytes, box sizes do not add up", len);
+    if (len == 0 || !well_formed(buf, len)) return;
+
+    Box ftyp, mvhd, mdhd, hdlr, stsd, flac, dfla, trex;
+    HT_CHECK(child(buf, len, "ftyp", &ftyp) && memcmp(ftyp.body, "iso6", 4) == 0, "init: no iso6 ftyp");
+    HT_CHECK(path(buf, len, "moov/mvhd", &mvhd) && be32(mvhd.body + 12) == RATE, "mvhd: timescale %u",
+             be32(mvhd.body + 12));
+    HT_CHECK(path(buf, len, "moov/trak/mdia/mdhd", &mdhd) && be32(mdhd.body + 12) == RATE, "mdhd: timescale %u",
+             be32(mdhd.body + 12));
+    HT_CHECK(path(buf, len, "moov/trak/mdia/hdlr", &hdlr) && memcmp(hdlr.body + 8, "soun", 4) == 0,
+             "hdlr: not a sound track");
+
+    // stsd: version/flags, entry count, then the sample entries
+    const bool has_stsd = path(buf, len, "moov/trak/mdia/minf/stbl/stsd", &stsd);
+    HT_CHECK(has_stsd && be32(stsd.body + 4) == 1 && child(stsd.body + 8, stsd.size - 8, "fLaC", &flac),
+             "stsd: no single fLaC sample entry");
+    if (!has_stsd || !child(stsd.body + 8, stsd.size - 8, "fLaC", &flac)) return;
+    const uint16_t channels = (uint16_t)(flac.body[16] << 8 | flac.body[17]);
+    const uint16_t bits     = (uint16_t)(flac.body[18] << 8 | flac.body[19]);
+    HT_CHECK(channels == 2 && bits == 16 && be32(flac.body + 24) == RATE << 16,
+             "fLaC: %u channels, %u bits, rate 0x%08x", channels, bits, be32(flac.body + 24));
+
+    // dfLa: version/flags, then the STREAMINFO metadata block
+    HT_CHECK(child(flac.body + 28, flac.size - 28, "dfLa", &dfla) && dfla.size == 4 + 4 + 34,
+             "fLaC: no dfLa holding one STREAMINFO");
+    if (!child(flac.body + 28, flac.size - 28, "dfLa", &dfla) || dfla.size != 42) return;
+    const uint8_t *si = dfla.body + 8;
+    const uint32_t block_min = (uint32_t)(si[0] << 8 | si[1]), block_max = (uint32_t)(si[2] << 8 | si[3]);
+    const uint32_t rate = (uint32_t)si[10] << 12 | (uint32_t)si[11] << 4 | si[12] >> 4;
+    const uint32_t ch = ((si[12] >> 1) & 7) + 1, bps = ((si[12] & 1) << 4 | si[13] >> 4) + 1;
+    HT_CHECK(be32(dfla.body + 4) == (0x80000000u | 34),
+             "dfLa: block header %08x, want last-block STREAMINFO of 34 bytes", be32(dfla.body + 4));
+    HT_CHECK(block_min == FLAC_BLOCK_FRAMES && block_max == FLAC_BLOCK_FRAMES && rate == RATE && ch == 2 &&
+             bps == 16, "STREAMINFO: blocks %u-%u, %u Hz, %u ch, %u bit", block_min, block_max, rate, ch, bps);
+
+    // trex: version/flags, track, description index, default duration
+    HT_CHECK(path(buf, len, "moov/mvex/trex", &trex) && be32(trex.body + 4) == 1 &&
+             be32(trex.body + 12) == FLAC_BLOCK_FRAMES, "trex: track %u, default duration %u",
+             be32(trex.body + 4), be32(trex.body + 12));
+    printf("init: %zu bytes\n", len);
+}
+
+// ─── Media segments ──────────────────────────────────────────────────────────
+
+// Parse, check and decode segment `seq`. Returns its bytes (0 on a miss) and
+// its tfdt and sample count.
+static size_t check_segment(uint32_t session, uint32_t seq, uint64_t *tfdt_out, uint32_t *samples_out,
+                            int64_t *capture_base) {
+    const uint8_t *d = nullptr;
+    size_t len = 0;
+    const int handle = HlsSegmenter::acquire(session, seq, &d, &len);
+    HT_CHECK(handle >= 0, "segment %u: not in the cache", seq);
+    if (handle < 0) return 0;
+
+    Box moof, mfhd, tfhd, tfdt, trun, mdat;
+    const bool boxes = well_formed(d, len) && child(d, len, "moof", &moof) && child(d, len, "mdat", &mdat) &&
+                       path(d, len, "moof/mfhd", &mfhd) && path(d, len, "moof/traf/tfhd", &tfhd) &&
+                       path(d, len, "moof/traf/tfdt", &tfdt) && path(d, len, "moof/traf/trun", &trun);
+    HT_CHECK(boxes, "segment %u: %zu bytes, not moof + mdat with mfhd, tfhd, tfdt and trun", seq, len);
+    if (!boxes) {
+        HlsSegmenter::release(handle, 0);
+        return 0;
+    }
+
+    const size_t moof_len = moof.size + 8;
+    HT_CHECK(be32(mfhd.body + 4) == seq + 1, "segment %u: mfhd sequence %u", seq, be32(mfhd.body + 4));
+    HT_CHECK(be32(tfhd.body) == 0x020008 && be32(tfhd.body + 4) == 1 && be32(tfhd.body + 8) == FLAC_BLOCK_FRAMES,
+             "segment %u: tfhd flags %06x, track %u, default duration %u", seq, be32(tfhd.body),
+             be32(tfhd.body + 4), be32(tfhd.body + 8));
+    HT_CHECK(tfdt.body[0] == 1, "segment %u: tfdt version %u", seq, tfdt.body[0]);
+    const uint64_t decode_time = be64(tfdt.body + 4);
+
+    const uint32_t samples = be32(trun.body + 4), data_offset = be32(trun.body + 8);
+    HT_CHECK(be32(trun.body) == 0x000201 && trun.size == 12 + 4 * (size_t)samples,
+             "segment %u: trun flags %06x, %u samples in %zu bytes", seq, be32(trun.body), samples, trun.size);
+    HT_CHECK(samples == SEGMENT_FRAMES, "segment %u: %u samples, want %u", seq, samples, SEGMENT_FRAMES);
+    HT_CHECK(data_offset == moof_len + 8 && mdat.body == d + data_offset,
+             "segment %u: data offset %u, want %zu", seq, data_offset, moof_len + 8);
+
+    size_t sum = 0;
+    for (uint32_t i = 0; i < samples; i++) sum += be32(trun.body + 12 + 4 * i);
+    HT_CHECK(sum == mdat.size && moof_len + 8 + sum == len, "segment %u: samples %zu bytes, mdat %zu, segment %zu",
+             seq, sum, mdat.size, len);
+
+    // Decode: sample i is FLAC frame tfdt / FLAC_BLOCK_FRAMES + i, and its
+    // frames carry capture frames base + tfdt + i · FLAC_BLOCK_FRAMES + k
+    static int16_t lrlr[FLAC_BLOCK_FRAMES * 2];
+    HtFlacStats st = {};
+    uint32_t bad = 0;
+    size_t pos = 0;
+    for (uint32_t i = 0; i < samples && sum == mdat.size; i++) {
+        const size_t size = be32(trun.body + 12 + 4 * i);
+        const uint32_t number = (uint32_t)(decode_time / FLAC_BLOCK_FRAMES) + i;
+        const size_t used = ht_flac_decode_frame(mdat.body + pos, size, RATE, number, lrlr, &st);
+        HT_CHECK(used == size, "segment %u sample %u: decoded %zu of %zu bytes", seq, i, used, size);
+        pos += size;
+        if (used != size) {
+            bad++;
+            continue;
+        }
+        for (uint32_t k = 0; k < FLAC_BLOCK_FRAMES; k++) {
+            const uint32_t f = (uint16_t)lrlr[k * 2] | (uint32_t)(uint16_t)lrlr[k * 2 + 1] << 16;
+            const uint64_t media = decode_time + (uint64_t)i * FLAC_BLOCK_FRAMES + k;
+            if (*capture_base < 0) *capture_base = (int64_t)f - (int64_t)media;
+            if ((int64_t)f != *capture_base + (int64_t)media) {
+                bad++;
+                break;
+            }
+        }
+    }
+    HT_CHECK(bad == 0, "segment %u: %u of %u samples do not decode to their capture frames", seq, bad, samples);
+    HlsSegmenter::release(handle, len);
+
+    *tfdt_out    = decode_time;
+    *samples_out = samples;
+    return len;
+}
+
+static void test_segments(uint32_t session, uint32_t sequence) {
+    HlsStats before;
+    HlsSegmenter::get_stats(&before);
+
+    // Every complete segment still cached: the playlist's and those that
+    // just left it, oldest first
+    const uint32_t first = sequence > HLS_CACHE_SEGMENTS - 1 ? sequence - (HLS_CACHE_SEGMENTS - 1) : 0;
+    int64_t capture_base = -1;
+    uint64_t next_tfdt = 0, served = 0;
+    for (uint32_t seq = first; seq < sequence; seq++) {
+        uint64_t tfdt = 0;
+        uint32_t samples = 0;
+        const size_t len = check_segment(session, seq, &tfdt, &samples, &capture_base);
+        HT_CHECK(seq == first || tfdt == next_tfdt, "segment %u: tfdt %llu, want %llu", seq,
+                 (unsigned long long)tfdt, (unsigned long long)next_tfdt);
+        next_tfdt = tfdt + (uint64_t)samples * FLAC_BLOCK_FRAMES;
+        served += len;
+        printf("segment %u: %zu bytes, tfdt %llu, %u samples\n", seq, len, (unsigned long long)tfdt, samples);
+    }
+    HT_CHECK(capture_base >= 0 && (uint64_t)capture_base < s_written, "media time 0 at capture frame %lld",
+             (long long)capture_base);
+
+    const uint8_t *d;
+    size_t len;
+    HT_CHECK(HlsSegmenter::acquire(session, sequence, &d, &len) < 0, "segment %u served before it is complete",
+             sequence);
+    HT_CHECK(HlsSegmenter::acquire(session + 1, sequence - 1, &d, &len) < 0, "segment served for another session");
+
+    HlsStats after;
+    HlsSegmenter::get_stats(&after);
+    const uint32_t fetched = sequence - first;
+    HT_CHECK(after.segment_requests - before.segment_requests == fetched + 2 &&
+             after.misses - before.misses == 2 && after.bytes_served - before.bytes_served == served,
+             "stats: %u requests, %u misses, %llu bytes; want %u, 2, %llu",
+             after.segment_requests - before.segment_requests, after.misses - before.misses,
+             (unsigned long long)(after.bytes_served - before.bytes_served), fetched + 2,
+             (unsigned long long)served);
+    HT_CHECK(after.discontinuities == 0 && after.dropped_frames == 0, "%u discontinuities, %u dropped frames",
+             after.discontinuities, after.dropped_frames);
+    const uint32_t cached = sequence < HLS_CACHE_SEGMENTS - 1 ? sequence : HLS_CACHE_SEGMENTS - 1;
+    HT_CHECK(after.cached == cached, "%u segments cached after %u, want %u", after.cached, sequence, cached);
+}
+
+// ─── Main ────────────────────────────────────────────────────────────────────
+
+static bool wait_running(bool running) {
+    for (int i = 0; i < 1000 && HlsSegmenter::is_running() != running; i++) vTaskDelay(pdMS_TO_TICKS(1));
+    return HlsSegmenter::is_running() == running;
+}
+
+int main() {
+    dsp_host_enable_tasks();
+    HT_CHECK(AudioBuffer::init(), "AudioBuffer::init failed");
+    HT_CHECK(StreamEncoder::init(RATE), "StreamEncoder::init failed");
+    StreamEncoder::set_dither(DitherMode::OFF);
+    HT_CHECK(HlsSegmenter::init(RATE), "HlsSegmenter::init failed");
+
+    char text[64];
+    HT_CHECK(HlsSegmenter::build_playlist(text, sizeof(text)) == 0, "playlist while HLS is off");
+
+    // A new pipe starts 1.5 s behind capture: the first segment is there at once
+    for (uint32_t b = 0; b < 2 * RATE / BLOCK_FRAMES; b++) write_block();
+    HlsSegmenter::configure(true, SEGMENT_S);
+    HT_CHECK(wait_running(true), "HLS did not start");
+    s_capturing = true;
+    std::thread capture(capture_thread);
+
+    HlsStats stats = {};
+    for (int i = 0; i < 100 && stats.sequence < SEGMENTS; i++) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        HlsSegmenter::get_stats(&stats);
+    }
+    s_capturing = false;
+    capture.join();
+    vTaskDelay(pdMS_TO_TICKS(4 * HLS_POLL_MS));     // Let the pipe drain into the slot being filled
+    HlsSegmenter::get_stats(&stats);
+    HT_CHECK(stats.sequence >= SEGMENTS, "%u segments in 10 s, want %u", stats.sequence, SEGMENTS);
+
+    // A slot: the largest moof (92 bytes + 4 per sample), the mdat header and
+    // SEGMENT_FRAMES verbatim FLAC frames
+    const size_t slot = 92 + 4 * (size_t)SEGMENT_FRAMES + 8 + (size_t)SEGMENT_FRAMES * FLAC_MAX_FRAME_BYTES;
+    HT_CHECK(stats.running && stats.segment_s == SEGMENT_S && stats.cache_bytes == HLS_CACHE_SEGMENTS * slot,
+             "stats: running %d, %u s segments, cache %u bytes, want %zu", stats.running, stats.segment_s,
+             stats.cache_bytes, HLS_CACHE_SEGMENTS * slot);
+    printf("session %08x: %u segments, cache %u KB\n", stats.session, stats.sequence, stats.cache_bytes / 1024);
+
+    if (stats.sequence >= HLS_PLAYLIST_SEGMENTS) {
+        test_playlist(stats.session, stats.sequence);
+        test_init(stats.session);
+        test_segments(stats.session, stats.sequence);
+    }
+
+    HlsSegmenter::configure(false, SEGMENT_S);
+    HT_CHECK(wait_running(false), "HLS did not stop");
+    const uint8_t *d;
+    size_t len;
+    uint8_t init[HLS_INIT_MAX_BYTES];
+    HT_CHECK(HlsSegmenter::build_playlist(text, sizeof(text)) == 0 &&
+             HlsSegmenter::build_init(stats.session, init, sizeof(init)) == 0 &&
+             HlsSegmenter::acquire(stats.session, stats.sequence - 1, &d, &len) < 0,
+             "playlist, init or segment served after stop");
+    return ht_result();
+}
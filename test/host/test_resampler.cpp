@@ -0,0 +1,144 @@
+// Resampler against the response promised in resampler_tables.h, per ratio.
+//
+//   passband    tones from 20 Hz to 20 kHz come out at their input level
+//               within ±0.1 dB
+//   rejection   input that lands on fs_out − 20 kHz and up (alias tones of
+//               content above the output Nyquist, images of the L-fold
+//               upsampling) is ≥ 94 dB down wherever it folds into 0–20 kHz
+//   ratio       N input frames give N·L/M output frames (±1), and feeding
+//               the same signal in odd block sizes gives bit-identical
+//               output: the phase carries across blocks
+//
+// Every tone sits on a whole number of cycles in the one-second analysis
+// window, so the least-squares fit at one frequency does not see the others.
+
+#include "host_test.h"
+#include "audio/resampler.h"
+#include "audio/resampler_tables.h"
+#include <algorithm>
+#include <vector>
+
+struct RatioCase {
+    uint32_t in_rate;
+    uint32_t out_rate;
+};
+
+static constexpr RatioCase RATIOS[] = {{48000, 44100}, {96000, 48000}, {96000, 44100}};
+
+static constexpr double AMP          = 0.5;
+static constexpr double RIPPLE_DB    = 0.1;
+static constexpr double REJECTION_DB = -94.0;
+
+// Run `in` (interleaved stereo) through a fresh resampler in blocks of the
+// given sizes, cycled
+static std::vector<float> resample_all(const RatioCase &rc, const std::vector<float> &in,
+                                       const std::vector<size_t> &blocks) {
+    Resampler rs;
+    std::vector<float> out;
+    if (!rs.init(rc.in_rate, rc.out_rate)) return out;
+    std::vector<float> buf(rs.max_output(RESAMPLER_MAX_FRAMES) * 2);
+    size_t frames = in.size() / 2, pos = 0, b = 0;
+    while (pos < frames) {
+        size_t n = std::min(blocks[b++ % blocks.size()], frames - pos);
+        size_t got = rs.process(in.data() + pos * 2, n, buf.data());
+        HT_CHECK(got <= rs.max_output(n), "%zu outputs from %zu frames, max_output says %zu", got, n,
+                 rs.max_output(n));
+        out.insert(out.end(), buf.begin(), buf.begin() + got * 2);
+        pos += n;
+    }
+    rs.deinit();
+    return out;
+}
+
+// Tones of `freqs` on L and the first one alone on R, 1.25 s
+static std::vector<float> tones(uint32_t rate, std::initializer_list<double> freqs) {
+    std::vector<float> x(rate * 5 / 4 * 2);
+    for (size_t i = 0; i < x.size() / 2; i++) {
+        double l = 0.0;
+        for (double f : freqs) l += AMP * sin(2.0 * M_PI * f * (double)i / rate);
+        x[i * 2 + 0] = (float)l;
+        x[i * 2 + 1] = (float)(AMP * sin(2.0 * M_PI * *freqs.begin() * (double)i / rate));
+    }
+    return x;
+}
+
+// Amplitude at `freq` over one second of output, after the filter has settled
+static double level(const std::vector<float> &y, int ch, uint32_t rate, double freq) {
+    const size_t skip = rate / 8;
+    std::vector<double> x(rate);
+    for (size_t i = 0; i < rate; i++) x[i] = y[(skip + i) * 2 + ch];
+    return ht_tone_amplitude(x.data(), rate, 1, freq, rate);
+}
+
+static void test_passband(const RatioCase &rc) {
+    double worst = 0.0;
+    for (double f : {20.0, 1000.0, 10000.0, 15000.0, 19000.0, 20000.0}) {
+        std::vector<float> y = resample_all(rc, tones(rc.in_rate, {f}), {RESAMPLER_MAX_FRAMES});
+        for (int ch = 0; ch < 2; ch++) {
+            double db = ht_db(level(y, ch, rc.out_rate, f) / AMP);
+            worst = std::max(worst, fabs(db));
+            HT_CHECK(fabs(db) <= RIPPLE_DB, "%u -> %u: %.0f Hz at %+.3f dB", rc.in_rate, rc.out_rate, f, db);
+        }
+    }
+    printf("%5u -> %5u  passband 20 Hz-20 kHz within %.3f dB\n", rc.in_rate, rc.out_rate, worst);
+}
+
+// Input tones at or above fs_out − 20 kHz (content or images), each checked
+// where it folds into the output band
+static void test_rejection(const RatioCase &rc) {
+    struct Fold { double in_hz; double out_hz; };
+    std::vector<Fold> folds;
+    const double fin = rc.in_rate, fout = rc.out_rate;
+    if (rc.in_rate / 2 > rc.out_rate - 20000) {
+        // Above the output Nyquist: f folds to fs_out − f
+        for (double f : {fout - 18000.0, fout - 4000.0, fin / 2 - 2000.0}) {
+            if (f >= fout - 20000.0 && f < fin / 2) folds.push_back({f, fabs(fout - f)});
+        }
+    }
+    // Images of a 1 kHz tone at fs_in ± 1 kHz, folded by fs_out (L > 1 only:
+    // plain decimation has no images)
+    for (double img : {fin - 1000.0, fin + 1000.0}) {
+        if (resample::table_for(rc.in_rate, rc.out_rate)->up == 1) break;
+        double out_hz = fmod(img, fout);
+        if (out_hz > fout / 2) out_hz = fout - out_hz;
+        if (out_hz <= 20000.0 && img >= fout - 20000.0) folds.push_back({1000.0, out_hz});
+    }
+
+    double worst = -200.0;
+    for (const Fold &fold : folds) {
+        std::vector<float> y = resample_all(rc, tones(rc.in_rate, {fold.in_hz}), {RESAMPLER_MAX_FRAMES});
+        double db = ht_db(level(y, 0, rc.out_rate, fold.out_hz) / AMP);
+        worst = std::max(worst, db);
+        HT_CHECK(db <= REJECTION_DB, "%u -> %u: %.0f Hz in shows at %.0f Hz, %.1f dB", rc.in_rate, rc.out_rate,
+                 fold.in_hz, fold.out_hz, db);
+    }
+    printf("%5u -> %5u  rejection: %zu folds, worst %.1f dB\n", rc.in_rate, rc.out_rate, folds.size(), worst);
+}
+
+static void test_ratio(const RatioCase &rc) {
+    const resample::RatioTable *t = resample::table_for(rc.in_rate, rc.out_rate);
+    std::vector<float> in = tones(rc.in_rate, {997.0, 6001.0});
+    const size_t frames = in.size() / 2;
+
+    std::vector<float> ref = resample_all(rc, in, {RESAMPLER_MAX_FRAMES});
+    double expect = (double)frames * t->up / t->down;
+    HT_CHECK(fabs(ref.size() / 2 - expect) <= 1.0, "%u -> %u: %zu outputs from %zu frames, want %.1f", rc.in_rate,
+             rc.out_rate, ref.size() / 2, frames, expect);
+
+    std::vector<float> odd = resample_all(rc, in, {1, 37, 255, 100, 2, 256, 17});
+    HT_CHECK(odd == ref, "%u -> %u: output depends on the block sizes", rc.in_rate, rc.out_rate);
+    printf("%5u -> %5u  %zu -> %zu frames (L/M = %u/%u), block-size independent\n", rc.in_rate, rc.out_rate, frames,
+           ref.size() / 2, t->up, t->down);
+}
+
+int main() {
+    HT_CHECK(!Resampler::supported(48000, 48000), "equal rates reported as needing a table");
+    HT_CHECK(!Resampler::supported(44100, 48000), "upsampling reported as supported");
+    for (const RatioCase &rc : RATIOS) {
+        HT_CHECK(Resampler::supported(rc.in_rate, rc.out_rate), "%u -> %u unsupported", rc.in_rate, rc.out_rate);
+        test_passband(rc);
+        test_rejection(rc);
+        test_ratio(rc);
+    }
+    return ht_result();
+}
@@ -0,0 +1,310 @@
+// RtpSender over multicast loopback.
+//
+// The real sender task (dsp_host_enable_tasks()) reads a synthetic capture
+// written block by block into AudioBuffer; the test joins the group and
+// checks what arrives, once as L24 and once as L16:
+//
+//   header       V=2, PT 96, constant SSRC, marker on the first packet only,
+//                sequence +1 per packet, timestamp +RTP_BLOCK_FRAMES; the
+//                timestamp minus its random base is the capture frame index
+//                (the session starts at the live position)
+//   payload      L24: the capture samples big-endian; L16 (dither off): the
+//                same samples rounded to 16 bits, big-endian. Samples are a
+//                per-frame hash, so any shift, swap or channel mix-up shows.
+//   RTCP (+1)    first SR with the first packet, then SR + SDES CNAME + BYE
+//                on stop: V=2, lengths, SSRC, RTP timestamp = base + frames
+//                written, NTP time = wall time of that frame's block write
+//                (within NTP_TOLERANCE_US), packet and octet counts
+//   config       unicast groups and odd ports are refused; build_sdp()
+//
+// WiFiManager::get_ip_address() and StreamEncoder::dither() are defined
+// here, so the sender links without the network stack or the encoder.
+//
+// Skipped (HT_SKIP) when the host cannot join or route the multicast group.
+
+#include "host_test.h"
+#include "network/rtp_sender.h"
+#include "network/stream_encoder.h"
+#include "network/wifi_manager.h"
+#include "audio/audio_buffer.h"
+#include "audio/dsp_platform.h"
+#include <atomic>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static const char        *GROUP            = "239.255.83.67";
+static constexpr uint32_t RATE             = 48000;
+static constexpr uint32_t BLOCKS           = 400;      // Per session, one packet each
+static constexpr int64_t  NTP_TOLERANCE_US = 5000;
+static constexpr uint32_t NTP_UNIX_OFFSET  = 2208988800u;
+
+bool WiFiManager::get_ip_address(char *ip, size_t len) {
+    snprintf(ip, len, "127.0.0.1");
+    return true;
+}
+
+DitherMode StreamEncoder::dither() {
+    return DitherMode::OFF;
+}
+
+static inline uint16_t get_be16(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+static inline uint32_t get_be32(const uint8_t *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+// Signed 24-bit sample of capture frame `frame`, channel `ch`
+static int32_t sample(uint64_t frame, int ch) {
+    uint32_t h = (uint32_t)(frame * 2 + ch) * 2654435761u;
+    return (int32_t)(h ^ (h >> 15)) >> 8;
+}
+
+// ─── Capture ─────────────────────────────────────────────────────────────────
+
+// Written by the capture thread, read by the receiver
+static std::atomic<uint64_t> s_written_frames{0};
+static std::atomic<int64_t>  s_block_wall_us[4 * BLOCKS];     // Wall time of each write, by block index
+
+static int64_t wall_us() {
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// One DMA block per millisecond: faster than real time, far from a resync
+static void write_blocks(uint32_t blocks) {
+    uint8_t block[RTP_BLOCK_FRAMES * AudioStream::BYTES_PER_FRAME];
+    for (uint32_t b = 0; b < blocks; b++) {
+        const uint64_t frame = s_written_frames.load();
+        for (uint32_t i = 0; i < RTP_BLOCK_FRAMES; i++) {
+            ht_put24(block + i * 6 + 0, sample(frame + i, 0));
+            ht_put24(block + i * 6 + 3, sample(frame + i, 1));
+        }
+        s_block_wall_us[frame / RTP_BLOCK_FRAMES] = wall_us();
+        AudioBuffer::write(block, sizeof(block));
+        s_written_frames += RTP_BLOCK_FRAMES;
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+}
+
+// ─── Receiver ────────────────────────────────────────────────────────────────
+
+static int open_receiver(uint16_t port) {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) return -1;
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(port);
+    inet_pton(AF_INET, GROUP, &addr.sin_addr);
+    ip_mreq mreq = {};
+    mreq.imr_multiaddr = addr.sin_addr;
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (const sockaddr *)&addr, sizeof(addr)) < 0 ||
+        setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// One datagram from `sock` within `timeout_ms`; its length, 0 on timeout
+static size_t receive(int sock, uint8_t *buf, size_t len, int timeout_ms) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(sock, &fds);
+    timeval tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    if (select(sock + 1, &fds, nullptr, nullptr, &tv) <= 0) return 0;
+    ssize_t n = recv(sock, buf, len, 0);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static bool wait_running(bool running) {
+    for (int i = 0; i < 1000 && RtpSender::is_running() != running; i++) vTaskDelay(pdMS_TO_TICKS(1));
+    return RtpSender::is_running() == running;
+}
+
+struct Session {
+    uint32_t ssrc      = 0;
+    uint16_t seq0      = 0;
+    uint32_t ts_base   = 0;
+    uint32_t packets   = 0;
+    uint32_t octets    = 0;
+    uint32_t reports   = 0;
+    bool     bye       = false;
+};
+
+// RTP: header continuity and payload against the capture
+static void check_rtp(Session &s, const uint8_t *pkt, size_t len, uint8_t bits, uint64_t first_frame) {
+    const size_t payload = RTP_BLOCK_FRAMES * 2 * (bits / 8);
+    HT_CHECK(len == RTP_HEADER_BYTES + payload, "L%u packet %u: %zu bytes, want %zu", bits, s.packets, len,
+             RTP_HEADER_BYTES + payload);
+    if (len != RTP_HEADER_BYTES + payload) return;
+    HT_CHECK(pkt[0] == 0x80 && (pkt[1] & 0x7F) == RTP_PAYLOAD_TYPE, "L%u packet %u: header %02X %02X", bits,
+             s.packets, pkt[0], pkt[1]);
+    HT_CHECK((pkt[1] >> 7) == (s.packets == 0), "L%u packet %u: marker %u", bits, s.packets, pkt[1] >> 7);
+
+    const uint16_t seq  = get_be16(pkt + 2);
+    const uint32_t ts   = get_be32(pkt + 4);
+    const uint32_t ssrc = get_be32(pkt + 8);
+    if (s.packets == 0) {
+        s.seq0    = seq;
+        s.ssrc    = ssrc;
+        s.ts_base = ts - (uint32_t)first_frame;
+    }
+    HT_CHECK(ssrc == s.ssrc, "L%u packet %u: SSRC %08X, want %08X", bits, s.packets, ssrc, s.ssrc);
+    HT_CHECK(seq == (uint16_t)(s.seq0 + s.packets), "L%u packet %u: sequence %u, want %u", bits, s.packets, seq,
+             (uint16_t)(s.seq0 + s.packets));
+    const uint64_t frame = first_frame + (uint64_t)s.packets * RTP_BLOCK_FRAMES;
+    HT_CHECK(ts - s.ts_base == (uint32_t)frame, "L%u packet %u: timestamp at frame %u, want %llu", bits,
+             s.packets, ts - s.ts_base, (unsigned long long)frame);
+
+    uint32_t bad = 0;
+    const uint8_t *p = pkt + RTP_HEADER_BYTES;
+    for (uint32_t i = 0; i < RTP_BLOCK_FRAMES * 2; i++) {
+        const int32_t v = sample(frame + i / 2, i % 2);
+        if (bits == 24) {
+            bad += p[i * 3] != (uint8_t)(v >> 16) || p[i * 3 + 1] != (uint8_t)(v >> 8) ||
+                   p[i * 3 + 2] != (uint8_t)v;
+        } else {
+            int32_t y = (v + 128) >> 8;
+            y = y > 32767 ? 32767 : y;
+            bad += get_be16(p + i * 2) != (uint16_t)y;
+        }
+    }
+    HT_CHECK(bad == 0, "L%u packet %u: %u samples differ from the capture", bits, s.packets, bad);
+    s.packets++;
+    s.octets += (uint32_t)payload;
+}
+
+// RTCP compound packet: SR + SDES (+ BYE)
+static void check_rtcp(Session &s, const uint8_t *pkt, size_t len, uint8_t bits) {
+    HT_CHECK(len >= 28 && pkt[0] == 0x80 && pkt[1] == 200 && get_be16(pkt + 2) == 6,
+             "L%u report %u: not an SR without report blocks (%02X %u, length %u)", bits, s.reports, pkt[0],
+             pkt[1], len >= 4 ? get_be16(pkt + 2) : 0);
+    if (len < 28) return;
+    HT_CHECK(get_be32(pkt + 4) == s.ssrc, "L%u SR SSRC %08X, want %08X", bits, get_be32(pkt + 4), s.ssrc);
+
+    // RTP timestamp: the frame after the last block written; NTP: when that
+    // block was written
+    uint64_t written = 0;
+    AudioBuffer::get_clock(&written, nullptr);
+    const uint32_t frames = get_be32(pkt + 16) - s.ts_base;
+    const bool on_block   = frames % RTP_BLOCK_FRAMES == 0 && frames > 0 && frames <= written;
+    HT_CHECK(on_block, "L%u SR timestamp at frame %u (%llu written)", bits, frames, (unsigned long long)written);
+    if (on_block) {
+        const int64_t ntp_us = ((int64_t)get_be32(pkt + 8) - NTP_UNIX_OFFSET) * 1000000 +
+                               (int64_t)(((uint64_t)get_be32(pkt + 12) * 1000000) >> 32);
+        const int64_t error  = ntp_us - s_block_wall_us[frames / RTP_BLOCK_FRAMES - 1];
+        printf("L%u SR %u: frame %u, NTP time %+lld us from its write, %u packets, %u octets\n", bits,
+               s.reports, frames, (long long)error, get_be32(pkt + 20), get_be32(pkt + 24));
+        HT_CHECK(llabs(error) < NTP_TOLERANCE_US, "L%u SR NTP time %lld us off the capture write", bits,
+                 (long long)error);
+    }
+    const uint32_t packets = get_be32(pkt + 20), octets = get_be32(pkt + 24);
+    HT_CHECK(packets >= 1 && packets <= BLOCKS && octets == packets * RTP_BLOCK_FRAMES * 2 * (bits / 8),
+             "L%u SR counts %u packets, %u octets", bits, packets, octets);
+
+    // SDES: one chunk, CNAME, padded to 32 bits
+    const uint8_t *sdes = pkt + 28;
+    const size_t   rest = len - 28;
+    const char     cname[] = "turntable@127.0.0.1";
+    HT_CHECK(rest >= 8 + sizeof(cname) && sdes[0] == 0x81 && sdes[1] == 202 && get_be32(sdes + 4) == s.ssrc &&
+             sdes[8] == 1 && sdes[9] == strlen(cname) && memcmp(sdes + 10, cname, strlen(cname)) == 0,
+             "L%u SDES CNAME chunk malformed", bits);
+    if (rest < 4) return;
+    const size_t sdes_len = 4 + get_be16(sdes + 2) * 4u;
+    HT_CHECK(sdes_len % 4 == 0 && sdes_len <= rest, "L%u SDES length %zu of %zu", bits, sdes_len, rest);
+    if (sdes_len > rest) return;
+
+    if (rest - sdes_len == 8) {
+        const uint8_t *bye = sdes + sdes_len;
+        HT_CHECK(bye[0] == 0x81 && bye[1] == 203 && get_be16(bye + 2) == 1 && get_be32(bye + 4) == s.ssrc,
+                 "L%u BYE malformed", bits);
+        HT_CHECK(packets == s.packets && octets == s.octets, "L%u final SR %u packets / %u octets, received %u / %u",
+                 bits, packets, octets, s.packets, s.octets);
+        s.bye = true;
+    } else {
+        HT_CHECK(rest == sdes_len, "L%u RTCP: %zu trailing bytes", bits, rest - sdes_len);
+    }
+    s.reports++;
+}
+
+// One session: start, write BLOCKS blocks, receive every packet, stop.
+// False if nothing arrived and the sender could not send (no route).
+static bool run_session(int rtp, int rtcp, uint16_t port, uint8_t bits) {
+    HT_CHECK(RtpSender::configure(true, GROUP, port, bits, 1), "configure(L%u) refused", bits);
+    HT_CHECK(wait_running(true), "L%u session did not start", bits);
+    const uint64_t first_frame = s_written_frames;
+
+    char sdp[512], want[64];
+    HT_CHECK(RtpSender::build_sdp(sdp, sizeof(sdp), "127.0.0.1", "test") > 0, "L%u: no SDP", bits);
+    snprintf(want, sizeof(want), "a=rtpmap:%u L%u/%lu/2\r\n", RTP_PAYLOAD_TYPE, bits, (unsigned long)RATE);
+    HT_CHECK(strstr(sdp, want) != nullptr, "L%u SDP lacks %s", bits, want);
+
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        write_blocks(BLOCKS);
+        done = true;
+    });
+
+    Session s;
+    uint8_t pkt[2048];
+    while (s.packets < BLOCKS) {
+        size_t len = receive(rtp, pkt, sizeof(pkt), 1000);
+        if (len == 0) break;
+        check_rtp(s, pkt, len, bits, first_frame);
+        while ((len = receive(rtcp, pkt, sizeof(pkt), 0)) > 0) check_rtcp(s, pkt, len, bits);
+    }
+    writer.join();
+
+    // The sender counts a packet after sendto() returns, so a packet can
+    // arrive before it is counted: read the stats once the session stopped
+    RtpSender::configure(false, GROUP, port, bits, 1);
+    HT_CHECK(wait_running(false), "L%u session did not stop", bits);
+    RtpStats stats;
+    RtpSender::get_stats(&stats);
+    if (s.packets == 0 && stats.send_errors > 0) return false;
+    HT_CHECK(s.packets == BLOCKS && stats.packets == BLOCKS && stats.send_errors == 0 && stats.resyncs == 0,
+             "L%u: received %u of %u packets (sender: %u sent, %u errors, %u resyncs)", bits, s.packets, BLOCKS,
+             stats.packets, stats.send_errors, stats.resyncs);
+
+    size_t len;
+    while (!s.bye && (len = receive(rtcp, pkt, sizeof(pkt), 1000)) > 0) check_rtcp(s, pkt, len, bits);
+    HT_CHECK(s.reports >= 2 && s.bye, "L%u: %u reports, BYE %s", bits, s.reports, s.bye ? "seen" : "missing");
+    printf("L%u: %u packets, SSRC %08X, %u RTCP reports\n", bits, s.packets, s.ssrc, s.reports);
+    return true;
+}
+
+int main() {
+    HT_CHECK(AudioBuffer::init(), "AudioBuffer::init failed");
+    dsp_host_enable_tasks();
+    HT_CHECK(RtpSender::init(RATE), "RtpSender::init failed");
+
+    HT_CHECK(!RtpSender::is_valid_group("10.0.0.1") && RtpSender::is_valid_group(GROUP), "group validation");
+    HT_CHECK(!RtpSender::configure(true, "10.0.0.1", 5004, 24, 1), "unicast group accepted");
+    HT_CHECK(!RtpSender::configure(true, GROUP, 5005, 24, 1), "odd port accepted");
+
+    // An even port per process, so parallel runs do not hear each other
+    const uint16_t port = (uint16_t)(20000 + (getpid() % 20000) * 2);
+    int rtp = open_receiver(port), rtcp = open_receiver((uint16_t)(port + 1));
+    if (rtp < 0 || rtcp < 0) {
+        printf("cannot join %s on this host: skipped\n", GROUP);
+        return HT_SKIP;
+    }
+    write_blocks(10);
+
+    for (uint8_t bits : {24, 16}) {
+        if (!run_session(rtp, rtcp, port, bits)) {
+            printf("multicast to %s is not routed on this host: skipped\n", GROUP);
+            return HT_SKIP;
+        }
+    }
+    close(rtp);
+    close(rtcp);
+    return ht_result();
+}
@@ -0,0 +1,393 @@
+// StreamEncoder::read_frames() capture frames and the Snapcast wire protocol.
+//
+// The capture is a counter: frame f is written as L = f & 0xFFFF,
+// R = f >> 16 (16-bit, below them a constant byte that the undithered 24 →
+// 16-bit conversion drops), so any 16-bit frame out of a pipe names its own
+// capture frame.
+//
+//   read_frames  2 s written at once, then PCM, FLAC and ADPCM pipes read
+//                inline (no encoder task). Every read's capture frame must be
+//                the one its data carries: each PCM frame, each ADPCM block
+//                header, and FLAC_BLOCK_FRAMES × each FLAC frame number from
+//                the pipe's start 1.5 s back.
+//   snapcast     a real-time capture thread and the real snap_srv task on
+//                port 1704; the test is the snapclient:
+//                  Hello          answered by ServerSettings (refersTo,
+//                                 bufferMs) and CodecHeader ("pcm", WAV)
+//                  WireChunk      base header sizes, a tv timestamp, the
+//                                 payload size, SNAPCAST_CHUNK_MS of frames.
+//                                 The timestamp must be the time the chunk's
+//                                 first frame reached the capture ring on
+//                                 the capture schedule (within
+//                                 CHUNK_TIME_TOLERANCE_US), chunks
+//                                 consecutive and SNAPCAST_CHUNK_MS apart,
+//                                 except for those skipped on a full outbox
+//                                 (the join backlog), as the server counts
+//                  Time           echoed with refersTo, the server's send
+//                                 time and latency = receive − client send
+//                Both sides read the same clock (esp_timer on the host), so
+//                the times are compared directly.
+//
+// Skipped (HT_SKIP) when port 1704 is taken on this host.
+
+#include "host_test.h"
+#include "network/snapcast_server.h"
+#include "network/stream_encoder.h"
+#include "network/flac_encoder.h"
+#include "network/adpcm_encoder.h"
+#include "audio/audio_buffer.h"
+#include "audio/dsp_platform.h"
+#include <atomic>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static constexpr uint32_t RATE                    = 48000;
+static constexpr uint32_t BLOCK_FRAMES            = 240;
+static constexpr uint32_t PREBUFFER_FRAMES        = RATE * 3 / 2;   // New pipe start, behind capture
+static constexpr uint16_t BUFFER_MS               = 1000;
+static constexpr uint32_t CHUNKS                  = 100;
+static constexpr int64_t  CHUNK_TIME_TOLERANCE_US = 2500;    // Half a capture block
+
+// Snapcast message types and base header (snapcast common/message/message.hpp)
+static constexpr uint16_t MSG_CODEC_HEADER    = 1;
+static constexpr uint16_t MSG_WIRE_CHUNK      = 2;
+static constexpr uint16_t MSG_SERVER_SETTINGS = 3;
+static constexpr uint16_t MSG_TIME            = 4;
+static constexpr uint16_t MSG_HELLO           = 5;
+static constexpr size_t   BASE_BYTES          = 26;
+
+static inline uint16_t get_le16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+static inline uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+static inline void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+static inline void put_le32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+static int64_t get_tv(const uint8_t *p) {
+    return (int64_t)(int32_t)get_le32(p) * 1000000 + (int32_t)get_le32(p + 4);
+}
+static void put_tv(uint8_t *p, int64_t us) {
+    put_le32(p, (uint32_t)(int32_t)(us / 1000000));
+    put_le32(p + 4, (uint32_t)(int32_t)(us % 1000000));
+}
+
+// Capture frame named by a 16-bit stereo frame
+static uint32_t frame_of(const uint8_t *lr16) {
+    return get_le16(lr16) | (uint32_t)get_le16(lr16 + 2) << 16;
+}
+
+// ─── Capture ─────────────────────────────────────────────────────────────────
+
+static std::atomic<uint64_t> s_written{0};
+static std::atomic<uint64_t> s_anchor_frame{0};          // Frames written when the schedule started
+static std::atomic<int64_t>  s_anchor_us{0};             // Its start time
+static std::atomic<bool>     s_capturing{false};
+
+static void write_block() {
+    uint8_t block[BLOCK_FRAMES * 6];
+    const uint64_t first = s_written.load();
+    for (uint32_t i = 0; i < BLOCK_FRAMES; i++) {
+        const uint32_t f = (uint32_t)(first + i);
+        ht_put24(block + i * 6 + 0, (int32_t)(int16_t)(f & 0xFFFF) * 256 + 0x5A);
+        ht_put24(block + i * 6 + 3, (int32_t)(int16_t)(f >> 16) * 256 + 0x5A);
+    }
+    AudioBuffer::write(block, sizeof(block));
+    s_written = first + BLOCK_FRAMES;
+}
+
+// One block per 5 ms on an absolute schedule, like the I²S DMA
+static void capture_thread() {
+    const int64_t period_us = (int64_t)BLOCK_FRAMES * 1000000 / RATE;
+    int64_t next = esp_timer_get_time();
+    s_anchor_frame = s_written.load();
+    s_anchor_us = next;
+    while (s_capturing) {
+        next += period_us;
+        int64_t wait = next - esp_timer_get_time();
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::microseconds(wait));
+        write_block();
+    }
+}
+
+// When capture frame `f` reached the ring on the capture schedule, i.e. at
+// the nominal rate from the anchor. The server smooths its capture clock the
+// same way, so a late wakeup of the (host) capture thread moves neither.
+static int64_t frame_time_us(uint64_t f) {
+    return s_anchor_us + ((int64_t)f - (int64_t)s_anchor_frame.load()) * 1000000 / RATE;
+}
+
+// ─── read_frames() ───────────────────────────────────────────────────────────
+
+static void test_read_frames() {
+    for (uint32_t b = 0; b < 2 * RATE / BLOCK_FRAMES; b++) write_block();
+    const uint64_t base = s_written - PREBUFFER_FRAMES;
+
+    // PCM: reads of 250 frames, across block boundaries
+    StreamSubscription pcm;
+    HT_CHECK(StreamEncoder::subscribe({StreamCodec::PCM_S16, RATE, 2}, &pcm), "PCM subscribe failed");
+    uint8_t buf[FLAC_MAX_FRAME_BYTES > 1000 ? FLAC_MAX_FRAME_BYTES : 1000];
+    uint64_t next = base, capture_frame = 0;
+    uint32_t reads = 0, bad = 0;
+    size_t n;
+    while ((n = StreamEncoder::read_frames(&pcm, buf, 1000, &capture_frame)) > 0) {
+        HT_CHECK(capture_frame == next, "PCM read %u at capture frame %llu, want %llu", reads,
+                 (unsigned long long)capture_frame, (unsigned long long)next);
+        for (size_t i = 0; i < n / 4; i++) bad += frame_of(buf + i * 4) != (uint32_t)(capture_frame + i);
+        next = capture_frame + n / 4;
+        reads++;
+    }
+    HT_CHECK(bad == 0, "PCM: %u frames do not match their capture frame", bad);
+    HT_CHECK(next == s_written, "PCM stopped at frame %llu of %llu", (unsigned long long)next,
+             (unsigned long long)s_written.load());
+    printf("PCM:   %u reads from capture frame %llu, %u mismatches\n", reads, (unsigned long long)base, bad);
+    StreamEncoder::unsubscribe(&pcm);
+
+    // FLAC: one frame per read, numbered from the pipe's first block
+    StreamSubscription flac;
+    HT_CHECK(StreamEncoder::subscribe({StreamCodec::FLAC, RATE, 2}, &flac), "FLAC subscribe failed");
+    reads = 0;
+    while ((n = StreamEncoder::read_frames(&flac, buf, sizeof(buf), &capture_frame)) > 0) {
+        HT_CHECK(n > 5 && get_le16(buf) == 0xF8FF, "FLAC read %u: no frame header", reads);
+        // UTF-8 coded frame number
+        uint32_t number = buf[4], extra = 0;
+        while (number & (0x80 >> extra)) extra++;
+        if (extra > 0) {
+            number &= 0x7F >> extra;
+            for (uint32_t i = 1; i < extra; i++) number = number << 6 | (buf[4 + i] & 0x3F);
+        }
+        HT_CHECK(number == reads && capture_frame == base + (uint64_t)number * FLAC_BLOCK_FRAMES,
+                 "FLAC read %u: frame %u at capture frame %llu, want %llu", reads, number,
+                 (unsigned long long)capture_frame, (unsigned long long)(base + (uint64_t)reads * FLAC_BLOCK_FRAMES));
+        reads++;
+    }
+    HT_CHECK(reads == PREBUFFER_FRAMES / FLAC_BLOCK_FRAMES, "%u FLAC frames, want %u", reads,
+             PREBUFFER_FRAMES / FLAC_BLOCK_FRAMES);
+    printf("FLAC:  %u frames\n", reads);
+    StreamEncoder::unsubscribe(&flac);
+
+    // ADPCM: whole blocks; the header holds the first frame verbatim
+    StreamSubscription adpcm;
+    HT_CHECK(StreamEncoder::subscribe({StreamCodec::IMA_ADPCM, RATE, 2}, &adpcm), "ADPCM subscribe failed");
+    reads = 0;
+    next  = base;
+    while ((n = StreamEncoder::read_frames(&adpcm, buf, ADPCM_BLOCK_BYTES, &capture_frame)) > 0) {
+        uint8_t first[4] = {buf[0], buf[1], buf[4], buf[5]};
+        HT_CHECK(n == ADPCM_BLOCK_BYTES && capture_frame == next && frame_of(first) == (uint32_t)capture_frame,
+                 "ADPCM read %u: %zu bytes at capture frame %llu holding frame %u, want %llu", reads, n,
+                 (unsigned long long)capture_frame, frame_of(first), (unsigned long long)next);
+        next = capture_frame + ADPCM_BLOCK_FRAMES;
+        reads++;
+    }
+    HT_CHECK(reads == PREBUFFER_FRAMES / ADPCM_BLOCK_FRAMES, "%u ADPCM blocks, want %u", reads,
+             PREBUFFER_FRAMES / ADPCM_BLOCK_FRAMES);
+    printf("ADPCM: %u blocks\n", reads);
+    StreamEncoder::unsubscribe(&adpcm);
+}
+
+// ─── Snapcast client ─────────────────────────────────────────────────────────
+
+struct Message {
+    uint16_t type, id, refers;
+    int64_t  sent_us;
+    std::vector<uint8_t> payload;
+};
+
+static bool recv_all(int sock, uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = recv(sock, buf, len, 0);
+        if (n <= 0) return false;
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool receive(int sock, Message *msg) {
+    uint8_t base[BASE_BYTES];
+    if (!recv_all(sock, base, sizeof(base))) return false;
+    msg->type    = get_le16(base);
+    msg->id      = get_le16(base + 2);
+    msg->refers  = get_le16(base + 4);
+    msg->sent_us = get_tv(base + 6);
+    msg->payload.resize(get_le32(base + 22));
+    return msg->payload.empty() || recv_all(sock, msg->payload.data(), msg->payload.size());
+}
+
+// Returns the send time stamped on the message
+static int64_t send_message(int sock, uint16_t type, uint16_t id, const uint8_t *payload, size_t len) {
+    std::vector<uint8_t> msg(BASE_BYTES + len);
+    const int64_t now = esp_timer_get_time();
+    put_le16(msg.data(), type);
+    put_le16(msg.data() + 2, id);
+    put_le16(msg.data() + 4, 0);
+    put_tv(msg.data() + 6, now);
+    put_tv(msg.data() + 14, 0);
+    put_le32(msg.data() + 22, (uint32_t)len);
+    if (len > 0) memcpy(msg.data() + BASE_BYTES, payload, len);
+    HT_CHECK(send(sock, msg.data(), msg.size(), 0) == (ssize_t)msg.size(), "send failed");
+    return now;
+}
+
+static void check_time_reply(const Message &msg, uint16_t id, int64_t sent_us, int64_t now_us) {
+    HT_CHECK(msg.refers == id && msg.payload.size() == 8, "Time reply refers to %u (want %u), %zu bytes",
+             msg.refers, id, msg.payload.size());
+    if (msg.payload.size() != 8) return;
+    const int64_t latency = get_tv(msg.payload.data());
+    HT_CHECK(latency >= 0 && latency <= now_us - sent_us, "Time latency %lld us, round trip %lld us",
+             (long long)latency, (long long)(now_us - sent_us));
+    HT_CHECK(msg.sent_us >= sent_us + latency && msg.sent_us <= now_us,
+             "Time reply sent at %+lld us after the request, reply received at %+lld us",
+             (long long)(msg.sent_us - sent_us), (long long)(now_us - sent_us));
+}
+
+static void test_snapcast(int sock) {
+    const char hello[] = "{\"Arch\":\"x86_64\",\"ClientName\":\"Snapclient\",\"HostName\":\"host-test\","
+                         "\"ID\":\"00:11:22:33:44:55\",\"Instance\":1,\"MAC\":\"00:11:22:33:44:55\","
+                         "\"OS\":\"Linux\",\"SnapStreamProtocolVersion\":2,\"Version\":\"0.27.0\"}";
+    uint8_t payload[4 + sizeof(hello)];
+    put_le32(payload, (uint32_t)strlen(hello));
+    memcpy(payload + 4, hello, strlen(hello));
+    send_message(sock, MSG_HELLO, 1, payload, 4 + strlen(hello));
+
+    Message msg;
+    HT_CHECK(receive(sock, &msg) && msg.type == MSG_SERVER_SETTINGS && msg.refers == 1,
+             "no ServerSettings for the Hello (type %u, refersTo %u)", msg.type, msg.refers);
+    std::string settings(msg.payload.begin() + (msg.payload.size() >= 4 ? 4 : 0), msg.payload.end());
+    HT_CHECK(msg.payload.size() >= 4 && get_le32(msg.payload.data()) == settings.size() &&
+             settings.find("\"bufferMs\":1000") != std::string::npos,
+             "ServerSettings payload: %s", settings.c_str());
+
+    HT_CHECK(receive(sock, &msg) && msg.type == MSG_CODEC_HEADER, "no CodecHeader (type %u)", msg.type);
+    const uint8_t *p = msg.payload.data();
+    HT_CHECK(msg.payload.size() == 4 + 3 + 4 + 44 && get_le32(p) == 3 && memcmp(p + 4, "pcm", 3) == 0 &&
+             get_le32(p + 7) == 44 && memcmp(p + 11, "RIFF", 4) == 0 && get_le16(p + 11 + 22) == 2 &&
+             get_le32(p + 11 + 24) == RATE && get_le16(p + 11 + 34) == 16,
+             "CodecHeader is not pcm with a 44-byte 16-bit stereo %u Hz WAV header", RATE);
+
+    const size_t chunk_bytes = RATE * SNAPCAST_CHUNK_MS / 1000 * 4;
+    const uint32_t chunk_frames = (uint32_t)(chunk_bytes / 4);
+    uint32_t chunks = 0, skipped = 0, requests = 0, syncs = 0, bad = 0;
+    uint64_t prev_frame = 0;
+    int64_t  prev_ts = 0, worst_error = 0, time_sent_us = 0;
+    uint16_t time_id = 0;
+    while (chunks < CHUNKS) {
+        // A Time request every 20 chunks, answered between messages
+        if (chunks % 20 == 10 && chunks / 20 + 1 > requests && time_id == 0) {
+            uint8_t zero[8] = {};
+            time_id      = (uint16_t)(100 + chunks);
+            time_sent_us = send_message(sock, MSG_TIME, time_id, zero, sizeof(zero));
+            requests++;
+        }
+        if (!receive(sock, &msg)) {
+            HT_CHECK(false, "connection lost after %u chunks", chunks);
+            return;
+        }
+        if (msg.type == MSG_TIME) {
+            check_time_reply(msg, time_id, time_sent_us, esp_timer_get_time());
+            time_id = 0;
+            syncs++;
+            continue;
+        }
+        HT_CHECK(msg.type == MSG_WIRE_CHUNK, "unexpected message type %u", msg.type);
+        if (msg.type != MSG_WIRE_CHUNK) continue;
+
+        // Timestamp (tv), payload size, payload
+        p = msg.payload.data();
+        HT_CHECK(msg.payload.size() == 12 + chunk_bytes && get_le32(p + 8) == chunk_bytes,
+                 "chunk %u: %zu bytes with size field %u, want %zu", chunks, msg.payload.size(),
+                 msg.payload.size() >= 12 ? get_le32(p + 8) : 0, 12 + chunk_bytes);
+        if (msg.payload.size() != 12 + chunk_bytes) continue;
+        HT_CHECK((int32_t)get_le32(p + 4) >= 0 && get_le32(p + 4) < 1000000, "chunk %u: tv usec %u", chunks,
+                 get_le32(p + 4));
+        const int64_t  ts    = get_tv(p);
+        const uint64_t frame = frame_of(p + 12);
+        for (uint32_t i = 0; i < chunk_frames; i++) bad += frame_of(p + 12 + i * 4) != (uint32_t)(frame + i);
+
+        const int64_t error = ts - frame_time_us(frame);
+        if (llabs(error) > llabs(worst_error)) worst_error = error;
+        HT_CHECK(llabs(error) < CHUNK_TIME_TOLERANCE_US, "chunk %u (capture frame %llu): timestamp %+lld us off",
+                 chunks, (unsigned long long)frame, (long long)error);
+        // Consecutive, except for chunks the server skipped because the
+        // client's outbox was full (the backlog sent on joining)
+        if (chunks > 0) {
+            const uint64_t step = frame - prev_frame;
+            HT_CHECK(frame > prev_frame && step % chunk_frames == 0, "chunk %u at capture frame %llu after %llu",
+                     chunks, (unsigned long long)frame, (unsigned long long)prev_frame);
+            if (frame > prev_frame) skipped += (uint32_t)(step / chunk_frames) - 1;
+            const int64_t want_us = (int64_t)(step * 1000000 / RATE);
+            HT_CHECK(llabs(ts - prev_ts - want_us) < 500, "chunk %u: %lld us after the last, want %lld us",
+                     chunks, (long long)(ts - prev_ts), (long long)want_us);
+        }
+        prev_frame = frame;
+        prev_ts    = ts;
+        chunks++;
+    }
+    HT_CHECK(bad == 0, "%u chunk frames out of sequence", bad);
+    HT_CHECK(syncs == requests, "%u Time replies to %u requests", syncs, requests);
+    printf("snapcast: %u chunks (%u skipped), worst timestamp error %+lld us, %u Time replies\n", chunks,
+           skipped, (long long)worst_error, syncs);
+
+    SnapcastStats stats;
+    SnapcastServer::get_stats(&stats);
+    HT_CHECK(stats.clients == 1 && strcmp(stats.client[0].name, "host-test") == 0 &&
+             stats.client[0].time_syncs == syncs && stats.client[0].skipped == skipped,
+             "stats: %u clients, name %s, %u syncs, %u skipped", stats.clients, stats.client[0].name,
+             stats.client[0].time_syncs, stats.client[0].skipped);
+}
+
+static bool wait_running(bool running) {
+    for (int i = 0; i < 1000 && SnapcastServer::is_running() != running; i++) vTaskDelay(pdMS_TO_TICKS(1));
+    return SnapcastServer::is_running() == running;
+}
+
+int main() {
+    HT_CHECK(AudioBuffer::init(), "AudioBuffer::init failed");
+    // No encoder task: pipes convert inline on read
+    HT_CHECK(StreamEncoder::init(RATE), "StreamEncoder::init failed");
+    StreamEncoder::set_dither(DitherMode::OFF);
+    test_read_frames();
+
+    dsp_host_enable_tasks();
+    HT_CHECK(SnapcastServer::init(RATE), "SnapcastServer::init failed");
+    SnapcastServer::configure(true, SnapcastCodec::PCM, BUFFER_MS);
+    if (!wait_running(true)) {
+        printf("cannot listen on port %u on this host: skipped\n", SNAPCAST_PORT);
+        return HT_SKIP;
+    }
+
+    // Real-time capture for longer than a new pipe's prebuffer
+    s_capturing = true;
+    std::thread capture(capture_thread);
+    vTaskDelay(pdMS_TO_TICKS(2000));
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(SNAPCAST_PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    timeval timeout = {2, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(sock, (const sockaddr *)&addr, sizeof(addr)) == 0) {
+        test_snapcast(sock);
+    } else {
+        HT_CHECK(false, "cannot connect to 127.0.0.1:%u", SNAPCAST_PORT);
+    }
+    close(sock);
+
+    SnapcastServer::configure(false, SnapcastCodec::PCM, BUFFER_MS);
+    HT_CHECK(wait_running(false), "server did not stop");
+    s_capturing = false;
+    capture.join();
+    return ht_result();
+}
@@ -0,0 +1,123 @@
+// WowFlutterMeter against synthetic frequency-modulated test tones.
+//
+// Each case writes a tone ref·(1 + ε)·(1 + m·sin 2π·fm·t) through AudioTap
+// and runs a 10 s measurement (the task is not started on the host, so the
+// meter drains inline from get_result()). Expected values:
+//
+//   speed error   ε × 100 %
+//   weighted      m × 100 % × W(fm), W being the analog weighting prototype
+//                 documented in wow_flutter.h (normalized to 0 dB at 4 Hz);
+//                 RMS = peak / √2 for a sinusoidal modulation
+//
+// plus no-modulation, noisy, quiet and silent inputs.
+
+#include "host_test.h"
+#include "audio/wow_flutter.h"
+#include "audio/audio_tap.h"
+#include <complex>
+
+static constexpr size_t BLOCK = 240;
+
+// |W(f)| of the analog prototype: 2nd-order HP 0.59 Hz Q 0.49 × 1st-order
+// HP 0.74 Hz × 1st-order LP 11.8 Hz, 0 dB at 4 Hz
+static double weighting(double f) {
+    auto h = [](double hz) {
+        std::complex<double> s(0.0, 2.0 * M_PI * hz);
+        double w0 = 2.0 * M_PI * 0.59, w1 = 2.0 * M_PI * 0.74, w2 = 2.0 * M_PI * 11.8;
+        return std::abs(s * s / (s * s + s * w0 / 0.49 + w0 * w0) * s / (s + w1) * w2 / (s + w2));
+    };
+    return h(f) / h(4.0);
+}
+
+struct FmCase {
+    uint32_t fs;
+    double   reference_hz;
+    double   speed;       // ε, relative speed error
+    double   depth;       // m, relative peak deviation
+    double   rate_hz;     // fm
+    double   noise;       // Uniform noise amplitude
+    double   amplitude;
+};
+
+static WowFlutterResult run(const FmCase &c) {
+    WowFlutterMeter::init(c.fs);
+    WowFlutterMeter::start((float)c.reference_hz, 10.0f);
+
+    uint8_t block[BLOCK * 6];
+    double phase = 0.0;
+    uint32_t seed = 7;
+    uint64_t n = 0;
+    WowFlutterResult r = {};
+    for (uint32_t b = 0; b < c.fs * 15 / BLOCK; b++) {
+        for (size_t i = 0; i < BLOCK; i++, n++) {
+            double t = (double)n / c.fs;
+            double f = c.reference_hz * (1.0 + c.speed) * (1.0 + c.depth * sin(2.0 * M_PI * c.rate_hz * t));
+            phase = fmod(phase + 2.0 * M_PI * f / c.fs, 2.0 * M_PI);
+            seed = seed * 1103515245u + 12345u;
+            double noise = c.noise * ((double)(seed >> 8) / 8388608.0 - 1.0);
+            int32_t v = ht_to24(c.amplitude * sin(phase) + noise);
+            ht_put24(block + i * 6 + 0, v);
+            ht_put24(block + i * 6 + 3, v);
+        }
+        AudioTap::write(block, BLOCK);
+        WowFlutterMeter::get_result(&r);
+    }
+    return r;
+}
+
+static void check_fm(const FmCase &c, double peak_tol_db) {
+    WowFlutterResult r = run(c);
+    double want_speed = c.speed * 100.0;
+    double want_peak  = c.depth * 100.0 * weighting(c.rate_hz);
+    double want_rms   = want_peak / sqrt(2.0);
+    printf("fs %u, %.0f Hz %+.2f %%, %.3f %% @ %5.1f Hz, noise %.3f: speed %+.4f %%, peak %.4f %% (want %.4f), "
+           "rms %.4f %% (want %.4f), %u periods\n",
+           c.fs, c.reference_hz, want_speed, c.depth * 100.0, c.rate_hz, c.noise,
+           r.speed_error_pct, r.weighted_peak_pct, want_peak, r.weighted_rms_pct, want_rms, r.periods);
+
+    HT_CHECK(r.state == WowFlutterState::DONE, "%.1f Hz modulation: state %s", c.rate_hz,
+             WowFlutterMeter::state_name(r.state));
+    HT_CHECK(r.rejected_periods == 0 && r.lost_chunks == 0, "%u periods rejected, %u chunks lost",
+             r.rejected_periods, r.lost_chunks);
+    HT_CHECK(fabs(r.speed_error_pct - want_speed) < 0.002, "speed %+.4f %%, want %+.4f %%",
+             r.speed_error_pct, want_speed);
+    if (c.depth == 0.0) {
+        HT_CHECK(r.weighted_peak_pct < 0.001, "unmodulated tone reads %.4f %% peak", r.weighted_peak_pct);
+        return;
+    }
+    HT_CHECK(fabs(ht_db(r.weighted_rms_pct / want_rms)) < 0.3, "%.1f Hz: rms %.4f %%, want %.4f %%",
+             c.rate_hz, r.weighted_rms_pct, want_rms);
+    HT_CHECK(fabs(ht_db(r.weighted_peak_pct / want_peak)) < peak_tol_db, "%.1f Hz: peak %.4f %%, want %.4f %%",
+             c.rate_hz, r.weighted_peak_pct, want_peak);
+}
+
+static void check_no_signal(const FmCase &c) {
+    WowFlutterResult r = run(c);
+    printf("fs %u, %.0f Hz at %.1f dBFS: %s, level %.1f dBFS\n", c.fs, c.reference_hz,
+           c.amplitude > 0.0 ? ht_db(c.amplitude) : -INFINITY, WowFlutterMeter::state_name(r.state),
+           r.tone_level_dbfs);
+    HT_CHECK(r.state == WowFlutterState::NO_SIGNAL, "tone at amplitude %g: state %s, want no_signal",
+             c.amplitude, WowFlutterMeter::state_name(r.state));
+}
+
+int main() {
+    HT_CHECK(AudioTap::init(), "AudioTap::init failed");
+
+    // Speed only, then depth across the weighting curve (slope, peak, roll-off)
+    check_fm({48000, 3150,  0.0,    0.0,   4.0, 0.0, 0.3}, 0.3);
+    check_fm({48000, 3150,  0.01,   0.001, 4.0, 0.0, 0.3}, 0.3);
+    check_fm({48000, 3150, -0.005,  0.001, 0.5, 0.0, 0.3}, 0.3);
+    check_fm({44100, 3000,  0.0,    0.002, 1.0, 0.0, 0.3}, 0.3);
+    check_fm({48000, 3150,  0.0,    0.001, 20.0, 0.0, 0.3}, 0.3);
+    check_fm({48000, 3150,  0.0,    0.001, 100.0, 0.0, 0.3}, 0.3);
+    check_fm({96000, 3150,  0.002,  0.001, 4.0, 0.0, 0.3}, 0.3);
+
+    // -40 dB noise on the tone: RMS holds, the peak picks up the noise
+    check_fm({48000, 3150,  0.0,    0.001, 4.0, 0.003, 0.3}, 0.5);
+
+    // Below WF_MIN_LEVEL_DBFS and digital silence
+    check_no_signal({48000, 3150, 0.0, 0.001, 4.0, 0.0, 0.001});
+    check_no_signal({48000, 3150, 0.0, 0.0,   4.0, 0.0, 0.0});
+
+    return ht_result();
+}